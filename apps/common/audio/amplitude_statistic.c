@@ -28,6 +28,306 @@ static const int  rms_va_tab[] = {
     134218, 0
 };
 
+/*log2(1 + i/32)，Q16*/
+static const unsigned short log2_frac_tab[33] = {
+    0, 2909, 5732, 8473, 11136, 13727, 16248, 18704, 21098, 23433, 25711, 27936, 30109, 32234, 34312, 36346,
+    38336, 40286, 42196, 44068, 45904, 47705, 49472, 51207, 52911, 54584, 56229, 57845, 59434, 60997, 62534, 64047,
+    65535
+};
+
+/*
+ *log2(x)，Q16，x > 0
+ *CLZ求整数部分，小数部分查表线性插值，常数时间
+ */
+static int amp_log2_q16(u32 x)
+{
+    int msb = 31 - __builtin_clz(x);
+    u32 norm = x << (31 - msb);
+    int idx = (norm >> 26) & 0x1F;
+    int frac = (norm >> 10) & 0xFFFF;
+    int val = log2_frac_tab[idx] + (((log2_frac_tab[idx + 1] - log2_frac_tab[idx]) * frac) >> 16);
+    return (msb << 16) + val;
+}
+
+static int amp_log2_q16_u64(u64 x)
+{
+    u32 hi = (u32)(x >> 32);
+    if (hi) {
+        int sh = 32 - __builtin_clz(hi);
+        return amp_log2_q16((u32)(x >> sh)) + (sh << 16);
+    }
+    return amp_log2_q16((u32)x);
+}
+
+/*10*log10(x)，单位0.1dB，x为0时返回-1000*/
+static int amp_db10(u64 x)
+{
+    if (x == 0) {
+        return -1000;
+    }
+    /*30.103 * 65536 = 1972830*/
+    return (int)(((s64)amp_log2_q16_u64(x) * 1972830) >> 32);
+}
+
+/*
+ *电平查表：按log2估算级数(误差不超过1级)，再用原表做边界修正，结果与逐项搜索一致
+ *返回31表示小于-30dB
+ */
+static int amp_rms_level(int rmsval)
+{
+    int k;
+    if (rmsval >= rms_va_tab[0]) {
+        return 0;
+    }
+    if (rmsval <= 0) {
+        return 31;
+    }
+    /*rms_va_tab[k] = 2^27 * 10^(-k/10)，功率1dB一级*/
+    k = (813 - amp_db10(rmsval) + 9) / 10;
+    k = (k < 0) ? 0 : ((k > 31) ? 31 : k);
+    while ((k > 0) && (rmsval >= rms_va_tab[k - 1])) {
+        k--;
+    }
+    while ((k < 31) && (rmsval < rms_va_tab[k])) {
+        k++;
+    }
+    return k;
+}
+
+static int amp_peak_level(int maxval)
+{
+    int k;
+    if (maxval >= am_va_tab[0]) {
+        return 0;
+    }
+    if (maxval <= 0) {
+        return 31;
+    }
+    /*am_va_tab[k] = 2^15 * 10^(-k/20)，幅值1dB一级*/
+    k = (903 - 2 * amp_db10(maxval) + 9) / 10;
+    k = (k < 0) ? 0 : ((k > 31) ? 31 : k);
+    while ((k > 0) && (maxval >= am_va_tab[k - 1])) {
+        k--;
+    }
+    while ((k < 31) && (maxval < am_va_tab[k])) {
+        k++;
+    }
+    return k;
+}
+
+#if LOUDNESS_METER_EXT_ENABLE
+/*
+ *K计权滤波器系数(ITU-R BS.1770)，Q28
+ *{b0, b1, b2, a1, a2}(高频搁架) + {a1, a2}(高通，b = {1, -2, 1})
+ */
+#define KW_COEF_Q		28
+static const int kw_coef_tab[][8] = {
+    { 8000, 354770625, -194952724,  80027655,  -78753804,  50163904, -521036802, 252835143},
+    {11025, 372195475, -352056837, 124502595, -195448268,  71654045, -525335095, 257023733},
+    {12000, 376082472, -387468171, 137633621, -221185565,  78998031, -526263196, 257932671},
+    {16000, 387431611, -491659773, 182981379, -295690720, 106008482, -528895568, 260519426},
+    {22050, 397237593, -582700525, 231080645, -359248603, 136430860, -531072063, 262667964},
+    {24000, 399405174, -602961189, 242909693, -373188260, 144106483, -531540891, 263131928},
+    {32000, 405653729, -661663714, 279611303, -413134272, 168300134, -532868450, 264447933},
+    {44100, 410932064, -711617024, 313822276, -446584019, 191285879, -533963668, 265536094},
+    {48000, 412081942, -722546694, 321691121, -453832898, 196623811, -534199296, 265770496},
+};
+
+/*
+ *真峰值4倍过采样多相滤波器(ITU-R BS.1770 Annex 2)，Q13
+ *第3、4相分别为第2、1相的逆序
+ */
+static const short tp_coef_tab[2][LOUDNESS_TP_TAPS] = {
+    {  14,   90, -161,  272,  -487, 1125, 7964,  -838, 390, -218, 122,  -68},
+    {-239,  240, -424,  730, -1364, 3810, 6388, -1641, 832, -477, 271, -155},
+};
+
+/*门限直方图每格下边沿的能量(相对-70LUFS)：100 * 10^(k / 10)*/
+static const u32 lufs_bin_energy[LOUDNESS_LUFS_GATE_BINS] = {
+    100, 126, 158, 200, 251, 316, 398, 501, 631, 794,
+    1000, 1259, 1585, 1995, 2512, 3162, 3981, 5012, 6310, 7943,
+    10000, 12589, 15849, 19953, 25119, 31623, 39811, 50119, 63096, 79433,
+    100000, 125893, 158489, 199526, 251189, 316228, 398107, 501187, 630957, 794328,
+    1000000, 1258925, 1584893, 1995262, 2511886, 3162278, 3981072, 5011872, 6309573, 7943282,
+    10000000, 12589254, 15848932, 19952623, 25118864, 31622777, 39810717, 50118723, 63095734, 79432823,
+    100000000, 125892541, 158489319, 199526231, 251188643, 316227766, 398107171, 501187234, 630957344, 794328235,
+    1000000000, 1258925412, 1584893192, 1995262315, 2511886432, 3162277660,
+};
+
+/*
+ *格内偏移(0.1LU一级)对应的能量倍数，Q12：4096 * 10^(f / 100)
+ *每格累加各块相对下边沿的能量，积分时按格内的平均能量计算，
+ *不会因为统一取格中心而带来最多0.5LU的偏差
+ */
+#define LUFS_FRAC_Q		12
+static const u16 lufs_frac_energy[10] = {
+    4096, 4191, 4289, 4389, 4491, 4596, 4703, 4812, 4924, 5039,
+};
+
+/*均方值(s16满幅为2^30)转换为LUFS，单位0.1LU：-0.691 + 10*log10(ms / 2^30)*/
+static int lufs_from_ms(u64 ms)
+{
+    int lufs = amp_db10(ms) - 903 - 7;
+    return (lufs < -700) ? -700 : lufs;
+}
+
+int loudness_meter_ext_enable(LOUDNESS_M_STRUCT *loud_obj, int sr, u8 flags)
+{
+    LOUDNESS_M_EXT *ext = &loud_obj->ext;
+    u8 req_flags = flags;
+    memset(ext, 0, sizeof(LOUDNESS_M_EXT));
+    ext->momentary = -700;
+    ext->short_term = -700;
+    if (flags & LOUDNESS_M_FLAG_LUFS) {
+        for (int i = 0; i < ARRAY_SIZE(kw_coef_tab); i++) {
+            if (kw_coef_tab[i][0] == sr) {
+                ext->kw_coef = &kw_coef_tab[i][1];
+                break;
+            }
+        }
+        if (ext->kw_coef == NULL) {
+            amplitude_log("[%d]lufs not support sr:%d\n", loud_obj->index, sr);
+            flags &= ~LOUDNESS_M_FLAG_LUFS;
+        }
+        ext->sub_len = sr / 10;
+    }
+    loud_obj->flags = flags;
+    return (flags == req_flags) ? 0 : -1;
+}
+
+/*K计权滤波 + 100ms子块能量统计*/
+static void loudness_meter_lufs_run(LOUDNESS_M_STRUCT *loud_obj, short *data, int len)
+{
+    LOUDNESS_M_EXT *ext = &loud_obj->ext;
+    const int *c = ext->kw_coef;
+    int *s0 = ext->kw_state[0];
+    int *s1 = ext->kw_state[1];
+    int i;
+
+    for (i = 0; i < len; i++) {
+        /*输入放大2^8，提高低频高通的运算精度*/
+        int x = data[i] << 8;
+        s64 acc = (s64)c[0] * x + (s64)c[1] * s0[0] + (s64)c[2] * s0[1]
+                  - (s64)c[3] * s0[2] - (s64)c[4] * s0[3];
+        int y = (int)(acc >> KW_COEF_Q);
+        s0[1] = s0[0];
+        s0[0] = x;
+        s0[3] = s0[2];
+        s0[2] = y;
+
+        acc = ((s64)(y - 2 * s1[0] + s1[1]) << KW_COEF_Q) - (s64)c[5] * s1[2] - (s64)c[6] * s1[3];
+        int z = (int)(acc >> KW_COEF_Q);
+        s1[1] = s1[0];
+        s1[0] = y;
+        s1[3] = s1[2];
+        s1[2] = z;
+
+        ext->energy += ((s64)z * z) >> 16;
+        if (++ext->sub_cnt < ext->sub_len) {
+            continue;
+        }
+
+        u64 ms = ext->energy / ext->sub_len;
+        ext->sub_ms[ext->sub_wr] = (ms > 0xFFFFFFFF) ? 0xFFFFFFFF : (u32)ms;
+        ext->sub_wr = (ext->sub_wr + 1) % LOUDNESS_LUFS_SUB_NUM;
+        if (ext->sub_num < LOUDNESS_LUFS_SUB_NUM) {
+            ext->sub_num++;
+        }
+        ext->energy = 0;
+        ext->sub_cnt = 0;
+
+        /*瞬时响度：最近4个子块(400ms)，75%重叠*/
+        if (ext->sub_num >= 4) {
+            u64 sum = 0;
+            int k, rd = ext->sub_wr;
+            for (k = 0; k < ext->sub_num; k++) {
+                rd = (rd == 0) ? (LOUDNESS_LUFS_SUB_NUM - 1) : (rd - 1);
+                sum += ext->sub_ms[rd];
+                if (k == 3) {
+                    ext->momentary = lufs_from_ms(sum >> 2);
+                }
+            }
+            ext->short_term = lufs_from_ms(sum / ext->sub_num);
+            /*绝对门限-70LUFS*/
+            if (ext->momentary > -700) {
+                int bin = (ext->momentary + 700) / 10;
+                int frac = (ext->momentary + 700) % 10;
+                if (bin >= LOUDNESS_LUFS_GATE_BINS) {
+                    bin = LOUDNESS_LUFS_GATE_BINS - 1;
+                    frac = 9;
+                }
+                if (ext->gate_hist[bin] < 0xFFFF) {
+                    ext->gate_hist[bin]++;
+                    ext->gate_energy[bin] += lufs_frac_energy[frac];
+                }
+            }
+        }
+    }
+}
+
+/*门限后的积分响度：先求绝对门限以上的平均响度，再以其-10LU作为相对门限*/
+static int loudness_meter_integrated(LOUDNESS_M_EXT *ext)
+{
+    u64 energy;
+    u32 cnt;
+    int k, gate_bin, lufs;
+
+    for (int pass = 0, start = 0; pass < 2; pass++) {
+        energy = 0;
+        cnt = 0;
+        for (k = start; k < LOUDNESS_LUFS_GATE_BINS; k++) {
+            energy += ((u64)ext->gate_energy[k] * lufs_bin_energy[k]) >> LUFS_FRAC_Q;
+            cnt += ext->gate_hist[k];
+        }
+        if (cnt == 0) {
+            return -700;
+        }
+        /*-70LUFS + 10*log10(energy / cnt / 100)*/
+        lufs = -700 - 200 + amp_db10(energy / cnt);
+        gate_bin = (lufs - 100 + 700) / 10;
+        start = (gate_bin < 0) ? 0 : gate_bin;
+    }
+    return lufs;
+}
+
+/*真峰值：4倍过采样后的最大绝对值*/
+static void loudness_meter_true_peak_run(LOUDNESS_M_STRUCT *loud_obj, short *data, int len)
+{
+    LOUDNESS_M_EXT *ext = &loud_obj->ext;
+    int i, j;
+    int tp_max = ext->tp_max;
+
+    for (i = 0; i < len; i++) {
+        short *h;
+        int acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+        ext->tp_hist[ext->tp_wr] = data[i];
+        ext->tp_hist[ext->tp_wr + LOUDNESS_TP_TAPS] = data[i];
+        ext->tp_wr = (ext->tp_wr + 1) % LOUDNESS_TP_TAPS;
+        h = &ext->tp_hist[ext->tp_wr];
+        for (j = 0; j < LOUDNESS_TP_TAPS; j++) {
+            acc0 += tp_coef_tab[0][j] * h[j];
+            acc1 += tp_coef_tab[1][j] * h[j];
+            acc2 += tp_coef_tab[1][LOUDNESS_TP_TAPS - 1 - j] * h[j];
+            acc3 += tp_coef_tab[0][LOUDNESS_TP_TAPS - 1 - j] * h[j];
+        }
+        acc0 = (acc0 < 0) ? -acc0 : acc0;
+        acc1 = (acc1 < 0) ? -acc1 : acc1;
+        acc2 = (acc2 < 0) ? -acc2 : acc2;
+        acc3 = (acc3 < 0) ? -acc3 : acc3;
+        acc0 = (acc0 > acc1) ? acc0 : acc1;
+        acc2 = (acc2 > acc3) ? acc2 : acc3;
+        acc0 = (acc0 > acc2) ? acc0 : acc2;
+        tp_max = (tp_max > acc0) ? tp_max : acc0;
+    }
+    ext->tp_max = tp_max;
+}
+#else
+int loudness_meter_ext_enable(LOUDNESS_M_STRUCT *loud_obj, int sr, u8 flags)
+{
+    return -1;
+}
+#endif/*LOUDNESS_METER_EXT_ENABLE*/
+
 /*
 *********************************************************************
 *                  Loudness meter init
@@ -47,124 +347,176 @@ void loudness_meter_init(LOUDNESS_M_STRUCT *loud_obj, int sr, int print_dest, u8
     loud_obj->inv_counterpreiod = 16777216 / loud_obj->countperiod;
     loud_obj->print_dest = print_dest;
     loud_obj->index = index;
+    loud_obj->snapshot.rms_db = -31;
+    loud_obj->snapshot.peak_db = -31;
+    loud_obj->snapshot.momentary_lufs = -700;
+    loud_obj->snapshot.short_term_lufs = -700;
+    loud_obj->snapshot.integrated_lufs = -700;
+    loud_obj->snapshot.true_peak_db = -1000;
 }
 
 /*
 *********************************************************************
-*                  Loudness meter short
-* Description: 响度计算函数
+*                  Loudness meter snapshot
+* Description: 获取最近一次统计周期的结果
 * Arguments  : loud_obj
-*			   data
-*			   len
+*			   snap		结果输出
 * Return	 : NULL
-* Note(s)    : NULL
+* Note(s)    : 可在其他任务中调用，快照在统计周期结束时整体更新
 *********************************************************************
 */
-void loudness_meter_short(LOUDNESS_M_STRUCT *loud_obj, short *data, int len)
+void loudness_meter_get_snapshot(LOUDNESS_M_STRUCT *loud_obj, LOUDNESS_M_SNAPSHOT *snap)
 {
-    int i;
-    int loudness_val = 0;
-
-    for (i = 0; i < len; i++) {
-        int tmp = data[i] * 256;
-        loud_obj->dclevel = (loud_obj->dclevel * 511 + tmp) >> 9;
-
-        int xabs = (data[i] > 0) ? data[i] : (-data[i]);
-        int xabs2 = (xabs * xabs) >> 10;
-        loud_obj->rms += xabs2;
-        loud_obj->maxval = (loud_obj->maxval > xabs) ? loud_obj->maxval : xabs;
-
-        if (xabs >= 32767) {
-            loud_obj->errprintfcount0++;
-        }
+    local_irq_disable();
+    memcpy(snap, &loud_obj->snapshot, sizeof(LOUDNESS_M_SNAPSHOT));
+    local_irq_enable();
+}
 
-        loud_obj->counti++;
-        if (loud_obj->counti > loud_obj->countperiod) {
-            if (loud_obj->maxval_print < loud_obj->maxval) {
-                loud_obj->maxval_print = loud_obj->maxval;
-            }
+/*统计周期结束：电平映射、日志输出及快照更新*/
+static void loudness_meter_period_end(LOUDNESS_M_STRUCT *loud_obj)
+{
+    LOUDNESS_M_SNAPSHOT snap;
+    int rmsval = ((__int64)loud_obj->rms_print * (__int64)loud_obj->inv_counterpreiod) >> (24 - (10 - 3));
+    int rms_level, peak_level;
 
-            if (loud_obj->rms_print < loud_obj->rms) {
-                loud_obj->rms_print = loud_obj->rms;
-            }
+    if (rmsval > 25837266) {
+        amplitude_log("[%d]energy  high... \n", loud_obj->index);
+    }
 
-            loud_obj->counti = 0;
-            loud_obj->maxval = 0;
-            loud_obj->rms = 0;
+    rms_level = amp_rms_level(rmsval);
+    if (rms_level < 31) {
+        amplitude_log("[%d]rms level: %d to %d dB\n", loud_obj->index, -rms_level, -rms_level - 1);
+    } else {
+        amplitude_log("[%d]rms level < -30dB \n", loud_obj->index);
+    }
 
-            if (loud_obj->errprintfcount0 > 2) {
-                loud_obj->errprintfcount0 = 0;
-                amplitude_log("[%d]overflow occur... \n", loud_obj->index);
-            }
+    peak_level = amp_peak_level(loud_obj->maxval_print);
+    if (peak_level < 31) {
+        loud_obj->peak_val = -peak_level - 1;
+        amplitude_log("[%d]peak level: %d to %d dB\n", loud_obj->index, -peak_level, -peak_level - 1);
+    } else {
+        loud_obj->peak_val = -31;
+        amplitude_log("[%d]peak level < -30dB \n", loud_obj->index);
+    }
 
-            loud_obj->print_cnt++;
+    memcpy(&snap, &loud_obj->snapshot, sizeof(LOUDNESS_M_SNAPSHOT));
+    snap.update_cnt++;
+    snap.rms_db = (rms_level < 31) ? -rms_level : -31;
+    snap.peak_db = loud_obj->peak_val;
+    snap.dc_level = loud_obj->dclevel >> 8;
+    snap.overflow_cnt = loud_obj->overflow_cnt;
+#if LOUDNESS_METER_EXT_ENABLE
+    if (loud_obj->flags & LOUDNESS_M_FLAG_LUFS) {
+        snap.momentary_lufs = loud_obj->ext.momentary;
+        snap.short_term_lufs = loud_obj->ext.short_term;
+        snap.integrated_lufs = loudness_meter_integrated(&loud_obj->ext);
+        amplitude_log("[%d]lufs M:%d S:%d I:%d (0.1LU)\n", loud_obj->index,
+                      snap.momentary_lufs, snap.short_term_lufs, snap.integrated_lufs);
+    }
+    if (loud_obj->flags & LOUDNESS_M_FLAG_TRUE_PEAK) {
+        /*满幅：32768 * 8192(Q13) = 2^28*/
+        snap.true_peak_db = loud_obj->ext.tp_max_print ? (2 * amp_db10(loud_obj->ext.tp_max_print) - 1686) : -1000;
+        loud_obj->ext.tp_max_print = 0;
+        amplitude_log("[%d]true peak:%d (0.1dBTP)\n", loud_obj->index, snap.true_peak_db);
+    }
+#endif/*LOUDNESS_METER_EXT_ENABLE*/
+    local_irq_disable();
+    memcpy(&loud_obj->snapshot, &snap, sizeof(LOUDNESS_M_SNAPSHOT));
+    local_irq_enable();
 
-            if (loud_obj->print_cnt >= loud_obj->print_dest) {
+    loud_obj->print_cnt = 0;
+    loud_obj->maxval_print = 0;
+    loud_obj->rms_print = 0;
+    loud_obj->overflow_cnt = 0;
 
-                int rmsval = ((__int64)loud_obj->rms_print * (__int64)loud_obj->inv_counterpreiod) >> (24 - (10 - 3));
+    if (loud_obj->dclevel > (255 * 256)) {
+        amplitude_log("[%d] why ??? dc level : %d \n", loud_obj->index, loud_obj->dclevel >> 8);
+    }
+    amplitude_log("\n\n");
+}
 
-                if (rmsval > 25837266) {
-                    amplitude_log("[%d]energy  high... \n", loud_obj->index);
-                }
+/*
+*********************************************************************
+*                  Loudness meter short
+* Description: 响度计算函数
+* Arguments  : loud_obj
+*			   data
+*			   len
+* Return	 : NULL
+* Note(s)    : 按统计周期分块处理：直流跟踪为递推运算单独一个循环，
+*			   rms/峰值/削波计数在无分支的内层循环累加
+*********************************************************************
+*/
+void loudness_meter_short(LOUDNESS_M_STRUCT *loud_obj, short *data, int len)
+{
+    int i;
 
-                {
-                    int compi = 0, found = 0;;
-                    while (compi < 31) {
-                        if (rmsval >= rms_va_tab[compi]) {
-//							float  upval = (0 - compi) * 0.5;
-//							float  dwonval = (0 - compi - 1) * 0.5;
-//							amplitude_log("rms level: %f to %f dB\n", upval, dwonval);
+#if LOUDNESS_METER_EXT_ENABLE
+    if (loud_obj->flags & LOUDNESS_M_FLAG_LUFS) {
+        loudness_meter_lufs_run(loud_obj, data, len);
+    }
+    if (loud_obj->flags & LOUDNESS_M_FLAG_TRUE_PEAK) {
+        loudness_meter_true_peak_run(loud_obj, data, len);
+    }
+#endif/*LOUDNESS_METER_EXT_ENABLE*/
 
-                            int  upval = (0 - compi);
-                            int  dwonval = (0 - compi - 1);
+    while (len > 0) {
+        /*本次处理到统计周期结束(counti > countperiod)为止*/
+        int n = loud_obj->countperiod + 1 - loud_obj->counti;
+        int dclevel = loud_obj->dclevel;
+        u32 rms = 0;
+        int maxval = loud_obj->maxval;
+        int overflow = 0;
 
-                            amplitude_log("[%d]rms level: %d to %d dB\n", loud_obj->index, upval, dwonval);
+        n = (n > len) ? len : n;
+        for (i = 0; i < n; i++) {
+            dclevel = (dclevel * 511 + data[i] * 256) >> 9;
+        }
+        for (i = 0; i < n; i++) {
+            int x = data[i];
+            int xabs = (x ^ (x >> 31)) - (x >> 31);
+            rms += (u32)(xabs * xabs) >> 10;
+            maxval = (maxval > xabs) ? maxval : xabs;
+            overflow += (xabs >= 32767);
+        }
+        loud_obj->dclevel = dclevel;
+        loud_obj->rms += rms;
+        loud_obj->maxval = maxval;
+        loud_obj->errprintfcount0 += overflow;
+        loud_obj->overflow_cnt += overflow;
+        loud_obj->counti += n;
+        data += n;
+        len -= n;
 
-                            found = 1;
-                            break;
-                        }
-                        compi++;
-                    }
+        if (loud_obj->counti <= loud_obj->countperiod) {
+            break;
+        }
 
-                    if (found == 0) {
-                        amplitude_log("[%d]rms level < -30dB \n", loud_obj->index);
-                    }
-                }
+        if (loud_obj->maxval_print < loud_obj->maxval) {
+            loud_obj->maxval_print = loud_obj->maxval;
+        }
+        if (loud_obj->rms_print < loud_obj->rms) {
+            loud_obj->rms_print = loud_obj->rms;
+        }
+        loud_obj->counti = 0;
+        loud_obj->maxval = 0;
+        loud_obj->rms = 0;
 
-                {
-                    int compi = 0, found = 0;;
-                    while (compi < 31) {
-                        if (loud_obj->maxval_print >= am_va_tab[compi]) {
-//							float  upval = (0 - compi) * 0.5;
-//							float  dwonval = (0 - compi - 1) * 0.5;
-//							amplitude_log("peak level: %f to %f dB\n", upval, dwonval);
-                            int  upval = (0 - compi);
-                            int  dwonval = (0 - compi - 1);
-                            loud_obj->peak_val = dwonval;
-                            amplitude_log("[%d]peak level: %d to %d dB\n", loud_obj->index, upval, dwonval);
-
-                            found = 1;
-                            break;
-                        }
-
-                        compi++;
-                    }
-
-                    if (found == 0) {
-                        loud_obj->peak_val = -31;
-                        amplitude_log("[%d]peak level < -30dB \n", loud_obj->index);
-                    }
-                }
+        if (loud_obj->errprintfcount0 > 2) {
+            loud_obj->errprintfcount0 = 0;
+            amplitude_log("[%d]overflow occur... \n", loud_obj->index);
+        }
 
-                loud_obj->print_cnt = 0;
-                loud_obj->maxval_print = 0;
-                loud_obj->rms_print = 0;
+#if LOUDNESS_METER_EXT_ENABLE
+        if (loud_obj->ext.tp_max_print < loud_obj->ext.tp_max) {
+            loud_obj->ext.tp_max_print = loud_obj->ext.tp_max;
+        }
+        loud_obj->ext.tp_max = 0;
+#endif/*LOUDNESS_METER_EXT_ENABLE*/
 
-                if (loud_obj->dclevel > (255 * 256)) {
-                    amplitude_log("[%d] why ??? dc level : %d \n", loud_obj->index, loud_obj->dclevel >> 8);
-                }
-                amplitude_log("\n\n");
-            }
+        loud_obj->print_cnt++;
+        if (loud_obj->print_cnt >= loud_obj->print_dest) {
+            loudness_meter_period_end(loud_obj);
         }
     }
 }
@@ -3,6 +3,56 @@
 
 #include "generic/typedef.h"
 
+/*
+ *响度扩展统计使能：K计权短时/积分响度(ITU-R BS.1770)及4倍过采样真峰值
+ *每个统计对象额外占用约700byte RAM，默认关闭
+ */
+#define LOUDNESS_METER_EXT_ENABLE		0
+
+#define LOUDNESS_M_FLAG_LUFS			BIT(0)	/*K计权响度统计*/
+#define LOUDNESS_M_FLAG_TRUE_PEAK		BIT(1)	/*真峰值统计*/
+
+#define LOUDNESS_LUFS_SUB_NUM			30	/*100ms子块个数，即短时响度3s窗*/
+#define LOUDNESS_LUFS_GATE_BINS			76	/*积分响度门限直方图，-70~+5LUFS，1LU一格*/
+#define LOUDNESS_TP_TAPS				12	/*真峰值多相滤波器每相抽头数*/
+
+/*
+ *统计结果快照，每个统计周期(print_dest)结束时更新
+ *dB类数值：rms_db/peak_db单位1dB，其余单位0.1dB(LUFS/dBTP)
+ */
+typedef struct {
+    u32 update_cnt;			/*快照更新次数*/
+    s16 rms_db;				/*rms电平上限，-31表示小于-30dB*/
+    s16 peak_db;			/*峰值电平下限，同peak_val*/
+    s16 dc_level;			/*直流电平*/
+    u16 overflow_cnt;		/*统计周期内的削波点数*/
+    s16 momentary_lufs;		/*瞬时响度(400ms)*/
+    s16 short_term_lufs;	/*短时响度(3s)*/
+    s16 integrated_lufs;	/*积分响度(门限后)*/
+    s16 true_peak_db;		/*真峰值(dBTP)*/
+} LOUDNESS_M_SNAPSHOT;
+
+#if LOUDNESS_METER_EXT_ENABLE
+typedef struct {
+    const int *kw_coef;							/*K计权滤波器系数，NULL表示采样率不支持*/
+    int kw_state[2][4];							/*两级biquad的x1,x2,y1,y2*/
+    u64 energy;									/*当前子块能量累加*/
+    u32 sub_len;								/*子块点数(100ms)*/
+    u32 sub_cnt;
+    u32 sub_ms[LOUDNESS_LUFS_SUB_NUM];			/*子块均方值*/
+    u16 gate_hist[LOUDNESS_LUFS_GATE_BINS];	/*400ms块响度直方图*/
+    u32 gate_energy[LOUDNESS_LUFS_GATE_BINS];	/*每格内各块相对格下边沿的能量和(Q12)*/
+    u8 sub_wr;
+    u8 sub_num;
+    u8 tp_wr;
+    short tp_hist[LOUDNESS_TP_TAPS * 2];		/*真峰值滤波历史数据(双倍长度环形)*/
+    int tp_max;									/*周期内过采样峰值(Q13)*/
+    int tp_max_print;
+    short momentary;
+    short short_term;
+} LOUDNESS_M_EXT;
+#endif/*LOUDNESS_METER_EXT_ENABLE*/
+
 typedef  struct _LOUDNESS_M_STRUCT_ {
     int mutecnt;
     int rms;
@@ -18,9 +68,17 @@ typedef  struct _LOUDNESS_M_STRUCT_ {
     int maxval_print;
     int peak_val;
     u8 index;
+    u8 flags;
+    u16 overflow_cnt;
+    LOUDNESS_M_SNAPSHOT snapshot;
+#if LOUDNESS_METER_EXT_ENABLE
+    LOUDNESS_M_EXT ext;
+#endif/*LOUDNESS_METER_EXT_ENABLE*/
 } LOUDNESS_M_STRUCT;
 
 void  loudness_meter_init(LOUDNESS_M_STRUCT *loud_obj, int sr, int print_dest, u8 index);
 void  loudness_meter_short(LOUDNESS_M_STRUCT *loud_obj, short *data, int len);
+int   loudness_meter_ext_enable(LOUDNESS_M_STRUCT *loud_obj, int sr, u8 flags);
+void  loudness_meter_get_snapshot(LOUDNESS_M_STRUCT *loud_obj, LOUDNESS_M_SNAPSHOT *snap);
 
 #endif /*_AMPLITUDE_STATISTIC_H_*/
@@ -8,6 +8,15 @@
  */
 
 #include "audio_dvol.h"
+#include "audio_mips_prof.h"
+
+#ifdef AUDIO_DVOL_HOST
+/*PC上单线程回放(tools/host_test)，不需要互斥*/
+typedef int OS_MUTEX;
+#define os_mutex_create(mutex)
+#define os_mutex_pend(mutex, timeout)
+#define os_mutex_post(mutex)
+#endif
 
 #if 0
 #define dvol_log	y_printf
@@ -29,11 +38,19 @@
 #define  L_sat(b,a)       __asm__ volatile("%0=sat16(%1)(s)":"=&r"(b) : "r"(a));
 #define  L_sat32(b,a,n)       __asm__ volatile("%0=%1>>%2(s)":"=&r"(b) : "r"(a),"r"(n));
 
+/*
+ *句柄索引表：按dvol_idx低位直接索引，避免每次运算都遍历dvol_head
+ *同一索引重复打开时，表中记录最新打开的句柄（与链表头插顺序一致）
+ */
+#define DVOL_HDL_TAB_SIZE	8
+#define DVOL_HDL_SLOT(idx)	((idx) & (DVOL_HDL_TAB_SIZE - 1))
+
 typedef struct {
     u8 bg_dvol_fade_out;
     u8 start;
     OS_MUTEX mutex;
     struct list_head dvol_head;
+    dvol_handle *hdl_tab[DVOL_HDL_TAB_SIZE];
 } dvol_t;
 static dvol_t dvol_attr;
 
@@ -77,6 +94,42 @@ const u16 dig_vol_table[DIGITAL_VOL_MAX + 1] = {
     16384 //31
 };
 
+/*
+ *根据通道索引查找句柄：先查索引表(O(1))，索引表冲突时再遍历链表
+ */
+static dvol_handle *audio_digital_vol_find(u8 dvol_idx)
+{
+    dvol_handle *dvol = dvol_attr.hdl_tab[DVOL_HDL_SLOT(dvol_idx)];
+    if (dvol && (dvol->idx == dvol_idx)) {
+        return dvol;
+    }
+    local_irq_disable();
+    list_for_each_entry(dvol, &dvol_attr.dvol_head, entry) {
+        if (dvol->idx == dvol_idx) {
+            local_irq_enable();
+            return dvol;
+        }
+    }
+    local_irq_enable();
+    return NULL;
+}
+
+/*
+ *句柄关闭后刷新索引表，索引表指向链表中同一槽位最新的句柄
+ *调用者需关中断
+ */
+static void audio_digital_vol_slot_update(u8 dvol_idx)
+{
+    dvol_handle *hdl;
+    dvol_attr.hdl_tab[DVOL_HDL_SLOT(dvol_idx)] = NULL;
+    list_for_each_entry(hdl, &dvol_attr.dvol_head, entry) {
+        if (DVOL_HDL_SLOT(hdl->idx) == DVOL_HDL_SLOT(dvol_idx)) {
+            dvol_attr.hdl_tab[DVOL_HDL_SLOT(dvol_idx)] = hdl;
+            break;
+        }
+    }
+}
+
 /*
 *********************************************************************
 *                  Audio Digital Volume Init
@@ -142,6 +195,7 @@ dvol_handle *audio_digital_vol_open(u8 dvol_idx, u8 vol, u8 vol_max, u16 fade_st
         dvol->idx = dvol_idx;
         local_irq_disable();
         list_add(&dvol->entry, &dvol_attr.dvol_head);
+        dvol_attr.hdl_tab[DVOL_HDL_SLOT(dvol_idx)] = dvol;
 #if BG_DVOL_FADE_ENABLE
         dvol->vol_bk = -1;
         if (dvol_attr.bg_dvol_fade_out) {
@@ -212,6 +266,7 @@ void audio_digital_vol_close(u8 dvol_idx)
         }
 #endif
         list_del(&dvol->entry);
+        audio_digital_vol_slot_update(dvol_idx);
         free(dvol);
         dvol = NULL;
         local_irq_enable();
@@ -229,17 +284,8 @@ void audio_digital_vol_close(u8 dvol_idx)
 */
 int audio_digital_vol_get(u8 dvol_idx)
 {
-    dvol_handle *dvol = NULL;
-    u8 dvol_valid = 0;
-    local_irq_disable();
-    list_for_each_entry(dvol, &dvol_attr.dvol_head, entry) {
-        if (dvol && (dvol->idx == dvol_idx)) {
-            dvol_valid = 1;
-            break;
-        }
-    }
-    local_irq_enable();
-    if (dvol && dvol_valid) {
+    dvol_handle *dvol = audio_digital_vol_find(dvol_idx);
+    if (dvol) {
         return dvol->vol;
     }
     return 0;
@@ -258,20 +304,11 @@ int audio_digital_vol_get(u8 dvol_idx)
 void audio_digital_vol_set(u8 dvol_idx, u8 vol)
 {
     dvol_log("audio_digital_vol set:%d,%d\n", dvol_idx, vol);
-    dvol_handle *dvol = NULL;
-    u8 dvol_valid = 0;
-    local_irq_disable();
-    list_for_each_entry(dvol, &dvol_attr.dvol_head, entry) {
-        if (dvol && (dvol->idx == dvol_idx)) {
-            dvol_log("dvol_set[%x]:%x", dvol_idx, dvol);
-            dvol_valid = 1;
-            break;
-        }
-    }
-    local_irq_enable();
-    if ((dvol == NULL) || (dvol_valid == 0)) {
+    dvol_handle *dvol = audio_digital_vol_find(dvol_idx);
+    if (dvol == NULL) {
         return;
     }
+    dvol_log("dvol_set[%x]:%x", dvol_idx, dvol);
     if (dvol->toggle == 0) {
         return;
     }
@@ -299,20 +336,11 @@ void audio_digital_vol_set(u8 dvol_idx, u8 vol)
 void audio_digital_vol_set_no_fade(u8 dvol_idx, u8 vol)
 {
     dvol_log("audio_digital_vol set:%d,%d\n", dvol_idx, vol);
-    dvol_handle *dvol = NULL;
-    u8 dvol_valid = 0;
-    local_irq_disable();
-    list_for_each_entry(dvol, &dvol_attr.dvol_head, entry) {
-        if (dvol && (dvol->idx == dvol_idx)) {
-            dvol_log("dvol_set[%x]:%x", dvol_idx, dvol);
-            dvol_valid = 1;
-            break;
-        }
-    }
-    local_irq_enable();
-    if ((dvol == NULL) || (dvol_valid == 0)) {
+    dvol_handle *dvol = audio_digital_vol_find(dvol_idx);
+    if (dvol == NULL) {
         return;
     }
+    dvol_log("dvol_set[%x]:%x", dvol_idx, dvol);
     if (dvol->toggle == 0) {
         return;
     }
@@ -330,112 +358,193 @@ void audio_digital_vol_set_no_fade(u8 dvol_idx, u8 vol)
 
 void audio_digital_vol_reset_fade(u8 dvol_idx)
 {
-    dvol_handle *dvol = NULL;
-    u8 dvol_valid = 0;
-    local_irq_disable();
-    list_for_each_entry(dvol, &dvol_attr.dvol_head, entry) {
-        if (dvol && (dvol->idx == dvol_idx)) {
-            dvol_valid = 1;
-            break;
+    dvol_handle *dvol = audio_digital_vol_find(dvol_idx);
+    if (dvol) {
+        dvol->vol_fade = 0;
+    }
+}
+
+/*
+ *对称rounding乘法，与原来负数先转正数运算再转回的结果一致（避免负数右移位引入1的误差）：
+ *-((-x * gain + 0.5) >> 14) == (x * gain + 0.5 - 1) >> 14，
+ *负数的舍入常数减1即可，不需要取绝对值和逐点的符号分支
+ */
+#define DVOL_GAIN_SHIFT		14
+#define DVOL_ROUND			(1 << (DVOL_GAIN_SHIFT - 1))
+static inline s32 dvol_mul_round(s32 x, s32 gain)
+{
+    x = (x * gain + DVOL_ROUND + (x >> 31)) >> DVOL_GAIN_SHIFT;
+    return data_sat_s16(x);
+}
+
+/*
+ *一个32bit字内打包的两个s16（低半字在前，即交织立体声的L/R）同时运算：
+ *两路分别放在64bit数的高低32bit，一次乘法和一次舍入常数加法完成两路，
+ *gain不超过1 << 14时低路的结果在+-2^30以内，低32bit就是低路的值，
+ *低路为负时向高路借了1，高路加回即可
+ */
+#ifndef DVOL_MUL_PACKED
+#define DVOL_MUL_PACKED		1	/*0:两路分别调用dvol_mul_round，tools/host_test/dvol_test可对比两种方式的耗时*/
+#endif
+static inline u32 dvol_mul_round_x2(u32 w, s32 gain)
+{
+    s32 lo = (s16)w;
+    s32 hi = (s32)w >> 16;
+#if DVOL_MUL_PACKED
+    s64 x = ((s64)hi << 32) + lo;
+
+    x = x * gain + ((s64)(DVOL_ROUND + (hi >> 31)) << 32) + (DVOL_ROUND + (lo >> 31));
+    lo = (s32)x;
+    hi = (s32)(x >> 32) - (lo >> 31);
+    lo = data_sat_s16(lo >> DVOL_GAIN_SHIFT);
+    hi = data_sat_s16(hi >> DVOL_GAIN_SHIFT);
+#else
+    lo = dvol_mul_round(lo, gain);
+    hi = dvol_mul_round(hi, gain);
+#endif
+    return ((u32)lo & 0xFFFF) | ((u32)hi << 16);
+}
+
+/*
+ *整块音量恒定时的运算，按声道数选择对应路径
+ */
+static void dvol_apply_const(s16 *buf, u32 frames, u8 ch_num, s32 gain)
+{
+    u32 i;
+    if (gain == (1 << DVOL_GAIN_SHIFT)) {
+        return;
+    }
+    if ((ch_num == 2) && (((unsigned long)buf & 0x3) == 0)) {
+        u32 *wbuf = (u32 *)buf;
+        for (i = 0; i < frames; i++) {
+            wbuf[i] = dvol_mul_round_x2(wbuf[i], gain);
         }
+        return;
     }
-    local_irq_enable();
-    if (dvol && dvol_valid) {
-        dvol->vol_fade = 0;
+    u32 points = frames * ch_num;
+    for (i = 0; i < points; i++) {
+        buf[i] = dvol_mul_round(buf[i], gain);
+    }
+}
+
+/*
+ *音量渐变段：每帧(所有声道)音量步进一次，gain为第一帧的音量
+ */
+static void dvol_apply_ramp(s16 *buf, u32 frames, u8 ch_num, s32 gain, s32 delta)
+{
+    u32 i;
+    u8 ch;
+    if (ch_num == 1) {
+        for (i = 0; i < frames; i++, gain += delta) {
+            buf[i] = dvol_mul_round(buf[i], gain);
+        }
+    } else if ((ch_num == 2) && (((unsigned long)buf & 0x3) == 0)) {
+        u32 *wbuf = (u32 *)buf;
+        for (i = 0; i < frames; i++, gain += delta) {
+            wbuf[i] = dvol_mul_round_x2(wbuf[i], gain);
+        }
+    } else {
+        for (i = 0; i < frames; i++, gain += delta) {
+            for (ch = 0; ch < ch_num; ch++) {
+                *buf = dvol_mul_round(*buf, gain);
+                buf++;
+            }
+        }
     }
 }
 
 /*
 *********************************************************************
-*                  Audio Digital Volume Process
-* Description: 数字音量运算核心
+*                  Audio Digital Volume Process(Multi Channel)
+* Description: 数字音量运算核心，支持单声道/多声道交织数据
 * Arguments  : dvol_idx 数字音量通道索引，详见audio_dvol.h宏定义
 *			   data		待运算数据
-*			   len		待运算数据长度
+*			   len		待运算数据长度(byte)
+*			   ch_num	交织的声道数
 * Return	 : 0 成功 其他 失败
-* Note(s)    : None.
+* Note(s)    : 淡入淡出按帧(每帧ch_num个点)线性步进，整块预先算出渐变段长度，
+*			   渐变段之后按恒定音量运算
 *********************************************************************
 */
-/*rounding处理*/
-#define MUL32_PSHIFT(x,y,s) (((x) * (y) + (1 << ((s)-1))) >> (s))
 AT(.common)
-int audio_digital_vol_run(u8 dvol_idx, void *data, u32 len)
+int audio_digital_vol_run_ch(u8 dvol_idx, void *data, u32 len, u8 ch_num)
 {
-    s32 valuetemp;
-    s16 *buf;
+    s16 *buf = data;
+    u32 points = len >> 1; //byte to point
+    u32 frames, tail;
+    u32 ramp_frames = 0;
+    s32 gain, target, delta = 0;
 
-    os_mutex_pend(&dvol_attr.mutex, 0);
-    dvol_handle *dvol = NULL;
-    u8 dvol_valid = 0;
-    local_irq_disable();
-    list_for_each_entry(dvol, &dvol_attr.dvol_head, entry) {
-        if (dvol && (dvol->idx == dvol_idx)) {
-            dvol_valid = 1;
-#if 0
-            static dvol_handle *last_dvol = NULL;
-            if (last_dvol != dvol) {
-                dvol_log("dvol_run[%x]:%x", dvol_idx, dvol);
-                last_dvol = dvol;
-            }
-#endif
-            break;
-        }
+    if (ch_num == 0) {
+        return -1;
     }
-    local_irq_enable();
-
-    if ((dvol->toggle == 0) || (dvol_valid == 0)) {
-        os_mutex_post(&dvol_attr.mutex);
+    dvol_handle *dvol = audio_digital_vol_find(dvol_idx);
+    if ((dvol == NULL) || (dvol->toggle == 0)) {
         return -1;
     }
 
-    buf = data;
-    len >>= 1; //byte to point
-
-    for (u32 i = 0; i < len; i += 2) {
-        ///left channel
-        if (dvol->fade) {
-            if (dvol->vol_fade > dvol->vol_target) {
-                dvol->vol_fade -= dvol->fade_step;
-                if (dvol->vol_fade < dvol->vol_target) {
-                    dvol->vol_fade = dvol->vol_target;
-                }
-            } else if (dvol->vol_fade < dvol->vol_target) {
-                dvol->vol_fade += dvol->fade_step;
-                if (dvol->vol_fade > dvol->vol_target) {
-                    dvol->vol_fade = dvol->vol_target;
-                }
-            }
-        } else {
-            dvol->vol_fade = dvol->vol_target;
+    AUDIO_PROF_BEGIN(AUDIO_PROF_DVOL);
+    os_mutex_pend(&dvol_attr.mutex, 0);
+    frames = points / ch_num;
+    tail = points % ch_num;
+    target = dvol->vol_target;
+    gain = dvol->vol_fade;
+    if (dvol->fade == 0) {
+        gain = target;
+    } else if ((gain != target) && dvol->fade_step) {
+        s32 diff = target - gain;
+        delta = (diff > 0) ? dvol->fade_step : -dvol->fade_step;
+        diff = (diff > 0) ? diff : -diff;
+        /*步进后仍未到达目标的帧数*/
+        ramp_frames = (diff - 1) / dvol->fade_step;
+        if (ramp_frames > frames) {
+            ramp_frames = frames;
         }
+    } else {
+        /*fade_step为0时音量保持不变*/
+        target = gain;
+    }
 
-        valuetemp = buf[i];
-        if (valuetemp < 0) {
-            /*负数先转换成正数，运算完再转换回去，是为了避免负数右移位引入1的误差，增加底噪*/
-            valuetemp = -valuetemp;
-            /*rounding处理（加入0.5），减少小信号时候的误差和谐波幅值*/
-            valuetemp = (valuetemp * dvol->vol_fade + (1 << 13)) >> 14 ;
-            valuetemp = -valuetemp;
-        } else {
-            valuetemp = (valuetemp * dvol->vol_fade + (1 << 13)) >> 14 ;
+    if (ramp_frames) {
+        dvol_apply_ramp(buf, ramp_frames, ch_num, gain + delta, delta);
+        buf += ramp_frames * ch_num;
+        gain += delta * ramp_frames;
+    }
+    if (ramp_frames < frames) {
+        dvol_apply_const(buf, frames - ramp_frames, ch_num, target);
+        buf += (frames - ramp_frames) * ch_num;
+        gain = target;
+    }
+    if (tail) {
+        /*不足一帧的尾部数据按一帧处理，音量再步进一次*/
+        gain += delta;
+        if (((delta > 0) && (gain > target)) || ((delta < 0) && (gain < target))) {
+            gain = target;
         }
-        /*饱和处理*/
-        buf[i] = (s16)data_sat_s16(valuetemp);
-
-        ///right channel
-        valuetemp = buf[i + 1];
-        if (valuetemp < 0) {
-            /*负数先转换成正数，运算完再转换回去，是为了避免负数右移位引入1的误差，增加底噪*/
-            valuetemp = -valuetemp;
-            valuetemp = (valuetemp * dvol->vol_fade + (1 << 13)) >> 14 ;
-            valuetemp = -valuetemp;
-        } else {
-            valuetemp = (valuetemp * dvol->vol_fade + (1 << 13)) >> 14 ;
+        while (tail--) {
+            *buf = dvol_mul_round(*buf, gain);
+            buf++;
         }
-        /*饱和处理*/
-        buf[i + 1] = (s16)data_sat_s16(valuetemp);
     }
+    dvol->vol_fade = gain;
     os_mutex_post(&dvol_attr.mutex);
+    AUDIO_PROF_END(AUDIO_PROF_DVOL);
     return 0;
 }
 
+/*
+*********************************************************************
+*                  Audio Digital Volume Process
+* Description: 数字音量运算核心
+* Arguments  : dvol_idx 数字音量通道索引，详见audio_dvol.h宏定义
+*			   data		待运算数据(立体声交织)
+*			   len		待运算数据长度
+* Return	 : 0 成功 其他 失败
+* Note(s)    : None.
+*********************************************************************
+*/
+AT(.common)
+int audio_digital_vol_run(u8 dvol_idx, void *data, u32 len)
+{
+    return audio_digital_vol_run_ch(dvol_idx, data, len, 2);
+}
@@ -2,8 +2,10 @@
 #define _AUDIO_DVOL_H_
 
 #include "generic/typedef.h"
+#ifndef AUDIO_DVOL_HOST
 #include "os/os_type.h"
 #include "os/os_api.h"
+#endif
 #include "generic/list.h"
 
 #define BG_DVOL_FADE_ENABLE		1	/*多路声音叠加，背景声音自动淡出小声*/
@@ -16,9 +18,9 @@
 
 /*Digital Volume Fade Step*/
 #define MUSIC_DVOL_FS		2
-#define CALL_DVOL_FS		4
+#define CALL_DVOL_FS		2	/*单声道逐点步进*/
 #define TONE_DVOL_FS		20
-#define HEARING_DVOL_FS		2
+#define HEARING_DVOL_FS		1	/*单声道逐点步进*/
 
 /*Digital Volume Max Level*/
 #define MUSIC_DVOL_MAX		16
@@ -49,6 +51,7 @@ void audio_digital_vol_close(u8 dvol_idx);
 void audio_digital_vol_set(u8 dvol_idx, u8 vol);
 int audio_digital_vol_get(u8 dvol_idx);
 int audio_digital_vol_run(u8 dvol_idx, void *data, u32 len);
+int audio_digital_vol_run_ch(u8 dvol_idx, void *data, u32 len, u8 ch_num);
 void audio_digital_vol_reset_fade(u8 dvol_idx);
 
 #endif/*_AUDIO_DVOL_H_*/
@@ -0,0 +1,465 @@
+/*
+ ****************************************************************
+ *							AUDIO MIPS PROFILER
+ * File  : audio_mips_prof.c
+ * By    :
+ * Notes : 音频各级处理耗时统计，探针见audio_mips_prof.h
+ ****************************************************************
+ */
+
+#include "audio_mips_prof.h"
+
+#ifdef AUDIO_MIPS_PROF_HOST
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#else
+#include "system/includes.h"
+#include "online_db_deal.h"
+#include "audio_online_debug.h"
+#endif
+
+#if AUDIO_MIPS_PROF_ENABLE
+
+#ifdef AUDIO_MIPS_PROF_HOST
+#define prof_barrier()			__asm__ volatile("" ::: "memory")
+#define prof_irq_disable()
+#define prof_irq_enable()
+#elif CPU_CORE_NUM > 1
+#define prof_barrier()			__asm_csync()
+#define prof_irq_disable()		local_irq_disable()
+#define prof_irq_enable()		local_irq_enable()
+#else
+#define prof_barrier()			__asm__ volatile("" ::: "memory")
+#define prof_irq_disable()		local_irq_disable()
+#define prof_irq_enable()		local_irq_enable()
+#endif
+
+/*
+ *单次耗时直方图：按1/4倍频程分桶，0~3单独成桶，
+ *v >= 4时桶号 = (log2(v) - 1) * 4 + v的次高两位
+ */
+#define PROF_HIST_NUM			128
+#define PROF_HIST_MAX			0xffff
+#define PROF_READ_RETRY			8
+
+struct audio_mips_prof_stage {
+    volatile u32 seq;		/*奇数表示更新中*/
+    u32 calls;
+    u64 total;
+    u32 min;
+    u32 max;
+    u32 mark;				/*跨回调计时起点*/
+    u32 window_start;		/*统计窗口起点(ms)*/
+    u8 marked;
+    volatile u8 reset;		/*读端请求清零，由写端在下次记录时执行*/
+    u16 hist[PROF_HIST_NUM];
+};
+
+static struct audio_mips_prof_stage prof_stage[AUDIO_PROF_STAGE_NUM];
+
+/*
+ *忙时间累计：进入第一个区间时记下起点，最后一个区间结束时累加，
+ *区间嵌套/重叠时只计一次
+ */
+static volatile u32 prof_busy;
+static u32 prof_busy_start;
+static u8 prof_busy_depth;
+
+static const char *const prof_stage_name[AUDIO_PROF_STAGE_NUM] = {
+    "decode",
+    "dvol",
+    "eq_drc",
+    "aec",
+    "mixer",
+    "src",
+    "dac_write",
+    "dha",
+};
+
+#ifdef AUDIO_MIPS_PROF_HOST
+/*PC上以ns计数*/
+u32 audio_mips_prof_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u32)((u64)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+}
+
+static u32 prof_cnt_hz(void)
+{
+    return 1000000000;
+}
+
+static u32 prof_cpu_hz(void)
+{
+    return 1000000000;
+}
+
+static u32 prof_msec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u32)((u64)ts.tv_sec * 1000 + ts.tv_nsec / 1000000);
+}
+#else
+/*
+ *tick timer从0递增到TICK_PRD，每个jiffies计数(TICK_PRD + 1)次，
+ *jiffies和TICK_CNT拼成连续递增的计数值，读取期间跨过节拍时重读
+ */
+u32 audio_mips_prof_now(void)
+{
+    u32 j, cnt;
+    do {
+        j = jiffies;
+        cnt = TICK_CNT;
+    } while (j != jiffies);
+    return j * (TICK_PRD + 1) + cnt;
+}
+
+static u32 prof_cnt_hz(void)
+{
+    return (TICK_PRD + 1) * (1000 / jiffies_unit);
+}
+
+static u32 prof_cpu_hz(void)
+{
+    return clk_get("sys");
+}
+
+static u32 prof_msec(void)
+{
+    return jiffies_msec();
+}
+#endif
+
+static u32 prof_hist_index(u32 v)
+{
+    if (v < 4) {
+        return v;
+    }
+    u32 msb = 31 - __builtin_clz(v);
+    return (msb - 1) * 4 + ((v >> (msb - 2)) & 3);
+}
+
+/*桶的上边界，用于保守估计p99*/
+static u32 prof_hist_upper(u32 idx)
+{
+    if (idx < 4) {
+        return idx;
+    }
+    u32 msb = idx / 4 + 1;
+    u64 v = ((u64)(4 + (idx & 3) + 1) << (msb - 2)) - 1;
+    return (v > 0xffffffff) ? 0xffffffff : (u32)v;
+}
+
+static void prof_stage_clear(struct audio_mips_prof_stage *s)
+{
+    s->calls = 0;
+    s->total = 0;
+    s->min = 0xffffffff;
+    s->max = 0;
+    memset(s->hist, 0, sizeof(s->hist));
+    s->window_start = prof_msec();
+    s->reset = 0;
+}
+
+void audio_mips_prof_record(u8 stage, u32 cnt)
+{
+    struct audio_mips_prof_stage *s;
+    u32 idx;
+
+    if (stage >= AUDIO_PROF_STAGE_NUM) {
+        return;
+    }
+    if (cnt & BIT(31)) {
+        /*计时期间节拍中断未及时响应导致计数回退，丢弃*/
+        return;
+    }
+    s = &prof_stage[stage];
+    prof_irq_disable();
+    s->seq++;
+    prof_barrier();
+    if (s->reset) {
+        prof_stage_clear(s);
+    }
+    s->calls++;
+    s->total += cnt;
+    if ((s->calls == 1) || (cnt < s->min)) {
+        s->min = cnt;
+    }
+    if (cnt > s->max) {
+        s->max = cnt;
+    }
+    idx = prof_hist_index(cnt);
+    if (s->hist[idx] == PROF_HIST_MAX) {
+        /*计数饱和时整体减半，保持分布*/
+        for (int i = 0; i < PROF_HIST_NUM; i++) {
+            s->hist[i] >>= 1;
+        }
+    }
+    s->hist[idx]++;
+    prof_barrier();
+    s->seq++;
+    prof_irq_enable();
+}
+
+static void prof_busy_enter(u32 now)
+{
+    prof_irq_disable();
+    if (prof_busy_depth++ == 0) {
+        prof_busy_start = now;
+    }
+    prof_irq_enable();
+}
+
+static void prof_busy_exit(u32 now)
+{
+    prof_irq_disable();
+    if (prof_busy_depth && (--prof_busy_depth == 0)) {
+        prof_busy += now - prof_busy_start;
+    }
+    prof_irq_enable();
+}
+
+u32 audio_mips_prof_begin(void)
+{
+    u32 now = audio_mips_prof_now();
+    prof_busy_enter(now);
+    return now;
+}
+
+void audio_mips_prof_end(u8 stage, u32 start)
+{
+    u32 now = audio_mips_prof_now();
+    prof_busy_exit(now);
+    audio_mips_prof_record(stage, now - start);
+}
+
+void audio_mips_prof_mark(u8 stage)
+{
+    if (stage < AUDIO_PROF_STAGE_NUM) {
+        u32 now = audio_mips_prof_now();
+        /*重复标记(上次没有走到结束)时不重复进入忙区间*/
+        if (!prof_stage[stage].marked) {
+            prof_busy_enter(now);
+        }
+        prof_stage[stage].mark = now;
+        prof_stage[stage].marked = 1;
+    }
+}
+
+void audio_mips_prof_mark_end(u8 stage)
+{
+    if ((stage < AUDIO_PROF_STAGE_NUM) && prof_stage[stage].marked) {
+        u32 now = audio_mips_prof_now();
+        prof_stage[stage].marked = 0;
+        prof_busy_exit(now);
+        audio_mips_prof_record(stage, now - prof_stage[stage].mark);
+    }
+}
+
+/*包含正在进行中的区间，读数随时间连续递增*/
+u32 audio_mips_prof_busy(void)
+{
+    u32 busy;
+
+    prof_irq_disable();
+    busy = prof_busy;
+    if (prof_busy_depth) {
+        busy += audio_mips_prof_now() - prof_busy_start;
+    }
+    prof_irq_enable();
+    return busy;
+}
+
+static u32 prof_cnt_to_us(u64 cnt, u32 hz)
+{
+    return (u32)(cnt * 1000000 / hz);
+}
+
+int audio_mips_prof_get_stat(u8 stage, struct audio_mips_prof_stat *stat)
+{
+    struct audio_mips_prof_stage *s;
+    u32 calls, min, max, window_start, seq;
+    u64 total;
+    u16 hist[PROF_HIST_NUM];
+    int retry;
+
+    if ((stage >= AUDIO_PROF_STAGE_NUM) || (stat == NULL)) {
+        return -EINVAL;
+    }
+    s = &prof_stage[stage];
+    for (retry = 0; retry < PROF_READ_RETRY; retry++) {
+        seq = s->seq;
+        if (seq & 1) {
+            continue;
+        }
+        prof_barrier();
+        calls = s->calls;
+        total = s->total;
+        min = s->min;
+        max = s->max;
+        window_start = s->window_start;
+        memcpy(hist, s->hist, sizeof(hist));
+        prof_barrier();
+        if (seq == s->seq) {
+            break;
+        }
+    }
+    if (retry == PROF_READ_RETRY) {
+        return -EBUSY;
+    }
+
+    u32 hz = prof_cnt_hz();
+    u32 hist_total = 0;
+    u32 p99 = 0;
+    for (int i = 0; i < PROF_HIST_NUM; i++) {
+        hist_total += hist[i];
+    }
+    if (hist_total) {
+        u32 limit = hist_total - hist_total / 100;
+        u32 acc = 0;
+        for (int i = 0; i < PROF_HIST_NUM; i++) {
+            acc += hist[i];
+            if (acc >= limit) {
+                p99 = prof_hist_upper(i);
+                break;
+            }
+        }
+        if (p99 > max) {
+            p99 = max;
+        }
+    }
+
+    stat->calls = calls;
+    stat->total_us = prof_cnt_to_us(total, hz);
+    stat->min_us = calls ? prof_cnt_to_us(min, hz) : 0;
+    stat->max_us = prof_cnt_to_us(max, hz);
+    stat->p99_us = prof_cnt_to_us(p99, hz);
+    stat->window_ms = prof_msec() - window_start;
+    /*cycles = 计数 * cpu_hz / cnt_hz，MIPS = cycles / 窗口秒数 / 1e6*/
+    if (stat->window_ms) {
+        u64 cycles = total * (prof_cpu_hz() / 1000) / (hz / 1000);
+        stat->mips_x100 = (u32)(cycles / ((u64)stat->window_ms * 10));
+    } else {
+        stat->mips_x100 = 0;
+    }
+    return 0;
+}
+
+void audio_mips_prof_reset(u8 stage)
+{
+    for (u8 i = 0; i < AUDIO_PROF_STAGE_NUM; i++) {
+        if ((stage == i) || (stage == AUDIO_PROF_STAGE_NUM)) {
+            if (prof_stage[i].calls == 0) {
+                /*还没有记录过，直接在读端初始化*/
+                prof_stage_clear(&prof_stage[i]);
+            } else {
+                prof_stage[i].reset = 1;
+            }
+        }
+    }
+}
+
+const char *audio_mips_prof_stage_name(u8 stage)
+{
+    if (stage >= AUDIO_PROF_STAGE_NUM) {
+        return NULL;
+    }
+    return prof_stage_name[stage];
+}
+
+void audio_mips_prof_dump(void)
+{
+    struct audio_mips_prof_stat stat;
+
+    printf("[MIPS_PROF] cpu:%dHz\n", (int)prof_cpu_hz());
+    for (u8 i = 0; i < AUDIO_PROF_STAGE_NUM; i++) {
+        if (audio_mips_prof_get_stat(i, &stat) || (stat.calls == 0)) {
+            continue;
+        }
+        printf("[MIPS_PROF] %s calls:%d total:%dus min:%d max:%d p99:%d window:%dms mips:%d.%02d\n",
+               prof_stage_name[i], (int)stat.calls, (int)stat.total_us, (int)stat.min_us,
+               (int)stat.max_us, (int)stat.p99_us, (int)stat.window_ms,
+               (int)(stat.mips_x100 / 100), (int)(stat.mips_x100 % 100));
+    }
+}
+
+#ifndef AUDIO_MIPS_PROF_HOST
+/*
+ *在线查询：命令格式同online_cmd_t
+ *AUD_MIPS_PROF_STAGE_NUM:回复级数
+ *AUD_MIPS_PROF_QUERY:data为级号，回复struct audio_mips_prof_stat
+ *AUD_MIPS_PROF_RESET:data为级号(AUDIO_PROF_STAGE_NUM清零所有级)，回复"OK"
+ */
+static int mips_prof_online_parse(u8 *packet, u8 size, u8 *ext_data, u16 ext_size)
+{
+    online_cmd_t cmd;
+    struct audio_mips_prof_stat stat;
+    int res_data;
+    u8 parse_seq = ext_data[1];
+
+    if (size < sizeof(online_cmd_t)) {
+        return -EINVAL;
+    }
+    memcpy(&cmd, packet, sizeof(online_cmd_t));
+    switch (cmd.cmd) {
+    case AUD_MIPS_PROF_STAGE_NUM:
+        res_data = AUDIO_PROF_STAGE_NUM;
+        return app_online_db_ack(parse_seq, (u8 *)&res_data, 4);
+    case AUD_MIPS_PROF_QUERY:
+        if (audio_mips_prof_get_stat((u8)cmd.data, &stat)) {
+            memset(&stat, 0, sizeof(stat));
+        }
+        return app_online_db_ack(parse_seq, (u8 *)&stat, sizeof(stat));
+    case AUD_MIPS_PROF_RESET:
+        audio_mips_prof_reset((u8)cmd.data);
+        return app_online_db_ack(parse_seq, (u8 *)"OK", 2);
+    default:
+        break;
+    }
+    return 0;
+}
+
+int audio_mips_prof_online_open(void)
+{
+    app_online_db_register_handle(DB_PKT_TYPE_MIPS_PROF, mips_prof_online_parse);
+    return 0;
+}
+
+static int audio_mips_prof_init(void)
+{
+    audio_mips_prof_reset(AUDIO_PROF_STAGE_NUM);
+    return 0;
+}
+__initcall(audio_mips_prof_init);
+#endif
+
+#else
+
+int audio_mips_prof_get_stat(u8 stage, struct audio_mips_prof_stat *stat)
+{
+    return -EPERM;
+}
+
+void audio_mips_prof_reset(u8 stage)
+{
+}
+
+const char *audio_mips_prof_stage_name(u8 stage)
+{
+    return NULL;
+}
+
+void audio_mips_prof_dump(void)
+{
+}
+
+int audio_mips_prof_online_open(void)
+{
+    return 0;
+}
+
+#endif/*AUDIO_MIPS_PROF_ENABLE*/
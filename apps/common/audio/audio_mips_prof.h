@@ -0,0 +1,88 @@
+#ifndef _AUDIO_MIPS_PROF_H_
+#define _AUDIO_MIPS_PROF_H_
+
+#include "generic/typedef.h"
+
+/*
+ *音频各级处理耗时统计
+ *在处理前后放置探针，按级累计调用次数、总耗时、最小/最大/p99单次耗时，
+ *用于确定哪一级处理决定了系统时钟需求
+ *1.关闭时探针展开为空，不占代码和运行时间
+ *2.每级统计只在记录时短暂关中断，读取快照不加锁(序号校验，读到更新中的数据时重读)
+ *3.定义AUDIO_MIPS_PROF_HOST时用clock_gettime计时，可在PC上编译同一套探针，
+ *  PC上使用前先调用audio_mips_prof_reset(AUDIO_PROF_STAGE_NUM)开始统计窗口
+ */
+#ifndef AUDIO_MIPS_PROF_ENABLE
+#define AUDIO_MIPS_PROF_ENABLE		0
+#endif
+
+/*处理级*/
+enum {
+    AUDIO_PROF_DECODE = 0,	/*解码(探测完成到输出)*/
+    AUDIO_PROF_DVOL,		/*数字音量*/
+    AUDIO_PROF_EQ_DRC,		/*同步eq/drc*/
+    AUDIO_PROF_AEC,			/*通话回音消除/降噪*/
+    AUDIO_PROF_MIXER,		/*混音(探测完成到输出)*/
+    AUDIO_PROF_SRC,			/*变采样写入(硬件src包含其输出回调的耗时)*/
+    AUDIO_PROF_DAC_WRITE,	/*dac/iis写入*/
+    AUDIO_PROF_DHA,			/*辅听算法(dha_chain_run)*/
+    AUDIO_PROF_STAGE_NUM,
+};
+
+/*单级统计快照，时间单位us*/
+struct audio_mips_prof_stat {
+    u32 calls;			/*调用次数*/
+    u32 total_us;		/*累计耗时*/
+    u32 min_us;			/*最小单次耗时*/
+    u32 max_us;			/*最大单次耗时*/
+    u32 p99_us;			/*99%单次耗时不超过该值(按1/4倍频程直方图估计)*/
+    u32 window_ms;		/*统计窗口(上次清零到现在)*/
+    u32 mips_x100;		/*窗口内平均占用的MIPS x100*/
+};
+
+#if AUDIO_MIPS_PROF_ENABLE
+
+/*单次处理前后计时，begin/end需在同一函数内成对使用*/
+#define AUDIO_PROF_BEGIN(stage)		u32 __prof_start_##stage = audio_mips_prof_begin()
+#define AUDIO_PROF_END(stage)		audio_mips_prof_end(stage, __prof_start_##stage)
+/*处理跨回调时(如库内解码: probe回调之后到output回调之前)，先标记起点，结束时记录*/
+#define AUDIO_PROF_MARK(stage)		audio_mips_prof_mark(stage)
+#define AUDIO_PROF_MARK_END(stage)	audio_mips_prof_mark_end(stage)
+
+/*当前计数值，单位由平台决定(tick timer计数或ns)*/
+u32 audio_mips_prof_now(void);
+u32 audio_mips_prof_begin(void);
+void audio_mips_prof_end(u8 stage, u32 start);
+void audio_mips_prof_record(u8 stage, u32 cnt);
+void audio_mips_prof_mark(u8 stage);
+void audio_mips_prof_mark_end(u8 stage);
+/*
+ *音频忙时间累计(单位同audio_mips_prof_now，回绕计数，取差值使用)，用于估计音频负载
+ *任一级在处理中即计为忙，嵌套(如src包含其输出回调里的dac写入)或不同任务重叠的区间只计一次，
+ *不是各级耗时之和；MARK区间内其他任务抢占的时间无法区分，仍计为忙
+ */
+u32 audio_mips_prof_busy(void);
+
+#else
+
+#define AUDIO_PROF_BEGIN(stage)
+#define AUDIO_PROF_END(stage)		do {} while (0)
+#define AUDIO_PROF_MARK(stage)		do {} while (0)
+#define AUDIO_PROF_MARK_END(stage)	do {} while (0)
+
+#endif/*AUDIO_MIPS_PROF_ENABLE*/
+
+/*
+ *读取单级统计
+ *return:0成功，stage无效返回-EINVAL，连续读到更新中的数据返回-EBUSY，未使能返回-EPERM
+ */
+int audio_mips_prof_get_stat(u8 stage, struct audio_mips_prof_stat *stat);
+/*清零统计并重新开始窗口，stage为AUDIO_PROF_STAGE_NUM时清零所有级*/
+void audio_mips_prof_reset(u8 stage);
+const char *audio_mips_prof_stage_name(u8 stage);
+/*串口打印所有级的统计*/
+void audio_mips_prof_dump(void);
+/*注册在线调试查询(DB_PKT_TYPE_MIPS_PROF)*/
+int audio_mips_prof_online_open(void);
+
+#endif/*_AUDIO_MIPS_PROF_H_*/
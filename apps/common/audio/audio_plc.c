@@ -5,11 +5,25 @@
  *
  ************************************************************
  */
+#ifdef AUDIO_PLC_HOST
+/*PC上回放(tools/host_test)：单线程，没有库PLC，全部使用内置修复*/
+#include "audio_plc.h"
+#define TCFG_ESCO_PLC	1
+typedef int OS_MUTEX;
+#define os_mutex_create(mutex)			((void)(mutex))
+#define os_mutex_pend(mutex, timeout)	((void)(mutex))
+#define os_mutex_post(mutex)			((void)(mutex))
+#define PLC_query()						0
+#define PLC_init(buf)					-1
+#define PLC_run(in, out, point, repair)
+#else
 #include "system/includes.h"
 #include "PLC.h"
 #include "os/os_api.h"
 #include "app_config.h"
 #include "audio_config.h"
+#include "audio_plc.h"
+#endif
 
 #if TCFG_ESCO_PLC
 
@@ -28,101 +42,541 @@ enum {
 
 
 #define PLC_FRAME_LEN	120
+
+/*
+ *修复级别按连续丢包时长切换(不同码流帧长从2.9ms到21ms不等，按时间而不按帧数)
+ *0~PLC_REPEAT_MS				：按基音周期重复，不衰减
+ *PLC_REPEAT_MS~PLC_FADE_MS		：基音外推，线性衰减并逐渐混入舒适噪声
+ *PLC_FADE_MS以后				：继续淡出，PLC_MUTE_MS时只剩舒适噪声
+ */
+#define PLC_REPEAT_MS		10
+#define PLC_FADE_MS			30
+#define PLC_MUTE_MS			60
+#define PLC_OLA_MS			4		/*恢复正常帧时的交叉淡化长度*/
+
+#define PLC_HIST_MS			24		/*历史数据长度，需大于基音搜索窗+最大基音周期*/
+#define PLC_PITCH_WIN_MS	5		/*基音搜索相关窗*/
+#define PLC_PITCH_MIN_HZ	70
+#define PLC_PITCH_MAX_HZ	400
+
+#define PLC_NOISE_MAX		256		/*舒适噪声幅度上限(平均绝对值)*/
+
 typedef struct {
     u8 state;
     u8 repair;
-    u8 wideband;
-    OS_MUTEX mutex;
-    s16 *run_buf;
+    u8 flags;
+    u8 ch_num;
+    u16 sr;
+    u16 hist_len;			/*每声道历史点数*/
+    u16 pitch;				/*当前丢包段使用的基音周期*/
+    u16 gain;				/*修复数据增益，Q15*/
+    u16 gain_step;			/*每点衰减量，Q15*/
+    u16 noise_floor;		/*正常帧跟踪到的底噪幅度*/
+    u16 repeat_points;
+    u16 fade_points;
+    u16 ola_points;
+    u32 conceal_points;		/*当前丢包段已修复点数*/
+    u32 seed;
+    s16 *run_buf;			/*库PLC工作空间，仅占用库的实例有效*/
+    s16 *hist;				/*按声道分块存放的历史数据*/
+    struct audio_plc_stat stat;
 } audio_plc_t;
-static audio_plc_t plc;
 
-int audio_plc_open(u16 sr)
+/*库PLC内部只有一份状态，同一时间只能给一个实例使用*/
+static audio_plc_t *plc_lib_owner = NULL;
+
+/*通话下行默认实例*/
+static audio_plc_t *esco_plc = NULL;
+static OS_MUTEX esco_plc_mutex;
+static u8 esco_plc_mutex_init = 0;
+
+static void audio_plc_lib_release(audio_plc_t *plc)
 {
-    PLC_LOG("audio_plc_open:%d\n", sr);
-    memset((u8 *)&plc, 0, sizeof(audio_plc_t));
-    plc.run_buf	= malloc(PLC_query()); /*buf_size:1040*/
-    PLC_LOG("PLC_buf:%x,size:%d\n", plc.run_buf, PLC_query());
-    if (plc.run_buf) {
-        s8 err = PLC_init(plc.run_buf);
-        if (err) {
-            PLC_LOG("PLC_init err:%d", err);
-            free(plc.run_buf);
-            return -EINVAL;
+    if (plc->run_buf) {
+        free(plc->run_buf);
+        plc->run_buf = NULL;
+    }
+    if (plc_lib_owner == plc) {
+        plc_lib_owner = NULL;
+    }
+}
+
+static int audio_plc_lib_setup(audio_plc_t *plc)
+{
+    if (plc_lib_owner || (plc->ch_num != 1)) {
+        return -EBUSY;
+    }
+    plc->run_buf = malloc(PLC_query()); /*buf_size:1040*/
+    PLC_LOG("PLC_buf:%x,size:%d\n", plc->run_buf, PLC_query());
+    if (!plc->run_buf) {
+        return -ENOMEM;
+    }
+    s8 err = PLC_init(plc->run_buf);
+    if (err) {
+        PLC_LOG("PLC_init err:%d", err);
+        free(plc->run_buf);
+        plc->run_buf = NULL;
+        return -EINVAL;
+    }
+    plc_lib_owner = plc;
+    return 0;
+}
+
+/*
+*********************************************************************
+*                  Audio PLC Create
+* Description: 创建一路丢包修复实例
+* Arguments  : sr		采样率
+*			   ch_num	声道数(交织数据)
+*			   flags	AUDIO_PLC_FLAG_xxx
+* Return	 : 实例句柄，NULL表示失败
+* Note(s)    : 带AUDIO_PLC_FLAG_LIB的单声道实例在库PLC空闲时使用库PLC处理
+*			   短时丢包，否则全部使用内置的基音外推；各实例之间没有共享状态，
+*			   可以同时运行多路
+*********************************************************************
+*/
+void *audio_plc_create(u16 sr, u8 ch_num, u8 flags)
+{
+    audio_plc_t *plc;
+    u16 hist_len = sr * PLC_HIST_MS / 1000;
+
+    if (!sr || !ch_num) {
+        return NULL;
+    }
+
+    plc = zalloc(sizeof(audio_plc_t) + hist_len * ch_num * sizeof(s16));
+    if (!plc) {
+        return NULL;
+    }
+    plc->sr = sr;
+    plc->ch_num = ch_num;
+    plc->flags = flags;
+    plc->hist_len = hist_len;
+    plc->hist = (s16 *)(plc + 1);
+    plc->repeat_points = sr * PLC_REPEAT_MS / 1000;
+    plc->fade_points = sr * PLC_FADE_MS / 1000;
+    plc->ola_points = sr * PLC_OLA_MS / 1000;
+    plc->gain_step = 32767 / (sr * (PLC_MUTE_MS - PLC_REPEAT_MS) / 1000);
+    if (plc->gain_step == 0) {
+        plc->gain_step = 1;
+    }
+    plc->gain = 32767;
+    plc->seed = (u32)(unsigned long)plc;
+
+    if (flags & AUDIO_PLC_FLAG_LIB) {
+        if (audio_plc_lib_setup(plc)) {
+            PLC_LOG("PLC lib busy, use builtin\n");
         }
-        os_mutex_create(&plc.mutex);
-        if (sr == 16000) {
-            plc.wideband = 1;
+    }
+    plc->state = PLC_STA_OPEN;
+    PLC_LOG("audio_plc_create:%x,sr:%d,ch:%d,lib:%d\n", plc, sr, ch_num, plc->run_buf ? 1 : 0);
+    return plc;
+}
+
+/*
+ *基音周期估计：在历史数据末尾取相关窗，搜索归一化互相关最大的延迟
+ *先按8k分辨率粗搜，再在最佳点附近细搜；清音或能量不足时返回最大周期
+ */
+static u16 audio_plc_pitch_estimate(audio_plc_t *plc)
+{
+    s16 *x = plc->hist;
+    int tmin = plc->sr / PLC_PITCH_MAX_HZ;
+    int tmax = plc->sr / PLC_PITCH_MIN_HZ;
+    int win = plc->sr * PLC_PITCH_WIN_MS / 1000;
+    int step = (plc->sr >= 16000) ? (plc->sr / 8000) : 1;
+    s16 *ref = x + plc->hist_len - win;
+    s64 best_score = 0;
+    s32 ref_e = 0;
+    int best_t = tmax;
+    int t, i, lo, hi, inc;
+
+    for (i = 0; i < win; i += step) {
+        ref_e += (ref[i] * ref[i]) >> 8;
+    }
+
+    lo = tmin;
+    hi = tmax;
+    inc = step;
+    while (1) {
+        for (t = lo; t <= hi; t += inc) {
+            s32 c = 0;
+            s32 e = 1;
+            s16 *y = ref - t;
+            for (i = 0; i < win; i += inc) {
+                c += (ref[i] * y[i]) >> 8;
+                e += (y[i] * y[i]) >> 8;
+            }
+            if (c > 0) {
+                s64 score = (s64)c * c / e;
+                if (score > best_score) {
+                    best_score = score;
+                    best_t = t;
+                }
+            }
+        }
+        if (inc == 1) {
+            break;
         }
-        plc.state = PLC_STA_OPEN;
+        /*细搜时ref_e也要换成全分辨率*/
+        lo = (best_t - inc + 1 > tmin) ? (best_t - inc + 1) : tmin;
+        hi = (best_t + inc - 1 < tmax) ? (best_t + inc - 1) : tmax;
+        ref_e *= inc;
+        inc = 1;
+        best_score = 0;
     }
-    PLC_LOG("audio_plc_open succ\n");
-    return 0;
+
+    /*相关系数小于0.5按清音处理*/
+    if (best_score * 4 < ref_e) {
+        return tmax;
+    }
+    return best_t;
 }
 
-void audio_plc_run(s16 *data, u16 len, u8 repair)
+static inline s16 audio_plc_noise(audio_plc_t *plc)
+{
+    plc->seed = plc->seed * 1103515245 + 12345;
+    s32 rnd = (s16)(plc->seed >> 16);
+    return (s16)((rnd * plc->noise_floor) >> 14);
+}
+
+static inline void audio_plc_gain_update(audio_plc_t *plc)
+{
+    if (plc->conceal_points >= plc->repeat_points) {
+        plc->gain = (plc->gain > plc->gain_step) ? (plc->gain - plc->gain_step) : 0;
+    }
+    plc->conceal_points++;
+}
+
+static void audio_plc_hist_update(audio_plc_t *plc, s16 *data, u16 points)
+{
+    u16 H = plc->hist_len;
+    u16 keep = (points < H) ? (H - points) : 0;
+    u16 skip = points - (H - keep);
+    u8 ch;
+    u16 i;
+
+    for (ch = 0; ch < plc->ch_num; ch++) {
+        s16 *h = plc->hist + ch * H;
+        if (keep) {
+            memmove(h, h + H - keep, keep * sizeof(s16));
+        }
+        s16 *p = data + skip * plc->ch_num + ch;
+        for (i = keep; i < H; i++) {
+            h[i] = *p;
+            p += plc->ch_num;
+        }
+    }
+}
+
+/*
+ *内置修复：按基音周期从历史数据末尾循环取数，乘以衰减增益后叠加舒适噪声
+ *未衰减的外推数据同时写入历史，保证连续丢帧和下次丢包时历史数据是连续的
+ *ola不为0时与data中的正常数据交叉淡化(丢包后恢复的第一帧)
+ */
+static void audio_plc_conceal(audio_plc_t *plc, s16 *data, u16 points, u16 ola)
 {
-    u16 repair_point, tmp_point;
-    s16 *p_in, *p_out;
-    p_in    = data;
-    p_out   = data;
-    tmp_point = len / 2;
-    u8 repair_flag = 0;
+    u16 H = plc->hist_len;
+    u16 T = plc->pitch;
+    u16 phase = 0;
+    s16 *p = data;
+    u8 ch;
+    u16 i;
 
-    os_mutex_pend(&plc.mutex, 0);
-    if (plc.state == PLC_STA_CLOSE) {
-        os_mutex_post(&plc.mutex);
+    if (ola) {
+        for (i = 0; i < ola; i++) {
+            s32 w = i * 32768 / ola;
+            for (ch = 0; ch < plc->ch_num; ch++) {
+                s32 s = plc->hist[ch * H + H - T + phase];
+                s = (s * plc->gain + audio_plc_noise(plc) * (32767 - plc->gain)) >> 15;
+                p[ch] = (p[ch] * w + s * (32768 - w)) >> 15;
+            }
+            p += plc->ch_num;
+            if (++phase >= T) {
+                phase = 0;
+            }
+        }
         return;
     }
 
-#if 0	//debug
-    static u16 repair_cnt = 0;
-    if (repair) {
-        repair_cnt++;
-        y_printf("[E%d]", repair_cnt);
+    for (i = 0; i < points; i++) {
+        for (ch = 0; ch < plc->ch_num; ch++) {
+            p[ch] = plc->hist[ch * H + H - T + phase];
+        }
+        p += plc->ch_num;
+        if (++phase >= T) {
+            phase = 0;
+        }
+    }
+    audio_plc_hist_update(plc, data, points);
+
+    p = data;
+    for (i = 0; i < points; i++) {
+        for (ch = 0; ch < plc->ch_num; ch++) {
+            p[ch] = (p[ch] * plc->gain + audio_plc_noise(plc) * (32767 - plc->gain)) >> 15;
+        }
+        p += plc->ch_num;
+        audio_plc_gain_update(plc);
+    }
+}
+
+/*
+ *库PLC输出之后的长时淡出(AUDIO_PLC_FLAG_LIB_FADE)：库PLC处理短时丢包，
+ *超过PLC_REPEAT_MS后在其输出上叠加同样的衰减和舒适噪声；恢复时增益渐变回满幅
+ */
+static void audio_plc_lib_fade(audio_plc_t *plc, s16 *data, u16 points, u8 recover)
+{
+    u16 i;
+    for (i = 0; i < points; i++) {
+        if (recover) {
+            if (plc->gain >= 32767) {
+                break;
+            }
+            plc->gain = (32767 - plc->gain > plc->gain_step * 4) ? (plc->gain + plc->gain_step * 4) : 32767;
+            data[i] = (data[i] * plc->gain) >> 15;
+        } else {
+            data[i] = (data[i] * plc->gain + audio_plc_noise(plc) * (32767 - plc->gain)) >> 15;
+            audio_plc_gain_update(plc);
+        }
+    }
+}
+
+/*跟踪正常帧的底噪：下降立即跟随，上升缓慢*/
+static void audio_plc_noise_track(audio_plc_t *plc, s16 *data, u16 points)
+{
+    u32 sum = 0;
+    u16 i;
+    for (i = 0; i < points; i++) {
+        s16 s = data[i * plc->ch_num];
+        sum += (s < 0) ? -s : s;
+    }
+    u32 lvl = sum / points;
+    if (lvl < plc->noise_floor) {
+        plc->noise_floor = lvl;
+    } else {
+        plc->noise_floor += (lvl - plc->noise_floor) >> 5;
+    }
+    if (plc->noise_floor > PLC_NOISE_MAX) {
+        plc->noise_floor = PLC_NOISE_MAX;
+    }
+}
+
+static void audio_plc_burst_end(audio_plc_t *plc)
+{
+    struct audio_plc_stat *stat = &plc->stat;
+    u16 burst = stat->cur_burst;
+    u8 idx;
+
+    if (burst == 1) {
+        idx = 0;
+    } else if (burst == 2) {
+        idx = 1;
+    } else if (burst <= 4) {
+        idx = 2;
+    } else if (burst <= 8) {
+        idx = 3;
     } else {
-        repair_cnt = 0;
+        idx = 4;
+    }
+    stat->burst_hist[idx]++;
+    if (burst > stat->max_burst) {
+        stat->max_burst = burst;
+    }
+    stat->conceal_ms += plc->conceal_points * 1000 / plc->sr;
+    stat->cur_burst = 0;
+    plc->conceal_points = 0;
+}
+
+/*
+*********************************************************************
+*                  Audio PLC Process
+* Description: 一帧数据丢包修复
+* Arguments  : plc		audio_plc_create返回的句柄
+*			   data		交织的16bit pcm，原址输出
+*			   len		数据长度(byte)
+*			   repair	当前帧是否为错误帧
+* Return	 : 0成功，其他失败
+* Note(s)    : 实例内部不加锁，同一实例的process/release由调用者保证不并发
+*********************************************************************
+*/
+int audio_plc_process(void *_plc, s16 *data, u16 len, u8 repair)
+{
+    audio_plc_t *plc = (audio_plc_t *)_plc;
+    struct audio_plc_stat *stat;
+    u16 points;
+    u8 repair_flag;
+    u8 tier;
+
+    if (!plc || plc->state == PLC_STA_CLOSE) {
+        return -EINVAL;
+    }
+    points = len / 2 / plc->ch_num;
+    if (!points) {
+        return 0;
     }
-    //printf("[%d]",point);
-#endif/*debug*/
+    stat = &plc->stat;
+    plc->state = PLC_STA_RUN;
 
     repair_flag = repair;
-    if (plc.wideband) {
+    if (plc->flags & AUDIO_PLC_FLAG_MSBC) {
         /*
          *msbc plc deal
          *如果上一帧是错误，则当前帧也要修复
          */
-        if (plc.repair) {
+        if (plc->repair) {
             repair_flag = 1;
         }
-        plc.repair = repair;
+        plc->repair = repair;
+    }
+
+    stat->frames++;
+    if (repair_flag) {
+        if (plc->conceal_points < plc->repeat_points) {
+            tier = AUDIO_PLC_TIER_REPEAT;
+        } else if (plc->conceal_points < plc->fade_points) {
+            tier = AUDIO_PLC_TIER_EXTRAP;
+        } else {
+            tier = AUDIO_PLC_TIER_FADE;
+        }
+        stat->lost_frames++;
+        stat->tier_frames[tier]++;
+        if (stat->cur_burst++ == 0) {
+            stat->bursts++;
+            if (!plc->run_buf) {
+                plc->gain = 32767;
+                plc->pitch = audio_plc_pitch_estimate(plc);
+            }
+        }
+    }
+
+    if (plc->run_buf) {
+        u16 repair_point, tmp_point = points;
+        s16 *p = data;
+        while (tmp_point) {
+            repair_point = (tmp_point > PLC_FRAME_LEN) ? PLC_FRAME_LEN : tmp_point;
+            tmp_point = tmp_point - repair_point;
+            PLC_run(p, p, repair_point, repair_flag);
+            p += repair_point;
+        }
+        if (repair_flag) {
+            if (plc->flags & AUDIO_PLC_FLAG_LIB_FADE) {
+                audio_plc_lib_fade(plc, data, points, 0);
+            }
+        } else {
+            if (stat->cur_burst) {
+                audio_plc_burst_end(plc);
+            }
+            if (plc->flags & AUDIO_PLC_FLAG_LIB_FADE) {
+                audio_plc_lib_fade(plc, data, points, 1);
+                audio_plc_noise_track(plc, data, points);
+            }
+        }
+        return 0;
+    }
+
+    if (repair_flag) {
+        audio_plc_conceal(plc, data, points, 0);
+        return 0;
+    }
+
+    if (stat->cur_burst) {
+        u16 ola = (points < plc->ola_points) ? points : plc->ola_points;
+        audio_plc_conceal(plc, data, ola, ola);
+        audio_plc_burst_end(plc);
+    }
+    audio_plc_noise_track(plc, data, points);
+    audio_plc_hist_update(plc, data, points);
+    return 0;
+}
+
+int audio_plc_get_stat(void *_plc, struct audio_plc_stat *stat)
+{
+    audio_plc_t *plc = _plc ? (audio_plc_t *)_plc : esco_plc;
+    if (!plc || !stat) {
+        return -EINVAL;
+    }
+    memcpy(stat, &plc->stat, sizeof(*stat));
+    return 0;
+}
+
+void audio_plc_release(void *_plc)
+{
+    audio_plc_t *plc = (audio_plc_t *)_plc;
+    if (!plc) {
+        return;
+    }
+    PLC_LOG("audio_plc_release:%x,frames:%d,lost:%d,bursts:%d,max_burst:%d,tier:%d/%d/%d\n",
+            plc, plc->stat.frames, plc->stat.lost_frames, plc->stat.bursts, plc->stat.max_burst,
+            plc->stat.tier_frames[0], plc->stat.tier_frames[1], plc->stat.tier_frames[2]);
+    plc->state = PLC_STA_CLOSE;
+    audio_plc_lib_release(plc);
+    free(plc);
+}
+
+int audio_plc_open(u16 sr)
+{
+    PLC_LOG("audio_plc_open:%d\n", sr);
+    if (!esco_plc_mutex_init) {
+        os_mutex_create(&esco_plc_mutex);
+        esco_plc_mutex_init = 1;
     }
+    os_mutex_pend(&esco_plc_mutex, 0);
+    /*先释放旧实例，让出库PLC给新实例*/
+    if (esco_plc) {
+        audio_plc_release(esco_plc);
+    }
+    esco_plc = audio_plc_create(sr, 1, AUDIO_PLC_FLAG_LIB | ((sr == 16000) ? AUDIO_PLC_FLAG_MSBC : 0));
+    os_mutex_post(&esco_plc_mutex);
+    if (!esco_plc) {
+        return -ENOMEM;
+    }
+    PLC_LOG("audio_plc_open succ\n");
+    return 0;
+}
 
-    while (tmp_point) {
-        repair_point = (tmp_point > PLC_FRAME_LEN) ? PLC_FRAME_LEN : tmp_point;
-        tmp_point = tmp_point - repair_point;
-        PLC_run(p_in, p_out, repair_point, repair_flag);
-        p_in  += repair_point;
-        p_out += repair_point;
+void audio_plc_run(s16 *data, u16 len, u8 repair)
+{
+    if (!esco_plc_mutex_init) {
+        return;
     }
-    os_mutex_post(&plc.mutex);
+    os_mutex_pend(&esco_plc_mutex, 0);
+    audio_plc_process(esco_plc, data, len, repair);
+    os_mutex_post(&esco_plc_mutex);
 }
 
 int audio_plc_close(void)
 {
     PLC_LOG("audio_plc_close\n");
-    os_mutex_pend(&plc.mutex, 0);
-    plc.state = PLC_STA_CLOSE;
-    if (plc.run_buf) {
-        free(plc.run_buf);
-        plc.run_buf = NULL;
+    if (!esco_plc_mutex_init) {
+        return 0;
     }
-    os_mutex_post(&plc.mutex);
+    os_mutex_pend(&esco_plc_mutex, 0);
+    audio_plc_release(esco_plc);
+    esco_plc = NULL;
+    os_mutex_post(&esco_plc_mutex);
     PLC_LOG("audio_plc_close succ\n");
     return 0;
 }
 #else
-int audio_plc_open(void)
+void *audio_plc_create(u16 sr, u8 ch_num, u8 flags)
+{
+    return NULL;
+}
+
+int audio_plc_process(void *plc, s16 *data, u16 len, u8 repair)
+{
+    return 0;
+}
+
+int audio_plc_get_stat(void *plc, struct audio_plc_stat *stat)
+{
+    return -EINVAL;
+}
+
+void audio_plc_release(void *plc)
+{
+}
+
+int audio_plc_open(u16 sr)
 {
     return 0;
 }
@@ -3,6 +3,47 @@
 
 #include "generic/typedef.h"
 
+#define AUDIO_PLC_FLAG_MSBC			BIT(0)	/*msbc:错误帧的下一帧也需要修复*/
+#define AUDIO_PLC_FLAG_LIB			BIT(1)	/*短时丢包优先使用库PLC(同一时间只能有一个实例占用)*/
+#define AUDIO_PLC_FLAG_LIB_FADE		BIT(2)	/*库PLC输出超过10ms后叠加淡出到舒适噪声，不设置时与原库PLC输出一致*/
+
+/*
+ *修复级别，按连续丢帧长度选择
+ *REPEAT:单帧丢失，按基音周期重复上一段波形
+ *EXTRAP:短时连续丢帧，基音外推并逐渐衰减
+ *FADE:长时丢帧，淡出到舒适噪声
+ */
+enum {
+    AUDIO_PLC_TIER_REPEAT = 0,
+    AUDIO_PLC_TIER_EXTRAP,
+    AUDIO_PLC_TIER_FADE,
+    AUDIO_PLC_TIER_NUM,
+};
+
+#define AUDIO_PLC_BURST_HIST_NUM	5	/*连续丢帧长度分布：1,2,3~4,5~8,>8*/
+
+/*单路数据流修复统计，调参用*/
+struct audio_plc_stat {
+    u32 frames;									/*处理帧数*/
+    u32 lost_frames;							/*修复帧数*/
+    u32 bursts;									/*连续丢帧段数*/
+    u32 tier_frames[AUDIO_PLC_TIER_NUM];		/*各级修复帧数*/
+    u32 burst_hist[AUDIO_PLC_BURST_HIST_NUM];	/*连续丢帧长度分布*/
+    u32 conceal_ms;								/*累计修复时长(ms)*/
+    u16 max_burst;								/*最长连续丢帧数*/
+    u16 cur_burst;								/*当前连续丢帧数*/
+};
+
+/*
+ *多实例接口：每路数据流(eSCO/TWS转发等)独立创建
+ *data为交织的16bit pcm，len单位byte
+ */
+void *audio_plc_create(u16 sr, u8 ch_num, u8 flags);
+int audio_plc_process(void *plc, s16 *data, u16 len, u8 repair);
+int audio_plc_get_stat(void *plc, struct audio_plc_stat *stat);
+void audio_plc_release(void *plc);
+
+/*通话下行默认实例，audio_plc_get_stat(NULL, stat)获取其统计*/
 int audio_plc_open(u16 sr);
 void audio_plc_run(s16 *dat, u16 len, u8 repair_flag);
 int audio_plc_close(void);
@@ -579,6 +579,11 @@ static int ktone_play_open_with_callback_base(const char *file_name, struct audi
         info.sin_num = sin_num;
     } else {
         info.file_name = file_name;
+        if (IS_SYNTH_TONE(file_name)) {
+            /*按键音使用库的正弦波解码，不支持多声部合成提示音，需用tone_play播放*/
+            log_e("key tone not support synth tone:0x%x\n", (u32)file_name);
+            return -1;
+        }
         if (IS_DEFAULT_SINE(file_name)) {
             info.sin = get_sine_param_data(DEFAULT_SINE_ID(file_name), &info.sin_num);
         }
@@ -1,6 +1,7 @@
 #include "audio_online_debug.h"
 #include "generic/list.h"
 #include "aud_mic_dut.h"
+#include "audio_mips_prof.h"
 #include "board_config.h"
 #include "system/includes.h"
 
@@ -28,6 +29,10 @@ int audio_online_debug_open(void)
 #if TCFG_AUDIO_MIC_DUT_ENABLE
     aud_mic_dut_open();
 #endif/*TCFG_AUDIO_MIC_DUT_ENABLE*/
+
+#if AUDIO_MIPS_PROF_ENABLE
+    audio_mips_prof_online_open();
+#endif/*AUDIO_MIPS_PROF_ENABLE*/
     return 0;
 }
 __initcall(audio_online_debug_open);
@@ -20,6 +20,10 @@ enum {
     MIC_DUT_DAC_GAIN_SET,
     MIC_DUT_SCAN_START,
     MIC_DUT_SCAN_STOP,
+
+    AUD_MIPS_PROF_STAGE_NUM = 0x400,
+    AUD_MIPS_PROF_QUERY,
+    AUD_MIPS_PROF_RESET,
 };
 
 #define RECORD_CH0_LENGTH		644
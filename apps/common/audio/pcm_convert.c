@@ -0,0 +1,403 @@
+/*
+ ****************************************************************
+ *File : pcm_convert.c
+ *Note : pcm格式/通道转换公共库
+ *		 c实现为参考实现，PCM_CONVERT_OPT_ENABLE时常用kernel走
+ *		 32bit打包读写/汇编循环，输出与参考实现逐点一致
+ *		 (tools/host_test/pcm_convert_test.c逐点对比)
+ ****************************************************************
+ */
+#ifdef PCM_CONVERT_HOST
+/*PC上没有pi32汇编和库函数user_sat16，汇编路径换成可自动向量化的c循环*/
+#include "pcm_convert.h"
+#define PCM_CONVERT_ASM_ENABLE		0
+#else
+#include "system/includes.h"
+#include "pcm_convert.h"
+#define PCM_CONVERT_ASM_ENABLE		PCM_CONVERT_OPT_ENABLE
+
+extern void user_sat16(s32 *in, s16 *out, u32 npoint);
+#endif
+
+static inline s32 pcm_sat(s64 v, s32 min, s32 max)
+{
+    if (v > max) {
+        return max;
+    }
+    if (v < min) {
+        return min;
+    }
+    return (s32)v;
+}
+
+/*读取一个采样点，统一到32bit满幅的刻度(16bit幅度左移16)*/
+static inline s64 pcm_load(const void *buf, u8 fmt, int idx)
+{
+    switch (fmt) {
+    case PCM_FMT_S16:
+        return (s64)((const s16 *)buf)[idx] << 16;
+    case PCM_FMT_S16_IN_32:
+        return (s64)((const s32 *)buf)[idx] << 16;
+    case PCM_FMT_S24:
+        return (s64)((const s32 *)buf)[idx] << 8;
+    default:
+        return ((const s32 *)buf)[idx];
+    }
+}
+
+static inline void pcm_store(void *buf, u8 fmt, int idx, s64 v)
+{
+    switch (fmt) {
+    case PCM_FMT_S16:
+        ((s16 *)buf)[idx] = pcm_sat(v >> 16, -32768, 32767);
+        break;
+    case PCM_FMT_S16_IN_32:
+        ((s32 *)buf)[idx] = pcm_sat(v >> 16, (s32)0x80000000, 0x7fffffff);
+        break;
+    case PCM_FMT_S24:
+        ((s32 *)buf)[idx] = pcm_sat(v >> 8, -0x800000, 0x7fffff);
+        break;
+    default:
+        ((s32 *)buf)[idx] = pcm_sat(v, (s32)0x80000000, 0x7fffffff);
+        break;
+    }
+}
+
+/*参考实现：逐点位宽转换，dst与src相同或dst位宽不大于src时可原地转换*/
+static void pcm_convert_points(void *dst, u8 dst_fmt, const void *src, u8 src_fmt, int points)
+{
+    for (int i = 0; i < points; i++) {
+        pcm_store(dst, dst_fmt, i, pcm_load(src, src_fmt, i));
+    }
+}
+
+#if PCM_CONVERT_OPT_ENABLE && !PCM_CONVERT_ASM_ENABLE
+/*
+ *不重叠时从前往后的简单循环，PC上打开-ftree-vectorize(gcc -O3默认打开)后可以自动向量化
+ *饱和写成比较选择而不是分支，便于生成pack/min/max指令
+ */
+static void pcm_s16_to_s32_fwd(s32 *__restrict dst, const s16 *__restrict src, int points, u8 shift)
+{
+    for (int i = 0; i < points; i++) {
+        dst[i] = (s32)src[i] << shift;
+    }
+}
+
+static void pcm_s32_to_s16_fwd(s16 *__restrict dst, const s32 *__restrict src, int points, u8 shift)
+{
+    for (int i = 0; i < points; i++) {
+        s32 v = src[i] >> shift;
+        v = v > 32767 ? 32767 : v;
+        v = v < -32768 ? -32768 : v;
+        dst[i] = v;
+    }
+}
+#endif
+
+void pcm_s16_to_s32(s32 *dst, const s16 *src, int points, u8 shift)
+{
+    if (points <= 0) {
+        return;
+    }
+#if PCM_CONVERT_OPT_ENABLE
+    if ((void *)dst != (void *)src) {
+#if PCM_CONVERT_ASM_ENABLE
+        s64 tmp;
+        s32 factor = 1 << shift;
+        __asm__ volatile(
+            "1:											\n\t"
+            "rep %2 {									\n\t"
+            "%3 = h[%1 ++= 2]*%4(s)                     \n\t"
+            "[%0 ++= 4] = %3.l                          \n\t"   //%3.l取tmp的低32位
+            "}										    \n\t"
+            "if(%2 != 0) goto 1b			            \n\t"
+            :
+            "=&r"(dst),
+            "=&r"(src),
+            "=&r"(points),
+            "=&r"(tmp)
+            :
+            "r"(factor),
+            "0"(dst),
+            "1"(src),
+            "2"(points),
+            "3"(tmp)
+            :
+        );
+#else
+        pcm_s16_to_s32_fwd(dst, src, points, shift);
+#endif
+        return;
+    }
+#endif
+    //从尾部往前处理，原地扩展时不覆盖未读数据
+    while (points--) {
+        dst[points] = (s32)src[points] << shift;
+    }
+}
+
+void pcm_s32_to_s16(s16 *dst, const s32 *src, int points, u8 shift)
+{
+    if (points <= 0) {
+        return;
+    }
+#if PCM_CONVERT_ASM_ENABLE
+    if (shift == 0 && (void *)dst != (void *)src) {
+        user_sat16((s32 *)src, dst, points);
+        return;
+    }
+#elif PCM_CONVERT_OPT_ENABLE
+    if ((void *)dst != (void *)src) {
+        pcm_s32_to_s16_fwd(dst, src, points, shift);
+        return;
+    }
+#endif
+    for (int i = 0; i < points; i++) {
+        dst[i] = pcm_sat(src[i] >> shift, -32768, 32767);
+    }
+}
+
+void pcm_s16_mono_to_dual(s16 *dst, const s16 *src, int frames)
+{
+    int i = frames;
+
+#if PCM_CONVERT_OPT_ENABLE
+    //4byte对齐时一次读两点写两帧
+    if (!(((unsigned long)dst | (unsigned long)src) & 0x3)) {
+        if (i & 1) {
+            i--;
+            dst[2 * i] = src[i];
+            dst[2 * i + 1] = src[i];
+        }
+        const u32 *in = (const u32 *)src;
+        u32 *out = (u32 *)dst;
+        for (i >>= 1; i > 0; i--) {
+            u32 w = in[i - 1];
+            out[2 * i - 2] = (w & 0xffff) | (w << 16);
+            out[2 * i - 1] = (w & 0xffff0000) | (w >> 16);
+        }
+        return;
+    }
+#endif
+    while (i--) {
+        dst[2 * i] = src[i];
+        dst[2 * i + 1] = src[i];
+    }
+}
+
+void pcm_s32_mono_to_dual(s32 *dst, const s32 *src, int frames)
+{
+    while (frames--) {
+        dst[2 * frames] = src[frames];
+        dst[2 * frames + 1] = src[frames];
+    }
+}
+
+void pcm_s16_mono_to_dual_s32(s32 *dst, const s16 *src, int frames, u8 shift)
+{
+    while (frames--) {
+        s32 v = (s32)src[frames] << shift;
+        dst[2 * frames] = v;
+        dst[2 * frames + 1] = v;
+    }
+}
+
+void pcm_s16_dual_to_mono(s16 *dst, const s16 *src, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        dst[i] = ((s32)src[2 * i] + src[2 * i + 1]) >> 1;
+    }
+}
+
+void pcm_s16_interleave(s16 *dst, const s16 *l, const s16 *r, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        dst[2 * i] = l[i];
+        dst[2 * i + 1] = r[i];
+    }
+}
+
+void pcm_s16_deinterleave(s16 *l, s16 *r, const s16 *src, int frames)
+{
+    int i = 0;
+
+#if PCM_CONVERT_OPT_ENABLE
+    //4byte对齐时一次读两帧写左右各两点，写l不会超过读位置，l == src时可原地
+    if (!(((unsigned long)l | (unsigned long)r | (unsigned long)src) & 0x3)) {
+        const u32 *in = (const u32 *)src;
+        u32 *out_l = (u32 *)l;
+        u32 *out_r = (u32 *)r;
+        for (; i < (frames >> 1); i++) {
+            u32 w0 = in[2 * i];
+            u32 w1 = in[2 * i + 1];
+            out_l[i] = (w0 & 0xffff) | (w1 << 16);
+            out_r[i] = (w0 >> 16) | (w1 & 0xffff0000);
+        }
+        i <<= 1;
+    }
+#endif
+    for (; i < frames; i++) {
+        l[i] = src[2 * i];
+        r[i] = src[2 * i + 1];
+    }
+}
+
+void pcm_s16_qual_mix_rear(s16 *data, int frames)
+{
+    if (frames <= 0) {
+        return;
+    }
+#if PCM_CONVERT_ASM_ENABLE
+    s32 tmp32_1;
+    s32 tmp32_2;
+    s16 *inbuf = data + 2;  //定位到第三通道
+    __asm__ volatile(
+        "1:                      \n\t"
+        "rep %0 {                \n\t"
+        "  %2 = h[%1 ++= 2](s)     \n\t"  //取第三通道值，并地址偏移两个字节指向第四通道数据
+        " %3 = h[%1 ++= -2](s)   \n\t"   //取第四通道值，并地址偏移两个字节指向第三通道数据
+        " %2 = %2 + %3           \n\t"
+        " %2 = sat16(%2)(s)      \n\t"  //饱和处理
+        " h[%1 ++= 2] = %2      \n\t"  //存取第三通道数据，并地址偏移两个字节指向第四通道数据
+        " h[%1 ++= 6] = %2      \n\t"  //存取第四通道数据，并地址偏移六个字节指向第三通道相邻的数据
+        "}                      \n\t"
+        "if(%0 != 0) goto 1b    \n\t"
+        :
+        "=&r"(frames),
+        "=&r"(inbuf),
+        "=&r"(tmp32_1),
+        "=&r"(tmp32_2)
+        :
+        "0"(frames),
+        "1"(inbuf),
+        "2"(tmp32_1),
+        "3"(tmp32_2)
+        :
+    );
+#else
+    for (int i = 0; i < frames; i++, data += 4) {
+        s16 v = pcm_sat((s32)data[2] + data[3], -32768, 32767);
+        data[2] = v;
+        data[3] = v;
+    }
+#endif
+}
+
+/*
+ *位宽转换查表，[src_fmt][dst_fmt]
+ *16bit相关组合走上面的kernel，32bit容器之间走参考实现
+ */
+#define PCM_FMT_SHIFT(fmt)	((fmt) == PCM_FMT_S24 ? 8 : ((fmt) == PCM_FMT_S32 ? 16 : 0))
+
+#define PCM_CONVERT_KERNEL(s, d) \
+static void pcm_##s##_to_##d(void *dst, const void *src, int points) \
+{ \
+    pcm_convert_points(dst, PCM_FMT_##d, src, PCM_FMT_##s, points); \
+}
+
+static void pcm_S16_to_S16(void *dst, const void *src, int points)
+{
+    if (dst != src) {
+        memmove(dst, src, points * 2);
+    }
+}
+static void pcm_S32_copy(void *dst, const void *src, int points)
+{
+    if (dst != src) {
+        memmove(dst, src, points * 4);
+    }
+}
+static void pcm_S16_to_S16_IN_32(void *dst, const void *src, int points)
+{
+    pcm_s16_to_s32(dst, src, points, 0);
+}
+static void pcm_S16_to_S24(void *dst, const void *src, int points)
+{
+    pcm_s16_to_s32(dst, src, points, 8);
+}
+static void pcm_S16_to_S32(void *dst, const void *src, int points)
+{
+    pcm_s16_to_s32(dst, src, points, 16);
+}
+static void pcm_S16_IN_32_to_S16(void *dst, const void *src, int points)
+{
+    pcm_s32_to_s16(dst, src, points, 0);
+}
+static void pcm_S24_to_S16(void *dst, const void *src, int points)
+{
+    pcm_s32_to_s16(dst, src, points, 8);
+}
+static void pcm_S32_to_S16(void *dst, const void *src, int points)
+{
+    pcm_s32_to_s16(dst, src, points, 16);
+}
+PCM_CONVERT_KERNEL(S16_IN_32, S24)
+PCM_CONVERT_KERNEL(S16_IN_32, S32)
+PCM_CONVERT_KERNEL(S24, S16_IN_32)
+PCM_CONVERT_KERNEL(S24, S32)
+PCM_CONVERT_KERNEL(S32, S16_IN_32)
+PCM_CONVERT_KERNEL(S32, S24)
+
+static const pcm_convert_fn pcm_convert_table[PCM_FMT_NUM][PCM_FMT_NUM] = {
+    [PCM_FMT_S16] = {
+        pcm_S16_to_S16, pcm_S16_to_S16_IN_32, pcm_S16_to_S24, pcm_S16_to_S32,
+    },
+    [PCM_FMT_S16_IN_32] = {
+        pcm_S16_IN_32_to_S16, pcm_S32_copy, pcm_S16_IN_32_to_S24, pcm_S16_IN_32_to_S32,
+    },
+    [PCM_FMT_S24] = {
+        pcm_S24_to_S16, pcm_S24_to_S16_IN_32, pcm_S32_copy, pcm_S24_to_S32,
+    },
+    [PCM_FMT_S32] = {
+        pcm_S32_to_S16, pcm_S32_to_S16_IN_32, pcm_S32_to_S24, pcm_S32_copy,
+    },
+};
+
+pcm_convert_fn pcm_convert_get(u8 src_fmt, u8 dst_fmt)
+{
+    if (src_fmt >= PCM_FMT_NUM || dst_fmt >= PCM_FMT_NUM) {
+        return NULL;
+    }
+    return pcm_convert_table[src_fmt][dst_fmt];
+}
+
+int pcm_convert(void *dst, u8 dst_fmt, u8 dst_ch, const void *src, u8 src_fmt, u8 src_ch, int frames)
+{
+    pcm_convert_fn fn = pcm_convert_get(src_fmt, dst_fmt);
+
+    if (!fn) {
+        return -EINVAL;
+    }
+    if (src_ch == dst_ch) {
+        fn(dst, src, frames * src_ch);
+        return 0;
+    }
+    if (src_ch == 1 && dst_ch == 2) {
+        if (src_fmt == PCM_FMT_S16 && dst_fmt == PCM_FMT_S16) {
+            pcm_s16_mono_to_dual(dst, src, frames);
+        } else if (src_fmt == PCM_FMT_S16) {
+            pcm_s16_mono_to_dual_s32(dst, src, frames, PCM_FMT_SHIFT(dst_fmt));
+        } else if (dst_fmt == PCM_FMT_S16) {
+            //先转换到dst前半段，再原地扩展
+            fn(dst, src, frames);
+            pcm_s16_mono_to_dual(dst, dst, frames);
+        } else {
+            fn(dst, src, frames);
+            pcm_s32_mono_to_dual(dst, dst, frames);
+        }
+        return 0;
+    }
+    if (src_ch == 2 && dst_ch == 1) {
+        if (src_fmt == PCM_FMT_S16 && dst_fmt == PCM_FMT_S16) {
+            pcm_s16_dual_to_mono(dst, src, frames);
+            return 0;
+        }
+        //按帧从前往后处理，dst每帧不超过src每帧大小，可原地转换
+        for (int i = 0; i < frames; i++) {
+            s64 v = (pcm_load(src, src_fmt, 2 * i) + pcm_load(src, src_fmt, 2 * i + 1)) >> 1;
+            pcm_store(dst, dst_fmt, i, v);
+        }
+        return 0;
+    }
+    return -EINVAL;
+}
@@ -0,0 +1,66 @@
+#ifndef _PCM_CONVERT_H_
+#define _PCM_CONVERT_H_
+
+#include "generic/typedef.h"
+
+/*
+ *pcm格式/通道转换公共库
+ *多通道数据均为交织存放，points为采样点数(各通道点数之和)，frames为帧数(每通道点数)
+ *各kernel注明是否支持原地转换(dst == src)
+ */
+
+/*
+ *0:全部使用c参考实现
+ *1:优化实现，芯片上走32bit打包读写/汇编循环，PC上(tools/host_test)汇编换成可自动向量化的c循环
+ */
+#ifndef PCM_CONVERT_OPT_ENABLE
+#define PCM_CONVERT_OPT_ENABLE		1
+#endif
+
+enum {
+    PCM_FMT_S16 = 0,	/*16bit*/
+    PCM_FMT_S16_IN_32,	/*32bit容器，16bit幅度(音效32bit中间数据，带余量)*/
+    PCM_FMT_S24,		/*32bit容器，24bit幅度(iis/dac 24bit输出)*/
+    PCM_FMT_S32,		/*32bit满幅*/
+    PCM_FMT_NUM,
+};
+
+/*单格式kernel，相同通道数的位宽转换*/
+typedef void (*pcm_convert_fn)(void *dst, const void *src, int points);
+
+/*16bit扩展到32bit容器并左移shift(0/8/16)，支持原地转换*/
+void pcm_s16_to_s32(s32 *dst, const s16 *src, int points, u8 shift);
+/*32bit容器右移shift后饱和到16bit，支持原地转换*/
+void pcm_s32_to_s16(s16 *dst, const s32 *src, int points, u8 shift);
+
+/*单声道复制为双声道，支持原地转换(dst需有2倍空间)*/
+void pcm_s16_mono_to_dual(s16 *dst, const s16 *src, int frames);
+void pcm_s32_mono_to_dual(s32 *dst, const s32 *src, int frames);
+/*16bit单声道左移shift后复制为32bit双声道(如16bit单声道直接写24bit iis)*/
+void pcm_s16_mono_to_dual_s32(s32 *dst, const s16 *src, int frames, u8 shift);
+/*双声道取平均为单声道，支持原地转换*/
+void pcm_s16_dual_to_mono(s16 *dst, const s16 *src, int frames);
+
+/*左右分离数据交织为双声道 / 双声道拆分为左右两路*/
+void pcm_s16_interleave(s16 *dst, const s16 *l, const s16 *r, int frames);
+/*拆分支持l == src原地(r需另外的空间)*/
+void pcm_s16_deinterleave(s16 *l, s16 *r, const s16 *src, int frames);
+
+/*四声道原地处理：后两路饱和相加后同时写回后两路(rl = rr = sat16(rl + rr))*/
+void pcm_s16_qual_mix_rear(s16 *data, int frames);
+
+/*
+ *按(src_fmt, dst_fmt)查表获取位宽转换kernel
+ *return:不支持的格式返回NULL
+ */
+pcm_convert_fn pcm_convert_get(u8 src_fmt, u8 dst_fmt);
+
+/*
+ *通用转换：位宽按(src_fmt, dst_fmt)，通道支持n->n、1->2、2->1(取平均)
+ *常用组合直接调用对应kernel，其余逐点处理
+ *只有常用组合支持原地转换，其余要求dst与src不重叠
+ *return:0成功，不支持的组合返回-EINVAL
+ */
+int pcm_convert(void *dst, u8 dst_fmt, u8 dst_ch, const void *src, u8 src_fmt, u8 src_ch, int frames);
+
+#endif/*_PCM_CONVERT_H_*/
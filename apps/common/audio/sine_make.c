@@ -3,9 +3,13 @@
 >author : lichao
 >create time : Sun 05 May 2019 08:37:35 PM CST
 *****************************************************************/
+#ifndef SINE_MAKE_HOST
 #include "system/includes.h"
+#endif
 #include "sine_make.h"
 
+/*SINE_MAKE_HOST：PC上回放(tools/host_test)，只编译查表和多声部合成部分*/
+#ifndef SINE_MAKE_HOST
 #define SINE_USE_MALLOC			1
 
 struct audio_sin_maker {
@@ -65,6 +69,8 @@ void *sin_tone_open(const struct sin_param *param, int num, u8 channel, u8 repea
 
     return (void *)sin;
 }
+#endif/*SINE_MAKE_HOST*/
+
 #if !defined(SINE_MAKE_IN_MASK)
 const int sf_sin_tab1[513] = {
     0x00000000, 0x0000c910, 0x0001921f, 0x00025b2d, 0x0003243a, 0x0003ed45, 0x0004b64e, 0x00057f53,
@@ -137,6 +143,7 @@ const int sf_sin_tab1[513] = {
 extern const int sf_sin_tab1[513] ;
 #endif
 
+#ifndef SINE_MAKE_HOST
 
 #define  SINE_INT_ZOOM   16384
 #define  SINE_INT_ZBIT   14
@@ -321,8 +328,177 @@ void sin_tone_close(void *_maker)
 #endif
 
 }
+#endif/*SINE_MAKE_HOST*/
+
+/*
+ *多声部合成器
+ *每个声部一个32bit相位累加器(一周期对应2^32)，高11bit查四分之一周期表，
+ *中间15bit做线性插值；频率和点数在open时按输出采样率换算成增量，生成时没有除法
+ */
+struct sine_synth_param {
+    u32 inc[SINE_SYNTH_TONE_MAX];
+    u32 points;
+    u8 tone_num;
+};
+
+struct audio_sine_synth {
+    u8 num;
+    u8 id;
+    u8 channel;
+    u8 repeat;
+    u16 fade_points;
+    u16 fade_coef;		/*32768 / fade_points*/
+    u32 pos;
+    u32 phase[SINE_SYNTH_TONE_MAX];
+    struct sine_synth_param param[0];
+};
+
+void *sine_synth_open(const struct sine_synth_note *note, int num, u32 sample_rate, u8 channel, u8 repeat)
+{
+    struct audio_sine_synth *synth;
+    int i, k;
+
+    if (!note || !num || !sample_rate) {
+        return NULL;
+    }
+
+    synth = zalloc(sizeof(*synth) + num * sizeof(struct sine_synth_param));
+    if (!synth) {
+        return NULL;
+    }
+    synth->num = num;
+    synth->channel = channel;
+    synth->repeat = repeat;
+    synth->fade_points = sample_rate * SINE_SYNTH_FADE_MS / 1000;
+    if (synth->fade_points) {
+        synth->fade_coef = 32768 / synth->fade_points;
+    }
+
+    for (i = 0; i < num; i++) {
+        struct sine_synth_param *p = &synth->param[i];
+        p->points = (u32)note[i].ms * sample_rate / 1000;
+        for (k = 0; k < SINE_SYNTH_TONE_MAX; k++) {
+            if (note[i].freq[k]) {
+                p->inc[p->tone_num++] = ((u64)note[i].freq[k] << 32) / sample_rate;
+            }
+        }
+    }
+
+    return synth;
+}
+
+/*phase一周期2^32，返回Q14*/
+static inline int sine_synth_value(u32 phase)
+{
+    u32 idx = (phase >> 21) & 0x1FF;
+    u32 frac = (phase >> 6) & 0x7FFF;
+    int dt0, dt1;
+
+    if (phase & BIT(30)) {
+        dt0 = sf_sin_tab1[512 - idx];
+        dt1 = sf_sin_tab1[511 - idx];
+    } else {
+        dt0 = sf_sin_tab1[idx];
+        dt1 = sf_sin_tab1[idx + 1];
+    }
+    dt0 += ((dt1 - dt0) * (int)frac) >> 15;
+    dt0 >>= 10;
+
+    return (phase & BIT(31)) ? -dt0 : dt0;
+}
+
+static int sine_synth_run(struct audio_sine_synth *synth, s16 *pcm, int len)
+{
+    u8 channel = synth->channel;
+    u32 remain_points = len / 2 / channel;
+    u16 fade = synth->fade_points;
+    int fade_coef = synth->fade_coef;
+
+    while (remain_points) {
+        struct sine_synth_param *p = &synth->param[synth->id];
+        u32 points = p->points - synth->pos;
+        u8 tone_num = p->tone_num;
+        int amp = tone_num ? (SINE_SYNTH_VOLUME / tone_num) : 0;
+        u32 pos = synth->pos;
+        u32 end_fade = (p->points > fade) ? (p->points - fade) : 0;
+        u32 i;
+        int k;
+
+        if (points > remain_points) {
+            points = remain_points;
+        }
+        remain_points -= points;
+
+        while (points--) {
+            int acc = 0;
+            for (k = 0; k < tone_num; k++) {
+                acc += sine_synth_value(synth->phase[k]);
+                synth->phase[k] += p->inc[k];
+            }
+            /*acc * amp <= 16384 * SINE_SYNTH_VOLUME，不会溢出*/
+            acc = (acc * amp) >> 14;
+            if (pos < fade) {
+                acc = (acc * (int)pos * fade_coef) >> 15;
+            } else if (pos >= end_fade) {
+                acc = (acc * (int)(p->points - 1 - pos) * fade_coef) >> 15;
+            }
+            pos++;
+
+            for (i = 0; i < channel; i++) {
+                *pcm++ = acc;
+            }
+        }
+
+        synth->pos = pos;
+        if (pos >= p->points) {
+            if (++synth->id >= synth->num) {
+                if (!synth->repeat) {
+                    break;
+                }
+                synth->id = 0;
+            }
+            synth->pos = 0;
+            memset(synth->phase, 0, sizeof(synth->phase));
+        }
+    }
+
+    return len - (remain_points * 2 * channel);
+}
+
+/*
+ *生成len字节数据到data，返回实际生成的长度，结束后返回0
+ */
+int sine_synth_make(void *_synth, void *data, int len)
+{
+    struct audio_sine_synth *synth = (struct audio_sine_synth *)_synth;
+
+    if (!synth || synth->id >= synth->num) {
+        return 0;
+    }
+    return sine_synth_run(synth, (s16 *)data, len);
+}
+
+int sine_synth_points(void *_synth)
+{
+    struct audio_sine_synth *synth = (struct audio_sine_synth *)_synth;
+    int points = 0;
+    u8 i = 0;
+
+    for (i = 0; i < synth->num; i++) {
+        points += synth->param[i].points;
+    }
+
+    return points;
+}
+
+void sine_synth_close(void *_synth)
+{
+    if (_synth) {
+        free(_synth);
+    }
+}
 
-#if 1
+#ifndef SINE_MAKE_HOST
 #include "asm/math_fast_function.h"
 
 #ifndef DATA16
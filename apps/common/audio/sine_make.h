@@ -14,6 +14,24 @@ struct sin_param {
     int decay;
 };
 
+/*
+ *多声部合成：每个音符最多SINE_SYNTH_TONE_MAX个频率同时发声(DTMF/和弦)
+ *相位累加器+查表插值生成，参数在open时按输出采样率一次换算好
+ */
+#define SINE_SYNTH_TONE_MAX      4
+#define SINE_SYNTH_VOLUME        26214  //满幅的0.8，与SINE_TOTAL_VOLUME一致
+#define SINE_SYNTH_FADE_MS       4      //音符首尾淡入淡出，避免爆音
+
+struct sine_synth_note {
+    u16 freq[SINE_SYNTH_TONE_MAX];  //各声部频率(Hz)，0表示该声部不发声，全0为静音段
+    u16 ms;                         //时长(ms)
+};
+
+void *sine_synth_open(const struct sine_synth_note *note, int num, u32 sample_rate, u8 channel, u8 repeat);
+int sine_synth_make(void *_synth, void *data, int len);
+int sine_synth_points(void *_synth);
+void sine_synth_close(void *_synth);
+
 int sin_tone_make(void *_maker, void *data, int len);
 void *sin_tone_open(const struct sin_param *param, int num, u8 channel, u8 repeat);
 int sin_tone_points(void *_maker);
@@ -82,6 +82,28 @@ void cJSON_InitHooks(cJSON_Hooks *hooks)
     cJSON_free	 = (hooks->free_fn) ? hooks->free_fn : free;
 }
 
+void cJSON_InitArena(cJSON_Arena *arena, void *buf, size_t size)
+{
+    arena->buf = (char *)buf;
+    arena->size = size;
+    arena->used = 0;
+}
+
+/* Arena bytes cJSON_ParseInSitu needs for json at most: one node for the root and one per '[', '{' and ',' (every element
+   follows one of them). Brackets and commas inside strings are counted too, which only overestimates. */
+size_t cJSON_ArenaSize(const char *json)
+{
+    size_t nodes = 1;
+    const size_t node_size = (sizeof(cJSON) + sizeof(double) - 1) & ~(sizeof(double) - 1);
+    while (json && *json) {
+        if (*json == '[' || *json == '{' || *json == ',') {
+            nodes++;
+        }
+        json++;
+    }
+    return nodes * node_size;
+}
+
 /* Internal constructor. */
 static cJSON *cJSON_New_Item(void)
 {
@@ -92,6 +114,25 @@ static cJSON *cJSON_New_Item(void)
     return node;
 }
 
+/* Parser constructor: carve the node out of arena (cJSON_ParseInSitu), or use the heap when arena is 0. */
+static cJSON *cJSON_New_Parse_Item(cJSON_Arena *arena)
+{
+    cJSON *node;
+    size_t used;
+    if (!arena) {
+        return cJSON_New_Item();
+    }
+    used = (arena->used + sizeof(double) - 1) & ~(sizeof(double) - 1);
+    if (used + sizeof(cJSON) > arena->size) {
+        return 0;
+    }
+    node = (cJSON *)(arena->buf + used);
+    arena->used = used + sizeof(cJSON);
+    memset(node, 0, sizeof(cJSON));
+    node->type = cJSON_IsArena;
+    return node;
+}
+
 /* Delete a cJSON structure. */
 void cJSON_Delete(cJSON *c)
 {
@@ -101,6 +142,10 @@ void cJSON_Delete(cJSON *c)
         if (!(c->type & cJSON_IsReference) && c->child) {
             cJSON_Delete(c->child);
         }
+        if (c->type & cJSON_IsArena) {	/* node and strings belong to an arena / the parsed text. */
+            c = next;
+            continue;
+        }
         if (!(c->type & cJSON_IsReference) && c->valuestring) {
             cJSON_free(c->valuestring);
         }
@@ -300,7 +345,7 @@ static unsigned parse_hex4(const char *str)
 
 /* Parse the input text into an unescaped cstring, and populate item. */
 static const unsigned char firstByteMark[7] = { 0x00, 0x00, 0xC0, 0xE0, 0xF0, 0xF8, 0xFC };
-static const char *parse_string(cJSON *item, const char *str)
+static const char *parse_string(cJSON *item, const char *str, cJSON_Arena *arena)
 {
     const char *ptr = str + 1;
     char *ptr2;
@@ -316,7 +361,11 @@ static const char *parse_string(cJSON *item, const char *str)
             ptr++;    /* Skip escaped quotes. */
         }
 
-    out = (char *)cJSON_malloc(len + 1);	/* This is how long we need for the string, roughly. */
+    if (arena) {
+        out = (char *)str + 1;	/* in situ: unescaped text is never longer than the source. */
+    } else {
+        out = (char *)cJSON_malloc(len + 1);	/* This is how long we need for the string, roughly. */
+    }
     if (!out) {
         return 0;
     }
@@ -396,10 +445,10 @@ static const char *parse_string(cJSON *item, const char *str)
             ptr++;
         }
     }
-    *ptr2 = 0;
     if (*ptr == '\"') {
         ptr++;
     }
+    *ptr2 = 0;	/* after the quote check: in situ this may overwrite the closing quote. */
     item->valuestring = out;
     item->type = cJSON_String;
     return ptr;
@@ -513,11 +562,11 @@ static char *print_string(cJSON *item, printbuffer *p)
 }
 
 /* Predeclare these prototypes. */
-static const char *parse_value(cJSON *item, const char *value);
+static const char *parse_value(cJSON *item, const char *value, cJSON_Arena *arena);
 static char *print_value(cJSON *item, int depth, int fmt, printbuffer *p);
-static const char *parse_array(cJSON *item, const char *value);
+static const char *parse_array(cJSON *item, const char *value, cJSON_Arena *arena);
 static char *print_array(cJSON *item, int depth, int fmt, printbuffer *p);
-static const char *parse_object(cJSON *item, const char *value);
+static const char *parse_object(cJSON *item, const char *value, cJSON_Arena *arena);
 static char *print_object(cJSON *item, int depth, int fmt, printbuffer *p);
 
 /* Utility to jump whitespace and cr/lf */
@@ -529,17 +578,17 @@ static const char *skip(const char *in)
     return in;
 }
 
-/* Parse an object - create a new root, and populate. */
-cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, int require_null_terminated)
+/* Parse an object - create a new root, and populate. Nodes come from arena when it is not 0. */
+static cJSON *parse_root(const char *value, const char **return_parse_end, int require_null_terminated, cJSON_Arena *arena)
 {
     const char *end = 0;
-    cJSON *c = cJSON_New_Item();
+    cJSON *c = cJSON_New_Parse_Item(arena);
     ep = 0;
     if (!c) {
         return 0;    /* memory fail */
     }
 
-    end = parse_value(c, skip(value));
+    end = parse_value(c, skip(value), arena);
     if (!end)	{
         cJSON_Delete(c);    /* parse failure. ep is set. */
         return 0;
@@ -559,12 +608,32 @@ cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, int
     }
     return c;
 }
+cJSON *cJSON_ParseWithOpts(const char *value, const char **return_parse_end, int require_null_terminated)
+{
+    return parse_root(value, return_parse_end, require_null_terminated, 0);
+}
 /* Default options for cJSON_Parse */
 cJSON *cJSON_Parse(const char *value)
 {
     return cJSON_ParseWithOpts(value, 0, 0);
 }
 
+/* Parse json in place: nodes come from arena, strings are unescaped inside json. */
+cJSON *cJSON_ParseInSitu(char *json, cJSON_Arena *arena)
+{
+    cJSON *c;
+    size_t used;
+    if (!json || !arena || !arena->buf) {
+        return 0;
+    }
+    used = arena->used;
+    c = parse_root(json, 0, 0, arena);
+    if (!c) {
+        arena->used = used;	/* drop the partial tree. */
+    }
+    return c;
+}
+
 /* Render a cJSON item/entity/structure to text. */
 char *cJSON_Print(cJSON *item)
 {
@@ -587,7 +656,7 @@ char *cJSON_PrintBuffered(cJSON *item, int prebuffer, int fmt)
 
 
 /* Parser core - when encountering text, process appropriately. */
-static const char *parse_value(cJSON *item, const char *value)
+static const char *parse_any(cJSON *item, const char *value, cJSON_Arena *arena)
 {
     if (!value) {
         return 0;    /* Fail on null. */
@@ -606,22 +675,32 @@ static const char *parse_value(cJSON *item, const char *value)
         return value + 4;
     }
     if (*value == '\"')				{
-        return parse_string(item, value);
+        return parse_string(item, value, arena);
     }
     if (*value == '-' || (*value >= '0' && *value <= '9'))	{
         return parse_number(item, value);
     }
     if (*value == '[')				{
-        return parse_array(item, value);
+        return parse_array(item, value, arena);
     }
     if (*value == '{')				{
-        return parse_object(item, value);
+        return parse_object(item, value, arena);
     }
 
     ep = value;
     return 0;	/* failure. */
 }
 
+/* The type setters above overwrite item->type; mark arena nodes again. */
+static const char *parse_value(cJSON *item, const char *value, cJSON_Arena *arena)
+{
+    const char *end = parse_any(item, value, arena);
+    if (arena) {
+        item->type |= cJSON_IsArena;
+    }
+    return end;
+}
+
 /* Render a value to text. */
 static char *print_value(cJSON *item, int depth, int fmt, printbuffer *p)
 {
@@ -694,7 +773,7 @@ static char *print_value(cJSON *item, int depth, int fmt, printbuffer *p)
 }
 
 /* Build an array from input text. */
-static const char *parse_array(cJSON *item, const char *value)
+static const char *parse_array(cJSON *item, const char *value, cJSON_Arena *arena)
 {
     cJSON *child;
     if (*value != '[')	{
@@ -708,24 +787,24 @@ static const char *parse_array(cJSON *item, const char *value)
         return value + 1;    /* empty array. */
     }
 
-    item->child = child = cJSON_New_Item();
+    item->child = child = cJSON_New_Parse_Item(arena);
     if (!item->child) {
         return 0;    /* memory fail */
     }
-    value = skip(parse_value(child, skip(value)));	/* skip any spacing, get the value. */
+    value = skip(parse_value(child, skip(value), arena));	/* skip any spacing, get the value. */
     if (!value) {
         return 0;
     }
 
     while (*value == ',') {
         cJSON *new_item;
-        if (!(new_item = cJSON_New_Item())) {
+        if (!(new_item = cJSON_New_Parse_Item(arena))) {
             return 0;    /* memory fail */
         }
         child->next = new_item;
         new_item->prev = child;
         child = new_item;
-        value = skip(parse_value(child, skip(value + 1)));
+        value = skip(parse_value(child, skip(value + 1), arena));
         if (!value) {
             return 0;    /* memory fail */
         }
@@ -858,7 +937,7 @@ static char *print_array(cJSON *item, int depth, int fmt, printbuffer *p)
 }
 
 /* Build an object from the text. */
-static const char *parse_object(cJSON *item, const char *value)
+static const char *parse_object(cJSON *item, const char *value, cJSON_Arena *arena)
 {
     cJSON *child;
     if (*value != '{')	{
@@ -872,11 +951,11 @@ static const char *parse_object(cJSON *item, const char *value)
         return value + 1;    /* empty array. */
     }
 
-    item->child = child = cJSON_New_Item();
+    item->child = child = cJSON_New_Parse_Item(arena);
     if (!item->child) {
         return 0;
     }
-    value = skip(parse_string(child, skip(value)));
+    value = skip(parse_string(child, skip(value), arena));
     if (!value) {
         return 0;
     }
@@ -886,20 +965,20 @@ static const char *parse_object(cJSON *item, const char *value)
         ep = value;    /* fail! */
         return 0;
     }
-    value = skip(parse_value(child, skip(value + 1)));	/* skip any spacing, get the value. */
+    value = skip(parse_value(child, skip(value + 1), arena));	/* skip any spacing, get the value. */
     if (!value) {
         return 0;
     }
 
     while (*value == ',') {
         cJSON *new_item;
-        if (!(new_item = cJSON_New_Item()))	{
+        if (!(new_item = cJSON_New_Parse_Item(arena)))	{
             return 0;    /* memory fail */
         }
         child->next = new_item;
         new_item->prev = child;
         child = new_item;
-        value = skip(parse_string(child, skip(value + 1)));
+        value = skip(parse_string(child, skip(value + 1), arena));
         if (!value) {
             return 0;
         }
@@ -909,7 +988,7 @@ static const char *parse_object(cJSON *item, const char *value)
             ep = value;    /* fail! */
             return 0;
         }
-        value = skip(parse_value(child, skip(value + 1)));	/* skip any spacing, get the value. */
+        value = skip(parse_value(child, skip(value + 1), arena));	/* skip any spacing, get the value. */
         if (!value) {
             return 0;
         }
@@ -1118,6 +1197,225 @@ static char *print_object(cJSON *item, int depth, int fmt, printbuffer *p)
     return out;
 }
 
+/* Streaming printer: same text as cJSON_Print/cJSON_PrintUnformatted, written
+   into a fixed buffer or pushed through a callback in small chunks, no heap use. */
+typedef struct {
+    char *buffer;		/* fixed output buffer, or staging chunk for write_fn */
+    int length;
+    int offset;
+    int total;			/* bytes produced so far */
+    int fail;
+    int (*write_fn)(void *priv, const char *data, int len);
+    void *priv;
+    char chunk[64];
+} printstream;
+
+static void stream_flush(printstream *s)
+{
+    if (s->write_fn && s->offset) {
+        if (s->write_fn(s->priv, s->buffer, s->offset) != s->offset) {
+            s->fail = 1;
+        }
+        s->offset = 0;
+    }
+}
+
+static void stream_put(printstream *s, const char *data, int len)
+{
+    int n;
+    while (len > 0 && !s->fail) {
+        if (s->offset == s->length) {
+            if (!s->write_fn) {
+                s->fail = 1;	/* fixed buffer is full. */
+                return;
+            }
+            stream_flush(s);
+            continue;
+        }
+        n = s->length - s->offset;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(s->buffer + s->offset, data, n);
+        s->offset += n;
+        s->total += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void stream_char(printstream *s, char c, int count)
+{
+    while (count-- > 0) {
+        stream_put(s, &c, 1);
+    }
+}
+
+static void stream_number(cJSON *item, printstream *s)
+{
+    char str[64];
+    double d = item->valuedouble;
+    if (d == 0) {
+        strcpy(str, "0");
+    } else if (fabs(((double)item->valueint) - d) <= DBL_EPSILON && d <= INT_MAX && d >= INT_MIN) {
+        sprintf(str, "%d", item->valueint);
+    } else if (fabs(floor(d) - d) <= DBL_EPSILON && fabs(d) < 1.0e60) {
+        sprintf(str, "%.0f", d);
+    } else if (fabs(d) < 1.0e-6 || fabs(d) > 1.0e9) {
+        sprintf(str, "%e", d);
+    } else {
+        sprintf(str, "%f", d);
+    }
+    stream_put(s, str, strlen(str));
+}
+
+static void stream_string(const char *str, printstream *s)
+{
+    const char *run;
+    char esc[8];
+    unsigned char token;
+
+    stream_char(s, '\"', 1);
+    run = str;
+    while (str && (token = *str)) {
+        if (token > 31 && token != '\"' && token != '\\') {
+            str++;
+            continue;
+        }
+        stream_put(s, run, str - run);
+        esc[0] = '\\';
+        switch (token) {
+        case '\\':
+        case '\"':
+            esc[1] = token;
+            break;
+        case '\b':
+            esc[1] = 'b';
+            break;
+        case '\f':
+            esc[1] = 'f';
+            break;
+        case '\n':
+            esc[1] = 'n';
+            break;
+        case '\r':
+            esc[1] = 'r';
+            break;
+        case '\t':
+            esc[1] = 't';
+            break;
+        default:
+            sprintf(esc + 1, "u%04x", token);
+            break;
+        }
+        stream_put(s, esc, esc[1] == 'u' ? 6 : 2);
+        run = ++str;
+    }
+    if (str) {
+        stream_put(s, run, str - run);
+    }
+    stream_char(s, '\"', 1);
+}
+
+static void stream_value(cJSON *item, int depth, int fmt, printstream *s)
+{
+    cJSON *child;
+    switch ((item->type) & 255) {
+    case cJSON_NULL:
+        stream_put(s, "null", 4);
+        break;
+    case cJSON_False:
+        stream_put(s, "false", 5);
+        break;
+    case cJSON_True:
+        stream_put(s, "true", 4);
+        break;
+    case cJSON_Number:
+        stream_number(item, s);
+        break;
+    case cJSON_String:
+        stream_string(item->valuestring, s);
+        break;
+    case cJSON_Array:
+        stream_char(s, '[', 1);
+        for (child = item->child; child && !s->fail; child = child->next) {
+            stream_value(child, depth + 1, fmt, s);
+            if (child->next) {
+                stream_put(s, ", ", fmt ? 2 : 1);
+            }
+        }
+        stream_char(s, ']', 1);
+        break;
+    case cJSON_Object:
+        stream_char(s, '{', 1);
+        if (!item->child) {
+            if (fmt) {
+                stream_char(s, '\n', 1);
+                stream_char(s, '\t', depth - 1);
+            }
+            stream_char(s, '}', 1);
+            break;
+        }
+        if (fmt) {
+            stream_char(s, '\n', 1);
+        }
+        depth++;
+        for (child = item->child; child && !s->fail; child = child->next) {
+            if (fmt) {
+                stream_char(s, '\t', depth);
+            }
+            stream_string(child->string, s);
+            stream_put(s, ":\t", fmt ? 2 : 1);
+            stream_value(child, depth, fmt, s);
+            if (child->next) {
+                stream_char(s, ',', 1);
+            }
+            if (fmt) {
+                stream_char(s, '\n', 1);
+            }
+        }
+        if (fmt) {
+            stream_char(s, '\t', depth - 1);
+        }
+        stream_char(s, '}', 1);
+        break;
+    }
+}
+
+int cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const int fmt)
+{
+    printstream s;
+    if (!item || !buffer || length <= 0) {
+        return 0;
+    }
+    memset(&s, 0, sizeof(s));
+    s.buffer = buffer;
+    s.length = length - 1;	/* room for the terminator. */
+    stream_value(item, 0, fmt, &s);
+    if (s.fail) {
+        buffer[0] = 0;
+        return 0;
+    }
+    buffer[s.offset] = 0;
+    return 1;
+}
+
+int cJSON_PrintStream(cJSON *item, const int fmt, int (*write_fn)(void *priv, const char *data, int len), void *priv)
+{
+    printstream s;
+    if (!item || !write_fn) {
+        return -1;
+    }
+    memset(&s, 0, sizeof(s));
+    s.buffer = s.chunk;
+    s.length = sizeof(s.chunk);
+    s.write_fn = write_fn;
+    s.priv = priv;
+    stream_value(item, 0, fmt, &s);
+    stream_flush(&s);
+    return s.fail ? -1 : s.total;
+}
+
 /* Get Array size/item / object item. */
 int    cJSON_GetArraySize(cJSON *array)
 {
@@ -1160,7 +1458,7 @@ static cJSON *create_reference(cJSON *item)
     }
     memcpy(ref, item, sizeof(cJSON));
     ref->string = 0;
-    ref->type |= cJSON_IsReference;
+    ref->type = (ref->type & ~cJSON_IsArena) | cJSON_IsReference;	/* the reference itself is on the heap. */
     ref->next = ref->prev = 0;
     return ref;
 }
@@ -1183,8 +1481,8 @@ void   cJSON_AddItemToArray(cJSON *array, cJSON *item)
 }
 void   cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
 {
-    if (!item) {
-        return;
+    if (!item || (item->type & cJSON_IsArena)) {
+        return;    /* arena keys point into the parsed text: never freed or renamed. */
     }
     if (item->string) {
         cJSON_free(item->string);
@@ -1194,7 +1492,7 @@ void   cJSON_AddItemToObject(cJSON *object, const char *string, cJSON *item)
 }
 void   cJSON_AddItemToObjectCS(cJSON *object, const char *string, cJSON *item)
 {
-    if (!item) {
+    if (!item || (item->type & cJSON_IsArena)) {
         return;
     }
     if (!(item->type & cJSON_StringIsConst) && item->string) {
@@ -1304,7 +1602,7 @@ void   cJSON_ReplaceItemInObject(cJSON *object, const char *string, cJSON *newit
     while (c && cJSON_strcasecmp(c->string, string)) {
         i++, c = c->next;
     }
-    if (c) {
+    if (c && !(newitem->type & cJSON_IsArena)) {
         newitem->string = cJSON_strdup(string);
         cJSON_ReplaceItemInArray(object, i, newitem);
     }
@@ -1455,7 +1753,7 @@ cJSON *cJSON_Duplicate(cJSON *item, int recurse)
         return 0;
     }
     /* Copy over all vars */
-    newitem->type = item->type & (~cJSON_IsReference), newitem->valueint = item->valueint, newitem->valuedouble = item->valuedouble;
+    newitem->type = item->type & (~(cJSON_IsReference | cJSON_IsArena)), newitem->valueint = item->valueint, newitem->valuedouble = item->valuedouble;
     if (item->valuestring)	{
         newitem->valuestring = cJSON_strdup(item->valuestring);
         if (!newitem->valuestring)	{
@@ -40,6 +40,7 @@ extern "C"
 
 #define cJSON_IsReference 256
 #define cJSON_StringIsConst 512
+#define cJSON_IsArena 1024
 
 /* The cJSON structure: */
 typedef struct cJSON {
@@ -63,6 +64,17 @@ typedef struct cJSON_Hooks {
 /* Supply malloc, realloc and free functions to cJSON */
 extern void cJSON_InitHooks(cJSON_Hooks *hooks);
 
+/* Caller-provided memory for cJSON_ParseInSitu. All nodes of a tree are carved out of buf, so the whole tree is released by
+   dropping (or freeing) buf once; used can be reset to 0 to reuse it. */
+typedef struct cJSON_Arena {
+    char *buf;
+    size_t size;
+    size_t used;
+} cJSON_Arena;
+extern void cJSON_InitArena(cJSON_Arena *arena, void *buf, size_t size);
+/* Bytes an empty arena needs to parse json with cJSON_ParseInSitu (an upper bound, counted without parsing). */
+extern size_t cJSON_ArenaSize(const char *json);
+
 
 /* Supply a block of JSON, and this returns a cJSON object you can interrogate. Call cJSON_Delete when finished. */
 extern cJSON *cJSON_Parse(const char *value);
@@ -72,6 +84,17 @@ extern char  *cJSON_Print(cJSON *item);
 extern char  *cJSON_PrintUnformatted(cJSON *item);
 /* Render a cJSON entity to text using a buffered strategy. prebuffer is a guess at the final size. guessing well reduces reallocation. fmt=0 gives unformatted, =1 gives formatted */
 extern char *cJSON_PrintBuffered(cJSON *item, int prebuffer, int fmt);
+/* Render a cJSON entity into a fixed buffer (NUL terminated) without touching the heap. Returns 1 on success, 0 if it didn't fit. */
+extern int cJSON_PrintPreallocated(cJSON *item, char *buffer, const int length, const int fmt);
+/* Render a cJSON entity through write_fn in small chunks without touching the heap. write_fn returns the bytes it took.
+   Returns the total length, or -1 if write_fn failed. */
+extern int cJSON_PrintStream(cJSON *item, const int fmt, int (*write_fn)(void *priv, const char *data, int len), void *priv);
+/* Parse json in situ: json is modified (strings are unescaped and terminated inside it) and the tree points into it, nodes come
+   from arena. Both must outlive the tree; cJSON_Delete is not needed (and does not free arena nodes). The arena is passed
+   down the parser, so trees can be parsed concurrently into different arenas (cJSON_GetErrorPtr stays shared).
+   Arena nodes' string/valuestring are not heap pointers: cJSON_AddItemToObject(CS)/cJSON_ReplaceItemInObject ignore arena
+   items. To put one into a heap tree use cJSON_AddItemReferenceToObject/Array or cJSON_Duplicate (both give heap nodes). */
+extern cJSON *cJSON_ParseInSitu(char *json, cJSON_Arena *arena);
 /* Delete a cJSON entity and all subentities. */
 extern void   cJSON_Delete(cJSON *c);
 
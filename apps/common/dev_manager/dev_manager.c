@@ -1,3 +1,9 @@
+#ifdef DEV_MANAGER_HOST
+/*PC上回放扫盘缓存(tools/host_test)，os/文件系统接口和system/includes.h、fs.h中用到的部分由测试程序提供*/
+#include "dev_manager.h"
+#include "dev_reg.h"
+#define TCFG_DEV_MANAGER_ENABLE		1
+#else
 #include "dev_manager.h"
 #include "dev_reg.h"
 #include "app_config.h"
@@ -6,6 +12,7 @@
 #endif
 #include "spi/nor_fs.h"
 #include "dev_update.h"
+#endif
 
 // *INDENT-OFF*
 
@@ -13,6 +20,13 @@
 
 #define DEV_MANAGER_TASK_NAME							"dev_mg"
 #define DEV_MANAGER_SCAN_DISK_MAX_DEEPTH				9
+#ifndef DEV_MANAGER_SCAN_CACHE_ENABLE
+#if TCFG_USB_DM_MULTIPLEX_WITH_SD_DAT0
+#define DEV_MANAGER_SCAN_CACHE_ENABLE					0//sd/usb复用时扫盘前会切换设备， 不缓存
+#else
+#define DEV_MANAGER_SCAN_CACHE_ENABLE					1//按设备缓存根目录扫盘句柄， 同一设备再次扫盘直接复用
+#endif
+#endif
 
 ///设备管理总控制句柄
 struct __dev_manager {
@@ -32,9 +46,30 @@ struct __dev {
 	struct imount 		*fmnt;
 	volatile u8			valid:	1;//有效设备标记， 这里有效是指是否有可播放文件
 	volatile u32		active_stamp;///活动设备时间戳，通过时间戳记录当前最后活动设备
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+	struct vfscan		*fsn;//缓存的根目录扫盘句柄， 设备卸载/删除或文件增删时失效
+	const char			*fsn_parm;//生成缓存句柄的扫盘参数， 只比较地址
+	u8					fsn_busy;//缓存句柄已被取走， 还没有释放
+#endif
 };
 
 
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+///释放设备缓存的扫盘句柄， 句柄正在使用时只解除缓存， 由使用者释放时真正释放
+static void __dev_manager_scan_cache_free(struct __dev *dev)
+{
+	if (dev->fsn) {
+		if (dev->fsn_busy == 0) {
+			fscan_release(dev->fsn);
+		}
+		dev->fsn = NULL;
+		dev->fsn_parm = NULL;
+		dev->fsn_busy = 0;
+	}
+}
+#endif
+
+
 static u32 __dev_manager_get_time_stamp(void)
 {
 	u32 counter = __this->counter;
@@ -97,6 +132,9 @@ static int __dev_manager_del(char *logo)
 	os_mutex_pend(&__this->mutex, 0);
 	list_for_each_entry_safe(dev, n, &__this->list, entry) {
 		if (!strcmp(dev->parm->logo, logo)) {
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+			__dev_manager_scan_cache_free(dev);
+#endif
 			///卸载文件系统
 			if(dev->fmnt){
 				unmount(dev->parm->storage_path);
@@ -515,9 +553,45 @@ struct __dev *dev_manager_find_by_index(u32 index, u8 valid)
 /*----------------------------------------------------------------------------*/
 void dev_manager_scan_disk_release(struct vfscan *fsn)
 {
-	if (fsn) {
-		fscan_release(fsn);
+	if (fsn == NULL) {
+		return;
+	}
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+	struct __dev *dev;
+	os_mutex_pend(&__this->mutex, 0);
+	list_for_each_entry(dev, &__this->list, entry) {
+		if (dev->fsn == fsn) {
+			///缓存句柄只归还， 下次扫盘复用
+			dev->fsn_busy = 0;
+			os_mutex_post(&__this->mutex);
+			return;
+		}
 	}
+	os_mutex_post(&__this->mutex);
+#endif
+	fscan_release(fsn);
+}
+//*----------------------------------------------------------------------------*/
+/**@brief   设备扫盘缓存失效
+   @param
+   			dev：设备节点， NULL表示所有设备
+   @return  无
+   @note	设备上增删文件后， 或者退出音乐模式需要回收内存时调用，
+   			下次扫盘重新扫描文件系统
+*/
+/*----------------------------------------------------------------------------*/
+void dev_manager_scan_disk_cache_free(struct __dev *dev)
+{
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+	struct __dev *p;
+	os_mutex_pend(&__this->mutex, 0);
+	list_for_each_entry(p, &__this->list, entry) {
+		if (dev == NULL || dev == p) {
+			__dev_manager_scan_cache_free(p);
+		}
+	}
+	os_mutex_post(&__this->mutex);
+#endif
 }
 //*----------------------------------------------------------------------------*/
 /**@brief   设备扫盘
@@ -528,7 +602,10 @@ void dev_manager_scan_disk_release(struct vfscan *fsn)
    			cycle_mode：播放循环模式
 			callback：扫描打断回调
    @return  成功返回扫描控制句柄，失败返回NULL
-   @note
+   @note	根目录扫盘句柄按设备缓存， 相同参数再次扫盘直接返回缓存句柄，
+   			不再遍历文件系统， 只省掉切设备/切录音文件夹时的重复扫盘， 首次扫盘不变；
+   			缓存只在设备卸载/删除、file_manager和music_player增删文件时失效，
+   			其他途径写卡(录音、调试写文件等)需要自己调用dev_manager_scan_disk_cache_free
 */
 /*----------------------------------------------------------------------------*/
 struct vfscan *dev_manager_scan_disk(struct __dev *dev, const char *path, const char *parm, u8 cycle_mode, struct __scan_callback *callback)
@@ -553,6 +630,23 @@ struct vfscan *dev_manager_scan_disk(struct __dev *dev, const char *path, const
         printf("mult remount fail !!!\n");
         return NULL;
     }
+#endif
+	struct vfscan *fsn;
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+	if (path == NULL) {
+		fsn = NULL;
+		os_mutex_pend(&__this->mutex, 0);
+		if (dev->fsn && (dev->fsn_busy == 0) && (dev->fsn_parm == parm)) {
+			dev->fsn_busy = 1;
+			fsn = dev->fsn;
+		}
+		os_mutex_post(&__this->mutex);
+		if (fsn) {
+			printf("%s scan cache hit, file_number = %d\n", dev->parm->logo, fsn->file_number);
+			fsn->cycle_mode = cycle_mode;
+			return fsn;
+		}
+	}
 #endif
 	char *fsn_path = NULL;
 	char *tmp_path = NULL;
@@ -570,7 +664,6 @@ struct vfscan *dev_manager_scan_disk(struct __dev *dev, const char *path, const
 		fsn_path = dev->parm->root_path;
 	}
 	printf("fsn_path = %s, scan parm = %s\n", fsn_path, parm);
-	struct vfscan *fsn;
 	/* clock_add_set(SCAN_DISK_CLK); */
 	if(callback && callback->enter){
 		callback->enter(dev);//扫描前处理， 可以在注册的回调里提高系统时钟等处理
@@ -596,6 +689,19 @@ struct vfscan *dev_manager_scan_disk(struct __dev *dev, const char *path, const
 			fsn = NULL;
 		} else {
 			fsn->cycle_mode = cycle_mode;
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+			if (path == NULL) {
+				os_mutex_pend(&__this->mutex, 0);
+				if (dev->fsn_busy == 0) {
+					///替换掉参数不同的旧缓存
+					__dev_manager_scan_cache_free(dev);
+					dev->fsn = fsn;
+					dev->fsn_parm = parm;
+					dev->fsn_busy = 1;
+				}
+				os_mutex_post(&__this->mutex);
+			}
+#endif
 		}
 	}
 
@@ -945,6 +1051,9 @@ static int __dev_manager_unmount(char *logo)
 		os_mutex_post(&__this->mutex);
 		return -1;
 	}
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+	__dev_manager_scan_cache_free(dev);
+#endif
 	if(dev->fmnt){
 		unmount(dev->parm->storage_path);
 		dev->fmnt = NULL;
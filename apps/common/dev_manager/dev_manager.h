@@ -49,6 +49,8 @@ struct __dev *dev_manager_find_spec(char *logo, u8 valid);
 struct __dev *dev_manager_find_by_index(u32 index, u8 valid);
 //dev_manager扫盘句柄释放
 void dev_manager_scan_disk_release(struct vfscan *fsn);
+//dev_manager扫盘缓存失效, dev为NULL时所有设备失效
+void dev_manager_scan_disk_cache_free(struct __dev *dev);
 //dev_manager扫盘
 struct vfscan *dev_manager_scan_disk(struct __dev *dev, const char *path, const char *parm, u8 cycle_mode, struct __scan_callback *callback);
 //dev_manager设定指定设备节点设备有效
@@ -28,20 +28,19 @@
 //#define LOG_CLI_ENABLE
 #include "debug.h"
 
-#define KEY_EVENT_CLICK_ONLY_SUPPORT	1 	//是否支持某些按键只响应单击事件
-
-
-#if TCFG_SPI_LCD_ENABLE
-#ifndef ALL_KEY_EVENT_CLICK_ONLY
-#define ALL_KEY_EVENT_CLICK_ONLY	1 	//是否全部按键只响应单击事件
-#endif
-#else
-#ifndef ALL_KEY_EVENT_CLICK_ONLY
-#define ALL_KEY_EVENT_CLICK_ONLY	0 	//是否全部按键只响应单击事件
-#endif
+/*
+ *扫描定时器按需运行:
+ *手势进行中(按下/消抖/等待连击)按scan_time全速扫描并阻止进入低功耗,
+ *手势结束后降频到KEY_SCAN_IDLE_TIME, 且该节拍在低功耗期间被忽略,
+ *边沿唤醒(key_active_set)后恢复全速扫描
+ */
+#ifndef KEY_SCAN_IDLE_TIME
+#define KEY_SCAN_IDLE_TIME		20	//空闲时扫描周期, 单位ms
 #endif
 
-static volatile u8 is_key_active = 0;
+static u8 key_scan_num = 0;	//已注册扫描定时器的按键驱动数
+static volatile u8 key_busy_num = 0;	//全速扫描中的按键驱动数
+static volatile u8 key_wakeup_pending = 0;	//边沿唤醒后还没有被扫描处理
 
 
 extern u32 timer_get_ms(void);
@@ -55,135 +54,10 @@ int __attribute__((weak)) key_event_remap(struct sys_event *e)
     return true;
 }
 
-//=======================================================//
-// 按键扫描函数: 扫描所有注册的按键驱动
-//=======================================================//
-static void key_driver_scan(void *_scan_para)
+static void key_driver_notify(struct key_driver_para *scan_para, u8 key_event, u8 key_value)
 {
-    struct key_driver_para *scan_para = (struct key_driver_para *)_scan_para;
-
-    u8 key_event = 0;
-    u8 cur_key_value = NO_KEY;
-    u8 key_value = 0;
     struct sys_event e;
-    static u8 poweron_cnt = 0;
-
-    //为了滤掉adkey与mic连在一起时电容充放电导致的开机按键误判,一般用于type-c耳机
-    /* if (poweron_cnt <= 250) { */
-    /*     poweron_cnt++; */
-    /*     return; */
-    /* } */
 
-    cur_key_value = scan_para->get_value();
-    /* if (cur_key_value != NO_KEY) { */
-    /*     printf(">>>cur_key_value: %d\n", cur_key_value); */
-    /* } */
-
-    if (cur_key_value != NO_KEY) {
-        is_key_active = 35;      //35*10Ms
-    } else if (is_key_active) {
-        is_key_active --;
-    }
-//===== 按键消抖处理
-    if (cur_key_value != scan_para->filter_value && scan_para->filter_time) {	//当前按键值与上一次按键值如果不相等, 重新消抖处理, 注意filter_time != 0;
-        scan_para->filter_cnt = 0; 		//消抖次数清0, 重新开始消抖
-        scan_para->filter_value = cur_key_value;	//记录上一次的按键值
-        return; 		//第一次检测, 返回不做处理
-    } 		//当前按键值与上一次按键值相等, filter_cnt开始累加;
-    if (scan_para->filter_cnt < scan_para->filter_time) {
-        scan_para->filter_cnt++;
-        return;
-    }
-    //为了滤掉adkey与mic连在一起时电容充放电导致的按键误判,一般用于type-c耳机
-    /* if ((cur_key_value != scan_para->last_key) && (scan_para->last_key != NO_KEY) && (cur_key_value != NO_KEY)) { */
-    /*     return; */
-    /* } */
-//===== 按键消抖结束, 开始判断按键类型(单击, 双击, 长按, 多击, HOLD, (长按/HOLD)抬起)
-    if (cur_key_value != scan_para->last_key) {
-        if (cur_key_value == NO_KEY) {  //cur_key = NO_KEY; last_key = valid_key -> 按键被抬起
-
-#if MOUSE_KEY_SCAN_MODE
-            /* if (scan_para->press_cnt >= scan_para->long_time) {  //长按/HOLD状态之后被按键抬起; */
-            key_event = KEY_EVENT_UP;
-            key_value = scan_para->last_key;
-            goto _notify;  	//发送抬起消息
-            /* } */
-#else
-            if (scan_para->press_cnt >= scan_para->long_time) {  //长按/HOLD状态之后被按键抬起;
-                key_event = KEY_EVENT_UP;
-                key_value = scan_para->last_key;
-                goto _notify;  	//发送抬起消息
-            }
-#endif
-
-            scan_para->click_delay_cnt = 1;  //按键等待下次连击延时开始
-        } else {  //cur_key = valid_key, last_key = NO_KEY -> 按键被按下
-            scan_para->press_cnt = 1;  //用于判断long和hold事件的计数器重新开始计时;
-            if (cur_key_value != scan_para->notify_value) {  //第一次单击/连击时按下的是不同按键, 单击次数重新开始计数
-                scan_para->click_cnt = 1;
-                scan_para->notify_value = cur_key_value;
-            } else {
-                scan_para->click_cnt++;  //单击次数累加
-            }
-        }
-        goto _scan_end;  //返回, 等待延时时间到
-    } else { 	//cur_key = last_key -> 没有按键按下/按键长按(HOLD)
-        if (cur_key_value == NO_KEY) {  //last_key = NO_KEY; cur_key = NO_KEY -> 没有按键按下
-            if (scan_para->click_cnt > 0) {  //有按键需要消息需要处理
-
-#if ALL_KEY_EVENT_CLICK_ONLY//彩屏方案支持单击
-                key_event = KEY_EVENT_CLICK;  //单击
-                key_value = scan_para->notify_value;
-                goto _notify;
-
-#endif
-
-#if KEY_EVENT_CLICK_ONLY_SUPPORT 	//是否支持某些按键只响应单击事件
-                if (scan_para->notify_value & BIT(7)) {  //BIT(7)按键特殊处理标志, 只发送单击事件, 也可以用于其它扩展
-                    key_event = KEY_EVENT_CLICK;  //单击
-                    key_value = scan_para->notify_value;
-                    goto _notify;
-                }
-#endif
-                if (scan_para->click_delay_cnt > scan_para->click_delay_time) { //按键被抬起后延时到
-                    //TODO: 在此可以添加任意多击事件
-                    if (scan_para->click_cnt >= 5) {
-                        key_event = KEY_EVENT_FIRTH_CLICK;  //五击
-                    } else if (scan_para->click_cnt >= 4) {
-                        key_event = KEY_EVENT_FOURTH_CLICK;  //4击
-                    } else if (scan_para->click_cnt >= 3) {
-                        key_event = KEY_EVENT_TRIPLE_CLICK;  //三击
-                    } else if (scan_para->click_cnt >= 2) {
-                        key_event = KEY_EVENT_DOUBLE_CLICK;  //双击
-                    } else {
-                        key_event = KEY_EVENT_CLICK;  //单击
-                    }
-                    key_value = scan_para->notify_value;
-                    goto _notify;
-                } else {	//按键抬起后等待下次延时时间未到
-                    scan_para->click_delay_cnt++;
-                    goto _scan_end; //按键抬起后延时时间未到, 返回
-                }
-            } else {
-                goto _scan_end;  //没有按键需要处理
-            }
-        } else {  //last_key = valid_key; cur_key = valid_key, press_cnt累加用于判断long和hold
-            scan_para->press_cnt++;
-            if (scan_para->press_cnt == scan_para->long_time) {
-                key_event = KEY_EVENT_LONG;
-            } else if (scan_para->press_cnt == scan_para->hold_time) {
-                key_event = KEY_EVENT_HOLD;
-                scan_para->press_cnt = scan_para->long_time;
-            } else {
-                goto _scan_end;  //press_cnt没到长按和HOLD次数, 返回
-            }
-            //press_cnt没到长按和HOLD次数, 发消息
-            key_value = cur_key_value;
-            goto _notify;
-        }
-    }
-
-_notify:
 #if TCFG_IRSENSOR_ENABLE
     if (get_irSensor_event() == IR_SENSOR_EVENT_FAR) {  //未佩戴的耳机不响应按键
         return;
@@ -197,10 +71,6 @@ _notify:
     e.u.key.value = key_value;
     e.u.key.tmr = timer_get_ms();
 
-
-    scan_para->click_cnt = 0;  //单击次数清0
-    scan_para->notify_value = NO_KEY;
-
     e.arg  = (void *)DEVICE_EVENT_FROM_KEY;
     /* printf("key_value: 0x%x, event: %d\n", key_value, key_event); */
     if (key_event_remap(&e)) {
@@ -209,16 +79,76 @@ _notify:
         audio_key_tone_play();
 #endif
     }
-_scan_end:
-    scan_para->last_key = cur_key_value;
-    return;
+}
+
+static u32 key_scan_idle_time(struct key_driver_para *scan_para)
+{
+    return (scan_para->scan_time > KEY_SCAN_IDLE_TIME) ? scan_para->scan_time : KEY_SCAN_IDLE_TIME;
+}
+
+//手势开始/结束时切换扫描周期
+static void key_driver_scan_busy(struct key_driver_para *scan_para, u8 busy)
+{
+    if (scan_para->scan_busy == busy) {
+        return;
+    }
+    scan_para->scan_busy = busy;
+    if (busy) {
+        key_busy_num++;
+        usr_timer_modify(scan_para->scan_timer, scan_para->scan_time);
+    } else {
+        key_busy_num--;
+        usr_timer_modify(scan_para->scan_timer, key_scan_idle_time(scan_para));
+    }
+}
+
+//=======================================================//
+// 按键扫描函数: 采样按键值, 驱动手势状态机, 发送按键消息
+//=======================================================//
+static void key_driver_scan(void *_scan_para)
+{
+    struct key_driver_para *scan_para = (struct key_driver_para *)_scan_para;
+    u8 cur_key_value;
+    u8 key_event;
+    u8 key_value;
+
+    //为了滤掉adkey与mic连在一起时电容充放电导致的开机按键误判,一般用于type-c耳机,
+    //可在此丢弃开机后的若干次采样
+
+    cur_key_value = scan_para->get_value();
+    /* if (cur_key_value != NO_KEY) { */
+    /*     printf(">>>cur_key_value: %d\n", cur_key_value); */
+    /* } */
+
+    if (key_gesture_step(scan_para, cur_key_value, &key_event, &key_value)) {
+        key_driver_notify(scan_para, key_event, key_value);
+    }
+
+    if (!key_gesture_idle(scan_para)) {
+        key_driver_scan_busy(scan_para, 1);
+    } else if (key_wakeup_pending) {
+        //边沿唤醒后至少全速扫描一次, 唤醒源没有按下的按键时下一拍即回到空闲
+        key_wakeup_pending = 0;
+        key_driver_scan_busy(scan_para, 1);
+    } else {
+        key_driver_scan_busy(scan_para, 0);
+    }
+}
+
+static void key_driver_scan_add(struct key_driver_para *scan_para)
+{
+    scan_para->scan_busy = 0;
+    key_scan_num++;
+    scan_para->scan_timer = usr_timer_add((void *)scan_para, key_driver_scan, key_scan_idle_time(scan_para), 0); //注册按键扫描定时器
 }
 
 
 //wakeup callback
 void key_active_set(u8 port)
 {
-    is_key_active = 35;      //35*10Ms
+    if (key_scan_num) {  //没有扫描定时器时不能挂起, 否则会一直阻止进入低功耗
+        key_wakeup_pending = 1;
+    }
 }
 
 //=======================================================//
@@ -235,11 +165,11 @@ int key_driver_init(void)
 #ifdef TCFG_IOKEY_TIME_REDEFINE
     extern struct key_driver_para iokey_scan_user_para;
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&iokey_scan_user_para, key_driver_scan, iokey_scan_user_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&iokey_scan_user_para);
     }
 #else
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&iokey_scan_para, key_driver_scan, iokey_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&iokey_scan_para);
     }
 #endif
 #endif
@@ -251,14 +181,14 @@ int key_driver_init(void)
     extern struct key_driver_para multi_adkey_scan_para;
     err = multi_adkey_init(multi_adkey_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&multi_adkey_scan_para, key_driver_scan, multi_adkey_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&multi_adkey_scan_para);
     }
 #else
     extern const struct adkey_platform_data adkey_data;
     extern struct key_driver_para adkey_scan_para;
     err = adkey_init(&adkey_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&adkey_scan_para, key_driver_scan, adkey_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&adkey_scan_para);
     }
 #endif
 #endif
@@ -268,7 +198,7 @@ int key_driver_init(void)
     extern struct key_driver_para irkey_scan_para;
     err = irkey_init(&irkey_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&irkey_scan_para, key_driver_scan, irkey_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&irkey_scan_para);
     }
 #endif
 
@@ -277,7 +207,7 @@ int key_driver_init(void)
     extern struct key_driver_para touch_key_scan_para;
     err = touch_key_init(&touch_key_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&touch_key_scan_para, key_driver_scan, touch_key_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&touch_key_scan_para);
     }
 #endif
 
@@ -286,7 +216,7 @@ int key_driver_init(void)
     extern struct key_driver_para adkey_rtcvdd_scan_para;
     err = adkey_rtcvdd_init(&adkey_rtcvdd_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&adkey_rtcvdd_scan_para, key_driver_scan, adkey_rtcvdd_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&adkey_rtcvdd_scan_para);
     }
 #endif
 
@@ -295,7 +225,7 @@ int key_driver_init(void)
     extern struct key_driver_para rdec_key_scan_para;
     err = rdec_key_init(&rdec_key_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&rdec_key_scan_para, key_driver_scan, rdec_key_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&rdec_key_scan_para);
     }
 #endif
 
@@ -306,7 +236,7 @@ int key_driver_init(void)
     extern int ctmu_touch_key_init(const struct ctmu_touch_key_platform_data * ctmu_touch_key_data);
     err = ctmu_touch_key_init(&ctmu_touch_key_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&ctmu_touch_key_scan_para, key_driver_scan, ctmu_touch_key_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&ctmu_touch_key_scan_para);
     }
 #endif /* #if TCFG_CTMU_TOUCH_KEY_ENABLE */
 
@@ -329,7 +259,7 @@ int key_driver_init(void)
     extern struct key_driver_para tent600_key_scan_para;
     err = tent600_key_init(&key_data);
     if (err == 0) {
-        sys_s_hi_timer_add((void *)&tent600_key_scan_para, key_driver_scan, tent600_key_scan_para.scan_time); //注册按键扫描定时器
+        key_driver_scan_add(&tent600_key_scan_para);
     }
 #endif
 
@@ -338,7 +268,7 @@ int key_driver_init(void)
 
 static u8 key_idle_query(void)
 {
-    return !is_key_active;
+    return !(key_busy_num || key_wakeup_pending);
 }
 #if !TCFG_LP_TOUCH_KEY_ENABLE
 REGISTER_LP_TARGET(key_lp_target) = {
@@ -0,0 +1,144 @@
+#include "device/key_driver.h"
+#include "system/event.h"
+#ifndef KEY_GESTURE_HOST	//PC上回放测试不包含板级配置，MOUSE_KEY_SCAN_MODE等按未定义处理
+#include "app_config.h"
+#endif
+
+/*
+ *按键手势识别状态机
+ *只依赖key_driver_para中的计数状态，不读硬件、不发消息、不取系统时间，
+ *时间以扫描节拍为单位由调用者注入(每调用一次key_gesture_step即前进一拍)，
+ *可脱离系统单独编译，用录制的按键序列回放验证(tools/host_test/key_gesture_replay.c)
+ */
+
+#define KEY_EVENT_CLICK_ONLY_SUPPORT	1 	//是否支持某些按键只响应单击事件
+
+#if TCFG_SPI_LCD_ENABLE
+#ifndef ALL_KEY_EVENT_CLICK_ONLY
+#define ALL_KEY_EVENT_CLICK_ONLY	1 	//是否全部按键只响应单击事件
+#endif
+#else
+#ifndef ALL_KEY_EVENT_CLICK_ONLY
+#define ALL_KEY_EVENT_CLICK_ONLY	0 	//是否全部按键只响应单击事件
+#endif
+#endif
+
+//=======================================================//
+// 手势状态机前进一拍: 消抖, 单击, 多击, 长按, HOLD, (长按/HOLD)抬起
+// cur_key_value: 本拍采样到的按键值
+// 返回1表示产生事件, 事件类型和键值由key_event/key_value带出(键值保留BIT(7)标志)
+//=======================================================//
+int key_gesture_step(struct key_driver_para *scan_para, u8 cur_key_value, u8 *key_event, u8 *key_value)
+{
+    int ret = 0;
+
+//===== 按键消抖处理
+    if (cur_key_value != scan_para->filter_value && scan_para->filter_time) {	//当前按键值与上一次按键值如果不相等, 重新消抖处理, 注意filter_time != 0;
+        scan_para->filter_cnt = 0; 		//消抖次数清0, 重新开始消抖
+        scan_para->filter_value = cur_key_value;	//记录上一次的按键值
+        return 0; 		//第一次检测, 返回不做处理
+    } 		//当前按键值与上一次按键值相等, filter_cnt开始累加;
+    if (scan_para->filter_cnt < scan_para->filter_time) {
+        scan_para->filter_cnt++;
+        return 0;
+    }
+//===== 按键消抖结束, 开始判断按键类型(单击, 双击, 长按, 多击, HOLD, (长按/HOLD)抬起)
+    if (cur_key_value != scan_para->last_key) {
+        if (cur_key_value == NO_KEY) {  //cur_key = NO_KEY; last_key = valid_key -> 按键被抬起
+#if MOUSE_KEY_SCAN_MODE
+            *key_event = KEY_EVENT_UP;
+            *key_value = scan_para->last_key;
+            goto _notify;  	//发送抬起消息
+#else
+            if (scan_para->press_cnt >= scan_para->long_time) {  //长按/HOLD状态之后被按键抬起;
+                *key_event = KEY_EVENT_UP;
+                *key_value = scan_para->last_key;
+                goto _notify;  	//发送抬起消息
+            }
+#endif
+            scan_para->click_delay_cnt = 1;  //按键等待下次连击延时开始
+        } else {  //cur_key = valid_key, last_key = NO_KEY -> 按键被按下
+            scan_para->press_cnt = 1;  //用于判断long和hold事件的计数器重新开始计时;
+            if (cur_key_value != scan_para->notify_value) {  //第一次单击/连击时按下的是不同按键, 单击次数重新开始计数
+                scan_para->click_cnt = 1;
+                scan_para->notify_value = cur_key_value;
+            } else {
+                scan_para->click_cnt++;  //单击次数累加
+            }
+        }
+        goto _scan_end;  //返回, 等待延时时间到
+    }
+
+    if (cur_key_value == NO_KEY) {  //last_key = NO_KEY; cur_key = NO_KEY -> 没有按键按下
+        if (scan_para->click_cnt == 0) {
+            goto _scan_end;  //没有按键需要处理
+        }
+#if ALL_KEY_EVENT_CLICK_ONLY//彩屏方案支持单击
+        *key_event = KEY_EVENT_CLICK;  //单击
+        *key_value = scan_para->notify_value;
+        goto _notify;
+#endif
+#if KEY_EVENT_CLICK_ONLY_SUPPORT 	//是否支持某些按键只响应单击事件
+        if (scan_para->notify_value & BIT(7)) {  //BIT(7)按键特殊处理标志, 只发送单击事件, 也可以用于其它扩展
+            *key_event = KEY_EVENT_CLICK;  //单击
+            *key_value = scan_para->notify_value;
+            goto _notify;
+        }
+#endif
+        if (scan_para->click_delay_cnt <= scan_para->click_delay_time) {
+            scan_para->click_delay_cnt++;
+            goto _scan_end; //按键抬起后延时时间未到, 返回
+        }
+        //按键被抬起后延时到
+        //TODO: 在此可以添加任意多击事件
+        if (scan_para->click_cnt >= 5) {
+            *key_event = KEY_EVENT_FIRTH_CLICK;  //五击
+        } else if (scan_para->click_cnt >= 4) {
+            *key_event = KEY_EVENT_FOURTH_CLICK;  //4击
+        } else if (scan_para->click_cnt >= 3) {
+            *key_event = KEY_EVENT_TRIPLE_CLICK;  //三击
+        } else if (scan_para->click_cnt >= 2) {
+            *key_event = KEY_EVENT_DOUBLE_CLICK;  //双击
+        } else {
+            *key_event = KEY_EVENT_CLICK;  //单击
+        }
+        *key_value = scan_para->notify_value;
+        goto _notify;
+    }
+
+    //last_key = valid_key; cur_key = valid_key, press_cnt累加用于判断long和hold
+    scan_para->press_cnt++;
+    if (scan_para->press_cnt == scan_para->long_time) {
+        *key_event = KEY_EVENT_LONG;
+    } else if (scan_para->press_cnt == scan_para->hold_time) {
+        *key_event = KEY_EVENT_HOLD;
+        scan_para->press_cnt = scan_para->long_time;
+    } else {
+        goto _scan_end;  //press_cnt没到长按和HOLD次数, 返回
+    }
+    *key_value = cur_key_value;
+
+_notify:
+    scan_para->click_cnt = 0;  //单击次数清0
+    scan_para->notify_value = NO_KEY;
+    ret = 1;
+_scan_end:
+    scan_para->last_key = cur_key_value;
+    return ret;
+}
+
+//=======================================================//
+// 手势是否结束: 消抖已稳定在NO_KEY, 没有按下的按键, 也没有等待连击的按键
+// 结束后状态机不再需要节拍, 扫描定时器可以降频/停止
+//=======================================================//
+int key_gesture_idle(const struct key_driver_para *scan_para)
+{
+    if (scan_para->last_key != NO_KEY || scan_para->click_cnt) {
+        return 0;
+    }
+    if (scan_para->filter_time &&
+        (scan_para->filter_value != NO_KEY || scan_para->filter_cnt < scan_para->filter_time)) {
+        return 0;
+    }
+    return 1;
+}
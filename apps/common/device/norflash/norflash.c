@@ -1,7 +1,12 @@
+#ifdef NORFLASH_HOST
+/*PC上的spi flash模型回放(tools/host_test)，spi/gpio/系统接口和norflash.h中用到的部分由测试程序提供*/
+#define TCFG_NORFLASH_DEV_ENABLE    1
+#else
 #include "norflash.h"
 #include "app_config.h"
 #include "asm/clock.h"
 #include "system/timer.h"
+#endif
 
 #if defined(TCFG_NORFLASH_DEV_ENABLE) && TCFG_NORFLASH_DEV_ENABLE
 
@@ -9,7 +14,9 @@
 #define LOG_TAG     "[FLASH]"
 #define LOG_ERROR_ENABLE
 #define LOG_INFO_ENABLE
+#ifndef NORFLASH_HOST
 #include "debug.h"
+#endif
 
 
 #define MAX_NORFLASH_PART_NUM       4
@@ -150,10 +157,47 @@ static int norflash_verify_part(struct norflash_partition *p)
 #define FLASH_CACHE_ENABLE  1
 
 #if FLASH_CACHE_ENABLE
-static u32 flash_cache_addr;
-static u8 *flash_cache_buf = NULL; //缓存4K的数据，与flash里的数据一样。
-static u8 flash_cache_is_dirty;
+/*
+ * 多扇区写回缓存：每行缓存一个4K扇区，LRU替换
+ * 同一扇区的多次写合并，由定时器按地址顺序回写
+ * RAM：FLASH_CACHE_SECTOR_NUM * 4K，open时申请，close时释放
+ * 默认1个扇区，与原来的单扇区缓存占用相同，只有1->0的修改不擦除、读命中仍然有效；
+ * 录音/日志等同时写几个扇区的应用在RAM允许时可以在板级配置里改成2~4，
+ * 擦除次数的对比见tools/host_test/norflash_sim_test.c
+ */
+#ifndef FLASH_CACHE_SECTOR_NUM
+#define FLASH_CACHE_SECTOR_NUM          1   //缓存扇区数，每个扇区占用4K RAM
+#endif
+#define FLASH_CACHE_SECTOR_SIZE         4096
+
+struct flash_cache_line {
+    u32 addr;           //扇区起始地址
+    u8 *buf;            //扇区数据，与flash(加上未回写的修改)一致
+    u32 lru;
+    u16 dirty_start;    //未回写的修改范围
+    u16 dirty_end;
+    u8 valid;
+    u8 dirty;
+    u8 need_erase;      //修改中有0->1的位，回写时需要先擦除
+};
+
+struct flash_cache_stat {
+    u32 read_hit;
+    u32 read_miss;
+    u32 erase_cnt;
+    u32 program_cnt;
+};
+
+static struct flash_cache_line flash_cache[FLASH_CACHE_SECTOR_NUM];
+static u8 *flash_cache_mem = NULL;
+static u32 flash_cache_tick;
 static u16 flash_cache_timer;
+static struct flash_cache_stat flash_cache_stat;
+
+static struct flash_cache_line *_norflash_cache_find(u32 sector_addr);
+static struct flash_cache_line *_norflash_cache_fill(u32 sector_addr);
+static int _norflash_cache_flush_all(void);
+static int _norflash_cache_invalidate(u32 addr, u32 len);
 
 #define FLASH_CACHE_SYNC_T_INTERVAL     60
 
@@ -166,6 +210,20 @@ static int _check_0xff(u8 *buf, u32 len)
     }
     return 0;
 }
+
+/*
+ * 新数据相对旧数据只有1->0的位时，可以直接编程，不需要擦除
+ * return: 1 需要擦除，0 不需要
+ */
+static int _check_need_erase(u8 *old, u8 *new, u32 len)
+{
+    for (u32 i = 0; i < len; i ++) {
+        if ((old[i] & new[i]) != new[i]) {
+            return 1;
+        }
+    }
+    return 0;
+}
 #endif
 
 
@@ -182,7 +240,7 @@ static u32 _pow(u32 num, int n)
 static int _norflash_wait_ok()
 {
     u32 timeout = 8 * 1000 * 1000 / 100;
-    while (timeout--) {
+    while (timeout) {
         spi_cs_l();
         spi_write_byte(WINBOND_READ_SR1);
         u8 reg_1 = spi_read_byte();
@@ -191,6 +249,7 @@ static int _norflash_wait_ok()
             break;
         }
         delay(100);
+        timeout--;
     }
     if (timeout == 0) {
         log_error("norflash_wait_ok timeout!\r\n");
@@ -305,11 +364,13 @@ int _norflash_open(void *arg)
             is4byte_mode = 1;
         }
 #if FLASH_CACHE_ENABLE
-        flash_cache_buf = (u8 *)malloc(4096);
-        ASSERT(flash_cache_buf, "flash_cache_buf is not ok\n");
-        flash_cache_addr = 4096;//先给一个大于4096的数
-        _norflash_read(0, flash_cache_buf, 4096, 1);
-        flash_cache_addr = 0;
+        flash_cache_mem = (u8 *)malloc(FLASH_CACHE_SECTOR_NUM * FLASH_CACHE_SECTOR_SIZE);
+        ASSERT(flash_cache_mem, "flash_cache_mem is not ok\n");
+        memset(flash_cache, 0, sizeof(flash_cache));
+        memset(&flash_cache_stat, 0, sizeof(flash_cache_stat));
+        for (int i = 0; i < FLASH_CACHE_SECTOR_NUM; i++) {
+            flash_cache[i].buf = flash_cache_mem + i * FLASH_CACHE_SECTOR_SIZE;
+        }
 #endif
         log_info("norflash open success !\n");
     }
@@ -335,13 +396,17 @@ int _norflash_close(void)
     }
     if (!_norflash.open_cnt) {
 #if FLASH_CACHE_ENABLE
-        if (flash_cache_is_dirty) {
-            flash_cache_is_dirty = 0;
-            _norflash_eraser(FLASH_SECTOR_ERASER, flash_cache_addr);
-            _norflash_write_pages(flash_cache_addr, flash_cache_buf, 4096);
+        _norflash_cache_flush_all();
+        if (flash_cache_timer) {
+            sys_timeout_del(flash_cache_timer);
+            flash_cache_timer = 0;
         }
-        free(flash_cache_buf);
-        flash_cache_buf = NULL;
+        log_info("norflash cache hit:%d miss:%d erase:%d program:%d\n",
+                 flash_cache_stat.read_hit, flash_cache_stat.read_miss,
+                 flash_cache_stat.erase_cnt, flash_cache_stat.program_cnt);
+        memset(flash_cache, 0, sizeof(flash_cache));
+        free(flash_cache_mem);
+        flash_cache_mem = NULL;
 #endif
         spi_close(_norflash.spi_num);
         spi_cs_uninit();
@@ -352,30 +417,8 @@ int _norflash_close(void)
     return 0;
 }
 
-int _norflash_read(u32 addr, u8 *buf, u32 len, u8 cache)
+static void _norflash_spi_read(u32 addr, u8 *buf, u32 len)
 {
-    int reg = 0;
-    u32 align_addr;
-    os_mutex_pend(&_norflash.mutex, 0);
-    /* y_printf("flash read  addr = %d, len = %d\n", addr, len); */
-#if FLASH_CACHE_ENABLE
-    if (!cache) {
-        goto __no_cache1;
-    }
-    u32 r_len = 4096 - (addr % 4096);
-    if ((addr >= flash_cache_addr) && (addr < (flash_cache_addr + 4096))) {
-        if (len <= r_len) {
-            memcpy(buf, flash_cache_buf + (addr - flash_cache_addr), len);
-            goto __exit;
-        } else {
-            memcpy(buf, flash_cache_buf + (addr - flash_cache_addr), r_len);
-            addr += r_len;
-            buf += r_len;
-            len -= r_len;
-        }
-    }
-__no_cache1:
-#endif
     spi_cs_l();
     if (_norflash.spi_r_width == 2) {
         spi_write_byte(WINBOND_FAST_READ_DUAL_OUTPUT);
@@ -398,20 +441,65 @@ __no_cache1:
         spi_dma_read(buf, len);
     }
     spi_cs_h();
-//#if FLASH_CACHE_ENABLE
-//    if (!cache) {
-//        goto __no_cache2;
-//    }
-//    align_addr = (addr + len) / 4096 * 4096;
-//    if ((int)len - (int)((addr + len) - align_addr) >= 4096) {
-//        align_addr -= 4096;
-//        if (flash_cache_addr != align_addr) {
-//            flash_cache_addr = align_addr;
-//            memcpy(flash_cache_buf, buf + (align_addr - addr), 4096);
-//        }
-//    }
-//__no_cache2:
-//#endif
+}
+
+int _norflash_read(u32 addr, u8 *buf, u32 len, u8 cache)
+{
+    int reg = 0;
+    os_mutex_pend(&_norflash.mutex, 0);
+    /* y_printf("flash read  addr = %d, len = %d\n", addr, len); */
+#if FLASH_CACHE_ENABLE
+    if (cache && flash_cache_mem) {
+        /*
+         * 逐扇区查缓存，命中的从缓存拷贝；
+         * 只读扇区一部分的未命中读入整个扇区(只替换没有未回写数据的行)，同一扇区的后续小块读直接命中；
+         * 覆盖整个扇区的未命中不占用缓存，连续的合并成一次读
+         */
+        u32 miss_addr = addr;
+        u8 *miss_buf = buf;
+        u32 miss_len = 0;
+        while (len) {
+            u32 sector_addr = addr / FLASH_CACHE_SECTOR_SIZE * FLASH_CACHE_SECTOR_SIZE;
+            u32 r_len = FLASH_CACHE_SECTOR_SIZE - (addr - sector_addr);
+            r_len = len > r_len ? r_len : len;
+            struct flash_cache_line *line = _norflash_cache_find(sector_addr);
+            if (line) {
+                flash_cache_stat.read_hit++;
+            } else {
+                flash_cache_stat.read_miss++;
+            }
+            if ((line == NULL) && (r_len < FLASH_CACHE_SECTOR_SIZE)) {
+                if (miss_len) {
+                    _norflash_spi_read(miss_addr, miss_buf, miss_len);
+                    miss_len = 0;
+                }
+                line = _norflash_cache_fill(sector_addr);
+            }
+            if (line) {
+                if (miss_len) {
+                    _norflash_spi_read(miss_addr, miss_buf, miss_len);
+                    miss_len = 0;
+                }
+                memcpy(buf, line->buf + (addr - sector_addr), r_len);
+                line->lru = ++flash_cache_tick;
+            } else {
+                if (miss_len == 0) {
+                    miss_addr = addr;
+                    miss_buf = buf;
+                }
+                miss_len += r_len;
+            }
+            addr += r_len;
+            buf += r_len;
+            len -= r_len;
+        }
+        if (miss_len) {
+            _norflash_spi_read(miss_addr, miss_buf, miss_len);
+        }
+        goto __exit;
+    }
+#endif
+    _norflash_spi_read(addr, buf, len);
 __exit:
     os_mutex_post(&_norflash.mutex);
     return reg;
@@ -457,23 +545,176 @@ static int _norflash_write_pages(u32 addr, u8 *buf, u32 len)
 }
 
 #if FLASH_CACHE_ENABLE
-static void _norflash_cache_sync_timer(void *priv)
+static struct flash_cache_line *_norflash_cache_find(u32 sector_addr)
+{
+    for (int i = 0; i < FLASH_CACHE_SECTOR_NUM; i++) {
+        if (flash_cache[i].valid && (flash_cache[i].addr == sector_addr)) {
+            return &flash_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * 回写一个缓存行，成功后才清除dirty
+ * 失败时保留dirty和need_erase，缓存中的数据不丢失，下次回写重新擦除/编程
+ */
+static int _norflash_cache_flush_line(struct flash_cache_line *line)
 {
     int reg = 0;
-    os_mutex_pend(&_norflash.mutex, 0);
-    if (flash_cache_is_dirty) {
-        flash_cache_is_dirty = 0;
-        reg = _norflash_eraser(FLASH_SECTOR_ERASER, flash_cache_addr);
+    if (!line->dirty) {
+        return 0;
+    }
+    if (line->need_erase) {
+        reg = _norflash_eraser(FLASH_SECTOR_ERASER, line->addr);
         if (reg) {
-            goto __exit;
+            return reg;
         }
-        reg = _norflash_write_pages(flash_cache_addr, flash_cache_buf, 4096);
+        flash_cache_stat.erase_cnt++;
+        /*擦除后全0xff的页不需要编程*/
+        for (u32 offset = 0; offset < FLASH_CACHE_SECTOR_SIZE; offset += 256) {
+            if (_check_0xff(line->buf + offset, 256)) {
+                reg = _norflash_write_pages(line->addr + offset, line->buf + offset, 256);
+                if (reg) {
+                    return reg;
+                }
+                flash_cache_stat.program_cnt++;
+            }
+        }
+    } else {
+        /*只有1->0的修改，直接编程修改过的范围(重复编程相同数据不影响已编程的位)*/
+        reg = _norflash_write_pages(line->addr + line->dirty_start, line->buf + line->dirty_start,
+                                    line->dirty_end - line->dirty_start);
+        if (reg) {
+            return reg;
+        }
+        flash_cache_stat.program_cnt += (line->dirty_end - 1) / 256 - line->dirty_start / 256 + 1;
+    }
+    line->dirty = 0;
+    line->need_erase = 0;
+    return 0;
+}
+
+/*按地址从低到高回写所有脏扇区*/
+static int _norflash_cache_flush_all(void)
+{
+    int reg = 0;
+    while (1) {
+        struct flash_cache_line *line = NULL;
+        for (int i = 0; i < FLASH_CACHE_SECTOR_NUM; i++) {
+            if (flash_cache[i].valid && flash_cache[i].dirty) {
+                if ((line == NULL) || (flash_cache[i].addr < line->addr)) {
+                    line = &flash_cache[i];
+                }
+            }
+        }
+        if (line == NULL) {
+            break;
+        }
+        reg = _norflash_cache_flush_line(line);
+        if (reg) {
+            break;
+        }
+    }
+    return reg;
+}
+
+/*
+ * 擦除操作前丢弃范围内的缓存
+ * 只擦除扇区的一部分时，先回写扇区内未回写的修改，回写失败时保留该行并返回错误
+ */
+static int _norflash_cache_invalidate(u32 addr, u32 len)
+{
+    int reg;
+    for (int i = 0; i < FLASH_CACHE_SECTOR_NUM; i++) {
+        struct flash_cache_line *line = &flash_cache[i];
+        if (line->valid && (line->addr + FLASH_CACHE_SECTOR_SIZE > addr) && (line->addr < addr + len)) {
+            if ((line->addr < addr) || (line->addr + FLASH_CACHE_SECTOR_SIZE > addr + len)) {
+                reg = _norflash_cache_flush_line(line);
+                if (reg) {
+                    return reg;
+                }
+            }
+            line->valid = 0;
+            line->dirty = 0;
+        }
+    }
+    return 0;
+}
+
+/*
+ * 读未命中时把扇区读入缓存
+ * 只替换无效行或最久未使用的干净行，所有行都有未回写数据时返回NULL(直接从flash读)
+ */
+static struct flash_cache_line *_norflash_cache_fill(u32 sector_addr)
+{
+    struct flash_cache_line *line = NULL;
+    for (int i = 0; i < FLASH_CACHE_SECTOR_NUM; i++) {
+        if (!flash_cache[i].valid) {
+            line = &flash_cache[i];
+            break;
+        }
+        if (!flash_cache[i].dirty && ((line == NULL) || (flash_cache[i].lru < line->lru))) {
+            line = &flash_cache[i];
+        }
+    }
+    if (line == NULL) {
+        return NULL;
+    }
+    _norflash_spi_read(sector_addr, line->buf, FLASH_CACHE_SECTOR_SIZE);
+    line->addr = sector_addr;
+    line->valid = 1;
+    line->dirty = 0;
+    line->need_erase = 0;
+    return line;
+}
+
+/*
+ * 获取扇区对应的缓存行，未命中时替换最久未使用的行
+ * full: 本次写覆盖整个扇区，不需要先从flash读出
+ */
+static struct flash_cache_line *_norflash_cache_get(u32 sector_addr, u8 full, int *reg)
+{
+    struct flash_cache_line *line = _norflash_cache_find(sector_addr);
+    if (line) {
+        return line;
+    }
+    for (int i = 0; i < FLASH_CACHE_SECTOR_NUM; i++) {
+        if (!flash_cache[i].valid) {
+            line = &flash_cache[i];
+            break;
+        }
+        if ((line == NULL) || (flash_cache[i].lru < line->lru)) {
+            line = &flash_cache[i];
+        }
+    }
+    if (line->valid && line->dirty) {
+        *reg = _norflash_cache_flush_line(line);
+        if (*reg) {
+            return NULL;
+        }
+    }
+    line->valid = 0;
+    if (!full) {
+        _norflash_spi_read(sector_addr, line->buf, FLASH_CACHE_SECTOR_SIZE);
+    }
+    line->addr = sector_addr;
+    line->valid = 1;
+    line->dirty = 0;
+    line->need_erase = full;
+    return line;
+}
+
+static void _norflash_cache_sync_timer(void *priv)
+{
+    os_mutex_pend(&_norflash.mutex, 0);
+    if (_norflash_cache_flush_all()) {
+        log_error("norflash cache sync fail\n");
     }
     if (flash_cache_timer) {
         sys_timeout_del(flash_cache_timer);
         flash_cache_timer = 0;
     }
-__exit:
     os_mutex_post(&_norflash.mutex);
 }
 #endif
@@ -492,65 +733,37 @@ int _norflash_write(u32 addr, void *buf, u32 len, u8 cache)
         reg = _norflash_write_pages(addr, w_buf, w_len);
         goto __exit;
     }
-    u32 align_addr = addr / 4096 * 4096;
-    u32 align_len = 4096 - (addr - align_addr);
-    align_len = w_len > align_len ? align_len : w_len;
-    if (align_addr != flash_cache_addr) {
-        if (flash_cache_is_dirty) {
-            flash_cache_is_dirty = 0;
-            reg = _norflash_eraser(FLASH_SECTOR_ERASER, flash_cache_addr);
-            if (reg) {
-                goto __exit;
-            }
-            reg = _norflash_write_pages(flash_cache_addr, flash_cache_buf, 4096);
-            if (reg) {
-                goto __exit;
-            }
-        }
-        _norflash_read(align_addr, flash_cache_buf, 4096, 0);
-        flash_cache_addr = align_addr;
-    }
-    memcpy(flash_cache_buf + (addr - align_addr), w_buf, align_len);
-    if ((addr + align_len) % 4096) {
-        flash_cache_is_dirty = 1;
-        if (flash_cache_timer) {
-            sys_timer_re_run(flash_cache_timer);
-        } else {
-            flash_cache_timer = sys_timeout_add(0, _norflash_cache_sync_timer, FLASH_CACHE_SYNC_T_INTERVAL);
-        }
-    } else {
-        flash_cache_is_dirty = 0;
-        reg = _norflash_eraser(FLASH_SECTOR_ERASER, align_addr);
-        if (reg) {
+    while (w_len) {
+        u32 sector_addr = addr / FLASH_CACHE_SECTOR_SIZE * FLASH_CACHE_SECTOR_SIZE;
+        u32 offset = addr - sector_addr;
+        u32 cnt = FLASH_CACHE_SECTOR_SIZE - offset;
+        cnt = w_len > cnt ? cnt : w_len;
+        struct flash_cache_line *line = _norflash_cache_get(sector_addr, cnt == FLASH_CACHE_SECTOR_SIZE, &reg);
+        if (line == NULL) {
             goto __exit;
         }
-        reg = _norflash_write_pages(align_addr, flash_cache_buf, 4096);
-        if (reg) {
-            goto __exit;
+        if (!line->need_erase) {
+            line->need_erase = _check_need_erase(line->buf + offset, w_buf, cnt);
         }
-    }
-    addr += align_len;
-    w_buf += align_len;
-    w_len -= align_len;
-    while (w_len) {
-        u32 cnt = w_len > 4096 ? 4096 : w_len;
-        _norflash_read(addr, flash_cache_buf, 4096, 0);
-        flash_cache_addr = addr;
-        memcpy(flash_cache_buf, w_buf, cnt);
-        if ((addr + cnt) % 4096) {
-            flash_cache_is_dirty = 1;
+        memcpy(line->buf + offset, w_buf, cnt);
+        if (line->dirty) {
+            line->dirty_start = offset < line->dirty_start ? offset : line->dirty_start;
+            line->dirty_end = (offset + cnt) > line->dirty_end ? (offset + cnt) : line->dirty_end;
+        } else {
+            line->dirty_start = offset;
+            line->dirty_end = offset + cnt;
+            line->dirty = 1;
+        }
+        line->lru = ++flash_cache_tick;
+        if ((offset + cnt) % FLASH_CACHE_SECTOR_SIZE) {
             if (flash_cache_timer) {
                 sys_timer_re_run(flash_cache_timer);
             } else {
                 flash_cache_timer = sys_timeout_add(0, _norflash_cache_sync_timer, FLASH_CACHE_SYNC_T_INTERVAL);
             }
         } else {
-            flash_cache_is_dirty = 0;
-            reg = _norflash_eraser(FLASH_SECTOR_ERASER, addr);
-            if (reg) {
-                goto __exit;
-            }
-            reg = _norflash_write_pages(addr, flash_cache_buf, 4096);
+            /*写到扇区末尾，认为是顺序写，立即回写*/
+            reg = _norflash_cache_flush_line(line);
             if (reg) {
                 goto __exit;
             }
@@ -587,6 +800,8 @@ int _norflash_eraser(u8 eraser, u32 addr)
     case FLASH_CHIP_ERASER:
         eraser_cmd = WINBOND_CHIP_ERASE;
         break;
+    default:
+        return -EINVAL;
     }
     _norflash_send_write_enable();
     spi_cs_l();
@@ -623,27 +838,41 @@ int _norflash_ioctl(u32 cmd, u32 arg, u32 unit, void *_part)
         *(u32 *)arg = 512;
         break;
     case IOCTL_ERASE_PAGE:
+#if FLASH_CACHE_ENABLE
+        reg = _norflash_cache_invalidate((arg * unit + part->start_addr) / 256 * 256, 256);
+        if (reg) {
+            break;
+        }
+#endif
         reg = _norflash_eraser(FLASH_PAGE_ERASER, arg * unit + part->start_addr);
         break;
     case IOCTL_ERASE_SECTOR:
+#if FLASH_CACHE_ENABLE
+        reg = _norflash_cache_invalidate((arg * unit + part->start_addr) / 4096 * 4096, 4096);
+        if (reg) {
+            break;
+        }
+#endif
         reg = _norflash_eraser(FLASH_SECTOR_ERASER, arg * unit + part->start_addr);
         break;
     case IOCTL_ERASE_BLOCK:
+#if FLASH_CACHE_ENABLE
+        reg = _norflash_cache_invalidate((arg * unit + part->start_addr) / 65536 * 65536, 65536);
+        if (reg) {
+            break;
+        }
+#endif
         reg = _norflash_eraser(FLASH_BLOCK_ERASER, arg * unit + part->start_addr);
         break;
     case IOCTL_ERASE_CHIP:
+#if FLASH_CACHE_ENABLE
+        _norflash_cache_invalidate(0, (u32) - 1);
+#endif
         reg = _norflash_eraser(FLASH_CHIP_ERASER, 0);
         break;
     case IOCTL_FLUSH:
 #if FLASH_CACHE_ENABLE
-        if (flash_cache_is_dirty) {
-            flash_cache_is_dirty = 0;
-            reg = _norflash_eraser(FLASH_SECTOR_ERASER, flash_cache_addr);
-            if (reg) {
-                goto __exit;
-            }
-            reg = _norflash_write_pages(flash_cache_addr, flash_cache_buf, 4096);
-        }
+        reg = _norflash_cache_flush_all();
 #endif
         break;
     case IOCTL_CMD_RESUME:
@@ -662,7 +891,6 @@ int _norflash_ioctl(u32 cmd, u32 arg, u32 unit, void *_part)
         reg = -EINVAL;
         break;
     }
-__exit:
     os_mutex_post(&_norflash.mutex);
     return reg;
 }
@@ -1,3 +1,11 @@
+#ifdef USB_MSD_HOST
+/*PC上回放READ_10/WRITE_10流水(tools/host_test)，usb、设备接口和msd_info由测试程序提供*/
+#include "usb/scsi.h"
+#include "usb_std_class_def.h"
+#define TCFG_USB_SLAVE_MSD_ENABLE   1
+//dev_ioctl用(u32)&x传地址，64位主机上会截断，本文件的u32按指针宽度编译
+#define u32                         unsigned long
+#else
 #include "system/includes.h"
 #include "usb/device/usb_stack.h"
 #include "usb/device/msd.h"
@@ -13,6 +21,7 @@
 #if TCFG_USB_APPLE_DOCK_EN
 #include "apple_dock/iAP.h"
 #endif
+#endif
 
 #if TCFG_USB_SLAVE_MSD_ENABLE
 
@@ -23,7 +32,9 @@
 #define LOG_INFO_ENABLE
 /* #define LOG_DUMP_ENABLE */
 #define LOG_CLI_ENABLE
+#ifndef USB_MSD_HOST
 #include "debug.h"
+#endif
 
  // *INDENT-OFF*
 #define USB_MSD_BULK_DEV_USE_ASYNC			1
@@ -115,10 +126,35 @@ static const u8 SCSIInquiryData[] = {
 #define MSD_BLOCK_SIZE       1
 #define MSD_BUFFER_SIZE     (MSD_BLOCK_SIZE * 512)
 
+#if USB_MSD_BULK_DEV_USE_ASYNC
+/*
+ *环形缓存：MSD_BUFFER_NUM个MSD_BUFFER_SIZE块，usb按块收发，
+ *设备按组(MSD_GROUP_NUM块)做一次多扇区读写，设备同一时间只有一笔异步操作，
+ *一组在设备读写时usb收发另一组
+ */
+#define MSD_GROUP_NUM       (MSD_BUFFER_NUM / 2)
+#define MSD_GROUP_BLOCKS    (MSD_GROUP_NUM * MSD_BLOCK_SIZE)
+#define MSD_RING_SIZE       (MSD_BUFFER_SIZE * MSD_BUFFER_NUM)
+#define MSD_READ_AHEAD_MIN  64  //单条READ_10不少于此扇区数时也视为顺序读
+
+/*READ_10之间的顺序预读：上一条命令结束时把后续一组扇区读进空闲组，覆盖csw和下一条cbw的时间*/
+struct msd_read_ahead {
+    u32 lba;            //预读起始扇区
+    u32 next_lba;       //上一条READ_10的结束扇区
+    u32 capacity;       //设备总扇区数
+    u16 num;            //预读扇区数，0:无预读
+    u8 slot;            //预读数据所在缓存块
+    u8 lun;
+};
+#endif
+
 struct usb_msd_handle {
     struct usb_scsi_cbw cbw;
     struct usb_scsi_csw csw;
     struct msd_info info;
+#if USB_MSD_BULK_DEV_USE_ASYNC
+    struct msd_read_ahead ra;
+#endif
     u8 *msd_buf;
     u8 *ep_out_dmabuffer;
     /* u8 *ep_in_dmabuffer; */
@@ -128,7 +164,7 @@ struct usb_msd_handle *msd_handle;
 #if USB_MALLOC_ENABLE
 #else
 #if USB_MSD_BULK_DEV_USE_ASYNC
-static u8 msd_buf[MSD_BUFFER_SIZE * 2] SEC(.mass_storage) __attribute__((aligned(64)));
+static u8 msd_buf[MSD_RING_SIZE] SEC(.mass_storage) __attribute__((aligned(64)));
 #else
 static u8 msd_buf[MSD_BUFFER_SIZE] SEC(.mass_storage) __attribute__((aligned(64)));
 #endif
@@ -531,11 +567,57 @@ static void verify(const struct usb_device_t *usb_device)
 }
 
 #if USB_MSD_BULK_DEV_USE_ASYNC
+#define MSD_SLOT_BUF(slot)  (msd_handle->msd_buf + (slot) * MSD_BUFFER_SIZE)
+#define MSD_NEXT_GROUP(slot)    (((slot) + MSD_GROUP_NUM) % MSD_BUFFER_NUM)
+
+/*----------------------------------------------------------------------------*/
+/**@brief    丢弃READ_10顺序预读
+   @param
+   @return
+   @note     预读还在进行时先等待设备完成，非READ_10命令或不连续的读前调用
+*/
+/*----------------------------------------------------------------------------*/
+static void msd_read_ahead_drop(void)
+{
+    struct msd_read_ahead *ra = &msd_handle->ra;
+    void *dev_fd;
+
+    if (ra->num == 0) {
+        return;
+    }
+    ra->num = 0;
+    dev_fd = msd_handle->info.dev_handle[ra->lun];
+    if (dev_fd) {
+        dev_ioctl(dev_fd, IOCTL_FLUSH, 0);
+    }
+}
+
+static int msd_write_group(u8 cur_lun, u8 slot, u32 lba, u16 num)
+{
+    u32 err;
+    void *dev_fd = check_disk_status(cur_lun);
+
+    if (!dev_fd) {
+        log_error("write_10 disk offline, dev = %s",
+                  msd_handle->info.dev_name[cur_lun]);
+        return -1;
+    }
+    dev_ioctl(dev_fd, IOCTL_SET_ASYNC_MODE, 0);
+    err = dev_bulk_write(dev_fd, MSD_SLOT_BUF(slot), lba, num);
+    if (err != num) {
+        log_error("write_10 write fail, %d, dev = %s",
+                  err, msd_handle->info.dev_name[cur_lun]);
+        return -1;
+    }
+    return 0;
+}
+
 static void msd_write_10_async(const struct usb_device_t *usb_device, u8 cur_lun, u32 lba, u16 lba_num)
 {
     u32 err = 0;
     u16 num = 0;
-    u8  buf_idx = 0;
+    u16 fill = 0;   //当前组已从usb收到的扇区数
+    u8 slot = 0;
     u32 have_send_stall = FALSE;
     void *dev_fd = NULL;
     while (lba_num) {
@@ -548,35 +630,37 @@ static void msd_write_10_async(const struct usb_device_t *usb_device, u8 cur_lun
         if (msd_handle->csw.uCSWDataResidue >= num * 0x200) {
             msd_handle->csw.uCSWDataResidue -= num * 0x200;
         }
-        err = msd_usb2mcu_64byte_fast(usb_device, msd_handle->msd_buf + buf_idx * MSD_BUFFER_SIZE, num * 0x200);
+        err = msd_usb2mcu_64byte_fast(usb_device, MSD_SLOT_BUF(slot) + fill * 0x200, num * 0x200);
         if (err != num * 0x200) {
             log_error("read usb_err %d, dev = %s",
                       __LINE__, msd_handle->info.dev_name[cur_lun]);
             stall_error(usb_device, 1, MEDIUM_ERROR);
             have_send_stall = TRUE;
+            fill = 0;
             break;
         }
-        dev_fd = check_disk_status(cur_lun);
-        if (dev_fd) {
-            dev_ioctl(dev_fd, IOCTL_SET_ASYNC_MODE, 0);
-            err = dev_bulk_write(dev_fd, msd_handle->msd_buf + buf_idx * MSD_BUFFER_SIZE, lba, num);
-            if (err != num) {
-                log_error("write_10 write fail, %d, dev = %s",
-                          err, msd_handle->info.dev_name[cur_lun]);
-                stall_error(usb_device, 1, MEDIUM_ERROR);
-                have_send_stall = TRUE;
-                break;
-            }
-        } else {
-            log_error("write_10 disk offline, dev = %s",
-                      msd_handle->info.dev_name[cur_lun]);
+        fill += num;
+        lba_num -= num;
+        if (fill < MSD_GROUP_BLOCKS && lba_num) {
+            continue;
+        }
+        //一组收满或命令结束，整组一次多扇区写入，写的同时usb接收下一组
+        if (msd_write_group(cur_lun, slot, lba, fill)) {
             stall_error(usb_device, 1, MEDIUM_ERROR);
             have_send_stall = TRUE;
+            fill = 0;
             break;
         }
-        buf_idx = !buf_idx;
-        lba_num -= num;
-        lba += num;
+        lba += fill;
+        fill = 0;
+        slot = MSD_NEXT_GROUP(slot);
+    }
+    if (fill) {
+        //主机数据提前结束，已收到的扇区照常写入
+        if (msd_write_group(cur_lun, slot, lba, fill)) {
+            stall_error(usb_device, 1, MEDIUM_ERROR);
+            have_send_stall = TRUE;
+        }
     }
     dev_fd = check_disk_status(cur_lun);
     if (dev_fd) {
@@ -594,60 +678,87 @@ static void msd_write_10_async(const struct usb_device_t *usb_device, u8 cur_lun
 int printf_lite(const char *format, ...);
 static void msd_read_10_async(const struct usb_device_t *usb_device, u8 cur_lun, u32 lba, u16 lba_num)
 {
+    struct msd_read_ahead *ra = &msd_handle->ra;
     u32 err = 0;
-    u16 num = 0;
-    u8 buf_idx = 0;
-    u32 last_lba = 0, last_num = 0;
+    u16 num = 0;        //当前组扇区数，设备正在读入slot
+    u16 next_num = 0;
+    u8 slot = 0;
+    u8 sequential;
     void *dev_fd = NULL;
 
     if (lba_num == 0) {
         printf_lite("lba_num == 0\n");
+        msd_read_ahead_drop();
         stall_error(usb_device, 0, 0x02);
         return;
     }
     printf_lite("%s() %d %d", __func__, lba, lba_num);
-    num = lba_num > MSD_BLOCK_SIZE ? MSD_BLOCK_SIZE : lba_num;
+    sequential = ((lba == ra->next_lba) && (cur_lun == ra->lun)) || (lba_num >= MSD_READ_AHEAD_MIN);
+    if (ra->num && (ra->lun != cur_lun || ra->lba != lba)) {
+        msd_read_ahead_drop();
+    }
+    ra->next_lba = lba + lba_num;
+    ra->lun = cur_lun;
+
     dev_fd = check_disk_status(cur_lun);
-    if (dev_fd) {
+    if (dev_fd == NULL) {
+        ra->num = 0;
+        printf_lite("read_10 disk offline, dev = %s\n", msd_handle->info.dev_name[cur_lun]);
+        stall_error(usb_device, 0, MEDIUM_ERROR);
+        return;
+    }
+    if (ra->num) {
+        //命中上一条命令的预读，第一组已在读或已读完
+        slot = ra->slot;
+        num = lba_num > ra->num ? ra->num : lba_num;
+        ra->num = 0;
+    } else {
+        ra->capacity = 0;
+        dev_ioctl(dev_fd, IOCTL_GET_CAPACITY, (u32)&ra->capacity);
+        num = lba_num > MSD_GROUP_BLOCKS ? MSD_GROUP_BLOCKS : lba_num;
         dev_ioctl(dev_fd, IOCTL_SET_ASYNC_MODE, 0);
-        err = dev_bulk_read(dev_fd, msd_handle->msd_buf + buf_idx * MSD_BUFFER_SIZE, lba, num);
+        err = dev_bulk_read(dev_fd, MSD_SLOT_BUF(slot), lba, num);
         if (err != num) {
             printf_lite("read disk error0 = %d, dev = %s\n", err, msd_handle->info.dev_name[cur_lun]);
             stall_error(usb_device, 0, MEDIUM_ERROR);
             return;
         }
-    } else {
-        printf_lite("read_10 disk offline, dev = %s\n", msd_handle->info.dev_name[cur_lun]);
-        stall_error(usb_device, 0, MEDIUM_ERROR);
-        return;
     }
 
     while (lba_num) {
         wdt_clear();
-        last_num = num;
-        last_lba = lba;
-        buf_idx = !buf_idx;
-        lba += num;
-        lba_num -= num;
-        num = lba_num > MSD_BLOCK_SIZE ? MSD_BLOCK_SIZE : lba_num;
+        next_num = lba_num - num > MSD_GROUP_BLOCKS ? MSD_GROUP_BLOCKS : lba_num - num;
         if (msd_handle->csw.uCSWDataResidue == 0) {
             msd_handle->csw.bCSWStatus = 1;
+            dev_ioctl(dev_fd, IOCTL_FLUSH, 0);
             break;
         }
-        if (msd_handle->csw.uCSWDataResidue >= last_num * 0x200) {
-            msd_handle->csw.uCSWDataResidue -= last_num * 0x200;
+        if (msd_handle->csw.uCSWDataResidue >= num * 0x200) {
+            msd_handle->csw.uCSWDataResidue -= num * 0x200;
         }
         dev_fd = check_disk_status(cur_lun);
         if (dev_fd) {
-            if (num) {
+            //启动下一组读(设备内部先等当前组完成)，usb发送当前组的同时设备读下一组
+            if (next_num) {
                 dev_ioctl(dev_fd, IOCTL_SET_ASYNC_MODE, 0);
-                err = dev_bulk_read(dev_fd, msd_handle->msd_buf + buf_idx * MSD_BUFFER_SIZE, lba, num);
-                if (err != num) {
+                err = dev_bulk_read(dev_fd, MSD_SLOT_BUF(MSD_NEXT_GROUP(slot)), lba + num, next_num);
+                if (err != next_num) {
                     printf_lite("read disk error1 = %d, dev = %s",
                                 err, msd_handle->info.dev_name[cur_lun]);
                     stall_error(usb_device, 0, MEDIUM_ERROR);
                     break;
                 }
+            } else if (sequential && (lba + num < ra->capacity)) {
+                //命令最后一组：顺序读时把后续扇区预读进空闲组，跨过csw和下一条cbw
+                ra->lba = lba + num;
+                ra->num = ra->capacity - ra->lba > MSD_GROUP_BLOCKS ? MSD_GROUP_BLOCKS : ra->capacity - ra->lba;
+                ra->slot = MSD_NEXT_GROUP(slot);
+                dev_ioctl(dev_fd, IOCTL_SET_ASYNC_MODE, 0);
+                err = dev_bulk_read(dev_fd, MSD_SLOT_BUF(ra->slot), ra->lba, ra->num);
+                if (err != ra->num) {
+                    ra->num = 0;
+                    dev_ioctl(dev_fd, IOCTL_FLUSH, 0);
+                }
             } else {
                 //async mode last block flush
                 dev_ioctl(dev_fd, IOCTL_FLUSH, 0);
@@ -659,22 +770,22 @@ static void msd_read_10_async(const struct usb_device_t *usb_device, u8 cur_lun,
             break;
         }
 
-        /* u8 *p = msd_handle->msd_buf + !buf_idx * MSD_BUFFER_SIZE; */
-        /* for (int i = 0; i < last_num * 512; i++) {                */
-        /*     p[i] = i;                                             */
-        /* }                                                         */
-
-        err = msd_mcu2usb(usb_device, msd_handle->msd_buf + !buf_idx * MSD_BUFFER_SIZE, last_num * 0x200);
+        err = msd_mcu2usb(usb_device, MSD_SLOT_BUF(slot), num * 0x200);
 
-        if (err != last_num * 0x200) {
+        if (err != num * 0x200) {
             printf_lite("read_10 data transfer err %d, dev = %s",
                         __LINE__, msd_handle->info.dev_name[cur_lun]);
             stall_error(usb_device, 0, 0x05);
-            if (num) {
+            if (next_num || ra->num) {
+                ra->num = 0;
                 dev_ioctl(dev_fd, IOCTL_FLUSH, 0);
             }
             break;
         }
+        slot = MSD_NEXT_GROUP(slot);
+        lba += num;
+        lba_num -= num;
+        num = next_num;
     }
 }
 #endif
@@ -878,7 +989,9 @@ static void stop_start()
 
 u32 private_scsi_cmd(const struct usb_device_t *usb_device, struct usb_scsi_cbw *cbw);
 
+#ifndef USB_MSD_HOST
 #include "usb/device/kugou/kugou_protocol.h"
+#endif
 void kg_set_disk_status(u32 lun, u8 status)
 {
     printf("msd.c kg_set_disk_status\n");
@@ -893,6 +1006,11 @@ void USB_MassStorage(const struct usb_device_t *usb_device)
         return;
     }
     /* log_debug("opcode %x", msd_handle->cbw.operationCode); */
+#if USB_MSD_BULK_DEV_USE_ASYNC
+    if (msd_handle->cbw.operationCode != READ_10) {
+        msd_read_ahead_drop();
+    }
+#endif
     if (private_scsi_cmd(usb_device, &(msd_handle->cbw))) {
         msd_handle->info.bError = 0;
         msd_handle->csw.uCSWDataResidue = 0;
@@ -1018,6 +1136,9 @@ u32 msd_unregister_all()
     u32 err;
     int i;
     if (msd_handle) {
+#if USB_MSD_BULK_DEV_USE_ASYNC
+        msd_read_ahead_drop();
+#endif
         for (i = 0; i < __get_max_msd_dev(); i++) {
             if (msd_handle->info.dev_handle[i]) {
                 err = dev_close(msd_handle->info.dev_handle[i]);
@@ -1039,7 +1160,7 @@ u32 msd_register(const usb_dev usb_id)
             return -1;
         }
 #if USB_MSD_BULK_DEV_USE_ASYNC
-        msd_handle->msd_buf = (u8 *)malloc(MSD_BUFFER_SIZE * 2);
+        msd_handle->msd_buf = (u8 *)malloc(MSD_RING_SIZE);
 #else
         msd_handle->msd_buf = (u8 *)malloc(MSD_BUFFER_SIZE);
 #endif
@@ -1063,6 +1184,9 @@ u32 msd_register(const usb_dev usb_id)
 u32 msd_release()
 {
     if (msd_handle) {
+#if USB_MSD_BULK_DEV_USE_ASYNC
+        msd_read_ahead_drop();
+#endif
         for (int i = 0; i < __get_max_msd_dev(); i++) {
             void *dev_fd = msd_handle->info.dev_handle[i] ;
             if (dev_fd) {
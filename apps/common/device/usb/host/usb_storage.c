@@ -1150,6 +1150,292 @@ __exit:
     return 0;
 }
 #endif
+#if UDISK_SECTOR_CACHE_ENABLE
+#define UDISK_CACHE_LINE_SIZE   (UDISK_CACHE_LINE_SECTORS * 512)
+
+/**
+ * @brief udisk_cache_reset 清空缓存行和顺序流记录
+ *
+ * @param disk
+ */
+static void udisk_cache_reset(struct mass_storage *disk)
+{
+    struct udisk_cache *cache = &disk->cache;
+
+    for (int i = 0; i < UDISK_CACHE_LINE_NUM; i++) {
+        cache->line[i].sectors = 0;
+        cache->line[i].stamp = 0;
+    }
+    for (int i = 0; i < UDISK_CACHE_STREAM_NUM; i++) {
+        cache->stream_next[i] = (u32) - 1;
+    }
+}
+
+static void udisk_cache_open(struct mass_storage *disk)
+{
+    struct udisk_cache *cache = &disk->cache;
+
+    if (!cache->mem) {
+        cache->mem = malloc(UDISK_CACHE_LINE_SIZE * UDISK_CACHE_LINE_NUM);
+        if (!cache->mem) {
+            log_error("udisk cache malloc fail, run without cache");
+            return;
+        }
+    }
+    for (int i = 0; i < UDISK_CACHE_LINE_NUM; i++) {
+        cache->line[i].buf = cache->mem + i * UDISK_CACHE_LINE_SIZE;
+    }
+    memset(&cache->stat, 0, sizeof(cache->stat));
+    cache->stamp = 0;
+    udisk_cache_reset(disk);
+}
+
+static void udisk_cache_close(struct mass_storage *disk)
+{
+    struct udisk_cache *cache = &disk->cache;
+
+    if (cache->mem) {
+        log_info("udisk cache hit:%d miss:%d prefetch:%d",
+                 cache->stat.hit, cache->stat.miss, cache->stat.prefetch);
+        free(cache->mem);
+        cache->mem = NULL;
+    }
+}
+
+/**
+ * @brief usb_stor_get_cache_stat 获取扇区缓存统计
+ *
+ * @param stat 统计结构体指针
+ *
+ * @return 0:成功  其他:U盘未打开或缓存未开启
+ */
+int usb_stor_get_cache_stat(struct udisk_cache_stat *stat)
+{
+    struct mass_storage *disk = udisk_inf.dev.disk;
+    int ret = -1;
+
+    //关闭后互斥量已删除，不能再pend
+    if (!stat || disk->dev_status == DEV_IDLE) {
+        return -1;
+    }
+    if (os_mutex_pend(&disk->mutex, UDISK_MUTEX_TIMEOUT)) {
+        return -1;
+    }
+    if (disk->cache.mem) {
+        memcpy(stat, &disk->cache.stat, sizeof(*stat));
+        ret = 0;
+    }
+    os_mutex_post(&disk->mutex);
+    return ret;
+}
+
+/**
+ * @brief udisk_cache_invalidate 写入时作废与写入范围重叠的缓存行(缓存只读，不需要回写)
+ */
+static void udisk_cache_invalidate(struct mass_storage *disk, u32 lba, u32 num_lba)
+{
+    struct udisk_cache_line *line = disk->cache.line;
+
+    for (int i = 0; i < UDISK_CACHE_LINE_NUM; i++, line++) {
+        if (line->sectors && (lba < line->lba + line->sectors) && (line->lba < lba + num_lba)) {
+            line->sectors = 0;
+        }
+    }
+}
+
+static struct udisk_cache_line *udisk_cache_find(struct mass_storage *disk, u32 line_lba)
+{
+    struct udisk_cache_line *line = disk->cache.line;
+
+    for (int i = 0; i < UDISK_CACHE_LINE_NUM; i++, line++) {
+        if (line->sectors && line->lba == line_lba) {
+            return line;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief udisk_cache_victim 选择替换行：优先空行，否则最久未访问的行
+ *
+ * @param since 访问时间晚于since的行(本次已选中的行)不参与选择
+ */
+static struct udisk_cache_line *udisk_cache_victim(struct mass_storage *disk, u32 since)
+{
+    struct udisk_cache_line *line = disk->cache.line;
+    struct udisk_cache_line *victim = NULL;
+
+    for (int i = 0; i < UDISK_CACHE_LINE_NUM; i++, line++) {
+        if ((s32)(line->stamp - since) > 0) {
+            continue;
+        }
+        if (!line->sectors) {
+            return line;
+        }
+        if (!victim || (s32)(line->stamp - victim->stamp) < 0) {
+            victim = line;
+        }
+    }
+    return victim;
+}
+
+/**
+ * @brief udisk_cache_stream_hit 判断本次读是否接在某个顺序流之后，并更新顺序流记录
+ *
+ * @return 1:顺序流  0:新的访问位置
+ */
+static int udisk_cache_stream_hit(struct mass_storage *disk, u32 lba, u32 num_lba)
+{
+    struct udisk_cache *cache = &disk->cache;
+
+    for (int i = 0; i < UDISK_CACHE_STREAM_NUM; i++) {
+        if (cache->stream_next[i] == lba) {
+            cache->stream_next[i] = lba + num_lba;
+            return 1;
+        }
+    }
+    cache->stream_next[cache->stream_victim] = lba + num_lba;
+    if (++cache->stream_victim >= UDISK_CACHE_STREAM_NUM) {
+        cache->stream_victim = 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief udisk_cache_fill 一条READ_10读入从line_lba开始的line_num行(遇到已缓存的行截止)
+ *
+ * @return 读入的第一行，失败返回NULL
+ */
+static struct udisk_cache_line *udisk_cache_fill(struct device *device, u32 block_size, u32 line_lba, u32 line_num, u32 cap_lba)
+{
+    struct usb_host_device *host_dev = device_to_usbdev(device);
+    struct mass_storage *disk = host_device2disk(host_dev);
+    struct udisk_cache *cache = &disk->cache;
+    const u32 txmaxp = usb_stor_txmaxp(disk);
+    const u32 rxmaxp = usb_stor_rxmaxp(disk);
+    struct udisk_cache_line *fill[UDISK_CACHE_READ_AHEAD + 1];
+    u32 since = cache->stamp;
+    u32 sectors = 0;
+    u32 lba;
+    int ret;
+    u32 i;
+
+    for (i = 0; i < line_num; i++) {
+        lba = line_lba + i * UDISK_CACHE_LINE_SECTORS;
+        if (lba >= cap_lba || (i && udisk_cache_find(disk, lba))) {
+            break;
+        }
+        fill[i] = udisk_cache_victim(disk, since);
+        fill[i]->stamp = ++cache->stamp;
+        sectors += MIN(UDISK_CACHE_LINE_SECTORS, cap_lba - lba);
+    }
+    line_num = i;
+    for (i = 0; i < line_num; i++) {
+        fill[i]->sectors = 0;
+        fill[i]->lba = line_lba + i * UDISK_CACHE_LINE_SECTORS;
+    }
+    cache->stat.prefetch += line_num - 1;
+
+    disk->dev_status = DEV_READ;
+    disk->suspend_cnt = 0;
+    usb_init_cbw(device, USB_DIR_IN, READ_10, sectors * 512);
+    disk->cbw.bCBWLength = 0xA;
+
+    lba = cpu_to_be32(line_lba / (block_size / 512));
+    memcpy(disk->cbw.lba, &lba, sizeof(lba));
+
+    disk->cbw.LengthH = HIBYTE(sectors / (block_size / 512));
+    disk->cbw.LengthL = LOBYTE(sectors / (block_size / 512));
+    //cbw
+    ret = usb_bulk_only_send(device,
+                             udisk_ep.host_epout,
+                             txmaxp,
+                             udisk_ep.target_epout,
+                             (u8 *)&disk->cbw,
+                             sizeof(struct usb_scsi_cbw));
+    if (ret < DEV_ERR_NONE) {
+        log_error("%s:%d\n", __func__, __LINE__);
+        goto __exit;
+    }
+    //data 按行接收到各自的缓存行
+    for (i = 0; i < line_num; i++) {
+        u32 len = MIN(UDISK_CACHE_LINE_SECTORS, cap_lba - fill[i]->lba) * 512;
+        ret = usb_bulk_only_receive(device,
+                                    udisk_ep.host_epin,
+                                    rxmaxp,
+                                    udisk_ep.target_epin,
+                                    fill[i]->buf,
+                                    len);
+        if (ret < DEV_ERR_NONE) {
+            log_error("%s:%d\n", __func__, __LINE__);
+            goto __exit;
+        }
+    }
+    //csw
+    ret = _usb_stro_read_csw(device);
+    if (ret < DEV_ERR_NONE || disk->csw.bCSWStatus) {
+        log_error("%s:%d\n", __func__, __LINE__);
+        goto __exit;
+    }
+    for (i = 0; i < line_num; i++) {
+        fill[i]->sectors = MIN(UDISK_CACHE_LINE_SECTORS, cap_lba - fill[i]->lba);
+    }
+    disk->dev_status = DEV_OPEN;
+    return fill[0];
+
+__exit:
+    if (disk->dev_status != DEV_CLOSE) {
+        disk->dev_status = DEV_OPEN;
+    }
+    return NULL;
+}
+
+/**
+ * @brief _usb_stor_cache_read 经扇区缓存读取，按行拆分请求
+ *
+ * @return 成功返回num_lba，失败返回0
+ */
+static int _usb_stor_cache_read(struct device *device, u32 block_size, void *pBuf, u32 num_lba, u32 lba)
+{
+    struct usb_host_device *host_dev = device_to_usbdev(device);
+    struct mass_storage *disk = host_device2disk(host_dev);
+    struct udisk_cache *cache = &disk->cache;
+    const u32 curlun = usb_stor_get_curlun(disk);
+    const u32 cap_lba = disk->capacity[curlun].block_num * (block_size / 512);
+    struct udisk_cache_line *line;
+    u32 line_lba, offset, len;
+    u32 ahead;
+
+    if (lba + num_lba > cap_lba) {
+        return -DEV_ERR_OVER_CAPACITY;
+    }
+    //顺序流未命中时带预读，随机访问只读一行
+    ahead = udisk_cache_stream_hit(disk, lba, num_lba) ? UDISK_CACHE_READ_AHEAD : 0;
+    len = num_lba;
+    while (len) {
+        line_lba = lba & ~(UDISK_CACHE_LINE_SECTORS - 1);
+        offset = lba - line_lba;
+        line = udisk_cache_find(disk, line_lba);
+        if (line) {
+            cache->stat.hit++;
+            line->stamp = ++cache->stamp;
+        } else {
+            cache->stat.miss++;
+            line = udisk_cache_fill(device, block_size, line_lba, 1 + ahead, cap_lba);
+            if (!line) {
+                log_error("%s---%d", __func__, __LINE__);
+                return 0;
+            }
+        }
+        u32 n = MIN(len, UDISK_CACHE_LINE_SECTORS - offset);
+        memcpy(pBuf, line->buf + offset * 512, n * 512);
+        pBuf = (u8 *)pBuf + n * 512;
+        lba += n;
+        len -= n;
+    }
+    return num_lba;
+}
+#endif
 /**
  * @brief usb_stor_read 从U盘的lba扇区读取num_lba个扇区
  *
@@ -1179,6 +1465,11 @@ static int _usb_stor_read(struct device *device, void *pBuf, u32 num_lba, u32 lb
 
     if (disk->capacity[curlun].block_size > 512) {
         // 扇区大于512Byte
+#if UDISK_SECTOR_CACHE_ENABLE
+        if (disk->cache.mem && disk->capacity[curlun].block_size <= UDISK_CACHE_LINE_SIZE) {
+            return _usb_stor_cache_read(device, disk->capacity[curlun].block_size, pBuf, num_lba, lba);
+        }
+#endif
         return _usb_stor_read_big_block(device, disk->capacity[curlun].block_size, pBuf, num_lba, lba);
     }
 
@@ -1190,6 +1481,15 @@ static int _usb_stor_read(struct device *device, void *pBuf, u32 num_lba, u32 lb
         return _usb_stro_read_async(device, pBuf, num_lba, lba);
     }
 #endif
+#if UDISK_SECTOR_CACHE_ENABLE
+    //整行以上的大块读直接读到pBuf，缓存只读不写回，直接读不影响一致性
+    if (disk->cache.mem) {
+        if (num_lba < UDISK_CACHE_LINE_SECTORS) {
+            return _usb_stor_cache_read(device, 512, pBuf, num_lba, lba);
+        }
+        udisk_cache_stream_hit(disk, lba, num_lba);
+    }
+#endif
 
     ret = _usb_stro_read_cbw_request(device, num_lba, lba);
     if (ret < DEV_ERR_NONE) {
@@ -1294,6 +1594,10 @@ static int _usb_stor_write(struct device *device, void *pBuf,  u32 num_lba, u32
     /* u32 tx_len = num_lba * disk->capacity[curlun].block_size; */
     u32 tx_len = num_lba * 512;  //filesystem uses the fixed BLOCK_SIZE
 
+#if UDISK_SECTOR_CACHE_ENABLE
+    udisk_cache_invalidate(disk, lba, num_lba);
+#endif
+
 #if (UDISK_READ_BIGBLOCK_ASYNC_ENABLE || UDISK_READ_512_ASYNC_ENABLE)
     /* r_printf("write lba : %d %d txlen:%d\n",lba,disk->remain_len,tx_len); */
     /* 确保预读read剩余的包读完，才开始写 */
@@ -1686,6 +1990,9 @@ static int usb_stor_ioctrl(struct device *device, u32 cmd, u32 arg)
             return -EINVAL;
         }
         usb_stor_set_curlun(disk, arg);
+#if UDISK_SECTOR_CACHE_ENABLE
+        udisk_cache_reset(disk);
+#endif
         ret = usb_stor_read_capacity(device);
         if (ret < 0) {
             log_error("usb disk unit%d is not ready", curlun);
@@ -1893,6 +2200,9 @@ static int usb_stor_open(const char *name, struct device **device, void *arg)
         log_error("usb_stor_init err %d\n", ret);
         return -ENODEV;
     }
+#if UDISK_SECTOR_CACHE_ENABLE
+    udisk_cache_open(disk);
+#endif
     log_debug("device %x", (u32)*device);
 
 
@@ -1949,6 +2259,9 @@ static int usb_stor_close(struct device *device)
             disk->udisk_512_buf = NULL;
         }
 
+#endif
+#if UDISK_SECTOR_CACHE_ENABLE
+        udisk_cache_close(disk);
 #endif
     }
     return DEV_ERR_NONE;
@@ -34,6 +34,16 @@
 
 #define UDISK_READ_ASYNC_BLOCK_NUM  (16) //预读扇区数
 
+/* u盘扇区缓存配置(同步读方式下生效，位于dev_bulk_read之下)
+ * 多行缓存按LRU替换，同时跟踪多个顺序读流，顺序流未命中时一条READ_10合并读入多行
+ * 播放大码率文件时浏览目录不会打断播放流的预读数据 */
+#define  UDISK_SECTOR_CACHE_ENABLE           1
+#define  UDISK_CACHE_LINE_SECTORS            8   //每行512byte扇区数(2的幂)，不小于大扇区盘的物理扇区
+#define  UDISK_CACHE_LINE_NUM                4   //缓存行数
+#define  UDISK_CACHE_STREAM_NUM              2   //同时跟踪的顺序读流数
+#define  UDISK_CACHE_READ_AHEAD              2   //顺序流未命中时额外预读的行数，需小于UDISK_CACHE_LINE_NUM
+/****************************/
+
 /**@enum    usb_sta
   * @brief  USB设备当前状态
   */
@@ -64,6 +74,39 @@ struct udisk_end_desc {
 
 #define ENABLE_DISK_HOTPLUG  0
 
+#if UDISK_SECTOR_CACHE_ENABLE
+/**@struct  udisk_cache_stat
+  * @brief  扇区缓存统计(按缓存行计数)
+  */
+struct udisk_cache_stat {
+    u32 hit; ///<命中行数
+    u32 miss; ///<未命中行数
+    u32 prefetch; ///<顺序流额外预读的行数
+};
+
+/**@struct  udisk_cache_line
+  * @brief  扇区缓存行
+  */
+struct udisk_cache_line {
+    u32 lba; ///<行起始扇区(512byte单位，按行对齐)
+    u32 stamp; ///<最近访问时间，LRU替换用
+    u8 *buf; ///<行数据
+    u8 sectors; ///<有效扇区数，0表示空行
+};
+
+/**@struct  udisk_cache
+  * @brief  扇区缓存
+  */
+struct udisk_cache {
+    struct udisk_cache_line line[UDISK_CACHE_LINE_NUM]; ///<缓存行
+    u32 stream_next[UDISK_CACHE_STREAM_NUM]; ///<各顺序流下一次预期读取的扇区
+    u8 stream_victim; ///<下一个被替换的顺序流
+    u32 stamp; ///<访问计数
+    u8 *mem; ///<缓存行内存，NULL表示缓存不可用
+    struct udisk_cache_stat stat; ///<统计
+};
+#endif
+
 /**@struct  mass_storage
   * @brief  mass_storage协议所使用的相关变量
   */
@@ -91,6 +134,9 @@ struct mass_storage {
     u8 *udisk_512_buf; ///<U盘512K大小BUFFER指针
     u32 async_prev_lba; ///<异步模式上一次地址
 #endif
+#if UDISK_SECTOR_CACHE_ENABLE
+    struct udisk_cache cache; ///<扇区缓存
+#endif
 #if ENABLE_DISK_HOTPLUG
     u8 media_sta_cur; ///<当前媒介状态                //for card reader, card removable
     u8 media_sta_prev; ///<上次媒介状态
@@ -128,4 +174,16 @@ int usb_msd_parser(struct usb_host_device *host_dev, u8 interface_num, const u8
   */
 int _usb_stor_async_wait_sem(struct usb_host_device *host_dev);
 
+#if UDISK_SECTOR_CACHE_ENABLE
+/**@brief   获取扇区缓存统计
+  * @param[out]  stat 统计结构体指针
+  * @return     0:成功  其他:缓存未开启
+  * @par    示例：
+  * @code
+  * usb_stor_get_cache_stat(&stat);
+  * @encode
+  */
+int usb_stor_get_cache_stat(struct udisk_cache_stat *stat);
+#endif
+
 #endif
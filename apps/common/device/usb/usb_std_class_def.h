@@ -30,6 +30,11 @@
 #ifndef MSD_STR_INDEX
 #define MSD_STR_INDEX               7
 #endif
+#ifndef MSD_BUFFER_NUM
+//读卡器环形缓存块数(偶数)，每块512byte，固定分成2组，设备读写一组的同时usb收发另一组
+//默认8块即2组*4块，设备一次读写4个扇区；改大只加大每组扇区数，不增加组数
+#define MSD_BUFFER_NUM              8
+#endif
 
 ///////////HID class
 #ifndef HID_EP_IN
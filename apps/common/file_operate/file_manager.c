@@ -169,6 +169,7 @@ int file_manager_delete_deal(char *path, char *param, u8 dir_flag)
     struct vfscan *fsn = NULL;
     FILE *d_f = NULL;
 
+    dev_manager_scan_disk_cache_free(NULL);//删除文件后缓存的扫盘信息失效
     fsn = fscan(path, param, 9);
     if (fsn == NULL) {
         r_printf(">>>[test]:err!!!!!! fsacn fsn fail\n");
@@ -288,6 +289,7 @@ int file_manager_division_file(FILE *f, char *dev_logo, char *file_name, u32 nam
         r_printf(">>>[test]:errr!!!!!!!!! not find dev\n");
         return -1;
     }
+    dev_manager_scan_disk_cache_free(dev);//新建文件后缓存的扫盘信息失效
     char *root_path = dev_manager_get_root_path(dev);
 
     /****************分割文件*********************/
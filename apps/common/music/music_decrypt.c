@@ -1,9 +1,15 @@
 
+#ifdef MUSIC_DECRYPT_HOST
+/*PC上只回放cryptanalysis_buff(tools/host_test)*/
+#include "music/music_decrypt.h"
+#define TCFG_DEC_DECRYPT_ENABLE		1
+#else
 #include "system/app_core.h"
 #include "system/includes.h"
 #include "app_config.h"
 #include "music/music_decrypt.h"
 #include "system/fs/fs.h"
+#endif
 
 #if (TCFG_DEC_DECRYPT_ENABLE)
 
@@ -14,7 +20,9 @@
 #define LOG_INFO_ENABLE
 /* #define LOG_DUMP_ENABLE */
 #define LOG_CLI_ENABLE
+#ifndef MUSIC_DECRYPT_HOST
 #include "debug.h"
+#endif
 
 /*----------------------------------------------------------------------------*/
 /**@brief  解密读使能开关
@@ -38,75 +46,48 @@ static void cipher_ctl(CIPHER *pcipher, u8 ctl)
 #define ALIN_SIZE	4
 void cryptanalysis_buff(CIPHER *pcipher, void *buf, u32 faddr, u32 len)
 {
-    u32 i;
-    u8 j;
-    u8	head_rem;//
-    u8  tail_rem;//
-    u32 len_ali;
-
-    u8  *buf_1b_ali;
-    u8  *cipher_code;
+    u8  *p8;
+    u32 *p32;
+    u32 key;
+    u32 rot;
 
-    cipher_code = (u8 *)&pcipher->cipher_code;
-
-    if (!pcipher->cipher_enable) {
+    if (!pcipher->cipher_enable || !len) {
         return;
     }
-    /* log_info("----faddr = %d \n",faddr); */
-    /* put_buf(buf,len); */
-    /* log_info("buf_addr = %d \n", buf); */
 
-    head_rem = ALIN_SIZE - (faddr % ALIN_SIZE);
-    if (head_rem == ALIN_SIZE) {
-        head_rem = 0;
-    }
-    if (head_rem > len) {
-        head_rem = len;
+    /*
+     *文件偏移faddr处的字节与cipher_code的第(faddr % 4)个字节异或
+     *先按字节处理到buf地址4字节对齐，再把密钥按当前偏移旋转一次，整字异或
+     */
+    p8 = (u8 *)buf;
+    key = pcipher->cipher_code;
+    while (((unsigned long)p8 & (ALIN_SIZE - 1)) && len) {
+        *p8++ ^= (u8)(key >> ((faddr % ALIN_SIZE) * 8));
+        faddr++;
+        len--;
     }
 
-    if (len - head_rem) {
-        tail_rem = (faddr + len) % ALIN_SIZE;
-    } else {
-        tail_rem = 0;
+    rot = (faddr % ALIN_SIZE) * 8;
+    if (rot) {
+        key = (key >> rot) | (key << (32 - rot));
     }
-    /* log_info("head_rem = %d tail_rem = %d \n", head_rem, tail_rem); */
-    /* log_info("deal_head_buf\n"); */
-    buf_1b_ali = buf;
-    j = 3;
-    for (i = head_rem; i > 0; i--) {
-        buf_1b_ali[i - 1] ^= cipher_code[j--];
-        /* log_info("i = %d \n", i - 1); */
-        /* log_info("buf_1b_ali[i] = %x \n", buf_1b_ali[i - 1]); */
+    p32 = (u32 *)p8;
+    for (; len >= 16; len -= 16) {
+        p32[0] ^= key;
+        p32[1] ^= key;
+        p32[2] ^= key;
+        p32[3] ^= key;
+        p32 += 4;
     }
-    /* log_info("\n\n-----------TEST_HEAD-----------------"); */
-    /* put_buf(buf_1b_ali, head_rem); */
-    /* log_info("deal_main_buf\n"); */
-    buf_1b_ali = buf;
-    buf_1b_ali = (u8 *)(buf_1b_ali + head_rem);
-    len_ali = len - head_rem - tail_rem;
-    /* log_info("len_ali = %d \n", len_ali); */
-    /* log_info("buf_1b_ali = %d \n", buf_1b_ali); */
-    for (i = 0; i < (len_ali / 4); i++) {
-        buf_1b_ali[0 + i * 4] ^= cipher_code[0];
-        buf_1b_ali[1 + i * 4] ^= cipher_code[1];
-        buf_1b_ali[2 + i * 4] ^= cipher_code[2];
-        buf_1b_ali[3 + i * 4] ^= cipher_code[3];
+    for (; len >= 4; len -= 4) {
+        *p32++ ^= key;
     }
-    /* log_info("\n\n-----------TEST_MAIN-----------------"); */
-    /* put_buf(buf_1b_ali, len_ali); */
 
-    /* log_info("deal_tail_buf\n"); */
-    buf_1b_ali = buf;
-    buf_1b_ali += len - tail_rem;
-    j = 0;
-    for (i = 0 ; i < tail_rem; i++) {
-        buf_1b_ali[i] ^= cipher_code[j++];
+    p8 = (u8 *)p32;
+    while (len--) {
+        *p8++ ^= (u8)key;
+        key >>= 8;
     }
-    /* log_info("\n\n-----------TEST_TAIL-----------------"); */
-    /* put_buf(buf_1b_ali, tail_rem); */
-
-    /* log_info("\n\n-----------TEST-----------------"); */
-    /* put_buf(buf,len); */
 }
 
 /*----------------------------------------------------------------------------*/
@@ -116,6 +97,7 @@ void cryptanalysis_buff(CIPHER *pcipher, void *buf, u32 faddr, u32 len)
   @note   void cipher_check_decode_file(void *file)
  */
 /*----------------------------------------------------------------------------*/
+#ifndef MUSIC_DECRYPT_HOST
 void cipher_check_decode_file(CIPHER *pcipher, void *file)
 {
     int rlen;
@@ -154,6 +136,7 @@ __check_ext:
     }
     cipher_ctl(pcipher, 0);
 }
+#endif
 
 /*----------------------------------------------------------------------------*/
 /**@brief  解密读初始化
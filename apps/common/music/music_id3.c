@@ -1,8 +1,15 @@
+#ifdef MUSIC_ID3_HOST
+/*PC上回放标签解析(tools/host_test)，文件接口和log由测试程序提供*/
+#include "music/music_id3.h"
+#define TCFG_DEC_ID3_V1_ENABLE		1
+#define TCFG_DEC_ID3_V2_ENABLE		1
+#else
 #include "system/app_core.h"
 #include "system/includes.h"
 #include "app_config.h"
 #include "music/music_id3.h"
 #include "system/fs/fs.h"
+#endif
 
 #if ((TCFG_DEC_ID3_V1_ENABLE) || (TCFG_DEC_ID3_V2_ENABLE))
 
@@ -13,7 +20,9 @@
 #define LOG_INFO_ENABLE
 /* #define LOG_DUMP_ENABLE */
 #define LOG_CLI_ENABLE
+#ifndef MUSIC_ID3_HOST
 #include "debug.h"
+#endif
 
 #define ID3_ANALYSIS_EN		1	// ID3解析
 
@@ -41,15 +50,16 @@ struct id3_v2_frame {
     char flags[2];		// 标志
 };
 
-u8 tpe1_data[512];
-u32 tpe1_data_len;
-
 #define ID3_SIZEOF_ALIN(var,al)     ((((var)+(al)-1)/(al))*(al))
 #define ID3_V1_HEADER_SIZE			(128) // sizeof(struct id3_v1_hdl)
 #define ID3_V2_HEADER_SIZE			(10)  // sizeof(struct id3_v2_hdl)
 #define ID3_V2_HEADER_SIZE_MAX		(1024 * 2)
 
 #define ID3_V2_FRAME_SIZE			(10)  // sizeof(struct id3_v2_frame)
+#define ID3_V22_FRAME_SIZE			(6)   // id3v2.2帧头:3字节ID+3字节大小
+
+#define ID3_READ_BUF_SIZE			(1024) // 标签区顺序读缓存
+#define ID3_TEXT_FRAME_MAX			(ID3_TAG_TEXT_LEN * 2 + 3) // 文本帧最多读取的长度(编码字节+BOM+utf16)
 
 static u8 id3_v1_match(u8 *buf)
 {
@@ -108,74 +118,22 @@ static void id3_v1_analysis(MP3_ID3_OBJ *obj)
     log_info("genre:%d \n", hdl->genre);
 }
 
-static const u8 ID3_V2_FRAME_ID[][4] = {
-    "TIT2",	// 标题
-    "TPE1",	// 作者
-    "TALB",	// 专辑
-    "TYER",	// 年代
-    "TCON",	// 类型
-    "COMM",	// 备注
-};
-
 static void id3_v2_analysis(void *file, void *buf)
 {
-#define FRAME_DAT_MAX		512
-    u8 *frame_dat = malloc(FRAME_DAT_MAX);
-    u8  frame_hdl[ID3_V2_FRAME_SIZE];
-    u32 frame_len;
-    struct id3_v2_hdl *hdl = (struct id3_v2_hdl *)buf;
-    /* log_info("header:%s \n", hdl->header); */
+    ID3_TAG_INFO *info = zalloc(sizeof(ID3_TAG_INFO));
 
-    if (!frame_dat) {
+    if (!info) {
         return ;
     }
-
-    u32 addr = ID3_V2_HEADER_SIZE;
-    u32 addr_end = id3v2_get_tag_len(buf) + ID3_V2_HEADER_SIZE;
-    log_info("frame total len:0x%x ", addr_end);
-    while (addr < addr_end) {
-        fseek(file, addr, SEEK_SET);
-        fread(file, frame_hdl, ID3_V2_FRAME_SIZE);
-
-        int idx;
-        struct id3_v2_frame *frame = (struct id3_v2_frame *)frame_hdl;
-        frame_len = (((u32)frame->size[0]) << 24) + (((u32)frame->size[1]) << 16) + (((u32)frame->size[2]) << 8) + (u32)frame->size[3];
-
-        log_info_hexdump(frame, ID3_V2_FRAME_SIZE);
-        log_info("frame ID:%s ", frame->frameID);
-        log_info("frame len:0x%x ", frame_len);
-        log_info("addr :0x%x ", addr);
-
-        if (!frame_len) {
-            break;
-        }
-        if (frame_len <= FRAME_DAT_MAX) {
-            memset(frame_dat, 0, FRAME_DAT_MAX);
-            fread(file, frame_dat, frame_len);
-        }
-
-        for (idx = 0; idx < sizeof(ID3_V2_FRAME_ID) / 4; idx++) {
-            if (!memcmp(frame->frameID, ID3_V2_FRAME_ID[idx], 4)) {
-                log_info("find frameID \n");
-                break;
-            }
-        }
-        if (frame_len <= FRAME_DAT_MAX) {
-            log_info("frame dat:%s, \n", frame_dat);
-            log_info_hexdump(frame_dat, frame_len);
-        }
-
-        if (!memcmp(frame->frameID, "TPE1", 4)) {
-            frame_dat++;
-            sprintf(tpe1_data, "%s", frame_dat);
-            tpe1_data_len = frame_len;
-            log_info_hexdump(tpe1_data, tpe1_data_len - 1);
-            frame_dat--;
-        }
-        addr += ID3_V2_FRAME_SIZE + frame_len;
+    if (!id3_tag_parse(file, info)) {
+        log_info("ver:%d \n", info->ver);
+        log_info("title:%s \n", info->text[ID3_TAG_TITLE]);
+        log_info("artist:%s \n", info->text[ID3_TAG_ARTIST]);
+        log_info("album:%s \n", info->text[ID3_TAG_ALBUM]);
+        log_info("year:%s \n", info->text[ID3_TAG_YEAR]);
+        log_info("genre:%s \n", info->text[ID3_TAG_GENRE]);
     }
-
-    free(frame_dat);
+    free(info);
 }
 #endif
 
@@ -305,5 +263,402 @@ __id3_v2_err:
     return NULL;
 }
 
+/*
+ *id3标签解析
+ *标签区用ID3_READ_BUF_SIZE的缓存顺序读，一次读取覆盖多个帧，
+ *只在缓存里放不下帧头或需要的文本时才重新定位读取；
+ *APIC等不需要的帧直接跳过，不读取帧内容
+ */
+struct id3_reader {
+    void *file;
+    u8  *buf;
+    u32 buf_addr;	// buf[0]对应的文件地址
+    u32 buf_len;	// buf有效数据长度
+    u32 fptr;		// 文件当前读位置
+    u32 end;		// 可读区域结束地址
+};
+
+static const char ID3_V2_FRAME_ID[][ID3_TAG_FIELD_NUM][4] = {
+    {"TT2", "TP1", "TAL", "TYE", "TCO"},		// id3v2.2
+    {"TIT2", "TPE1", "TALB", "TYER", "TCON"},	// id3v2.3/id3v2.4
+};
+
+static u8 *id3_reader_get(struct id3_reader *rd, u32 addr, u32 len)
+{
+    int rlen;
+
+    if ((addr >= rd->buf_addr) && (addr + len <= rd->buf_addr + rd->buf_len)) {
+        return rd->buf + (addr - rd->buf_addr);
+    }
+    if ((len > ID3_READ_BUF_SIZE) || (addr + len > rd->end)) {
+        return NULL;
+    }
+    rlen = rd->end - addr;
+    if (rlen > ID3_READ_BUF_SIZE) {
+        rlen = ID3_READ_BUF_SIZE;
+    }
+    if (addr != rd->fptr) {
+        fseek(rd->file, addr, SEEK_SET);
+    }
+    rd->buf_len = 0;
+    rlen = fread(rd->file, rd->buf, rlen);
+    if ((rlen <= 0) || (rlen > ID3_READ_BUF_SIZE)) {
+        return NULL;
+    }
+    rd->buf_addr = addr;
+    rd->buf_len = rlen;
+    rd->fptr = addr + rlen;
+    if (rlen < len) {
+        return NULL;
+    }
+    return rd->buf;
+}
+
+static u32 id3_put_utf8(char *dst, u32 pos, u32 size, u32 c)
+{
+    u32 n = (c < 0x80) ? 1 : (c < 0x800) ? 2 : (c < 0x10000) ? 3 : 4;
+
+    if (pos + n >= size) {
+        return 0;
+    }
+    switch (n) {
+    case 1:
+        dst[pos] = c;
+        break;
+    case 2:
+        dst[pos] = 0xc0 | (c >> 6);
+        dst[pos + 1] = 0x80 | (c & 0x3f);
+        break;
+    case 3:
+        dst[pos] = 0xe0 | (c >> 12);
+        dst[pos + 1] = 0x80 | ((c >> 6) & 0x3f);
+        dst[pos + 2] = 0x80 | (c & 0x3f);
+        break;
+    default:
+        dst[pos] = 0xf0 | (c >> 18);
+        dst[pos + 1] = 0x80 | ((c >> 12) & 0x3f);
+        dst[pos + 2] = 0x80 | ((c >> 6) & 0x3f);
+        dst[pos + 3] = 0x80 | (c & 0x3f);
+        break;
+    }
+    return n;
+}
+
+/*
+ *文本帧解码，src[0]为编码方式:0:ISO-8859-1, 1:带BOM的utf16, 2:utf16be, 3:utf8
+ *返回1表示原样拷贝(ISO-8859-1，国内文件多为本地编码)
+ */
+static u8 id3_text_decode(const u8 *src, u32 len, char *dst, u32 size)
+{
+    u32 pos = 0;
+    u32 n;
+    u32 c;
+    u8 enc;
+    u8 be = 1;
+
+    dst[0] = 0;
+    if (!len) {
+        return 0;
+    }
+    enc = *src++;
+    len--;
+
+    if ((enc == 0) || (enc == 3)) {
+        while (len && *src && (pos + 1 < size)) {
+            dst[pos++] = *src++;
+            len--;
+        }
+        if ((enc == 3) && len && *src) {//截断时去掉不完整的utf8字符
+            while (pos && ((dst[pos - 1] & 0xc0) == 0x80)) {
+                pos--;
+            }
+            if (pos && ((u8)dst[pos - 1] >= 0xc0)) {
+                pos--;
+            }
+        }
+        dst[pos] = 0;
+        return (enc == 0);
+    }
+
+    if ((enc == 1) && (len >= 2)) {
+        if ((src[0] == 0xff) && (src[1] == 0xfe)) {
+            be = 0;
+            src += 2;
+            len -= 2;
+        } else if ((src[0] == 0xfe) && (src[1] == 0xff)) {
+            src += 2;
+            len -= 2;
+        }
+    }
+    while (len >= 2) {
+        c = be ? ((src[0] << 8) | src[1]) : ((src[1] << 8) | src[0]);
+        src += 2;
+        len -= 2;
+        if (!c) {
+            break;
+        }
+        if ((c >= 0xd800) && (c < 0xdc00) && (len >= 2)) {
+            u32 lo = be ? ((src[0] << 8) | src[1]) : ((src[1] << 8) | src[0]);
+            if ((lo >= 0xdc00) && (lo < 0xe000)) {
+                c = 0x10000 + ((c - 0xd800) << 10) + (lo - 0xdc00);
+                src += 2;
+                len -= 2;
+            }
+        }
+        n = id3_put_utf8(dst, pos, size, c);
+        if (!n) {
+            break;
+        }
+        pos += n;
+    }
+    dst[pos] = 0;
+    return 0;
+}
+
+static int id3_v2_parse(struct id3_reader *rd, ID3_TAG_INFO *info)
+{
+    u8 *p;
+    u8 ver;
+    u8 hdr_len;
+    u32 addr;
+    u32 size;
+    u32 skip;
+    int idx;
+
+    p = id3_reader_get(rd, 0, ID3_V2_HEADER_SIZE);
+    if (!p || (id3_v2_match(p) == false)) {
+        return -1;
+    }
+    ver = p[3];
+    if ((ver < 2) || (ver > 4)) {
+        return -1;
+    }
+    rd->end = (((u32)p[6] & 0x7f) << 21) + (((u32)p[7] & 0x7f) << 14) +
+              (((u32)p[8] & 0x7f) << 7) + (p[9] & 0x7f) + ID3_V2_HEADER_SIZE;
+    addr = ID3_V2_HEADER_SIZE;
+    if ((ver > 2) && (p[5] & 0x40)) { //扩展头
+        p = id3_reader_get(rd, addr, 4);
+        if (!p) {
+            return -1;
+        }
+        if (ver == 4) {
+            size = (((u32)p[0] & 0x7f) << 21) + (((u32)p[1] & 0x7f) << 14) + (((u32)p[2] & 0x7f) << 7) + (p[3] & 0x7f);
+        } else {
+            size = ((u32)p[0] << 24) + ((u32)p[1] << 16) + ((u32)p[2] << 8) + p[3] + 4;
+        }
+        if (size > rd->end - addr) { //扩展头超出标签区(包括大小回绕)
+            return -1;
+        }
+        addr += size;
+    }
+    hdr_len = (ver == 2) ? ID3_V22_FRAME_SIZE : ID3_V2_FRAME_SIZE;
+    info->ver = ver;
+
+    while (addr + hdr_len <= rd->end) {
+        p = id3_reader_get(rd, addr, hdr_len);
+        if (!p || !p[0]) { //读错误或已到填充区
+            break;
+        }
+        skip = 0;
+        if (ver == 2) {
+            size = ((u32)p[3] << 16) + ((u32)p[4] << 8) + p[5];
+        } else if (ver == 3) {
+            size = ((u32)p[4] << 24) + ((u32)p[5] << 16) + ((u32)p[6] << 8) + p[7];
+            if (p[9] & 0xc0) { //压缩或加密
+                skip = 1;
+            }
+        } else {
+            size = (((u32)p[4] & 0x7f) << 21) + (((u32)p[5] & 0x7f) << 14) + (((u32)p[6] & 0x7f) << 7) + (p[7] & 0x7f);
+            if (p[9] & 0x0e) { //压缩、加密或帧内同步
+                skip = 1;
+            }
+        }
+        if (!size) { //空帧(部分编码器会写)跳过帧头继续找
+            addr += hdr_len;
+            continue;
+        }
+        /*循环条件保证addr + hdr_len <= end，用减法比较，v2.3的32位帧大小不会回绕*/
+        if (size > rd->end - addr - hdr_len) {
+            break;
+        }
+
+        for (idx = 0; !skip && (idx < ID3_TAG_FIELD_NUM); idx++) {
+            if (!memcmp(p, ID3_V2_FRAME_ID[ver != 2][idx], (ver == 2) ? 3 : 4)) {
+                break;
+            }
+        }
+        if ((ver == 4) && (idx == ID3_TAG_FIELD_NUM) && !memcmp(p, "TDRC", 4)) { //id3v2.4用TDRC代替TYER
+            idx = ID3_TAG_YEAR;
+        }
+        if (!skip && (idx < ID3_TAG_FIELD_NUM) && !info->text[idx][0]) {
+            u32 dat_addr = addr + hdr_len;
+            u32 dat_len = size;
+            if ((ver == 4) && (p[9] & 0x01)) { //数据长度指示
+                dat_addr += 4;
+                dat_len = (dat_len > 4) ? (dat_len - 4) : 0;
+            }
+            if (dat_len > ID3_TEXT_FRAME_MAX) {
+                dat_len = ID3_TEXT_FRAME_MAX;
+            }
+            p = id3_reader_get(rd, dat_addr, dat_len);
+            if (p && id3_text_decode(p, dat_len, info->text[idx], ID3_TAG_TEXT_LEN)) {
+                info->local_mask |= BIT(idx);
+            }
+        }
+        addr += hdr_len + size;
+    }
+    return 0;
+}
+
+static void id3_v1_copy(char *dst, const char *src, u32 len)
+{
+    if (len > ID3_TAG_TEXT_LEN - 1) {
+        len = ID3_TAG_TEXT_LEN - 1;
+    }
+    memcpy(dst, src, len);
+    dst[len] = 0;
+    while (len && ((dst[len - 1] == ' ') || !dst[len - 1])) {
+        dst[--len] = 0;
+    }
+}
+
+static int id3_v1_parse(struct id3_reader *rd, ID3_TAG_INFO *info)
+{
+    u32 file_len = flen(rd->file);
+    struct id3_v1_hdl *hdl;
+
+    if (file_len < ID3_V1_HEADER_SIZE) {
+        return -1;
+    }
+    rd->end = file_len;
+    hdl = (struct id3_v1_hdl *)id3_reader_get(rd, file_len - ID3_V1_HEADER_SIZE, ID3_V1_HEADER_SIZE);
+    if (!hdl || (id3_v1_match((u8 *)hdl) == false)) {
+        return -1;
+    }
+    id3_v1_copy(info->text[ID3_TAG_TITLE], hdl->title, sizeof(hdl->title));
+    id3_v1_copy(info->text[ID3_TAG_ARTIST], hdl->artist, sizeof(hdl->artist));
+    id3_v1_copy(info->text[ID3_TAG_ALBUM], hdl->album, sizeof(hdl->album));
+    id3_v1_copy(info->text[ID3_TAG_YEAR], hdl->year, sizeof(hdl->year));
+    if ((u8)hdl->genre != 0xff) {
+        sprintf(info->text[ID3_TAG_GENRE], "%d", (u8)hdl->genre);
+    }
+    info->local_mask = BIT(ID3_TAG_TITLE) | BIT(ID3_TAG_ARTIST) | BIT(ID3_TAG_ALBUM);
+    info->ver = 1;
+    return 0;
+}
+
+int id3_tag_parse(void *file, ID3_TAG_INFO *info)
+{
+    struct id3_reader rd = {0};
+    int err = -1;
+
+    if (!file || !info) {
+        return -1;
+    }
+    memset(info, 0, sizeof(*info));
+    rd.buf = malloc(ID3_READ_BUF_SIZE);
+    if (!rd.buf) {
+        log_error("malloc err !!\n");
+        return -1;
+    }
+    rd.file = file;
+    rd.fptr = fpos(file);
+    u32 cur_fptr = rd.fptr;
+
+    rd.end = ID3_V2_HEADER_SIZE;
+#if TCFG_DEC_ID3_V2_ENABLE
+    err = id3_v2_parse(&rd, info);
+#endif
+#if TCFG_DEC_ID3_V1_ENABLE
+    if (err) {
+        rd.buf_len = 0;
+        err = id3_v1_parse(&rd, info);
+    }
+#endif
+    if (rd.fptr != cur_fptr) {
+        fseek(file, cur_fptr, SEEK_SET);
+    }
+    free(rd.buf);
+    return err;
+}
+
+#if ID3_TAG_CACHE_NUM
+/*缓存只在app任务中访问(播放成功回调、设备拔出事件)，不加锁*/
+struct id3_tag_cache {
+    u32 logo;		// 设备盘符hash，0:空
+    u32 sclust;
+    u32 fsize;
+    u32 stamp;		// 最近使用时间，淘汰最久未用的
+    ID3_TAG_INFO info;
+};
+static struct id3_tag_cache id3_cache[ID3_TAG_CACHE_NUM];
+static u32 id3_cache_stamp;
+
+static u32 id3_logo_hash(const char *logo)
+{
+    u32 h = 5381;
+    while (logo && *logo) {
+        h = (h << 5) + h + (u8)(*logo++);
+    }
+    return h ? h : 1;
+}
+#endif
+
+int id3_tag_get(void *file, const char *logo, ID3_TAG_INFO *info)
+{
+#if ID3_TAG_CACHE_NUM
+    struct vfs_attr attr = {0};
+    struct id3_tag_cache *cache;
+    u32 hash = id3_logo_hash(logo);
+    int i;
+    int err;
+
+    if (!file || !info) {
+        return -1;
+    }
+    fget_attrs(file, &attr);
+
+    for (i = 0; i < ID3_TAG_CACHE_NUM; i++) {
+        cache = &id3_cache[i];
+        if ((cache->logo == hash) && (cache->sclust == attr.sclust) && (cache->fsize == attr.fsize)) {
+            cache->stamp = ++id3_cache_stamp;
+            memcpy(info, &cache->info, sizeof(*info));
+            return info->ver ? 0 : -1;
+        }
+    }
+
+    err = id3_tag_parse(file, info); //没有标签也缓存，避免重复解析
+
+    cache = &id3_cache[0];
+    for (i = 1; i < ID3_TAG_CACHE_NUM; i++) {
+        if (id3_cache[i].stamp < cache->stamp) {
+            cache = &id3_cache[i];
+        }
+    }
+    cache->logo = hash;
+    cache->sclust = attr.sclust;
+    cache->fsize = attr.fsize;
+    cache->stamp = ++id3_cache_stamp;
+    memcpy(&cache->info, info, sizeof(*info));
+    return err;
+#else
+    return id3_tag_parse(file, info);
+#endif
+}
+
+void id3_tag_cache_clear(const char *logo)
+{
+#if ID3_TAG_CACHE_NUM
+    u32 hash = logo ? id3_logo_hash(logo) : 0;
+
+    for (int i = 0; i < ID3_TAG_CACHE_NUM; i++) {
+        if (!hash || (id3_cache[i].logo == hash)) {
+            memset(&id3_cache[i], 0, sizeof(id3_cache[i]));
+        }
+    }
+#endif
+}
+
+
 #endif
 
@@ -11,5 +11,30 @@ void id3_obj_post(MP3_ID3_OBJ **obj);
 MP3_ID3_OBJ *id3_v1_obj_get(void *file);
 MP3_ID3_OBJ *id3_v2_obj_get(void *file);
 
+#define ID3_TAG_TEXT_LEN		40	// 单个字段最大长度(含结束符)，超长截断
+#define ID3_TAG_CACHE_NUM		8	// 标签缓存条数，0:不缓存
+
+enum {
+    ID3_TAG_TITLE = 0,	// 标题
+    ID3_TAG_ARTIST,		// 作者
+    ID3_TAG_ALBUM,		// 专辑
+    ID3_TAG_YEAR,		// 年代
+    ID3_TAG_GENRE,		// 类型
+    ID3_TAG_FIELD_NUM,
+};
+
+typedef struct __ID3_TAG_INFO {
+    char text[ID3_TAG_FIELD_NUM][ID3_TAG_TEXT_LEN];	// utf8字符串
+    u8 local_mask;	// BIT(字段):ISO-8859-1/id3v1字段原样拷贝(可能是本地编码)，未转utf8
+    u8 ver;			// 2~4:id3v2.x, 1:id3v1, 0:无标签
+} ID3_TAG_INFO;
+
+/*解析文件id3标签(优先id3v2，没有再找id3v1)，不改变文件读写位置，返回0:成功*/
+int id3_tag_parse(void *file, ID3_TAG_INFO *info);
+/*带缓存的解析，缓存以 设备盘符+文件簇号+文件大小 为索引，只在app任务中调用*/
+int id3_tag_get(void *file, const char *logo, ID3_TAG_INFO *info);
+/*清除指定设备的缓存，logo为NULL时清除全部*/
+void id3_tag_cache_clear(const char *logo);
+
 #endif// __MUSIC_ID3_H__
 
@@ -110,6 +110,8 @@ void music_player_destroy(void)
 {
     if (__this) {
         music_player_stop(1);
+        ///退出时回收缓存的扫盘句柄， 避免占用其他模式的内存
+        dev_manager_scan_disk_cache_free(NULL);
         free(__this);
         __this = NULL;
     }
@@ -445,6 +447,23 @@ u32 music_player_get_file_sclust(void)
     return (u32) - 1;
 }
 
+//*----------------------------------------------------------------------------*/
+/**@brief    music_player获取当前文件id3标签
+   @param    info:标签信息
+   @return   0:成功, 其他:没有标签或无效
+   @note	 按设备+簇号缓存，重复查询不再读文件
+*/
+/*----------------------------------------------------------------------------*/
+int music_player_get_id3_info(ID3_TAG_INFO *info)
+{
+#if ((TCFG_DEC_ID3_V1_ENABLE) || (TCFG_DEC_ID3_V2_ENABLE))
+    if (__this && __this->file) {
+        return id3_tag_get(__this->file, dev_manager_get_logo(__this->dev), info);
+    }
+#endif
+    return -1;
+}
+
 //*----------------------------------------------------------------------------*/
 /**@brief    music_player获取文件长度
    @param
@@ -858,6 +877,7 @@ int music_player_delete_playing_file(void)
             log_info("[%s, %d] fail!!, replay cur file\n", __FUNCTION__, __LINE__);
         } else {
             log_info("[%s, %d] ok, play next file\n", __FUNCTION__, __LINE__);
+            dev_manager_scan_disk_cache_free(__this->dev);
             __this->file = NULL;
             __this->dev = NULL;//目的重新扫盘， 更新文件总数
             return music_player_play_by_number(cur_dev, cur_file);
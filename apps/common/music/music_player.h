@@ -8,6 +8,7 @@
 #include "dev_manager/dev_manager.h"
 #include "file_operate/file_manager.h"
 #include "audio_dec/audio_dec_file.h"
+#include "music/music_id3.h"
 
 ///解码错误码表
 enum {
@@ -78,6 +79,8 @@ u16 music_player_get_dir_total(void);
 FILE *music_player_get_file_hdl(void);
 //music_player获取当前文件簇号
 u32 music_player_get_file_sclust(void);
+//music_player获取当前文件id3标签
+int music_player_get_id3_info(ID3_TAG_INFO *info);
 //music_player获取当前文件长度
 u32 music_player_get_file_len(void);
 //music_player获取现在的使用设备
@@ -17,6 +17,7 @@
 #define QCLOUD_BLE_QIOT_MD5_H
 
 #include <stdint.h>
+#include "profile_crypto.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,11 +25,7 @@ extern "C" {
 
 #define MD5_DIGEST_SIZE 16
 
-typedef struct {
-    unsigned int  total[2];   /*!< number of bytes processed  */
-    unsigned int  state[4];   /*!< intermediate digest state  */
-    unsigned char buffer[64]; /*!< data block being processed */
-} iot_md5_context;
+typedef struct profile_hash_ctx iot_md5_context;
 
 /**
  * @brief init MD5 context
@@ -76,9 +73,6 @@ void utils_md5_update(iot_md5_context *ctx, const unsigned char *input, unsigned
  */
 void utils_md5_finish(iot_md5_context *ctx, unsigned char output[16]);
 
-/* MD5 internal process */
-void utils_md5_process(iot_md5_context *ctx, const unsigned char data[64]);
-
 /**
  * @brief          Output = MD5( input buffer )
  *
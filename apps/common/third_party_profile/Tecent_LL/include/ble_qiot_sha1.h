@@ -22,15 +22,12 @@ extern "C" {
 
 #include <stdint.h>
 #include <stddef.h>
+#include "profile_crypto.h"
 
 /**
  * \brief          SHA-1 context structure
  */
-typedef struct {
-    uint32_t      total[2];   /*!< number of bytes processed  */
-    uint32_t      state[5];   /*!< intermediate digest state  */
-    unsigned char buffer[64]; /*!< data block being processed */
-} iot_sha1_context;
+typedef struct profile_hash_ctx iot_sha1_context;
 
 /**
  * \brief          Initialize SHA-1 context
@@ -78,9 +75,6 @@ void utils_sha1_update(iot_sha1_context *ctx, const unsigned char *input, size_t
  */
 void utils_sha1_finish(iot_sha1_context *ctx, unsigned char output[20]);
 
-/* Internal use */
-void utils_sha1_process(iot_sha1_context *ctx, const unsigned char data[64]);
-
 /**
  * \brief          Output = SHA-1( input buffer )
  *
@@ -0,0 +1,49 @@
+#ifndef _PROFILE_CRC_H_
+#define _PROFILE_CRC_H_
+
+#include "typedef.h"
+
+/*
+ * 第三方协议(tuya / Tecent LL)共用的查表CRC
+ * PROFILE_CRC_SLICE: 每次并行处理的字节数，1/4/8
+ *   1: CRC32表1K + CRC16表512byte
+ *   4: CRC32表4K + CRC16表2K，速度约为逐字节查表的2~3倍
+ *   8: CRC32表8K，大块数据(OTA校验)最快
+ */
+#ifndef PROFILE_CRC_SLICE
+#define PROFILE_CRC_SLICE       4
+#endif
+
+/*
+ * CRC32(IEEE 802.3, 反射多项式0xEDB88320)
+ * 流式用法：
+ *   u32 crc = profile_crc32_init();
+ *   crc = profile_crc32_update(crc, buf, len);	//可多次调用
+ *   crc = profile_crc32_final(crc);
+ */
+#define PROFILE_CRC32_INIT      0xFFFFFFFF
+
+static inline u32 profile_crc32_init(void)
+{
+    return PROFILE_CRC32_INIT;
+}
+
+static inline u32 profile_crc32_final(u32 crc)
+{
+    return ~crc;
+}
+
+u32 profile_crc32_update(u32 crc, const u8 *buf, u32 len);
+
+/*与zlib crc32()一致：crc为上一次的结果，首次传0*/
+u32 profile_crc32(u32 crc, const u8 *buf, u32 len);
+
+/*
+ * CRC16(MODBUS, 反射多项式0xA001)，无结果取反
+ * 首次传PROFILE_CRC16_INIT，续算传上一次的结果
+ */
+#define PROFILE_CRC16_INIT      0xFFFF
+
+u16 profile_crc16_update(u16 crc, const u8 *buf, u32 len);
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef _PROFILE_CRYPTO_H_
+#define _PROFILE_CRYPTO_H_
+
+#include "typedef.h"
+
+/*
+ * 第三方协议(tuya / Tecent LL / dma)共用的加解密和摘要，
+ * 替代各协议自带的mbedtls / qcloud副本
+ *
+ * PROFILE_CRYPTO_AES_TABLES: AES每轮的查表方式
+ *   0: 只查S盒(加解密共512byte)，列混合现算，代码最小，最慢
+ *   1: 加解密各一张1K的T表，其余三列由循环移位得到
+ *   4: 加解密各四张T表(共8K)，最快，适合大块OTA数据
+ */
+#ifndef PROFILE_CRYPTO_AES_TABLES
+#define PROFILE_CRYPTO_AES_TABLES	1
+#endif
+
+#define PROFILE_AES_BLOCK_SIZE		16
+
+struct profile_aes_ctx {
+    u32 rk[60];			/*轮密钥*/
+    u8 nr;				/*轮数10/12/14*/
+};
+
+/*keybits:128/192/256，return:0成功，长度不支持返回-EINVAL*/
+int profile_aes_setkey_enc(struct profile_aes_ctx *ctx, const u8 *key, u16 keybits);
+int profile_aes_setkey_dec(struct profile_aes_ctx *ctx, const u8 *key, u16 keybits);
+
+/*多块批量处理，blocks为16byte块数，支持原地(out == in)*/
+void profile_aes_ecb_encrypt(const struct profile_aes_ctx *ctx, const u8 *in, u8 *out, u32 blocks);
+void profile_aes_ecb_decrypt(const struct profile_aes_ctx *ctx, const u8 *in, u8 *out, u32 blocks);
+/*iv返回时更新为最后一块密文，可接着处理下一段*/
+void profile_aes_cbc_encrypt(const struct profile_aes_ctx *ctx, u8 *iv, const u8 *in, u8 *out, u32 blocks);
+void profile_aes_cbc_decrypt(const struct profile_aes_ctx *ctx, u8 *iv, const u8 *in, u8 *out, u32 blocks);
+/*
+ * CTR，加解密相同，使用加密轮密钥
+ * ctr:16byte计数块，整块按大端+1，返回时为下一个计数
+ * len不是16的倍数时最后一块剩余的密钥流丢弃，只能作为最后一段
+ */
+void profile_aes_ctr(const struct profile_aes_ctx *ctx, u8 *ctr, const u8 *in, u8 *out, u32 len);
+/*
+ * CCM(NIST SP800-38C)，使用加密轮密钥，支持原地
+ * nonce_len:7~13  tag_len:4~16的偶数
+ * return:0成功，参数错误返回-EINVAL，解密校验失败返回-EACCES(输出清零)
+ */
+int profile_aes_ccm_encrypt(const struct profile_aes_ctx *ctx, const u8 *nonce, u8 nonce_len,
+                            const u8 *aad, u32 aad_len, const u8 *in, u8 *out, u32 len,
+                            u8 *tag, u8 tag_len);
+int profile_aes_ccm_decrypt(const struct profile_aes_ctx *ctx, const u8 *nonce, u8 nonce_len,
+                            const u8 *aad, u32 aad_len, const u8 *in, u8 *out, u32 len,
+                            const u8 *tag, u8 tag_len);
+
+/*
+ * 摘要，三种算法共用一个流式上下文
+ * 整块数据直接从输入处理，不经过内部缓存
+ *   struct profile_hash_ctx ctx;
+ *   profile_hash_init(&ctx, PROFILE_HASH_SHA256);
+ *   profile_hash_update(&ctx, buf, len);	//可多次调用
+ *   profile_hash_final(&ctx, digest);
+ */
+enum {
+    PROFILE_HASH_MD5 = 0,
+    PROFILE_HASH_SHA1,
+    PROFILE_HASH_SHA256,
+    PROFILE_HASH_NUM,
+};
+
+#define PROFILE_MD5_DIGEST_SIZE		16
+#define PROFILE_SHA1_DIGEST_SIZE	20
+#define PROFILE_SHA256_DIGEST_SIZE	32
+#define PROFILE_HASH_DIGEST_MAX		32
+#define PROFILE_HASH_BLOCK_SIZE		64
+
+struct profile_hash_ctx {
+    u32 state[8];
+    u64 total;			/*已输入字节数*/
+    u8 buf[PROFILE_HASH_BLOCK_SIZE];
+    u8 alg;
+};
+
+/*return:0成功，算法不支持返回-EINVAL*/
+int profile_hash_init(struct profile_hash_ctx *ctx, u8 alg);
+void profile_hash_update(struct profile_hash_ctx *ctx, const u8 *data, u32 len);
+/*输出摘要，ctx需重新init才能再用*/
+void profile_hash_final(struct profile_hash_ctx *ctx, u8 *digest);
+/*return:摘要字节数，算法不支持返回0*/
+u8 profile_hash_size(u8 alg);
+int profile_hash(u8 alg, const u8 *data, u32 len, u8 *digest);
+
+/*
+ * HMAC，init时把密钥的内外两层填充块各压缩一次并保存，
+ * final后自动回到init之后的状态，同一密钥连续计算时不再重复处理密钥
+ */
+struct profile_hmac_ctx {
+    struct profile_hash_ctx hash;
+    u32 istate[8];		/*压缩完ipad块后的状态*/
+    u32 ostate[8];		/*压缩完opad块后的状态*/
+};
+
+/*return:0成功，算法不支持返回-EINVAL*/
+int profile_hmac_init(struct profile_hmac_ctx *ctx, u8 alg, const u8 *key, u32 key_len);
+void profile_hmac_update(struct profile_hmac_ctx *ctx, const u8 *data, u32 len);
+void profile_hmac_final(struct profile_hmac_ctx *ctx, u8 *mac);
+int profile_hmac(u8 alg, const u8 *key, u32 key_len, const u8 *data, u32 len, u8 *mac);
+
+#endif
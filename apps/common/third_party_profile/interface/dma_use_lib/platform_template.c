@@ -6,6 +6,7 @@
 #include "btstack/third_party/app_protocol_event.h"
 #include "btstack/avctp_user.h"
 #include "system/timer.h"
+#include "profile_crypto.h"
 
 #ifdef DMA_LIB_CODE_SIZE_CHECK
 #pragma bss_seg(	".bt_dma_port_bss")
@@ -459,7 +460,7 @@ bool platform_set_wakeup_enable(bool on)
 bool platform_get_check_summary(const void *input_data, uint32_t len, uint8_t *output_string)
 {
     dma_log("%s\n", __func__);
-    sha256Compute(input_data, len, (u8 *)output_string);
+    profile_hash(PROFILE_HASH_SHA256, input_data, len, (u8 *)output_string);
     set_dueros_pair_state(1, 0);
     return true;
 }
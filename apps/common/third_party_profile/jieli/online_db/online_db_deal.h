@@ -16,6 +16,7 @@ typedef enum {
     DB_PKT_TYPE_DAT_CH1,
     DB_PKT_TYPE_DAT_CH2,
     DB_PKT_TYPE_MIC_DUT = 0x20,/*麦克风测试功能*/
+    DB_PKT_TYPE_MIPS_PROF = 0x21,/*音频各级处理耗时统计*/
     DB_PKT_TYPE_MAX,
 } db_pkt_e;
 
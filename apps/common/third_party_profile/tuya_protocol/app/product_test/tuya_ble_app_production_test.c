@@ -394,7 +394,16 @@ static void tuya_ble_auc_write_comm_cfg(uint8_t *para, uint16_t len)
     memset(pstr, 0x00, len + 1);
     memcpy(pstr, para, len);
 
-    root = cJSON_Parse((char *)pstr);
+    /* parse in place on pstr, all nodes come from one block that is freed once,
+       sized from the frame so extra fields from the tool cannot run it out */
+    cJSON_Arena arena;
+    size_t arena_size = cJSON_ArenaSize((char *)pstr);
+    void *arena_buf = tuya_ble_malloc(arena_size);
+    if (NULL == arena_buf) {
+        goto EXIT_ERR;
+    }
+    cJSON_InitArena(&arena, arena_buf, arena_size);
+    root = cJSON_ParseInSitu((char *)pstr, &arena);
     if (!root) {
         TUYA_BLE_LOG_ERROR("cJSON error : [%s]\n", cJSON_GetErrorPtr());
         goto EXIT_ERR;
@@ -526,8 +535,8 @@ EXIT_ERR:
         }
     }
 
-    if (NULL != root) {
-        cJSON_Delete(root);
+    if (NULL != arena_buf) {
+        tuya_ble_free(arena_buf);
     }
 }
 #else
@@ -32,8 +32,7 @@
 #include "system/includes.h"
 #include "update.h"
 #include "update_loader_download.h"
-#include "aes.h"
-#include "md5.h"
+#include "profile_crypto.h"
 #include "tuya_ble_data_handler.h"
 
 #include "btstack/le/le_user.h"
@@ -945,28 +944,14 @@ __TUYA_BLE_WEAK bool tuya_ble_event_queue_send_port(tuya_ble_evt_param_t *evt, u
     */
 __TUYA_BLE_WEAK bool tuya_ble_aes128_ecb_encrypt(uint8_t *key, uint8_t *input, uint16_t input_len, uint8_t *output)
 {
-    uint16_t length;
-    mbedtls_aes_context aes_ctx;
-    //
+    struct profile_aes_ctx aes_ctx;
+
     if (input_len % 16) {
         return false;
     }
-
-    length = input_len;
-
-    mbedtls_aes_init(&aes_ctx);
-
-    mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
-
-    while (length > 0) {
-        mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_ENCRYPT, input, output);
-        input  += 16;
-        output += 16;
-        length -= 16;
-    }
-
-    mbedtls_aes_free(&aes_ctx);
-
+    profile_aes_setkey_enc(&aes_ctx, key, 128);
+    profile_aes_ecb_encrypt(&aes_ctx, input, output, input_len / 16);
+    memset(&aes_ctx, 0, sizeof(aes_ctx));
     return true;
 }
 
@@ -983,27 +968,14 @@ __TUYA_BLE_WEAK bool tuya_ble_aes128_ecb_encrypt(uint8_t *key, uint8_t *input, u
 */
 __TUYA_BLE_WEAK bool tuya_ble_aes128_ecb_decrypt(uint8_t *key, uint8_t *input, uint16_t input_len, uint8_t *output)
 {
-    uint16_t length;
-    mbedtls_aes_context aes_ctx;
-    //
+    struct profile_aes_ctx aes_ctx;
+
     if (input_len % 16) {
         return false;
     }
-
-    length = input_len;
-
-    mbedtls_aes_init(&aes_ctx);
-
-    mbedtls_aes_setkey_dec(&aes_ctx, key, 128);
-
-    while (length > 0) {
-        mbedtls_aes_crypt_ecb(&aes_ctx, MBEDTLS_AES_DECRYPT, input, output);
-        input  += 16;
-        output += 16;
-        length -= 16;
-    }
-
-    mbedtls_aes_free(&aes_ctx);
+    profile_aes_setkey_dec(&aes_ctx, key, 128);
+    profile_aes_ecb_decrypt(&aes_ctx, input, output, input_len / 16);
+    memset(&aes_ctx, 0, sizeof(aes_ctx));
     return true;
 }
 /**
@@ -1020,20 +992,14 @@ __TUYA_BLE_WEAK bool tuya_ble_aes128_ecb_decrypt(uint8_t *key, uint8_t *input, u
     */
 __TUYA_BLE_WEAK bool tuya_ble_aes128_cbc_encrypt(uint8_t *key, uint8_t *iv, uint8_t *input, uint16_t input_len, uint8_t *output)
 {
-    mbedtls_aes_context aes_ctx;
+    struct profile_aes_ctx aes_ctx;
 
     if (input_len % 16) {
         return false;
     }
-
-    mbedtls_aes_init(&aes_ctx);
-
-    mbedtls_aes_setkey_enc(&aes_ctx, key, 128);
-
-    mbedtls_aes_crypt_cbc(&aes_ctx, MBEDTLS_AES_ENCRYPT, input_len, iv, input, output);
-
-    mbedtls_aes_free(&aes_ctx);
-
+    profile_aes_setkey_enc(&aes_ctx, key, 128);
+    profile_aes_cbc_encrypt(&aes_ctx, iv, input, output, input_len / 16);
+    memset(&aes_ctx, 0, sizeof(aes_ctx));
     return true;
 }
 /**
@@ -1050,20 +1016,14 @@ __TUYA_BLE_WEAK bool tuya_ble_aes128_cbc_encrypt(uint8_t *key, uint8_t *iv, uint
     */
 __TUYA_BLE_WEAK bool tuya_ble_aes128_cbc_decrypt(uint8_t *key, uint8_t *iv, uint8_t *input, uint16_t input_len, uint8_t *output)
 {
-    mbedtls_aes_context aes_ctx;
+    struct profile_aes_ctx aes_ctx;
 
     if (input_len % 16) {
         return false;
     }
-
-    mbedtls_aes_init(&aes_ctx);
-
-    mbedtls_aes_setkey_dec(&aes_ctx, key, 128);
-
-    mbedtls_aes_crypt_cbc(&aes_ctx, MBEDTLS_AES_DECRYPT, input_len, iv, input, output);
-
-    mbedtls_aes_free(&aes_ctx);
-
+    profile_aes_setkey_dec(&aes_ctx, key, 128);
+    profile_aes_cbc_decrypt(&aes_ctx, iv, input, output, input_len / 16);
+    memset(&aes_ctx, 0, sizeof(aes_ctx));
     return true;
 }
 /**
@@ -1078,13 +1038,22 @@ __TUYA_BLE_WEAK bool tuya_ble_aes128_cbc_decrypt(uint8_t *key, uint8_t *iv, uint
     */
 __TUYA_BLE_WEAK bool tuya_ble_md5_crypt(uint8_t *input, uint16_t input_len, uint8_t *output)
 {
-    mbedtls_md5_context md5_ctx;
-    mbedtls_md5_init(&md5_ctx);
-    mbedtls_md5_starts(&md5_ctx);
-    mbedtls_md5_update(&md5_ctx, input, input_len);
-    mbedtls_md5_finish(&md5_ctx, output);
-    mbedtls_md5_free(&md5_ctx);
-    return true;
+    return profile_hash(PROFILE_HASH_MD5, input, input_len, output) == 0;
+}
+
+/**
+    * @brief  SHA256 checksum
+    * @param  input    specifed plain text to be encypted
+    * @param  output    output buffer to store sha256 result data,output data len is always 32
+    * @param  input_len    byte length of the data to be encypted
+    * @return encryption results
+    * @retval true      successful
+    * @retval false     fail
+    * @note
+    */
+__TUYA_BLE_WEAK bool tuya_ble_sha256_crypt(const uint8_t *input, uint16_t input_len, uint8_t *output)
+{
+    return profile_hash(PROFILE_HASH_SHA256, input, input_len, output) == 0;
 }
 
 /**
@@ -1102,7 +1071,7 @@ __TUYA_BLE_WEAK bool tuya_ble_md5_crypt(uint8_t *input, uint16_t input_len, uint
     */
 __TUYA_BLE_WEAK bool tuya_ble_hmac_sha1_crypt(const uint8_t *key, uint32_t key_len, const uint8_t *input, uint32_t input_len, uint8_t *output)
 {
-    return true;
+    return profile_hmac(PROFILE_HASH_SHA1, key, key_len, input, input_len, output) == 0;
 }
 
 /**
@@ -1120,7 +1089,7 @@ __TUYA_BLE_WEAK bool tuya_ble_hmac_sha1_crypt(const uint8_t *key, uint32_t key_l
     */
 __TUYA_BLE_WEAK bool tuya_ble_hmac_sha256_crypt(const uint8_t *key, uint32_t key_len, const uint8_t *input, uint32_t input_len, uint8_t *output)
 {
-    return true;
+    return profile_hmac(PROFILE_HASH_SHA256, key, key_len, input, input_len, output) == 0;
 }
 
 
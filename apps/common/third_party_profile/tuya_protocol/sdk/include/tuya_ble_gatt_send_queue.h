@@ -41,6 +41,7 @@ typedef struct {
 void tuya_ble_gatt_send_queue_init(void);
 void tuya_ble_gatt_send_data_handle(void *evt);
 tuya_ble_status_t tuya_ble_gatt_send_data_enqueue(uint8_t *p_data, uint8_t data_len);
+tuya_ble_status_t tuya_ble_gatt_send_data_enqueue_iov(uint8_t *p_head, uint8_t head_len, uint8_t *p_data, uint8_t data_len);
 
 #ifdef __cplusplus
 }
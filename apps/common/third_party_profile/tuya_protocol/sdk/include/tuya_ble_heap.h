@@ -30,7 +30,9 @@
 #ifndef TUYA_HEAP_H__
 #define TUYA_HEAP_H__
 
+#ifndef TUYA_BLE_HEAP_HOST
 #include "tuya_ble_stdlib.h"
+#endif
 
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +72,12 @@ extern "C" {
 #error "Invalid portBYTE_ALIGNMENT definition"
 #endif
 
+/* Unsigned type as wide as a pointer, used for address arithmetic. Host
+builds (tools/host_test) set it to the native width. */
+#ifndef portPOINTER_SIZE_TYPE
+#define portPOINTER_SIZE_TYPE       uint32_t
+#endif
+
 
 #ifndef tuyaASSERT
 #define tuyaASSERT( x )
@@ -94,6 +102,19 @@ extern "C" {
 
 
 
+/* Heap usage snapshot, filled by vTuyaPortGetHeapStats(). Fragmentation can
+be estimated as 1 - xSizeOfLargestFreeBlockInBytes / xAvailableHeapSpaceInBytes. */
+typedef struct xTUYA_HEAP_STATS {
+    uint32_t xAvailableHeapSpaceInBytes;		/*<< Total free bytes, including block headers. */
+    uint32_t xSizeOfLargestFreeBlockInBytes;
+    uint32_t xSizeOfSmallestFreeBlockInBytes;
+    uint32_t xNumberOfFreeBlocks;
+    uint32_t xMinimumEverFreeBytesRemaining;	/*<< High-water mark of heap usage. */
+    uint32_t xNumberOfSuccessfulAllocations;
+    uint32_t xNumberOfSuccessfulFrees;
+    uint32_t xNumberOfFailedAllocations;
+} TuyaHeapStats_t;
+
 void *pvTuyaPortMalloc(uint32_t xWantedSize);
 
 void vTuyaPortFree(void *pv);
@@ -102,6 +123,8 @@ uint32_t xTuyaPortGetFreeHeapSize(void);
 
 uint32_t xTuyaPortGetMinimumEverFreeHeapSize(void);
 
+void vTuyaPortGetHeapStats(TuyaHeapStats_t *pxHeapStats);
+
 
 #endif
 
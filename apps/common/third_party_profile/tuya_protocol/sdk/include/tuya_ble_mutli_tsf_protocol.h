@@ -121,6 +121,22 @@ typedef struct s_klv_node {
     uint8_t *data;
 } klv_node_s;
 
+// klv record parsed in place, data points into the source buffer
+typedef struct {
+    uint8_t id;
+    dp_type type;
+    uint16_t len;
+    uint8_t *data;
+} klv_view_s;
+
+// sub-package described as head + data slice of the caller's buffer
+typedef struct {
+    uint8_t *head;
+    uint16_t head_len;
+    uint8_t *data;
+    uint16_t data_len;
+} trsmitr_iov_s;
+
 
 /***********************************************************
 *************************variable define********************
@@ -173,6 +189,27 @@ mtp_ret klvlist_2_data(klv_node_s *list, uint8_t **data, uint32_t *len, uint8_t
 __MUTLI_TSF_PROTOCOL_EXT \
 mtp_ret data_2_klvlist(uint8_t *data, uint32_t len, klv_node_s **list, uint8_t type);
 
+/***********************************************************
+*  Function: klv_data_next
+*  description: parse one klv record in place
+*  Input: data len offset
+*  Output: klv offset
+*  Return:
+*  Note: klv->data points into data, nothing to free.
+***********************************************************/
+__MUTLI_TSF_PROTOCOL_EXT \
+mtp_ret klv_data_next(uint8_t *data, uint32_t len, uint32_t *offset, klv_view_s *klv, uint8_t type);
+
+/***********************************************************
+*  Function: klv_data_check
+*  description: validate dp data without malloc
+*  Input: data len
+*  Output: dp_num
+*  Return:
+***********************************************************/
+__MUTLI_TSF_PROTOCOL_EXT \
+mtp_ret klv_data_check(uint8_t *data, uint32_t len, uint8_t type, uint16_t *dp_num);
+
 /***********************************************************
 *  Function: create_trsmitr_init
 *  description: create a transmitter and initialize
@@ -287,6 +324,21 @@ mtp_ret trsmitr_send_pkg_encode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t version
 __MUTLI_TSF_PROTOCOL_EXT \
 mtp_ret trsmitr_send_pkg_encode_with_packet_length(frm_trsmitr_proc_s *frm_trsmitr, uint32_t pkg_len_max, uint8_t version, uint8_t *buf, uint32_t len);
 
+/***********************************************************
+*  Function: trsmitr_send_pkg_encode_iov
+*  description: Encoding function for specifying sub-packet length,
+*               sub-packet data is not copied
+*  Input:
+*  Output: iov->sub-package head and data slice of buf
+*  Return: MTP_OK->buf send up
+*          MTP_TRSMITR_CONTINUE->need call again to be continue
+*          other->error
+*  Note: iov->head is only valid until the next call
+***********************************************************/
+__MUTLI_TSF_PROTOCOL_EXT \
+mtp_ret trsmitr_send_pkg_encode_iov(frm_trsmitr_proc_s *frm_trsmitr, uint32_t pkg_len_max, uint8_t version, uint8_t *buf, uint32_t len, \
+                                    trsmitr_iov_s *iov);
+
 /***********************************************************
 *  Function: trsmitr_recv_pkg_decode
 *  description: frm_trsmitr->transmitter handle
@@ -303,6 +355,20 @@ mtp_ret trsmitr_send_pkg_encode_with_packet_length(frm_trsmitr_proc_s *frm_trsmi
 __MUTLI_TSF_PROTOCOL_EXT \
 mtp_ret trsmitr_recv_pkg_decode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_data, uint16_t raw_data_len);
 
+/***********************************************************
+*  Function: trsmitr_recv_pkg_decode_in_place
+*  description: same as trsmitr_recv_pkg_decode without copying
+*               the data to the transmitter subpackage buf
+*  Input:
+*  Output: data->sub-package data inside raw_data
+*  Return: MTP_OK->buf receive up
+*          MTP_TRSMITR_CONTINUE->need call again to be continue
+*          other->error
+*  Note: data len is get_trsmitr_subpkg_len()
+***********************************************************/
+__MUTLI_TSF_PROTOCOL_EXT \
+mtp_ret trsmitr_recv_pkg_decode_in_place(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_data, uint16_t raw_data_len, uint8_t **data);
+
 
 #ifdef __cplusplus
 }
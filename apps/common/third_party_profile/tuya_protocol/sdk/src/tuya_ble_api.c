@@ -553,7 +553,6 @@ tuya_ble_status_t tuya_ble_dp_data_send(uint32_t sn, tuya_ble_dp_data_send_type_
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer = NULL;
     mtp_ret ret;
-    klv_node_s *list = NULL;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
         return TUYA_BLE_ERR_INVALID_STATE;
@@ -563,11 +562,10 @@ tuya_ble_status_t tuya_ble_dp_data_send(uint32_t sn, tuya_ble_dp_data_send_type_
         TUYA_BLE_LOG_ERROR("send dp data len error,data len = %d , max data len = %d", dp_data_len, TUYA_BLE_SEND_MAX_DATA_LEN - 7);
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
-    ret = data_2_klvlist(p_dp_data, dp_data_len, &list, 1);
+    ret = klv_data_check(p_dp_data, dp_data_len, 1, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
 
     ble_evt_buffer = (uint8_t *)tuya_ble_malloc(dp_data_len + 7);
     if (ble_evt_buffer == NULL) {
@@ -626,7 +624,6 @@ tuya_ble_status_t tuya_ble_dp_data_with_time_send(uint32_t sn, tuya_ble_dp_data_
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer = NULL;
     mtp_ret ret;
-    klv_node_s *list = NULL;
     uint16_t buffer_len = 0;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
@@ -637,11 +634,10 @@ tuya_ble_status_t tuya_ble_dp_data_with_time_send(uint32_t sn, tuya_ble_dp_data_
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
 
-    ret = data_2_klvlist(p_dp_data, dp_data_len, &list, 1);
+    ret = klv_data_check(p_dp_data, dp_data_len, 1, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
 
     if (time_type == DP_TIME_TYPE_UNIX_TIMESTAMP) {
         buffer_len = dp_data_len + 12;
@@ -706,7 +702,6 @@ tuya_ble_status_t tuya_ble_dp_data_report(uint8_t *p_data, uint32_t len)
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer;
     mtp_ret ret;
-    klv_node_s *list = NULL;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
         return TUYA_BLE_ERR_INVALID_STATE;
@@ -716,11 +711,10 @@ tuya_ble_status_t tuya_ble_dp_data_report(uint8_t *p_data, uint32_t len)
         TUYA_BLE_LOG_ERROR("report dp data len error,data len = %d , max data len = %d", len, TUYA_BLE_REPORT_MAX_DP_DATA_LEN);
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
-    ret = data_2_klvlist(p_data, len, &list, 0);
+    ret = klv_data_check(p_data, len, 0, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
 
     ble_evt_buffer = (uint8_t *)tuya_ble_malloc(len);
     if (ble_evt_buffer == NULL) {
@@ -753,7 +747,6 @@ tuya_ble_status_t tuya_ble_dp_data_with_flag_report(uint16_t sn, tuya_ble_dp_dat
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer = NULL;
     mtp_ret ret;
-    klv_node_s *list = NULL;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
         return TUYA_BLE_ERR_INVALID_STATE;
@@ -763,11 +756,10 @@ tuya_ble_status_t tuya_ble_dp_data_with_flag_report(uint16_t sn, tuya_ble_dp_dat
         TUYA_BLE_LOG_ERROR("report flag dp data len error,data len = %d , max data len = %d", len, (TUYA_BLE_REPORT_MAX_DP_DATA_LEN - 3));
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
-    ret = data_2_klvlist(p_data, len, &list, 0);
+    ret = klv_data_check(p_data, len, 0, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
 
     ble_evt_buffer = (uint8_t *)tuya_ble_malloc(len + 3);
     if (ble_evt_buffer == NULL) {
@@ -806,7 +798,6 @@ tuya_ble_status_t tuya_ble_dp_data_with_time_report(uint32_t timestamp, uint8_t
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer;
     mtp_ret ret;
-    klv_node_s *list = NULL;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
         return TUYA_BLE_ERR_INVALID_STATE;
@@ -815,11 +806,10 @@ tuya_ble_status_t tuya_ble_dp_data_with_time_report(uint32_t timestamp, uint8_t
     if ((len > TUYA_BLE_REPORT_MAX_DP_DATA_LEN) || (len == 0)) {
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
-    ret = data_2_klvlist(p_data, len, &list, 0);
+    ret = klv_data_check(p_data, len, 0, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
     ble_evt_buffer = (uint8_t *)tuya_ble_malloc(len);
     if (ble_evt_buffer == NULL) {
         return TUYA_BLE_ERR_NO_MEM;
@@ -852,7 +842,6 @@ tuya_ble_status_t tuya_ble_dp_data_with_flag_and_time_report(uint16_t sn, tuya_b
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer = NULL;
     mtp_ret ret;
-    klv_node_s *list = NULL;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
         return TUYA_BLE_ERR_INVALID_STATE;
@@ -861,11 +850,10 @@ tuya_ble_status_t tuya_ble_dp_data_with_flag_and_time_report(uint16_t sn, tuya_b
     if ((len > (TUYA_BLE_REPORT_MAX_DP_DATA_LEN - 8)) || (len == 0)) {
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
-    ret = data_2_klvlist(p_data, len, &list, 0);
+    ret = klv_data_check(p_data, len, 0, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
     ble_evt_buffer = (uint8_t *)tuya_ble_malloc(len);
     if (ble_evt_buffer == NULL) {
         return TUYA_BLE_ERR_NO_MEM;
@@ -901,7 +889,6 @@ tuya_ble_status_t tuya_ble_dp_data_with_time_ms_string_report(uint8_t *time_stri
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer;
     mtp_ret ret;
-    klv_node_s *list = NULL;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
         return TUYA_BLE_ERR_INVALID_STATE;
@@ -910,11 +897,10 @@ tuya_ble_status_t tuya_ble_dp_data_with_time_ms_string_report(uint8_t *time_stri
     if ((len > TUYA_BLE_REPORT_MAX_DP_DATA_LEN) || (len == 0)) {
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
-    ret = data_2_klvlist(p_data, len, &list, 0);
+    ret = klv_data_check(p_data, len, 0, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
     ble_evt_buffer = (uint8_t *)tuya_ble_malloc(len);
     if (ble_evt_buffer == NULL) {
         return TUYA_BLE_ERR_NO_MEM;
@@ -947,7 +933,6 @@ tuya_ble_status_t tuya_ble_dp_data_with_flag_and_time_ms_string_report(uint16_t
     tuya_ble_evt_param_t evt;
     uint8_t *ble_evt_buffer = NULL;
     mtp_ret ret;
-    klv_node_s *list = NULL;
 
     if (tuya_ble_connect_status_get() != BONDING_CONN) {
         return TUYA_BLE_ERR_INVALID_STATE;
@@ -956,11 +941,10 @@ tuya_ble_status_t tuya_ble_dp_data_with_flag_and_time_ms_string_report(uint16_t
     if ((len > (TUYA_BLE_REPORT_MAX_DP_DATA_LEN - 17)) || (len == 0)) {
         return TUYA_BLE_ERR_INVALID_LENGTH;
     }
-    ret = data_2_klvlist(p_data, len, &list, 0);
+    ret = klv_data_check(p_data, len, 0, NULL);
     if (MTP_OK != ret) {
         return TUYA_BLE_ERR_INVALID_PARAM;
     }
-    free_klv_list(list);
     ble_evt_buffer = (uint8_t *)tuya_ble_malloc(len);
     if (ble_evt_buffer == NULL) {
         return TUYA_BLE_ERR_NO_MEM;
@@ -191,8 +191,9 @@ static uint32_t ble_data_unpack(uint8_t *buf, uint32_t len)
 {
     static uint32_t offset = 0;
     mtp_ret ret;
+    uint8_t *subpkg = NULL;
 
-    ret = trsmitr_recv_pkg_decode(&ty_trsmitr_proc, buf, len);
+    ret = trsmitr_recv_pkg_decode_in_place(&ty_trsmitr_proc, buf, len, &subpkg);
     if (MTP_OK != ret && MTP_TRSMITR_CONTINUE != ret) {
         air_recv_packet.recv_len_max = 0;
         air_recv_packet.recv_len = 0;
@@ -227,8 +228,11 @@ static uint32_t ble_data_unpack(uint8_t *buf, uint32_t len)
     }
     if ((offset + get_trsmitr_subpkg_len(&ty_trsmitr_proc)) <= air_recv_packet.recv_len_max) {
         if (air_recv_packet.recv_data) {
-            memcpy(air_recv_packet.recv_data + offset, get_trsmitr_subpkg(&ty_trsmitr_proc), get_trsmitr_subpkg_len(&ty_trsmitr_proc));
-            offset += get_trsmitr_subpkg_len(&ty_trsmitr_proc);
+            // a repeated sub-package leaves subpkg NULL and length 0, nothing to copy
+            if (subpkg) {
+                memcpy(air_recv_packet.recv_data + offset, subpkg, get_trsmitr_subpkg_len(&ty_trsmitr_proc));
+                offset += get_trsmitr_subpkg_len(&ty_trsmitr_proc);
+            }
             air_recv_packet.recv_len = offset;
         } else {
             TUYA_BLE_LOG_ERROR("ble_data_unpack error.");
@@ -1979,7 +1983,6 @@ static void tuya_ble_handle_bt_state_req(uint8_t *recv_data, uint16_t recv_len)
 static void tuya_ble_handle_dp_data_write_req(uint8_t *recv_data, uint16_t recv_len)
 {
     mtp_ret ret;
-    klv_node_s *list = NULL;
     uint8_t p_buf[6];
     uint16_t data_len = 0;
     uint32_t ack_sn = 0;
@@ -2016,7 +2019,7 @@ static void tuya_ble_handle_dp_data_write_req(uint8_t *recv_data, uint16_t recv_
 
     TUYA_BLE_LOG_HEXDUMP_DEBUG("cmd_dp_write data : ", recv_data + 13, data_len);
     memcpy(&p_buf[0], &recv_data[13], 5);
-    ret = data_2_klvlist(&recv_data[18], data_len - 5, &list, 1);
+    ret = klv_data_check(&recv_data[18], data_len - 5, 1, NULL);
     if (MTP_OK != ret) {
         TUYA_BLE_LOG_ERROR("cmd rx fail-%d", ret);
         p_buf[5] = 1;
@@ -2024,8 +2027,6 @@ static void tuya_ble_handle_dp_data_write_req(uint8_t *recv_data, uint16_t recv_
         return;
     }
 
-    free_klv_list(list);
-
     event.evt = TUYA_BLE_CB_EVT_DP_DATA_RECEIVED;
 
     uint8_t *ble_cb_evt_buffer = (uint8_t *)tuya_ble_malloc(data_len - 5);
@@ -2126,7 +2127,6 @@ static void tuya_ble_handle_dp_data_with_time_send_response(uint8_t *recv_data,
 static void tuya_ble_handle_dp_write_req(uint8_t *recv_data, uint16_t recv_len)
 {
     mtp_ret ret;
-    klv_node_s *list = NULL;
     uint8_t p_buf[1];
     uint16_t data_len = 0;
     uint32_t ack_sn = 0;
@@ -2146,7 +2146,7 @@ static void tuya_ble_handle_dp_write_req(uint8_t *recv_data, uint16_t recv_len)
         return;
     }
     TUYA_BLE_LOG_HEXDUMP_DEBUG("cmd_dp_write data : ", recv_data + 13, data_len);
-    ret = data_2_klvlist(&recv_data[13], data_len, &list, 0);
+    ret = klv_data_check(&recv_data[13], data_len, 0, NULL);
     if (MTP_OK != ret) {
         TUYA_BLE_LOG_ERROR("cmd rx fail-%d", ret);
         p_buf[0] = 0x01;
@@ -2154,7 +2154,6 @@ static void tuya_ble_handle_dp_write_req(uint8_t *recv_data, uint16_t recv_len)
         return;
     }
 
-    free_klv_list(list);
     p_buf[0] = 0x00;
 
     tuya_ble_commData_send(FRM_CMD_RESP, ack_sn, p_buf, 1, ENCRYPTION_MODE_SESSION_KEY);
@@ -2382,8 +2381,7 @@ void tuya_ble_evt_process(uint16_t cmd, uint8_t *recv_data, uint32_t recv_len)
 uint8_t tuya_ble_commData_send(uint16_t cmd, uint32_t ack_sn, uint8_t *data, uint16_t len, uint8_t encryption_mode)
 {
     mtp_ret ret;
-    uint16_t send_len = 0;
-    uint8_t *p_buf = NULL;
+    trsmitr_iov_s send_iov;
     uint32_t err = 0;
     int8_t retries_cnt = 0;
     uint8_t iv[16];
@@ -2528,16 +2526,14 @@ uint8_t tuya_ble_commData_send(uint16_t cmd, uint32_t ack_sn, uint8_t *data, uin
     }
     trsmitr_init(&ty_trsmitr_proc_send);
     do {
-        ret = trsmitr_send_pkg_encode_with_packet_length(&ty_trsmitr_proc_send, send_packet_data_len, TUYA_BLE_PROTOCOL_VERSION_HIGN,
-                (uint8_t *)(air_send_packet.encrypt_data_buf), air_send_packet.encrypt_data_buf_len);
+        ret = trsmitr_send_pkg_encode_iov(&ty_trsmitr_proc_send, send_packet_data_len, TUYA_BLE_PROTOCOL_VERSION_HIGN,
+                                          (uint8_t *)(air_send_packet.encrypt_data_buf), air_send_packet.encrypt_data_buf_len, &send_iov);
         if (MTP_OK != ret && MTP_TRSMITR_CONTINUE != ret) {
             tuya_ble_free(air_send_packet.encrypt_data_buf);
             return 1;
         }
-        send_len = get_trsmitr_subpkg_len(&ty_trsmitr_proc_send);
-        p_buf = get_trsmitr_subpkg(&ty_trsmitr_proc_send);
         package_number++;
-        tuya_ble_gatt_send_data_enqueue(p_buf, send_len);
+        tuya_ble_gatt_send_data_enqueue_iov(send_iov.head, send_iov.head_len, send_iov.data, send_iov.data_len);
 
     } while (ret == MTP_TRSMITR_CONTINUE);
 
@@ -93,14 +93,33 @@ void tuya_ble_gatt_send_data_handle(void *evt)
 
 
 tuya_ble_status_t tuya_ble_gatt_send_data_enqueue(uint8_t *p_data, uint8_t data_len)
+{
+    return tuya_ble_gatt_send_data_enqueue_iov(p_data, data_len, NULL, 0);
+}
+
+/**
+ *@brief    Enqueue one gatt packet made of head + data, both copied straight into the queue buffer.
+ *
+ *@note     Lets the frame encoder point data at the caller's buffer instead of staging a copy.
+ * */
+tuya_ble_status_t tuya_ble_gatt_send_data_enqueue_iov(uint8_t *p_head, uint8_t head_len, uint8_t *p_data, uint8_t data_len)
 {
     tuya_ble_gatt_send_data_t data   = {0};
 
-    data.buf = tuya_ble_malloc(data_len);
+    if ((uint16_t)head_len + data_len > 0xff) {
+        return TUYA_BLE_ERR_INVALID_LENGTH;
+    }
+
+    data.buf = tuya_ble_malloc(head_len + data_len);
 
     if (data.buf) {
-        memcpy(data.buf, p_data, data_len);
-        data.size = data_len;
+        if (head_len) {
+            memcpy(data.buf, p_head, head_len);
+        }
+        if (data_len) {
+            memcpy(data.buf + head_len, p_data, data_len);
+        }
+        data.size = head_len + data_len;
         if (tuya_ble_enqueue(&gatt_send_queue, &data) == TUYA_BLE_SUCCESS) {
             if (gatt_queue_flag == 0) {
                 gatt_queue_flag = 1;
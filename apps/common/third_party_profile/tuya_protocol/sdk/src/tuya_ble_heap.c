@@ -25,12 +25,17 @@
  *
  * 1 tab == 4 spaces!
  */
+#ifdef TUYA_BLE_HEAP_HOST
+/*PC上的分配轨迹回放(tools/host_test)，堆配置和临界区由测试程序提供*/
+#include "tuya_ble_heap.h"
+#else
 #include "tuya_ble_stdlib.h"
 #include "tuya_ble_heap.h"
 #include "tuya_ble_port.h"
 #include "tuya_ble_internal_config.h"
+#endif
 
-#if (TUYA_BLE_USE_PLATFORM_MEMORY_HEAP==0)
+#if (TUYA_BLE_USE_PLATFORM_MEMORY_HEAP==0) && (TUYA_BLE_HEAP_USE_TLSF==0)
 
 /* Block sizes must not get too small. */
 #define heapMINIMUM_BLOCK_SIZE	( ( uint32_t ) ( xHeapStructSize << 1 ) )
@@ -77,6 +82,9 @@ static BlockLink_t xStart, *pxEnd = NULL;
 fragmentation. */
 static uint32_t xFreeBytesRemaining = 0U;
 static uint32_t xMinimumEverFreeBytesRemaining = 0U;
+static uint32_t xNumberOfSuccessfulAllocations = 0U;
+static uint32_t xNumberOfSuccessfulFrees = 0U;
+static uint32_t xNumberOfFailedAllocations = 0U;
 
 /* Gets set to the top bit of an size_t type.  When this bit in the xBlockSize
 member of an BlockLink_t structure is set then the block belongs to the
@@ -153,7 +161,7 @@ void *pvTuyaPortMalloc(uint32_t xWantedSize)
                         cast is used to prevent byte alignment warnings from the
                         compiler. */
                         pxNewBlockLink = (void *)(((uint8_t *) pxBlock) + xWantedSize);
-                        tuyaASSERT((((uint32_t) pxNewBlockLink) & portBYTE_ALIGNMENT_MASK) == 0);
+                        tuyaASSERT((((portPOINTER_SIZE_TYPE) pxNewBlockLink) & portBYTE_ALIGNMENT_MASK) == 0);
 
                         /* Calculate the sizes of two blocks split from the
                         single block. */
@@ -178,6 +186,7 @@ void *pvTuyaPortMalloc(uint32_t xWantedSize)
                     by the application and has no "next" block. */
                     pxBlock->xBlockSize |= xBlockAllocatedBit;
                     pxBlock->pxNextFreeBlock = NULL;
+                    xNumberOfSuccessfulAllocations++;
                 } else {
                     tuyaCOVERAGE_TEST_MARKER();
                 }
@@ -188,6 +197,10 @@ void *pvTuyaPortMalloc(uint32_t xWantedSize)
             tuyaCOVERAGE_TEST_MARKER();
         }
 
+        if (pvReturn == NULL) {
+            xNumberOfFailedAllocations++;
+        }
+
         tuya_traceMALLOC(pvReturn, xWantedSize);
     }
     (void) tuya_ble_device_exit_critical();
@@ -203,7 +216,7 @@ void *pvTuyaPortMalloc(uint32_t xWantedSize)
     }
 #endif
 
-    tuyaASSERT((((uint32_t) pvReturn) & (uint32_t) portBYTE_ALIGNMENT_MASK) == 0);
+    tuyaASSERT((((portPOINTER_SIZE_TYPE) pvReturn) & (portPOINTER_SIZE_TYPE) portBYTE_ALIGNMENT_MASK) == 0);
     return pvReturn;
 }
 /*-----------------------------------------------------------*/
@@ -235,6 +248,7 @@ void vTuyaPortFree(void *pv)
                 {
                     /* Add this block to the list of free blocks. */
                     xFreeBytesRemaining += pxLink->xBlockSize;
+                    xNumberOfSuccessfulFrees++;
                     tuya_traceFREE(pv, pxLink->xBlockSize);
                     prvInsertBlockIntoFreeList(((BlockLink_t *) pxLink));
                 }
@@ -261,6 +275,40 @@ uint32_t xTuyaPortGetMinimumEverFreeHeapSize(void)
 }
 /*-----------------------------------------------------------*/
 
+void vTuyaPortGetHeapStats(TuyaHeapStats_t *pxHeapStats)
+{
+    BlockLink_t *pxBlock;
+    uint32_t xBlocks = 0, xMaxSize = 0, xMinSize = 0xffffffffUL;
+
+    tuya_ble_device_enter_critical();
+    {
+        if (pxEnd != NULL) {
+            pxBlock = xStart.pxNextFreeBlock;
+            while (pxBlock != pxEnd) {
+                xBlocks++;
+                if (pxBlock->xBlockSize > xMaxSize) {
+                    xMaxSize = pxBlock->xBlockSize;
+                }
+                if (pxBlock->xBlockSize < xMinSize) {
+                    xMinSize = pxBlock->xBlockSize;
+                }
+                pxBlock = pxBlock->pxNextFreeBlock;
+            }
+        }
+
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+        pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xBlocks ? xMinSize : 0;
+        pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xNumberOfFailedAllocations = xNumberOfFailedAllocations;
+    }
+    (void) tuya_ble_device_exit_critical();
+}
+/*-----------------------------------------------------------*/
+
 void vTuyaPortInitialiseBlocks(void)
 {
     /* This just exists to keep the linker quiet. */
@@ -271,16 +319,16 @@ static void prvHeapInit(void)
 {
     BlockLink_t *pxFirstFreeBlock;
     uint8_t *pucAlignedHeap;
-    uint32_t uxAddress;
+    portPOINTER_SIZE_TYPE uxAddress;
     uint32_t xTotalHeapSize = TUYA_BLE_TOTAL_HEAP_SIZE;
 
     /* Ensure the heap starts on a correctly aligned boundary. */
-    uxAddress = (uint32_t) ucHeap;
+    uxAddress = (portPOINTER_SIZE_TYPE) ucHeap;
 
     if ((uxAddress & portBYTE_ALIGNMENT_MASK) != 0) {
         uxAddress += (portBYTE_ALIGNMENT - 1);
-        uxAddress &= ~((uint32_t) portBYTE_ALIGNMENT_MASK);
-        xTotalHeapSize -= uxAddress - (uint32_t) ucHeap;
+        uxAddress &= ~((portPOINTER_SIZE_TYPE) portBYTE_ALIGNMENT_MASK);
+        xTotalHeapSize -= uxAddress - (portPOINTER_SIZE_TYPE) ucHeap;
     }
 
     pucAlignedHeap = (uint8_t *) uxAddress;
@@ -292,9 +340,9 @@ static void prvHeapInit(void)
 
     /* pxEnd is used to mark the end of the list of free blocks and is inserted
     at the end of the heap space. */
-    uxAddress = ((uint32_t) pucAlignedHeap) + xTotalHeapSize;
+    uxAddress = ((portPOINTER_SIZE_TYPE) pucAlignedHeap) + xTotalHeapSize;
     uxAddress -= xHeapStructSize;
-    uxAddress &= ~((uint32_t) portBYTE_ALIGNMENT_MASK);
+    uxAddress &= ~((portPOINTER_SIZE_TYPE) portBYTE_ALIGNMENT_MASK);
     pxEnd = (void *) uxAddress;
     pxEnd->xBlockSize = 0;
     pxEnd->pxNextFreeBlock = NULL;
@@ -302,7 +350,7 @@ static void prvHeapInit(void)
     /* To start with there is a single free block that is sized to take up the
     entire heap space, minus the space taken by pxEnd. */
     pxFirstFreeBlock = (void *) pucAlignedHeap;
-    pxFirstFreeBlock->xBlockSize = uxAddress - (uint32_t) pxFirstFreeBlock;
+    pxFirstFreeBlock->xBlockSize = uxAddress - (portPOINTER_SIZE_TYPE) pxFirstFreeBlock;
     pxFirstFreeBlock->pxNextFreeBlock = pxEnd;
 
     /* Only one block exists - and it covers the entire usable heap space. */
@@ -0,0 +1,526 @@
+/**
+ * \file tuya_ble_heap_tlsf.c
+ *
+ * \brief TLSF (Two-Level Segregated Fit) implementation of the tuya ble private heap.
+ *
+ * Drop-in replacement of tuya_ble_heap.c, selected by TUYA_BLE_HEAP_USE_TLSF.
+ * Free blocks are kept in power-of-two size classes, each split into
+ * tlsfSL_INDEX_COUNT linear sub-classes, and two bitmaps locate a suitable
+ * list with one find-first-set, so malloc and free are O(1) and do not depend
+ * on how fragmented the arena is. Neighbouring free blocks are merged on free
+ * through the physical block chain.
+ */
+
+#ifdef TUYA_BLE_HEAP_HOST
+/*PC上的分配轨迹回放(tools/host_test)，堆配置和临界区由测试程序提供*/
+#include "tuya_ble_heap.h"
+#else
+#include "tuya_ble_stdlib.h"
+#include "tuya_ble_heap.h"
+#include "tuya_ble_port.h"
+#include "tuya_ble_internal_config.h"
+#endif
+
+#if (TUYA_BLE_USE_PLATFORM_MEMORY_HEAP==0) && TUYA_BLE_HEAP_USE_TLSF
+
+#if portBYTE_ALIGNMENT != 4
+#error "TLSF heap requires portBYTE_ALIGNMENT 4"
+#endif
+
+/* Each first level range [2^n, 2^(n+1)) is split into 4 linear lists. */
+#define tlsfSL_INDEX_COUNT_LOG2		2
+#define tlsfSL_INDEX_COUNT			(1 << tlsfSL_INDEX_COUNT_LOG2)
+#define tlsfALIGN_SIZE_LOG2			2
+
+/* Blocks smaller than tlsfSMALL_BLOCK_SIZE all live in first level 0. */
+#define tlsfFL_INDEX_SHIFT			(tlsfSL_INDEX_COUNT_LOG2 + tlsfALIGN_SIZE_LOG2)
+#define tlsfSMALL_BLOCK_SIZE		(1 << tlsfFL_INDEX_SHIFT)
+
+#if TUYA_BLE_TOTAL_HEAP_SIZE < (1 << 13)
+#define tlsfFL_INDEX_MAX			13
+#elif TUYA_BLE_TOTAL_HEAP_SIZE < (1 << 14)
+#define tlsfFL_INDEX_MAX			14
+#elif TUYA_BLE_TOTAL_HEAP_SIZE < (1 << 15)
+#define tlsfFL_INDEX_MAX			15
+#elif TUYA_BLE_TOTAL_HEAP_SIZE < (1 << 16)
+#define tlsfFL_INDEX_MAX			16
+#else
+#error "TUYA_BLE_TOTAL_HEAP_SIZE too large for TLSF heap"
+#endif
+#define tlsfFL_INDEX_COUNT			(tlsfFL_INDEX_MAX - tlsfFL_INDEX_SHIFT + 1)
+
+/* xSize low bits: the block itself is free / the physically previous block is free. */
+#define tlsfBLOCK_FREE_BIT			((uint32_t) 1)
+#define tlsfBLOCK_PREV_FREE_BIT		((uint32_t) 2)
+#define tlsfBLOCK_SIZE_MASK			(~(tlsfBLOCK_FREE_BIT | tlsfBLOCK_PREV_FREE_BIT))
+
+static uint8_t ucHeap[ TUYA_BLE_TOTAL_HEAP_SIZE ];
+
+/* pxPrevPhysBlock is stored in the last word of the previous block and is
+only valid while that block is free. pxNextFree/pxPrevFree overlay the user
+data and are only valid while this block is free. */
+typedef struct TLSF_BLOCK {
+    struct TLSF_BLOCK *pxPrevPhysBlock;
+    uint32_t xSize;								/*<< Payload size plus the flag bits. */
+    struct TLSF_BLOCK *pxNextFree;
+    struct TLSF_BLOCK *pxPrevFree;
+} TlsfBlock_t;
+
+/* Only the size word is overhead for a used block. The next block header
+starts tlsfBLOCK_LINK_SIZE bytes before the end of the payload, so that its
+pxPrevPhysBlock overlays the tail of this block; on a 32-bit target both are 4. */
+#define tlsfBLOCK_OVERHEAD			((uint32_t) sizeof(uint32_t))
+#define tlsfBLOCK_LINK_SIZE			((uint32_t) sizeof(TlsfBlock_t *))
+#define tlsfBLOCK_START_OFFSET		((uint32_t) (sizeof(TlsfBlock_t *) + sizeof(uint32_t)))
+/* A free payload must hold the free list links and, at its tail, the next
+block's pxPrevPhysBlock (the struct may be padded after xSize). */
+#define tlsfBLOCK_SIZE_MIN			((uint32_t) (sizeof(TlsfBlock_t) - tlsfBLOCK_START_OFFSET + tlsfBLOCK_LINK_SIZE))
+#define tlsfBLOCK_SIZE_MAX			((uint32_t) 1 << tlsfFL_INDEX_MAX)
+
+/*-----------------------------------------------------------*/
+
+/* Empty lists point at xNullBlock instead of NULL. */
+static TlsfBlock_t xNullBlock;
+static uint32_t ulFlBitmap;
+static uint32_t ulSlBitmap[ tlsfFL_INDEX_COUNT ];
+static TlsfBlock_t *pxBlocks[ tlsfFL_INDEX_COUNT ][ tlsfSL_INDEX_COUNT ];
+static uint8_t ucHeapReady = 0;
+
+static uint32_t xFreeBytesRemaining = 0U;
+static uint32_t xMinimumEverFreeBytesRemaining = 0U;
+static uint32_t xNumberOfSuccessfulAllocations = 0U;
+static uint32_t xNumberOfSuccessfulFrees = 0U;
+static uint32_t xNumberOfFailedAllocations = 0U;
+
+static void prvHeapInit(void);
+
+/*-----------------------------------------------------------*/
+
+static inline int prvFls(uint32_t x)
+{
+    return 31 - __builtin_clz(x);
+}
+
+static inline int prvFfs(uint32_t x)
+{
+    return __builtin_ctz(x);
+}
+
+static inline uint32_t prvBlockSize(const TlsfBlock_t *pxBlock)
+{
+    return pxBlock->xSize & tlsfBLOCK_SIZE_MASK;
+}
+
+static inline void prvBlockSetSize(TlsfBlock_t *pxBlock, uint32_t xSize)
+{
+    pxBlock->xSize = xSize | (pxBlock->xSize & ~tlsfBLOCK_SIZE_MASK);
+}
+
+static inline void *prvBlockToPtr(const TlsfBlock_t *pxBlock)
+{
+    return (void *)(((uint8_t *) pxBlock) + tlsfBLOCK_START_OFFSET);
+}
+
+static inline TlsfBlock_t *prvBlockFromPtr(const void *pv)
+{
+    return (TlsfBlock_t *)(((uint8_t *) pv) - tlsfBLOCK_START_OFFSET);
+}
+
+static inline TlsfBlock_t *prvBlockNext(const TlsfBlock_t *pxBlock)
+{
+    return (TlsfBlock_t *)(((uint8_t *) prvBlockToPtr(pxBlock)) + prvBlockSize(pxBlock) - tlsfBLOCK_LINK_SIZE);
+}
+
+static inline TlsfBlock_t *prvBlockLinkNext(TlsfBlock_t *pxBlock)
+{
+    TlsfBlock_t *pxNext = prvBlockNext(pxBlock);
+    pxNext->pxPrevPhysBlock = pxBlock;
+    return pxNext;
+}
+
+static inline void prvBlockMarkAsFree(TlsfBlock_t *pxBlock)
+{
+    TlsfBlock_t *pxNext = prvBlockLinkNext(pxBlock);
+    pxNext->xSize |= tlsfBLOCK_PREV_FREE_BIT;
+    pxBlock->xSize |= tlsfBLOCK_FREE_BIT;
+}
+
+static inline void prvBlockMarkAsUsed(TlsfBlock_t *pxBlock)
+{
+    TlsfBlock_t *pxNext = prvBlockNext(pxBlock);
+    pxNext->xSize &= ~tlsfBLOCK_PREV_FREE_BIT;
+    pxBlock->xSize &= ~tlsfBLOCK_FREE_BIT;
+}
+
+/*-----------------------------------------------------------*/
+
+/* Size to list index, used when inserting a free block. */
+static inline void prvMappingInsert(uint32_t xSize, int *pxFl, int *pxSl)
+{
+    int xFl, xSl;
+
+    if (xSize < tlsfSMALL_BLOCK_SIZE) {
+        xFl = 0;
+        xSl = (int) xSize / (tlsfSMALL_BLOCK_SIZE / tlsfSL_INDEX_COUNT);
+    } else {
+        xFl = prvFls(xSize);
+        xSl = (int)(xSize >> (xFl - tlsfSL_INDEX_COUNT_LOG2)) ^ tlsfSL_INDEX_COUNT;
+        xFl -= (tlsfFL_INDEX_SHIFT - 1);
+    }
+    *pxFl = xFl;
+    *pxSl = xSl;
+}
+
+/* Same as prvMappingInsert but rounded up to the next list, so that any block
+found in the returned list (or above) is large enough. */
+static inline void prvMappingSearch(uint32_t xSize, int *pxFl, int *pxSl)
+{
+    if (xSize >= tlsfSMALL_BLOCK_SIZE) {
+        xSize += (((uint32_t) 1) << (prvFls(xSize) - tlsfSL_INDEX_COUNT_LOG2)) - 1;
+    }
+    prvMappingInsert(xSize, pxFl, pxSl);
+}
+
+static TlsfBlock_t *prvSearchSuitableBlock(int *pxFl, int *pxSl)
+{
+    int xFl = *pxFl;
+    int xSl = *pxSl;
+    uint32_t ulSlMap, ulFlMap;
+
+    ulSlMap = ulSlBitmap[xFl] & (~((uint32_t) 0) << xSl);
+    if (!ulSlMap) {
+        ulFlMap = ulFlBitmap & (~((uint32_t) 0) << (xFl + 1));
+        if (!ulFlMap) {
+            return NULL;
+        }
+        xFl = prvFfs(ulFlMap);
+        ulSlMap = ulSlBitmap[xFl];
+    }
+    xSl = prvFfs(ulSlMap);
+
+    *pxFl = xFl;
+    *pxSl = xSl;
+    return pxBlocks[xFl][xSl];
+}
+
+/* Fallback when the rounded up search finds nothing: the list xSize itself maps
+to may still hold a block that is large enough (e.g. the single arena sized
+block, whose class rounds up past tlsfFL_INDEX_MAX). Walk that one list. */
+static TlsfBlock_t *prvSearchExactClass(uint32_t xSize, int *pxFl, int *pxSl)
+{
+    TlsfBlock_t *pxBlock;
+
+    prvMappingInsert(xSize, pxFl, pxSl);
+    if (*pxFl >= tlsfFL_INDEX_COUNT) {
+        return NULL;
+    }
+    for (pxBlock = pxBlocks[*pxFl][*pxSl]; pxBlock != &xNullBlock; pxBlock = pxBlock->pxNextFree) {
+        if (prvBlockSize(pxBlock) >= xSize) {
+            return pxBlock;
+        }
+    }
+    return NULL;
+}
+
+static void prvRemoveFreeBlock(TlsfBlock_t *pxBlock, int xFl, int xSl)
+{
+    TlsfBlock_t *pxPrev = pxBlock->pxPrevFree;
+    TlsfBlock_t *pxNext = pxBlock->pxNextFree;
+
+    pxNext->pxPrevFree = pxPrev;
+    pxPrev->pxNextFree = pxNext;
+
+    if (pxBlocks[xFl][xSl] == pxBlock) {
+        pxBlocks[xFl][xSl] = pxNext;
+        if (pxNext == &xNullBlock) {
+            ulSlBitmap[xFl] &= ~(((uint32_t) 1) << xSl);
+            if (!ulSlBitmap[xFl]) {
+                ulFlBitmap &= ~(((uint32_t) 1) << xFl);
+            }
+        }
+    }
+}
+
+static void prvInsertFreeBlock(TlsfBlock_t *pxBlock, int xFl, int xSl)
+{
+    TlsfBlock_t *pxCurrent = pxBlocks[xFl][xSl];
+
+    pxBlock->pxNextFree = pxCurrent;
+    pxBlock->pxPrevFree = &xNullBlock;
+    pxCurrent->pxPrevFree = pxBlock;
+
+    pxBlocks[xFl][xSl] = pxBlock;
+    ulFlBitmap |= ((uint32_t) 1) << xFl;
+    ulSlBitmap[xFl] |= ((uint32_t) 1) << xSl;
+}
+
+static void prvBlockRemove(TlsfBlock_t *pxBlock)
+{
+    int xFl, xSl;
+
+    prvMappingInsert(prvBlockSize(pxBlock), &xFl, &xSl);
+    prvRemoveFreeBlock(pxBlock, xFl, xSl);
+}
+
+static void prvBlockInsert(TlsfBlock_t *pxBlock)
+{
+    int xFl, xSl;
+
+    prvMappingInsert(prvBlockSize(pxBlock), &xFl, &xSl);
+    prvInsertFreeBlock(pxBlock, xFl, xSl);
+}
+
+/*-----------------------------------------------------------*/
+
+/* Give the tail of a free block beyond xSize back to the free lists. */
+static void prvBlockTrimFree(TlsfBlock_t *pxBlock, uint32_t xSize)
+{
+    TlsfBlock_t *pxRemaining;
+    uint32_t xRemainSize;
+
+    if (prvBlockSize(pxBlock) < sizeof(TlsfBlock_t) + xSize) {
+        tuyaCOVERAGE_TEST_MARKER();
+        return;
+    }
+
+    pxRemaining = (TlsfBlock_t *)(((uint8_t *) prvBlockToPtr(pxBlock)) + xSize - tlsfBLOCK_LINK_SIZE);
+    xRemainSize = prvBlockSize(pxBlock) - (xSize + tlsfBLOCK_OVERHEAD);
+    tuyaASSERT((((portPOINTER_SIZE_TYPE) prvBlockToPtr(pxRemaining)) & portBYTE_ALIGNMENT_MASK) == 0);
+
+    pxRemaining->xSize = xRemainSize;
+    prvBlockSetSize(pxBlock, xSize);
+    prvBlockMarkAsFree(pxRemaining);
+
+    prvBlockLinkNext(pxBlock);
+    pxRemaining->xSize |= tlsfBLOCK_PREV_FREE_BIT;
+    prvBlockInsert(pxRemaining);
+}
+
+static TlsfBlock_t *prvBlockAbsorb(TlsfBlock_t *pxPrev, TlsfBlock_t *pxBlock)
+{
+    pxPrev->xSize += prvBlockSize(pxBlock) + tlsfBLOCK_OVERHEAD;
+    prvBlockLinkNext(pxPrev);
+    return pxPrev;
+}
+
+static TlsfBlock_t *prvBlockMergePrev(TlsfBlock_t *pxBlock)
+{
+    TlsfBlock_t *pxPrev;
+
+    if (pxBlock->xSize & tlsfBLOCK_PREV_FREE_BIT) {
+        pxPrev = pxBlock->pxPrevPhysBlock;
+        tuyaASSERT((pxPrev->xSize & tlsfBLOCK_FREE_BIT) != 0);
+        prvBlockRemove(pxPrev);
+        pxBlock = prvBlockAbsorb(pxPrev, pxBlock);
+    }
+    return pxBlock;
+}
+
+static TlsfBlock_t *prvBlockMergeNext(TlsfBlock_t *pxBlock)
+{
+    TlsfBlock_t *pxNext = prvBlockNext(pxBlock);
+
+    if (pxNext->xSize & tlsfBLOCK_FREE_BIT) {
+        prvBlockRemove(pxNext);
+        pxBlock = prvBlockAbsorb(pxBlock, pxNext);
+    }
+    return pxBlock;
+}
+
+/*-----------------------------------------------------------*/
+
+void *pvTuyaPortMalloc(uint32_t xWantedSize)
+{
+    TlsfBlock_t *pxBlock = NULL;
+    void *pvReturn = NULL;
+    int xFl, xSl;
+
+    tuya_ble_device_enter_critical();
+    {
+        if (!ucHeapReady) {
+            prvHeapInit();
+        }
+
+        if ((xWantedSize > 0) && (xWantedSize < tlsfBLOCK_SIZE_MAX)) {
+            xWantedSize = (xWantedSize + portBYTE_ALIGNMENT_MASK) & ~((uint32_t) portBYTE_ALIGNMENT_MASK);
+            if (xWantedSize < tlsfBLOCK_SIZE_MIN) {
+                xWantedSize = tlsfBLOCK_SIZE_MIN;
+            }
+
+            prvMappingSearch(xWantedSize, &xFl, &xSl);
+            if (xFl < tlsfFL_INDEX_COUNT) {
+                pxBlock = prvSearchSuitableBlock(&xFl, &xSl);
+            }
+            if (pxBlock == NULL) {
+                pxBlock = prvSearchExactClass(xWantedSize, &xFl, &xSl);
+            }
+        }
+
+        if (pxBlock != NULL) {
+            tuyaASSERT(prvBlockSize(pxBlock) >= xWantedSize);
+            prvRemoveFreeBlock(pxBlock, xFl, xSl);
+            prvBlockTrimFree(pxBlock, xWantedSize);
+            prvBlockMarkAsUsed(pxBlock);
+            pvReturn = prvBlockToPtr(pxBlock);
+
+            xFreeBytesRemaining -= prvBlockSize(pxBlock) + tlsfBLOCK_OVERHEAD;
+            if (xFreeBytesRemaining < xMinimumEverFreeBytesRemaining) {
+                xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+            }
+            xNumberOfSuccessfulAllocations++;
+        } else {
+            xNumberOfFailedAllocations++;
+        }
+
+        tuya_traceMALLOC(pvReturn, xWantedSize);
+    }
+    (void) tuya_ble_device_exit_critical();
+
+#if( tuyaUSE_MALLOC_FAILED_HOOK == 1 )
+    {
+        if (pvReturn == NULL) {
+            extern void vApplicationMallocFailedHook(void);
+            vApplicationMallocFailedHook();
+        } else {
+            tuyaCOVERAGE_TEST_MARKER();
+        }
+    }
+#endif
+
+    tuyaASSERT((((portPOINTER_SIZE_TYPE) pvReturn) & (portPOINTER_SIZE_TYPE) portBYTE_ALIGNMENT_MASK) == 0);
+    return pvReturn;
+}
+/*-----------------------------------------------------------*/
+
+void vTuyaPortFree(void *pv)
+{
+    TlsfBlock_t *pxBlock;
+
+    if (pv == NULL) {
+        return;
+    }
+
+    pxBlock = prvBlockFromPtr(pv);
+
+    /* Check the block is actually allocated. */
+    tuyaASSERT((pxBlock->xSize & tlsfBLOCK_FREE_BIT) == 0);
+    if (pxBlock->xSize & tlsfBLOCK_FREE_BIT) {
+        return;
+    }
+
+    tuya_ble_device_enter_critical();
+    {
+        xFreeBytesRemaining += prvBlockSize(pxBlock) + tlsfBLOCK_OVERHEAD;
+        xNumberOfSuccessfulFrees++;
+        tuya_traceFREE(pv, prvBlockSize(pxBlock));
+
+        prvBlockMarkAsFree(pxBlock);
+        pxBlock = prvBlockMergePrev(pxBlock);
+        pxBlock = prvBlockMergeNext(pxBlock);
+        prvBlockInsert(pxBlock);
+    }
+    (void) tuya_ble_device_exit_critical();
+}
+/*-----------------------------------------------------------*/
+
+uint32_t xTuyaPortGetFreeHeapSize(void)
+{
+    return xFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t xTuyaPortGetMinimumEverFreeHeapSize(void)
+{
+    return xMinimumEverFreeBytesRemaining;
+}
+/*-----------------------------------------------------------*/
+
+void vTuyaPortGetHeapStats(TuyaHeapStats_t *pxHeapStats)
+{
+    TlsfBlock_t *pxBlock;
+    uint32_t xBlocks = 0, xMaxSize = 0, xMinSize = 0xffffffffUL, xSize;
+    int xFl, xSl;
+
+    tuya_ble_device_enter_critical();
+    {
+        for (xFl = 0; xFl < tlsfFL_INDEX_COUNT; xFl++) {
+            if (!(ulFlBitmap & (((uint32_t) 1) << xFl))) {
+                continue;
+            }
+            for (xSl = 0; xSl < tlsfSL_INDEX_COUNT; xSl++) {
+                for (pxBlock = pxBlocks[xFl][xSl]; pxBlock != &xNullBlock; pxBlock = pxBlock->pxNextFree) {
+                    xSize = prvBlockSize(pxBlock) + tlsfBLOCK_OVERHEAD;
+                    xBlocks++;
+                    if (xSize > xMaxSize) {
+                        xMaxSize = xSize;
+                    }
+                    if (xSize < xMinSize) {
+                        xMinSize = xSize;
+                    }
+                }
+            }
+        }
+
+        pxHeapStats->xAvailableHeapSpaceInBytes = xFreeBytesRemaining;
+        pxHeapStats->xSizeOfLargestFreeBlockInBytes = xMaxSize;
+        pxHeapStats->xSizeOfSmallestFreeBlockInBytes = xBlocks ? xMinSize : 0;
+        pxHeapStats->xNumberOfFreeBlocks = xBlocks;
+        pxHeapStats->xMinimumEverFreeBytesRemaining = xMinimumEverFreeBytesRemaining;
+        pxHeapStats->xNumberOfSuccessfulAllocations = xNumberOfSuccessfulAllocations;
+        pxHeapStats->xNumberOfSuccessfulFrees = xNumberOfSuccessfulFrees;
+        pxHeapStats->xNumberOfFailedAllocations = xNumberOfFailedAllocations;
+    }
+    (void) tuya_ble_device_exit_critical();
+}
+/*-----------------------------------------------------------*/
+
+void vTuyaPortInitialiseBlocks(void)
+{
+    /* This just exists to keep the linker quiet. */
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapInit(void)
+{
+    TlsfBlock_t *pxBlock, *pxSentinel;
+    portPOINTER_SIZE_TYPE uxAddress;
+    uint32_t xTotalHeapSize = TUYA_BLE_TOTAL_HEAP_SIZE;
+    int xFl, xSl;
+
+    xNullBlock.pxNextFree = &xNullBlock;
+    xNullBlock.pxPrevFree = &xNullBlock;
+    ulFlBitmap = 0;
+    for (xFl = 0; xFl < tlsfFL_INDEX_COUNT; xFl++) {
+        ulSlBitmap[xFl] = 0;
+        for (xSl = 0; xSl < tlsfSL_INDEX_COUNT; xSl++) {
+            pxBlocks[xFl][xSl] = &xNullBlock;
+        }
+    }
+
+    /* Ensure the heap starts on a correctly aligned boundary. */
+    uxAddress = (portPOINTER_SIZE_TYPE) ucHeap;
+    if ((uxAddress & portBYTE_ALIGNMENT_MASK) != 0) {
+        uxAddress += (portBYTE_ALIGNMENT - 1);
+        uxAddress &= ~((portPOINTER_SIZE_TYPE) portBYTE_ALIGNMENT_MASK);
+        xTotalHeapSize -= uxAddress - (portPOINTER_SIZE_TYPE) ucHeap;
+    }
+    xTotalHeapSize &= ~((uint32_t) portBYTE_ALIGNMENT_MASK);
+
+    /* One free block covering the arena, followed by a zero sized used
+    sentinel so that the last block always has a physical successor. The
+    first block has no predecessor, its pxPrevPhysBlock word is unused. */
+    pxBlock = (TlsfBlock_t *) uxAddress;
+    pxBlock->xSize = xTotalHeapSize - tlsfBLOCK_START_OFFSET - tlsfBLOCK_OVERHEAD;
+    pxBlock->xSize |= tlsfBLOCK_FREE_BIT;
+
+    pxSentinel = prvBlockLinkNext(pxBlock);
+    pxSentinel->xSize = 0 | tlsfBLOCK_PREV_FREE_BIT;
+
+    prvBlockInsert(pxBlock);
+
+    xFreeBytesRemaining = prvBlockSize(pxBlock) + tlsfBLOCK_OVERHEAD;
+    xMinimumEverFreeBytesRemaining = xFreeBytesRemaining;
+    ucHeapReady = 1;
+}
+
+#endif
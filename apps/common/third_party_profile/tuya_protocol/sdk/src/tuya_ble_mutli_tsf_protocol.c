@@ -170,25 +170,17 @@ static frame_seq_t get_frame_seq(void) //Because this type of data is not used t
 }
 
 /***********************************************************
-*  Function: trsmitr_send_pkg_encode
-*  description: frm_trsmitr->transmitter handle
-*               type->frame type
-*               buf->data buf
-*               len->data len
-*  Input:
-*  Output:
-*  Return: MTP_OK->buf send up
-*          MTP_TRSMITR_CONTINUE->need call again to be continue
-*          other->error
-*  Note: could get from encode data len and encode data by calling method
-         get_trsmitr_subpkg_len() and get_trsmitr_subpkg()
+*  Function: trsmitr_subpkg_prepare
+*  description: encode the sub-package head into frm_trsmitr->subpkg
+*               and work out how many data bytes this sub-package carries
+*  Input: pkg_len_max->sub-package length limit, head included
+*  Output: head_len->encoded head len
+*          data_len->data len of this sub-package
+*  Return: MTP_OK or error
 ***********************************************************/
-mtp_ret trsmitr_send_pkg_encode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t version, uint8_t *buf, uint32_t len)
+static mtp_ret trsmitr_subpkg_prepare(frm_trsmitr_proc_s *frm_trsmitr, uint32_t pkg_len_max, uint8_t version, uint32_t len, \
+                                      uint16_t *head_len, uint16_t *data_len)
 {
-    if (((void *)0) == frm_trsmitr) {
-        return MTP_INVALID_PARAM;
-    }
-
     if (FRM_PKG_INIT == frm_trsmitr->pkg_desc) {
         frm_trsmitr->total = len;
         frm_trsmitr->version = version;
@@ -240,16 +232,32 @@ mtp_ret trsmitr_send_pkg_encode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t version
         frm_trsmitr->subpkg[sunpkg_offset++] = (frm_trsmitr->version << 0x04) | (frm_trsmitr->seq & 0x0f);
     }
 
+    if (pkg_len_max <= sunpkg_offset) {
+        return MTP_INVALID_PARAM;
+    }
+
     // frame data transfer
-    uint16_t send_data_len = (SNGL_PKG_TRSFR_LMT - sunpkg_offset);
+    uint16_t send_data_len = (pkg_len_max - sunpkg_offset);
     if ((len - frm_trsmitr->pkg_trsmitr_cnt) < send_data_len) {
         send_data_len = len - frm_trsmitr->pkg_trsmitr_cnt;
     }
 
-    memcpy(&(frm_trsmitr->subpkg[sunpkg_offset]), buf + frm_trsmitr->pkg_trsmitr_cnt, send_data_len);
-    frm_trsmitr->subpkg_len = sunpkg_offset + send_data_len;
+    *head_len = sunpkg_offset;
+    *data_len = send_data_len;
+    return MTP_OK;
+}
 
-    frm_trsmitr->pkg_trsmitr_cnt += send_data_len;
+/***********************************************************
+*  Function: trsmitr_subpkg_commit
+*  description: account a sub-package as sent and step to the next one
+*  Input: data_len->data len of the sub-package
+*  Output:
+*  Return: MTP_OK->buf send up
+*          MTP_TRSMITR_CONTINUE->need call again to be continue
+***********************************************************/
+static mtp_ret trsmitr_subpkg_commit(frm_trsmitr_proc_s *frm_trsmitr, uint16_t data_len)
+{
+    frm_trsmitr->pkg_trsmitr_cnt += data_len;
     if (0 == frm_trsmitr->subpkg_num) {
         frm_trsmitr->pkg_desc = FRM_PKG_FIRST;
     } else {
@@ -265,6 +273,25 @@ mtp_ret trsmitr_send_pkg_encode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t version
     return MTP_OK;
 }
 
+/***********************************************************
+*  Function: trsmitr_send_pkg_encode
+*  description: frm_trsmitr->transmitter handle
+*               type->frame type
+*               buf->data buf
+*               len->data len
+*  Input:
+*  Output:
+*  Return: MTP_OK->buf send up
+*          MTP_TRSMITR_CONTINUE->need call again to be continue
+*          other->error
+*  Note: could get from encode data len and encode data by calling method
+         get_trsmitr_subpkg_len() and get_trsmitr_subpkg()
+***********************************************************/
+mtp_ret trsmitr_send_pkg_encode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t version, uint8_t *buf, uint32_t len)
+{
+    return trsmitr_send_pkg_encode_with_packet_length(frm_trsmitr, SNGL_PKG_TRSFR_LMT, version, buf, len);
+}
+
 /***********************************************************
 *  Function: trsmitr_send_pkg_encode_with_packet_length
 *  description: Encoding function for specifying sub-packet length
@@ -281,6 +308,9 @@ mtp_ret trsmitr_send_pkg_encode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t version
 ***********************************************************/
 mtp_ret trsmitr_send_pkg_encode_with_packet_length(frm_trsmitr_proc_s *frm_trsmitr, uint32_t pkg_len_max, uint8_t version, uint8_t *buf, uint32_t len)
 {
+    mtp_ret ret;
+    uint16_t head_len, data_len;
+
     if (((void *)0) == frm_trsmitr) {
         return MTP_INVALID_PARAM;
     }
@@ -289,85 +319,68 @@ mtp_ret trsmitr_send_pkg_encode_with_packet_length(frm_trsmitr_proc_s *frm_trsmi
         return MTP_INVALID_PARAM;
     }
 
-    if (FRM_PKG_INIT == frm_trsmitr->pkg_desc) {
-        frm_trsmitr->total = len;
-        frm_trsmitr->version = version;
-        frm_trsmitr->seq = get_frame_seq();
-        frm_trsmitr->subpkg_num = 0;
-        frm_trsmitr->pkg_trsmitr_cnt = 0;
-    }
-
-    if (frm_trsmitr->subpkg_num >= 0x10000000 || len >= 0x10000000) {
-        return MTP_COM_ERROR;
+    ret = trsmitr_subpkg_prepare(frm_trsmitr, pkg_len_max, version, len, &head_len, &data_len);
+    if (MTP_OK != ret) {
+        return ret;
     }
 
-    uint16_t sunpkg_offset = 0;
+    memcpy(&(frm_trsmitr->subpkg[head_len]), buf + frm_trsmitr->pkg_trsmitr_cnt, data_len);
+    frm_trsmitr->subpkg_len = head_len + data_len;
 
-    // package code
-    // subpackage num encode
-    int32_t i;
-    uint32_t tmp = 0;
-    tmp = frm_trsmitr->subpkg_num;
-    for (i = 0; i < 4; i++) {
-        frm_trsmitr->subpkg[sunpkg_offset] = tmp % 0x80;
-        if ((tmp / 0x80)) {
-            frm_trsmitr->subpkg[sunpkg_offset] |= 0x80;
-        }
-        sunpkg_offset++;
-        tmp /= 0x80;
-        if (0 == tmp) {
-            break;
-        }
-    }
+    return trsmitr_subpkg_commit(frm_trsmitr, data_len);
+}
 
-    // the first package include the frame total len
-    if (0 == frm_trsmitr->subpkg_num) {
-        // frame len encode
-        tmp = len;
-        for (i = 0; i < 4; i++) {
-            frm_trsmitr->subpkg[sunpkg_offset] = tmp % 0x80;
-            if ((tmp / 0x80)) {
-                frm_trsmitr->subpkg[sunpkg_offset] |= 0x80;
-            }
-            sunpkg_offset++;
-            tmp /= 0x80;
-            if (0 == tmp) {
-                break;
-            }
-        }
+/***********************************************************
+*  Function: trsmitr_send_pkg_encode_iov
+*  description: same as trsmitr_send_pkg_encode_with_packet_length,
+*               but the sub-package data is not copied, iov->data
+*               points into the caller's buf
+*  Input:
+*  Output: iov->sub-package head and data
+*  Return: MTP_OK->buf send up
+*          MTP_TRSMITR_CONTINUE->need call again to be continue
+*          other->error
+*  Note: iov->head is frm_trsmitr->subpkg and is overwritten by the next
+*        call, buf must stay valid until the sub-package is consumed.
+***********************************************************/
+mtp_ret trsmitr_send_pkg_encode_iov(frm_trsmitr_proc_s *frm_trsmitr, uint32_t pkg_len_max, uint8_t version, uint8_t *buf, uint32_t len, \
+                                    trsmitr_iov_s *iov)
+{
+    mtp_ret ret;
+    uint16_t head_len, data_len;
 
-        // frame type and frame seq
-        frm_trsmitr->subpkg[sunpkg_offset++] = (frm_trsmitr->version << 0x04) | (frm_trsmitr->seq & 0x0f);
+    if (((void *)0) == frm_trsmitr || ((void *)0) == iov) {
+        return MTP_INVALID_PARAM;
     }
 
-    // frame data transfer
-    uint16_t send_data_len = (pkg_len_max - sunpkg_offset);
-    if ((len - frm_trsmitr->pkg_trsmitr_cnt) < send_data_len) {
-        send_data_len = len - frm_trsmitr->pkg_trsmitr_cnt;
+    if ((pkg_len_max == 0) || (pkg_len_max > SNGL_PKG_TRSFR_LMT)) {
+        return MTP_INVALID_PARAM;
     }
 
-    memcpy(&(frm_trsmitr->subpkg[sunpkg_offset]), buf + frm_trsmitr->pkg_trsmitr_cnt, send_data_len);
-    frm_trsmitr->subpkg_len = sunpkg_offset + send_data_len;
-
-    frm_trsmitr->pkg_trsmitr_cnt += send_data_len;
-    if (0 == frm_trsmitr->subpkg_num) {
-        frm_trsmitr->pkg_desc = FRM_PKG_FIRST;
-    } else {
-        frm_trsmitr->pkg_desc = FRM_PKG_MIDDLE;
+    ret = trsmitr_subpkg_prepare(frm_trsmitr, pkg_len_max, version, len, &head_len, &data_len);
+    if (MTP_OK != ret) {
+        return ret;
     }
 
-    if (frm_trsmitr->pkg_trsmitr_cnt < frm_trsmitr->total) {
-        frm_trsmitr->subpkg_num++;
-        return MTP_TRSMITR_CONTINUE;
-    }
+    iov->head = frm_trsmitr->subpkg;
+    iov->head_len = head_len;
+    iov->data = buf + frm_trsmitr->pkg_trsmitr_cnt;
+    iov->data_len = data_len;
+    frm_trsmitr->subpkg_len = head_len + data_len;
 
-    frm_trsmitr->pkg_desc = FRM_PKG_END;
-    return MTP_OK;
+    return trsmitr_subpkg_commit(frm_trsmitr, data_len);
 }
 
-
-
-mtp_ret trsmitr_recv_pkg_decode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_data, uint16_t raw_data_len)
+/***********************************************************
+*  Function: trsmitr_recv_pkg_parse
+*  description: parse the sub-package head and update transmitter state
+*  Input:
+*  Output: data->sub-package data inside raw_data
+*          data_len->sub-package data len
+*  Return: MTP_OK or error, MTP_TRSMITR_CONTINUE for a repeated sub-package
+***********************************************************/
+static mtp_ret trsmitr_recv_pkg_parse(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_data, uint16_t raw_data_len, \
+                                      uint8_t **data, uint16_t *data_len)
 {
     if (NULL == raw_data || (raw_data_len > SNGL_PKG_TRSFR_LMT) || NULL == frm_trsmitr) {
         return MTP_INVALID_PARAM;
@@ -453,8 +466,24 @@ mtp_ret trsmitr_recv_pkg_decode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_da
         recv_data_len = frm_trsmitr->total - frm_trsmitr->pkg_trsmitr_cnt;
     }
 
+    *data = &raw_data[sunpkg_offset];
+    *data_len = recv_data_len;
+    return MTP_OK;
+}
+
+mtp_ret trsmitr_recv_pkg_decode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_data, uint16_t raw_data_len)
+{
+    uint8_t *data;
+    uint16_t recv_data_len;
+    mtp_ret ret;
+
+    ret = trsmitr_recv_pkg_parse(frm_trsmitr, raw_data, raw_data_len, &data, &recv_data_len);
+    if (MTP_OK != ret) {
+        return ret;
+    }
+
     // decode data cp to transmitter subpackage buf
-    memcpy(frm_trsmitr->subpkg, &raw_data[sunpkg_offset], recv_data_len);
+    memcpy(frm_trsmitr->subpkg, data, recv_data_len);
     frm_trsmitr->subpkg_len = recv_data_len;
     frm_trsmitr->pkg_trsmitr_cnt += recv_data_len;
 
@@ -464,6 +493,44 @@ mtp_ret trsmitr_recv_pkg_decode(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_da
     //cannot add 'frm_trsmitr->pkg_desc = FRM_PKG_END;' here.
     return MTP_OK;
 }
+
+/***********************************************************
+*  Function: trsmitr_recv_pkg_decode_in_place
+*  description: same as trsmitr_recv_pkg_decode, but the sub-package
+*               data is left in raw_data instead of frm_trsmitr->subpkg
+*  Input:
+*  Output: data->sub-package data inside raw_data, len is
+*                get_trsmitr_subpkg_len()
+*  Return: MTP_OK->buf receive up
+*          MTP_TRSMITR_CONTINUE->need call again to be continue
+*          other->error
+***********************************************************/
+mtp_ret trsmitr_recv_pkg_decode_in_place(frm_trsmitr_proc_s *frm_trsmitr, uint8_t *raw_data, uint16_t raw_data_len, uint8_t **data)
+{
+    uint16_t recv_data_len;
+    mtp_ret ret;
+
+    if (NULL == data) {
+        return MTP_INVALID_PARAM;
+    }
+
+    ret = trsmitr_recv_pkg_parse(frm_trsmitr, raw_data, raw_data_len, data, &recv_data_len);
+    if (MTP_OK != ret) {
+        if (MTP_TRSMITR_CONTINUE == ret) {
+            frm_trsmitr->subpkg_len = 0;    //repeated sub-package, nothing new
+        }
+        return ret;
+    }
+
+    frm_trsmitr->subpkg_len = recv_data_len;
+    frm_trsmitr->pkg_trsmitr_cnt += recv_data_len;
+
+    if (frm_trsmitr->pkg_trsmitr_cnt < frm_trsmitr->total) {
+        return MTP_TRSMITR_CONTINUE;
+    }
+    return MTP_OK;
+}
+
 /***********************************************************
 *  Function: free_klv_list
 *  description:
@@ -708,3 +775,78 @@ mtp_ret data_2_klvlist(uint8_t *data, uint32_t len, klv_node_s **list, uint8_t t
     return MTP_OK;
 }
 
+
+/***********************************************************
+*  Function: klv_data_next
+*  description: parse one klv record in place
+*  Input:   data len->klv data
+*           offset->record offset, moved to the next record on success
+*           type: 0- 1 byte length，1- 2 byte length
+*  Output:  klv->record, klv->data points into data
+*  Return:
+***********************************************************/
+mtp_ret klv_data_next(uint8_t *data, uint32_t len, uint32_t *offset, klv_view_s *klv, uint8_t type)
+{
+    uint32_t head_len = (1 == type) ? 4 : 3;
+    uint8_t *p;
+
+    if (NULL == data || NULL == offset || NULL == klv || *offset > len) {
+        return MTP_INVALID_PARAM;
+    }
+
+    // not full klv
+    if ((len - *offset) < head_len) {
+        return MTP_COM_ERROR;
+    }
+
+    p = &data[*offset];
+    klv->id = p[0];
+    klv->type = p[1];
+    if (1 == type) {
+        klv->len = (p[2] << 8) + p[3];
+    } else {
+        klv->len = p[2];
+    }
+
+    // is remain data len enougn?
+    if ((len - *offset - head_len) < klv->len) {
+        return MTP_COM_ERROR;
+    }
+
+    klv->data = p + head_len;
+    *offset += head_len + klv->len;
+    return MTP_OK;
+}
+
+/***********************************************************
+*  Function: klv_data_check
+*  description: validate dp data without building a klv list,
+*               same rules as data_2_klvlist
+*  Input:   type: 0- 1 byte length，1- 2 byte length
+*  Output:  dp_num->number of klv records, can be NULL
+*  Return:
+***********************************************************/
+mtp_ret klv_data_check(uint8_t *data, uint32_t len, uint8_t type, uint16_t *dp_num)
+{
+    klv_view_s klv;
+    uint32_t offset = 0;
+    uint16_t num = 0;
+    mtp_ret ret;
+
+    if (NULL == data) {
+        return MTP_INVALID_PARAM;
+    }
+
+    do {
+        ret = klv_data_next(data, len, &offset, &klv, type);
+        if (MTP_OK != ret) {
+            return ret;
+        }
+        num++;
+    } while (offset < len);
+
+    if (dp_num) {
+        *dp_num = num;
+    }
+    return MTP_OK;
+}
@@ -25,6 +25,7 @@
 #include "tuya_ble_utils.h"
 #include "tuya_ble_port.h"
 #include "tuya_ble_mem.h"
+#include "profile_crc.h"
 
 
 int32_t tuya_ble_count_bits(uint32_t data)
@@ -335,36 +336,15 @@ void tuya_ble_swap128(uint8_t dst[16], const uint8_t src[16])
 
 uint16_t tuya_ble_crc16_compute(uint8_t *p_data, uint16_t size, uint16_t *p_crc)
 {
-
-    uint16_t poly[2] = {0, 0xa001};            //0x8005 <==> 0xa001
-    uint16_t crc;
-    int i, j;
-    crc = (p_crc == NULL) ? 0xFFFF : *p_crc;
-
-    for (j = size; j > 0; j--) {
-        unsigned char ds = *p_data++;
-
-        for (i = 0; i < 8; i++) {
-            crc = (crc >> 1) ^ poly[(crc ^ ds) & 1];
-            ds = ds >> 1;
-        }
-    }
-
-    return crc;
+    uint16_t crc = (p_crc == NULL) ? PROFILE_CRC16_INIT : *p_crc;
+    return profile_crc16_update(crc, p_data, size);
 }
 
 
 uint32_t tuya_ble_crc32_compute(uint8_t const *p_data, uint32_t size, uint32_t const *p_crc)
 {
-    uint32_t crc;
-    crc = (p_crc == NULL) ? 0xFFFFFFFF : ~(*p_crc);
-    for (uint32_t i = 0; i < size; i++) {
-        crc = crc ^ p_data[i];
-        for (uint32_t j = 8; j > 0; j--) {
-            crc = (crc >> 1) ^ (0xEDB88320U & ((crc & 1) ? 0xFFFFFFFF : 0));
-        }
-    }
-    return ~crc;
+    uint32_t crc = (p_crc == NULL) ? PROFILE_CRC32_INIT : ~(*p_crc);
+    return profile_crc32_final(profile_crc32_update(crc, p_data, size));
 }
 
 
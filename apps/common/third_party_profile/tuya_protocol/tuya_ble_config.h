@@ -174,6 +174,14 @@
 #define  TUYA_BLE_USE_PLATFORM_MEMORY_HEAP   0
 #endif
 
+/*
+ * if 1 ,ble sdk private heap use TLSF allocator (O(1) good-fit, less fragmentation)
+ * instead of the first-fit free list. Only valid when TUYA_BLE_USE_PLATFORM_MEMORY_HEAP is 0.
+ */
+#ifndef  TUYA_BLE_HEAP_USE_TLSF
+#define  TUYA_BLE_HEAP_USE_TLSF   0
+#endif
+
 
 /*
  * if defined ,include UART module
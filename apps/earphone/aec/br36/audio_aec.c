@@ -19,6 +19,7 @@
 //#include "audio_aec_debug.c"
 #include "audio_config.h"
 #include "amplitude_statistic.h"
+#include "audio_mips_prof.h"
 #include "audio_gain_process.h"
 
 #if TCFG_AUDIO_CVP_SYNC
@@ -388,6 +389,7 @@ static int audio_aec_probe(short *mic0, short *mic1, short *mic2, short *ref, u1
         audio_eq_run(aec_hdl->dccs_eq, mic0, len);
     }
 #endif/*AEC_DCCS_EN*/
+    AUDIO_PROF_MARK(AUDIO_PROF_AEC);
     return 0;
 }
 
@@ -403,6 +405,7 @@ static int audio_aec_probe(short *mic0, short *mic1, short *mic2, short *ref, u1
 */
 static int audio_aec_post(s16 *data, u16 len)
 {
+    AUDIO_PROF_MARK_END(AUDIO_PROF_AEC);
 #if AEC_UL_EQ_EN
     if (aec_hdl->ul_eq) {
         audio_eq_run(aec_hdl->ul_eq, data, len);
@@ -928,14 +931,6 @@ void audio_aec_reboot(u8 reduce)
     }
 }
 
-#if TCFG_SIDETONE_ENABLE
-static s16 mic0_data[3][256];
-static int mic0_data_offset = 0;
-static int mic0_data_bulk = 0;
-static s16 mic1_data[3][256];
-static int mic1_data_offset = 0;
-static int mic1_data_bulk = 0;
-#endif/*TCFG_SIDETONE_ENABLE*/
 /*
 *********************************************************************
 *                  Audio AEC Close
@@ -991,13 +986,6 @@ void audio_aec_close(void)
 #endif/*AEC_USER_MALLOC_ENABLE*/
         aec_hdl = NULL;
         local_irq_enable();
-
-#if TCFG_SIDETONE_ENABLE
-        mic0_data_offset = 0;
-        mic0_data_bulk = 0;
-        mic1_data_offset = 0;
-        mic1_data_bulk = 0;
-#endif/*TCFG_SIDETONE_ENABLE*/
     }
 }
 
@@ -1030,43 +1018,24 @@ u8 audio_aec_status(void)
 */
 void audio_aec_inbuf(s16 *buf, u16 len)
 {
-    u16 data_len = len;
     if (aec_hdl && aec_hdl->start) {
         if (aec_hdl->input_clear) {
             memset(buf, 0, len);
         }
-#if TCFG_SIDETONE_ENABLE
-        if (mic0_data_bulk > 2) {
-            mic0_data_bulk = 0;
-        }
-        if (mic0_data_offset > (512 - len)) {
-            mic0_data_offset = 0;
-        }
-        memcpy((((u32)&mic0_data[mic0_data_bulk][0]) + mic0_data_offset), buf, len);
-        data_len = 512;
-        buf = (s16 *)(&mic0_data[mic0_data_bulk]);
-        mic0_data_offset += len;
-        if (mic0_data_offset <= (512 - len)) {
-            return;
-        }
-        mic0_data_bulk++;
-
-#endif/*TCFG_SIDETONE_ENABLE*/
-
 #if AEC_TOGGLE
         if (aec_hdl->inbuf_clear_cnt) {
             aec_hdl->inbuf_clear_cnt--;
-            memset(buf, 0, data_len);
+            memset(buf, 0, len);
         }
 
-        int ret = aec_in_data(buf, data_len);
+        int ret = aec_in_data(buf, len);
         if (ret == -1) {
         } else if (ret == -2) {
             log_error("aec inbuf full\n");
             printf("clk : %d\n", clk_get("sys"));
         }
 #else	/*不经算法，直通到输出*/
-        audio_aec_output(buf, data_len);
+        audio_aec_output(buf, len);
 #endif/*AEC_TOGGLE*/
     }
 }
@@ -1083,28 +1052,8 @@ void audio_aec_inbuf(s16 *buf, u16 len)
 */
 void audio_aec_inbuf_ref(s16 *buf, u16 len)
 {
-    u16 data_len = len;
-
-#if TCFG_SIDETONE_ENABLE
-    if (mic1_data_bulk > 2) {
-        mic1_data_bulk = 0;
-    }
-    if (mic1_data_offset > (512 - len)) {
-        mic1_data_offset = 0;
-    }
-    memcpy((((u32)&mic1_data[mic1_data_bulk][0]) + mic1_data_offset), buf, len);
-    data_len = 512;
-    buf = (s16 *)(&mic1_data[mic1_data_bulk]);
-    mic1_data_offset += len;
-    if (mic1_data_offset <= (512 - len)) {
-        return;
-    }
-    mic1_data_bulk++;
-
-#endif/*TCFG_SIDETONE_ENABLE*/
-
     if (aec_hdl && aec_hdl->start) {
-        aec_in_data_ref(buf, data_len);
+        aec_in_data_ref(buf, len);
     }
 }
 
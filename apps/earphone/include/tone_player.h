@@ -81,6 +81,15 @@
 #define TONE_LOW_LATENCY_IN     DEFAULT_SINE_TONE(SINE_WTONE_LOW_LATENRY_IN)
 #define TONE_LOW_LATENCY_OUT    DEFAULT_SINE_TONE(SINE_WTONE_LOW_LATENRY_OUT)
 
+/*多声部合成提示音*/
+#define SYNTH_WTONE_KEY             0
+#define SYNTH_WTONE_CHORD_UP        1
+#define SYNTH_WTONE_CHORD_DOWN      2
+
+#define TONE_SYNTH_KEY          DEFAULT_SYNTH_TONE(SYNTH_WTONE_KEY)
+#define TONE_SYNTH_CHORD_UP     DEFAULT_SYNTH_TONE(SYNTH_WTONE_CHORD_UP)
+#define TONE_SYNTH_CHORD_DOWN   DEFAULT_SYNTH_TONE(SYNTH_WTONE_CHORD_DOWN)
+
 
 enum {
     IDEX_TONE_NUM_0,
@@ -13,6 +13,7 @@
 #include "tone_player.h"
 #include "app_task.h"
 #include "earphone.h"
+#include "adv_music_info_setting.h"
 
 #define LOG_TAG_CONST       MUSIC
 #define LOG_TAG             "[MUSIC]"
@@ -107,6 +108,53 @@ static void music_powerdown_exit_check(void)
     /* log_info(">>>>>>>>>>>>>>>exit music_play_status = %d\n", music_play_status); */
 }
 
+#if ((TCFG_DEC_ID3_V1_ENABLE) || (TCFG_DEC_ID3_V2_ENABLE))
+static u8 music_id3_text_is_ascii(const char *text)
+{
+    while (*text) {
+        if ((u8)(*text++) >= 0x80) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//*----------------------------------------------------------------------------*/
+/**@brief    当前文件id3标签推送到rcsp音乐信息
+   @param    无
+   @return   无
+   @note	 标签按设备+簇号缓存，切回播放过的文件不再读文件；
+   			 ISO-8859-1/id3v1字段可能是本地编码，非ascii时不推送
+*/
+/*----------------------------------------------------------------------------*/
+static void music_id3_info_update(void)
+{
+    ID3_TAG_INFO *info = zalloc(sizeof(ID3_TAG_INFO));
+
+    if (!info) {
+        return;
+    }
+    if (music_player_get_id3_info(info) == 0) {
+        log_info("id3 ver:%d title:%s artist:%s album:%s\n", info->ver,
+                 info->text[ID3_TAG_TITLE], info->text[ID3_TAG_ARTIST], info->text[ID3_TAG_ALBUM]);
+#if (RCSP_ADV_EN && RCSP_ADV_MUSIC_INFO_ENABLE)
+        //rcsp音乐信息类型:1:标题, 2:作者, 3:专辑, 6:类型, 年代没有对应类型
+        static const u8 rcsp_type[ID3_TAG_FIELD_NUM] = {1, 2, 3, 0, 6};
+        for (int i = 0; i < ID3_TAG_FIELD_NUM; i++) {
+            if (!rcsp_type[i] || !info->text[i][0]) {
+                continue;
+            }
+            if ((info->local_mask & BIT(i)) && !music_id3_text_is_ascii(info->text[i])) {
+                continue;
+            }
+            rcsp_adv_music_info_deal(rcsp_type[i], 0, (u8 *)info->text[i], strlen(info->text[i]));
+        }
+#endif
+    }
+    free(info);
+}
+#endif
+
 //*----------------------------------------------------------------------------*/
 /**@brief    music 解码成功回调
    @param    priv:私有参数， parm:暂时未用
@@ -132,6 +180,9 @@ static void music_player_play_success(void *priv, int parm)
     if (music_player_get_playing_breakpoint(breakpoint, 0) == true) {
         breakpoint_vm_write(breakpoint, logo);
     }
+#if ((TCFG_DEC_ID3_V1_ENABLE) || (TCFG_DEC_ID3_V2_ENABLE))
+    music_id3_info_update();
+#endif
 }
 
 //*----------------------------------------------------------------------------*/
@@ -641,6 +692,9 @@ static int event_handler(struct application *app, struct sys_event *event)
             if (event->u.dev.event == DEVICE_EVENT_OUT) {
                 update_clear_result();
                 music_save_breakpoint(1);
+#if ((TCFG_DEC_ID3_V1_ENABLE) || (TCFG_DEC_ID3_V2_ENABLE))
+                id3_tag_cache_clear((char *)event->u.dev.value);
+#endif
                 dev_manager_del((char *)event->u.dev.value);
                 app_task_switch_next();
                 return true;
@@ -127,6 +127,52 @@ static const struct sin_param sine_tws_max_volume[] __BANK_TONE = {
     {400 << 9, 2539, 0, 100},
 };
 
+/*
+ * 多声部合成参数配置:
+ * freq : 各声部频率(Hz)，0为不发声
+ * ms : 时长
+ */
+static const struct sine_synth_note synth_key[] __BANK_TONE = {
+    {{941, 1336}, 80},		//DTMF "0"
+};
+
+static const struct sine_synth_note synth_chord_up[] __BANK_TONE = {
+    {{523}, 90},
+    {{523, 659}, 90},
+    {{523, 659, 784}, 240},
+};
+
+static const struct sine_synth_note synth_chord_down[] __BANK_TONE = {
+    {{523, 659, 784}, 90},
+    {{523, 659}, 90},
+    {{523}, 240},
+};
+
+__BANK_TONE_ENTRY
+static const struct sine_synth_note *get_synth_note_by_index(u8 index, u8 *num)
+{
+    const struct sine_synth_note *note;
+
+    switch (index) {
+    case SYNTH_WTONE_KEY:
+        note = synth_key;
+        *num = ARRAY_SIZE(synth_key);
+        break;
+    case SYNTH_WTONE_CHORD_UP:
+        note = synth_chord_up;
+        *num = ARRAY_SIZE(synth_chord_up);
+        break;
+    case SYNTH_WTONE_CHORD_DOWN:
+        note = synth_chord_down;
+        *num = ARRAY_SIZE(synth_chord_down);
+        break;
+    default:
+        return NULL;
+    }
+
+    return note;
+}
+
 __BANK_TONE_ENTRY
 static const struct sin_param *get_sine_param_by_index(u8 index, u8 *num)
 {
@@ -231,6 +277,7 @@ __BANK_INIT_ENTRY
 int tone_table_init()
 {
     tone_play_set_sine_param_handler(get_sine_param_by_index);
+    tone_play_set_synth_note_handler(get_synth_note_by_index);
     return 0;
 }
 __initcall(tone_table_init);
@@ -0,0 +1,275 @@
+/*
+ ****************************************************************
+ *							A2DP Stream Repair
+ *						A2DP数据流异常修复状态机
+ * File  : a2dp_stream_repair.c
+ * By    :
+ * Notes : 处理播空(underrun)、丢包(missed)、补帧过多(overrun)
+ *		   三种情况下的补帧、丢包与重新同步，数据包通过
+ *		   struct a2dp_packet_source获取，本文件不访问硬件
+ ****************************************************************
+ */
+
+#include "a2dp_stream_repair.h"
+
+#ifdef SUPPORT_MS_EXTENSIONS
+#pragma bss_seg(	".bt_decode.data.bss")
+#pragma data_seg(	".bt_decode.data")
+#pragma const_seg(	".bt_decode.text.const")
+#pragma code_seg(	".bt_decode.text")
+#endif
+
+#define RB16(b)    (u16)(((u8 *)b)[0] << 8 | (((u8 *)b))[1])
+
+#define a2dp_seqn_before(a, b)  ((a < b && (u16)(b - a) < 1000) || (a > b && (u16)(a - b) > 1000))
+
+/*
+*********************************************************************
+*                  A2DP Stream Repair Init
+* Description: 初始化修复状态机
+* Arguments  : s			状态机
+*			   src			数据包来源接口
+*			   priv			数据包来源私有参数
+*			   sample_rate	码流采样率
+*			   aac			是否AAC码流(AAC的RTP头不带payload header)
+* Return	 : None.
+* Note(s)    : target_delay/low_latency默认为空，使用前由调用者指向
+*			   实际的延时配置，便于运行中自适应调整或离线扫描参数
+*********************************************************************
+*/
+void a2dp_stream_repair_init(struct a2dp_stream_repair *s, const struct a2dp_packet_source *src, void *priv,
+                             u16 sample_rate, u8 aac)
+{
+    memset(s, 0x0, sizeof(*s));
+    s->src = src;
+    s->priv = priv;
+    s->sample_rate = sample_rate;
+    s->aac = aac;
+}
+
+AT(.bt_decode.text.cache.L2.a2dp)
+void a2dp_stream_repair_free(struct a2dp_stream_repair *s, void *packet)
+{
+    if (packet) {
+        s->src->free_packet(s->priv, packet);
+    }
+
+    if ((void *)packet == (void *)s->repair_pkt) {
+        s->repair_pkt = NULL;
+    }
+
+    if (s->repair_pkt) {
+        s->src->free_packet(s->priv, s->repair_pkt);
+        s->repair_pkt = NULL;
+    }
+    s->repair_pkt_len = 0;
+}
+
+static int a2dp_stream_overrun_handler(struct a2dp_stream_repair *s, u8 **frame, int *len)
+{
+    u8 *packet = NULL;
+    int rlen = 0;
+    int sample_rate = 0;
+    u16 seqn;
+    u16 end_seqn = 0;
+
+    while (1) {
+        if (s->src->delay_time(s->priv) < *s->target_delay) {
+            break;
+        }
+        rlen = s->src->try_get_packet(s->priv, &packet);
+        if (rlen <= 0) {
+            break;
+        }
+
+        if (s->src->sample_rate_detect) {
+            sample_rate = s->src->sample_rate_detect(s->priv, s->repair_pkt, &end_seqn);
+        } else {
+            sample_rate = s->sample_rate;
+        }
+        a2dp_stream_repair_free(s, NULL);
+        s->repair_pkt = packet;
+        s->repair_pkt_len = rlen;
+        seqn = RB16(packet + 2);
+        if (!a2dp_seqn_before(seqn, s->overrun_seqn)) {
+            *frame = packet;
+            *len = rlen;
+            /*printf("------> end frame : %d\n", s->overrun_seqn);*/
+            return 1;
+        }
+        s->stat.drop_packets++;
+
+        if (/*sample_rate < (s->sample_rate * 4 / 5) || */sample_rate > (s->sample_rate * 4 / 3)) {
+            if (a2dp_seqn_before(s->overrun_seqn, end_seqn)) {
+                s->overrun_seqn = end_seqn;
+            }
+        }
+    }
+
+    *frame = s->repair_pkt;
+    *len = s->repair_pkt_len;
+    return 0;
+}
+
+static int a2dp_stream_missed_handler(struct a2dp_stream_repair *s, u8 **frame, int *len)
+{
+    int msecs = s->src->delay_time(s->priv);
+    *frame = s->repair_pkt;
+    *len = s->repair_pkt_len;
+    if ((msecs >= (s->delay_time + 50) || s->src->rx_overrun(s->priv)) || --s->missed_num == 0) {
+        /*putchar('M');*/
+        return 1;
+    }
+    /*putchar('m');*/
+    s->stat.repair_frames++;
+    return 0;
+}
+
+static int a2dp_stream_underrun_handler(struct a2dp_stream_repair *s, u8 **packet)
+{
+    if (!s->src->is_underrun(s->priv)) {
+        putchar('x');
+        return 0;
+    }
+    putchar('X');
+    if (s->stream_error != A2DP_STREAM_UNDERRUN) {
+        if (!s->stream_error) {
+            if (s->src->underrun_feedback) {
+                s->src->underrun_feedback(s->priv);
+            }
+            s->stat.underrun_cnt++;
+        }
+        s->stream_error = *s->low_latency ? A2DP_STREAM_LOW_UNDERRUN : A2DP_STREAM_UNDERRUN;
+        s->repair = *s->low_latency ? 0 : 1;
+    }
+    *packet = s->repair_pkt;
+    s->repair_frames++;
+    if (s->repair_pkt_len > 0) {
+        s->stat.repair_frames++;
+    }
+    return s->repair_pkt_len;
+}
+
+static int a2dp_stream_error_filter(struct a2dp_stream_repair *s, u8 new_packet, u8 *packet, int len)
+{
+    int err = 0;
+
+    if (s->aac) {
+        s->header_len = s->src->rtp_header_len(s->priv, s->new_frame, packet, len);
+        s->new_frame = 0;
+    } else {
+        s->header_len = s->src->rtp_header_len(s->priv, 1, packet, len);
+    }
+
+    if (s->header_len >= len) {
+        printf("##A2DP header error : %d\n", s->header_len);
+        s->stat.header_err++;
+        a2dp_stream_repair_free(s, packet);
+        return -EFAULT;
+    }
+
+    u16 seqn = RB16(packet + 2);
+    if (new_packet) {
+        if (s->stream_error == A2DP_STREAM_UNDERRUN) {
+            int missed_frames = (u16)(seqn - s->seqn) - 1;
+            if (missed_frames > s->repair_frames) {
+                s->stream_error = A2DP_STREAM_MISSED;
+                s->missed_num = missed_frames - s->repair_frames + 1;
+                s->stat.missed_cnt++;
+                /*printf("case 0 : %d, %d\n", missed_frames, s->repair_frames);*/
+                err = -EAGAIN;
+            } else if (missed_frames < s->repair_frames) {
+                s->stream_error = A2DP_STREAM_OVERRUN;
+                s->overrun_seqn = seqn + s->repair_frames - missed_frames;
+                s->stat.overrun_cnt++;
+                /*printf("case 1 : %d, %d, seqn : %d, %d\n", missed_frames, s->repair_frames, seqn, s->overrun_seqn);*/
+                err = -EAGAIN;
+            }
+        } else if (!s->stream_error && (u16)(seqn - s->seqn) > 1) {
+            s->stream_error = A2DP_STREAM_MISSED;
+            s->stat.missed_cnt++;
+            if (s->src->delay_time(s->priv) < s->delay_time) {
+                s->missed_num = (u16)(seqn - s->seqn);
+                err = -EAGAIN;
+            }
+            /*printf("case 2 : %d, %d\n", seqn, s->seqn);*/
+            if (s->missed_num > 30) {
+                printf("##A serious mistake : A2DP stream missed too much, %d\n", s->missed_num);
+                s->missed_num = 30;
+            }
+        }
+        s->repair_frames = 0;
+    }
+    if (!err && new_packet) {
+        s->seqn = seqn;
+    }
+    s->repair_pkt = packet;
+    s->repair_pkt_len = len;
+    return err;
+}
+
+/*
+*********************************************************************
+*                  A2DP Stream Repair Get Frame
+* Description: 取一帧待解码数据
+* Arguments  : s		状态机
+*			   frame	返回去掉RTP头之后的数据地址
+* Return	 : 数据长度，0表示当前没有数据可解
+* Note(s)    : 数据流异常时返回的可能是上一包的重复数据，
+*			   该包由状态机持有，下次取数或a2dp_stream_repair_free时释放
+*********************************************************************
+*/
+AT(.bt_decode.text.cache.L2.a2dp)
+int a2dp_stream_repair_get_frame(struct a2dp_stream_repair *s, u8 **frame)
+{
+    u8 *packet = NULL;
+    int len = 0;
+    u8 new_packet = 0;
+
+try_again:
+    switch (s->stream_error) {
+    case A2DP_STREAM_OVERRUN:
+        new_packet = a2dp_stream_overrun_handler(s, &packet, &len);
+        break;
+    case A2DP_STREAM_MISSED:
+        new_packet = a2dp_stream_missed_handler(s, &packet, &len);
+        break;
+    default:
+        len = s->src->try_get_packet(s->priv, &packet);
+        if (len <= 0) {
+            len = a2dp_stream_underrun_handler(s, &packet);
+        } else {
+            a2dp_stream_repair_free(s, NULL);
+            new_packet = 1;
+            s->stat.packets++;
+            if (s->src->packet_arrived) {
+                s->src->packet_arrived(s->priv);
+            }
+        }
+        break;
+    }
+
+    if (len <= 0) {
+        return 0;
+    }
+
+    int err = a2dp_stream_error_filter(s, new_packet, packet, len);
+    if (err) {
+        if (-err == EAGAIN) {
+            s->new_frame = 1;
+            goto try_again;
+        }
+        return 0;
+    }
+
+    *frame = packet + s->header_len;
+    len -= s->header_len;
+    if (s->stream_error && new_packet) {
+        if (s->src->error_recovered) {
+            s->src->error_recovered(s->priv);
+        }
+        s->stream_error = 0;
+    }
+
+    return len;
+}
@@ -0,0 +1,70 @@
+#ifndef _A2DP_STREAM_REPAIR_H_
+#define _A2DP_STREAM_REPAIR_H_
+
+#include "generic/typedef.h"
+
+#define A2DP_STREAM_NO_ERR                  0
+#define A2DP_STREAM_UNDERRUN                1
+#define A2DP_STREAM_OVERRUN                 2
+#define A2DP_STREAM_MISSED                  3
+#define A2DP_STREAM_DECODE_ERR              4
+#define A2DP_STREAM_LOW_UNDERRUN            5
+
+/*
+ *A2DP数据包来源接口
+ *修复状态机只通过这组接口访问蓝牙缓存和输出缓冲，
+ *不依赖硬件，可以用抓包记录或构造的RTP包序列在PC上驱动
+ */
+struct a2dp_packet_source {
+    int (*try_get_packet)(void *priv, u8 **packet);          /*取下一个包，返回包长，<=0无数据*/
+    void (*free_packet)(void *priv, void *packet);
+    int (*delay_time)(void *priv);                            /*当前已缓存的总播放时长(ms)*/
+    int (*rx_overrun)(void *priv);                            /*接收缓存即将溢出*/
+    int (*is_underrun)(void *priv);                           /*输出缓冲即将播空*/
+    int (*rtp_header_len)(void *priv, u8 new_frame, u8 *packet, int len);
+    int (*sample_rate_detect)(void *priv, u8 *from_packet, u16 *end_seqn);  /*可选，检测缓存数据的实际采样率*/
+    void (*underrun_feedback)(void *priv);                    /*可选，首次播空时调整延时*/
+    void (*packet_arrived)(void *priv);                       /*可选，取到新包*/
+    void (*error_recovered)(void *priv);                      /*可选，异常恢复*/
+};
+
+/*修复统计，调参用*/
+struct a2dp_stream_stat {
+    u32 packets;            /*正常取到的包数*/
+    u32 repair_frames;      /*重复上一包补出的帧数*/
+    u32 drop_packets;       /*追赶延时丢弃的包数*/
+    u16 underrun_cnt;       /*进入播空修复的次数*/
+    u16 missed_cnt;         /*检测到丢包的次数*/
+    u16 overrun_cnt;        /*补帧过多需要追赶的次数*/
+    u16 header_err;         /*RTP头异常的包数*/
+};
+
+struct a2dp_stream_repair {
+    const struct a2dp_packet_source *src;
+    void *priv;
+    const s16 *target_delay;    /*当前目标延时(ms)，运行中可被自适应调整*/
+    const u8 *low_latency;      /*低延时模式*/
+    u16 delay_time;             /*基础延时(ms)*/
+    u16 sample_rate;
+    u8 aac;
+    u8 stream_error;
+    u8 new_frame;
+    u8 repair;
+    s16 header_len;
+    s16 repair_pkt_len;
+    void *repair_pkt;
+    u16 seqn;
+    u16 missed_num;
+    u16 repair_frames;
+    u16 overrun_seqn;
+    struct a2dp_stream_stat stat;
+};
+
+void a2dp_stream_repair_init(struct a2dp_stream_repair *s, const struct a2dp_packet_source *src, void *priv,
+                             u16 sample_rate, u8 aac);
+
+void a2dp_stream_repair_free(struct a2dp_stream_repair *s, void *packet);
+
+int a2dp_stream_repair_get_frame(struct a2dp_stream_repair *s, u8 **frame);
+
+#endif /*_A2DP_STREAM_REPAIR_H_*/
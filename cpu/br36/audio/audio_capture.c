@@ -103,6 +103,28 @@ extern struct audio_adc_hdl adc_hdl;
 /*数据导出添加数据头*/
 #define DE_PACKET_HEADER_EN	0	//DE:DataExport
 
+/*
+ *mic数据缓存：mic中断写、任务/定时器读，是单生产者单消费者的通路，
+ *可选用无锁的spsc_ring代替cbuffer_t(缓存大小需为2的幂)
+ *每个缓存只能有一个写者：ANS(NS_DEMO_EN)的原始输入由任务写入单独的ns_in_cb，
+ *不能写mic0_cb(数字mic时mic0_cb由中断写)
+ */
+#define AC_MIC_SPSC_RING_EN	0
+#if AC_MIC_SPSC_RING_EN
+#include "generic/spsc_ring.h"
+typedef spsc_ring_t ac_mic_buf_t;
+#define ac_mic_buf_init(b, buf, size)	spsc_ring_init(b, buf, size)
+#define ac_mic_buf_write(b, dat, len)	spsc_ring_write(b, dat, len)
+#define ac_mic_buf_read(b, dat, len)	spsc_ring_read(b, dat, len)
+#define ac_mic_buf_len(b)				spsc_ring_data_len(b)
+#else
+typedef cbuffer_t ac_mic_buf_t;
+#define ac_mic_buf_init(b, buf, size)	cbuf_init(b, buf, size)
+#define ac_mic_buf_write(b, dat, len)	cbuf_write(b, dat, len)
+#define ac_mic_buf_read(b, dat, len)	cbuf_read(b, dat, len)
+#define ac_mic_buf_len(b)				((b)->data_len)
+#endif/*AC_MIC_SPSC_RING_EN*/
+
 extern struct device *force_open_sd(char *sdx);
 extern void force_write_sd(u8 *buf, u32 sector, u32 sector_num);
 
@@ -135,8 +157,12 @@ typedef struct {
     s16 mic0_buf[ADC_DM_IRQ_POINTS * 4];	// mic0的原始数据buf
     s16 mic1_buf[ADC_DM_IRQ_POINTS * 4];	// mic1的原始数据buf
     //s16 out_buf[ADC_DM_IRQ_POINTS * 4];		// dm noise reduce output
-    cbuffer_t mic0_cb;
-    cbuffer_t mic1_cb;
+    ac_mic_buf_t mic0_cb;
+    ac_mic_buf_t mic1_cb;
+#if NS_DEMO_EN
+    s16 ns_in_buf[ADC_DM_IRQ_POINTS * 4];	// ANS输入的原始数据，任务写、导出读
+    ac_mic_buf_t ns_in_cb;
+#endif/*NS_DEMO_EN*/
     //cbuffer_t out_cb;
     s16 mic0[DM_RUN_POINT];
     s16 mic1[DM_RUN_POINT];
@@ -422,20 +448,20 @@ static void adc_dual_mic_output(void *priv, s16 *data, int len)
         mic1_data[i] = data[i * 2 + 1];
     }
 
-    wlen = cbuf_write(&dm.mic0_cb, mic0_data, len);
+    wlen = ac_mic_buf_write(&dm.mic0_cb, mic0_data, len);
     if (wlen != len) {
         AC_ERR_LOG("mic0_cbuf full:%d,%d\n", wlen, len);
     }
 
 #if (TCFG_AUDIO_TCFG_AUDIO_DATA_EXPORT_ENABLE == AUDIO_DATA_EXPORT_USE_SPP)
 #if (SPP_EXPORT_CH > 1)
-    wlen = cbuf_write(&dm.mic1_cb, mic1_data, len);
+    wlen = ac_mic_buf_write(&dm.mic1_cb, mic1_data, len);
     if (wlen != len) {
         AC_ERR_LOG("mic1_cbuf full\n");
     }
 #endif/*SPP_EXPORT_CH == 2*/
 #else
-    wlen = cbuf_write(&dm.mic1_cb, mic1_data, len);
+    wlen = ac_mic_buf_write(&dm.mic1_cb, mic1_data, len);
     if (wlen != len) {
         AC_ERR_LOG("mic1_cbuf full\n");
     }
@@ -460,7 +486,7 @@ static void adc_dual_mic_output(void *priv, s16 *data, int len)
 #endif/*DM_2_DAC_EN*/
 #else /*单模拟MIC*/
     //putchar('m');
-    wlen = cbuf_write(&dm.mic1_cb, data, len);
+    wlen = ac_mic_buf_write(&dm.mic1_cb, data, len);
     if (wlen != len) {
         AC_ERR_LOG("mic1_cbuf full\n");
     }
@@ -570,12 +596,12 @@ static void plnk_mic_output(void *buf, u16 len)
     putchar('o');
     //printf("olen:%d,%d",len,olen);
 
-    wlen = cbuf_write(&dm.mic0_cb, mic0, olen);
+    wlen = ac_mic_buf_write(&dm.mic0_cb, mic0, olen);
     if (wlen != olen) {
         AC_ERR_LOG("mic0_cbuf full:%d,%d\n", wlen, olen);
     }
 #if ((AC_MIC_TYPE == AC_D_MIC) && (PLNK_MIC_CH == 2))
-    wlen = cbuf_write(&dm.mic1_cb, mic1, olen);
+    wlen = ac_mic_buf_write(&dm.mic1_cb, mic1, olen);
     if (wlen != olen) {
         AC_ERR_LOG("mic1_cbuf full:%d,%d\n", wlen, olen);
     }
@@ -683,7 +709,11 @@ static void spp_data_export_run()
     case 0:
         //putchar('0');
         if (de.retry == 0) {
-            ret = cbuf_read(&dm.mic0_cb, &dm.export_buf[4], SPP_EXPORT_DATA_LEN);
+#if NS_DEMO_EN
+            ret = ac_mic_buf_read(&dm.ns_in_cb, &dm.export_buf[4], SPP_EXPORT_DATA_LEN);
+#else
+            ret = ac_mic_buf_read(&dm.mic0_cb, &dm.export_buf[4], SPP_EXPORT_DATA_LEN);
+#endif/*NS_DEMO_EN*/
             memcpy(dm.export_buf, &de.seqn0, SPP_EXPORT_HEAD);
         } else {
             ret = SPP_EXPORT_DATA_LEN;
@@ -708,7 +738,7 @@ static void spp_data_export_run()
 #if NS_DEMO_EN
         ret = cbuf_read(&dm.out_cbuf, &dm.export_buf[4], SPP_EXPORT_DATA_LEN);
 #else
-        ret = cbuf_read(&dm.mic1_cb, &dm.export_buf[4], SPP_EXPORT_DATA_LEN);
+        ret = ac_mic_buf_read(&dm.mic1_cb, &dm.export_buf[4], SPP_EXPORT_DATA_LEN);
 #endif/*NS_DEMO_EN*/
         memcpy(dm.export_buf, &de.seqn1, SPP_EXPORT_HEAD);
         if (ret == SPP_EXPORT_DATA_LEN) {
@@ -787,8 +817,11 @@ static void audio_capture_board_init()
 int audio_capture_start(void)
 {
     dm.sr = AC_SAMPLE_RATE;
-    cbuf_init(&dm.mic0_cb, dm.mic0_buf, sizeof(dm.mic0_buf));
-    cbuf_init(&dm.mic1_cb, dm.mic1_buf, sizeof(dm.mic1_buf));
+    ac_mic_buf_init(&dm.mic0_cb, dm.mic0_buf, sizeof(dm.mic0_buf));
+    ac_mic_buf_init(&dm.mic1_cb, dm.mic1_buf, sizeof(dm.mic1_buf));
+#if NS_DEMO_EN
+    ac_mic_buf_init(&dm.ns_in_cb, dm.ns_in_buf, sizeof(dm.ns_in_buf));
+#endif/*NS_DEMO_EN*/
     //cbuf_init(&dm.out_cb, dm.out_buf, sizeof(dm.out_buf));
     audio_mic_pwr_ctl(MIC_PWR_ON);
 #if (AC_MIC_TYPE & AC_A_MIC)
@@ -884,10 +917,10 @@ static void AudioCapture_Task(void *p)
     audio_capture_board_init();
 #if (TCFG_AUDIO_DATA_EXPORT_ENABLE == AUDIO_DATA_EXPORT_USE_SD)
     while (1) {
-        if ((dm.mic0_cb.data_len >= DM_RUN_SIZE) && (dm.mic1_cb.data_len >= DM_RUN_SIZE)) {
-            cbuf_read(&dm.mic0_cb, dm.mic0, DM_RUN_SIZE);
+        if ((ac_mic_buf_len(&dm.mic0_cb) >= DM_RUN_SIZE) && (ac_mic_buf_len(&dm.mic1_cb) >= DM_RUN_SIZE)) {
+            ac_mic_buf_read(&dm.mic0_cb, dm.mic0, DM_RUN_SIZE);
             data_export_run(dm.mic0, DM_RUN_SIZE, 0);
-            cbuf_read(&dm.mic1_cb, dm.mic1, DM_RUN_SIZE);
+            ac_mic_buf_read(&dm.mic1_cb, dm.mic1, DM_RUN_SIZE);
             data_export_run(dm.mic1, DM_RUN_SIZE, 1);
             int out_points = DualMic_NoiseReduce_run(dm.mic0, dm.mic1, dm.output, DM_RUN_POINT);
             data_export_run(dm.output, (out_points << 1), 2);
@@ -902,8 +935,10 @@ static void AudioCapture_Task(void *p)
 
         //do ans here:
         if (audio_ns) {
-            if (cbuf_read(&dm.mic1_cb, audio_ns->inbuf, DM_RUN_SIZE) == DM_RUN_SIZE) {
-                cbuf_write(&dm.mic0_cb, audio_ns->inbuf, DM_RUN_SIZE);
+            if (ac_mic_buf_read(&dm.mic1_cb, audio_ns->inbuf, DM_RUN_SIZE) == DM_RUN_SIZE) {
+#if NS_DEMO_EN
+                ac_mic_buf_write(&dm.ns_in_cb, audio_ns->inbuf, DM_RUN_SIZE);
+#endif/*NS_DEMO_EN*/
                 int out_size = audio_ns_run(audio_ns->inbuf, audio_ns->outbuf, DM_RUN_POINT);
 #if DM_2_DAC_EN
                 ret = audio_dac_write(&dac_hdl, audio_ns->outbuf, out_size);
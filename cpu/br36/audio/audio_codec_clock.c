@@ -17,6 +17,7 @@
 #include "audio_codec_clock.h"
 #include "audio_dec_eff.h"
 #include "asm/dac.h"
+#include "clock_governor.h"
 
 #define AUDIO_CODING_ALL        (0xffffffff)
 #define MAX_CODING_TYPE_NUM     4 //可根据模式的解码格式需求扩展
@@ -278,7 +279,7 @@ match_clock:
     }
 
     background_clk = audio_codec_background_clock();
-    new_clk = (params[i].clk ? params[i].clk : clk_get("sys")) + background_clk;
+    new_clk = (params[i].clk ? params[i].clk : clock_sys_budget()) + background_clk;
     if (!preemption) {
         struct audio_codec_clk_context *ctx1;
         if (!list_empty(&codec_clock_head)) {
@@ -316,7 +317,7 @@ clock_set:
     ctx->params.coding_type = coding_type;
     ctx->params.background = params[i].background;
     ctx->params.clk = ctx->params.background ? params[i].clk : new_clk;
-    clk_set("sys", new_clk);
+    clock_sys_request(new_clk);
     if (ctx->params.background) {
         list_add_tail(&ctx->entry, &codec_clock_head);
     } else {
@@ -353,14 +354,14 @@ clock_del:
             next_clk = ctx->params.clk;
         }
     } else {
-        u32 current_clk = clk_get("sys");
+        u32 current_clk = clock_sys_budget();
         next_clk = current_clk - remove_clk;
     }
 
     if (!next_clk || next_clk < AUDIO_CODEC_BASE_CLK) {
-        next_clk = list_empty(&codec_clock_head) ? clk_get("sys") : AUDIO_CODEC_BASE_CLK;
+        next_clk = list_empty(&codec_clock_head) ? clock_sys_budget() : AUDIO_CODEC_BASE_CLK;
     }
-    clk_set("sys", next_clk);
+    clock_sys_request(next_clk);
 }
 
 void audio_codec_clock_check(void)
@@ -373,12 +374,12 @@ void audio_codec_clock_check(void)
             return;
         }
 
-        u32 current_clk = clk_get("sys");
+        u32 current_clk = clock_sys_budget();
         u32 expect_clk = ctx->params.background ? (ctx->params.clk + 12 * 1000000L) : ctx->params.clk;
         if ((current_clk < 128 * 1000000L) && current_clk < expect_clk) {
             /*log_error("Audio codec clock error : %dM, %dM.", current_clk / 1000000, expect_clk / 1000000);*/
             putchar('K');
-            clk_set("sys", expect_clk);
+            clock_sys_request(expect_clk);
         }
     }
 }
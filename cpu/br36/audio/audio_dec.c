@@ -19,6 +19,9 @@
 #include "audio_demo/audio_demo.h"
 #include "application/audio_vbass.h"
 #include "audio_plc.h"
+#include "pcm_convert.h"
+#include "audio_mips_prof.h"
+#include "a2dp_stream_repair.h"
 #include "audio_dec_eff.h"
 #include "audio_codec_clock.h"
 #include "media/bt_audio_timestamp.h"
@@ -67,6 +70,9 @@
 #define AUDIO_CODEC_SUPPORT_SYNC	1
 
 #define A2DP_AUDIO_PLC_ENABLE       1
+/*a2dp使用audio_plc分级修复实例(需要TCFG_ESCO_PLC)，创建失败时仍使用LFaudio PLC
+ *默认关闭：还没有a2dp丢包下与LFaudio PLC的对比测量*/
+#define A2DP_AUDIO_PLC_TIERED       0
 
 #if A2DP_AUDIO_PLC_ENABLE
 #include "media/tech_lib/LFaudio_plc_api.h"
@@ -130,22 +136,14 @@ struct a2dp_dec_hdl {
     enum audio_channel channel;
     u8 start;
     u8 ch;
-    s16 header_len;
     u8 remain;
     u8 eq_remain;
     u8 fetch_lock;
     u8 preempt;
-    u8 stream_error;
-    u8 new_frame;
-    u8 repair;
     u8 dut_enable;
     void *sample_detect;
     void *syncts;
-    void *repair_pkt;
-    s16 repair_pkt_len;
-    u16 missed_num;
-    u16 repair_frames;
-    u16 overrun_seqn;
+    struct a2dp_stream_repair stream;
     u16 slience_frames;
 #if AUDIO_CODEC_SUPPORT_SYNC
     u8 ts_start;
@@ -157,15 +155,14 @@ struct a2dp_dec_hdl {
 #if A2DP_AUDIO_PLC_ENABLE
     LFaudio_PLC_API *plc_ops;
     void *plc_mem;
+    void *plc;
 #endif /*A2DP_AUDIO_PLC_ENABLE*/
     u32 mix_ch_event_params[3];
 
     u32 pending_time;
-    u16 seqn;
     u16 sample_rate;
     int timer;
     u32 coding_type;
-    u16 delay_time;
     u16 detect_timer;
     u8  underrun_feedback;
     /*
@@ -291,13 +288,6 @@ s16 mix_buff[MIX_POINTS_NUM];
 #define A2DP_MAX_PENDING_TIME               40
 #endif
 
-#define A2DP_STREAM_NO_ERR                  0
-#define A2DP_STREAM_UNDERRUN                1
-#define A2DP_STREAM_OVERRUN                 2
-#define A2DP_STREAM_MISSED                  3
-#define A2DP_STREAM_DECODE_ERR              4
-#define A2DP_STREAM_LOW_UNDERRUN            5
-
 #ifdef TCFG_AUDIO_MUSIC_SAMPLE_RATE
 #define A2DP_SOUND_SAMPLE_RATE      TCFG_AUDIO_MUSIC_SAMPLE_RATE
 #else
@@ -617,6 +607,7 @@ static void mixer_event_handler(struct audio_mixer *mixer, int event)
 
 static int mix_probe_handler(struct audio_mixer *mixer)
 {
+    AUDIO_PROF_MARK(AUDIO_PROF_MIXER);
     return 0;
 }
 
@@ -625,6 +616,7 @@ static int mix_output_handler(struct audio_mixer *mixer, s16 *data, u16 len)
 {
     int rlen = len;
     int wlen = 0;
+    AUDIO_PROF_MARK_END(AUDIO_PROF_MIXER);
     if (!mix_out_remain) {
 #if MIX_OUT_DRC_EN
         mix_out_drc_run(data, len);
@@ -810,7 +802,7 @@ void __a2dp_drop_frame(void *p)
 
 static void __a2dp_clean_frame_by_number(struct a2dp_dec_hdl *dec, u16 num)
 {
-    u16 end_seqn = dec->seqn + num;
+    u16 end_seqn = dec->stream.seqn + num;
     if (end_seqn == 0) {
         end_seqn++;
     }
@@ -1006,29 +998,12 @@ static bool a2dp_bt_rx_overrun(void)
     return a2dp_media_get_remain_buffer_size() < 768 ? true : false;
 }
 
-AT(.bt_decode.text.cache.L2.a2dp)
-static void a2dp_decoder_stream_free(struct a2dp_dec_hdl *dec, void *packet)
-{
-    if (packet) {
-        a2dp_media_free_packet(packet);
-    }
-
-    if ((void *)packet == (void *)dec->repair_pkt) {
-        dec->repair_pkt = NULL;
-    }
-
-    if (dec->repair_pkt) {
-        a2dp_media_free_packet(dec->repair_pkt);
-        dec->repair_pkt = NULL;
-    }
-    dec->repair_pkt_len = 0;
-}
-
 static void a2dp_stream_underrun_feedback(void *priv);
 static int a2dp_audio_delay_time(struct a2dp_dec_hdl *dec);
-#define a2dp_seqn_before(a, b)  ((a < b && (u16)(b - a) < 1000) || (a > b && (u16)(a - b) > 1000))
-static int a2dp_buffered_stream_sample_rate(struct a2dp_dec_hdl *dec, u8 *from_packet, u16 *end_seqn)
+static int a2dp_decoder_audio_sync_handler(struct audio_decoder *decoder);
+static int a2dp_buffered_stream_sample_rate(void *priv, u8 *from_packet, u16 *end_seqn)
 {
+    struct a2dp_dec_hdl *dec = (struct a2dp_dec_hdl *)priv;
     u8 *packet = from_packet;
     int len = 0;
     int sample_rate = 0;
@@ -1051,207 +1026,85 @@ static int a2dp_buffered_stream_sample_rate(struct a2dp_dec_hdl *dec, u8 *from_p
     return sample_rate;
 }
 
-static int a2dp_stream_overrun_handler(struct a2dp_dec_hdl *dec, u8 **frame, int *len)
+AT(.bt_decode.text.cache.L2.a2dp)
+static int a2dp_stream_try_get_packet(void *priv, u8 **packet)
 {
-    u8 *packet = NULL;
-    int rlen = 0;
+    return a2dp_media_try_get_packet(packet);
+}
 
-    int msecs = 0;
-    int overrun = 0;
-    int sample_rate = 0;
-    u16 from_seqn = RB16(dec->repair_pkt + 2);
-    u16 seqn = from_seqn;
-    u16 end_seqn = 0;
-    overrun = 1;
-    while (1) {
-        msecs = a2dp_audio_delay_time(dec);
-        if (msecs < a2dp_delay_time) {
-            break;
-        }
-        overrun = 0;
-        rlen = a2dp_media_try_get_packet(&packet);
-        if (rlen <= 0) {
-            break;
-        }
+AT(.bt_decode.text.cache.L2.a2dp)
+static void a2dp_stream_free_packet(void *priv, void *packet)
+{
+    a2dp_media_free_packet(packet);
+}
 
-        sample_rate = a2dp_buffered_stream_sample_rate(dec, dec->repair_pkt, &end_seqn);
-        a2dp_decoder_stream_free(dec, NULL);
-        dec->repair_pkt = packet;
-        dec->repair_pkt_len = rlen;
-        seqn = RB16(packet + 2);
-        if (!a2dp_seqn_before(seqn, dec->overrun_seqn)) {
-            *frame = packet;
-            *len = rlen;
-            /*printf("------> end frame : %d\n", dec->overrun_seqn);*/
-            return 1;
-        }
+static int a2dp_stream_delay_time(void *priv)
+{
+    return a2dp_audio_delay_time((struct a2dp_dec_hdl *)priv);
+}
 
-        if (/*sample_rate < (dec->sample_rate * 4 / 5) || */sample_rate > (dec->sample_rate * 4 / 3)) {
-            if (a2dp_seqn_before(dec->overrun_seqn, end_seqn)) {
-                dec->overrun_seqn = end_seqn;
-            }
-            continue;
-        }
-    }
-    if (overrun) {
-        /*putchar('+');*/
-        /* dec->overrun_seqn++; */
-    } else {
-        /*putchar('-');*/
-    }
+static int a2dp_stream_rx_overrun(void *priv)
+{
+    return a2dp_bt_rx_overrun();
+}
 
-    *frame = dec->repair_pkt;
-    *len = dec->repair_pkt_len;
-    return 0;
+static int a2dp_stream_is_underrun(void *priv)
+{
+    return a2dp_audio_is_underrun((struct a2dp_dec_hdl *)priv);
 }
 
-static int a2dp_stream_missed_handler(struct a2dp_dec_hdl *dec, u8 **frame, int *len)
+AT(.bt_decode.text.cache.L2.a2dp)
+static int a2dp_stream_rtp_header_len(void *priv, u8 new_frame, u8 *packet, int len)
 {
-    int msecs = a2dp_audio_delay_time(dec);
-    *frame = dec->repair_pkt;
-    *len = dec->repair_pkt_len;
-    if ((msecs >= (dec->delay_time + 50) || a2dp_bt_rx_overrun()) || --dec->missed_num == 0) {
-        /*putchar('M');*/
-        return 1;
-    }
-    /*putchar('m');*/
-    return 0;
+    return get_rtp_header_len(new_frame, packet, len);
 }
 
-static int a2dp_stream_underrun_handler(struct a2dp_dec_hdl *dec, u8 **packet)
+static void a2dp_stream_packet_arrived(void *priv)
 {
+    struct a2dp_dec_hdl *dec = (struct a2dp_dec_hdl *)priv;
 
-    if (!a2dp_audio_is_underrun(dec)) {
-        putchar('x');
-        return 0;
-    }
-    putchar('X');
-    if (dec->stream_error != A2DP_STREAM_UNDERRUN) {
-        if (!dec->stream_error) {
-            a2dp_stream_underrun_feedback(dec);
-        }
-        dec->stream_error = a2dp_low_latency ? A2DP_STREAM_LOW_UNDERRUN : A2DP_STREAM_UNDERRUN;
-        dec->repair = a2dp_low_latency ? 0 : 1;
-    }
-    *packet = dec->repair_pkt;
-    dec->repair_frames++;
-    return dec->repair_pkt_len;
+    a2dp_decoder_audio_sync_handler(&dec->decoder);
 }
 
-static int a2dp_stream_error_filter(struct a2dp_dec_hdl *dec, u8 new_packet, u8 *packet, int len)
+static void a2dp_stream_error_recovered(void *priv)
 {
-    int err = 0;
+#if AUDIO_CODEC_SUPPORT_SYNC && TCFG_USER_TWS_ENABLE
+    struct a2dp_dec_hdl *dec = (struct a2dp_dec_hdl *)priv;
 
-    if (dec->coding_type == AUDIO_CODING_AAC) {
-        dec->header_len = get_rtp_header_len(dec->new_frame, packet, len);
-        dec->new_frame = 0;
-    } else {
-        dec->header_len = get_rtp_header_len(1, packet, len);
-    }
-
-    if (dec->header_len >= len) {
-        printf("##A2DP header error : %d\n", dec->header_len);
-        a2dp_decoder_stream_free(dec, packet);
-        return -EFAULT;
-    }
-
-    u16 seqn = RB16(packet + 2);
-    if (new_packet) {
-        if (dec->stream_error == A2DP_STREAM_UNDERRUN) {
-            int missed_frames = (u16)(seqn - dec->seqn) - 1;
-            if (missed_frames > dec->repair_frames) {
-                dec->stream_error = A2DP_STREAM_MISSED;
-                dec->missed_num = missed_frames - dec->repair_frames + 1;
-                /*printf("case 0 : %d, %d\n", missed_frames, dec->repair_frames);*/
-                err = -EAGAIN;
-            } else if (missed_frames < dec->repair_frames) {
-                dec->stream_error = A2DP_STREAM_OVERRUN;
-                dec->overrun_seqn = seqn + dec->repair_frames - missed_frames;
-                /*printf("case 1 : %d, %d, seqn : %d, %d\n", missed_frames, dec->repair_frames, seqn, dec->overrun_seqn);*/
-                err = -EAGAIN;
-            }
-        } else if (!dec->stream_error && (u16)(seqn - dec->seqn) > 1) {
-            dec->stream_error = A2DP_STREAM_MISSED;
-            if (a2dp_audio_delay_time(dec) < dec->delay_time) {
-                dec->missed_num = (u16)(seqn - dec->seqn);
-                err = -EAGAIN;
-            }
-            int pkt_len;
-            void *head = a2dp_media_fetch_packet(&pkt_len, NULL);
-            /*printf("case 2 : %d, %d, pkt : 0x%x, 0x%x\n", seqn, dec->seqn, (u32)head, (u32)packet);*/
-            if (dec->missed_num > 30) {
-                printf("##A serious mistake : A2DP stream missed too much, %d\n", dec->missed_num);
-                dec->missed_num = 30;
-            }
-        }
-        dec->repair_frames = 0;
-    }
-    if (!err && new_packet) {
-        dec->seqn = seqn;
+    if (dec->ts_handle) {
+        tws_a2dp_share_timestamp(dec->ts_handle);
     }
-    dec->repair_pkt = packet;
-    dec->repair_pkt_len = len;
-    return err;
+#endif
 }
 
+static const struct a2dp_packet_source a2dp_media_packet_source = {
+    .try_get_packet     = a2dp_stream_try_get_packet,
+    .free_packet        = a2dp_stream_free_packet,
+    .delay_time         = a2dp_stream_delay_time,
+    .rx_overrun         = a2dp_stream_rx_overrun,
+    .is_underrun        = a2dp_stream_is_underrun,
+    .rtp_header_len     = a2dp_stream_rtp_header_len,
+    .sample_rate_detect = a2dp_buffered_stream_sample_rate,
+    .underrun_feedback  = a2dp_stream_underrun_feedback,
+    .packet_arrived     = a2dp_stream_packet_arrived,
+    .error_recovered    = a2dp_stream_error_recovered,
+};
+
 AT(.bt_decode.text.cache.L2.a2dp)
 static int a2dp_dec_get_frame(struct audio_decoder *decoder, u8 **frame)
 {
     struct a2dp_dec_hdl *dec = container_of(decoder, struct a2dp_dec_hdl, decoder);
-    u8 *packet = NULL;
-    int len = 0;
-    u8 new_packet = 0;
-
-try_again:
-    switch (dec->stream_error) {
-    case A2DP_STREAM_OVERRUN:
-        new_packet = a2dp_stream_overrun_handler(dec, &packet, &len);
-        break;
-    case A2DP_STREAM_MISSED:
-        new_packet = a2dp_stream_missed_handler(dec, &packet, &len);
-        if (new_packet) {
-            break;
-        }
-    default:
-        len = a2dp_media_try_get_packet(&packet);
-        if (len <= 0) {
-            len = a2dp_stream_underrun_handler(dec, &packet);
-        } else {
-            a2dp_decoder_stream_free(dec, NULL);
-            new_packet = 1;
-            a2dp_decoder_audio_sync_handler(decoder);
-        }
-        break;
-    }
+    int len;
 
+    len = a2dp_stream_repair_get_frame(&dec->stream, frame);
     if (len <= 0) {
         return 0;
     }
 
-    int err = a2dp_stream_error_filter(dec, new_packet, packet, len);
-    if (err) {
-        if (-err == EAGAIN) {
-            dec->new_frame = 1;
-            goto try_again;
-        }
-        return 0;
-    }
-
-    *frame = packet + dec->header_len;
-    len -= dec->header_len;
-    if (dec->stream_error && new_packet) {
-#if AUDIO_CODEC_SUPPORT_SYNC && TCFG_USER_TWS_ENABLE
-        if (dec->ts_handle) {
-            tws_a2dp_share_timestamp(dec->ts_handle);
-        }
-#endif
-        dec->stream_error = 0;
-    }
-
     if (dec->slience_frames) {
         dec->slience_frames--;
     }
-    a2dp_decoder_set_timestamp(dec, dec->seqn);
+    a2dp_decoder_set_timestamp(dec, dec->stream.seqn);
 
     return len;
 }
@@ -1264,9 +1117,9 @@ static void a2dp_dec_put_frame(struct audio_decoder *decoder, u8 *frame)
 
     if (frame) {
         if (!a2dp_media_channel_exist() || app_var.goto_poweroff_flag) {
-            a2dp_decoder_stream_free(dec, (void *)(frame - dec->header_len));
+            a2dp_stream_repair_free(&dec->stream, (void *)(frame - dec->stream.header_len));
         }
-        /*a2dp_media_free_packet((void *)(frame - dec->header_len));*/
+        /*a2dp_media_free_packet((void *)(frame - dec->stream.header_len));*/
     }
 }
 
@@ -1285,9 +1138,9 @@ static int a2dp_dec_fetch_frame(struct audio_decoder *decoder, u8 **frame)
 __retry_fetch:
     packet = a2dp_media_fetch_packet(&len, NULL);
     if (packet) {
-        dec->header_len = get_rtp_header_len(1, packet, len);
-        *frame = packet + dec->header_len;
-        len -= dec->header_len;
+        dec->stream.header_len = get_rtp_header_len(1, packet, len);
+        *frame = packet + dec->stream.header_len;
+        len -= dec->stream.header_len;
     } else if (!dec->start) {
         if (time_before(jiffies, wait_timeout)) {
             os_time_dly(1);
@@ -1347,7 +1200,7 @@ static int a2dp_dec_rx_delay_monitor(struct audio_decoder *decoder, struct rt_st
 
 #if AUDIO_CODEC_SUPPORT_SYNC
     msecs = a2dp_audio_delay_time(dec);
-    if (dec->stream_error) {
+    if (dec->stream.stream_error) {
         return 0;
     }
 
@@ -1376,7 +1229,7 @@ static int a2dp_decoder_stream_delay_update(struct audio_decoder *decoder)
 
 #if AUDIO_CODEC_SUPPORT_SYNC
     msecs = a2dp_audio_delay_time(dec);
-    if (dec->stream_error) {
+    if (dec->stream.stream_error) {
         return 0;
     }
 
@@ -1485,11 +1338,11 @@ static void a2dp_stream_stability_detect(void *priv)
     }
 
     local_irq_disable();
-    if (a2dp_delay_time > dec->delay_time) {
+    if (a2dp_delay_time > dec->stream.delay_time) {
         if (a2dp_max_interval < a2dp_delay_time) {
             a2dp_delay_time -= 50;
-            if (a2dp_delay_time < dec->delay_time) {
-                a2dp_delay_time = dec->delay_time;
+            if (a2dp_delay_time < dec->stream.delay_time) {
+                a2dp_delay_time = dec->stream.delay_time;
             }
 
             if (a2dp_delay_time < a2dp_max_interval) {
@@ -1497,7 +1350,7 @@ static void a2dp_stream_stability_detect(void *priv)
             }
             update_a2dp_delay_report_time(a2dp_delay_time);
         }
-        a2dp_max_interval = dec->delay_time;
+        a2dp_max_interval = dec->stream.delay_time;
     }
     local_irq_enable();
 }
@@ -1532,14 +1385,14 @@ static int a2dp_decoder_stream_is_available(struct a2dp_dec_hdl *dec)
         return -EINVAL;
     }
 
-    dec->seqn = RB16(packet + 2);
+    dec->stream.seqn = RB16(packet + 2);
     if (dec->ts_handle) {
 #if TCFG_USER_TWS_ENABLE
-        if (!tws_network_audio_was_started() && !a2dp_audio_timestamp_is_available(dec->ts_handle, dec->seqn, 0, &drop)) {
+        if (!tws_network_audio_was_started() && !a2dp_audio_timestamp_is_available(dec->ts_handle, dec->stream.seqn, 0, &drop)) {
             if (drop) {
                 local_irq_disable();
                 u8 *check_packet = (u8 *)a2dp_media_fetch_packet(&len, NULL);
-                if (check_packet && RB16(check_packet + 2) == dec->seqn) {
+                if (check_packet && RB16(check_packet + 2) == dec->stream.seqn) {
                     a2dp_media_free_packet(packet);
                 }
                 local_irq_enable();
@@ -1575,13 +1428,14 @@ static int a2dp_dec_probe_handler(struct audio_decoder *decoder)
     }
     */
 
-    dec->new_frame = 1;
+    dec->stream.new_frame = 1;
     if (dec->pkt_frames) {
         a2dp_stream_bandwidth_detect_handler(dec, dec->pkt_frames);
     }
     dec->pkt_frames = 0;
 
     a2dp_dec_set_output_channel(dec);
+    AUDIO_PROF_MARK(AUDIO_PROF_DECODE);
 
     return err;
 }
@@ -1643,14 +1497,14 @@ AT(.bt_decode.text.cache.L2.a2dp)
 static int a2dp_decoder_slience_plc_filter(struct a2dp_dec_hdl *dec, void *data, int len)
 {
     if (len == 0) {
-        a2dp_decoder_stream_free(dec, NULL);
-        if (!dec->stream_error) {
-            dec->stream_error = A2DP_STREAM_DECODE_ERR;
-            dec->repair = 1;
+        a2dp_stream_repair_free(&dec->stream, NULL);
+        if (!dec->stream.stream_error) {
+            dec->stream.stream_error = A2DP_STREAM_DECODE_ERR;
+            dec->stream.repair = 1;
         }
         return 0;
     }
-    if (dec->stream_error) {
+    if (dec->stream.stream_error) {
         memset(data, 0x0, len);
     }
 #if TCFG_USER_TWS_ENABLE
@@ -1665,12 +1519,21 @@ static int a2dp_decoder_slience_plc_filter(struct a2dp_dec_hdl *dec, void *data,
     }
 #endif
 #if A2DP_AUDIO_PLC_ENABLE
-    if (dec->plc_ops) {
+    if (dec->plc) {
+        if (dec->slience_frames) {
+            /*静音帧不是解码数据，不送进修复历史*/
+            memset(data, 0x0, len);
+        } else {
+            /*分级修复：错误期间持续修复，按丢包时长从波形重复过渡到舒适噪声*/
+            audio_plc_process(dec->plc, data, len, dec->stream.stream_error ? 1 : 0);
+        }
+        dec->stream.repair = 0;
+    } else if (dec->plc_ops) {
         if (dec->slience_frames) {
             dec->plc_ops->run(dec->plc_mem, data, data, len >> 1, 2);
-        } else if (dec->stream_error) {
-            dec->plc_ops->run(dec->plc_mem, data, data, len >> 1, dec->repair ? 1 : 2);
-            dec->repair = 0;
+        } else if (dec->stream.stream_error) {
+            dec->plc_ops->run(dec->plc_mem, data, data, len >> 1, dec->stream.repair ? 1 : 2);
+            dec->stream.repair = 0;
         } else {
             dec->plc_ops->run(dec->plc_mem, data, data, len >> 1, 0);
         }
@@ -1688,8 +1551,8 @@ static void a2dp_stream_bandwidth_detect_handler(struct a2dp_dec_hdl *dec, int s
     /*int samples = (len >> 1) / A2DP_DECODE_CH_NUM(dec->channel);*/
     int max_latency = 0;
 
-    if (dec->repair_pkt_len) {
-        max_latency = (CONFIG_A2DP_MAX_BUF_SIZE * samples / dec->repair_pkt_len) * 1000 / dec->sample_rate * 8 / 10;
+    if (dec->stream.repair_pkt_len) {
+        max_latency = (CONFIG_A2DP_MAX_BUF_SIZE * samples / dec->stream.repair_pkt_len) * 1000 / dec->sample_rate * 8 / 10;
     }
 
     if (max_latency < CONFIG_A2DP_ADAPTIVE_MAX_LATENCY) {
@@ -1705,6 +1568,7 @@ static int a2dp_dec_output_handler(struct audio_decoder *decoder, s16 *data, int
     int wlen = 0;
     int data_len = len;
     struct a2dp_dec_hdl *dec = container_of(decoder, struct a2dp_dec_hdl, decoder);
+    AUDIO_PROF_MARK_END(AUDIO_PROF_DECODE);
     if (!dec->remain) {
         wlen = a2dp_decoder_slience_plc_filter(dec, data, len);
         if (wlen < len) {
@@ -1812,6 +1676,14 @@ static void a2dp_dec_event_handler(struct audio_decoder *decoder, int argc, int
 }
 
 
+static void a2dp_decoder_stream_setup(struct a2dp_dec_hdl *dec)
+{
+    a2dp_stream_repair_init(&dec->stream, &a2dp_media_packet_source, dec,
+                            dec->sample_rate, dec->coding_type == AUDIO_CODING_AAC);
+    dec->stream.target_delay = &a2dp_delay_time;
+    dec->stream.low_latency = &a2dp_low_latency;
+}
+
 static void a2dp_decoder_delay_time_setup(struct a2dp_dec_hdl *dec)
 {
 #if TCFG_USER_TWS_ENABLE
@@ -1825,7 +1697,7 @@ static void a2dp_decoder_delay_time_setup(struct a2dp_dec_hdl *dec)
     a2dp_max_interval = 0;
     a2dp_max_latency = CONFIG_A2DP_ADAPTIVE_MAX_LATENCY;
 
-    dec->delay_time = a2dp_delay_time;
+    dec->stream.delay_time = a2dp_delay_time;
 
     dec->detect_timer = sys_timer_add((void *)dec, a2dp_stream_stability_detect, A2DP_FLUENT_DETECT_INTERVAL);
 
@@ -1887,6 +1759,12 @@ static int a2dp_decoder_plc_setup(struct a2dp_dec_hdl *dec)
 #if A2DP_AUDIO_PLC_ENABLE
     int plc_mem_size;
     u8 nch = A2DP_DECODE_CH_NUM(dec->channel);
+#if A2DP_AUDIO_PLC_TIERED
+    dec->plc = audio_plc_create(dec->sample_rate, nch, 0);
+    if (dec->plc) {
+        return 0;
+    }
+#endif
     dec->plc_ops = get_lfaudioPLC_api();
     plc_mem_size = dec->plc_ops->need_buf(nch); // 3660bytes，请衡量是否使用该空间换取PLC处理
     dec->plc_mem = malloc(plc_mem_size);
@@ -1902,6 +1780,10 @@ static int a2dp_decoder_plc_setup(struct a2dp_dec_hdl *dec)
 static void a2dp_decoder_plc_free(struct a2dp_dec_hdl *dec)
 {
 #if A2DP_AUDIO_PLC_ENABLE
+    if (dec->plc) {
+        audio_plc_release(dec->plc);
+        dec->plc = NULL;
+    }
     if (dec->plc_mem) {
         free(dec->plc_mem);
         dec->plc_mem = NULL;
@@ -2041,6 +1923,7 @@ int a2dp_dec_start()
     }
     //dac_hdl.dec_channel_num = fmt->channel;
     dec->sample_rate = fmt->sample_rate;
+    a2dp_decoder_stream_setup(dec);
     a2dp_decoder_delay_time_setup(dec);
 #if TCFG_AUDIO_ANC_ENABLE && ANC_MUSIC_DYNAMIC_GAIN_EN
     audio_anc_music_dynamic_gain_init(dec->sample_rate);
@@ -2178,6 +2061,7 @@ static int a2dp_dut_dec_start(void)
     }
     //dac_hdl.dec_channel_num = fmt->channel;
     dec->sample_rate = fmt->sample_rate;
+    a2dp_decoder_stream_setup(dec);
     a2dp_decoder_delay_time_setup(dec);
     set_source_sample_rate(fmt->sample_rate);
     a2dp_dec_set_output_channel(dec);
@@ -2248,7 +2132,7 @@ static int __a2dp_audio_res_close(void)
     a2dp_decoder_syncts_free(a2dp_dec);
     a2dp_decoder_plc_free(a2dp_dec);
     a2dp_effect_develop_close(a2dp_dec);
-    a2dp_decoder_stream_free(a2dp_dec, NULL);
+    a2dp_stream_repair_free(&a2dp_dec->stream, NULL);
 #if TCFG_EQ_ENABLE&&TCFG_BT_MUSIC_EQ_ENABLE
     if (a2dp_dec->eq_drc) {
         dec_eq_drc_free(a2dp_dec->eq_drc);
@@ -2540,7 +2424,7 @@ int earphone_a2dp_codec_set_low_latency_mode(int enable, int msec)
     a2dp_low_latency = enable;
     a2dp_low_latency_seqn = 0;
 
-    r_printf("a2dp_low_latency: %d, %d, %d\n", a2dp_dec->seqn, a2dp_delay_time, enable);
+    r_printf("a2dp_low_latency: %d, %d, %d\n", a2dp_dec->stream.seqn, a2dp_delay_time, enable);
 
     if (!a2dp_dec || a2dp_dec->start == 0) {
 #if TCFG_USER_TWS_ENABLE
@@ -2550,9 +2434,9 @@ int earphone_a2dp_codec_set_low_latency_mode(int enable, int msec)
     }
 
     if (a2dp_dec->coding_type == AUDIO_CODING_SBC) {
-        a2dp_low_latency_seqn = a2dp_dec->seqn + (msec + a2dp_delay_time) / 15;
+        a2dp_low_latency_seqn = a2dp_dec->stream.seqn + (msec + a2dp_delay_time) / 15;
     } else {
-        a2dp_low_latency_seqn = a2dp_dec->seqn + (msec + a2dp_delay_time) / 20;
+        a2dp_low_latency_seqn = a2dp_dec->stream.seqn + (msec + a2dp_delay_time) / 20;
     }
 
 #if TCFG_USER_TWS_ENABLE
@@ -2796,6 +2680,7 @@ static int esco_dec_probe_handler(struct audio_decoder *decoder)
         dec->preempt = 0;
         dec->slience_frames = 30;
     }
+    AUDIO_PROF_MARK(AUDIO_PROF_DECODE);
     return err;
 
 }
@@ -2806,18 +2691,6 @@ static int esco_dec_probe_handler(struct audio_decoder *decoder)
 
 
 //////////////////////////////////////////////////////////////////////////////
-static inline void audio_pcm_mono_to_dual(s16 *dual_pcm, s16 *mono_pcm, int points)
-{
-    //printf("<%d,%x>",points,mono_pcm);
-    s16 *mono = mono_pcm;
-    int i = 0;
-    u8 j = 0;
-
-    for (i = 0; i < points; i++, mono++) {
-        *dual_pcm++ = *mono;
-        *dual_pcm++ = *mono;
-    }
-}
 /*level:0~15*/
 static const u16 esco_dvol_tab[] = {
     0,	//0
@@ -2884,7 +2757,7 @@ static int esco_decoder_mix_filter(struct esco_dec_hdl *dec, s16 *data, int len)
             if (point_num >= remain_points) {
                 point_num = remain_points;
             }
-            audio_pcm_mono_to_dual(two_ch_data, mono_data, point_num);
+            pcm_s16_mono_to_dual(two_ch_data, mono_data, point_num);
             dual_offset_points = 0;
             dual_total_points = point_num << 1;
             int tmp_len = audio_mixer_ch_write(&dec->mix_ch, &two_ch_data[dual_offset_points], (dual_total_points - dual_offset_points) << 1);
@@ -3021,6 +2894,7 @@ static int esco_dec_output_handler(struct audio_decoder *decoder, s16 *buf, int
     int len = size;
     short *data = buf;
     struct esco_dec_hdl *dec = container_of(decoder, struct esco_dec_hdl, decoder);
+    AUDIO_PROF_MARK_END(AUDIO_PROF_DECODE);
 
     /*非上次残留数据,进行后处理*/
     if (!dec->remain) {
@@ -3032,7 +2906,7 @@ static int esco_dec_output_handler(struct audio_decoder *decoder, s16 *buf, int
             audio_plc_run(data, len, *(u8 *)priv);
         }
 #if (SYS_VOL_TYPE == VOL_TYPE_DIGITAL)
-        audio_digital_vol_run(CALL_DVOL, data, len);
+        audio_digital_vol_run_ch(CALL_DVOL, data, len, 1);
         u16 dvol_val = esco_dvol_tab[app_var.aec_dac_gain];
         for (u16 i = 0; i < len / 2; i++) {
             s32 tmp_data = data[i];
@@ -3433,6 +3307,7 @@ int esco_dec_start()
     return 0;
 
 __err3:
+    audio_plc_close();
     audio_mixer_ch_close(&dec->mix_ch);
 __err2:
     audio_decoder_close(&dec->decoder);
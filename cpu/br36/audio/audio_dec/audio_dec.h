@@ -77,19 +77,6 @@ void a2dp_dec_output_set_start_bt_time(u32 bt_tmr);
 /*void mix_out_high_bass(u32 cmd, struct high_bass *hb);
 void mix_out_high_bass_dis(u32 cmd, u8 dis);*/
 
-//////////////////////////////////////////////////////////////////////////////
-static inline void audio_pcm_mono_to_dual(s16 *dual_pcm, s16 *mono_pcm, int points)
-{
-    s16 *mono = mono_pcm;
-    int i = 0;
-    u8 j = 0;
-
-    for (i = 0; i < points; i++, mono++) {
-        *dual_pcm++ = *mono;
-        *dual_pcm++ = *mono;
-    }
-}
-
 
 //////////////////////////////////////////////////////////////////////////////
 #include "audio_dec_file.h"
@@ -133,10 +133,14 @@ static int file_fread(struct audio_decoder *decoder, void *buf, u32 len)
 
 #if TCFG_DEC_DECRYPT_ENABLE
     u32 addr;
-    addr = fpos(dec->file);
-    rlen = fread(dec->file, buf, len);
-    if (rlen && (rlen <= len)) {
-        cryptanalysis_buff(&dec->mply_cipher, buf, addr, rlen);
+    if (!dec->mply_cipher.cipher_enable) { //非加密文件不取文件位置
+        rlen = fread(dec->file, buf, len);
+    } else {
+        addr = fpos(dec->file);
+        rlen = fread(dec->file, buf, len);
+        if (rlen && (rlen <= len)) {
+            cryptanalysis_buff(&dec->mply_cipher, buf, addr, rlen);//在解码器读缓存上原地解密
+        }
     }
 #else
     rlen = fread(dec->file, buf, len);
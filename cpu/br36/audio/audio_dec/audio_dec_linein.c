@@ -11,6 +11,7 @@
 #include "audio_codec_clock.h"
 #include "clock_cfg.h"
 #include "audio_dec_linein.h"
+#include "pcm_convert.h"
 
 #if (TCFG_APP_LINEIN_EN && TCFG_LINEIN_PCM_DECODER)
 
@@ -22,7 +23,6 @@ extern struct audio_dac_hdl dac_hdl;
 extern struct audio_adc_hdl adc_hdl;
 extern struct audio_decoder_task decode_task;
 extern struct audio_mixer mixer;
-extern void audio_pcm_mono_to_dual(s16 *dual_pcm, s16 *mono_pcm, int points);
 
 /* 函数声明 */
 static int linein_pcm_dec_data_read(struct audio_decoder *decoder, void *buf, u32 len);
@@ -118,7 +118,7 @@ static int linein_pcm_1to2_output_handler(struct pcm_dec_hdl *dec, s16 *data, in
 {
     int wlen = 0;
     if (!dec->two_ch_remain_len) {
-        audio_pcm_mono_to_dual(two_ch_data, data, len >> 1);
+        pcm_s16_mono_to_dual(two_ch_data, data, len >> 1);
         dec->two_ch_remain_addr = two_ch_data;
         dec->two_ch_remain_len = len << 1;
     }
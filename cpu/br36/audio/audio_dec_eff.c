@@ -3,9 +3,10 @@
 #include "debug.h"
 #include "system/syscfg_id.h"
 #include "media/mixer.h"
+#include "pcm_convert.h"
+#include "audio_mips_prof.h"
 extern struct audio_dac_hdl dac_hdl;
 extern const int const_surround_en;
-void user_sat16(s32 *in, s16 *out, u32 npoint);
 void a2dp_surround_set(u8 eff);
 int audio_out_eq_get_filter_info(void *eq, int sr, struct audio_eq_filter_info *info);
 int audio_out_eq_spec_set_info(struct audio_eq *eq, u8 idx, int freq, float gain);
@@ -309,7 +310,7 @@ static int eq_output(void *priv, void *buf, u32 len)
                 eff->eq_out_buf = malloc(eff->eq_out_buf_len);
                 ASSERT(eff->eq_out_buf);
             }
-            user_sat16((s32 *)data, (s16 *)eff->eq_out_buf, len / 4);
+            pcm_s32_to_s16((s16 *)eff->eq_out_buf, (s32 *)data, len / 4, 0);
             eff->eq_out_points = 0;
             eff->eq_out_total = len / 4;
 #endif
@@ -329,7 +330,6 @@ static int eq_output(void *priv, void *buf, u32 len)
 }
 
 
-
 int wdrc_get_filter_info(void *drc, struct audio_drc_filter_info *info)
 {
     static struct drc_ch wdrc_p = {0};
@@ -440,6 +440,7 @@ void *dec_eq_drc_setup(void *priv, int (*eq_output_cb)(void *, void *, int), u32
 #if defined(AUDIO_SPK_EQ_CONFIG) && AUDIO_SPK_EQ_CONFIG
     eff->spk_eq	= spk_eq_open(sample_rate, channel, drc_en ? 1 : 0);
 #endif/*AUDIO_SPK_EQ_CONFIG*/
+    eq_drc_buf_alloc(eff);
     return eff;
 #else
     return NULL;
@@ -562,6 +563,7 @@ void *esco_eq_drc_setup(void *priv, int (*eq_output_cb)(void *, void *, int), u3
         eff->async = async;
     }
 #endif//TCFG_DRC_ENABLE
+    eq_drc_buf_alloc(eff);
 
     return eff;
 #else
@@ -616,7 +618,7 @@ void *audio_out_eq_drc_setup(void *priv, int (*eq_output_cb)(void *, void *, int
         eff->async = async;
     }
 #endif //TCFG_DRC_ENABLE
-
+    eq_drc_buf_alloc(eff);
     return eff;
 #else
     return NULL;
@@ -631,40 +633,7 @@ void audio_out_eq_drc_free(void *eff)
 
 }
 
-__attribute__((always_inline))
-void sat16_to_sat32(s16 *in, s32 *out, u32 npoint, int factor)
-{
-#if 0
-    for (int i = 0; i < npoint; i ++) {
-        out[i] = in[i] * factor;
-    }
-#else
-    s64 tmp;
-    __asm__ volatile(
-        "1:											\n\t"
-        "rep %2 {									\n\t"        //循环
-        "%3 = h[%1 ++= 2]*%4(s)                              \n\t"
-        "[%0 ++= 4] = %3.l                            \n\t"   //%3.l意思是取tmp的低32位
-        "}										    \n\t"
-        "if(%2 != 0) goto 1b			            \n\t"
-        :
-        "=&r"(out),
-        "=&r"(in),
-        "=&r"(npoint),
-        "=&r"(tmp)
-        :
-        "r"(factor),
-        "0"(out),
-        "1"(in),
-        "2"(npoint),
-        "3"(tmp)
-        :
-    );
-
-#endif
-}
-
-int eq_drc_run(void *priv, void *data, u32 len)
+static int __eq_drc_run(void *priv, void *data, u32 len)
 {
 #if TCFG_EQ_ENABLE
     struct dec_eq_drc *eff = (struct dec_eq_drc *)priv;
@@ -683,23 +652,15 @@ int eq_drc_run(void *priv, void *data, u32 len)
     }
 #endif
 
-
 #if TCFG_DRC_ENABLE
-    if (eff->drc && !eff->async) {//同步32bit eq drc 处理
-        if ((!eff->eq_out_buf) || (eff->eq_out_buf_len < len * 2)) {
-            if (eff->eq_out_buf) {
-                free(eff->eq_out_buf);
-            }
-            eff->eq_out_buf_len = len * 2;
-            eff->eq_out_buf = malloc(eff->eq_out_buf_len);
-            ASSERT(eff->eq_out_buf);
-        }
-        audio_eq_set_output_buf(eff->eq, eff->eq_out_buf, len);
-
-        if (eff->drc_bef_eq && eff->drc_prev) {
-            sat16_to_sat32((short *)data, (int *)eff->eq_out_buf, len >> 1, 1);
-            audio_drc_run(eff->drc_prev, eff->eq_out_buf, len * 2);
-        }
+    if (eff->drc && !eff->async) {//同步32bit eq drc 分块处理
+        len = eq_drc_tile_run(eff, (s16 *)data, len);
+#if defined(TCFG_AUDIO_DAC_24BIT_MODE) && TCFG_AUDIO_DAC_24BIT_MODE
+        eff->eq_out_points = 0;
+        eff->eq_out_total = len >> 1;
+        eq_32bit_out(eff);
+#endif
+        return len;//返回16bit位宽长度
     }
 #endif//TCFG_DRC_ENABLE
 
@@ -711,37 +672,23 @@ int eq_drc_run(void *priv, void *data, u32 len)
     }
 #if defined(AUDIO_SPK_EQ_CONFIG) && AUDIO_SPK_EQ_CONFIG
     if (!eff->async) {
-        if (eff->drc) {
-            spk_eq_run(eff->spk_eq, eff->eq_out_buf, eff->eq_out_buf, len * 2);
-        } else {
-            spk_eq_run(eff->spk_eq, data, data, len);
-        }
+        spk_eq_run(eff->spk_eq, data, data, len);
     }
 #endif
-
-#if TCFG_DRC_ENABLE
-    if (eff->drc && !eff->async) {//同步32bit eq drc 处理
-        audio_drc_run(eff->drc, eff->eq_out_buf, len * 2);
-#if defined(TCFG_AUDIO_DAC_24BIT_MODE) && TCFG_AUDIO_DAC_24BIT_MODE
-        eff->eq_out_points = 0;
-        eff->eq_out_total = (len * 2) / 4;
-        eq_32bit_out(eff);
-        return len;//返回16bit位宽长度
-#else
-        user_sat16((s32 *)eff->eq_out_buf, (s16 *)data, (len * 2) / 4);
-#endif
-    }
-#endif//TCFG_DRC_ENABLE
-
-    if (eff->drc && !eff->async) {
-        return len;
-    }
     return eqlen;
 #else
     return len;
 #endif
 }
 
+int eq_drc_run(void *priv, void *data, u32 len)
+{
+    AUDIO_PROF_BEGIN(AUDIO_PROF_EQ_DRC);
+    int ret = __eq_drc_run(priv, data, len);
+    AUDIO_PROF_END(AUDIO_PROF_EQ_DRC);
+    return ret;
+}
+
 #if AUDIO_OUT_EQ_USE_SPEC_NUM
 
 static struct eq_seg_info audio_out_eq_tab[AUDIO_OUT_EQ_USE_SPEC_NUM] = {
@@ -1108,6 +1055,7 @@ void *dec_eq_drc_setup_new(void *priv, int (*eq_output_cb)(void *, void *, int),
         eff->drc = audio_dec_drc_open(&drc_param);
     }
 #endif//TCFG_DRC_ENABLE
+    eq_drc_buf_alloc(eff);
 
     return eff;
 #else
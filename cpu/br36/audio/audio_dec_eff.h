@@ -32,6 +32,15 @@ struct dec_sur {
 #define AUDIO_EQ_FADE_EN  1
 #define HIGH_BASS_EQ_FADE_STEP  (1)
 
+/*
+ *同步eq+drc分块处理：每块(16bit点数)依次经过drc_prev/eq/spk_eq/drc/饱和输出，
+ *32bit中间数据只占一块大小，常驻cache，不再整帧多次读写内存
+ */
+#define EQ_DRC_TILE_POINTS		256
+/*24bit dac输出时32bit结果需整帧缓存等待输出，单次最多处理的16bit点数，
+ *缓存在setup时按该值(EQ_DRC_TILE_POINTS对齐)一次申请*/
+#define EQ_DRC_BLOCK_POINTS_MAX	2048
+
 #if TCFG_EQ_ENABLE&&TCFG_AUDIO_OUT_EQ_ENABLE
 #define AUDIO_OUT_EFFECT_ENABLE			1	// 音频输出时的音效处理
 #else
@@ -64,6 +73,14 @@ struct dec_eq_drc {
     u8 remain;
 };
 
+/*同步eq drc分块处理(audio_eq_drc_tile.c)*/
+#if TCFG_DRC_ENABLE
+void eq_drc_buf_alloc(struct dec_eq_drc *eff);
+int eq_drc_tile_run(struct dec_eq_drc *eff, s16 *data, u32 len);
+#else
+#define eq_drc_buf_alloc(eff)
+#endif
+
 struct eq_parm_new {
     u8 in_mode: 2;
     u8 run_mode: 2;
@@ -15,6 +15,7 @@
 #include "app_main.h"
 #include "audio_config.h"
 #include "audio_enc.h"
+#include "audio_mic_capture.h"
 #include "app_config.h"
 
 #if TCFG_AUDIO_DMS_DUT_ENABLE
@@ -493,14 +494,18 @@ static int esco_iis_mic_en(u8 en, u16 sr, u16 gain)
 #define ESCO_ADC_CH			    1	//单mic通话
 #endif/*TCFG_AUDIO_DUAL_MIC_ENABLE*/
 #define ESCO_ADC_BUFS_SIZE      (ESCO_ADC_BUF_NUM * ESCO_ADC_IRQ_POINTS * ESCO_ADC_CH)
+#define ESCO_MIC_BLOCK_POINTS	256	//aec/dms输入帧长
+#define ESCO_MIC_BLOCK_NUM		2	//aec/dms同步拷贝输入，不保留view
 struct esco_mic_hdl {
     struct audio_adc_output_hdl adc_output;
     struct adc_mic_ch mic_ch;
     int adc_dump_cnt;
     s16 adc_buf[ESCO_ADC_BUFS_SIZE];    //align 2Bytes
-#if (ESCO_ADC_CH == 2)
-    s16 tmp_buf[ESCO_ADC_IRQ_POINTS];
-#endif/*ESCO_ADC_CH*/
+    struct mic_capture *capture;
+    struct mic_capture_output aec_output;
+#if TCFG_SIDETONE_ENABLE
+    struct mic_capture_output sidetone_output;
+#endif/*TCFG_SIDETONE_ENABLE*/
 };
 static struct esco_mic_hdl *esco_mic = NULL;
 void esco_mic_dump_set(u16 dump_cnt)
@@ -511,6 +516,45 @@ void esco_mic_dump_set(u16 dump_cnt)
     }
 }
 
+/*凑满一帧的平面数据直接送aec/dms，侧音打开时也不再二次凑帧*/
+static void esco_mic_aec_output(void *priv, struct mic_view *view)
+{
+    u16 len = view->points << 1;
+#if (ESCO_ADC_CH == 2)/*DualMic*/
+#if 0 /*debug*/
+    static u16 mic_cnt = 0;
+    if (mic_cnt++ > 300) {
+        putchar('1');
+        audio_aec_inbuf(view->ch[1], len);
+        if (mic_cnt > 600) {
+            mic_cnt = 0;
+        }
+    } else {
+        putchar('0');
+        audio_aec_inbuf(view->ch[0], len);
+    }
+    return;
+#endif/*debug end*/
+#if (TCFG_AUDIO_DMS_MIC_MANAGE == DMS_MASTER_MIC0)
+    audio_aec_inbuf_ref(view->ch[1], len);
+    audio_aec_inbuf(view->ch[0], len);
+#else
+    audio_aec_inbuf_ref(view->ch[0], len);
+    audio_aec_inbuf(view->ch[1], len);
+#endif/*TCFG_AUDIO_DMS_MIC_MANAGE*/
+#else/*SingleMic*/
+    audio_aec_inbuf(view->ch[0], len);
+#endif/*ESCO_ADC_CH*/
+}
+
+#if TCFG_SIDETONE_ENABLE
+/*每个adc周期送mic0数据，保持侧音低延时*/
+static void esco_mic_sidetone_output(void *priv, struct mic_view *view)
+{
+    audio_sidetone_inbuf(view->ch[0], view->points << 1);
+}
+#endif/*TCFG_SIDETONE_ENABLE*/
+
 /*adc_mic采样输出接口*/
 static void adc_mic_output_handler(void *priv, s16 *data, int len)
 {
@@ -528,49 +572,8 @@ static void adc_mic_output_handler(void *priv, s16 *data, int len)
             memset(data, 0, len);
             return;
         }
-
-#if (ESCO_ADC_CH == 2)/*DualMic*/
-        s16 *mic0_data = data;
-        s16 *mic1_data = esco_mic->tmp_buf;
-        s16 *mic1_data_pos = data + (len / 2);
-        //printf("mic_data:%x,%x,%d\n",data,mic1_data_pos,len);
-        for (u16 i = 0; i < (len >> 1); i++) {
-            mic0_data[i] = data[i * 2];
-            mic1_data[i] = data[i * 2 + 1];
-        }
-        memcpy(mic1_data_pos, mic1_data, len);
-
-#if 0 /*debug*/
-        static u16 mic_cnt = 0;
-        if (mic_cnt++ > 300) {
-            putchar('1');
-            audio_aec_inbuf(mic1_data_pos, len);
-            if (mic_cnt > 600) {
-                mic_cnt = 0;
-            }
-        } else {
-            putchar('0');
-            audio_aec_inbuf(mic0_data, len);
-        }
-        return;
-#endif/*debug end*/
-#if (TCFG_AUDIO_DMS_MIC_MANAGE == DMS_MASTER_MIC0)
-        audio_aec_inbuf_ref(mic1_data_pos, len);
-        audio_aec_inbuf(data, len);
-#else
-        audio_aec_inbuf_ref(data, len);
-        audio_aec_inbuf(mic1_data_pos, len);
-#endif/*TCFG_AUDIO_DMS_MIC_MANAGE*/
-#if TCFG_SIDETONE_ENABLE
-        audio_sidetone_inbuf(data, len);
-#endif/*TCFG_SIDETONE_ENABLE*/
-
-#else/*SingleMic*/
-        audio_aec_inbuf(data, len);
-#if TCFG_SIDETONE_ENABLE
-        audio_sidetone_inbuf(data, len);
-#endif/*TCFG_SIDETONE_ENABLE*/
-#endif/*ESCO_ADC_CH*/
+        /*len为每通道字节数，多mic数据交织存放*/
+        mic_capture_write(esco_mic->capture, data, len >> 1);
     }
 }
 extern void dmic_io_mux_ctl(u8 en, u8 sclk_sel);
@@ -590,6 +593,21 @@ static int esco_mic_en(u8 en, u16 sr, u16 mic0_gain, u16 mic1_gain)
             printf("esco mic zalloc failed\n");
             return -1;
         }
+        esco_mic->capture = mic_capture_open(ESCO_ADC_CH, ESCO_MIC_BLOCK_POINTS, ESCO_MIC_BLOCK_NUM);
+        if (esco_mic->capture == NULL) {
+            printf("esco mic capture open failed\n");
+            free(esco_mic);
+            esco_mic = NULL;
+            return -1;
+        }
+        esco_mic->aec_output.handler = esco_mic_aec_output;
+        esco_mic->aec_output.mode = MIC_OUTPUT_BLOCK;
+        mic_capture_add_output(esco_mic->capture, &esco_mic->aec_output);
+#if TCFG_SIDETONE_ENABLE
+        esco_mic->sidetone_output.handler = esco_mic_sidetone_output;
+        esco_mic->sidetone_output.mode = MIC_OUTPUT_PERIOD;
+        mic_capture_add_output(esco_mic->capture, &esco_mic->sidetone_output);
+#endif/*TCFG_SIDETONE_ENABLE*/
         audio_mic_pwr_ctl(MIC_PWR_ON);
 #if TCFG_AUDIO_ANC_ENABLE && TCFG_AUDIO_DYNAMIC_ADC_GAIN
 #if (!TCFG_AUDIO_DUAL_MIC_ENABLE && (TCFG_AUDIO_ADC_MIC_CHA & LADC_CH_MIC_R)) || \
@@ -638,6 +656,7 @@ static int esco_mic_en(u8 en, u16 sr, u16 mic0_gain, u16 mic1_gain)
 #endif/*TCFG_AUDIO_ADC_MIC_CH == LADC_CH_PLNK*/
 
             audio_mic_pwr_ctl(MIC_PWR_OFF);
+            mic_capture_close(esco_mic->capture);
             free(esco_mic);
             esco_mic = NULL;
 #if TCFG_SIDETONE_ENABLE
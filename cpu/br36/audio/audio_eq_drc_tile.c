@@ -0,0 +1,107 @@
+/*
+ ****************************************************************
+ *File : audio_eq_drc_tile.c
+ *Note : 同步32bit eq+drc分块处理
+ *		 每块依次经过drc_prev/eq/spk_eq/drc/饱和输出，逐块保留各音效状态，
+ *		 输出与整帧处理逐位一致(tools/host_test/eq_drc_tile_test.c)
+ ****************************************************************
+ */
+#ifndef AUDIO_EQ_DRC_TILE_HOST
+#include "audio_dec_eff.h"
+#include "pcm_convert.h"
+#endif
+
+#if TCFG_EQ_ENABLE && TCFG_DRC_ENABLE
+
+/*
+ *同步eq drc的32bit中间缓存，在setup时一次申请，处理过程中不再申请
+ *16bit输出只需一块大小；24bit输出需整帧缓存等待eq_32bit_out输出完，
+ *按单次最多处理的EQ_DRC_BLOCK_POINTS_MAX(块对齐)申请
+ */
+void eq_drc_buf_alloc(struct dec_eq_drc *eff)
+{
+    u32 points;
+
+    if (!eff || eff->async) {
+        return;
+    }
+    if (!eff->drc && !eff->drc_bef_eq) {
+        return;
+    }
+#if defined(TCFG_AUDIO_DAC_24BIT_MODE) && TCFG_AUDIO_DAC_24BIT_MODE
+    points = (EQ_DRC_BLOCK_POINTS_MAX + EQ_DRC_TILE_POINTS - 1) / EQ_DRC_TILE_POINTS * EQ_DRC_TILE_POINTS;
+#else
+    points = EQ_DRC_TILE_POINTS;
+#endif
+    if (eff->eq_out_buf && (eff->eq_out_buf_len >= points * 4)) {
+        return;
+    }
+    if (eff->eq_out_buf) {
+        free(eff->eq_out_buf);
+    }
+    eff->eq_out_buf_len = points * 4;
+    eff->eq_out_buf = malloc(eff->eq_out_buf_len);
+    ASSERT(eff->eq_out_buf);
+}
+
+/*
+ *一块数据依次经过所有使能的音效，32bit中间结果在cache中直接传递
+ *in:16bit输入(同时也是16bit输出)，tmp:本块32bit缓存，points:16bit点数
+ */
+static void eq_drc_run_tile(struct dec_eq_drc *eff, s16 *in, s32 *tmp, u32 points)
+{
+    audio_eq_set_output_buf(eff->eq, (s16 *)tmp, points * 2);
+
+    if (eff->drc_bef_eq && eff->drc_prev) {
+        pcm_s16_to_s32(tmp, in, points, 0);
+        audio_drc_run(eff->drc_prev, (s16 *)tmp, points * 4);
+    }
+
+    if (eff->drc_bef_eq) {
+        audio_eq_run(eff->eq, (s16 *)tmp, points * 4);
+    } else {
+        audio_eq_run(eff->eq, in, points * 2);
+    }
+
+#if defined(AUDIO_SPK_EQ_CONFIG) && AUDIO_SPK_EQ_CONFIG
+    spk_eq_run(eff->spk_eq, tmp, tmp, points * 4);
+#endif
+
+    audio_drc_run(eff->drc, (s16 *)tmp, points * 4);
+
+#if !(defined(TCFG_AUDIO_DAC_24BIT_MODE) && TCFG_AUDIO_DAC_24BIT_MODE)
+    pcm_s32_to_s16(in, tmp, points, 0);
+#endif
+}
+
+/*
+ *同步eq drc分块处理，返回处理的16bit长度
+ *16bit输出时结果写回data；24bit输出时32bit结果留在eq_out_buf，由调用者输出
+ */
+int eq_drc_tile_run(struct dec_eq_drc *eff, s16 *data, u32 len)
+{
+    s32 *tmp;
+    u32 points = len >> 1;
+    u32 tile;
+
+#if defined(TCFG_AUDIO_DAC_24BIT_MODE) && TCFG_AUDIO_DAC_24BIT_MODE
+    if (points > EQ_DRC_BLOCK_POINTS_MAX) {
+        points = EQ_DRC_BLOCK_POINTS_MAX;
+        len = points << 1;
+    }
+#endif
+    tmp = (s32 *)eff->eq_out_buf;
+
+    while (points) {
+        tile = points > EQ_DRC_TILE_POINTS ? EQ_DRC_TILE_POINTS : points;
+        eq_drc_run_tile(eff, data, tmp, tile);
+        data += tile;
+        points -= tile;
+#if defined(TCFG_AUDIO_DAC_24BIT_MODE) && TCFG_AUDIO_DAC_24BIT_MODE
+        tmp += tile;
+#endif
+    }
+    return len;
+}
+
+#endif//TCFG_EQ_ENABLE && TCFG_DRC_ENABLE
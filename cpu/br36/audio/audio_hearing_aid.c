@@ -28,6 +28,10 @@
 #include "audio_noise_gate.h"
 #include "amplitude_statistic.h"
 #include "audio_hearing_aid_lp.h"
+#include "clock_governor.h"
+#include "audio_mips_prof.h"
+#include "audio_hearing_aid_chain.h"
+#include "pcm_convert.h"
 
 
 #if TCFG_AUDIO_HEARING_AID_ENABLE
@@ -90,7 +94,12 @@ typedef struct {
 #else
 #define HEARING_AID_CLK     	(76 * 1000000L)
 #define DHA_MIC_SAMPLE_RATE		TCFG_AUDIO_DHA_MIC_SAMPLE_RATE
+#if DHA_LOW_LATENCY_ENABLE
+/*小块处理，4点对齐*/
+#define DHA_MIC_SAMPLE_POINT	((DHA_MIC_SAMPLE_RATE * DHA_LOW_LATENCY_BLOCK_MS / 1000) & ~3)
+#else
 #define DHA_MIC_SAMPLE_POINT	64
+#endif/*DHA_LOW_LATENCY_ENABLE*/
 #endif/*DHA_NS_ENABLE*/
 #if (DHA_MIC_SAMPLE_RATE == TCFG_AD2DA_LOW_LATENCY_SAMPLE_RATE)
 /*输入输出采样率一致，条件编译自动关闭SRC使能*/
@@ -150,6 +159,11 @@ typedef struct {
 #endif/*DHA_SRC_USE_HW_ENABLE*/
 #endif /*DHA_SRC_ENABLE*/
 
+    struct dha_chain chain;
+#if DHA_LATENCY_MEASURE_ENABLE
+    struct dha_latency latency;
+#endif/*DHA_LATENCY_MEASURE_ENABLE*/
+
 #if (TCFG_AUDIO_DAC_CONNECT_MODE == DAC_OUTPUT_LR)
     s16 mono_to_dual[(DHA_MIC_SAMPLE_POINT * TCFG_AD2DA_LOW_LATENCY_SAMPLE_RATE / DHA_MIC_SAMPLE_RATE) * 2 + 8];
 #endif/*TCFG_AUDIO_DAC_CONNECT_MODE*/
@@ -586,12 +600,17 @@ static int hearing_src_run(hearing_aid_t *hdl, s16 *indata, s16 *outdata, u16 le
 {
 #if DHA_SRC_USE_HW_ENABLE
     if (hdl->hw_src) {
-        return audio_src_resample_write(hdl->hw_src, indata, len);
+        AUDIO_PROF_BEGIN(AUDIO_PROF_SRC);
+        int wlen = audio_src_resample_write(hdl->hw_src, indata, len);
+        AUDIO_PROF_END(AUDIO_PROF_SRC);
+        return wlen;
     }
 #else
     int outlen = len;
     if (sw_src_api && sw_src_buf) {
+        AUDIO_PROF_BEGIN(AUDIO_PROF_SRC);
         outlen = sw_src_api->run(sw_src_buf, indata, len >> 1, outdata);
+        AUDIO_PROF_END(AUDIO_PROF_SRC);
         /* ASSERT(outlen <= (sizeof(outdata) >> 1));  */
         outlen = outlen << 1;
         /* printf("%d\n",outlen); */
@@ -996,7 +1015,7 @@ static void hearing_volume_run(s16 *data, int len)
         printf("[DHA]Volume:%d\n", audio_digital_vol_get(HEARING_DVOL));
     }
 #endif
-    audio_digital_vol_run(HEARING_DVOL, data, len);
+    audio_digital_vol_run_ch(HEARING_DVOL, data, len, 1);
 }
 /*设置音量*/
 static void hearing_volume_set(u8 volume)
@@ -1144,10 +1163,7 @@ int hearing_output(hearing_aid_t *hdl, s16 *data, u16 len)
     u16 data_len = len;
     int wlen = 0;
 #if (TCFG_AUDIO_DAC_CONNECT_MODE == DAC_OUTPUT_LR)
-    for (u16 i = 0; i < (len >> 1); i++) {
-        hdl->mono_to_dual[2 * i] 		= mic_data[i];
-        hdl->mono_to_dual[2 * i + 1] 	= mic_data[i];
-    }
+    pcm_s16_mono_to_dual(hdl->mono_to_dual, mic_data, len >> 1);
     mic_data = hdl->mono_to_dual;
     data_len = len + data_len;
 #endif/*TCFG_AUDIO_DAC_CONNECT_MODE*/
@@ -1169,6 +1185,96 @@ int hearing_output(hearing_aid_t *hdl, s16 *data, u16 len)
     return len;
 }
 
+/*
+*********************************************************************
+*                  Audio Hearing-aid Process Chain
+* Description: 按顺序登记打开的算法，逐块在mic数据上原地处理
+* Arguments  : NULL
+* Return	 : NULL
+* Note(s)    : 验配时由单频音替换整条处理链
+*********************************************************************
+*/
+#if (DHA_HS_FS_ENABLE || DHA_HS_NOTCH_ENABLE)
+static int dha_stage_howling(void *priv, s16 *data, int len)
+{
+    run_howling(priv, data, data, len >> 1);
+    return len;
+}
+#endif/*DHA_HS_FS_ENABLE || DHA_HS_NOTCH_ENABLE*/
+
+#if (DHA_EQ_ENABLE || DHA_DRC_ENABLE)
+static int dha_stage_eq_drc(void *priv, s16 *data, int len)
+{
+    hearing_eq_drc_run(priv, data, len);
+    return len;
+}
+#endif/*DHA_EQ_ENABLE || DHA_DRC_ENABLE*/
+
+#if (TCFG_EQ_ENABLE && DHA_EQ2_ENABLE)
+static int dha_stage_eq2(void *priv, s16 *data, int len)
+{
+    hearing_eq2_run(priv, data, len);
+    return len;
+}
+#endif /*TCFG_EQ_ENABLE && DHA_EQ2_ENABLE*/
+
+#if DHA_NOISE_GATE_ENABLE
+static int dha_stage_noise_gate(void *priv, s16 *data, int len)
+{
+    audio_noise_gate_run(data, data, len);
+    return len;
+}
+#endif/*DHA_NOISE_GATE_ENABLE*/
+
+#if DHA_NS_ENABLE
+static int dha_stage_llns(void *priv, s16 *data, int len)
+{
+    return llns_run(data, len);
+}
+#endif /*DHA_NS_ENABLE*/
+
+#if DHA_FADEIN_ENABLE
+static int dha_stage_fade_in(void *priv, s16 *data, int len)
+{
+    hearing_fade_in_run(data, len >> 1);
+    return len;
+}
+#endif/*DHA_FADEIN_ENABLE*/
+
+static void hearing_chain_build(hearing_aid_t *hdl)
+{
+    dha_chain_init(&hdl->chain);
+#if DHA_HS_FS_ENABLE
+    if (hdl->hs_fs) {
+        dha_chain_add(&hdl->chain, "hs_fs", dha_stage_howling, hdl->hs_fs);
+    }
+#endif/*DHA_HS_FS_ENABLE*/
+#if DHA_HS_NOTCH_ENABLE
+    if (hdl->hs_notch) {
+        dha_chain_add(&hdl->chain, "hs_notch", dha_stage_howling, hdl->hs_notch);
+    }
+#endif/*DHA_HS_NOTCH_ENABLE*/
+#if (DHA_EQ_ENABLE || DHA_DRC_ENABLE)
+    if (hdl->hearing_eq_drc) {
+        dha_chain_add(&hdl->chain, "eq_drc", dha_stage_eq_drc, hdl->hearing_eq_drc);
+    }
+#endif/*DHA_EQ_ENABLE || DHA_DRC_ENABLE*/
+#if (TCFG_EQ_ENABLE && DHA_EQ2_ENABLE)
+    if (hdl->hearing_eq2) {
+        dha_chain_add(&hdl->chain, "eq2", dha_stage_eq2, hdl->hearing_eq2);
+    }
+#endif /*TCFG_EQ_ENABLE && DHA_EQ2_ENABLE*/
+#if DHA_NOISE_GATE_ENABLE
+    dha_chain_add(&hdl->chain, "noise_gate", dha_stage_noise_gate, NULL);
+#endif/*DHA_NOISE_GATE_ENABLE*/
+#if DHA_NS_ENABLE
+    dha_chain_add(&hdl->chain, "llns", dha_stage_llns, NULL);
+#endif /*DHA_NS_ENABLE*/
+#if DHA_FADEIN_ENABLE
+    dha_chain_add(&hdl->chain, "fade_in", dha_stage_fade_in, NULL);
+#endif/*DHA_FADEIN_ENABLE*/
+}
+
 /*
 *********************************************************************
 *                  Audio Hearing-aid Task
@@ -1207,9 +1313,8 @@ static void audio_hearing_aid_task(void *p)
         data_len = hdl->mic_data_len;
 #endif /*DHA_MIC_DATA_CBUF_ENABLE*/
 
-        int clk = clk_get("sys");
-        if (clk < HEARING_AID_CLK) {
-            clk_set("sys", HEARING_AID_CLK);
+        if (clock_sys_budget() < HEARING_AID_CLK) {
+            clock_sys_request(HEARING_AID_CLK);
         }
 
 #if ((defined TCFG_AUDIO_DHA_LOW_POWER_ENABLE) && TCFG_AUDIO_DHA_LOW_POWER_ENABLE)
@@ -1220,6 +1325,12 @@ static void audio_hearing_aid_task(void *p)
         loudness_meter_short(&dha_in_loudness, mic_data, data_len >> 1);
 #endif /*DHA_IN_LOUDNESS_TRACE_ENABLE*/
 
+#if DHA_LATENCY_MEASURE_ENABLE
+        if (dha_latency_input(&hdl->latency, mic_data, data_len >> 1)) {
+            printf("[DHA]latency:%d(us)\n", dha_latency_result(&hdl->latency));
+        }
+#endif/*DHA_LATENCY_MEASURE_ENABLE*/
+
 
         //数据导出
 #if DHA_DATA_EXPORT_ENABLE
@@ -1238,42 +1349,10 @@ static void audio_hearing_aid_task(void *p)
         } else
 #endif /*TCFG_AUDIO_DHA_FITTING_ENABLE*/
         {
-            // 算法处理
-#if DHA_HS_FS_ENABLE
-            if (hdl->hs_fs) {
-                run_howling(hdl->hs_fs, mic_data, mic_data, data_len >> 1);
-            }
-#endif/*DHA_HS_FS_ENABLE*/
-
-#if DHA_HS_NOTCH_ENABLE
-            if (hdl->hs_notch) {
-                run_howling(hdl->hs_notch, mic_data, mic_data, data_len >> 1);
-            }
-#endif/*DHA_HS_NOTCH_ENABLE*/
-
-#if (DHA_EQ_ENABLE || DHA_DRC_ENABLE)
-            if (hdl->hearing_eq_drc) {
-                hearing_eq_drc_run(hdl->hearing_eq_drc, mic_data, data_len);
-            }
-#endif/*DHA_EQ_ENABLE || DHA_DRC_ENABLE*/
-
-#if (TCFG_EQ_ENABLE && DHA_EQ2_ENABLE)
-            if (hdl->hearing_eq2) {
-                hearing_eq2_run(hdl->hearing_eq2, mic_data, data_len);
-            }
-#endif /*TCFG_EQ_ENABLE && DHA_EQ2_ENABLE*/
-
-#if DHA_NOISE_GATE_ENABLE
-            audio_noise_gate_run(mic_data, mic_data, data_len);
-#endif/*DHA_NOISE_GATE_ENABLE*/
-
-#if DHA_NS_ENABLE
-            data_len = llns_run(mic_data, data_len);
-#endif /*DHA_NS_ENABLE*/
-
-#if DHA_FADEIN_ENABLE
-            hearing_fade_in_run(mic_data, (data_len >> 1));
-#endif/*DHA_FADEIN_ENABLE*/
+            // 算法处理，计入音频忙时间，时钟调节按实际负载保留辅听所需的时钟
+            AUDIO_PROF_BEGIN(AUDIO_PROF_DHA);
+            data_len = dha_chain_run(&hdl->chain, mic_data, data_len);
+            AUDIO_PROF_END(AUDIO_PROF_DHA);
         }
 
 #if DHA_VOLUME_ENABLE
@@ -1290,6 +1369,10 @@ static void audio_hearing_aid_task(void *p)
         loudness_meter_short(&dha_out_loudness, mic_data, data_len >> 1);
 #endif /*DHA_OUT_LOUDNESS_TRACE_ENABLE*/
 
+#if DHA_LATENCY_MEASURE_ENABLE
+        dha_latency_output(&hdl->latency, mic_data, data_len >> 1);
+#endif/*DHA_LATENCY_MEASURE_ENABLE*/
+
 #if DHA_SRC_ENABLE
 #if DHA_SRC_USE_HW_ENABLE
         hearing_src_run(hdl, mic_data, NULL, data_len);
@@ -1394,7 +1477,7 @@ int audio_hearing_aid_open(void)
         printf("hdl->adc_dma_buf malloc error!");
         goto __err;
     }
-    clk_set("sys", HEARING_AID_CLK);
+    clock_sys_request(HEARING_AID_CLK);
     /* audio_codec_clock_set(HEARING_AID_MODE, AUDIO_CODING_PCM, 0); */
 
 #if TCFG_AUDIO_DHA_FITTING_ENABLE
@@ -1494,6 +1577,8 @@ int audio_hearing_aid_open(void)
     //mem_stats();
 #endif /*DHA_SRC_ENABLE*/
 
+    hearing_chain_build(hdl);
+
     app_audio_state_switch(APP_AUDIO_STATE_MUSIC, get_max_sys_vol());
 
 #if DHA_VOLUME_ENABLE
@@ -1686,6 +1771,27 @@ int audio_hearing_aid_close(void)
     printf("audio_hearing_aid_close success!\n");
     return 0;
 }
+#if DHA_LATENCY_MEASURE_ENABLE
+int audio_hearing_aid_latency_measure(void)
+{
+    hearing_aid_t *hdl = (hearing_aid_t *)hearing_hdl;
+    if (hdl == NULL) {
+        return -EINVAL;
+    }
+    dha_latency_start(&hdl->latency, DHA_MIC_SAMPLE_RATE);
+    return 0;
+}
+
+int audio_hearing_aid_latency_get(void)
+{
+    hearing_aid_t *hdl = (hearing_aid_t *)hearing_hdl;
+    if (hdl == NULL) {
+        return -EINVAL;
+    }
+    return dha_latency_result(&hdl->latency);
+}
+#endif/*DHA_LATENCY_MEASURE_ENABLE*/
+
 char *dha_state_str[] = {
     "close",
     "open",
@@ -30,7 +30,14 @@
  ************************************************************************/
 #define DHA_AND_MEDIA_MUTEX_ENABLE		    1	//辅听功能和多媒体播放互斥
 #define DHA_SRC_USE_HW_ENABLE               1   //SRC选择，1:使用硬件SRC，0:使用软件SRC
+#define DHA_LOW_LATENCY_ENABLE              0   //小块低延时模式：按DHA_LOW_LATENCY_BLOCK_MS分块，直接在ADC DMA缓存上原地处理
+#define DHA_LOW_LATENCY_BLOCK_MS            2   //低延时模式处理块长(ms)，开降噪时固定为降噪帧长5ms
+#if DHA_LOW_LATENCY_ENABLE
+#define DHA_MIC_DATA_CBUF_ENABLE            0   //低延时模式不经cbuf拷贝
+#else
 #define DHA_MIC_DATA_CBUF_ENABLE            1   //是否使用cbuf缓存mic的数据
+#endif/*DHA_LOW_LATENCY_ENABLE*/
+#define DHA_LATENCY_MEASURE_ENABLE          0   //mic到dac整体延时测量(注入脉冲)，见audio_hearing_aid_latency_measure
 #define DHA_DAC_OUTPUT_ENHANCE_ENABLE       0   //DAC输出音量增强使能：用来提高辅听的动态范围
 #define DHA_TDE_ENABLE   				    0   //辅听信号延时估计
 #define DHA_IN_LOUDNESS_TRACE_ENABLE		0	//跟踪获取当前mic输入幅值
@@ -115,6 +122,10 @@ u8 get_hearing_aid_fitting_state(void);
 u8 set_hearing_aid_fitting_state(u8 state);
 void audio_dha_fitting_sync_close(void);
 int get_hearing_aid_state_cmd_info(u8 *data);
+/*开始一次整体延时测量(需打开DHA_LATENCY_MEASURE_ENABLE)，测量期间辅听输出静音*/
+int audio_hearing_aid_latency_measure(void);
+/*return:整体延时(us)，测量中返回-EBUSY，失败返回其他负值*/
+int audio_hearing_aid_latency_get(void);
 
 /*************************************************************************
  *						其他引用(Other Reference)
@@ -0,0 +1,130 @@
+/*
+ ****************************************************************
+ *							Hearing Aid Chain
+ * File  : audio_hearing_aid_chain.c
+ * By    :
+ * Notes : 辅听处理链和整体延时测量，说明见audio_hearing_aid_chain.h
+ ****************************************************************
+ */
+
+#ifdef DHA_CHAIN_HOST
+#include <string.h>
+#include <errno.h>
+#else
+#include "system/includes.h"
+#endif
+#include "audio_hearing_aid_chain.h"
+
+#define DHA_LATENCY_NOISE_MS		50		/*噪声统计时长*/
+#define DHA_LATENCY_TIMEOUT_MS		100		/*注入后最长等待时长*/
+#define DHA_LATENCY_THR_MIN			2000	/*检测门限下限*/
+#define DHA_LATENCY_PULSE			24000	/*脉冲幅度*/
+#define DHA_LATENCY_PULSE_POINTS	4		/*脉冲点数(正负交替)*/
+
+void dha_chain_init(struct dha_chain *chain)
+{
+    memset(chain, 0, sizeof(*chain));
+}
+
+int dha_chain_add(struct dha_chain *chain, const char *name, dha_stage_run_t run, void *priv)
+{
+    if ((run == NULL) || (chain->num >= DHA_CHAIN_STAGE_MAX)) {
+        return -1;
+    }
+    chain->stage[chain->num].name = name;
+    chain->stage[chain->num].run = run;
+    chain->stage[chain->num].priv = priv;
+    chain->num++;
+    return 0;
+}
+
+int dha_chain_run(struct dha_chain *chain, s16 *data, int len)
+{
+    for (u8 i = 0; (i < chain->num) && (len > 0); i++) {
+        len = chain->stage[i].run(chain->stage[i].priv, data, len);
+    }
+    return len;
+}
+
+void dha_latency_start(struct dha_latency *lat, u16 sample_rate)
+{
+    memset(lat, 0, sizeof(*lat));
+    lat->sample_rate = sample_rate;
+    lat->state = DHA_LATENCY_NOISE;
+}
+
+int dha_latency_input(struct dha_latency *lat, const s16 *data, int points)
+{
+    int ret = 0;
+
+    if (lat->state == DHA_LATENCY_NOISE) {
+        for (int i = 0; i < points; i++) {
+            s16 abs = data[i] < 0 ? (data[i] == -32768 ? 32767 : -data[i]) : data[i];
+            if (abs > lat->noise_peak) {
+                lat->noise_peak = abs;
+            }
+        }
+        /*输出块一直放不下完整脉冲，无法注入*/
+        if (lat->wait_points + points >= (u32)lat->sample_rate * (DHA_LATENCY_NOISE_MS + DHA_LATENCY_TIMEOUT_MS) / 1000) {
+            lat->state = DHA_LATENCY_FAIL;
+            ret = 1;
+        }
+    } else if (lat->state == DHA_LATENCY_WAIT) {
+        for (int i = 0; i < points; i++) {
+            if ((data[i] > lat->threshold) || (data[i] < -lat->threshold)) {
+                lat->result_points = lat->in_points + i - lat->inject_point;
+                lat->state = DHA_LATENCY_DONE;
+                ret = 1;
+                break;
+            }
+        }
+        if ((lat->state == DHA_LATENCY_WAIT) &&
+            (lat->wait_points + points >= (u32)lat->sample_rate * DHA_LATENCY_TIMEOUT_MS / 1000)) {
+            lat->state = DHA_LATENCY_FAIL;
+            ret = 1;
+        }
+    }
+    lat->in_points += points;
+    lat->wait_points += points;
+    return ret;
+}
+
+int dha_latency_output(struct dha_latency *lat, s16 *data, int points)
+{
+    if ((lat->state != DHA_LATENCY_NOISE) && (lat->state != DHA_LATENCY_WAIT)) {
+        return 0;
+    }
+    memset(data, 0, points * sizeof(s16));
+    /*块太短放不下完整脉冲时继续静音，等下一块*/
+    if ((lat->state == DHA_LATENCY_NOISE) && (points >= DHA_LATENCY_PULSE_POINTS) &&
+        (lat->wait_points >= (u32)lat->sample_rate * DHA_LATENCY_NOISE_MS / 1000)) {
+        s32 thr = lat->noise_peak * 4;
+        if (thr < DHA_LATENCY_THR_MIN) {
+            thr = DHA_LATENCY_THR_MIN;
+        }
+        lat->threshold = thr > DHA_LATENCY_PULSE / 2 ? DHA_LATENCY_PULSE / 2 : thr;
+        for (int i = 0; i < DHA_LATENCY_PULSE_POINTS; i++) {
+            data[i] = (i & 1) ? -DHA_LATENCY_PULSE : DHA_LATENCY_PULSE;
+        }
+        /*本块输出对应的mic输入从(in_points - points)开始*/
+        lat->inject_point = lat->in_points - points;
+        lat->wait_points = 0;
+        lat->state = DHA_LATENCY_WAIT;
+    }
+    return 1;
+}
+
+int dha_latency_result(struct dha_latency *lat)
+{
+    switch (lat->state) {
+    case DHA_LATENCY_DONE:
+        return (int)((u64)lat->result_points * 1000000 / lat->sample_rate);
+    case DHA_LATENCY_NOISE:
+    case DHA_LATENCY_WAIT:
+        return -EBUSY;
+    case DHA_LATENCY_FAIL:
+        return -ETIMEDOUT;
+    default:
+        return -EINVAL;
+    }
+}
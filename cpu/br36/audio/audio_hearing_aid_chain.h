@@ -0,0 +1,73 @@
+#ifndef _AUD_HEARING_AID_CHAIN_H_
+#define _AUD_HEARING_AID_CHAIN_H_
+
+#include "generic/typedef.h"
+
+/*
+ * 辅听处理链
+ * 各级处理按顺序登记，逐块在同一块缓存上原地运行，级间没有拷贝；
+ * 不依赖算法库和系统接口，定义DHA_CHAIN_HOST时可在PC上编译，
+ * 登记PC侧的处理级后用wav文件回放做回归和耗时统计(tools/host_test/dha_chain_replay.c)
+ */
+#define DHA_CHAIN_STAGE_MAX		12
+
+/*
+ * 原地处理一块数据
+ * len:字节长度
+ * return:处理后的字节长度，0表示本块没有输出(如降噪凑帧)
+ */
+typedef int (*dha_stage_run_t)(void *priv, s16 *data, int len);
+
+struct dha_stage {
+    const char *name;
+    dha_stage_run_t run;
+    void *priv;
+};
+
+struct dha_chain {
+    struct dha_stage stage[DHA_CHAIN_STAGE_MAX];
+    u8 num;
+};
+
+void dha_chain_init(struct dha_chain *chain);
+/*按处理顺序登记，return:0成功，超出DHA_CHAIN_STAGE_MAX返回-1*/
+int dha_chain_add(struct dha_chain *chain, const char *name, dha_stage_run_t run, void *priv);
+/*依次运行各级，某一级没有输出时停止，return:最终输出的字节长度*/
+int dha_chain_run(struct dha_chain *chain, s16 *data, int len);
+
+/*
+ * mic到dac的整体延时测量
+ * 1.先静音输出一段时间，统计环境噪声峰值作为检测门限
+ * 2.在输出中注入脉冲(只在放得下完整脉冲的输出块注入)，记下对应的mic输入点
+ * 3.保持静音，在mic输入中找第一个超过门限的点，两者之差即为整体延时
+ *   (处理块长 + dac缓存 + 声学路径)
+ * mic数据需在处理前送入dha_latency_input，输出数据在送dac(变采样)前送入dha_latency_output
+ */
+enum {
+    DHA_LATENCY_IDLE = 0,
+    DHA_LATENCY_NOISE,		/*统计噪声*/
+    DHA_LATENCY_WAIT,		/*已注入脉冲，等待检测*/
+    DHA_LATENCY_DONE,
+    DHA_LATENCY_FAIL,		/*超时没有检测到脉冲，或一直没有能注入脉冲的输出块*/
+};
+
+struct dha_latency {
+    u32 in_points;			/*已输入的mic点数*/
+    u32 inject_point;		/*脉冲对应的mic输入点*/
+    u32 result_points;
+    u32 wait_points;		/*当前状态已经过的点数*/
+    u16 sample_rate;
+    s16 noise_peak;
+    s16 threshold;
+    u8 state;
+};
+
+void dha_latency_start(struct dha_latency *lat, u16 sample_rate);
+/*送入处理前的mic数据，return:1表示本次测量刚结束(成功或超时)*/
+int dha_latency_input(struct dha_latency *lat, const s16 *data, int points);
+/*测量期间替换输出数据(静音/脉冲)，return:1表示输出被替换*/
+int dha_latency_output(struct dha_latency *lat, s16 *data, int points);
+/*return:延时(us)，测量中返回-EBUSY，超时或未测量返回-ETIMEDOUT/-EINVAL*/
+int dha_latency_result(struct dha_latency *lat);
+
+#endif/*_AUD_HEARING_AID_CHAIN_H_*/
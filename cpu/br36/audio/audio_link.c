@@ -14,6 +14,7 @@
 #include "audio_syncts.h"
 #include "audio_iis.h"
 #include "sound/sound.h"
+#include "pcm_convert.h"
 
 #if TCFG_AUDIO_INPUT_IIS || TCFG_AUDIO_OUTPUT_IIS || TCFG_ADC_IIS_ENABLE
 /*#define ALINK_TEST_ENABLE*/
@@ -790,36 +791,13 @@ static int __audio_iis_pcm_write(s16 *dst, s16 *src, int frames, int remapping,
     frames_offset += (frame_bytes >> 1) / 2;
     return frame_bytes;
     */
-    if (remapping == 1) {
-        if (convert_mode == SAMPLE_16BIT_TO_24BIT) {
-            int *dst_24bit = (int *)dst;
-            for (int i = 0; i < frames; i++) {
-                dst_24bit[i * 2] = src[i] << 8;
-                dst_24bit[i * 2 + 1] = src[i] << 8;
-            }
-        } else {
-            for (int i = 0; i < frames; i++) {
-                dst[i * 2] = src[i];
-                dst[i * 2 + 1] = src[i];
-            }
-        }
-        return frames << 1;
-    }
-
-    if (remapping == 2) {
-        if (convert_mode == SAMPLE_16BIT_TO_24BIT) {
-            int samples = frames * 2;
-            int *dst_24bit = (int *)dst;
-            for (int i = 0; i < samples; i++) {
-                dst_24bit[i] = src[i] << 8;
-            }
-        } else {
-            memcpy(dst, src, (frames << 1) * 2);
-        }
-        return frames << 2;
+    //16bit数据按iis位宽和声道数转换到dma buffer，单声道复制为双声道
+    u8 dst_fmt = convert_mode == SAMPLE_16BIT_TO_24BIT ? PCM_FMT_S24 : PCM_FMT_S16;
+    if (remapping == 1 || remapping == 2) {
+        pcm_convert(dst, dst_fmt, 2, src, PCM_FMT_S16, remapping, frames);
+        return frames << remapping;
     }
 
-
     return frames;
 }
 
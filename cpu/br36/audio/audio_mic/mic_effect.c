@@ -7,6 +7,7 @@
 /* #include "media/audio_stream.h" */
 #include "media/includes.h"
 #include "mic_effect.h"
+#include "pcm_convert.h"
 #include "asm/dac.h"
 /* #include "audio_enc/audio_enc.h" */
 /* #include "audio_dec.h" */
@@ -229,18 +230,6 @@ void aud_reverb_close(struct aud_reverb_process *hdl)
     hdl = NULL;
 }
 
-void pcm_single_to_dual_32bit(void *out, void *in, u16 len)
-{
-    s32 *outbuf = out;
-    s32 *inbuf = in;
-    len >>= 2;
-    while (len--) {
-        *outbuf++ = *inbuf;
-        *outbuf++ = *inbuf;
-        inbuf++;
-    }
-}
-
 s16 *aud_reverb_process_run(struct aud_reverb_process *hdl, s16 *data, int len)
 {
     struct __mic_effect  *eff = hdl->eff;
@@ -314,7 +303,7 @@ s16 *aud_reverb_process_run(struct aud_reverb_process *hdl, s16 *data, int len)
                 run_echo(eff->sub_1_echo_hdl, data, tar, len);
                 audio_dec_eq_run(eff->mic_eq2, tar, tar2, len); //16 ->32 1ch
                 audio_dec_drc_run(eff->mic_drc2, tar2, len * 2); //32bit 1ch
-                pcm_single_to_dual_32bit(hdl->tmpbuf[1], tar2, len * 2); //32bit 2ch out
+                pcm_s32_mono_to_dual((s32 *)hdl->tmpbuf[1], (s32 *)tar2, (len * 2) >> 2); //32bit 2ch out
             }
 
             //ch2
@@ -325,7 +314,7 @@ s16 *aud_reverb_process_run(struct aud_reverb_process *hdl, s16 *data, int len)
             tar = &tmp[len * 2]; //buf中间位置
             audio_dec_eq_run(eff->mic_eq3, data, tar, len);//16->32bit 1ch
             audio_dec_drc_run(eff->mic_drc3, tar, len * 2); //32bit 1ch
-            pcm_single_to_dual_32bit(hdl->tmpbuf[2], tar,  len * 2); //32bit 2ch
+            pcm_s32_mono_to_dual((s32 *)hdl->tmpbuf[2], (s32 *)tar, (len * 2) >> 2); //32bit 2ch
 
             points = (len * 2 * 2) / 4;
         }
@@ -738,65 +727,13 @@ void mic_effect_to_usbmic_onoff(u8 mark)
 #endif
 }
 
-static void  inline rl_rr_mix_to_rl_rr(short *data, int len)
-{
-    s32 tmp32_1;
-    s32 tmp32_2;
-    s16 *inbuf = data;
-    inbuf = inbuf + 2;  //定位到第三通道
-    len >>= 3;
-    __asm__ volatile(
-        "1:                      \n\t"
-        "rep %0 {                \n\t"
-        "  %2 = h[%1 ++= 2](s)     \n\t"  //取第三通道值，并地址偏移两个字节指向第四通道数据
-        " %3 = h[%1 ++= -2](s)   \n\t"   //取第四通道值，并地址偏移两个字节指向第三通道数据
-        " %2 = %2 + %3           \n\t"
-        " %2 = sat16(%2)(s)      \n\t"  //饱和处理
-        " h[%1 ++= 2] = %2      \n\t"  //存取第三通道数据，并地址偏移两个字节指向第四通道数据
-        " h[%1 ++= 6] = %2      \n\t"  //存取第四通道数据，并地址偏移六个字节指向第三通道相邻的数据
-        "}                      \n\t"
-        "if(%0 != 0) goto 1b    \n\t"
-        :
-        "=&r"(len),
-        "=&r"(inbuf),
-        "=&r"(tmp32_1),
-        "=&r"(tmp32_2)
-        :
-        "0"(len),
-        "1"(inbuf),
-        "2"(tmp32_1),
-        "3"(tmp32_2)
-        :
-    );
-}
 static int effect_to_dac_data_pro_handle(struct audio_stream_entry *entry,  struct audio_data_frame *in)
 {
 #if (SOUNDCARD_ENABLE)
     if (in->data_len == 0) {
         return 0;
     }
-#if 1
-    rl_rr_mix_to_rl_rr(in->data, in->data_len);//汇编加速
-#else
-    s16 *outbuf = in->data;
-    s16 *inbuf = in->data;
-    s32 tmp32;
-    u16 len = in->data_len;
-    len >>= 3;
-    while (len--) {
-        *outbuf++ = inbuf[0];
-        *outbuf++ = inbuf[1];
-        tmp32 = (inbuf[2] + inbuf[3]);
-        if (tmp32 < -32768) {
-            tmp32 = -32768;
-        } else if (tmp32 > 32767) {
-            tmp32 = 32767;
-        }
-        *outbuf++ = tmp32;
-        *outbuf++ = tmp32;
-        inbuf += 4;
-    }
-#endif
+    pcm_s16_qual_mix_rear(in->data, in->data_len >> 3);//rl/rr混合后写回后两路
 #endif
     return 0;
 }
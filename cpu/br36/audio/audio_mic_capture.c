@@ -0,0 +1,184 @@
+/*
+ ****************************************************************
+ *							MIC Capture
+ * File  : audio_mic_capture.c
+ * By    :
+ * Notes : 多mic采集拆分和分发，说明见audio_mic_capture.h
+ ****************************************************************
+ */
+
+#ifdef AUDIO_MIC_CAPTURE_HOST
+/*PC上回放(tools/host_test)，zalloc和开关中断由测试用的generic/typedef.h提供*/
+#include <string.h>
+#include <errno.h>
+#else
+#include "system/includes.h"
+#endif
+#include "audio_mic_capture.h"
+#include "pcm_convert.h"
+
+struct mic_block {
+    volatile u8 ref;		/*写入中的块由采集持有一个引用*/
+    s16 *data;				/*各通道依次存放，每通道block_points点*/
+};
+
+struct mic_capture {
+    struct mic_capture_output *output[MIC_CAPTURE_OUTPUT_MAX];
+    struct mic_block *cur;	/*正在写入的块*/
+    u32 overrun;
+    u16 block_points;
+    u16 offset;				/*当前块已写入点数*/
+    u8 ch_num;
+    u8 block_num;
+    u8 output_num;
+    u8 next;				/*下一个查找空闲块的位置*/
+    struct mic_block block[0];
+};
+
+struct mic_capture *mic_capture_open(u8 ch_num, u16 block_points, u8 block_num)
+{
+    struct mic_capture *cap;
+    u32 data_size = (u32)ch_num * block_points * sizeof(s16);
+
+    if (!ch_num || (ch_num > MIC_CAPTURE_CH_MAX) || !block_points || !block_num) {
+        return NULL;
+    }
+    cap = zalloc(sizeof(*cap) + block_num * (sizeof(struct mic_block) + data_size));
+    if (cap == NULL) {
+        return NULL;
+    }
+    s16 *data = (s16 *)&cap->block[block_num];
+    for (u8 i = 0; i < block_num; i++) {
+        cap->block[i].data = data + i * ch_num * block_points;
+    }
+    cap->ch_num = ch_num;
+    cap->block_points = block_points;
+    cap->block_num = block_num;
+    return cap;
+}
+
+void mic_capture_close(struct mic_capture *cap)
+{
+    if (cap) {
+        free(cap);
+    }
+}
+
+int mic_capture_add_output(struct mic_capture *cap, struct mic_capture_output *output)
+{
+    if ((output->handler == NULL) || (cap->output_num >= MIC_CAPTURE_OUTPUT_MAX)) {
+        return -1;
+    }
+    cap->output[cap->output_num++] = output;
+    return 0;
+}
+
+u32 mic_capture_overrun(struct mic_capture *cap)
+{
+    return cap->overrun;
+}
+
+int mic_view_get(struct mic_view *view)
+{
+    if (view->block == NULL) {
+        return -EPERM;
+    }
+    local_irq_disable();
+    view->block->ref++;
+    local_irq_enable();
+    return 0;
+}
+
+void mic_view_put(struct mic_view *view)
+{
+    if (view->block) {
+        local_irq_disable();
+        view->block->ref--;
+        local_irq_enable();
+    }
+}
+
+static void mic_capture_dispatch(struct mic_capture *cap, u8 mode, struct mic_view *view)
+{
+    for (u8 i = 0; i < cap->output_num; i++) {
+        if (cap->output[i]->mode == mode) {
+            cap->output[i]->handler(cap->output[i]->priv, view);
+        }
+    }
+}
+
+static void mic_capture_view(struct mic_capture *cap, struct mic_view *view, u16 offset, u16 points)
+{
+    for (u8 c = 0; c < cap->ch_num; c++) {
+        view->ch[c] = cap->cur->data + c * cap->block_points + offset;
+    }
+    view->points = points;
+    view->ch_num = cap->ch_num;
+    view->block = cap->cur;
+}
+
+/*取一个没有被输出保留的块*/
+static struct mic_block *mic_capture_alloc(struct mic_capture *cap)
+{
+    struct mic_block *block = NULL;
+
+    local_irq_disable();
+    for (u8 i = 0; i < cap->block_num; i++) {
+        u8 idx = (cap->next + i) % cap->block_num;
+        if (cap->block[idx].ref == 0) {
+            block = &cap->block[idx];
+            block->ref = 1;
+            cap->next = (idx + 1) % cap->block_num;
+            break;
+        }
+    }
+    local_irq_enable();
+    return block;
+}
+
+void mic_capture_write(struct mic_capture *cap, s16 *data, int frames)
+{
+    struct mic_view view;
+
+    if ((cap->ch_num == 1) && (cap->offset == 0) && (frames == cap->block_points)) {
+        view.ch[0] = data;
+        view.points = frames;
+        view.ch_num = 1;
+        view.block = NULL;
+        mic_capture_dispatch(cap, MIC_OUTPUT_PERIOD, &view);
+        mic_capture_dispatch(cap, MIC_OUTPUT_BLOCK, &view);
+        return;
+    }
+
+    while (frames > 0) {
+        if (cap->cur == NULL) {
+            cap->cur = mic_capture_alloc(cap);
+            if (cap->cur == NULL) {
+                cap->overrun++;
+                return;
+            }
+            cap->offset = 0;
+        }
+        u16 n = cap->block_points - cap->offset;
+        if (n > frames) {
+            n = frames;
+        }
+        mic_capture_view(cap, &view, cap->offset, n);
+        if (cap->ch_num == 2) {
+            pcm_s16_deinterleave(view.ch[0], view.ch[1], data, n);
+        } else {
+            memcpy(view.ch[0], data, n * sizeof(s16));
+        }
+        mic_capture_dispatch(cap, MIC_OUTPUT_PERIOD, &view);
+
+        cap->offset += n;
+        data += n * cap->ch_num;
+        frames -= n;
+        if (cap->offset == cap->block_points) {
+            mic_capture_view(cap, &view, 0, cap->block_points);
+            mic_capture_dispatch(cap, MIC_OUTPUT_BLOCK, &view);
+            mic_view_put(&view);
+            cap->cur = NULL;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef _AUDIO_MIC_CAPTURE_H_
+#define _AUDIO_MIC_CAPTURE_H_
+
+#include "generic/typedef.h"
+
+/*
+ * 多mic采集分发
+ * adc中断数据(多通道交织，每次一个周期)直接拆分到按块长分配的平面缓存，
+ * 各输出拿到的是指向缓存的view，不再各自拷贝/凑帧：
+ * MIC_OUTPUT_PERIOD  每个adc周期输出一次，view指向本周期刚写入的部分(如侧音)
+ * MIC_OUTPUT_BLOCK   凑满一块输出一次(如aec/dms的256点帧)
+ * view在handler返回前有效；需要在handler之外继续使用时调用mic_view_get，用完mic_view_put，
+ * 块缓存的引用计数归零后才会被重新写入，没有空闲块时丢弃数据并计数
+ */
+#define MIC_CAPTURE_CH_MAX			2
+#define MIC_CAPTURE_OUTPUT_MAX		4
+
+enum {
+    MIC_OUTPUT_PERIOD = 0,
+    MIC_OUTPUT_BLOCK,
+};
+
+struct mic_block;
+
+struct mic_view {
+    s16 *ch[MIC_CAPTURE_CH_MAX];	/*各通道数据*/
+    u16 points;						/*每通道点数*/
+    u8 ch_num;
+    struct mic_block *block;		/*NULL表示直接引用adc缓存，不能保留*/
+};
+
+struct mic_capture_output {
+    void (*handler)(void *priv, struct mic_view *view);
+    void *priv;
+    u8 mode;
+};
+
+struct mic_capture;
+
+/*
+ * ch_num:通道数  block_points:块长(每通道点数)  block_num:块缓存个数
+ * 输出都同步处理时2块即可，输出要异步保留view时按保留的块数增加
+ */
+struct mic_capture *mic_capture_open(u8 ch_num, u16 block_points, u8 block_num);
+void mic_capture_close(struct mic_capture *cap);
+/*按添加顺序调用，return:0成功，超出MIC_CAPTURE_OUTPUT_MAX返回-1*/
+int mic_capture_add_output(struct mic_capture *cap, struct mic_capture_output *output);
+/*
+ * 写入一个adc周期的交织数据并分发，在adc中断里调用
+ * frames:每通道点数
+ * 单mic且周期正好一块时直接把adc缓存作为view输出，不拷贝
+ */
+void mic_capture_write(struct mic_capture *cap, s16 *data, int frames);
+/*没有空闲块丢弃的周期数*/
+u32 mic_capture_overrun(struct mic_capture *cap);
+
+/*return:0成功，直接引用adc缓存的view返回-EPERM*/
+int mic_view_get(struct mic_view *view);
+void mic_view_put(struct mic_view *view);
+
+#endif/*_AUDIO_MIC_CAPTURE_H_*/
@@ -21,14 +21,30 @@ extern struct audio_encoder_task *encode_task;
 #define MIC_ENC_IN_SIZE		(ENC_ADC_IRQ_POINTS * 2)
 #define MIC_ENC_OUT_SIZE       (ENC_ADC_IRQ_POINTS)
 
+/*
+ *pcm输入缓存由adc中断写、编码任务读，可选用无锁spsc_ring代替cbuffer_t
+ *spsc_ring大小需为2的幂，向上取整到4096byte
+ */
+#define MIC_ENC_IN_SPSC_RING_EN	0
+#if MIC_ENC_IN_SPSC_RING_EN
+#include "generic/spsc_ring.h"
+#define MIC_ENC_IN_BUF_SIZE		(4096)
+#else
+#define MIC_ENC_IN_BUF_SIZE		(MIC_ENC_IN_SIZE * 4)
+#endif/*MIC_ENC_IN_SPSC_RING_EN*/
+
 struct mic_enc_hdl {
     struct audio_encoder encoder;
     OS_SEM pcm_frame_sem;
     u8 output_frame[MIC_ENC_OUT_SIZE];
     u8  pcm_frame[MIC_ENC_IN_SIZE];
     u8 frame_size;
-    u8 in_cbuf_buf[MIC_ENC_IN_SIZE * 4];
+    u8 in_cbuf_buf[MIC_ENC_IN_BUF_SIZE];
+#if MIC_ENC_IN_SPSC_RING_EN
+    spsc_ring_t pcm_in_ring;
+#else
     cbuffer_t pcm_in_cbuf;
+#endif/*MIC_ENC_IN_SPSC_RING_EN*/
     int (*mic_output)(void *priv, void *buf, int len);
 #if mic_ENC_PACK_ENABLE
     u16 cp_type;
@@ -67,7 +83,11 @@ static int mic_enc_pcm_get(struct audio_encoder *encoder, s16 **frame, u16 frame
 
 
     /* putchar('!'); */
+#if MIC_ENC_IN_SPSC_RING_EN
+    if (spsc_ring_data_len(&mic_enc->pcm_in_ring) < frame_len) {
+#else
     if ((&mic_enc->pcm_in_cbuf)->data_len < frame_len) {
+#endif/*MIC_ENC_IN_SPSC_RING_EN*/
         /* putchar('#'); */
         os_sem_set(&mic_enc->pcm_frame_sem, 0);
         os_sem_pend(&mic_enc->pcm_frame_sem, 5);
@@ -77,7 +97,11 @@ static int mic_enc_pcm_get(struct audio_encoder *encoder, s16 **frame, u16 frame
         }
     }
 
+#if MIC_ENC_IN_SPSC_RING_EN
+    pcm_len = spsc_ring_read(&mic_enc->pcm_in_ring, mic_enc->pcm_frame, frame_len);
+#else
     pcm_len = cbuf_read(&mic_enc->pcm_in_cbuf, mic_enc->pcm_frame, frame_len);
+#endif/*MIC_ENC_IN_SPSC_RING_EN*/
     if (pcm_len != frame_len) {
         putchar('L');
     }
@@ -138,7 +162,11 @@ static void mic_enc_event_handler(struct audio_decoder *decoder, int argc, int *
 static void adc_mic_output_handler(void *priv, s16 *data, int len)
 {
     if (mic_enc) {
+#if MIC_ENC_IN_SPSC_RING_EN
+        u16 wlen = spsc_ring_write(&mic_enc->pcm_in_ring, data, len);
+#else
         u16 wlen = cbuf_write(&mic_enc->pcm_in_cbuf, data, len);
+#endif/*MIC_ENC_IN_SPSC_RING_EN*/
         if (wlen != len) {
             putchar('@');
         }
@@ -197,7 +225,11 @@ int audio_mic_enc_open(int (*mic_output)(void *priv, void *buf, int len), u32 co
     }
 
     mic_enc_output_func_register(mic_output);
-    cbuf_init(&mic_enc->pcm_in_cbuf, mic_enc->in_cbuf_buf, MIC_ENC_IN_SIZE * 4);
+#if MIC_ENC_IN_SPSC_RING_EN
+    spsc_ring_init(&mic_enc->pcm_in_ring, mic_enc->in_cbuf_buf, MIC_ENC_IN_BUF_SIZE);
+#else
+    cbuf_init(&mic_enc->pcm_in_cbuf, mic_enc->in_cbuf_buf, MIC_ENC_IN_BUF_SIZE);
+#endif/*MIC_ENC_IN_SPSC_RING_EN*/
     os_sem_create(&mic_enc->pcm_frame_sem, 0);
     audio_encoder_open(&mic_enc->encoder, &mic_enc_input, encode_task);
     audio_encoder_set_handler(&mic_enc->encoder, &mic_enc_handler);
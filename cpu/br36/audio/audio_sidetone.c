@@ -4,6 +4,7 @@
 #include "audio_config.h"
 #include "sound_device.h"
 #include "audio_sidetone.h"
+#include "pcm_convert.h"
 
 #if TCFG_SIDETONE_ENABLE
 
@@ -24,18 +25,6 @@ static struct audio_sidetone_hdl {
 };
 static struct audio_sidetone_hdl *sidetone_hdl = NULL;
 
-static inline void audio_pcm_mono_to_dual(s16 *dual_pcm, s16 *mono_pcm, int points)
-{
-    s16 *mono = mono_pcm;
-    int i = 0;
-    u8 j = 0;
-
-    for (i = 0; i < points; i++, mono++) {
-        *dual_pcm++ = *mono;
-        *dual_pcm++ = *mono;
-    }
-}
-
 static void audio_sidetone_task(void)
 {
     if (!sidetone_hdl) {
@@ -69,7 +58,7 @@ static void audio_sidetone_task(void)
             printf("rlen err : %d\n", rlen);
         }
 #if (TCFG_AUDIO_DAC_CONNECT_MODE == DAC_OUTPUT_LR)
-        audio_pcm_mono_to_dual(sidetone_hdl->sidetone_buf_lr, sidetone_hdl->sidetone_buf, rlen >> 1);
+        pcm_s16_mono_to_dual(sidetone_hdl->sidetone_buf_lr, sidetone_hdl->sidetone_buf, rlen >> 1);
         u16 wlen = sound_pcm_dev_write(&sidetone_hdl->dac_ch, sidetone_hdl->sidetone_buf_lr, rlen <<= 1);
 #else
         u16 wlen = sound_pcm_dev_write(&sidetone_hdl->dac_ch, sidetone_hdl->sidetone_buf, rlen);
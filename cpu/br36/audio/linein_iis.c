@@ -8,6 +8,7 @@
 #include "app_action.h"
 #include "audio_dec/audio_dec_linein.h"
 #include "asm/audio_src.h"
+#include "audio_mips_prof.h"
 #if 1
 #define ADC_LINEIN_LOG	printf
 #else
@@ -431,7 +432,9 @@ static void hw_src_task(void *priv)
     while (1) {
         os_sem_pend(&linein->hw_src_sem, 0);
         data_len = cbuf_read(&linein->cbuf, linein->indata, cbuf_get_data_len(&linein->cbuf));
+        AUDIO_PROF_BEGIN(AUDIO_PROF_SRC);
         audio_src_resample_write(linein->hw_src, linein->indata, data_len);
+        AUDIO_PROF_END(AUDIO_PROF_SRC);
     }
 }
 
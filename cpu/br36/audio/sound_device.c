@@ -9,6 +9,7 @@
 #include "audio_config.h"
 #include "audio_syncts.h"
 #include "audio_dvol.h"
+#include "audio_mips_prof.h"
 #if TCFG_AUDIO_DAC_ENABLE
 #define SOUND_PCM_DAC_ENABLE    1
 #else
@@ -135,7 +136,7 @@ int sound_pcm_match_sample_rate(int sample_rate)
     return sample_rate;
 }
 
-int sound_pcm_dev_write(void *private_data, void *data, int len)
+static int __sound_pcm_dev_write(void *private_data, void *data, int len)
 {
     int wlen = len;
     if (SOUND_PCM_DEV_NUM == 1) {
@@ -176,6 +177,14 @@ int sound_pcm_dev_write(void *private_data, void *data, int len)
     return wlen;
 }
 
+int sound_pcm_dev_write(void *private_data, void *data, int len)
+{
+    AUDIO_PROF_BEGIN(AUDIO_PROF_DAC_WRITE);
+    int wlen = __sound_pcm_dev_write(private_data, data, len);
+    AUDIO_PROF_END(AUDIO_PROF_DAC_WRITE);
+    return wlen;
+}
+
 void sound_pcm_dev_add_syncts(void *priv)
 {
     /*蓝牙音频同步仅能挂载到一个设备上，无法挂载多个*/
@@ -7,6 +7,7 @@
 #include "aec_user.h"
 #include "audio_dvol.h"
 #include "audio_codec_clock.h"
+#include "audio_mips_prof.h"
 #if TCFG_AUDIO_HEARING_AID_ENABLE
 #include "audio_hearing_aid.h"
 #endif/*TCFG_AUDIO_HEARING_AID_ENABLE*/
@@ -103,6 +104,7 @@ struct tone_sine_handle {
     u32 sine_id;
     u32 sine_offset;
     void *sin_maker;
+    u8 synth;
     struct audio_decoder decoder;
     struct audio_mixer_ch mix_ch;
     struct sin_param sin_dynamic_params[8];
@@ -696,7 +698,9 @@ static int tone_output_after_syncts_filter(void *priv, void *data, int len)
 #endif/*SYS_VOL_TYPE == VOL_TYPE_DIGITAL*/
 
     if (dec->hw_src) {
+        AUDIO_PROF_BEGIN(AUDIO_PROF_SRC);
         wlen = audio_src_resample_write(dec->hw_src, data, len);
+        AUDIO_PROF_END(AUDIO_PROF_SRC);
         if (wlen < len) {
             audio_hw_src_trigger_resume(dec->hw_src, &dec->decoder, (void (*)(void *))audio_decoder_resume);
         }
@@ -1081,7 +1085,11 @@ static int sine_fread(struct audio_decoder *decoder, void *buf, u32 len)
     int offset;
     u8 *data = (u8 *)buf;
 
-    offset = sin_tone_make(sine_dec->sin_maker, data, len);
+    if (sine_dec->synth) {
+        offset = sine_synth_make(sine_dec->sin_maker, data, len);
+    } else {
+        offset = sin_tone_make(sine_dec->sin_maker, data, len);
+    }
     sine_dec->sine_offset += offset;
 
     return offset;
@@ -1095,6 +1103,9 @@ static int sine_fseek(struct audio_decoder *decoder, u32 offset, int seek_mode)
 
 static int sine_flen(struct audio_decoder *decoder)
 {
+    if (sine_dec->synth) {
+        return sine_synth_points(sine_dec->sin_maker) * 2;
+    }
     return sin_tone_points(sine_dec->sin_maker) * 2;
 }
 
@@ -1264,6 +1275,30 @@ void tone_play_set_sine_param_handler(get_sine_param_t handler)
     get_sine_param_data = handler;
 }
 
+static get_synth_note_t get_synth_note_data = NULL;
+
+__BANK_INIT
+void tone_play_set_synth_note_handler(get_synth_note_t handler)
+{
+    get_synth_note_data = handler;
+}
+
+/*合成提示音按输出采样率在open时一次换算，不需要sine_param_resample*/
+static void *sine_synth_tone_open(u32 sine_id, u32 sample_rate, u8 channel)
+{
+    const struct sine_synth_note *note;
+    u8 num = 0;
+
+    if (!get_synth_note_data) {
+        return NULL;
+    }
+    note = get_synth_note_data(DEFAULT_SINE_ID(sine_id) & ~SINE_SYNTH_ID_FLAG, &num);
+    if (!note) {
+        return NULL;
+    }
+    return sine_synth_open(note, num, sample_rate, channel, sine_dec->repeat);
+}
+
 static struct sin_param *get_sine_param(u32 sine_id, u32 sample_rate, u8 *data_num)
 {
     const struct sin_param *sin_data_param;
@@ -1310,6 +1345,16 @@ static int sine_dec_probe_handler(struct audio_decoder *decoder)
 
         printf("sine: %d, %d\n", sample_rate, channel);
 
+        if (IS_SYNTH_TONE(sine_dec->sine_id)) {
+            sine_dec->sin_maker = sine_synth_tone_open(sine_dec->sine_id, sample_rate, channel);
+            if (!sine_dec->sin_maker) {
+                return -ENOENT;
+            }
+            sine_dec->synth = 1;
+            audio_mixer_ch_set_sample_rate(&sine_dec->mix_ch, sound_pcm_match_sample_rate(sample_rate));
+            return 0;
+        }
+
         param = get_sine_param(sine_dec->sine_id, sample_rate, &num);
         if (!param) {
             return -ENOENT;
@@ -1496,7 +1541,11 @@ int sine_dec_close(void)
     audio_decoder_close(&sine_dec->decoder);
     audio_mixer_ch_close(&sine_dec->mix_ch);
     if (sine_dec->sin_maker) {
-        sin_tone_close(sine_dec->sin_maker);
+        if (sine_dec->synth) {
+            sine_synth_close(sine_dec->sin_maker);
+        } else {
+            sin_tone_close(sine_dec->sin_maker);
+        }
     }
 
     if (app_audio_get_state() == APP_AUDIO_STATE_WTONE) {
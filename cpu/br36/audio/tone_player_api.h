@@ -29,6 +29,15 @@ typedef const struct sin_param *(*get_sine_param_t)(u8 id, u8 *num);
 
 void tone_play_set_sine_param_handler(get_sine_param_t handler);
 
+/*多声部合成提示音(DTMF/和弦)，id由get_synth_note_t回调解析*/
+#define SINE_SYNTH_ID_FLAG       0x8000
+#define DEFAULT_SYNTH_TONE(a)    DEFAULT_SINE_TONE(SINE_SYNTH_ID_FLAG | (a))
+#define IS_SYNTH_TONE(a)         (IS_DEFAULT_SINE(a) && (((u32)(a)) & SINE_SYNTH_ID_FLAG))
+
+typedef const struct sine_synth_note *(*get_synth_note_t)(u8 id, u8 *num);
+
+void tone_play_set_synth_note_handler(get_synth_note_t handler);
+
 
 int tone_play(const char *name, u8 preemption) ;
 
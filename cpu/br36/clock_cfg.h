@@ -108,6 +108,9 @@ void clock_set_cur(void);
 void clock_add_set(u32 type);
 void clock_remove_set(u32 type);
 
+u8 clock_tb_get(const u8 **tb);
+u32 clock_floor_get(void);
+
 
 
 
@@ -0,0 +1,225 @@
+/*
+ ****************************************************************
+ *							CLOCK GOVERNOR
+ * File  : clock_governor.c
+ * By    :
+ * Notes : 按实测音频负载调节系统时钟，策略说明见clock_governor.h
+ ****************************************************************
+ */
+
+#ifndef CLOCK_GOVERNOR_HOST
+#include "system/includes.h"
+#include "app_config.h"
+#include "clock_cfg.h"
+#include "audio/sound_device.h"
+#include "audio_mips_prof.h"
+#endif
+#include "clock_governor.h"
+
+#define GOV_MHZ		1000000L
+
+/*大于hz的最小档位，不超过上限*/
+static u32 clock_gov_level_above(struct clock_gov *gov, u32 hz)
+{
+    for (u8 i = 0; i < gov->tb_num; i++) {
+        u32 level = gov->tb[i] * GOV_MHZ;
+        if (level >= gov->ceil_hz) {
+            break;
+        }
+        if (level > hz) {
+            return level;
+        }
+    }
+    return gov->ceil_hz;
+}
+
+/*不小于need的最小档位，限制在上下限之间*/
+static u32 clock_gov_level_match(struct clock_gov *gov, u32 need)
+{
+    if (need <= gov->floor_hz) {
+        return gov->floor_hz;
+    }
+    return clock_gov_level_above(gov, need - 1);
+}
+
+/*小于hz的最大档位，不低于下限*/
+static u32 clock_gov_level_below(struct clock_gov *gov, u32 hz)
+{
+    for (int i = gov->tb_num - 1; i >= 0; i--) {
+        u32 level = gov->tb[i] * GOV_MHZ;
+        if (level <= gov->floor_hz) {
+            break;
+        }
+        if ((level < hz) && (level < gov->ceil_hz)) {
+            return level;
+        }
+    }
+    return gov->floor_hz;
+}
+
+void clock_gov_reset(struct clock_gov *gov, u32 floor_hz, u32 ceil_hz)
+{
+    if (floor_hz > ceil_hz) {
+        floor_hz = ceil_hz;
+    }
+    gov->floor_hz = floor_hz;
+    gov->ceil_hz = ceil_hz;
+    gov->cur_hz = ceil_hz;
+    gov->down_cnt = 0;
+    gov->settle = 1;
+}
+
+u32 clock_gov_step(struct clock_gov *gov, const struct clock_gov_sample *sample)
+{
+    u32 cur = gov->cur_hz;
+    u32 next = cur;
+    u8 settle = gov->settle;
+
+    gov->settle = 0;
+    if ((sample->slack_ms >= 0) && (sample->slack_ms < CLOCK_GOV_SLACK_MIN_MS)) {
+        /*输出快断流了，先保证不断音*/
+        next = gov->ceil_hz;
+        gov->down_cnt = 0;
+    } else if (sample->busy_permille > CLOCK_GOV_UP_PERMILLE) {
+        u32 need = (u32)((u64)cur * sample->busy_permille / CLOCK_GOV_TARGET_PERMILLE);
+        next = clock_gov_level_match(gov, need);
+        if (next <= cur) {
+            next = clock_gov_level_above(gov, cur);
+        }
+        gov->down_cnt = 0;
+    } else if (!settle && (cur > gov->floor_hz)) {
+        u32 lower = clock_gov_level_below(gov, cur);
+        u32 proj = (u32)((u64)sample->busy_permille * cur / lower);
+        if ((proj < CLOCK_GOV_DOWN_PERMILLE) &&
+            ((sample->slack_ms < 0) || (sample->slack_ms >= CLOCK_GOV_SLACK_OK_MS))) {
+            if (++gov->down_cnt >= CLOCK_GOV_DOWN_WINDOWS) {
+                next = lower;
+                gov->down_cnt = 0;
+            }
+        } else {
+            gov->down_cnt = 0;
+        }
+    }
+
+    if (next != cur) {
+        gov->cur_hz = next;
+        gov->settle = 1;
+    }
+    return next;
+}
+
+#ifndef CLOCK_GOVERNOR_HOST
+
+#if CLOCK_GOVERNOR_ENABLE
+
+#if !AUDIO_MIPS_PROF_ENABLE
+#error "CLOCK_GOVERNOR_ENABLE depends on AUDIO_MIPS_PROF_ENABLE"
+#endif
+
+static struct clock_gov sys_gov;
+static u16 gov_timer;
+static volatile u8 gov_pending;
+static u32 gov_time_last;
+static u32 gov_busy_last;
+
+static void clock_gov_apply(u32 hz)
+{
+    clk_set("sys", hz);
+    /*以实际设置的频率为准，用于识别其他地方直接修改时钟*/
+    sys_gov.cur_hz = clk_get("sys");
+}
+
+static void clock_gov_window(void)
+{
+    struct clock_gov_sample sample;
+    u32 now, busy, time_cnt, busy_cnt;
+    u32 clk = clk_get("sys");
+    int slack;
+
+    gov_pending = 0;
+    now = audio_mips_prof_now();
+    busy = audio_mips_prof_busy();
+    time_cnt = now - gov_time_last;
+    busy_cnt = busy - gov_busy_last;
+    gov_time_last = now;
+    gov_busy_last = busy;
+
+    if (clk != sys_gov.cur_hz) {
+        /*其他地方直接clk_set修改了时钟，作为新的上限*/
+        clock_gov_reset(&sys_gov, sys_gov.floor_hz, clk);
+        return;
+    }
+    if (!sound_pcm_dev_is_running()) {
+        /*没有音频输出时负载统计不可信，回到静态预算*/
+        if (sys_gov.cur_hz != sys_gov.ceil_hz) {
+            clock_gov_reset(&sys_gov, sys_gov.floor_hz, sys_gov.ceil_hz);
+            clock_gov_apply(sys_gov.ceil_hz);
+        }
+        return;
+    }
+
+    sample.busy_permille = 0;
+    if (time_cnt) {
+        u64 permille = (u64)busy_cnt * 1000 / time_cnt;
+        sample.busy_permille = permille > 1000 ? 1000 : permille;
+    }
+    slack = sound_pcm_dev_buffered_time();
+    sample.slack_ms = slack > 0x7fff ? 0x7fff : slack;
+
+    u32 next = clock_gov_step(&sys_gov, &sample);
+    if (next != clk) {
+        clock_gov_apply(next);
+    }
+}
+
+static void clock_gov_timer(void *priv)
+{
+    int msg[2];
+
+    if (gov_pending) {
+        return;
+    }
+    gov_pending = 1;
+    msg[0] = (int)clock_gov_window;
+    msg[1] = 0;
+    if (os_taskq_post_type("app_core", Q_CALLBACK, 2, msg)) {
+        gov_pending = 0;
+    }
+}
+
+void clock_sys_request(u32 hz)
+{
+    if (sys_gov.tb == NULL) {
+        sys_gov.tb_num = clock_tb_get(&sys_gov.tb);
+    }
+    clock_gov_reset(&sys_gov, clock_floor_get(), hz);
+    clock_gov_apply(hz);
+    sys_gov.ceil_hz = sys_gov.cur_hz;
+    if (!gov_timer) {
+        gov_time_last = audio_mips_prof_now();
+        gov_busy_last = audio_mips_prof_busy();
+        /*低优先级定时，不唤醒低功耗*/
+        gov_timer = usr_timer_add(NULL, clock_gov_timer, CLOCK_GOV_WINDOW_MS, 0);
+    }
+}
+
+u32 clock_sys_budget(void)
+{
+    return sys_gov.ceil_hz ? sys_gov.ceil_hz : clk_get("sys");
+}
+
+#else
+
+void clock_sys_request(u32 hz)
+{
+    clk_set("sys", hz);
+}
+
+u32 clock_sys_budget(void)
+{
+    return clk_get("sys");
+}
+
+#endif/*CLOCK_GOVERNOR_ENABLE*/
+
+#endif/*CLOCK_GOVERNOR_HOST*/
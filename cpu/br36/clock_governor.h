@@ -0,0 +1,59 @@
+#ifndef CLOCK_GOVERNOR_H
+#define CLOCK_GOVERNOR_H
+
+#include "typedef.h"
+
+/*
+ *按实测负载调节系统时钟
+ *静态预算(clock_enum/audio_codec_clock的配置)作为上限，clock_manager的模式空闲时钟作为下限，
+ *音频输出运行时每个窗口统计音频处理占用率和输出缓存余量，在clock_tb档位间升降：
+ *1.占用率超过上限或缓存余量不足时立即升档(余量不足直接回到上限)
+ *2.降一档后预计占用率仍低于下限，且连续多个窗口满足时才降一档
+ *3.其他地方直接clk_set改了时钟时，以新时钟作为上限重新开始
+ *负载统计依赖audio_mips_prof，使能时需同时打开AUDIO_MIPS_PROF_ENABLE
+ *策略部分(clock_gov_step)不依赖系统接口，定义CLOCK_GOVERNOR_HOST时可在PC上用负载记录回放
+ */
+#ifndef CLOCK_GOVERNOR_ENABLE
+#define CLOCK_GOVERNOR_ENABLE		0
+#endif
+
+#define CLOCK_GOV_WINDOW_MS			100		/*统计窗口*/
+#define CLOCK_GOV_UP_PERMILLE		800		/*占用率高于该值升档*/
+#define CLOCK_GOV_TARGET_PERMILLE	700		/*升档时按该占用率选目标档位*/
+#define CLOCK_GOV_DOWN_PERMILLE		600		/*降一档后预计占用率低于该值才允许降档*/
+#define CLOCK_GOV_DOWN_WINDOWS		5		/*连续满足降档条件的窗口数*/
+#define CLOCK_GOV_SLACK_MIN_MS		4		/*输出缓存余量低于该值直接回到上限*/
+#define CLOCK_GOV_SLACK_OK_MS		8		/*输出缓存余量不低于该值才允许降档*/
+
+struct clock_gov {
+    const u8 *tb;			/*档位表(MHz，递增)*/
+    u8 tb_num;
+    u8 down_cnt;			/*连续满足降档条件的窗口数*/
+    u8 settle;				/*刚调整过时钟，下一个窗口的数据混有两个频率，不参与降档*/
+    u32 floor_hz;
+    u32 ceil_hz;
+    u32 cur_hz;
+};
+
+struct clock_gov_sample {
+    u16 busy_permille;		/*窗口内音频处理占用率(当前频率下)*/
+    s16 slack_ms;			/*输出缓存余量，<0表示输出未运行*/
+};
+
+/*设置上下限并从上限开始调节*/
+void clock_gov_reset(struct clock_gov *gov, u32 floor_hz, u32 ceil_hz);
+/*
+ *输入一个窗口的统计，返回下一个窗口使用的时钟(Hz)
+ *只改变gov->cur_hz，由调用者设置时钟
+ */
+u32 clock_gov_step(struct clock_gov *gov, const struct clock_gov_sample *sample);
+
+/*
+ *按静态预算请求系统时钟，替代直接clk_set("sys", hz)
+ *未使能调节时直接设置；使能时hz作为上限，先设置到上限再按负载调节
+ */
+void clock_sys_request(u32 hz);
+/*当前静态预算(未使能调节时为当前时钟)*/
+u32 clock_sys_budget(void);
+
+#endif
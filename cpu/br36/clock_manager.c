@@ -1,6 +1,7 @@
 #include "system/includes.h"
 #include "app_config.h"
 #include "clock_cfg.h"
+#include "clock_governor.h"
 struct clock_type {
     u8 type;
     u32 clock;
@@ -253,6 +254,18 @@ u8 clock_ext_pop(u8 ext_type)
     return 0;
 }
 
+u8 clock_tb_get(const u8 **tb)
+{
+    *tb = clock_tb;
+    return ARRAY_SIZE(clock_tb);
+}
+
+//模式空闲时钟，作为按负载调节时钟的下限
+u32 clock_floor_get(void)
+{
+    return clock_match(clock_idle_selet(idle_type)) * 1000000L;
+}
+
 u16 clock_match(u16 clk)
 {
     u8 i;
@@ -308,11 +321,11 @@ void clock_pause_play(u8 mode)
     u32 idle_clk, cur_clk ;
     if (mode) {
         idle_clk = clock_idle_selet(idle_type);
-        clk_set("sys", idle_clk * 1000000L);
+        clock_sys_request(idle_clk * 1000000L);
     } else {
         clock_ext_dump();
         cur_clk = clock_cur_cal();
-        clk_set("sys", cur_clk * 1000000L);
+        clock_sys_request(cur_clk * 1000000L);
     }
 }
 
@@ -324,7 +337,7 @@ void clock_idle(u32 type)
     cur_clk = clock_cur_cal();
     local_irq_enable();
     clock_ext_dump();
-    clk_set("sys", cur_clk * 1000000L);
+    clock_sys_request(cur_clk * 1000000L);
 }
 
 //////把时钟设置加入到ext中，但是不是立刻设置时钟
@@ -352,7 +365,7 @@ void clock_set_cur(void)
     u32 cur_clk ;
     clock_ext_dump();
     cur_clk = clock_cur_cal();
-    clk_set("sys", cur_clk * 1000000L);
+    clock_sys_request(cur_clk * 1000000L);
 }
 
 //////把时钟设置加入到ext中，立刻设置时钟
@@ -365,7 +378,7 @@ void clock_add_set(u32 type)
     }
     clock_ext_dump();
     cur_clk = clock_cur_cal();
-    clk_set("sys", cur_clk * 1000000L);
+    clock_sys_request(cur_clk * 1000000L);
 }
 
 void clock_remove_set(u32 type)
@@ -379,6 +392,6 @@ void clock_remove_set(u32 type)
 
     clock_ext_dump();
     cur_clk = clock_cur_cal();
-    clk_set("sys", cur_clk * 1000000L);
+    clock_sys_request(cur_clk * 1000000L);
 }
 
@@ -1,5 +1,11 @@
+#ifdef LP_TOUCH_KEY_ALOG_HOST
+#include "generic/typedef.h"
+#undef MIN
+#undef MAX
+#else
 #include "includes.h"
 #include "asm/lp_touch_key_alog.h"
+#endif
 
 
 #define ABS(a)                      ((a)>0?(a):-(a))
@@ -13,7 +19,7 @@
 #define PRESSED_ZSCORE              (12)
 #define PULSE_WIDTH                 (5)
 #define MIN_VALLEY_SAMPLE           (3)
-#define FIFO_BUF_SIZE               (8)
+#define FIFO_BUF_SIZE               (8)     //必须是2的幂
 #define HISTORY_BUF_SIZE            (12)
 #define UNBALANCED_TH               (2) //0.2
 #define RANGE_TH_ALPHA              (5)
@@ -23,6 +29,7 @@
 #define RANGE_STABLE_VALUE_TH       (3)     //0.3
 #define RANGE_STABLE_COUNT_TH       (10)
 #define RANGE_STABLE_ALPHA          (12)    //0.04296875
+#define STD_WINDOW_SHIFT            (7)     //每128个点统计一次方差
 
 typedef struct {
     u32 count;
@@ -169,6 +176,8 @@ static s32 iir_filter(s32 *state, u16 x, s16 alpha)
     return *state;
 }
 
+//整数开方，结果与向下取整有个别差1(如n=3返回2)，阈值是按这个结果调的，不要改成精确开方
+//每128个点才算一次，迭代次数不影响每个点的耗时
 static s32 newton_sqrt(s32 in)
 {
     int x = 1;
@@ -219,8 +228,8 @@ static void TouchAlgo_tracing(TouchAlgo_t *ta, u16 x)
         ta->std_sum += delta * delta;
         ta->std_count += 1;
 
-        if (ta->std_count == 128) {
-            s32 var = newton_sqrt((ta->std_sum + ta->std_count / 2) / ta->std_count);
+        if (ta->std_count == (1 << STD_WINDOW_SHIFT)) {
+            s32 var = newton_sqrt((ta->std_sum + (ta->std_count >> 1)) >> STD_WINDOW_SHIFT);
             ta->std_count = 0;
             ta->std_sum = 0;
 
@@ -249,7 +258,7 @@ static void TouchAlgo_tracing(TouchAlgo_t *ta, u16 x)
     grad_abs_max = delta_abs;
     grad_sign_max = delta >> 31;
     for (int i = 1; i < ta->fifo_size; i += 2) {
-        int idx = (FIFO_BUF_SIZE + ta->fifo_pos - 1 - i) % FIFO_BUF_SIZE;
+        int idx = (FIFO_BUF_SIZE + ta->fifo_pos - 1 - i) & (FIFO_BUF_SIZE - 1);
 
         grad = x - ta->fifo_buf[idx];
         grad_abs = ABS(grad);
@@ -268,7 +277,7 @@ static void TouchAlgo_tracing(TouchAlgo_t *ta, u16 x)
 
     //append to fifo
     ta->fifo_buf[ta->fifo_pos] = x;
-    ta->fifo_pos = (ta->fifo_pos + 1) % FIFO_BUF_SIZE;
+    ta->fifo_pos = (ta->fifo_pos + 1) & (FIFO_BUF_SIZE - 1);
     ta->fifo_size += 1;
     if (ta->fifo_size > FIFO_BUF_SIZE) {
         ta->fifo_size = FIFO_BUF_SIZE;
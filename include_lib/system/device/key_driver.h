@@ -47,6 +47,9 @@ struct key_driver_para {
     u8 notify_value;  		//在延时的待发送按键值
     u8 key_type;
     u8(*get_value)(void);
+//== 扫描定时器状态, 由key_driver维护
+    u16 scan_timer;  		//扫描定时器id
+    u8 scan_busy;  			//手势进行中, 按scan_time全速扫描
 };
 
 //组合按键映射按键值
@@ -62,6 +65,12 @@ struct key_remap_data {
 
 // key_driver API:
 extern int key_driver_init(void);
+//按键边沿/唤醒通知, 空闲时降频的扫描恢复全速
+extern void key_active_set(u8 port);
+
+// 手势状态机(不依赖硬件和系统时间, 每调用一次前进一拍):
+extern int key_gesture_step(struct key_driver_para *scan_para, u8 cur_key_value, u8 *key_event, u8 *key_value);
+extern int key_gesture_idle(const struct key_driver_para *scan_para);
 
 
 
@@ -0,0 +1,250 @@
+#ifndef SPSC_RING_INTERFACE_H
+#define SPSC_RING_INTERFACE_H
+
+#include "typedef.h"
+#include "string.h"
+
+/*
+ * 单生产者单消费者无锁环形缓存
+ * 适用于中断写、任务读(或任务写、中断读)的固定两端数据通路，
+ * 读写两端各自只修改自己的索引，不需要关中断/自旋锁
+ * 1. 缓存大小必须是2的幂，索引自由增长，用mask取模
+ * 2. 生产者先写数据再发布write_idx，消费者先读数据再发布read_idx
+ * 3. 多个生产者或多个消费者的场景请继续使用cbuffer_t
+ */
+
+#if CPU_CORE_NUM > 1
+#define spsc_ring_barrier()		__asm_csync()
+#else
+#define spsc_ring_barrier()		__asm__ volatile("" ::: "memory")
+#endif
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief spsc_ring结构体
+ */
+/* ----------------------------------------------------------------------------*/
+typedef struct _spsc_ring {
+    u8  *buf;
+    u32 mask;
+    volatile u32 write_idx;
+    volatile u32 read_idx;
+} spsc_ring_t;
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:全局
+ * @brief spsc_ring初始化
+ *
+ * @param [in] ring spsc_ring 句柄
+ * @param [in] buf 缓存空间
+ * @param [in] size 缓存总大小，必须是2的幂
+ *
+ * @return 0成功，大小不是2的幂返回-EINVAL
+ */
+/* ----------------------------------------------------------------------------*/
+static inline int spsc_ring_init(spsc_ring_t *ring, void *buf, u32 size)
+{
+    if (!size || (size & (size - 1))) {
+        return -EINVAL;
+    }
+    ring->buf = (u8 *)buf;
+    ring->mask = size - 1;
+    ring->write_idx = 0;
+    ring->read_idx = 0;
+    return 0;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:全局
+ * @brief 获取已缓存数据的字节长度
+ */
+/* ----------------------------------------------------------------------------*/
+static inline u32 spsc_ring_data_len(spsc_ring_t *ring)
+{
+    return ring->write_idx - ring->read_idx;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:全局
+ * @brief 获取剩余可写的字节长度
+ */
+/* ----------------------------------------------------------------------------*/
+static inline u32 spsc_ring_free_len(spsc_ring_t *ring)
+{
+    return ring->mask + 1 - (ring->write_idx - ring->read_idx);
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:生产者
+ * @brief 预留一段连续的可写空间，直接写入后调用spsc_ring_commit()发布
+ *
+ * @param [in] ring spsc_ring 句柄
+ * @param [out] len 回传连续可写的字节长度(到缓存末尾为止)
+ *
+ * @return 当前写地址
+ */
+/* ----------------------------------------------------------------------------*/
+static inline void *spsc_ring_reserve(spsc_ring_t *ring, u32 *len)
+{
+    u32 widx = ring->write_idx;
+    u32 free = ring->mask + 1 - (widx - ring->read_idx);
+    u32 off = widx & ring->mask;
+    u32 tail = ring->mask + 1 - off;
+
+    spsc_ring_barrier();
+    *len = (free < tail) ? free : tail;
+    return ring->buf + off;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:生产者
+ * @brief 发布已写入的len字节数据，len不能超过spsc_ring_reserve()回传的长度
+ */
+/* ----------------------------------------------------------------------------*/
+static inline void spsc_ring_commit(spsc_ring_t *ring, u32 len)
+{
+    spsc_ring_barrier();
+    ring->write_idx += len;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:消费者
+ * @brief 获取一段连续的可读数据，处理完后调用spsc_ring_consume()释放
+ *
+ * @param [in] ring spsc_ring 句柄
+ * @param [out] len 回传连续可读的字节长度(到缓存末尾为止)
+ *
+ * @return 当前读地址
+ */
+/* ----------------------------------------------------------------------------*/
+static inline void *spsc_ring_peek(spsc_ring_t *ring, u32 *len)
+{
+    u32 ridx = ring->read_idx;
+    u32 data_len = ring->write_idx - ridx;
+    u32 off = ridx & ring->mask;
+    u32 tail = ring->mask + 1 - off;
+
+    spsc_ring_barrier();
+    *len = (data_len < tail) ? data_len : tail;
+    return ring->buf + off;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:消费者
+ * @brief 释放已处理的len字节数据，len不能超过spsc_ring_peek()回传的长度
+ */
+/* ----------------------------------------------------------------------------*/
+static inline void spsc_ring_consume(spsc_ring_t *ring, u32 len)
+{
+    spsc_ring_barrier();
+    ring->read_idx += len;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:生产者
+ * @brief 写入len字节数据，空间不足时不写入
+ *
+ * @return 成功写入的字节长度(len或0)
+ */
+/* ----------------------------------------------------------------------------*/
+static inline u32 spsc_ring_write(spsc_ring_t *ring, const void *buf, u32 len)
+{
+    u32 widx = ring->write_idx;
+    u32 off = widx & ring->mask;
+    u32 tail = ring->mask + 1 - off;
+
+    if (ring->mask + 1 - (widx - ring->read_idx) < len) {
+        return 0;
+    }
+    spsc_ring_barrier();
+    if (len <= tail) {
+        memcpy(ring->buf + off, buf, len);
+    } else {
+        memcpy(ring->buf + off, buf, tail);
+        memcpy(ring->buf, (const u8 *)buf + tail, len - tail);
+    }
+    spsc_ring_barrier();
+    ring->write_idx = widx + len;
+    return len;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:生产者
+ * @brief 批量写入多帧等长数据，只写入能完整放下的帧，最后统一发布一次
+ *
+ * @param [in] ring spsc_ring 句柄
+ * @param [in] frames 连续存放的帧数据
+ * @param [in] frame_len 每帧字节长度
+ * @param [in] frame_num 帧数
+ *
+ * @return 成功写入的帧数
+ */
+/* ----------------------------------------------------------------------------*/
+static inline u32 spsc_ring_write_frames(spsc_ring_t *ring, const void *frames, u32 frame_len, u32 frame_num)
+{
+    u32 free = spsc_ring_free_len(ring);
+    u32 num;
+
+    if (!frame_len) {
+        return 0;
+    }
+    num = free / frame_len;
+    if (num > frame_num) {
+        num = frame_num;
+    }
+    if (num) {
+        spsc_ring_write(ring, frames, num * frame_len);
+    }
+    return num;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:消费者
+ * @brief 读取len字节数据，数据不足时不读取
+ *
+ * @return 成功读取的字节长度(len或0)
+ */
+/* ----------------------------------------------------------------------------*/
+static inline u32 spsc_ring_read(spsc_ring_t *ring, void *buf, u32 len)
+{
+    u32 ridx = ring->read_idx;
+    u32 off = ridx & ring->mask;
+    u32 tail = ring->mask + 1 - off;
+
+    if (ring->write_idx - ridx < len) {
+        return 0;
+    }
+    spsc_ring_barrier();
+    if (len <= tail) {
+        memcpy(buf, ring->buf + off, len);
+    } else {
+        memcpy(buf, ring->buf + off, tail);
+        memcpy((u8 *)buf + tail, ring->buf, len - tail);
+    }
+    spsc_ring_barrier();
+    ring->read_idx = ridx + len;
+    return len;
+}
+
+/* --------------------------------------------------------------------------*/
+/**
+ * @brief 适用范围:消费者
+ * @brief 丢弃全部已缓存数据
+ */
+/* ----------------------------------------------------------------------------*/
+static inline void spsc_ring_clear(spsc_ring_t *ring)
+{
+    ring->read_idx = ring->write_idx;
+}
+
+#endif
@@ -0,0 +1,491 @@
+/*
+ * A2DP数据流修复状态机(cpu/br36/audio/a2dp_stream_repair.c)抖动缓存回放
+ * 手机按包时长匀速发包，包经过丢包/抖动/停顿后按序到达接收缓存(满时蓝牙丢包)；
+ * 解码按1ms步进：累计缓存达到目标延时后开始播放，输出缓冲低于DAC_FILL_MS时调用a2dp_stream_repair_get_frame，
+ * 每帧补入一个包时长的pcm，输出缓冲播空的时间记为静音
+ * a2dp_packet_source由测试实现：delay_time为接收缓存 + 输出缓冲的时长，is_underrun与audio_dec.c一致(低于20ms，低延时1ms)，
+ * rtp_header_len与get_rtp_header_len(SBC)一致，目标延时固定(不模拟audio_dec.c里的自适应调整)
+ * 1.每个包正好释放一次，没有释放未分配或已释放的包
+ * 2.返回的帧为包去掉RTP头后的payload，播放顺序的包序号不回退
+ * 3.内置负载：无损链路逐包播放不修复；单包丢失全部检测到；RTP头异常的包丢弃并计数，不影响后面的包；
+ *   停顿超过延时时播空修复，恢复后丢包追赶回到目标延时附近
+ * 4.各负载按延时(delay_time/a2dp_delay_time)和低延时模式扫描，输出播空次数、静音时长、修复帧、丢包、播放延时
+ *   a2dp_repair_replay [trace.txt [延时ms [低延时]]]
+ *   trace每行一个到达的包："序号 到达时间ms [1]"，1表示RTP头损坏，没有出现的序号为丢包，#开头的行忽略
+ */
+#include "host_bench.h"
+#define putchar(c)
+#define printf(...)
+#include "../../cpu/br36/audio/a2dp_stream_repair.c"
+#undef printf
+
+#define SAMPLE_RATE			44100
+#define PKT_SAMPLES			640		/*SBC 5帧 * 128点*/
+#define PKT_US				((u32)((u64)PKT_SAMPLES * 1000000 / SAMPLE_RATE))
+#define PKT_PAYLOAD			120
+#define RX_BUF_PACKETS		40		/*接收缓存，剩余小于768byte(约1包)时为rx_overrun*/
+#define DAC_FILL_MS			40		/*输出缓冲低于该值时解码*/
+#define TRACE_PACKETS_MAX	(1 << 16)
+#define TRACE_SECONDS		60
+
+struct trace_pkt {
+    u32 arrival_us;
+    u16 seqn;
+    u8 bad;
+};
+
+struct trace {
+    struct trace_pkt *pkt;
+    u32 num;
+    u32 sent;				/*手机发出的包数(含丢失)*/
+    u32 lost;				/*丢失的包数，连续丢失算多个*/
+    u32 loss_events;		/*丢包段数*/
+    u32 bad;
+};
+
+enum {
+    PKT_FREE = 0,
+    PKT_HELD,				/*在接收缓存里或由状态机持有*/
+    PKT_RELEASED,
+};
+
+struct sim_pkt {
+    u8 *data;
+    u16 len;
+    u8 state;
+};
+
+struct replay_stat {
+    struct a2dp_stream_stat stream;
+    u32 silence_ms;
+    u32 rx_full_drop;		/*接收缓存满蓝牙丢掉的包*/
+    u32 played;				/*播放的新包数*/
+    u32 frames;				/*get_frame返回的帧数(含重复)*/
+    u64 latency_sum_us;
+    u32 latency_max_us;
+    u32 latency_end_us;		/*最后一秒的平均播放延时*/
+    u32 bad_free;
+    u32 leak;
+    u32 seqn_back;			/*播放的包序号回退*/
+    u32 bad_frame;			/*返回的帧不是payload*/
+};
+
+struct replay {
+    const struct trace *t;
+    struct sim_pkt *pkt;	/*按trace下标*/
+    u32 rx_q[RX_BUF_PACKETS];
+    u32 rx_head;
+    u32 rx_num;
+    u32 next;				/*下一个到达的trace下标*/
+    u32 now_us;
+    u32 dac_us;
+    struct replay_stat *st;
+};
+
+static int replay_rtp_header_len(void *priv, u8 new_frame, u8 *packet, int len)
+{
+    int csrc = packet[0] & 0x0f;
+    int header_len = 12 + 4 * csrc + (new_frame ? 1 : 0);
+
+    while (packet[header_len] != 0x9c) {
+        if (++header_len > len) {
+            return len;
+        }
+    }
+    return header_len;
+}
+
+static int replay_try_get_packet(void *priv, u8 **packet)
+{
+    struct replay *r = priv;
+
+    if (!r->rx_num) {
+        return 0;
+    }
+    u32 i = r->rx_q[r->rx_head];
+    r->rx_head = (r->rx_head + 1) % RX_BUF_PACKETS;
+    r->rx_num--;
+    *packet = r->pkt[i].data;
+    return r->pkt[i].len;
+}
+
+static void replay_free_packet(void *priv, void *packet)
+{
+    struct replay *r = priv;
+    u32 i;
+
+    memcpy(&i, (u8 *)packet + 8, 4);	/*ssrc位置存trace下标*/
+    if (i >= r->t->num || r->pkt[i].data != packet || r->pkt[i].state != PKT_HELD) {
+        r->st->bad_free++;
+        return;
+    }
+    r->pkt[i].state = PKT_RELEASED;
+}
+
+static int replay_delay_time(void *priv)
+{
+    struct replay *r = priv;
+    return (r->rx_num * PKT_US + r->dac_us) / 1000;
+}
+
+static int replay_rx_overrun(void *priv)
+{
+    struct replay *r = priv;
+    return r->rx_num >= RX_BUF_PACKETS - 1;
+}
+
+static u8 replay_low_latency;
+
+static int replay_is_underrun(void *priv)
+{
+    struct replay *r = priv;
+    return r->dac_us < (replay_low_latency ? 1 : 20) * 1000;
+}
+
+static const struct a2dp_packet_source replay_source = {
+    .try_get_packet = replay_try_get_packet,
+    .free_packet    = replay_free_packet,
+    .delay_time     = replay_delay_time,
+    .rx_overrun     = replay_rx_overrun,
+    .is_underrun    = replay_is_underrun,
+    .rtp_header_len = replay_rtp_header_len,
+};
+
+/*RTP头(12byte，ssrc位置存trace下标) + SBC payload头 + 帧(0x9c同步字，后跟序号)；损坏的包没有同步字*/
+static void packet_build(struct sim_pkt *p, const struct trace_pkt *tp, u32 idx)
+{
+    p->len = 13 + PKT_PAYLOAD;
+    p->data = malloc(p->len);
+    memset(p->data, 0, p->len);
+    p->data[0] = 0x80;
+    p->data[1] = 0x60;
+    p->data[2] = tp->seqn >> 8;
+    p->data[3] = tp->seqn;
+    memcpy(p->data + 8, &idx, 4);
+    p->data[12] = 5;
+    if (!tp->bad) {
+        p->data[13] = 0x9c;
+        p->data[14] = tp->seqn >> 8;
+        p->data[15] = tp->seqn;
+    }
+    p->state = PKT_HELD;
+}
+
+static void replay_run(const struct trace *t, u16 delay_ms, u8 low_latency, struct replay_stat *st)
+{
+    struct a2dp_stream_repair s;
+    struct replay r = {0};
+    s16 target_delay = delay_ms;
+    u32 end_us = t->sent * PKT_US + 1000000;
+    u32 last_seqn = 0, started = 0, seqn_valid = 0;
+    u64 end_sum = 0;
+    u32 end_cnt = 0;
+
+    memset(st, 0, sizeof(*st));
+    r.t = t;
+    r.st = st;
+    r.pkt = calloc(t->num, sizeof(struct sim_pkt));
+    replay_low_latency = low_latency;
+    a2dp_stream_repair_init(&s, &replay_source, &r, SAMPLE_RATE, 0);
+    s.target_delay = &target_delay;
+    s.low_latency = &replay_low_latency;
+    s.delay_time = delay_ms;
+
+    for (r.now_us = 0; r.now_us < end_us; r.now_us += 1000) {
+        if (r.next == t->num && !r.rx_num) {
+            break;		/*所有包都已交给解码*/
+        }
+        while (r.next < t->num && t->pkt[r.next].arrival_us <= r.now_us) {
+            if (r.rx_num == RX_BUF_PACKETS) {
+                st->rx_full_drop++;
+            } else {
+                packet_build(&r.pkt[r.next], &t->pkt[r.next], r.next);
+                r.rx_q[(r.rx_head + r.rx_num) % RX_BUF_PACKETS] = r.next;
+                r.rx_num++;
+            }
+            r.next++;
+        }
+        if (!started && replay_delay_time(&r) >= target_delay) {
+            started = 1;
+        }
+        while (started && r.dac_us < DAC_FILL_MS * 1000) {
+            u8 *frame;
+            int len = a2dp_stream_repair_get_frame(&s, &frame);
+            if (len <= 0) {
+                break;
+            }
+            st->frames++;
+            if (len != PKT_PAYLOAD || frame[0] != 0x9c) {
+                st->bad_frame++;
+            }
+            u16 seqn = RB16(frame + 1);
+            if (!seqn_valid || seqn != last_seqn) {
+                if (seqn_valid && !a2dp_seqn_before(last_seqn, seqn)) {
+                    st->seqn_back++;
+                }
+                /*新包：发出时间到开始播放的时间*/
+                u32 lat = r.now_us + r.dac_us - (u32)seqn * PKT_US;
+                st->latency_sum_us += lat;
+                st->latency_max_us = MAX(st->latency_max_us, lat);
+                if (r.now_us + 2000000 > end_us) {
+                    end_sum += lat;
+                    end_cnt++;
+                }
+                st->played++;
+                last_seqn = seqn;
+                seqn_valid = 1;
+            }
+            r.dac_us += PKT_US;
+        }
+        if (started) {
+            if (r.dac_us >= 1000) {
+                r.dac_us -= 1000;
+            } else {
+                r.dac_us = 0;
+                st->silence_ms++;
+            }
+        }
+    }
+
+    a2dp_stream_repair_free(&s, NULL);
+    /*接收缓存里剩下的包由蓝牙在关闭时清掉*/
+    while (r.rx_num) {
+        u8 *p;
+        replay_try_get_packet(&r, &p);
+        replay_free_packet(&r, p);
+    }
+    for (u32 i = 0; i < t->num; i++) {
+        if (r.pkt[i].state == PKT_HELD) {
+            st->leak++;
+        }
+        free(r.pkt[i].data);
+    }
+    free(r.pkt);
+    st->stream = s.stat;
+    st->latency_end_us = end_cnt ? end_sum / end_cnt : 0;
+}
+
+static void trace_add(struct trace *t, u16 seqn, u32 arrival_us, u8 bad)
+{
+    if (t->num && arrival_us < t->pkt[t->num - 1].arrival_us) {
+        arrival_us = t->pkt[t->num - 1].arrival_us;	/*按序到达*/
+    }
+    t->pkt[t->num].seqn = seqn;
+    t->pkt[t->num].arrival_us = arrival_us;
+    t->pkt[t->num].bad = bad;
+    t->bad += bad;
+    t->num++;
+}
+
+enum {
+    TRACE_CLEAN,
+    TRACE_JITTER,
+    TRACE_LOSS,
+    TRACE_BURST_LOSS,
+    TRACE_STALL,
+    TRACE_HEADER_ERR,
+    TRACE_NUM,
+};
+
+static const char *trace_name[TRACE_NUM] = {"clean", "jitter", "loss", "burst", "stall", "hdr_err"};
+
+/*
+ *clean:固定5ms传输 + 0~4ms抖动
+ *jitter:5%的包重传，额外20~60ms
+ *loss:1%的包单个丢失
+ *burst:每5s连续丢8个包
+ *stall:每2s一次150ms的停顿(wifi共存)，停顿期间的包在停顿结束后一起到达
+ *hdr_err:0.5%的包RTP头损坏
+ */
+static void trace_synth(struct trace *t, int type)
+{
+    u32 n = TRACE_SECONDS * 1000000 / PKT_US;
+    u32 burst_left = 0;
+
+    memset(t, 0, sizeof(*t));
+    t->pkt = malloc(n * sizeof(struct trace_pkt));
+    t->sent = n;
+    for (u32 k = 0; k < n; k++) {
+        u32 send = k * PKT_US;
+        u32 arrival = send + 5000 + host_rand() % 4000;
+        u8 bad = 0;
+        switch (type) {
+        case TRACE_JITTER:
+            if (host_rand() % 100 < 5) {
+                arrival += 20000 + host_rand() % 40000;
+            }
+            break;
+        case TRACE_LOSS:
+            if (k > 10 && host_rand() % 100 == 0) {
+                t->lost++;
+                t->loss_events++;
+                continue;
+            }
+            break;
+        case TRACE_BURST_LOSS:
+            if (k % (5000000 / PKT_US) == 100) {
+                burst_left = 8;
+                t->loss_events++;
+            }
+            if (burst_left) {
+                burst_left--;
+                t->lost++;
+                continue;
+            }
+            break;
+        case TRACE_STALL:
+            if (send % 2000000 >= 1000000 && send % 2000000 < 1150000) {
+                arrival = send - send % 2000000 + 1150000 + 5000;
+            }
+            break;
+        case TRACE_HEADER_ERR:
+            bad = k > 10 && host_rand() % 200 == 0;
+            break;
+        }
+        trace_add(t, k, arrival, bad);
+    }
+}
+
+static int trace_load(struct trace *t, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[64];
+    int last = -1;
+
+    if (!fp) {
+        printf("open %s failed\n", path);
+        return -1;
+    }
+    memset(t, 0, sizeof(*t));
+    t->pkt = malloc(TRACE_PACKETS_MAX * sizeof(struct trace_pkt));
+    while (fgets(line, sizeof(line), fp) && t->num < TRACE_PACKETS_MAX) {
+        int seqn, bad = 0;
+        double ms;
+        if (line[0] == '#' || sscanf(line, "%d %lf %d", &seqn, &ms, &bad) < 2) {
+            continue;
+        }
+        if (last >= 0 && seqn > last + 1) {
+            t->lost += seqn - last - 1;
+            t->loss_events++;
+        }
+        last = seqn;
+        trace_add(t, seqn, (u32)(ms * 1000), bad != 0);
+    }
+    fclose(fp);
+    t->sent = last + 1;
+    return t->num ? 0 : -1;
+}
+
+static void report_head(void)
+{
+    printf("  %-8s %5s %3s %8s %8s %7s %6s %8s %5s %6s %7s %17s\n", "trace", "delay", "ll", "underrun", "silence",
+           "repair", "missed", "overrun", "drop", "hdrerr", "rxfull", "latency avg/max/end");
+}
+
+static void report(const char *name, u16 delay, u8 ll, const struct replay_stat *st)
+{
+    printf("  %-8s %5u %3u %8u %6ums %7u %6u %8u %5u %6u %7u %5u/%4u/%4u ms\n", name, delay, ll,
+           st->stream.underrun_cnt, st->silence_ms, st->stream.repair_frames, st->stream.missed_cnt,
+           st->stream.overrun_cnt, st->stream.drop_packets, st->stream.header_err, st->rx_full_drop,
+           (u32)(st->played ? st->latency_sum_us / st->played / 1000 : 0), st->latency_max_us / 1000,
+           st->latency_end_us / 1000);
+}
+
+static void check_common(const char *name, u16 delay, const struct replay_stat *st)
+{
+    HOST_CHECK(st->bad_free == 0, "%s %u ms: %u bad frees", name, delay, st->bad_free);
+    HOST_CHECK(st->leak == 0, "%s %u ms: %u packets not freed", name, delay, st->leak);
+    HOST_CHECK(st->seqn_back == 0, "%s %u ms: played seqn went back %u times", name, delay, st->seqn_back);
+    HOST_CHECK(st->bad_frame == 0, "%s %u ms: %u frames are not the payload", name, delay, st->bad_frame);
+}
+
+static void test_builtin(void)
+{
+    static const u16 delays[] = {75, 100, 150, 200, 280, 340};
+    struct replay_stat st;
+
+    printf("a2dp repair replay (packet %u us, rx buffer %u packets):\n", PKT_US, RX_BUF_PACKETS);
+    report_head();
+    for (int type = 0; type < TRACE_NUM; type++) {
+        struct trace t;
+        trace_synth(&t, type);
+        for (int d = 0; d < ARRAY_SIZE(delays); d++) {
+            for (u8 ll = 0; ll < 2; ll++) {
+                replay_run(&t, delays[d], ll, &st);
+                check_common(trace_name[type], delays[d], &st);
+                if (ll == 0 || delays[d] <= 100) {
+                    report(trace_name[type], delays[d], ll, &st);
+                }
+                if (ll) {
+                    continue;
+                }
+                switch (type) {
+                case TRACE_CLEAN:
+                    HOST_CHECK(st.stream.underrun_cnt == 0 && st.stream.repair_frames == 0 &&
+                               st.stream.drop_packets == 0 && st.stream.missed_cnt == 0,
+                               "clean %u ms: underrun %u repair %u drop %u missed %u", delays[d],
+                               st.stream.underrun_cnt, st.stream.repair_frames, st.stream.drop_packets, st.stream.missed_cnt);
+                    HOST_CHECK(st.played == t.num && st.frames == t.num, "clean %u ms: played %u frames %u of %u",
+                               delays[d], st.played, st.frames, t.num);
+                    break;
+                case TRACE_LOSS:
+                case TRACE_BURST_LOSS:
+                    /*延时足够时每段丢包都检测到，不播空*/
+                    if (delays[d] >= 150) {
+                        HOST_CHECK(st.stream.missed_cnt == t.loss_events, "%s %u ms: missed %u of %u loss events",
+                                   trace_name[type], delays[d], st.stream.missed_cnt, t.loss_events);
+                        HOST_CHECK(st.stream.underrun_cnt == 0, "%s %u ms: %u underruns", trace_name[type], delays[d],
+                                   st.stream.underrun_cnt);
+                    }
+                    break;
+                case TRACE_STALL:
+                    if (delays[d] >= 200) {
+                        HOST_CHECK(st.stream.underrun_cnt == 0 && st.silence_ms == 0, "stall %u ms: underrun %u silence %u ms",
+                                   delays[d], st.stream.underrun_cnt, st.silence_ms);
+                    } else {
+                        /*停顿超过延时：播空修复，恢复后丢包追赶，结束时播放延时回到目标附近*/
+                        HOST_CHECK(st.stream.underrun_cnt > 0 && st.stream.repair_frames > 0,
+                                   "stall %u ms: no underrun repair", delays[d]);
+                        HOST_CHECK(st.latency_end_us < (delays[d] + DAC_FILL_MS) * 1000 + 2 * PKT_US,
+                                   "stall %u ms: end latency %u ms", delays[d], st.latency_end_us / 1000);
+                    }
+                    break;
+                case TRACE_HEADER_ERR:
+                    HOST_CHECK(st.stream.header_err == t.bad, "hdr_err %u ms: header errors %u of %u",
+                               delays[d], st.stream.header_err, t.bad);
+                    HOST_CHECK(st.played + t.bad == t.num, "hdr_err %u ms: played %u + bad %u of %u",
+                               delays[d], st.played, t.bad, t.num);
+                    break;
+                }
+            }
+        }
+        free(t.pkt);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        struct trace t;
+        struct replay_stat st;
+        if (trace_load(&t, argv[1])) {
+            return 1;
+        }
+        u8 ll = argc > 3 ? atoi(argv[3]) : 0;
+        printf("%s: %u packets, %u lost in %u events, %u bad\n", argv[1], t.num, t.lost, t.loss_events, t.bad);
+        report_head();
+        if (argc > 2) {
+            replay_run(&t, atoi(argv[2]), ll, &st);
+            report("trace", atoi(argv[2]), ll, &st);
+        } else {
+            for (u16 delay = 50; delay <= 400; delay += 25) {
+                replay_run(&t, delay, ll, &st);
+                report("trace", delay, ll, &st);
+            }
+        }
+        return 0;
+    }
+
+    test_builtin();
+    return host_test_result("a2dp_repair_replay");
+}
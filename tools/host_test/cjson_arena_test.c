@@ -0,0 +1,232 @@
+/*
+ * cJSON原地解析/无堆打印(apps/common/cJSON/cJSON.c)对比和速度测试
+ * 1.生成的文档(转义、utf16代理对、空容器、嵌套、数字)：cJSON_ParseInSitu和cJSON_Parse解析结果
+ *   打印出来一致，cJSON_PrintPreallocated/cJSON_PrintStream与cJSON_PrintUnformatted/cJSON_Print一致
+ * 2.cJSON_ArenaSize给出的大小够用；比实际用量少一个节点时解析失败，arena回到解析前
+ * 3.涂鸦产测COMM_CFG帧：按帧算的arena能解析带额外字段的帧(原来固定8个节点)
+ * 4.统计堆解析/打印和arena解析/无堆打印的MB/s和每次的malloc次数
+ */
+#include "host_bench.h"
+#include "generic/typedef.h"
+#include "../../apps/common/cJSON/cJSON.c"
+
+static int malloc_cnt;
+
+static void *count_malloc(size_t sz)
+{
+    malloc_cnt++;
+    return malloc(sz);
+}
+
+#define DOC_BYTES_MAX		(256 * 1024)
+
+static char doc[DOC_BYTES_MAX];
+static u32 doc_len;
+
+static void doc_put(const char *s)
+{
+    u32 len = strlen(s);
+    if (doc_len + len < DOC_BYTES_MAX) {
+        memcpy(doc + doc_len, s, len + 1);
+        doc_len += len;
+    }
+}
+
+/*records条记录组成的数组，和产测/配置里常见的小对象类似*/
+static void doc_gen(int records)
+{
+    char tmp[160];
+
+    doc_len = 0;
+    doc[0] = 0;
+    doc_put("{\"ver\": 3, \"empty_obj\": {}, \"empty_arr\": [], \"list\": [\n");
+    for (int i = 0; i < records; i++) {
+        u32 r = host_rand();
+        sprintf(tmp, "%s{\"id\": %d, \"name\": \"dev_%08x\", \"on\": %s, \"level\": %d.%02d, \"mode\": null,\n",
+                i ? ",\n" : "", i, r, (r & 1) ? "true" : "false", (int)(r % 1000) - 500, (int)(r % 100));
+        doc_put(tmp);
+        doc_put("\t\"note\": \"tab\\there \\\"quoted\\\" back\\\\slash \\u00e9\\u4e2d \\ud83c\\udfb5 \\/\",\n");
+        sprintf(tmp, "\t\"rgb\": [%u, %u, %u], \"big\": %u, \"neg\": -%u.5e-3, \"sub\": {\"a\": [[], {}, [1, [2]]]}}",
+                r & 0xff, (r >> 8) & 0xff, r >> 24, r, r % 977);
+        doc_put(tmp);
+    }
+    doc_put("]}");
+}
+
+static char print_ref[DOC_BYTES_MAX * 2];
+static char print_buf[DOC_BYTES_MAX * 2];
+static u32 stream_len;
+
+static int stream_write(void *priv, const char *data, int len)
+{
+    if (stream_len + len >= sizeof(print_buf)) {
+        return 0;
+    }
+    memcpy(print_buf + stream_len, data, len);
+    stream_len += len;
+    return len;
+}
+
+static void test_doc(int records)
+{
+    static char text[DOC_BYTES_MAX];
+    cJSON_Arena arena;
+
+    doc_gen(records);
+    memcpy(text, doc, doc_len + 1);
+    size_t size = cJSON_ArenaSize(text);
+    void *buf = malloc(size);
+    cJSON_InitArena(&arena, buf, size);
+
+    cJSON *heap = cJSON_Parse(doc);
+    cJSON *root = cJSON_ParseInSitu(text, &arena);
+    HOST_CHECK(heap && root, "records=%d parse failed heap %p arena %p", records, heap, root);
+    if (!heap || !root) {
+        return;
+    }
+    HOST_CHECK(arena.used <= size, "arena used %zu > %zu", arena.used, size);
+
+    for (int fmt = 0; fmt < 2; fmt++) {
+        char *out = fmt ? cJSON_Print(heap) : cJSON_PrintUnformatted(heap);
+        strcpy(print_ref, out);
+        free(out);
+        HOST_CHECK(cJSON_PrintPreallocated(root, print_buf, sizeof(print_buf), fmt) && !strcmp(print_buf, print_ref),
+                   "records=%d fmt=%d preallocated print differs", records, fmt);
+        stream_len = 0;
+        int len = cJSON_PrintStream(root, fmt, stream_write, NULL);
+        print_buf[stream_len] = 0;
+        HOST_CHECK(len == strlen(print_ref) && !strcmp(print_buf, print_ref), "records=%d fmt=%d stream print differs",
+                   records, fmt);
+        HOST_CHECK(!cJSON_PrintPreallocated(root, print_buf, strlen(print_ref), fmt), "fmt=%d print one byte short fits", fmt);
+    }
+
+    /*少一个节点放不下：解析失败，arena回到解析前*/
+    size_t used = arena.used;
+    memcpy(text, doc, doc_len + 1);
+    cJSON_InitArena(&arena, buf, used - 1);
+    HOST_CHECK(!cJSON_ParseInSitu(text, &arena) && arena.used == 0, "records=%d short arena parsed, used %zu",
+               records, arena.used);
+
+    cJSON_Delete(heap);
+    free(buf);
+}
+
+/*tuya_ble_auc_write_comm_cfg的三种帧，后两帧多带了字段*/
+static void test_comm_cfg(void)
+{
+    static const char *frames[] = {
+        "{\"type\":1,\"key\":\"deviceCertificate\",\"size\":1024}",
+        "{\"type\":2,\"key\":\"privateKey\",\"value\":\"MIIBVQIBADANBgkqhkiG9w0BAQEFAASCAT8wggE7\",\"offset\":0,"
+        "\"seq\":7,\"total\":12,\"tool\":{\"ver\":\"2.1\",\"station\":[3,4]}}",
+        "{\"type\":3,\"key\":\"privateKey\",\"crc32\":305419896,\"extra\":[1,2,3,4,5,6,7,8,9,10]}",
+    };
+    char text[256];
+    cJSON_Arena arena;
+
+    for (int i = 0; i < ARRAY_SIZE(frames); i++) {
+        strcpy(text, frames[i]);
+        size_t size = cJSON_ArenaSize(text);
+        void *buf = malloc(size);
+        cJSON_InitArena(&arena, buf, size);
+        cJSON *root = cJSON_ParseInSitu(text, &arena);
+        cJSON *key = root ? cJSON_GetObjectItem(root, "key") : NULL;
+        HOST_CHECK(key && key->valuestring[0], "comm cfg frame %d parse failed (arena %zu bytes)", i, size);
+        HOST_CHECK(cJSON_GetObjectItem(root, "type")->valueint == i + 1, "comm cfg frame %d type", i);
+        free(buf);
+    }
+}
+
+/*MB/s按墙上时间计算*/
+static double bench_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void bench(int records, int loops)
+{
+    static char text[DOC_BYTES_MAX];
+    cJSON_Hooks hooks = {count_malloc, free};
+    cJSON_Arena arena;
+    double t0;
+    int heap_alloc, arena_alloc;
+
+    doc_gen(records);
+    size_t size = cJSON_ArenaSize(doc);
+    void *buf = malloc(size);
+    cJSON_InitHooks(&hooks);
+
+    malloc_cnt = 0;
+    t0 = bench_sec();
+    for (int i = 0; i < loops; i++) {
+        cJSON_Delete(cJSON_Parse(doc));
+    }
+    double heap_mbps = (double)doc_len * loops / (bench_sec() - t0) / 1e6;
+    heap_alloc = malloc_cnt / loops;
+
+    /*原地解析会改写输入，每次先拷贝一份，拷贝时间算在内*/
+    malloc_cnt = 0;
+    t0 = bench_sec();
+    for (int i = 0; i < loops; i++) {
+        memcpy(text, doc, doc_len + 1);
+        cJSON_InitArena(&arena, buf, size);
+        cJSON_ParseInSitu(text, &arena);
+    }
+    double arena_mbps = (double)doc_len * loops / (bench_sec() - t0) / 1e6;
+    arena_alloc = malloc_cnt / loops;
+    printf("  %5d records %7u bytes  parse: heap %6.1f MB/s %6d mallocs  in situ %6.1f MB/s %d mallocs, arena %zu of %zu bytes\n",
+           records, doc_len, heap_mbps, heap_alloc, arena_mbps, arena_alloc, arena.used, size);
+
+    memcpy(text, doc, doc_len + 1);
+    cJSON_InitArena(&arena, buf, size);
+    cJSON *root = cJSON_ParseInSitu(text, &arena);
+    for (int fmt = 0; fmt < 2; fmt++) {
+        u32 out_len = 0;
+        malloc_cnt = 0;
+        t0 = bench_sec();
+        for (int i = 0; i < loops; i++) {
+            char *out = fmt ? cJSON_Print(root) : cJSON_PrintUnformatted(root);
+            out_len = strlen(out);
+            free(out);
+        }
+        heap_mbps = (double)out_len * loops / (bench_sec() - t0) / 1e6;
+        heap_alloc = malloc_cnt / loops;
+
+        malloc_cnt = 0;
+        t0 = bench_sec();
+        for (int i = 0; i < loops; i++) {
+            cJSON_PrintPreallocated(root, print_buf, sizeof(print_buf), fmt);
+        }
+        arena_mbps = (double)out_len * loops / (bench_sec() - t0) / 1e6;
+        arena_alloc = malloc_cnt;
+
+        malloc_cnt = 0;
+        t0 = bench_sec();
+        for (int i = 0; i < loops; i++) {
+            stream_len = 0;
+            cJSON_PrintStream(root, fmt, stream_write, NULL);
+        }
+        double stream_mbps = (double)out_len * loops / (bench_sec() - t0) / 1e6;
+        printf("  %5d records  print %-11s: heap %6.1f MB/s %6d mallocs  preallocated %6.1f MB/s  stream %6.1f MB/s, %d mallocs\n",
+               records, fmt ? "formatted" : "unformatted", heap_mbps, heap_alloc, arena_mbps, stream_mbps,
+               arena_alloc + malloc_cnt);
+    }
+
+    cJSON_InitHooks(NULL);
+    free(buf);
+}
+
+int main(void)
+{
+    test_doc(0);
+    test_doc(1);
+    test_doc(37);
+    test_doc(300);
+    test_comm_cfg();
+
+    printf("cjson bench:\n");
+    bench(10, 2000);
+    bench(1000, 20);
+    return host_test_result("cjson_arena_test");
+}
@@ -0,0 +1,274 @@
+/*
+ * 系统时钟调节(cpu/br36/clock_governor.c)负载记录回放，以及audio_mips_prof忙时间累计检查
+ * 1.忙时间累计：src嵌套dac写入、两个区间交叠、MARK重复标记时只计一次，读数包含进行中的区间，
+ *   辅听算法(dha)一级计入忙时间
+ * 2.按窗口回放音频负载(MIPS)，模型：当前时钟下占用率 = 负载 / 时钟，
+ *   负载超过时钟时输出缓存按差额消耗，低于时钟时补满，缓存耗尽记为断流
+ *   逐窗口调用clock_gov_step，统计平均时钟、各档位时间、切换次数、断流窗口
+ * 3.内置负载(a2dp稳定负载、通话开启aec的阶跃、周期性尖峰、缓慢爬升)不断流，
+ *   稳定低负载时平均时钟低于静态预算，负载阶跃后一个窗口内升到足够的档位
+ *   clock_gov_replay [trace.txt [预算MHz [下限MHz]]]
+ *   trace每行一个窗口(CLOCK_GOV_WINDOW_MS)的音频负载MIPS(设备上busy_permille * 时钟MHz / 1000)，#开头的行忽略
+ */
+#include "host_bench.h"
+#include <string.h>
+#include "../../apps/common/audio/audio_mips_prof.c"
+#include "../../cpu/br36/clock_governor.c"
+
+#define BUDGET_MHZ			96		/*a2dp静态预算*/
+#define FLOOR_MHZ			24
+#define OUTPUT_BUF_MS		30		/*dac缓存可容纳的时长*/
+#define TRACE_WINDOWS_MAX	100000
+
+static const u8 sys_clock_tb[] = {24, 32, 48, 60, 80, 96, 120, 160, 192};	/*clock_manager.c clock_tb*/
+
+struct gov_stat {
+    u64 mhz_sum;
+    u32 windows;
+    u32 switches;
+    u32 underrun;
+    u32 level_windows[ARRAY_SIZE(sys_clock_tb)];
+    u32 late;			/*负载阶跃后下一个窗口时钟仍不够*/
+};
+
+static void spin_ns(u32 ns)
+{
+    u32 t0 = audio_mips_prof_now();
+    while ((u32)(audio_mips_prof_now() - t0) < ns);
+}
+
+static u32 stage_total_us(u8 stage)
+{
+    struct audio_mips_prof_stat stat;
+    audio_mips_prof_get_stat(stage, &stat);
+    return stat.total_us;
+}
+
+static void test_busy(void)
+{
+    u32 busy, dt;
+
+    /*src包含其输出回调里的dac写入：忙时间等于src区间，不是两级之和*/
+    audio_mips_prof_reset(AUDIO_PROF_STAGE_NUM);
+    busy = audio_mips_prof_busy();
+    {
+        AUDIO_PROF_BEGIN(AUDIO_PROF_SRC);
+        spin_ns(200000);
+        {
+            AUDIO_PROF_BEGIN(AUDIO_PROF_DAC_WRITE);
+            spin_ns(300000);
+            AUDIO_PROF_END(AUDIO_PROF_DAC_WRITE);
+        }
+        spin_ns(200000);
+        AUDIO_PROF_END(AUDIO_PROF_SRC);
+    }
+    dt = (audio_mips_prof_busy() - busy) / 1000;
+    HOST_CHECK(dt + 1 >= stage_total_us(AUDIO_PROF_SRC) && dt <= stage_total_us(AUDIO_PROF_SRC) + 1,
+               "nested busy %u us, src %u us", dt, stage_total_us(AUDIO_PROF_SRC));
+    HOST_CHECK(dt + 100 < stage_total_us(AUDIO_PROF_SRC) + stage_total_us(AUDIO_PROF_DAC_WRITE),
+               "nested busy %u us counts dac_write twice", dt);
+
+    /*两个任务的区间交叠：从先开始的起点到后结束的终点*/
+    audio_mips_prof_reset(AUDIO_PROF_STAGE_NUM);
+    busy = audio_mips_prof_busy();
+    u32 t0 = audio_mips_prof_begin();
+    spin_ns(200000);
+    AUDIO_PROF_MARK(AUDIO_PROF_DECODE);
+    spin_ns(200000);
+    audio_mips_prof_end(AUDIO_PROF_EQ_DRC, t0);
+    spin_ns(200000);
+    /*进行中的区间也计入读数*/
+    dt = (audio_mips_prof_busy() - busy) / 1000;
+    HOST_CHECK(dt >= 600, "busy %u us while decode is marked", dt);
+    AUDIO_PROF_MARK_END(AUDIO_PROF_DECODE);
+    dt = (audio_mips_prof_busy() - busy) / 1000;
+    u32 eq = stage_total_us(AUDIO_PROF_EQ_DRC), dec = stage_total_us(AUDIO_PROF_DECODE);
+    HOST_CHECK(dt + 100 < eq + dec && dt + 1 >= MAX(eq, dec), "overlap busy %u us, eq %u decode %u", dt, eq, dec);
+
+    /*辅听算法单独一级，同样计入忙时间*/
+    audio_mips_prof_reset(AUDIO_PROF_STAGE_NUM);
+    busy = audio_mips_prof_busy();
+    {
+        AUDIO_PROF_BEGIN(AUDIO_PROF_DHA);
+        spin_ns(300000);
+        AUDIO_PROF_END(AUDIO_PROF_DHA);
+    }
+    dt = (audio_mips_prof_busy() - busy) / 1000;
+    HOST_CHECK(dt >= 300 && dt <= stage_total_us(AUDIO_PROF_DHA) + 1, "dha busy %u us, stage %u us",
+               dt, stage_total_us(AUDIO_PROF_DHA));
+
+    /*重复标记(上次没有结束)后结束一次即回到空闲，不会一直计为忙*/
+    AUDIO_PROF_MARK(AUDIO_PROF_MIXER);
+    AUDIO_PROF_MARK(AUDIO_PROF_MIXER);
+    AUDIO_PROF_MARK_END(AUDIO_PROF_MIXER);
+    HOST_CHECK(prof_busy_depth == 0, "busy depth %d after re-mark", prof_busy_depth);
+    busy = audio_mips_prof_busy();
+    spin_ns(200000);
+    HOST_CHECK(audio_mips_prof_busy() == busy, "idle time counted as busy");
+}
+
+static int level_index(u32 hz)
+{
+    for (int i = 0; i < ARRAY_SIZE(sys_clock_tb); i++) {
+        if (sys_clock_tb[i] * GOV_MHZ == hz) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+/*按窗口回放负载(MIPS)*/
+static void replay(const u16 *load, u32 windows, u32 budget_mhz, u32 floor_mhz, struct gov_stat *st, u8 verbose)
+{
+    struct clock_gov gov = {
+        .tb = sys_clock_tb,
+        .tb_num = ARRAY_SIZE(sys_clock_tb),
+    };
+    s32 slack = OUTPUT_BUF_MS;
+
+    memset(st, 0, sizeof(*st));
+    clock_gov_reset(&gov, floor_mhz * GOV_MHZ, budget_mhz * GOV_MHZ);
+    for (u32 w = 0; w < windows; w++) {
+        struct clock_gov_sample sample;
+        u32 mhz = gov.cur_hz / GOV_MHZ;
+        u32 busy = load[w] * 1000 / mhz;
+
+        if (load[w] > mhz) {
+            /*处理跟不上，按差额消耗输出缓存*/
+            slack -= CLOCK_GOV_WINDOW_MS * (load[w] - mhz) / load[w];
+            if (slack < 0) {
+                st->underrun++;
+                slack = 0;
+            }
+        } else {
+            slack = OUTPUT_BUF_MS;
+        }
+        sample.busy_permille = busy > 1000 ? 1000 : busy;
+        sample.slack_ms = slack;
+        u32 next = clock_gov_step(&gov, &sample) / GOV_MHZ;
+        if (w && (load[w] > load[w - 1] + 10) && (next < budget_mhz) && (load[w] > next)) {
+            /*负载阶跃后下一个窗口的时钟应当够用(预算不够时除外)*/
+            st->late++;
+        }
+        st->mhz_sum += mhz;
+        st->windows++;
+        st->level_windows[level_index(mhz * GOV_MHZ)]++;
+        if (next != mhz) {
+            st->switches++;
+            if (verbose) {
+                printf("  %8u ms  load %3u MIPS busy %4u slack %2d  %u -> %u MHz\n", w * CLOCK_GOV_WINDOW_MS,
+                       load[w], busy, slack, mhz, (u32)(gov.cur_hz / GOV_MHZ));
+            }
+        }
+    }
+}
+
+static void report(const char *name, u32 budget_mhz, const struct gov_stat *st)
+{
+    printf("clock gov %-8s avg %5.1f MHz (budget %u), switches %u, underrun %u, windows per level:",
+           name, (double)st->mhz_sum / st->windows, budget_mhz, st->switches, st->underrun);
+    for (int i = 0; i < ARRAY_SIZE(sys_clock_tb); i++) {
+        if (st->level_windows[i]) {
+            printf(" %u:%u", sys_clock_tb[i], st->level_windows[i]);
+        }
+    }
+    printf("\n");
+}
+
+#define NOISE(a)	((s32)(host_rand() % (2 * (a) + 1)) - (a))
+
+/*
+ *内置负载：
+ *a2dp:30 MIPS左右稳定负载
+ *call:a2dp后开启通话aec，负载阶跃到65，再回落
+ *spike:稳定负载上每2秒一个窗口的2倍尖峰(切歌/提示音)
+ *ramp:从20缓慢爬升到85再回落
+ */
+static u32 trace_synth(u16 *load, int type)
+{
+    u32 n = 0;
+
+    for (u32 w = 0; w < 1200; w++) {
+        s32 v;
+        switch (type) {
+        case 0:
+            v = 30 + NOISE(3);
+            break;
+        case 1:
+            v = (w >= 300 && w < 900) ? 65 + NOISE(4) : 30 + NOISE(3);
+            break;
+        case 2:
+            v = (w % 20) == 10 ? 55 + NOISE(3) : 28 + NOISE(3);
+            break;
+        default:
+            v = w < 600 ? 20 + w * 65 / 600 : 85 - (w - 600) * 65 / 600;
+            v += NOISE(2);
+            break;
+        }
+        load[n++] = v;
+    }
+    return n;
+}
+
+static void test_replay(void)
+{
+    static const char *name[] = {"a2dp", "call", "spike", "ramp"};
+    static u16 load[TRACE_WINDOWS_MAX];
+    struct gov_stat st;
+
+    for (int t = 0; t < ARRAY_SIZE(name); t++) {
+        u32 n = trace_synth(load, t);
+        replay(load, n, BUDGET_MHZ, FLOOR_MHZ, &st, 0);
+        report(name[t], BUDGET_MHZ, &st);
+        HOST_CHECK(st.underrun == 0, "%s: %u underrun windows", name[t], st.underrun);
+        HOST_CHECK(st.late == 0, "%s: %u load steps not covered in one window", name[t], st.late);
+        HOST_CHECK(st.mhz_sum < (u64)BUDGET_MHZ * st.windows, "%s: never below budget", name[t]);
+        if (t == 0) {
+            /*30 MIPS稳定后停在60MHz(再降一档预计占用率超过降档线)*/
+            u32 low = st.level_windows[0] + st.level_windows[1] + st.level_windows[2] + st.level_windows[3];
+            HOST_CHECK(low * 100 >= st.windows * 95, "a2dp: only %u of %u windows at 60 MHz or below", low, st.windows);
+        }
+    }
+}
+
+static u32 trace_load(u16 *load, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[64];
+    u32 n = 0;
+
+    if (!fp) {
+        printf("open %s failed\n", path);
+        return 0;
+    }
+    while (fgets(line, sizeof(line), fp) && n < TRACE_WINDOWS_MAX) {
+        int v;
+        if (line[0] == '#' || sscanf(line, "%d", &v) != 1) {
+            continue;
+        }
+        load[n++] = v < 0 ? 0 : v;
+    }
+    fclose(fp);
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        static u16 load[TRACE_WINDOWS_MAX];
+        struct gov_stat st;
+        u32 budget = argc > 2 ? atoi(argv[2]) : BUDGET_MHZ;
+        u32 floor = argc > 3 ? atoi(argv[3]) : FLOOR_MHZ;
+        u32 n = trace_load(load, argv[1]);
+        if (!n) {
+            return 1;
+        }
+        replay(load, n, budget, floor, &st, 1);
+        report("trace", budget, &st);
+        return 0;
+    }
+
+    test_busy();
+    test_replay();
+    return host_test_result("clock_gov_replay");
+}
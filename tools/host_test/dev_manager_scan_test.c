@@ -0,0 +1,346 @@
+/*
+ * 设备管理扫盘缓存(apps/common/dev_manager/dev_manager.c dev_manager_scan_disk)回放测试
+ * 文件系统用模型代替：fscan按卷的文件数计"遍历的文件数"，句柄分配/释放计数，检查重复释放和泄漏
+ * 1.缓存命中：释放后同参数再扫盘返回同一句柄，不调用fscan，循环模式按新参数设置
+ * 2.句柄被占用时再扫同一设备、扫盘参数不同、指定子目录：都重新扫盘，不会返回同一个句柄
+ * 3.失效：music_player_delete_playing_file(播放器还占着句柄时失效，停止时才真正释放)、
+ *   file_manager删除/新建文件、设备卸载/删除，之后扫盘重新遍历并看到新的文件数
+ * 4.按音乐模式常见的操作序列(断点播放、切设备、切录音文件夹、删文件、新建文件、拔盘)回放，
+ *   统计fscan次数和遍历的文件数
+ * 同一程序以-DDEV_MANAGER_SCAN_CACHE_ENABLE=0编译作为对照
+ * 这里只统计app层是否重新扫盘；首次扫盘、fselect选文件仍在fs库内部，不在统计范围内
+ */
+#include "host_bench.h"
+#include "generic/typedef.h"
+#include "generic/list.h"
+
+/*system/includes.h、system/fs/fs.h里dev_manager用到的部分*/
+#define SYS_INCLUDES_H
+#define __FS_H__
+
+typedef int OS_MUTEX;
+typedef int OS_SEM;
+#define OS_NO_ERR		0
+#define OS_TASKQ		1
+#define Q_EVENT			1
+#define Q_MSG			2
+#define ASSERT(...)
+
+struct imount {
+    int dummy;
+};
+
+#define VFSCAN_MAGIC	0x5343414e
+
+struct vfscan {
+    u32 magic;
+    u8 cycle_mode;
+    u16 file_number;
+    const char *path;
+};
+
+#define TCFG_RECORD_FOLDER_DEV_ENABLE	1
+
+/*卷模型：根目录和文件数，sd0_rec是sd0上的录音文件夹设备*/
+struct sim_volume {
+    const char *root_path;
+    int files;
+    int online;
+};
+
+static struct sim_volume sim_vol[] = {
+    {"storage/sd0/C/", 3000, 1},
+    {"storage/sd0/C/JL_REC/", 20, 1},
+    {"storage/udisk0/C/", 800, 1},
+};
+
+static struct imount sim_mnt;
+static int fscan_calls;
+static int files_walked;
+static int fsn_live;
+
+/*按最长的根目录前缀找卷，子目录扫盘算在所在的卷上*/
+static struct sim_volume *sim_find(const char *path)
+{
+    struct sim_volume *vol = NULL;
+    for (int i = 0; i < ARRAY_SIZE(sim_vol); i++) {
+        u32 len = strlen(sim_vol[i].root_path);
+        if (!strncmp(path, sim_vol[i].root_path, len) && (!vol || len > strlen(vol->root_path))) {
+            vol = &sim_vol[i];
+        }
+    }
+    return vol;
+}
+
+static struct imount *mount(const char *name, const char *storage_path, const char *fs_type, int cache_num, const char *dev_arg)
+{
+    return &sim_mnt;
+}
+
+static int unmount(const char *path)
+{
+    return 0;
+}
+
+static struct vfscan *fscan_interrupt(const char *path, const char *arg, int max_deepth, int (*callback)(void))
+{
+    struct sim_volume *vol = sim_find(path);
+
+    fscan_calls++;
+    if (!vol || !vol->online) {
+        return NULL;
+    }
+    files_walked += vol->files;
+    struct vfscan *fsn = calloc(1, sizeof(*fsn));
+    fsn->magic = VFSCAN_MAGIC;
+    fsn->file_number = vol->files;
+    fsn->path = path;
+    fsn_live++;
+    return fsn;
+}
+
+static void fscan_release(struct vfscan *fsn)
+{
+    HOST_CHECK(fsn->magic == VFSCAN_MAGIC, "fscan_release on a freed handle");
+    fsn->magic = 0;
+    fsn_live--;
+    free(fsn);
+}
+
+static void os_mutex_create(OS_MUTEX *m) {}
+static void os_mutex_pend(OS_MUTEX *m, int timeout) {}
+static void os_mutex_post(OS_MUTEX *m) {}
+static void os_sem_create(OS_SEM *s, int cnt) {}
+static void os_sem_pend(OS_SEM *s, int timeout) {}
+static void os_sem_post(OS_SEM *s) {}
+static int os_taskq_pend(const char *fmt, int *msg, int len)
+{
+    return 0;
+}
+static int task_create(void (*task)(void *), void *p, const char *name)
+{
+    return OS_NO_ERR;
+}
+static void devices_init(void) {}
+void hidden_file(u8 flag) {}
+
+#define printf(...)
+#include "../../apps/common/dev_manager/dev_manager.c"
+#undef printf
+
+const struct __dev_reg dev_reg[] = {
+    {"sd0", "sd0", "storage/sd0", "storage/sd0/C/", "fat"},
+    {"sd0_rec", "sd0", "storage/sd0", "storage/sd0/C/JL_REC/", "fat"},
+    {"udisk0", "udisk0", "storage/udisk0", "storage/udisk0/C/", "fat"},
+    {NULL},
+};
+
+static const char scan_parm[] = "-tMP1MP2MP3WAVWMAFLAAPEM4AAACAMR -sn -r";
+static const char other_parm[] = "-tMP3 -sn -r";
+
+/*music_player中只保留设备和扫盘句柄相关的部分*/
+struct player {
+    struct __dev *dev;
+    struct vfscan *fsn;
+};
+
+static void player_stop(struct player *pl, u8 fsn_release)
+{
+    if (fsn_release && pl->fsn) {
+        dev_manager_scan_disk_release(pl->fsn);
+        pl->fsn = NULL;
+    }
+}
+
+/*music_player_play_by_number/by_breakpoint切设备时的流程*/
+static int player_play_dev(struct player *pl, char *logo)
+{
+    char *cur_logo = dev_manager_get_logo(pl->dev);
+    if (cur_logo && !strcmp(cur_logo, logo) && pl->fsn) {
+        return pl->fsn->file_number;
+    }
+    player_stop(pl, 1);
+    pl->dev = dev_manager_find_spec(logo, 1);
+    if (pl->dev == NULL) {
+        return -1;
+    }
+    pl->fsn = dev_manager_scan_disk(pl->dev, NULL, scan_parm, 0, NULL);
+    return pl->fsn ? pl->fsn->file_number : -1;
+}
+
+/*music_player_delete_playing_file：删除成功后让缓存失效，清掉dev重新扫盘*/
+static int player_delete_playing_file(struct player *pl)
+{
+    char *cur_dev = dev_manager_get_logo(pl->dev);
+    sim_find(dev_manager_get_root_path(pl->dev))->files--;
+    dev_manager_scan_disk_cache_free(pl->dev);
+    pl->dev = NULL;
+    return player_play_dev(pl, cur_dev);
+}
+
+/*file_manager_division_file新建文件前让该设备的缓存失效*/
+static void file_manager_create(char *logo)
+{
+    struct __dev *dev = dev_manager_find_spec(logo, 0);
+    dev_manager_scan_disk_cache_free(dev);
+    sim_find(dev_manager_get_root_path(dev))->files++;
+}
+
+/*file_manager_delete_deal删除前让所有设备的缓存失效，自己用fscan扫指定目录*/
+static void file_manager_delete(char *logo, int n)
+{
+    struct __dev *dev = dev_manager_find_spec(logo, 0);
+    dev_manager_scan_disk_cache_free(NULL);
+    sim_find(dev_manager_get_root_path(dev))->files -= n;
+}
+
+static void devices_reset(void)
+{
+    dev_manager_var_init();
+    sim_vol[0].files = 3000;
+    sim_vol[1].files = 20;
+    sim_vol[2].files = 800;
+    for (int i = 0; i < ARRAY_SIZE(sim_vol); i++) {
+        sim_vol[i].online = 1;
+    }
+    dev_manager_add("sd0");
+    dev_manager_add("udisk0");
+    fscan_calls = 0;
+    files_walked = 0;
+}
+
+static void devices_remove(void)
+{
+    dev_manager_del("sd0");
+    dev_manager_del("udisk0");
+    HOST_CHECK(fsn_live == 0, "%d scan handles leaked", fsn_live);
+}
+
+static void test_cache(void)
+{
+    devices_reset();
+    struct __dev *sd0 = dev_manager_find_spec("sd0", 1);
+    struct vfscan *a = dev_manager_scan_disk(sd0, NULL, scan_parm, 1, NULL);
+    HOST_CHECK(a && fscan_calls == 1, "first scan");
+    dev_manager_scan_disk_release(a);
+    HOST_CHECK(fsn_live == DEV_MANAGER_SCAN_CACHE_ENABLE, "released handle live %d", fsn_live);
+
+    struct vfscan *b = dev_manager_scan_disk(sd0, NULL, scan_parm, 3, NULL);
+#if DEV_MANAGER_SCAN_CACHE_ENABLE
+    HOST_CHECK(b == a && fscan_calls == 1 && b->cycle_mode == 3, "cache miss after release (%d scans)", fscan_calls);
+#else
+    HOST_CHECK(fscan_calls == 2, "no-cache build reused a handle");
+#endif
+
+    /*句柄占用时再扫：新句柄，释放时真正释放*/
+    struct vfscan *c = dev_manager_scan_disk(sd0, NULL, scan_parm, 0, NULL);
+    HOST_CHECK(c && c != b, "busy cached handle handed out twice");
+    dev_manager_scan_disk_release(c);
+    HOST_CHECK(fsn_live == 1, "second handle not freed, live %d", fsn_live);
+
+    /*子目录扫盘不缓存*/
+    struct vfscan *d = dev_manager_scan_disk(sd0, "JL_REC", scan_parm, 0, NULL);
+    HOST_CHECK(d && d != b, "path scan returned the cached handle");
+    dev_manager_scan_disk_release(d);
+    HOST_CHECK(fsn_live == 1, "path scan handle kept, live %d", fsn_live);
+    dev_manager_scan_disk_release(b);
+
+    /*参数不同：重新扫盘并替换缓存*/
+    int calls = fscan_calls;
+    struct vfscan *e = dev_manager_scan_disk(sd0, NULL, other_parm, 0, NULL);
+    HOST_CHECK(fscan_calls == calls + 1, "scan with another parm hit the cache");
+    dev_manager_scan_disk_release(e);
+    HOST_CHECK(fsn_live == DEV_MANAGER_SCAN_CACHE_ENABLE, "old parm handle not replaced, live %d", fsn_live);
+
+    /*没有文件的卷：不缓存*/
+    sim_vol[2].files = 0;
+    struct __dev *udisk = dev_manager_find_spec("udisk0", 1);
+    HOST_CHECK(!dev_manager_scan_disk(udisk, NULL, scan_parm, 0, NULL), "empty volume returned a handle");
+    HOST_CHECK(fsn_live == DEV_MANAGER_SCAN_CACHE_ENABLE, "empty volume handle kept, live %d", fsn_live);
+
+    devices_remove();
+}
+
+static void test_invalidate(void)
+{
+    struct player pl = {0};
+
+    devices_reset();
+    HOST_CHECK(player_play_dev(&pl, "sd0") == 3000, "sd0 first play");
+    HOST_CHECK(player_play_dev(&pl, "udisk0") == 800, "udisk0 play");
+
+    /*播放中删除当前文件：占用的旧句柄只解除缓存，停止时释放，重新扫盘看到少一个文件*/
+    int calls = fscan_calls;
+    HOST_CHECK(player_delete_playing_file(&pl) == 799, "file count after delete %d", pl.fsn ? pl.fsn->file_number : -1);
+    HOST_CHECK(fscan_calls == calls + 1, "delete did not rescan");
+    HOST_CHECK(fsn_live == 1 + DEV_MANAGER_SCAN_CACHE_ENABLE, "deleted-file handle leaked, live %d", fsn_live);
+
+    /*回到sd0命中缓存，再回udisk0：删除之后的新句柄已缓存*/
+    calls = fscan_calls;
+    HOST_CHECK(player_play_dev(&pl, "sd0") == 3000, "sd0 replay");
+    HOST_CHECK(player_play_dev(&pl, "udisk0") == 799, "udisk0 after delete");
+    HOST_CHECK(fscan_calls == calls + 2 * !DEV_MANAGER_SCAN_CACHE_ENABLE, "device flip rescanned %d times", fscan_calls - calls);
+
+    /*新建文件(当前设备占用中)和删除其他设备上的文件*/
+    file_manager_create("udisk0");
+    file_manager_delete("sd0", 100);
+    calls = fscan_calls;
+    HOST_CHECK(player_play_dev(&pl, "sd0") == 2900, "sd0 after delete");
+    HOST_CHECK(player_play_dev(&pl, "udisk0") == 800, "udisk0 after create");
+    HOST_CHECK(fscan_calls == calls + 2, "create/delete did not invalidate (%d scans)", fscan_calls - calls);
+
+    /*拔盘：卸载时缓存释放，重新挂载后重新扫盘*/
+    player_stop(&pl, 1);
+    pl.dev = NULL;
+    dev_manager_unmount("sd0");
+    HOST_CHECK(fsn_live == DEV_MANAGER_SCAN_CACHE_ENABLE, "unmount kept sd0 handle, live %d", fsn_live);
+    sim_vol[0].files = 10;
+    dev_manager_mount("sd0");
+    HOST_CHECK(player_play_dev(&pl, "sd0") == 10, "sd0 after remount");
+
+    player_stop(&pl, 1);
+    dev_manager_scan_disk_cache_free(NULL);
+    HOST_CHECK(fsn_live == 0, "cache free left %d handles", fsn_live);
+    devices_remove();
+}
+
+/*音乐模式的操作序列*/
+static void replay(void)
+{
+    struct player pl = {0};
+
+    devices_reset();
+    player_play_dev(&pl, "sd0");		//插卡断点播放
+    for (int i = 0; i < 10; i++) {
+        player_play_dev(&pl, "udisk0");	//切设备
+        player_play_dev(&pl, "sd0");
+    }
+    for (int i = 0; i < 5; i++) {
+        player_play_dev(&pl, "sd0_rec");	//切录音文件夹
+        player_play_dev(&pl, "sd0");
+    }
+    player_delete_playing_file(&pl);
+    player_play_dev(&pl, "udisk0");
+    file_manager_create("udisk0");
+    player_play_dev(&pl, "sd0");
+    player_play_dev(&pl, "udisk0");
+    player_stop(&pl, 1);
+    pl.dev = NULL;
+    dev_manager_unmount("udisk0");	//拔U盘
+    player_play_dev(&pl, "sd0");
+    player_stop(&pl, 1);
+    dev_manager_scan_disk_cache_free(NULL);	//退出音乐模式
+
+    printf("scan replay (cache %d): %d fscan, %d files walked\n", DEV_MANAGER_SCAN_CACHE_ENABLE, fscan_calls, files_walked);
+    devices_remove();
+}
+
+int main(void)
+{
+    test_cache();
+    test_invalidate();
+    replay();
+    char name[40];
+    sprintf(name, "dev_manager_scan_test(cache %d)", DEV_MANAGER_SCAN_CACHE_ENABLE);
+    return host_test_result(name);
+}
@@ -0,0 +1,417 @@
+/*
+ * 辅听处理链(cpu/br36/audio/audio_hearing_aid_chain.c)wav回放和延时测量测试
+ * 登记PC侧的处理级(增益、eq双二阶、噪声门限，代替芯片上的算法库调用)，按块原地运行：
+ * 1.直通链逐位不变；带状态的链在不同块长下输出逐位一致(级间没有拷贝/丢点)
+ * 2.某一级没有输出时后面的级不运行，登记超过DHA_CHAIN_STAGE_MAX返回-1
+ * 3.延时测量：输出经(处理块长 + dac延时)回环到mic并叠加噪声，测得延时与模型一致；
+ *   块长小于脉冲点数时不注入(不截断脉冲)，一直没有能注入的块时超时失败
+ * 4.按块统计各级和整条链的平均/最大耗时
+ *   dha_chain_replay [in.wav [out.wav [块长ms]]]
+ *   只支持16bit单声道pcm wav，不带参数时使用内置的合成数据(16k，语音频段谐波 + 噪声)
+ */
+#include "host_bench.h"
+#include <string.h>
+#include <math.h>
+#include "../../cpu/br36/audio/audio_hearing_aid_chain.c"
+
+#define SAMPLE_RATE			16000
+#define BLOCK_MS			2		/*DHA_LOW_LATENCY_BLOCK_MS*/
+#define LOOP_GAIN_Q15		9830	/*回环声学增益0.3*/
+
+struct pcm_clip {
+    s16 *data;
+    u32 points;
+    u32 sr;
+};
+
+/*各级耗时，包在登记的处理函数外面*/
+struct stage_timer {
+    dha_stage_run_t run;
+    void *priv;
+    u64 cycles;
+    u64 cycles_max;
+    u32 calls;
+};
+
+struct gain_stage {
+    s16 gain_q12;
+};
+
+/*双二阶q14直接I型，状态跨块保持*/
+struct biquad_stage {
+    s32 b0, b1, b2, a1, a2;
+    s32 x1, x2, y1, y2;
+};
+
+struct gate_stage {
+    s32 env;
+    s32 thr;
+};
+
+static s16 sat16(s32 v)
+{
+    return v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+}
+
+static int stage_gain(void *priv, s16 *data, int len)
+{
+    struct gain_stage *g = priv;
+    for (int i = 0; i < (len >> 1); i++) {
+        data[i] = sat16((data[i] * g->gain_q12) >> 12);
+    }
+    return len;
+}
+
+static int stage_biquad(void *priv, s16 *data, int len)
+{
+    struct biquad_stage *q = priv;
+    for (int i = 0; i < (len >> 1); i++) {
+        s32 x = data[i];
+        s32 y = (q->b0 * x + q->b1 * q->x1 + q->b2 * q->x2 - q->a1 * q->y1 - q->a2 * q->y2) >> 14;
+        q->x2 = q->x1;
+        q->x1 = x;
+        q->y2 = q->y1;
+        q->y1 = y;
+        data[i] = sat16(y);
+    }
+    return len;
+}
+
+static int stage_gate(void *priv, s16 *data, int len)
+{
+    struct gate_stage *g = priv;
+    for (int i = 0; i < (len >> 1); i++) {
+        s32 a = data[i] < 0 ? -data[i] : data[i];
+        g->env += (a - g->env) >> 5;
+        if (g->env < g->thr) {
+            data[i] = (data[i] * g->env) / g->thr;
+        }
+    }
+    return len;
+}
+
+static int stage_pass(void *priv, s16 *data, int len)
+{
+    if (priv) {
+        (*(u32 *)priv)++;
+    }
+    return len;
+}
+
+static int stage_drop(void *priv, s16 *data, int len)
+{
+    return 0;
+}
+
+static int stage_timed(void *priv, s16 *data, int len)
+{
+    struct stage_timer *t = priv;
+    u64 t0 = host_bench_now();
+    len = t->run(t->priv, data, len);
+    u64 dt = host_bench_now() - t0;
+    t->cycles += dt;
+    t->cycles_max = MAX(t->cycles_max, dt);
+    t->calls++;
+    return len;
+}
+
+/*eq按1k峰值+6dB、Q 1设计*/
+static void biquad_peak(struct biquad_stage *q, u32 sr)
+{
+    double w0 = 2 * M_PI * 1000 / sr, alpha = sin(w0) / 2, a = pow(10, 6.0 / 40);
+    double a0 = 1 + alpha / a;
+
+    memset(q, 0, sizeof(*q));
+    q->b0 = (s32)((1 + alpha * a) / a0 * 16384);
+    q->b1 = (s32)(-2 * cos(w0) / a0 * 16384);
+    q->b2 = (s32)((1 - alpha * a) / a0 * 16384);
+    q->a1 = q->b1;
+    q->a2 = (s32)((1 - alpha / a) / a0 * 16384);
+}
+
+struct replay_chain {
+    struct dha_chain chain;
+    struct gain_stage gain;
+    struct biquad_stage eq;
+    struct gate_stage gate;
+    struct stage_timer timer[3];
+};
+
+static void replay_chain_init(struct replay_chain *rc, u32 sr, u8 timed)
+{
+    static const char *name[] = {"gain", "eq", "noise_gate"};
+    dha_stage_run_t run[] = {stage_gain, stage_biquad, stage_gate};
+    void *priv[] = {&rc->gain, &rc->eq, &rc->gate};
+
+    memset(rc, 0, sizeof(*rc));
+    rc->gain.gain_q12 = 4096 * 3 / 2;
+    biquad_peak(&rc->eq, sr);
+    rc->gate.thr = 300;
+    dha_chain_init(&rc->chain);
+    for (int i = 0; i < ARRAY_SIZE(name); i++) {
+        if (timed) {
+            rc->timer[i].run = run[i];
+            rc->timer[i].priv = priv[i];
+            dha_chain_add(&rc->chain, name[i], stage_timed, &rc->timer[i]);
+        } else {
+            dha_chain_add(&rc->chain, name[i], run[i], priv[i]);
+        }
+    }
+}
+
+/*clip拷贝到out后按块原地运行整条链，return:总耗时*/
+static u64 run_blocks(struct dha_chain *chain, const struct pcm_clip *clip, s16 *out, u32 block, u64 *cycles_max)
+{
+    u64 total = 0;
+
+    memcpy(out, clip->data, clip->points * 2);
+    for (u32 i = 0; i < clip->points; i += block) {
+        u32 n = MIN(block, clip->points - i);
+        u64 t0 = host_bench_now();
+        dha_chain_run(chain, out + i, n * 2);
+        u64 dt = host_bench_now() - t0;
+        total += dt;
+        if (cycles_max) {
+            *cycles_max = MAX(*cycles_max, dt);
+        }
+    }
+    return total;
+}
+
+static void synth_clip(struct pcm_clip *clip, u32 seconds)
+{
+    clip->sr = SAMPLE_RATE;
+    clip->points = SAMPLE_RATE * seconds;
+    clip->data = malloc(clip->points * 2);
+    for (u32 i = 0; i < clip->points; i++) {
+        double t = (double)i / SAMPLE_RATE;
+        double env = 0.5 + 0.5 * sin(2 * M_PI * 3 * t);
+        double v = 0;
+        for (int h = 1; h <= 8; h++) {
+            v += sin(2 * M_PI * 180 * h * t) / h;
+        }
+        clip->data[i] = (s16)(v * env * 4000 + (s32)(host_rand() % 401) - 200);
+    }
+}
+
+static void test_chain(const struct pcm_clip *clip)
+{
+    static const u32 blocks[] = {1, 16, 32, 80, 160, 333};
+    struct replay_chain rc;
+    struct dha_chain chain;
+    s16 *ref = malloc(clip->points * 2);
+    s16 *out = malloc(clip->points * 2);
+    u32 cnt = 0;
+
+    /*直通*/
+    dha_chain_init(&chain);
+    dha_chain_add(&chain, "pass", stage_pass, &cnt);
+    dha_chain_add(&chain, "pass", stage_pass, NULL);
+    run_blocks(&chain, clip, out, 32, NULL);
+    HOST_CHECK(memcmp(out, clip->data, clip->points * 2) == 0, "pass through chain changed data");
+    HOST_CHECK(cnt == (clip->points + 31) / 32, "pass stage ran %u times", cnt);
+
+    /*不同块长输出一致*/
+    replay_chain_init(&rc, clip->sr, 0);
+    run_blocks(&rc.chain, clip, ref, 32, NULL);
+    HOST_CHECK(memcmp(ref, clip->data, clip->points * 2) != 0, "chain did not process");
+    for (int b = 0; b < ARRAY_SIZE(blocks); b++) {
+        replay_chain_init(&rc, clip->sr, 0);
+        run_blocks(&rc.chain, clip, out, blocks[b], NULL);
+        HOST_CHECK(memcmp(out, ref, clip->points * 2) == 0, "block %u output differs from block 32", blocks[b]);
+    }
+
+    /*某一级没有输出时停止*/
+    cnt = 0;
+    dha_chain_init(&chain);
+    dha_chain_add(&chain, "drop", stage_drop, NULL);
+    dha_chain_add(&chain, "pass", stage_pass, &cnt);
+    HOST_CHECK(dha_chain_run(&chain, out, 64) == 0 && cnt == 0, "stage after an empty output ran");
+    dha_chain_init(&chain);
+    for (int i = 0; i < DHA_CHAIN_STAGE_MAX; i++) {
+        HOST_CHECK(dha_chain_add(&chain, "pass", stage_pass, NULL) == 0, "add stage %d failed", i);
+    }
+    HOST_CHECK(dha_chain_add(&chain, "pass", stage_pass, NULL) == -1, "stage %d accepted", DHA_CHAIN_STAGE_MAX);
+    HOST_CHECK(dha_chain_add(&chain, "null", NULL, NULL) == -1, "NULL stage accepted");
+
+    free(ref);
+    free(out);
+}
+
+/*
+ *回环延时模型：输出连续播放，比对应的mic输入晚(最大块长 + dac_delay)个点回到mic
+ *block_seq为各块长度(循环使用)，return:测量结果(us或负的错误码)
+ */
+static int latency_loop(const u32 *block_seq, int seq_num, u32 dac_delay, s16 noise, u32 *pulse_clip)
+{
+    static s16 out_hist[SAMPLE_RATE];
+    struct dha_latency lat;
+    s16 mic[512], out[512];
+    u32 t = 0;
+    u32 out_points = 0;
+    u32 loop_delay = dac_delay;
+
+    for (int k = 0; k < seq_num; k++) {
+        loop_delay = MAX(loop_delay, block_seq[k] + dac_delay);
+    }
+
+    memset(out_hist, 0, sizeof(out_hist));
+    dha_latency_start(&lat, SAMPLE_RATE);
+    for (int k = 0; t < SAMPLE_RATE / 2; k++) {
+        u32 block = block_seq[k % seq_num];
+        for (u32 i = 0; i < block; i++) {
+            /*mic[t] = 噪声 + 回环的out[t - loop_delay]*/
+            s32 back = (s32)(t + i) - (s32)loop_delay;
+            s32 v = (s32)(host_rand() % (2 * noise + 1)) - noise;
+            if (back >= 0 && back < (s32)out_points) {
+                v += (out_hist[back % SAMPLE_RATE] * LOOP_GAIN_Q15) >> 15;
+            }
+            mic[i] = sat16(v);
+            out[i] = mic[i];	/*直通处理*/
+        }
+        if (dha_latency_input(&lat, mic, block)) {
+            return dha_latency_result(&lat);
+        }
+        dha_latency_output(&lat, out, block);
+        for (u32 i = 0; i < block; i++) {
+            if (out[i] && pulse_clip && block < DHA_LATENCY_PULSE_POINTS) {
+                (*pulse_clip)++;
+            }
+            out_hist[(out_points + i) % SAMPLE_RATE] = out[i];
+        }
+        out_points += block;
+        t += block;
+    }
+    return dha_latency_result(&lat);
+}
+
+static void test_latency(void)
+{
+    static const u32 blocks[] = {16, 32, 80};
+    static const u32 delays[] = {0, 24, 100};
+    static const u32 small[] = {2};
+    static const u32 mixed[] = {2, 2, 3, 32};
+    u32 clip = 0;
+
+    for (int b = 0; b < ARRAY_SIZE(blocks); b++) {
+        for (int d = 0; d < ARRAY_SIZE(delays); d++) {
+            int expect = (blocks[b] + delays[d]) * 1000000 / SAMPLE_RATE;
+            int us = latency_loop(&blocks[b], 1, delays[d], 300, NULL);
+            HOST_CHECK(us == expect, "block %u dac delay %u: latency %d us, expect %d", blocks[b], delays[d], us, expect);
+        }
+    }
+    /*块长小于脉冲点数：不注入，超时失败*/
+    int ret = latency_loop(small, ARRAY_SIZE(small), 24, 300, &clip);
+    HOST_CHECK(ret == -ETIMEDOUT && clip == 0, "block 2: ret %d, %u pulse points in short blocks", ret, clip);
+    /*长短块混合：只在32点的块注入，脉冲完整*/
+    ret = latency_loop(mixed, ARRAY_SIZE(mixed), 24, 300, &clip);
+    HOST_CHECK(ret == (32 + 24) * 1000000 / SAMPLE_RATE && clip == 0,
+               "mixed blocks: ret %d, %u pulse points in short blocks", ret, clip);
+    printf("dha latency: block 32 dac delay 24 -> %d us, mixed blocks -> %d us\n",
+           latency_loop(&blocks[1], 1, 24, 300, NULL), ret);
+}
+
+static void bench(const struct pcm_clip *clip, u32 block, const char *out_path)
+{
+    static const char *name[] = {"gain", "eq", "noise_gate"};
+    struct replay_chain rc;
+    s16 *out = malloc(clip->points * 2);
+    u64 block_max = 0;
+    u32 blocks = (clip->points + block - 1) / block;
+
+    replay_chain_init(&rc, clip->sr, 1);
+    u64 total = run_blocks(&rc.chain, clip, out, block, &block_max);
+    printf("dha chain: %u points, block %u points (%u us), %u blocks\n", clip->points, block,
+           (u32)((u64)block * 1000000 / clip->sr), blocks);
+    for (int i = 0; i < ARRAY_SIZE(name); i++) {
+        printf("  %-10s avg %8.1f max %8llu %s/block\n", name[i], (double)rc.timer[i].cycles / rc.timer[i].calls,
+               (unsigned long long)rc.timer[i].cycles_max, HOST_BENCH_UNIT);
+    }
+    printf("  %-10s avg %8.1f max %8llu %s/block, %.2f %s/point\n", "chain", (double)total / blocks,
+           (unsigned long long)block_max, HOST_BENCH_UNIT, (double)total / clip->points, HOST_BENCH_UNIT);
+
+    if (out_path) {
+        FILE *fp = fopen(out_path, "wb");
+        if (fp) {
+            u32 bytes = clip->points * 2;
+            u8 hdr[44] = "RIFF\0\0\0\0WAVEfmt \x10\0\0\0\x01\0\x01\0\0\0\0\0\0\0\0\0\x02\0\x10\0data";
+            u32 riff = bytes + 36, byte_rate = clip->sr * 2;
+            memcpy(hdr + 4, &riff, 4);
+            memcpy(hdr + 24, &clip->sr, 4);
+            memcpy(hdr + 28, &byte_rate, 4);
+            memcpy(hdr + 40, &bytes, 4);
+            fwrite(hdr, 1, 44, fp);
+            fwrite(out, 2, clip->points, fp);
+            fclose(fp);
+        } else {
+            printf("open %s fail\n", out_path);
+        }
+    }
+    free(out);
+}
+
+/*只支持16bit单声道pcm wav*/
+static int load_wav(struct pcm_clip *clip, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    u8 hdr[12], chunk[8];
+    u16 fmt_tag = 0, bits = 0, ch_num = 0;
+
+    if (!fp) {
+        printf("open %s fail\n", path);
+        return -1;
+    }
+    if (fread(hdr, 1, 12, fp) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fclose(fp);
+        return -1;
+    }
+    while (fread(chunk, 1, 8, fp) == 8) {
+        u32 size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((u32)chunk[7] << 24);
+        if (!memcmp(chunk, "fmt ", 4)) {
+            u8 fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, fp) != 16) {
+                break;
+            }
+            fmt_tag = fmt[0] | (fmt[1] << 8);
+            ch_num = fmt[2];
+            clip->sr = fmt[4] | (fmt[5] << 8);
+            bits = fmt[14] | (fmt[15] << 8);
+            fseek(fp, size - 16 + (size & 1), SEEK_CUR);
+        } else if (!memcmp(chunk, "data", 4)) {
+            if (fmt_tag != 1 || bits != 16 || ch_num != 1 || !clip->sr) {
+                break;
+            }
+            clip->data = malloc(size);
+            clip->points = fread(clip->data, 1, size, fp) / 2;
+            fclose(fp);
+            return 0;
+        } else {
+            fseek(fp, size + (size & 1), SEEK_CUR);
+        }
+    }
+    printf("%s: only 16bit mono pcm wav supported\n", path);
+    fclose(fp);
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    struct pcm_clip clip;
+
+    if (argc > 1) {
+        u32 block_ms = argc > 3 ? atoi(argv[3]) : BLOCK_MS;
+        if (load_wav(&clip, argv[1])) {
+            return 1;
+        }
+        bench(&clip, MAX(clip.sr * block_ms / 1000, 1), argc > 2 ? argv[2] : NULL);
+        free(clip.data);
+        return 0;
+    }
+
+    synth_clip(&clip, 10);
+    test_chain(&clip);
+    test_latency();
+    bench(&clip, SAMPLE_RATE * BLOCK_MS / 1000, NULL);
+    free(clip.data);
+    return host_test_result("dha_chain_replay");
+}
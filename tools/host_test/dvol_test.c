@@ -0,0 +1,219 @@
+/*
+ * 数字音量(audio_dvol.c)回放对比
+ * 1.打包乘法dvol_mul_round_x2与逐点dvol_mul_round逐位一致
+ * 2.立体声与原逐点实现(每两个点步进一次)逐位一致，含淡入淡出和块边界
+ * 3.单声道/多声道与逐帧步进的参考实现逐位一致，含不足一帧的尾部
+ * 4.统计新旧实现每个点的耗时
+ */
+#include "host_bench.h"
+#include "../../apps/common/audio/audio_dvol.c"
+
+#define TEST_POINTS_MAX		1024
+
+/*原audio_digital_vol_run的逐点循环(只支持立体声)*/
+static void legacy_dvol_run(s16 *vol_fade, s16 vol_target, u16 fade_step, s16 *buf, u32 len)
+{
+    s32 valuetemp;
+
+    len >>= 1;
+    for (u32 i = 0; i < len; i += 2) {
+        if (*vol_fade > vol_target) {
+            *vol_fade -= fade_step;
+            if (*vol_fade < vol_target) {
+                *vol_fade = vol_target;
+            }
+        } else if (*vol_fade < vol_target) {
+            *vol_fade += fade_step;
+            if (*vol_fade > vol_target) {
+                *vol_fade = vol_target;
+            }
+        }
+        for (u32 ch = 0; ch < 2; ch++) {
+            valuetemp = buf[i + ch];
+            if (valuetemp < 0) {
+                valuetemp = -valuetemp;
+                valuetemp = (valuetemp * *vol_fade + (1 << 13)) >> 14 ;
+                valuetemp = -valuetemp;
+            } else {
+                valuetemp = (valuetemp * *vol_fade + (1 << 13)) >> 14 ;
+            }
+            buf[i + ch] = (s16)data_sat_s16(valuetemp);
+        }
+    }
+}
+
+/*按帧步进的参考实现，不足一帧的尾部按一帧处理*/
+static void ref_dvol_run(s16 *vol_fade, s16 vol_target, u16 fade_step, s16 *buf, u32 points, u8 ch_num)
+{
+    for (u32 i = 0; i < points; i += ch_num) {
+        if (*vol_fade > vol_target) {
+            *vol_fade = (*vol_fade - fade_step < vol_target) ? vol_target : *vol_fade - fade_step;
+        } else if (*vol_fade < vol_target) {
+            *vol_fade = (*vol_fade + fade_step > vol_target) ? vol_target : *vol_fade + fade_step;
+        }
+        for (u32 ch = 0; (ch < ch_num) && (i + ch < points); ch++) {
+            buf[i + ch] = dvol_mul_round(buf[i + ch], *vol_fade);
+        }
+    }
+}
+
+static void fill_random(s16 *buf, u32 points)
+{
+    for (u32 i = 0; i < points; i++) {
+        u32 r = host_rand();
+        /*穿插满幅和极小值，覆盖饱和和舍入边界*/
+        switch (r & 0xf) {
+        case 0:
+            buf[i] = -32768;
+            break;
+        case 1:
+            buf[i] = 32767;
+            break;
+        case 2:
+            buf[i] = (s16)((r >> 8) & 0x3) - 2;
+            break;
+        default:
+            buf[i] = (s16)(r >> 16);
+            break;
+        }
+    }
+}
+
+static void test_packed_mul(void)
+{
+    for (s32 gain = 0; gain <= 16384; gain++) {
+        for (int n = 0; n < 64; n++) {
+            u32 w = host_rand();
+            if (n < 4) {
+                w = (n & 1 ? 0x8000 : 0x7fff) | ((n & 2 ? 0x8000u : 0x7fffu) << 16);
+            }
+            u32 expect = ((u32)dvol_mul_round((s16)w, gain) & 0xffff) |
+                         ((u32)dvol_mul_round((s32)w >> 16, gain) << 16);
+            u32 got = dvol_mul_round_x2(w, gain);
+            HOST_CHECK(got == expect, "x2 w=%08x gain=%d got=%08x expect=%08x", w, gain, got, expect);
+            if (got != expect) {
+                return;
+            }
+        }
+    }
+}
+
+/*ch_num为0时与原立体声实现对比*/
+static void test_replay(u8 ch_num, int rounds)
+{
+    static s16 buf[TEST_POINTS_MAX + 1], ref[TEST_POINTS_MAX + 1];
+    static const u16 fade_steps[] = {0, 1, 2, 4, 20, 300};
+    u8 legacy = (ch_num == 0);
+    u8 ch = legacy ? 2 : ch_num;
+
+    for (int r = 0; r < rounds; r++) {
+        u16 fade_step = fade_steps[host_rand() % ARRAY_SIZE(fade_steps)];
+        u8 vol_max = 16;
+        dvol_handle *dvol = audio_digital_vol_open(MUSIC_DVOL, host_rand() % (vol_max + 1), vol_max, fade_step, -1);
+        s16 ref_fade = dvol->vol_fade;
+
+        for (int blk = 0; blk < 16; blk++) {
+            if ((host_rand() & 3) == 0) {
+                audio_digital_vol_set(MUSIC_DVOL, host_rand() % (vol_max + 1));
+            }
+            u32 points = host_rand() % TEST_POINTS_MAX;
+            if (legacy) {
+                points &= ~1;
+            }
+            /*奇数起始地址走非对齐路径*/
+            s16 *data = buf + (host_rand() & 1);
+            fill_random(data, points);
+            memcpy(ref, data, points * sizeof(s16));
+            if (legacy) {
+                legacy_dvol_run(&ref_fade, dvol->vol_target, fade_step, ref, points * 2);
+            } else {
+                ref_dvol_run(&ref_fade, dvol->vol_target, fade_step, ref, points, ch);
+            }
+            audio_digital_vol_run_ch(MUSIC_DVOL, data, points * 2, ch);
+            HOST_CHECK(memcmp(data, ref, points * sizeof(s16)) == 0,
+                       "ch=%d legacy=%d round=%d blk=%d points=%d fade_step=%d", ch, legacy, r, blk, points, fade_step);
+            HOST_CHECK(dvol->vol_fade == ref_fade, "vol_fade %d != %d", dvol->vol_fade, ref_fade);
+            if (host_test_fail) {
+                audio_digital_vol_close(MUSIC_DVOL);
+                return;
+            }
+        }
+        audio_digital_vol_close(MUSIC_DVOL);
+    }
+}
+
+static void bench(const char *name, u8 ch_num, u16 fade_step, u8 vol_from, u8 vol_to)
+{
+    static s16 buf[TEST_POINTS_MAX], src[TEST_POINTS_MAX];
+    const int loops = 2000;
+    u64 t_new = 0, t_old = 0;
+
+    fill_random(src, TEST_POINTS_MAX);
+    for (int i = 0; i < loops; i++) {
+        dvol_handle *dvol = audio_digital_vol_open(MUSIC_DVOL, vol_from, 16, fade_step, -1);
+        audio_digital_vol_set(MUSIC_DVOL, vol_to);
+        s16 fade = dvol->vol_fade;
+        s16 target = dvol->vol_target;
+
+        memcpy(buf, src, sizeof(buf));
+        u64 t0 = host_bench_now();
+        audio_digital_vol_run_ch(MUSIC_DVOL, buf, sizeof(buf), ch_num);
+        u64 t1 = host_bench_now();
+        t_new += t1 - t0;
+        audio_digital_vol_close(MUSIC_DVOL);
+
+        memcpy(buf, src, sizeof(buf));
+        t0 = host_bench_now();
+        legacy_dvol_run(&fade, target, fade_step, buf, sizeof(buf));
+        t1 = host_bench_now();
+        t_old += t1 - t0;
+    }
+    printf("  %-24s old %6.2f  new %6.2f %s/point\n", name,
+           (double)t_old / loops / TEST_POINTS_MAX, (double)t_new / loops / TEST_POINTS_MAX, HOST_BENCH_UNIT);
+}
+
+/*打包乘法与两次逐点乘法的耗时对比*/
+static void bench_kernel(void)
+{
+    static u32 w[TEST_POINTS_MAX / 2];
+    const int loops = 4000;
+    u64 t_x1 = 0, t_x2 = 0;
+
+    fill_random((s16 *)w, TEST_POINTS_MAX);
+    for (int i = 0; i < loops; i++) {
+        s32 gain = 1 + (i & 0x3fff);
+        u64 t0 = host_bench_now();
+        for (int n = 0; n < TEST_POINTS_MAX / 2; n++) {
+            s32 lo = dvol_mul_round((s16)w[n], gain);
+            s32 hi = dvol_mul_round((s32)w[n] >> 16, gain);
+            w[n] = ((u32)lo & 0xffff) | ((u32)hi << 16);
+        }
+        u64 t1 = host_bench_now();
+        for (int n = 0; n < TEST_POINTS_MAX / 2; n++) {
+            w[n] = dvol_mul_round_x2(w[n], gain);
+        }
+        u64 t2 = host_bench_now();
+        t_x1 += t1 - t0;
+        t_x2 += t2 - t1;
+    }
+    printf("  %-24s x1   %6.2f  x2  %6.2f %s/point\n", "stereo kernel",
+           (double)t_x1 / loops / TEST_POINTS_MAX, (double)t_x2 / loops / TEST_POINTS_MAX, HOST_BENCH_UNIT);
+}
+
+int main(void)
+{
+    audio_digital_vol_init();
+
+    test_packed_mul();
+    test_replay(0, 400);
+    test_replay(1, 400);
+    test_replay(2, 400);
+    test_replay(3, 200);
+
+    printf("dvol bench (%d points per block):\n", TEST_POINTS_MAX);
+    bench("stereo const gain", 2, 2, 10, 10);
+    bench("stereo fade", 2, 2, 0, 16);
+    bench("mono const gain", 1, 2, 10, 10);
+    bench_kernel();
+    return host_test_result("dvol_test");
+}
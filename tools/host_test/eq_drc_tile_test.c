@@ -0,0 +1,278 @@
+/*
+ * 同步eq+drc分块处理(cpu/br36/audio/audio_eq_drc_tile.c)与原整帧处理逐位对比
+ * eq/drc/spk_eq是库函数，PC上用带状态的替身代替：一阶IIR、包络跟踪限幅、两点FIR，
+ * 各自跨调用保存每个通道的状态，分块边界处理不对就会和整帧结果不同
+ * 1.16bit输出：随机帧长，drc在eq前/后两种组合，输出逐位一致，中间缓存始终一块
+ * 2.24bit输出(-DTCFG_AUDIO_DAC_24BIT_MODE=1)：32bit结果逐位一致，
+ *   超过EQ_DRC_BLOCK_POINTS_MAX时截断
+ * 两种输出的中间缓存都在setup时一次申请，处理过程中不重新申请
+ * 3.统计分块/整帧每个点的耗时(替身的耗时，不代表库函数)
+ */
+#include "host_bench.h"
+#include "generic/typedef.h"
+
+#define TCFG_EQ_ENABLE			1
+#define TCFG_DRC_ENABLE			1
+#define AUDIO_SPK_EQ_CONFIG		1
+#ifndef TCFG_AUDIO_DAC_24BIT_MODE
+#define TCFG_AUDIO_DAC_24BIT_MODE	0
+#endif
+#define EQ_DRC_TILE_POINTS		256
+#define EQ_DRC_BLOCK_POINTS_MAX	2048
+
+#define ASSERT(x)	do { if (!(x)) { printf("ASSERT %s\n", #x); exit(1); } } while (0)
+
+/*与audio_dec_eff.h中用到的成员一致*/
+struct dec_eq_drc {
+    s16 *eq_out_buf;
+    int eq_out_buf_len;
+    int eq_out_points;
+    int eq_out_total;
+    void *drc_prev;
+    void *eq;
+    void *spk_eq;
+    void *drc;
+    u8 async;
+    u8 drc_bef_eq;
+};
+
+static s32 sat(s64 v, s32 min, s32 max)
+{
+    return v > max ? max : (v < min ? min : (s32)v);
+}
+
+/*pcm_convert.c的c参考实现*/
+static void pcm_s16_to_s32(s32 *dst, const s16 *src, int points, u8 shift)
+{
+    while (points-- > 0) {
+        dst[points] = (s32)src[points] << shift;
+    }
+}
+
+static void pcm_s32_to_s16(s16 *dst, const s32 *src, int points, u8 shift)
+{
+    for (int i = 0; i < points; i++) {
+        dst[i] = sat(src[i] >> shift, -32768, 32767);
+    }
+}
+
+/*库音效替身，状态按通道交替保存*/
+struct fx {
+    s64 st[2];
+    u32 n;
+    s32 *out;
+    u8 in_32bit;
+};
+
+static void audio_eq_set_output_buf(void *eq, s16 *buf, int len)
+{
+    ((struct fx *)eq)->out = (s32 *)buf;
+}
+
+/*一阶IIR，16bit或32bit输入，32bit输出到set_output_buf的缓存，可原地*/
+static int audio_eq_run(void *eq, void *data, int len)
+{
+    struct fx *e = eq;
+    int points = e->in_32bit ? len / 4 : len / 2;
+
+    for (int i = 0; i < points; i++) {
+        int ch = e->n++ & 1;
+        s64 x = e->in_32bit ? ((s32 *)data)[i] : ((s16 *)data)[i];
+        s64 y = x + ((e->st[ch] * 24000) >> 15);
+        e->st[ch] = sat(y, -(1 << 20), 1 << 20);
+        e->out[i] = sat(y, (s32)0x80000000, 0x7fffffff);
+    }
+    return len;
+}
+
+/*包络跟踪限幅，32bit原地*/
+static int audio_drc_run(void *drc, s16 *data, int len)
+{
+    struct fx *d = drc;
+    s32 *p = (s32 *)data;
+
+    for (int i = 0; i < len / 4; i++) {
+        int ch = d->n++ & 1;
+        s64 x = p[i];
+        d->st[ch] += ((x < 0 ? -x : x) - d->st[ch]) >> 5;
+        if (d->st[ch] > 20000) {
+            x = x * 20000 / d->st[ch];
+        }
+        p[i] = (s32)x;
+    }
+    return len;
+}
+
+/*两点FIR，32bit*/
+static int spk_eq_run(void *spk, s32 *in, s32 *out, int len)
+{
+    struct fx *s = spk;
+
+    for (int i = 0; i < len / 4; i++) {
+        int ch = s->n++ & 1;
+        s64 x = in[i];
+        out[i] = (s32)((x * 3 + s->st[ch]) >> 2);
+        s->st[ch] = x;
+    }
+    return len;
+}
+
+#include "../../cpu/br36/audio/audio_eq_drc_tile.c"
+
+struct chain {
+    struct fx drc_prev, eq, spk_eq, drc;
+};
+
+static void chain_init(struct chain *c, u8 drc_bef_eq)
+{
+    memset(c, 0, sizeof(*c));
+    c->eq.in_32bit = drc_bef_eq;
+}
+
+static void eff_init(struct dec_eq_drc *eff, struct chain *c, u8 drc_bef_eq, u8 drc_prev)
+{
+    memset(eff, 0, sizeof(*eff));
+    chain_init(c, drc_bef_eq);
+    eff->drc_bef_eq = drc_bef_eq;
+    eff->drc_prev = drc_prev ? &c->drc_prev : NULL;
+    eff->eq = &c->eq;
+    eff->spk_eq = &c->spk_eq;
+    eff->drc = &c->drc;
+    eq_drc_buf_alloc(eff);
+}
+
+/*原eq_drc_run的同步32bit整帧处理，每个音效整帧调用一次，返回处理的16bit长度*/
+static int legacy_eq_drc_run(struct chain *c, u8 drc_bef_eq, u8 drc_prev, s16 *data, s32 *buf, u32 len)
+{
+#if TCFG_AUDIO_DAC_24BIT_MODE
+    if ((len >> 1) > EQ_DRC_BLOCK_POINTS_MAX) {
+        len = EQ_DRC_BLOCK_POINTS_MAX << 1;
+    }
+#endif
+    audio_eq_set_output_buf(&c->eq, (s16 *)buf, len);
+    if (drc_bef_eq && drc_prev) {
+        for (u32 i = 0; i < (len >> 1); i++) {
+            buf[i] = data[i];
+        }
+        audio_drc_run(&c->drc_prev, (s16 *)buf, len * 2);
+    }
+    if (drc_bef_eq) {
+        audio_eq_run(&c->eq, buf, len * 2);
+    } else {
+        audio_eq_run(&c->eq, data, len);
+    }
+    spk_eq_run(&c->spk_eq, buf, buf, len * 2);
+    audio_drc_run(&c->drc, (s16 *)buf, len * 2);
+#if !TCFG_AUDIO_DAC_24BIT_MODE
+    for (u32 i = 0; i < (len >> 1); i++) {
+        data[i] = data_sat_s16(buf[i]);
+    }
+#endif
+    return len;
+}
+
+static void fill_random(s16 *buf, u32 points)
+{
+    for (u32 i = 0; i < points; i++) {
+        u32 r = host_rand();
+        switch (r & 0x7) {
+        case 0:
+            buf[i] = -32768;
+            break;
+        case 1:
+            buf[i] = 32767;
+            break;
+        default:
+            buf[i] = (s16)(r >> 16) >> (r & 0x3);
+            break;
+        }
+    }
+}
+
+#define TEST_POINTS_MAX		(EQ_DRC_BLOCK_POINTS_MAX + 600)
+
+static void test_replay(u8 drc_bef_eq, u8 drc_prev, int blocks)
+{
+    static s16 data[TEST_POINTS_MAX], ref[TEST_POINTS_MAX];
+    static s32 ref_buf[TEST_POINTS_MAX];
+    struct dec_eq_drc eff;
+    struct chain c, ref_c;
+#if TCFG_AUDIO_DAC_24BIT_MODE
+    const int setup_len = EQ_DRC_BLOCK_POINTS_MAX * 4;
+#else
+    const int setup_len = EQ_DRC_TILE_POINTS * 4;
+#endif
+
+    eff_init(&eff, &c, drc_bef_eq, drc_prev);
+    chain_init(&ref_c, drc_bef_eq);
+    s16 *setup_buf = eff.eq_out_buf;
+    HOST_CHECK(setup_buf && eff.eq_out_buf_len == setup_len, "setup buf len %d, expect %d", eff.eq_out_buf_len, setup_len);
+
+    for (int b = 0; b < blocks; b++) {
+        u32 points = host_rand() % TEST_POINTS_MAX;
+        if ((host_rand() & 7) == 0) {
+            points = EQ_DRC_TILE_POINTS * (1 + (host_rand() & 3)) + (host_rand() & 1);
+        }
+        fill_random(data, points);
+        memcpy(ref, data, points * 2);
+
+        int len = eq_drc_tile_run(&eff, data, points * 2);
+        int ref_len = legacy_eq_drc_run(&ref_c, drc_bef_eq, drc_prev, ref, ref_buf, points * 2);
+        u32 done = len >> 1;
+
+        HOST_CHECK(len == ref_len, "len %d != %d", len, ref_len);
+#if TCFG_AUDIO_DAC_24BIT_MODE
+        HOST_CHECK(memcmp(eff.eq_out_buf, ref_buf, done * 4) == 0,
+                   "bef_eq=%d prev=%d blk=%d points=%d 32bit out differs", drc_bef_eq, drc_prev, b, points);
+#else
+        HOST_CHECK(memcmp(data, ref, done * 2) == 0,
+                   "bef_eq=%d prev=%d blk=%d points=%d 16bit out differs", drc_bef_eq, drc_prev, b, points);
+#endif
+        HOST_CHECK(eff.eq_out_buf == setup_buf && eff.eq_out_buf_len == setup_len,
+                   "realloc in run path, buf len %d", eff.eq_out_buf_len);
+        if (host_test_fail) {
+            break;
+        }
+    }
+    free(eff.eq_out_buf);
+}
+
+static void bench(void)
+{
+    static s16 src[1024], data[1024];
+    static s32 ref_buf[1024];
+    struct dec_eq_drc eff;
+    struct chain c, ref_c;
+    const int loops = 2000;
+    u64 t_tile = 0, t_whole = 0;
+
+    fill_random(src, 1024);
+    eff_init(&eff, &c, 0, 0);
+    chain_init(&ref_c, 0);
+    for (int i = 0; i < loops; i++) {
+        memcpy(data, src, sizeof(data));
+        u64 t0 = host_bench_now();
+        eq_drc_tile_run(&eff, data, sizeof(data));
+        u64 t1 = host_bench_now();
+        memcpy(data, src, sizeof(data));
+        legacy_eq_drc_run(&ref_c, 0, 0, data, ref_buf, sizeof(data));
+        u64 t2 = host_bench_now();
+        t_tile += t1 - t0;
+        t_whole += t2 - t1;
+    }
+    free(eff.eq_out_buf);
+    printf("eq_drc bench (stand-ins, 1024 points per block): whole %6.2f  tiled %6.2f %s/point\n",
+           (double)t_whole / loops / 1024, (double)t_tile / loops / 1024, HOST_BENCH_UNIT);
+}
+
+int main(void)
+{
+    test_replay(0, 0, 300);
+    test_replay(1, 1, 300);
+    bench();
+#if TCFG_AUDIO_DAC_24BIT_MODE
+    return host_test_result("eq_drc_tile_test(24bit)");
+#else
+    return host_test_result("eq_drc_tile_test");
+#endif
+}
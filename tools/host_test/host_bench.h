@@ -0,0 +1,61 @@
+/*
+ * PC回放/对比测试公共部分：计时和结果检查
+ * 计时在x86上读tsc(周期)，其他平台用clock_gettime(ns)，
+ * 只用于比较同一台机器上新旧实现的相对耗时，不代表目标芯片上的数值
+ */
+#ifndef _HOST_BENCH_H_
+#define _HOST_BENCH_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HOST_BENCH_UNIT		"cycles"
+static inline uint64_t host_bench_now(void)
+{
+    return __rdtsc();
+}
+#else
+#define HOST_BENCH_UNIT		"ns"
+static inline uint64_t host_bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+
+static int host_test_fail;
+
+#define HOST_CHECK(cond, ...) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+			printf(__VA_ARGS__); \
+			printf("\n"); \
+			host_test_fail++; \
+		} \
+	} while (0)
+
+/*返回值作为进程退出码*/
+static inline int host_test_result(const char *name)
+{
+    printf("%s: %s\n", name, host_test_fail ? "FAIL" : "PASS");
+    return host_test_fail ? 1 : 0;
+}
+
+/*固定种子的伪随机数，保证每次回放数据一致*/
+static uint32_t host_rand_state = 0x12345678;
+
+static inline uint32_t host_rand(void)
+{
+    host_rand_state ^= host_rand_state << 13;
+    host_rand_state ^= host_rand_state >> 17;
+    host_rand_state ^= host_rand_state << 5;
+    return host_rand_state;
+}
+
+#endif
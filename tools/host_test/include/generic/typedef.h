@@ -0,0 +1,85 @@
+/*
+ * PC主机编译用的generic/typedef.h
+ * 只在tools/host_test下编译算法模块时使用，固件编译仍使用include_lib里的版本
+ */
+#ifndef _typedef_h_
+#define _typedef_h_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+typedef unsigned char   		u8, BOOL;
+typedef char            		s8;
+typedef unsigned short  		u16;
+typedef signed short    		s16;
+typedef unsigned int    		u32;
+typedef signed int      		s32;
+typedef unsigned long long 		u64;
+typedef long long               s64;
+
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+#define SEC_USED(x)
+#define SEC(x)
+#define sec(x)
+#define AT(x)
+#define SET(x)          __attribute__((x))
+#define ALIGNED(x)	    __attribute__((aligned(x)))
+#define _GNU_PACKED_	__attribute__((packed))
+#define _NOINLINE_	    __attribute__((noinline))
+#define _INLINE_	    __attribute__((always_inline))
+#define _WEAK_	        __attribute__((weak))
+
+#undef FALSE
+#define FALSE    	0
+#undef TRUE
+#define TRUE    	1
+
+#define BIT(n)              (1UL << (n))
+#define ALIGN_4BYTE(size)   ((size+3)&0xfffffffc)
+
+#ifndef MIN
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
+#ifndef MAX
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#endif
+
+#define ARRAY_SIZE(array)  (sizeof(array)/sizeof(array[0]))
+
+#define likely(x) 	__builtin_expect(!!(x), 1)
+#define unlikely(x) __builtin_expect(!!(x), 0)
+
+#ifdef offsetof
+#undef offsetof
+#endif
+#ifdef container_of
+#undef container_of
+#endif
+#define offsetof(type, memb) \
+	((unsigned long)(&((type *)0)->memb))
+#define container_of(ptr, type, memb) \
+	((type *)((char *)(ptr) - offsetof(type, memb)))
+
+/*单线程回放，不需要关中断*/
+#define local_irq_disable()
+#define local_irq_enable()
+
+#define zalloc(size)		calloc(1, size)
+
+static inline int data_sat_s16(int ind)
+{
+    if (ind > 32767) {
+        ind = 32767;
+    } else if (ind < -32768) {
+        ind = -32768;
+    }
+    return ind;
+}
+
+#endif
@@ -0,0 +1,340 @@
+/*
+ * 按键手势状态机(apps/common/device/key/key_gesture.c)回放测试
+ * 按扫描节拍逐拍喂入录制的按键值序列，输出事件和扫描定时器需要全速运行的节拍数：
+ * 1.内置录制序列(单击、多击、长按/HOLD/抬起、消抖毛刺、换键、BIT(7)只单击按键)，检查事件、键值和节拍
+ * 2.随机序列与拆分前key_driver_scan的内联实现逐拍对比，事件、键值和节拍完全一致
+ * 3.每个手势最后一个事件的同一拍状态机即空闲(key_gesture_idle)，统计全速扫描节拍数，
+ *   与原来按下后保持35拍is_key_active的轮询方式比较
+ *   key_gesture_replay [seq.txt]
+ *   seq每行一段："按键值 节拍数"，按键值'-'表示NO_KEY，#开头的行忽略
+ */
+#include "host_bench.h"
+#include "../../apps/common/device/key/key_gesture.c"
+
+#define LEGACY_ACTIVE_TICKS		35		/*拆分前is_key_active的保持节拍数*/
+#define EVENT_MAX				256
+
+/*iokey默认参数，扫描周期10ms*/
+#define KEY_SCAN_PARA_INIT { \
+	.scan_time = 10, \
+	.last_key = NO_KEY, \
+	.filter_time = 4, \
+	.long_time = 75, \
+	.hold_time = 75 + 15, \
+	.click_delay_time = 20, \
+}
+
+struct seg {
+    u8 value;
+    u16 ticks;
+};
+
+struct key_ev {
+    u32 tick;
+    u8 event;
+    u8 value;
+};
+
+struct replay_stat {
+    struct key_ev ev[EVENT_MAX];
+    u32 ev_num;
+    u32 busy_ticks;		/*状态机不空闲的节拍*/
+    u32 legacy_ticks;	/*原轮询方式保持活跃的节拍*/
+    u32 idle_late;		/*最后一个事件之后状态机仍不空闲的手势数*/
+};
+
+static const char *event_name(u8 event)
+{
+    static const char *name[] = {
+        "click", "long", "hold", "up", "double", "triple", "fourth", "fifth",
+    };
+    return event < ARRAY_SIZE(name) ? name[event] : "?";
+}
+
+/*拆分前key_driver_scan的手势部分，去掉发消息，作为对比参考*/
+static int legacy_scan(struct key_driver_para *scan_para, u8 cur_key_value, u8 *key_event, u8 *key_value)
+{
+    if (cur_key_value != scan_para->filter_value && scan_para->filter_time) {
+        scan_para->filter_cnt = 0;
+        scan_para->filter_value = cur_key_value;
+        return 0;
+    }
+    if (scan_para->filter_cnt < scan_para->filter_time) {
+        scan_para->filter_cnt++;
+        return 0;
+    }
+    if (cur_key_value != scan_para->last_key) {
+        if (cur_key_value == NO_KEY) {
+            if (scan_para->press_cnt >= scan_para->long_time) {
+                *key_event = KEY_EVENT_UP;
+                *key_value = scan_para->last_key;
+                goto _notify;
+            }
+            scan_para->click_delay_cnt = 1;
+        } else {
+            scan_para->press_cnt = 1;
+            if (cur_key_value != scan_para->notify_value) {
+                scan_para->click_cnt = 1;
+                scan_para->notify_value = cur_key_value;
+            } else {
+                scan_para->click_cnt++;
+            }
+        }
+        goto _scan_end;
+    } else {
+        if (cur_key_value == NO_KEY) {
+            if (scan_para->click_cnt > 0) {
+                if (scan_para->notify_value & BIT(7)) {
+                    *key_event = KEY_EVENT_CLICK;
+                    *key_value = scan_para->notify_value;
+                    goto _notify;
+                }
+                if (scan_para->click_delay_cnt > scan_para->click_delay_time) {
+                    if (scan_para->click_cnt >= 5) {
+                        *key_event = KEY_EVENT_FIRTH_CLICK;
+                    } else if (scan_para->click_cnt >= 4) {
+                        *key_event = KEY_EVENT_FOURTH_CLICK;
+                    } else if (scan_para->click_cnt >= 3) {
+                        *key_event = KEY_EVENT_TRIPLE_CLICK;
+                    } else if (scan_para->click_cnt >= 2) {
+                        *key_event = KEY_EVENT_DOUBLE_CLICK;
+                    } else {
+                        *key_event = KEY_EVENT_CLICK;
+                    }
+                    *key_value = scan_para->notify_value;
+                    goto _notify;
+                } else {
+                    scan_para->click_delay_cnt++;
+                    goto _scan_end;
+                }
+            } else {
+                goto _scan_end;
+            }
+        } else {
+            scan_para->press_cnt++;
+            if (scan_para->press_cnt == scan_para->long_time) {
+                *key_event = KEY_EVENT_LONG;
+            } else if (scan_para->press_cnt == scan_para->hold_time) {
+                *key_event = KEY_EVENT_HOLD;
+                scan_para->press_cnt = scan_para->long_time;
+            } else {
+                goto _scan_end;
+            }
+            *key_value = cur_key_value;
+            goto _notify;
+        }
+    }
+_notify:
+    scan_para->click_cnt = 0;
+    scan_para->notify_value = NO_KEY;
+    scan_para->last_key = cur_key_value;
+    return 1;
+_scan_end:
+    scan_para->last_key = cur_key_value;
+    return 0;
+}
+
+typedef int (*gesture_fn)(struct key_driver_para *scan_para, u8 cur_key_value, u8 *key_event, u8 *key_value);
+
+static void replay(const struct seg *seq, int seg_num, gesture_fn step, struct replay_stat *st, u8 verbose)
+{
+    struct key_driver_para para = KEY_SCAN_PARA_INIT;
+    u32 tick = 0;
+    u32 active = 0;
+
+    memset(st, 0, sizeof(*st));
+    for (int s = 0; s < seg_num; s++) {
+        for (u32 i = 0; i < seq[s].ticks; i++, tick++) {
+            u8 key_event, key_value;
+            u8 cur = seq[s].value;
+
+            if (step(&para, cur, &key_event, &key_value)) {
+                if (st->ev_num < EVENT_MAX) {
+                    st->ev[st->ev_num++] = (struct key_ev) {
+                        tick, key_event, key_value
+                    };
+                }
+                //除LONG/HOLD外都是手势的最后一个事件，应当立即回到空闲
+                if (key_event != KEY_EVENT_LONG && key_event != KEY_EVENT_HOLD && !key_gesture_idle(&para)) {
+                    st->idle_late++;
+                }
+                if (verbose) {
+                    printf("  %8u ms  %-7s key 0x%02x\n", tick * para.scan_time, event_name(key_event), key_value);
+                }
+            }
+            st->busy_ticks += !key_gesture_idle(&para);
+            if (cur != NO_KEY) {
+                active = LEGACY_ACTIVE_TICKS;
+            } else if (active) {
+                active--;
+            }
+            st->legacy_ticks += !!active;
+        }
+    }
+}
+
+struct replay_case {
+    const char *name;
+    struct seg seq[16];
+    int seg_num;
+    struct key_ev expect[8];
+    int expect_num;
+};
+
+#define K1		0x01
+#define K2		0x02
+#define KC		(0x03 | BIT(7))		/*只响应单击的按键*/
+#define NK		NO_KEY
+
+/*
+ *节拍计算：按键值稳定filter_time + 1拍后状态机才看到变化，
+ *按下后第long_time拍LONG，之后每(hold_time - long_time)拍HOLD，
+ *抬起后等click_delay_time + 1拍发多击事件
+ */
+static const struct replay_case cases[] = {
+    {
+        "click", {{NK, 10}, {K1, 10}, {NK, 40}}, 3,
+        {{20 + 5 + 21, KEY_EVENT_CLICK, K1}}, 1,
+    },
+    {
+        "double", {{NK, 10}, {K1, 10}, {NK, 8}, {K1, 10}, {NK, 40}}, 5,
+        {{38 + 5 + 21, KEY_EVENT_DOUBLE_CLICK, K1}}, 1,
+    },
+    {
+        "fifth", {{K1, 8}, {NK, 8}, {K1, 8}, {NK, 8}, {K1, 8}, {NK, 8}, {K1, 8}, {NK, 8}, {K1, 8}, {NK, 40}}, 10,
+        {{72 + 5 + 21, KEY_EVENT_FIRTH_CLICK, K1}}, 1,
+    },
+    {
+        "long_hold_up", {{NK, 10}, {K1, 130}, {NK, 40}}, 3,
+        {
+            {10 + 5 + 74, KEY_EVENT_LONG, K1},
+            {10 + 5 + 89, KEY_EVENT_HOLD, K1},
+            {10 + 5 + 104, KEY_EVENT_HOLD, K1},
+            {10 + 5 + 119, KEY_EVENT_HOLD, K1},
+            {140 + 5, KEY_EVENT_UP, K1},
+        }, 5,
+    },
+    {
+        "glitch", {{NK, 10}, {K1, 3}, {NK, 10}, {K2, 4}, {NK, 40}}, 5,
+        {}, 0,
+    },
+    {
+        "glitch_in_press", {{NK, 10}, {K1, 20}, {NK, 3}, {K1, 20}, {NK, 40}}, 5,
+        {{53 + 5 + 21, KEY_EVENT_CLICK, K1}}, 1,
+    },
+    {
+        /*不同按键连击只上报后一个按键(与拆分前一致)*/
+        "change_key", {{NK, 10}, {K1, 10}, {NK, 8}, {K2, 10}, {NK, 40}}, 5,
+        {{38 + 5 + 21, KEY_EVENT_CLICK, K2}}, 1,
+    },
+    {
+        "click_only", {{NK, 10}, {KC, 10}, {NK, 8}, {KC, 10}, {NK, 40}}, 5,
+        {{20 + 5 + 1, KEY_EVENT_CLICK, KC}, {38 + 5 + 1, KEY_EVENT_CLICK, KC}}, 2,
+    },
+};
+
+static void test_cases(void)
+{
+    struct replay_stat st;
+
+    for (int c = 0; c < ARRAY_SIZE(cases); c++) {
+        const struct replay_case *rc = &cases[c];
+        replay(rc->seq, rc->seg_num, key_gesture_step, &st, 0);
+        HOST_CHECK(st.ev_num == rc->expect_num, "%s: %u events, expect %d", rc->name, st.ev_num, rc->expect_num);
+        for (int i = 0; i < rc->expect_num && i < st.ev_num; i++) {
+            HOST_CHECK(st.ev[i].event == rc->expect[i].event && st.ev[i].value == rc->expect[i].value &&
+                       st.ev[i].tick == rc->expect[i].tick,
+                       "%s: event %d %s 0x%02x @%u, expect %s 0x%02x @%u", rc->name, i,
+                       event_name(st.ev[i].event), st.ev[i].value, st.ev[i].tick,
+                       event_name(rc->expect[i].event), rc->expect[i].value, rc->expect[i].tick);
+        }
+        HOST_CHECK(st.idle_late == 0, "%s: not idle after the last event", rc->name);
+    }
+}
+
+/*随机序列：按下/抬起时长覆盖毛刺、连击间隔、长按和HOLD*/
+static int random_seq(struct seg *seq, int seg_max)
+{
+    static const u8 keys[] = {K1, K2, KC};
+    int n = 0;
+
+    while (n < seg_max - 1) {
+        u32 r = host_rand();
+        u16 press = (r & 3) == 0 ? 1 + (r >> 8) % 6 : ((r & 3) == 1 ? 5 + (r >> 8) % 40 : 60 + (r >> 8) % 150);
+        u16 idle = (r & 0x30) ? 1 + (r >> 16) % 30 : 20 + (r >> 16) % 200;
+        seq[n++] = (struct seg) {
+            keys[(r >> 24) % ((r & 0x40) ? 3 : 1)], press
+        };
+        seq[n++] = (struct seg) {
+            NK, idle
+        };
+    }
+    seq[n++] = (struct seg) {
+        NK, 100
+    };
+    return n;
+}
+
+static void test_random(void)
+{
+    static struct seg seq[64];
+    struct replay_stat st, ref;
+    u64 busy = 0, legacy = 0;
+
+    for (int k = 0; k < 20000 && !host_test_fail; k++) {
+        int n = random_seq(seq, ARRAY_SIZE(seq) - 1);
+        replay(seq, n, key_gesture_step, &st, 0);
+        replay(seq, n, legacy_scan, &ref, 0);
+        HOST_CHECK(st.ev_num == ref.ev_num && memcmp(st.ev, ref.ev, st.ev_num * sizeof(st.ev[0])) == 0,
+                   "random %d: events differ from legacy scan (%u vs %u)", k, st.ev_num, ref.ev_num);
+        HOST_CHECK(st.idle_late == 0, "random %d: not idle after the last event", k);
+        busy += st.busy_ticks;
+        legacy += st.legacy_ticks;
+    }
+    printf("key gesture: full speed scan ticks %llu, legacy active ticks %llu (%.1f%%)\n",
+           (unsigned long long)busy, (unsigned long long)legacy, legacy ? 100.0 * busy / legacy : 0);
+}
+
+static int seq_load(struct seg *seq, int seg_max, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[128];
+    int n = 0;
+
+    if (!fp) {
+        printf("open %s failed\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), fp) && n < seg_max) {
+        char key[16];
+        int ticks;
+        if (line[0] == '#' || sscanf(line, "%15s %d", key, &ticks) != 2) {
+            continue;
+        }
+        seq[n].value = key[0] == '-' ? NO_KEY : strtol(key, NULL, 0);
+        seq[n].ticks = ticks;
+        n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1) {
+        static struct seg seq[4096];
+        struct replay_stat st;
+        int n = seq_load(seq, ARRAY_SIZE(seq), argv[1]);
+        if (n <= 0) {
+            return 1;
+        }
+        replay(seq, n, key_gesture_step, &st, 1);
+        printf("key gesture replay: %u events, full speed scan ticks %u, legacy active ticks %u\n",
+               st.ev_num, st.busy_ticks, st.legacy_ticks);
+        return 0;
+    }
+
+    test_cases();
+    test_random();
+    return host_test_result("key_gesture_replay");
+}
@@ -0,0 +1,468 @@
+/*
+ * 多mic采集分发(cpu/br36/audio/audio_mic_capture.c)对比测试
+ * 1.双mic 32点周期凑256点块：块输出与原来的路径(tmp_buf拆分后拷回adc缓存，
+ *   侧音打开时audio_aec_inbuf/audio_aec_inbuf_ref再用mic0_data/mic1_data凑512byte)逐点一致，
+ *   周期输出按写入顺序拼起来等于各通道原始数据，view指向块缓存
+ * 2.周期不整除块长(48点、块长的倍数)时跨块拆成两次周期输出，数据不丢不重
+ * 3.输出保留view：所有块都被保留时丢弃整个周期并计数，保留的块不被改写，
+ *   mic_view_put后从下一个周期恢复
+ * 4.单mic且周期正好一块：直接输出adc缓存，不拷贝，mic_view_get返回-EPERM；
+ *   单mic 32点周期仍按块拷贝
+ * 5.统计原路径和新路径每个周期的耗时
+ */
+#include "host_bench.h"
+#include "generic/typedef.h"
+#include "../../apps/common/audio/pcm_convert.c"
+#include "../../cpu/br36/audio/audio_mic_capture.c"
+
+#define STREAM_PERIODS		64
+#define PERIOD_POINTS_MAX	512
+#define STREAM_POINTS_MAX	(STREAM_PERIODS * PERIOD_POINTS_MAX)
+#define BLOCK_POINTS		256
+
+/*adc数据：各通道按点交织*/
+static s16 adc_stream[STREAM_POINTS_MAX * MIC_CAPTURE_CH_MAX];
+
+static void adc_stream_gen(int points, u8 ch_num)
+{
+    for (int i = 0; i < points * ch_num; i++) {
+        adc_stream[i] = (s16)host_rand();
+    }
+}
+
+/*输出记录：各通道按输出顺序拼接*/
+struct mic_record {
+    s16 ch[MIC_CAPTURE_CH_MAX][STREAM_POINTS_MAX];
+    int points;
+    int calls;
+    u8 ch_num;
+    u8 block_view;		/*所有view都指向块缓存*/
+    u8 hold;			/*保留块输出的view*/
+    struct mic_view held[8];
+    int held_num;
+    s16 held_copy[8][MIC_CAPTURE_CH_MAX][BLOCK_POINTS];
+};
+
+static struct mic_record period_rec, block_rec;
+
+static void mic_record_reset(struct mic_record *rec)
+{
+    rec->points = 0;
+    rec->calls = 0;
+    rec->block_view = 1;
+    rec->hold = 0;
+    rec->held_num = 0;
+}
+
+static void mic_record_output(void *priv, struct mic_view *view)
+{
+    struct mic_record *rec = priv;
+
+    rec->ch_num = view->ch_num;
+    rec->calls++;
+    if (view->block == NULL) {
+        rec->block_view = 0;
+    }
+    if (rec->points + view->points <= STREAM_POINTS_MAX) {
+        for (u8 c = 0; c < view->ch_num; c++) {
+            memcpy(&rec->ch[c][rec->points], view->ch[c], view->points * sizeof(s16));
+        }
+        rec->points += view->points;
+    }
+    if (rec->hold && (rec->held_num < ARRAY_SIZE(rec->held))) {
+        HOST_CHECK(mic_view_get(view) == 0, "mic_view_get on a block view failed");
+        rec->held[rec->held_num] = *view;
+        for (u8 c = 0; c < view->ch_num; c++) {
+            memcpy(rec->held_copy[rec->held_num][c], view->ch[c], view->points * sizeof(s16));
+        }
+        rec->held_num++;
+    }
+}
+
+static struct mic_capture_output period_output = {mic_record_output, &period_rec, MIC_OUTPUT_PERIOD};
+static struct mic_capture_output block_output = {mic_record_output, &block_rec, MIC_OUTPUT_BLOCK};
+
+static struct mic_capture *mic_open(u8 ch_num, u16 block_points, u8 block_num)
+{
+    struct mic_capture *cap = mic_capture_open(ch_num, block_points, block_num);
+
+    mic_record_reset(&period_rec);
+    mic_record_reset(&block_rec);
+    if (cap) {
+        mic_capture_add_output(cap, &block_output);
+        mic_capture_add_output(cap, &period_output);
+    }
+    return cap;
+}
+
+/*adc中断里的写入：每次拷一个周期到adc缓存再交给采集，采集不能依赖adc缓存之后不变*/
+static void mic_write_periods(struct mic_capture *cap, u8 ch_num, int period, int first, int num)
+{
+    s16 adc_buf[PERIOD_POINTS_MAX * MIC_CAPTURE_CH_MAX];
+
+    for (int i = first; i < first + num; i++) {
+        memcpy(adc_buf, &adc_stream[i * period * ch_num], period * ch_num * sizeof(s16));
+        mic_capture_write(cap, adc_buf, period);
+        memset(adc_buf, 0x5a, sizeof(adc_buf));
+    }
+}
+
+static int mic_record_equal(struct mic_record *rec, u8 ch_num, int first_point, int points)
+{
+    if (rec->points != points) {
+        return 0;
+    }
+    for (int i = 0; i < points; i++) {
+        for (u8 c = 0; c < ch_num; c++) {
+            if (rec->ch[c][i] != adc_stream[(first_point + i) * ch_num + c]) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/*
+ *原来的esco路径(audio_enc.c + 侧音打开时的audio_aec.c)，作为逐点对比的参考：
+ *adc_mic_output_handler里mic0原地拆到前半、mic1先拆到tmp_buf再拷到后半，
+ *audio_aec_inbuf/audio_aec_inbuf_ref各自把周期拷进3个512byte的缓存凑成一帧
+ */
+static s16 old_mic0_data[3][256];
+static int old_mic0_data_offset;
+static int old_mic0_data_bulk;
+static s16 old_mic1_data[3][256];
+static int old_mic1_data_offset;
+static int old_mic1_data_bulk;
+
+static void (*old_frame_out)(u8 mic, s16 *buf, u16 len);
+
+static void old_aec_inbuf(s16 *buf, u16 len)
+{
+    if (old_mic0_data_bulk > 2) {
+        old_mic0_data_bulk = 0;
+    }
+    if (old_mic0_data_offset > (512 - len)) {
+        old_mic0_data_offset = 0;
+    }
+    memcpy((u8 *)&old_mic0_data[old_mic0_data_bulk][0] + old_mic0_data_offset, buf, len);
+    buf = (s16 *)(&old_mic0_data[old_mic0_data_bulk]);
+    old_mic0_data_offset += len;
+    if (old_mic0_data_offset <= (512 - len)) {
+        return;
+    }
+    old_mic0_data_bulk++;
+    old_frame_out(0, buf, 512);
+}
+
+static void old_aec_inbuf_ref(s16 *buf, u16 len)
+{
+    if (old_mic1_data_bulk > 2) {
+        old_mic1_data_bulk = 0;
+    }
+    if (old_mic1_data_offset > (512 - len)) {
+        old_mic1_data_offset = 0;
+    }
+    memcpy((u8 *)&old_mic1_data[old_mic1_data_bulk][0] + old_mic1_data_offset, buf, len);
+    buf = (s16 *)(&old_mic1_data[old_mic1_data_bulk]);
+    old_mic1_data_offset += len;
+    if (old_mic1_data_offset <= (512 - len)) {
+        return;
+    }
+    old_mic1_data_bulk++;
+    old_frame_out(1, buf, 512);
+}
+
+static void old_sidetone_inbuf(s16 *buf, u16 len)
+{
+    __asm__ volatile("" :: "r"(buf), "r"(len) : "memory");
+}
+
+static void old_esco_handler(s16 *data, int len, s16 *tmp_buf)
+{
+    s16 *mic0_data = data;
+    s16 *mic1_data = tmp_buf;
+    s16 *mic1_data_pos = data + (len / 2);
+    for (u16 i = 0; i < (len >> 1); i++) {
+        mic0_data[i] = data[i * 2];
+        mic1_data[i] = data[i * 2 + 1];
+    }
+    memcpy(mic1_data_pos, mic1_data, len);
+    /*TCFG_AUDIO_DMS_MIC_MANAGE == DMS_MASTER_MIC0*/
+    old_aec_inbuf_ref(mic1_data_pos, len);
+    old_aec_inbuf(data, len);
+    old_sidetone_inbuf(data, len);
+}
+
+static void old_reset(void)
+{
+    old_mic0_data_offset = 0;
+    old_mic0_data_bulk = 0;
+    old_mic1_data_offset = 0;
+    old_mic1_data_bulk = 0;
+}
+
+static struct mic_record old_rec;
+
+static void old_record_frame(u8 mic, s16 *buf, u16 len)
+{
+    u16 points = len >> 1;
+    if (old_rec.points + points <= STREAM_POINTS_MAX) {
+        /*mic1(参考)先于mic0送入，mic0送入时一帧完整*/
+        memcpy(&old_rec.ch[mic][old_rec.points], buf, len);
+        if (mic == 0) {
+            old_rec.points += points;
+            old_rec.calls++;
+        }
+    }
+}
+
+static void old_frame_nop(u8 mic, s16 *buf, u16 len)
+{
+    __asm__ volatile("" :: "r"(buf), "r"(len) : "memory");
+}
+
+/*1.双mic 32点周期凑256点块，和原路径逐点比较*/
+static void test_dual_mic_old_path(void)
+{
+    const int period = 32;
+    s16 adc_buf[PERIOD_POINTS_MAX * 2];
+    s16 tmp_buf[PERIOD_POINTS_MAX];
+
+    adc_stream_gen(STREAM_PERIODS * period, 2);
+    old_reset();
+    old_rec.points = 0;
+    old_rec.calls = 0;
+    old_frame_out = old_record_frame;
+    for (int i = 0; i < STREAM_PERIODS; i++) {
+        memcpy(adc_buf, &adc_stream[i * period * 2], period * 2 * sizeof(s16));
+        old_esco_handler(adc_buf, period * 2, tmp_buf);
+    }
+
+    struct mic_capture *cap = mic_open(2, BLOCK_POINTS, 2);
+    mic_write_periods(cap, 2, period, 0, STREAM_PERIODS);
+
+    int frames = STREAM_PERIODS * period / BLOCK_POINTS;
+    HOST_CHECK(old_rec.calls == frames && block_rec.calls == frames, "frames old %d new %d, want %d",
+               old_rec.calls, block_rec.calls, frames);
+    HOST_CHECK(block_rec.points == old_rec.points && block_rec.ch_num == 2, "block points %d old %d",
+               block_rec.points, old_rec.points);
+    for (u8 c = 0; c < 2; c++) {
+        HOST_CHECK(!memcmp(block_rec.ch[c], old_rec.ch[c], old_rec.points * sizeof(s16)),
+                   "mic%d blocks differ from old tmp_buf/mic%d_data path", c, c);
+    }
+    HOST_CHECK(mic_record_equal(&block_rec, 2, 0, frames * BLOCK_POINTS), "blocks differ from adc data");
+    HOST_CHECK(period_rec.calls == STREAM_PERIODS && mic_record_equal(&period_rec, 2, 0, STREAM_PERIODS * period),
+               "period outputs %d differ from adc data", period_rec.calls);
+    HOST_CHECK(period_rec.block_view && block_rec.block_view, "dual mic view points at the adc buffer");
+    HOST_CHECK(mic_capture_overrun(cap) == 0, "overrun %u with synchronous outputs", mic_capture_overrun(cap));
+    mic_capture_close(cap);
+}
+
+/*2.周期和块长不对齐：跨块的周期拆成两次输出*/
+static void test_period_split(u8 ch_num, int period)
+{
+    int periods = STREAM_PERIODS;
+
+    adc_stream_gen(periods * period, ch_num);
+    struct mic_capture *cap = mic_open(ch_num, BLOCK_POINTS, 2);
+    mic_write_periods(cap, ch_num, period, 0, periods);
+
+    int frames = periods * period / BLOCK_POINTS;
+    int splits = 0;
+    for (int i = 0; i < periods; i++) {
+        int end = (i + 1) * period;
+        /*跨过块边界(不含正好落在边界上)的周期多一次输出，一个周期可能跨多块*/
+        splits += (end - 1) / BLOCK_POINTS - (i * period) / BLOCK_POINTS;
+    }
+    HOST_CHECK(block_rec.calls == frames && mic_record_equal(&block_rec, ch_num, 0, frames * BLOCK_POINTS),
+               "ch %d period %d: %d blocks differ", ch_num, period, block_rec.calls);
+    HOST_CHECK(period_rec.calls == periods + splits && mic_record_equal(&period_rec, ch_num, 0, periods * period),
+               "ch %d period %d: %d period outputs (want %d) differ", ch_num, period, period_rec.calls,
+               periods + splits);
+    HOST_CHECK(period_rec.block_view, "ch %d period %d: view points at the adc buffer", ch_num, period);
+    mic_capture_close(cap);
+}
+
+/*3.输出保留view：没有空闲块时丢弃整个周期并计数*/
+static void test_overrun(void)
+{
+    const int period = 32;
+    const int per_block = BLOCK_POINTS / period;
+    const u8 block_num = 3;
+
+    adc_stream_gen(STREAM_PERIODS * period, 2);
+    struct mic_capture *cap = mic_open(2, BLOCK_POINTS, block_num);
+    block_rec.hold = 1;
+
+    /*保留满所有块：第block_num块写完后没有空闲块*/
+    int written = block_num * per_block;
+    mic_write_periods(cap, 2, period, 0, written);
+    HOST_CHECK(block_rec.held_num == block_num && mic_capture_overrun(cap) == 0,
+               "held %d blocks, overrun %u", block_rec.held_num, mic_capture_overrun(cap));
+
+    int dropped = 5;
+    mic_write_periods(cap, 2, period, written, dropped);
+    HOST_CHECK(mic_capture_overrun(cap) == dropped, "overrun %u, want %d dropped periods",
+               mic_capture_overrun(cap), dropped);
+    HOST_CHECK(period_rec.calls == written, "period outputs %d while all blocks are held", period_rec.calls);
+
+    /*保留的块不被改写*/
+    for (int b = 0; b < block_rec.held_num; b++) {
+        struct mic_view *view = &block_rec.held[b];
+        for (u8 c = 0; c < 2; c++) {
+            HOST_CHECK(!memcmp(view->ch[c], block_rec.held_copy[b][c], BLOCK_POINTS * sizeof(s16)),
+                       "held block %d ch %d was overwritten", b, c);
+        }
+    }
+
+    /*放掉一块后从下一个周期恢复，丢弃的周期不补*/
+    block_rec.hold = 0;
+    mic_view_put(&block_rec.held[1]);
+    int resume = written + dropped;
+    mic_write_periods(cap, 2, period, resume, per_block);
+    HOST_CHECK(mic_capture_overrun(cap) == dropped, "overrun %u after a block is put back", mic_capture_overrun(cap));
+    HOST_CHECK(block_rec.calls == block_num + 1, "%d blocks after resume", block_rec.calls);
+    int ok = 1;
+    for (int i = 0; i < BLOCK_POINTS; i++) {
+        for (u8 c = 0; c < 2; c++) {
+            ok &= block_rec.ch[c][block_num * BLOCK_POINTS + i] == adc_stream[(resume * period + i) * 2 + c];
+        }
+    }
+    HOST_CHECK(ok, "block after resume does not start at the first period after the drop");
+
+    /*新块写进放掉的那一块，其余保留的块仍不变*/
+    for (int b = 0; b < block_rec.held_num; b++) {
+        if (b == 1) {
+            continue;
+        }
+        HOST_CHECK(!memcmp(block_rec.held[b].ch[0], block_rec.held_copy[b][0], BLOCK_POINTS * sizeof(s16)),
+                   "held block %d changed after resume", b);
+    }
+
+    /*恢复后输出的块没有被保留，采集放掉后下一个周期继续写这一块*/
+    mic_write_periods(cap, 2, period, resume + per_block, 1);
+    HOST_CHECK(mic_capture_overrun(cap) == dropped, "block put by the capture was not reused");
+
+    mic_view_put(&block_rec.held[0]);
+    mic_view_put(&block_rec.held[2]);
+    mic_capture_close(cap);
+}
+
+/*4.单mic周期正好一块时直接输出adc缓存*/
+static struct mic_view passthrough_view;
+static s16 *passthrough_data;
+static int passthrough_get;
+static int passthrough_calls;
+
+static void passthrough_output(void *priv, struct mic_view *view)
+{
+    passthrough_view = *view;
+    passthrough_get = mic_view_get(view);
+    passthrough_calls++;
+    HOST_CHECK(view->ch[0] == passthrough_data, "single mic view is a copy of the adc buffer");
+}
+
+static void test_single_mic(void)
+{
+    struct mic_capture_output outputs[2] = {
+        {passthrough_output, NULL, MIC_OUTPUT_PERIOD},
+        {passthrough_output, NULL, MIC_OUTPUT_BLOCK},
+    };
+
+    adc_stream_gen(STREAM_PERIODS * BLOCK_POINTS, 1);
+    struct mic_capture *cap = mic_capture_open(1, BLOCK_POINTS, 1);
+    mic_capture_add_output(cap, &outputs[0]);
+    mic_capture_add_output(cap, &outputs[1]);
+    for (int i = 0; i < STREAM_PERIODS; i++) {
+        passthrough_data = &adc_stream[i * BLOCK_POINTS];
+        mic_capture_write(cap, passthrough_data, BLOCK_POINTS);
+    }
+    HOST_CHECK(passthrough_calls == STREAM_PERIODS * 2, "single mic outputs %d", passthrough_calls);
+    HOST_CHECK(passthrough_view.block == NULL && passthrough_view.points == BLOCK_POINTS && passthrough_view.ch_num == 1,
+               "single mic view block %p points %d", passthrough_view.block, passthrough_view.points);
+    HOST_CHECK(passthrough_get == -EPERM, "mic_view_get on the adc buffer returned %d", passthrough_get);
+    /*直通不占块，一个块也不会丢*/
+    HOST_CHECK(mic_capture_overrun(cap) == 0, "single mic passthrough overrun %u", mic_capture_overrun(cap));
+    mic_capture_close(cap);
+
+    /*单mic小周期仍按块拷贝*/
+    test_period_split(1, 32);
+}
+
+static void test_open(void)
+{
+    struct mic_capture_output output = {mic_record_output, NULL, MIC_OUTPUT_BLOCK};
+
+    HOST_CHECK(mic_capture_open(0, BLOCK_POINTS, 2) == NULL, "open with 0 channels");
+    HOST_CHECK(mic_capture_open(MIC_CAPTURE_CH_MAX + 1, BLOCK_POINTS, 2) == NULL, "open with too many channels");
+    HOST_CHECK(mic_capture_open(2, 0, 2) == NULL, "open with 0 block points");
+    HOST_CHECK(mic_capture_open(2, BLOCK_POINTS, 0) == NULL, "open with 0 blocks");
+
+    struct mic_capture *cap = mic_capture_open(2, BLOCK_POINTS, 2);
+    for (int i = 0; i < MIC_CAPTURE_OUTPUT_MAX; i++) {
+        HOST_CHECK(mic_capture_add_output(cap, &output) == 0, "add output %d failed", i);
+    }
+    HOST_CHECK(mic_capture_add_output(cap, &output) == -1, "output beyond MIC_CAPTURE_OUTPUT_MAX added");
+    output.handler = NULL;
+    mic_capture_close(cap);
+    cap = mic_capture_open(2, BLOCK_POINTS, 2);
+    HOST_CHECK(mic_capture_add_output(cap, &output) == -1, "output without handler added");
+    mic_capture_close(cap);
+}
+
+/*5.双mic 32点周期：原路径和新路径每个周期的耗时*/
+static void mic_nop_output(void *priv, struct mic_view *view)
+{
+    __asm__ volatile("" :: "r"(view->ch[0]), "r"(view->ch[1]) : "memory");
+}
+
+static void bench(void)
+{
+    const int period = 32;
+    const int loops = 20000;
+    s16 adc_buf[PERIOD_POINTS_MAX * 2];
+    s16 tmp_buf[PERIOD_POINTS_MAX];
+    struct mic_capture_output outputs[2] = {
+        {mic_nop_output, NULL, MIC_OUTPUT_BLOCK},
+        {mic_nop_output, NULL, MIC_OUTPUT_PERIOD},
+    };
+    uint64_t t0, t_old, t_new;
+
+    adc_stream_gen(STREAM_PERIODS * period, 2);
+    old_reset();
+    old_frame_out = old_frame_nop;
+    t0 = host_bench_now();
+    for (int i = 0; i < loops; i++) {
+        memcpy(adc_buf, &adc_stream[(i % STREAM_PERIODS) * period * 2], period * 2 * sizeof(s16));
+        old_esco_handler(adc_buf, period * 2, tmp_buf);
+    }
+    t_old = host_bench_now() - t0;
+
+    struct mic_capture *cap = mic_capture_open(2, BLOCK_POINTS, 2);
+    mic_capture_add_output(cap, &outputs[0]);
+    mic_capture_add_output(cap, &outputs[1]);
+    t0 = host_bench_now();
+    for (int i = 0; i < loops; i++) {
+        memcpy(adc_buf, &adc_stream[(i % STREAM_PERIODS) * period * 2], period * 2 * sizeof(s16));
+        mic_capture_write(cap, adc_buf, period);
+    }
+    t_new = host_bench_now() - t0;
+    mic_capture_close(cap);
+
+    printf("mic capture bench (dual mic, %d point period, %d point block, adc copy included):\n", period, BLOCK_POINTS);
+    printf("  old tmp_buf/mic_data %7.1f %s/period\n", (double)t_old / loops, HOST_BENCH_UNIT);
+    printf("  mic_capture_write    %7.1f %s/period\n", (double)t_new / loops, HOST_BENCH_UNIT);
+}
+
+int main(void)
+{
+    test_open();
+    test_dual_mic_old_path();
+    test_period_split(2, 32);
+    test_period_split(2, 48);
+    test_period_split(2, 512);
+    test_overrun();
+    test_single_mic();
+    bench();
+    return host_test_result("mic_capture_test");
+}
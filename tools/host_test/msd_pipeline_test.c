@@ -0,0 +1,524 @@
+/*
+ * 读卡器READ_10/WRITE_10流水(apps/common/device/usb/device/msd.c)回放
+ * usb主机和SD卡都是PC上的模型：
+ *   主机按CBW/数据/CSW的顺序收发，检查CSW和读回的数据
+ *   SD卡异步模式同一时间只有一笔未完成的读写，下一次读写或IOCTL_FLUSH时才真正完成，
+ *   数据也在完成时才进出缓存(最晚完成，缓存块被提前复用时数据一定出错)
+ * 1.随机混合顺序读、随机读、写和其他命令，读回数据与参考镜像一致，写入后卡上数据一致，CSW状态为0
+ * 2.设备未完成的读写占用的缓存块，usb在完成前不会收发
+ * 3.整卡顺序读/写和4KB小块顺序读：统计每个扇区的设备命令数、ioctl数、预读命中，
+ *   按简单时序模型估算吞吐(usb和设备异步时重叠，数值只用于比较缓存块数)
+ * 同一程序以-DMSD_BUFFER_NUM=2编译(每组1块，即原来的乒乓缓存)作为对照
+ */
+#include "host_bench.h"
+#include "generic/typedef.h"
+#include "usb/scsi.h"
+#include "usb_std_class_def.h"
+
+#define TCFG_SD0_ENABLE			1
+
+#define DISK_SECTORS			4096
+#define USB_SECTOR_US			450.0	/*全速bulk传512byte*/
+#define USB_PKT_US				30.0	/*CBW/CSW*/
+#define DEV_CMD_US				300.0	/*SD卡单条多扇区命令的固定开销*/
+#define DEV_SECTOR_US			60.0
+#define DEV_IOCTL_US			3.0
+
+enum {
+    IOCTL_GET_STATUS = 1,
+    IOCTL_GET_CAPACITY,
+    IOCTL_GET_BLOCK_SIZE,
+    IOCTL_SET_ASYNC_MODE,
+    IOCTL_FLUSH,
+    IOCTL_CMD_RESUME,
+    IOCTL_CMD_SUSPEND,
+    IOCTL_POWER_RESUME,
+    IOCTL_POWER_SUSPEND,
+};
+
+/*与usb/device/msd.h、usb_stack.h中用到的部分一致，msd.c按指针宽度编译u32，回调参数用unsigned long*/
+typedef u8 usb_dev;
+#define MAX_MSD_DEV				2
+#define MSD_DEV_NAME_LEN		12
+
+struct usb_device_t {
+    u8 baddr;
+};
+
+struct usb_ctrlrequest {
+    u8 bRequestType;
+    u8 bRequest;
+    u16 wValue;
+    u16 wIndex;
+    u16 wLength;
+};
+
+struct msd_info {
+    u8 bError;
+    u8 bSenseKey;
+    u8 bAdditionalSenseCode;
+    u8 bAddiSenseCodeQualifier;
+    u8 bDisk_popup[MAX_MSD_DEV];
+    void *dev_handle[MAX_MSD_DEV];
+    char dev_name[MAX_MSD_DEV][MSD_DEV_NAME_LEN];
+    void (*msd_wakeup_handle)(struct usb_device_t *usb_device);
+    void (*msd_reset_wakeup_handle)(struct usb_device_t *usb_device, unsigned long itf_num);
+};
+
+#define USB_DT_INTERFACE_SIZE	9
+#define USB_DT_INTERFACE		4
+#define USB_DT_ENDPOINT_SIZE	7
+#define USB_DT_ENDPOINT			5
+#define USB_CLASS_MASS_STORAGE	8
+#define USB_DIR_IN				0x80
+#define USB_ENDPOINT_XFER_BULK	2
+#define USB_TYPE_MASK			(0x03 << 5)
+#define USB_TYPE_STANDARD		(0x00 << 5)
+#define USB_TYPE_CLASS			(0x01 << 5)
+#define USB_REQ_GET_STATUS		0x00
+#define USB_REQ_GET_INTERFACE	0x0a
+#define USB_REQ_SET_INTERFACE	0x0b
+#define USB_EP0_STAGE_SETUP		0
+#define TXCSRP_SendStall		BIT(5)
+#define RXCSRP_SendStall		BIT(5)
+#define DISCONN_MODE			0
+#define LOBYTE(x)				((u8)(x))
+#define HIBYTE(x)				((u8)((x) >> 8))
+
+#define min(a, b)				MIN(a, b)
+#define ASSERT(x, ...)			do { if (!(x)) { printf("ASSERT %s\n", #x); exit(1); } } while (0)
+#define log_debug(...)
+#define log_info(...)
+#define log_error(...)
+#define wdt_clear()
+
+static u32 cpu_to_be32(u32 v)
+{
+    return __builtin_bswap32(v);
+}
+
+int printf_lite(const char *format, ...)
+{
+    return 0;
+}
+
+/*-------------------------------SD卡模型-------------------------------*/
+struct dev_op {
+    u8 write;
+    u8 *buf;
+    u32 lba;
+    u32 num;
+};
+
+static struct {
+    u8 data[DISK_SECTORS * 512];
+    u8 async;
+    u8 busy;            /*有未完成的异步读写*/
+    struct dev_op op;
+    double busy_until;
+    u32 cmds;
+    u32 ioctls;
+    u32 sectors;
+} disk;
+
+/*主机时序模型，单位us*/
+static double sim_now;
+
+static void dev_op_run(const struct dev_op *op)
+{
+    if (op->write) {
+        memcpy(disk.data + op->lba * 512, op->buf, op->num * 512);
+    } else {
+        memcpy(op->buf, disk.data + op->lba * 512, op->num * 512);
+    }
+}
+
+/*等待未完成的异步读写*/
+static void dev_wait(void)
+{
+    if (disk.busy) {
+        dev_op_run(&disk.op);
+        disk.busy = 0;
+    }
+    if (sim_now < disk.busy_until) {
+        sim_now = disk.busy_until;
+    }
+}
+
+static u32 dev_bulk_rw(void *fd, u8 write, void *buf, u32 lba, u32 num)
+{
+    struct dev_op op = {write, buf, lba, num};
+
+    dev_wait();
+    if (lba + num > DISK_SECTORS) {
+        return 0;
+    }
+    disk.cmds++;
+    disk.sectors += num;
+    if (disk.async) {
+        disk.async = 0;
+        disk.op = op;
+        disk.busy = 1;
+        disk.busy_until = sim_now + DEV_CMD_US + num * DEV_SECTOR_US;
+    } else {
+        dev_op_run(&op);
+        sim_now += DEV_CMD_US + num * DEV_SECTOR_US;
+    }
+    return num;
+}
+
+static u32 dev_bulk_read(void *fd, void *buf, u32 lba, u32 num)
+{
+    return dev_bulk_rw(fd, 0, buf, lba, num);
+}
+
+static u32 dev_bulk_write(void *fd, void *buf, u32 lba, u32 num)
+{
+    return dev_bulk_rw(fd, 1, buf, lba, num);
+}
+
+/*msd.c里把u32当成指针宽度，arg是unsigned long*/
+static int dev_ioctl(void *fd, int cmd, unsigned long arg)
+{
+    disk.ioctls++;
+    sim_now += DEV_IOCTL_US;
+    switch (cmd) {
+    case IOCTL_GET_STATUS:
+        *(unsigned long *)arg = 1;
+        break;
+    case IOCTL_GET_CAPACITY:
+        *(unsigned long *)arg = DISK_SECTORS;
+        break;
+    case IOCTL_GET_BLOCK_SIZE:
+        *(unsigned long *)arg = 512;
+        break;
+    case IOCTL_SET_ASYNC_MODE:
+        disk.async = 1;
+        break;
+    case IOCTL_FLUSH:
+        dev_wait();
+        break;
+    }
+    return 0;
+}
+
+static void *dev_open(const char *name, void *arg)
+{
+    return &disk;
+}
+
+static int dev_close(void *fd)
+{
+    return 0;
+}
+
+/*-------------------------------usb主机模型-------------------------------*/
+static struct {
+    u8 out[256 * 512 + 64];     /*主机发出：CBW+写数据*/
+    u32 out_len;
+    u32 out_pos;
+    u8 in[256 * 512 + 64];      /*主机收到：读数据+CSW*/
+    u32 in_len;
+    u32 owned_fail;
+} usb;
+
+/*设备未完成的读写占用的缓存块，usb不能碰*/
+static void usb_check_owned(const u8 *buf, u32 len)
+{
+    if (disk.busy && (buf < disk.op.buf + disk.op.num * 512) && (disk.op.buf < buf + len)) {
+        usb.owned_fail++;
+    }
+}
+
+static u32 usb_out_read(u8 *buf, u32 len)
+{
+    len = MIN(len, usb.out_len - usb.out_pos);
+    usb_check_owned(buf, len);
+    memcpy(buf, usb.out + usb.out_pos, len);
+    usb.out_pos += len;
+    sim_now += len >= 512 ? len / 512 * USB_SECTOR_US : USB_PKT_US;
+    return len;
+}
+
+static u32 usb_g_bulk_read(const usb_dev id, u32 ep, void *buf, u32 len, u32 block)
+{
+    return usb_out_read(buf, len);
+}
+
+static u32 usb_g_bulk_read64byte_fast(const usb_dev id, u32 ep, void *buf, u32 len)
+{
+    return usb_out_read(buf, len);
+}
+
+static u32 usb_g_bulk_write(const usb_dev id, u32 ep, const void *buf, u32 len)
+{
+    usb_check_owned(buf, len);
+    memcpy(usb.in + usb.in_len, buf, len);
+    usb.in_len += len;
+    sim_now += len >= 512 ? len / 512 * USB_SECTOR_US : USB_PKT_US;
+    return len;
+}
+
+static struct usb_device_t usb_device;
+static u8 ep_dmabuffer[MAXP_SIZE_BULKIN + MAXP_SIZE_BULKOUT];
+static const usb_dev usb_device2id(const struct usb_device_t *dev)
+{
+    return 0;
+}
+static void usb_g_ep_config(usb_dev id, u32 ep, u32 type, u32 ie, u8 *buf, u32 len)
+{
+}
+static void usb_g_set_intr_hander(usb_dev id, u32 ep, void (*h)(struct usb_device_t *, unsigned long))
+{
+}
+static void usb_enable_ep(usb_dev id, u32 ep)
+{
+}
+static void usb_disable_ep(usb_dev id, u32 ep)
+{
+}
+static u8 *usb_get_setup_buffer(const struct usb_device_t *dev)
+{
+    return ep_dmabuffer;
+}
+static void usb_set_setup_phase(struct usb_device_t *dev, u8 phase)
+{
+}
+static void usb_set_data_payload(struct usb_device_t *dev, struct usb_ctrlrequest *req, const void *data, u32 len)
+{
+}
+static u32 usb_set_interface_hander(usb_dev id, u32 itf, unsigned long(*h)(struct usb_device_t *, struct usb_ctrlrequest *))
+{
+    return itf;
+}
+static u32 usb_set_reset_hander(usb_dev id, u32 itf, void (*h)(struct usb_device_t *, unsigned long))
+{
+    return itf;
+}
+static void usb_write_txcsr(usb_dev id, u32 ep, u32 v)
+{
+}
+static u32 usb_read_txcsr(usb_dev id, u32 ep)
+{
+    return 0;
+}
+static void usb_write_rxcsr(usb_dev id, u32 ep, u32 v)
+{
+}
+static u32 usb_read_rxcsr(usb_dev id, u32 ep)
+{
+    return 0;
+}
+static u32 usb_otg_online(usb_dev id)
+{
+    return 1;
+}
+static void usb_clr_intr_rxe(usb_dev id, u32 ep)
+{
+}
+static void usb_set_intr_rxe(usb_dev id, u32 ep)
+{
+}
+static u8 *usb_alloc_ep_dmabuffer(usb_dev id, u32 ep, u32 len)
+{
+    return ep_dmabuffer;
+}
+static u32 kugou_scsi_cmd(const struct usb_device_t *usb_device, struct usb_scsi_cbw *cbw)
+{
+    return 0;
+}
+
+#include "../../apps/common/device/usb/device/msd.c"
+
+u32 private_scsi_cmd(const struct usb_device_t *usb_device, struct usb_scsi_cbw *cbw)
+{
+    return 0;
+}
+#undef u32
+
+/*-------------------------------回放-------------------------------*/
+static u8 ref[DISK_SECTORS * 512];
+
+struct replay_stat {
+    u32 cmds;
+    u32 sectors;
+    u32 ra_hit;
+};
+
+static void fill_random(u8 *buf, u32 len)
+{
+    for (u32 i = 0; i < len; i++) {
+        buf[i] = host_rand() >> 24;
+    }
+}
+
+/*发一条命令，返回CSW状态，读到的数据在usb.in*/
+static int scsi_cmd(u8 op, u32 lba, u16 num, struct replay_stat *st)
+{
+    struct usb_scsi_cbw cbw;
+    struct usb_scsi_csw csw;
+    u32 data_len = 0;
+    u8 dir_in = 1;
+
+    memset(&cbw, 0, sizeof(cbw));
+    cbw.dCBWSignature = CBW_SIGNATURE;
+    cbw.dCBWTag = host_rand();
+    cbw.operationCode = op;
+    cbw.lba[0] = lba >> 24;
+    cbw.lba[1] = lba >> 16;
+    cbw.lba[2] = lba >> 8;
+    cbw.lba[3] = lba;
+    cbw.LengthH = num >> 8;
+    cbw.LengthL = num;
+    switch (op) {
+    case READ_10:
+        data_len = num * 512;
+        if (msd_handle->ra.num && msd_handle->ra.lba == lba) {
+            st->ra_hit++;
+        }
+        break;
+    case WRITE_10:
+        data_len = num * 512;
+        dir_in = 0;
+        break;
+    case READ_CAPACITY:
+        data_len = 8;
+        break;
+    }
+    cbw.dCBWDataTransferLength = data_len;
+    cbw.bmCBWFlags = dir_in ? 0x80 : 0;
+    cbw.bCBWLength = 10;
+
+    memcpy(usb.out, &cbw, sizeof(cbw));
+    usb.out_len = sizeof(cbw);
+    usb.out_pos = 0;
+    if (op == WRITE_10) {
+        memcpy(usb.out + usb.out_len, ref + lba * 512, data_len);
+        usb.out_len += data_len;
+    }
+    usb.in_len = 0;
+
+    USB_MassStorage(&usb_device);
+
+    HOST_CHECK(usb.out_pos == usb.out_len, "op %x lba %d num %d: host data left %d", op, lba, num, usb.out_len - usb.out_pos);
+    if (!dir_in) {
+        data_len = 0;
+    }
+    if (usb.in_len != data_len + sizeof(csw)) {
+        HOST_CHECK(0, "op %x lba %d num %d: in len %d, expect %d", op, lba, num, usb.in_len, data_len + (u32)sizeof(csw));
+        return -1;
+    }
+    memcpy(&csw, usb.in + data_len, sizeof(csw));
+    HOST_CHECK(csw.dCSWSignature == CSW_SIGNATURE && csw.dCSWTag == cbw.dCBWTag, "op %x bad csw", op);
+    HOST_CHECK(csw.uCSWDataResidue == 0, "op %x lba %d num %d: residue %d", op, lba, num, csw.uCSWDataResidue);
+    if (op == READ_10 || op == WRITE_10) {
+        st->cmds++;
+        st->sectors += num;
+    }
+    return csw.bCSWStatus;
+}
+
+static void check_read(u32 lba, u16 num, struct replay_stat *st)
+{
+    int status = scsi_cmd(READ_10, lba, num, st);
+
+    HOST_CHECK(status == 0, "read lba %d num %d status %d", lba, num, status);
+    HOST_CHECK(memcmp(usb.in, ref + lba * 512, num * 512) == 0, "read lba %d num %d data differs", lba, num);
+}
+
+static void check_write(u32 lba, u16 num, struct replay_stat *st)
+{
+    fill_random(ref + lba * 512, num * 512);
+    int status = scsi_cmd(WRITE_10, lba, num, st);
+
+    HOST_CHECK(status == 0, "write lba %d num %d status %d", lba, num, status);
+    HOST_CHECK(!disk.busy, "write lba %d num %d not flushed", lba, num);
+    HOST_CHECK(memcmp(disk.data + lba * 512, ref + lba * 512, num * 512) == 0, "write lba %d num %d disk differs", lba, num);
+}
+
+static u32 be32_to_host(const u8 *p)
+{
+    return ((u32)p[0] << 24) | ((u32)p[1] << 16) | ((u32)p[2] << 8) | p[3];
+}
+
+static u16 rand_num(u32 lba)
+{
+    static const u16 sizes[] = {1, 2, 3, 7, 8, 16, 31, 64, 128, 255};
+    u16 num = sizes[host_rand() % ARRAY_SIZE(sizes)];
+
+    return MIN(num, DISK_SECTORS - lba);
+}
+
+static void test_random(int rounds)
+{
+    struct replay_stat st = {0};
+
+    for (int r = 0; r < rounds && !host_test_fail; r++) {
+        u32 sel = host_rand() % 10;
+        u32 lba = host_rand() % DISK_SECTORS;
+        u16 num;
+
+        if ((host_rand() & 15) == 0) {
+            lba = DISK_SECTORS - 1 - host_rand() % 16;      /*预读碰到卡尾*/
+        }
+        num = rand_num(lba);
+        if (sel < 5) {
+            int runs = 1 + host_rand() % 8;
+            while (runs-- && lba + num <= DISK_SECTORS) {
+                check_read(lba, num, &st);
+                lba += num;
+            }
+        } else if (sel < 7) {
+            check_read(lba, num, &st);
+        } else if (sel < 9) {
+            check_write(lba, num, &st);
+        } else if (host_rand() & 1) {
+            HOST_CHECK(scsi_cmd(TEST_UNIT_READY, 0, 0, &st) == 0, "test unit ready failed");
+        } else {
+            HOST_CHECK(scsi_cmd(READ_CAPACITY, 0, 0, &st) == 0, "read capacity failed");
+            HOST_CHECK(be32_to_host(usb.in) == DISK_SECTORS - 1, "capacity %d", be32_to_host(usb.in));
+        }
+        HOST_CHECK(usb.owned_fail == 0, "round %d: usb touched %d slots owned by device", r, usb.owned_fail);
+    }
+    printf("random replay: %d commands %d sectors, read ahead hit %d\n", st.cmds, st.sectors, st.ra_hit);
+}
+
+static void run_seq(const char *name, u8 op, u16 num)
+{
+    struct replay_stat st = {0};
+    u32 cmds = disk.cmds, ioctls = disk.ioctls;
+    double t0 = sim_now;
+
+    for (u32 lba = 0; lba + num <= DISK_SECTORS; lba += num) {
+        if (op == READ_10) {
+            check_read(lba, num, &st);
+        } else {
+            check_write(lba, num, &st);
+        }
+    }
+    printf("  %-16s dev cmd %.3f ioctl %.2f /sector, read ahead hit %4d, model %5.0f KB/s\n",
+           name, (double)(disk.cmds - cmds) / st.sectors, (double)(disk.ioctls - ioctls) / st.sectors,
+           st.ra_hit, st.sectors * 0.5 / ((sim_now - t0) / 1e6));
+}
+
+int main(void)
+{
+    fill_random(disk.data, sizeof(disk.data));
+    memcpy(ref, disk.data, sizeof(ref));
+    msd_register(0);
+    msd_register_disk("sd0", NULL);
+
+    test_random(20000);
+
+    printf("sequential (MSD_BUFFER_NUM %d, %d sectors per device command):\n", MSD_BUFFER_NUM, MSD_GROUP_BLOCKS);
+    run_seq("read 64KB/cmd", READ_10, 128);
+    run_seq("read 4KB/cmd", READ_10, 8);
+    run_seq("write 64KB/cmd", WRITE_10, 128);
+    run_seq("write 4KB/cmd", WRITE_10, 8);
+    HOST_CHECK(usb.owned_fail == 0, "usb touched %d slots owned by device", usb.owned_fail);
+
+    msd_release();
+    char name[32];
+    sprintf(name, "msd_pipeline_test(%d)", MSD_BUFFER_NUM);
+    return host_test_result(name);
+}
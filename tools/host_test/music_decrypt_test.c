@@ -0,0 +1,163 @@
+/*
+ * 加密文件解密(music_decrypt.c cryptanalysis_buff)对比和耗时测试
+ * 1.随机文件偏移、长度、buf地址对齐，与逐字节参考(偏移faddr处异或密钥第faddr%4字节)一致，
+ *   含长度小于头部未对齐字节数的短读
+ * 2.同一段数据按随机长度分多次读，与一次读解密结果一致，再加密一次还原明文
+ * 3.不触发短读时与原逐字节实现一致
+ * 4.统计原实现和整字实现每个字节的耗时
+ */
+#include "host_bench.h"
+#include "../../apps/common/music/music_decrypt.c"
+
+#define TEST_BYTES_MAX		4096
+
+/*逐字节参考：与文件偏移对应的密钥字节(小端)异或*/
+static void ref_decrypt(u32 key, u8 *buf, u32 faddr, u32 len)
+{
+    for (u32 i = 0; i < len; i++) {
+        buf[i] ^= (u8)(key >> (((faddr + i) % 4) * 8));
+    }
+}
+
+/*原cryptanalysis_buff，len小于头部未对齐字节数时用错了密钥字节*/
+static void legacy_cryptanalysis_buff(CIPHER *pcipher, void *buf, u32 faddr, u32 len)
+{
+    u32 i;
+    u8 j;
+    u8	head_rem;
+    u8  tail_rem;
+    u32 len_ali;
+    u8  *buf_1b_ali;
+    u8  *cipher_code = (u8 *)&pcipher->cipher_code;
+
+    if (!pcipher->cipher_enable) {
+        return;
+    }
+    head_rem = ALIN_SIZE - (faddr % ALIN_SIZE);
+    if (head_rem == ALIN_SIZE) {
+        head_rem = 0;
+    }
+    if (head_rem > len) {
+        head_rem = len;
+    }
+    if (len - head_rem) {
+        tail_rem = (faddr + len) % ALIN_SIZE;
+    } else {
+        tail_rem = 0;
+    }
+    buf_1b_ali = buf;
+    j = 3;
+    for (i = head_rem; i > 0; i--) {
+        buf_1b_ali[i - 1] ^= cipher_code[j--];
+    }
+    buf_1b_ali = (u8 *)buf + head_rem;
+    len_ali = len - head_rem - tail_rem;
+    for (i = 0; i < (len_ali / 4); i++) {
+        buf_1b_ali[0 + i * 4] ^= cipher_code[0];
+        buf_1b_ali[1 + i * 4] ^= cipher_code[1];
+        buf_1b_ali[2 + i * 4] ^= cipher_code[2];
+        buf_1b_ali[3 + i * 4] ^= cipher_code[3];
+    }
+    buf_1b_ali = (u8 *)buf + len - tail_rem;
+    j = 0;
+    for (i = 0 ; i < tail_rem; i++) {
+        buf_1b_ali[i] ^= cipher_code[j++];
+    }
+}
+
+static void fill_random(u8 *buf, u32 len)
+{
+    for (u32 i = 0; i < len; i++) {
+        buf[i] = host_rand() >> 24;
+    }
+}
+
+static void test_random(int rounds)
+{
+    static u8 buf[TEST_BYTES_MAX + 8], ref[TEST_BYTES_MAX + 8], old[TEST_BYTES_MAX + 8];
+    CIPHER cipher;
+
+    for (int r = 0; r < rounds; r++) {
+        cipher_init(&cipher, host_rand());
+        cipher.cipher_enable = 1;
+        u32 faddr = host_rand() % 100000;
+        u32 len = (r & 3) ? host_rand() % 8 : host_rand() % TEST_BYTES_MAX;
+        u8 *p = buf + (host_rand() & 7);
+
+        fill_random(p, len);
+        memcpy(ref, p, len);
+        memcpy(old, p, len);
+        cryptanalysis_buff(&cipher, p, faddr, len);
+        ref_decrypt(cipher.cipher_code, ref, faddr, len);
+        HOST_CHECK(memcmp(p, ref, len) == 0, "faddr=%d len=%d align=%d differs",
+                   faddr, len, (int)((unsigned long)p & 7));
+
+        u32 head = (4 - faddr % 4) % 4;
+        if (len >= head) {
+            legacy_cryptanalysis_buff(&cipher, old, faddr, len);
+            HOST_CHECK(memcmp(old, ref, len) == 0, "legacy faddr=%d len=%d differs", faddr, len);
+        }
+        if (host_test_fail) {
+            return;
+        }
+    }
+}
+
+/*文件按随机长度分段读，每段用当前偏移解密*/
+static void test_stream(void)
+{
+    static u8 plain[TEST_BYTES_MAX * 4], data[TEST_BYTES_MAX * 4];
+    CIPHER cipher;
+    u32 faddr = 0;
+
+    cipher_init(&cipher, 0x5a3cc3a5);
+    cipher.cipher_enable = 1;
+    fill_random(plain, sizeof(plain));
+    memcpy(data, plain, sizeof(data));
+    ref_decrypt(cipher.cipher_code, data, 0, sizeof(data));
+    while (faddr < sizeof(data)) {
+        u32 len = MIN(1 + host_rand() % 700, sizeof(data) - faddr);
+        cryptanalysis_buff(&cipher, data + faddr, faddr, len);
+        faddr += len;
+    }
+    HOST_CHECK(memcmp(data, plain, sizeof(data)) == 0, "stream round trip differs");
+
+    cipher_close(&cipher);
+    cryptanalysis_buff(&cipher, data, 0, sizeof(data));
+    HOST_CHECK(memcmp(data, plain, sizeof(data)) == 0, "disabled cipher changed data");
+}
+
+static void bench(const char *name, u32 len, u32 faddr, u32 align)
+{
+    static u8 buf[TEST_BYTES_MAX + 8];
+    const int loops = 20000;
+    CIPHER cipher;
+    u64 t_old = 0, t_new = 0;
+
+    cipher_init(&cipher, 0x12345678);
+    cipher.cipher_enable = 1;
+    fill_random(buf, sizeof(buf));
+    for (int i = 0; i < loops; i++) {
+        u64 t0 = host_bench_now();
+        legacy_cryptanalysis_buff(&cipher, buf + align, faddr, len);
+        u64 t1 = host_bench_now();
+        cryptanalysis_buff(&cipher, buf + align, faddr, len);
+        u64 t2 = host_bench_now();
+        t_old += t1 - t0;
+        t_new += t2 - t1;
+    }
+    printf("  %-24s old %6.3f  new %6.3f %s/byte\n", name,
+           (double)t_old / loops / len, (double)t_new / loops / len, HOST_BENCH_UNIT);
+}
+
+int main(void)
+{
+    test_random(200000);
+    test_stream();
+
+    printf("decrypt bench:\n");
+    bench("4096B aligned", 4096, 0, 0);
+    bench("4096B faddr+1 buf+1", 4096, 1, 1);
+    bench("512B aligned", 512, 0, 0);
+    return host_test_result("music_decrypt_test");
+}
@@ -0,0 +1,376 @@
+/*
+ * id3标签解析(apps/common/music/music_id3.c id3_tag_parse/id3_tag_get)回放测试
+ * 1.内存里构造id3v2.2/2.3/2.4和id3v1标签，检查各字段(编码转换、空帧、APIC跳过、填充区)
+ * 2.损坏的帧大小：v2.3的32位帧大小0xFFFFFFF6(addr + 帧头 + size回绕成原地址)、
+ *   超出标签区的帧、超出标签区的扩展头、标签区比文件长，解析必须结束且保留已解析的字段
+ * 3.随机改写标签区字节，解析必须结束，不越界，文件读位置不变
+ * 4.带缓存的id3_tag_get第二次命中缓存不再读文件
+ * 解析卡死时由alarm结束进程，make run返回失败
+ */
+#include <unistd.h>
+#include "host_bench.h"
+#include "generic/typedef.h"
+
+/*内存文件，接口与固件fs.h同名同参数*/
+struct host_file {
+    const u8 *data;
+    u32 len;
+    u32 pos;
+    u32 sclust;
+    int reads;
+};
+
+struct vfs_attr {
+    u8 attr;
+    u32 fsize;
+    u32 sclust;
+};
+
+static int host_fseek(void *file, u32 offset, int orig)
+{
+    struct host_file *f = file;
+    f->pos = (orig == SEEK_END) ? f->len + offset : offset;
+    return 0;
+}
+
+static int host_fread(void *file, void *buf, u32 len)
+{
+    struct host_file *f = file;
+    u32 n = (f->pos < f->len) ? MIN(len, f->len - f->pos) : 0;
+    memcpy(buf, f->data + f->pos, n);
+    f->pos += n;
+    f->reads++;
+    return n;
+}
+
+static int fpos(void *file)
+{
+    return ((struct host_file *)file)->pos;
+}
+
+static int flen(void *file)
+{
+    return ((struct host_file *)file)->len;
+}
+
+static int fget_attrs(void *file, struct vfs_attr *attr)
+{
+    struct host_file *f = file;
+    attr->fsize = f->len;
+    attr->sclust = f->sclust;
+    return 0;
+}
+
+#define fseek(f, o, w)		host_fseek(f, o, w)
+#define fread(f, b, l)		host_fread(f, b, l)
+#define log_info(...)
+#define log_error(...)
+#define put_buf(...)
+
+#include "../../apps/common/music/music_id3.c"
+
+#define TAG_BYTES_MAX		4096
+
+struct tag_builder {
+    u8 buf[TAG_BYTES_MAX];
+    u32 len;
+    u8 ver;
+};
+
+static void tag_begin(struct tag_builder *t, u8 ver)
+{
+    memset(t, 0, sizeof(*t));
+    memcpy(t->buf, "ID3", 3);
+    t->buf[3] = ver;
+    t->len = ID3_V2_HEADER_SIZE;
+    t->ver = ver;
+}
+
+static void put_syncsafe(u8 *p, u32 v)
+{
+    p[0] = (v >> 21) & 0x7f;
+    p[1] = (v >> 14) & 0x7f;
+    p[2] = (v >> 7) & 0x7f;
+    p[3] = v & 0x7f;
+}
+
+/*size_override非0时写入的帧大小用它代替真实长度*/
+static void tag_frame_raw(struct tag_builder *t, const char *id, const void *dat, u32 len, u32 size_override, u8 flags)
+{
+    u8 *p = t->buf + t->len;
+    u32 size = size_override ? size_override : len;
+
+    if (t->ver == 2) {
+        memcpy(p, id, 3);
+        p[3] = size >> 16;
+        p[4] = size >> 8;
+        p[5] = size;
+        t->len += ID3_V22_FRAME_SIZE;
+    } else {
+        memcpy(p, id, 4);
+        if (t->ver == 4) {
+            put_syncsafe(p + 4, size);
+        } else {
+            p[4] = size >> 24;
+            p[5] = size >> 16;
+            p[6] = size >> 8;
+            p[7] = size;
+        }
+        p[8] = 0;
+        p[9] = flags;
+        t->len += ID3_V2_FRAME_SIZE;
+    }
+    memcpy(t->buf + t->len, dat, len);
+    t->len += len;
+}
+
+/*enc:0 ISO-8859-1, 3 utf8，文本按原样写入*/
+static void tag_text(struct tag_builder *t, const char *id, u8 enc, const char *text)
+{
+    u8 dat[256];
+    u32 len = strlen(text);
+
+    dat[0] = enc;
+    memcpy(dat + 1, text, len);
+    tag_frame_raw(t, id, dat, len + 1, 0, 0);
+}
+
+/*带BOM的小端utf16*/
+static void tag_text_utf16(struct tag_builder *t, const char *id, const u16 *text, u32 chars)
+{
+    u8 dat[256];
+
+    dat[0] = 1;
+    dat[1] = 0xff;
+    dat[2] = 0xfe;
+    for (u32 i = 0; i < chars; i++) {
+        dat[3 + i * 2] = text[i];
+        dat[4 + i * 2] = text[i] >> 8;
+    }
+    tag_frame_raw(t, id, dat, 3 + chars * 2, 0, 0);
+}
+
+/*写标签头里的标签大小，padding为帧后面的填充字节数*/
+static void tag_end(struct tag_builder *t, u32 padding)
+{
+    memset(t->buf + t->len, 0, padding);
+    t->len += padding;
+    put_syncsafe(t->buf + 6, t->len - ID3_V2_HEADER_SIZE);
+}
+
+static int parse(const u8 *data, u32 len, u32 start_pos, ID3_TAG_INFO *info, struct host_file *f)
+{
+    f->data = data;
+    f->len = len;
+    f->pos = start_pos;
+    f->reads = 0;
+    int err = id3_tag_parse(f, info);
+    HOST_CHECK(f->pos == start_pos, "file position %u not restored (%u)", f->pos, start_pos);
+    return err;
+}
+
+static void test_v23(void)
+{
+    static struct tag_builder t;
+    static const u16 artist[] = {0x5468, 0x4e50, 'A', 0xd83c, 0xdfb5}; //"周乐A🎵"的utf16
+    static u8 apic[3000];
+    ID3_TAG_INFO info;
+    struct host_file f;
+
+    tag_begin(&t, 3);
+    tag_frame_raw(&t, "APIC", apic, sizeof(apic), 0, 0);	//比读缓存大，直接跳过
+    tag_frame_raw(&t, "TXXX", "", 0, 0, 0);			//空帧
+    tag_text(&t, "TIT2", 0, "Title 23");
+    tag_text_utf16(&t, "TPE1", artist, ARRAY_SIZE(artist));
+    tag_text(&t, "TALB", 3, "Album \xe4\xb8\x93\xe8\xbe\x91");
+    tag_text(&t, "TYER", 0, "1999");
+    tag_text(&t, "TCON", 0, "(13)");
+    tag_end(&t, 100);
+
+    HOST_CHECK(parse(t.buf, t.len, 123, &info, &f) == 0, "v2.3 parse failed");
+    HOST_CHECK(info.ver == 3, "v2.3 ver %d", info.ver);
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_TITLE], "Title 23"), "v2.3 title '%s'", info.text[ID3_TAG_TITLE]);
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_ARTIST], "\xe5\x91\xa8\xe4\xb9\x90" "A\xf0\x9f\x8e\xb5"),
+               "v2.3 utf16 artist '%s'", info.text[ID3_TAG_ARTIST]);
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_ALBUM], "Album \xe4\xb8\x93\xe8\xbe\x91"), "v2.3 album '%s'", info.text[ID3_TAG_ALBUM]);
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_YEAR], "1999"), "v2.3 year '%s'", info.text[ID3_TAG_YEAR]);
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_GENRE], "(13)"), "v2.3 genre '%s'", info.text[ID3_TAG_GENRE]);
+    HOST_CHECK(info.local_mask == (BIT(ID3_TAG_TITLE) | BIT(ID3_TAG_YEAR) | BIT(ID3_TAG_GENRE)),
+               "v2.3 local mask %02x", info.local_mask);
+}
+
+static void test_v24_v22(void)
+{
+    static struct tag_builder t;
+    u8 dli[] = {0, 0, 0, 6, 3, 'T', 'i', 't', 'l', 'e'};	//带数据长度指示的帧
+    ID3_TAG_INFO info;
+    struct host_file f;
+
+    tag_begin(&t, 4);
+    tag_frame_raw(&t, "TIT2", dli, sizeof(dli), 0, 0x01);
+    tag_text(&t, "TDRC", 3, "2024-05-01");
+    tag_frame_raw(&t, "TPE1", "\x03secret", 7, 0, 0x04);	//加密帧不解析
+    tag_text(&t, "TALB", 3, "\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91"
+             "\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91"
+             "\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91"
+             "\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91"
+             "\xe4\xb8\x93\xe8\xbe\x91\xe4\xb8\x93\xe8\xbe\x91");	//超长截断在完整的utf8字符处
+    tag_end(&t, 0);
+
+    HOST_CHECK(parse(t.buf, t.len, 0, &info, &f) == 0 && info.ver == 4, "v2.4 parse failed");
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_TITLE], "Title"), "v2.4 title '%s'", info.text[ID3_TAG_TITLE]);
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_YEAR], "2024-05-01"), "v2.4 TDRC '%s'", info.text[ID3_TAG_YEAR]);
+    HOST_CHECK(!info.text[ID3_TAG_ARTIST][0], "v2.4 encrypted frame parsed");
+    u32 album_len = strlen(info.text[ID3_TAG_ALBUM]);
+    HOST_CHECK(album_len >= ID3_TAG_TEXT_LEN - 4 && (album_len % 3) == 0, "v2.4 truncated album length %d", album_len);
+
+    tag_begin(&t, 2);
+    tag_text(&t, "TT2", 0, "Old");
+    tag_text(&t, "TP1", 0, "Artist");
+    tag_end(&t, 10);
+    HOST_CHECK(parse(t.buf, t.len, 0, &info, &f) == 0 && info.ver == 2, "v2.2 parse failed");
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_TITLE], "Old") && !strcmp(info.text[ID3_TAG_ARTIST], "Artist"),
+               "v2.2 '%s' '%s'", info.text[ID3_TAG_TITLE], info.text[ID3_TAG_ARTIST]);
+}
+
+static void test_v1(void)
+{
+    static u8 file[1000];
+    struct id3_v1_hdl *hdl = (struct id3_v1_hdl *)(file + sizeof(file) - ID3_V1_HEADER_SIZE);
+    ID3_TAG_INFO info;
+    struct host_file f;
+
+    memset(file, 0, sizeof(file));
+    memcpy(hdl->header, "TAG", 3);
+    memcpy(hdl->title, "V1 Title  ", 10);
+    memcpy(hdl->artist, "V1 Artist", 9);
+    memcpy(hdl->year, "2001", 4);
+    hdl->genre = 17;
+    HOST_CHECK(parse(file, sizeof(file), 500, &info, &f) == 0 && info.ver == 1, "v1 parse failed");
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_TITLE], "V1 Title") && !strcmp(info.text[ID3_TAG_ARTIST], "V1 Artist"),
+               "v1 '%s' '%s'", info.text[ID3_TAG_TITLE], info.text[ID3_TAG_ARTIST]);
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_GENRE], "17"), "v1 genre '%s'", info.text[ID3_TAG_GENRE]);
+
+    memset(hdl, 0, ID3_V1_HEADER_SIZE);
+    HOST_CHECK(parse(file, sizeof(file), 0, &info, &f) != 0 && info.ver == 0, "file without tag parsed");
+}
+
+/*损坏的帧大小/扩展头/标签大小：解析结束，保留前面的字段*/
+static void test_corrupt(void)
+{
+    static struct tag_builder t;
+    ID3_TAG_INFO info;
+    struct host_file f;
+
+    /*0xFFFFFFF6 + 帧头10字节回绕成0，旧实现addr不变一直循环*/
+    tag_begin(&t, 3);
+    tag_text(&t, "TIT2", 0, "Before");
+    tag_frame_raw(&t, "TPE1", "\0Never", 7, 0xFFFFFFF6, 0);
+    tag_text(&t, "TALB", 0, "After");
+    tag_end(&t, 20);
+    HOST_CHECK(parse(t.buf, t.len, 0, &info, &f) == 0 && info.ver == 3, "v2.3 wrap size parse failed");
+    HOST_CHECK(!strcmp(info.text[ID3_TAG_TITLE], "Before"), "v2.3 wrap size title '%s'", info.text[ID3_TAG_TITLE]);
+    HOST_CHECK(!info.text[ID3_TAG_ARTIST][0] && !info.text[ID3_TAG_ALBUM][0], "v2.3 wrap size read past the bad frame");
+
+    /*其他回绕到标签区内的大小*/
+    u32 wrap[] = {0xFFFFFFFF, 0xFFFFFFF0, 0xFFFFFF00, 0x80000000, 0x7FFFFFFF};
+    for (int i = 0; i < ARRAY_SIZE(wrap); i++) {
+        tag_begin(&t, 3);
+        tag_text(&t, "TIT2", 0, "Before");
+        tag_frame_raw(&t, "TPE1", "\0Never", 7, wrap[i], 0);
+        tag_end(&t, 0);
+        HOST_CHECK(parse(t.buf, t.len, 0, &info, &f) == 0 && !strcmp(info.text[ID3_TAG_TITLE], "Before")
+                   && !info.text[ID3_TAG_ARTIST][0], "v2.3 size %08x", wrap[i]);
+    }
+
+    /*帧大小刚好超出标签区1字节*/
+    tag_begin(&t, 4);
+    tag_text(&t, "TIT2", 3, "Ok");
+    tag_frame_raw(&t, "TPE1", "\0Cut", 4, 5, 0);
+    tag_end(&t, 0);
+    HOST_CHECK(parse(t.buf, t.len, 0, &info, &f) == 0 && !strcmp(info.text[ID3_TAG_TITLE], "Ok")
+               && !info.text[ID3_TAG_ARTIST][0], "v2.4 frame past tag end parsed");
+
+    /*v2.3扩展头大小超出标签区，按无效id3v2处理，回退到id3v1(这里没有)*/
+    tag_begin(&t, 3);
+    t.buf[5] = 0x40;
+    memcpy(t.buf + t.len, "\xff\xff\xff\xf0", 4);
+    t.len += 4;
+    tag_text(&t, "TIT2", 0, "Ext");
+    tag_end(&t, 0);
+    HOST_CHECK(parse(t.buf, t.len, 0, &info, &f) != 0 && !info.text[ID3_TAG_TITLE][0], "bad extended header parsed");
+
+    /*标签头里的大小比文件长：读到文件尾结束*/
+    tag_begin(&t, 3);
+    tag_text(&t, "TIT2", 0, "Short file");
+    tag_text(&t, "TPE1", 0, "Cut by eof");
+    tag_end(&t, 0);
+    put_syncsafe(t.buf + 6, 0x0fffffff);
+    HOST_CHECK(parse(t.buf, t.len - 4, 0, &info, &f) == 0 && !strcmp(info.text[ID3_TAG_TITLE], "Short file"),
+               "tag longer than file '%s'", info.text[ID3_TAG_TITLE]);
+}
+
+/*随机改写帧头和数据：只要求解析结束、字符串有结束符*/
+static void test_fuzz(int rounds)
+{
+    static struct tag_builder base, t;
+    static u8 file[TAG_BYTES_MAX + ID3_V1_HEADER_SIZE];
+    ID3_TAG_INFO info;
+    struct host_file f;
+
+    for (int r = 0; r < rounds; r++) {
+        u8 ver = 2 + r % 3;
+        tag_begin(&base, ver);
+        for (int i = 0; i < 8; i++) {
+            tag_text(&base, ID3_V2_FRAME_ID[ver != 2][host_rand() % ID3_TAG_FIELD_NUM], host_rand() & 3,
+                     "0123456789abcdefghijklmnopqrstuvwxyz0123456789");
+        }
+        tag_end(&base, host_rand() % 64);
+        t = base;
+        for (int n = 1 + host_rand() % 8; n; n--) {
+            u32 i = ID3_V2_HEADER_SIZE + host_rand() % (t.len - ID3_V2_HEADER_SIZE);
+            t.buf[i] = (host_rand() & 1) ? 0xff : host_rand();
+        }
+        u32 len = (r & 7) ? t.len : host_rand() % t.len;
+        memcpy(file, t.buf, len);
+        parse(file, len, 0, &info, &f);
+        for (int i = 0; i < ID3_TAG_FIELD_NUM; i++) {
+            HOST_CHECK(memchr(info.text[i], 0, ID3_TAG_TEXT_LEN), "round %d field %d not terminated", r, i);
+        }
+        if (host_test_fail) {
+            return;
+        }
+    }
+}
+
+static void test_cache(void)
+{
+    static struct tag_builder t;
+    ID3_TAG_INFO info;
+    struct host_file f = {0};
+
+    tag_begin(&t, 3);
+    tag_text(&t, "TIT2", 0, "Cached");
+    tag_end(&t, 0);
+    f.data = t.buf;
+    f.len = t.len;
+    f.sclust = 100;
+    HOST_CHECK(id3_tag_get(&f, "sd0", &info) == 0 && f.reads, "cache miss did not read");
+    f.reads = 0;
+    HOST_CHECK(id3_tag_get(&f, "sd0", &info) == 0 && !f.reads && !strcmp(info.text[ID3_TAG_TITLE], "Cached"),
+               "cache hit read %d times", f.reads);
+    id3_tag_cache_clear("sd0");
+    HOST_CHECK(id3_tag_get(&f, "sd0", &info) == 0 && f.reads, "cache clear kept the entry");
+}
+
+int main(void)
+{
+    alarm(10);
+    test_v23();
+    test_v24_v22();
+    test_v1();
+    test_corrupt();
+    test_fuzz(20000);
+    test_cache();
+    return host_test_result("music_id3_test");
+}
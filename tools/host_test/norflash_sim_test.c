@@ -0,0 +1,585 @@
+/*
+ * 外挂norflash驱动(apps/common/device/norflash/norflash.c)写回缓存的spi flash模型回放
+ * spi flash模型：按命令字节解析快速读/页编程/擦除/状态寄存器/id，编程只能把1写成0，
+ * 页编程超过页尾时回绕到页首，统计擦除和页编程次数；
+ * 可以注入故障(页编程只写入一半、状态寄存器一直忙导致驱动超时)，可以在第N次擦除/编程后掉电
+ * 1.随机读写、擦除、定时器回写混合，读回数据与参考镜像一致，最终flash内容一致；
+ *   注入故障时写回失败的数据保留在缓存里，停止注入后回写，flash内容仍与参考一致
+ * 2.录音顺序写 + 文件分配表更新 + 日志追加交错的负载，与原来的单扇区缓存
+ *   (每次换扇区都擦除回写整个扇区)对比擦除/编程次数，读回数据一致
+ * 3.回写过程中任意一次擦除/编程后掉电：按地址从低到高回写，掉电点之前的扇区为新数据，
+ *   之后的为上次回写的数据，最多一个扇区不完整
+ * 同一程序以-DFLASH_CACHE_SECTOR_NUM=4编译作为对照
+ */
+#include "host_bench.h"
+#include "generic/typedef.h"
+#include "device/ioctl_cmds.h"
+
+#define SIM_FLASH_ID			0xef4013	/*容量64K * 2^(0x13 - 0x10) = 512K*/
+#define SIM_FLASH_SIZE			(512 * 1024)
+#define SIM_SECTOR_NUM			(SIM_FLASH_SIZE / 4096)
+
+/*与norflash.h、device/device.h中用到的部分一致*/
+#define WINBOND_WRITE_ENABLE			0x06
+#define WINBOND_READ_SR1				0x05
+#define WINBOND_FAST_READ_DATA			0x0b
+#define WINBOND_FAST_READ_DUAL_OUTPUT	0x3b
+#define WINBOND_PAGE_PROGRAM			0x02
+#define WINBOND_PAGE_ERASE				0x81
+#define WINBOND_SECTOR_ERASE			0x20
+#define WINBOND_BLOCK_ERASE				0xD8
+#define WINBOND_CHIP_ERASE				0xC7
+#define WINBOND_JEDEC_ID				0x9F
+
+enum {
+    FLASH_PAGE_ERASER,
+    FLASH_SECTOR_ERASER,
+    FLASH_BLOCK_ERASER,
+    FLASH_CHIP_ERASER,
+};
+
+struct norflash_dev_platform_data {
+    int spi_hw_num;
+    u32 spi_cs_port;
+    u32 spi_read_width;
+    const void *spi_pdata;
+    u32 start_addr;
+    u32 size;
+};
+
+typedef struct {
+    int counter;
+} atomic_t;
+#define atomic_read(v)			((v)->counter)
+
+struct dev_node {
+    const char *name;
+    const struct device_operations *ops;
+    void *priv_data;
+};
+
+struct device {
+    atomic_t ref;
+    void *private_data;
+    const struct device_operations *ops;
+    void *platform_data;
+    void *driver_data;
+};
+
+struct device_operations {
+    bool (*online)(const struct dev_node *node);
+    int (*init)(const struct dev_node *node, void *);
+    int (*open)(const char *name, struct device **device, void *arg);
+    int (*read)(struct device *device, void *buf, u32 len, u32);
+    int (*write)(struct device *device, void *buf, u32 len, u32);
+    int (*seek)(struct device *device, u32 offset, int orig);
+    int (*ioctl)(struct device *device, u32 cmd, u32 arg);
+    int (*close)(struct device *device);
+};
+
+/*系统接口：单线程回放，定时器由测试按模拟时间触发*/
+typedef int OS_MUTEX;
+#define os_mutex_create(m)
+#define os_mutex_pend(m, t)
+#define os_mutex_post(m)
+#define ASSERT(cond, ...)		do { if (!(cond)) { printf("ASSERT %s\n", #cond); exit(1); } } while (0)
+#define log_info(...)
+#define log_error(...)
+#define r_printf(...)
+#define delay(n)
+#define CLOCK_CRITICAL_HANDLE_REG(name, enter, exit)
+#define SPI_MODE_BIDIR_1BIT		0
+#define SPI_MODE_UNIDIR_2BIT	1
+#define SPI_MODE_UNIDIR_4BIT	2
+
+static u32 sim_now_ms;
+static u32 sim_timer_deadline;
+static void (*sim_timer_func)(void *priv);
+
+static u16 sys_timeout_add(void *priv, void (*func)(void *priv), u32 msec)
+{
+    sim_timer_func = func;
+    sim_timer_deadline = sim_now_ms + msec;
+    return 1;
+}
+
+static void sys_timer_re_run(u16 id)
+{
+    sim_timer_deadline = sim_now_ms + 60;
+}
+
+static void sys_timeout_del(u16 id)
+{
+    sim_timer_func = NULL;
+}
+
+/*spi flash模型*/
+struct spi_flash_sim {
+    u8 mem[SIM_FLASH_SIZE];
+    u8 cmd;
+    u8 addr_cnt;
+    u8 wel;
+    u8 id_idx;
+    u32 addr;
+    u32 busy;				/*状态寄存器还要读到几次忙*/
+    u32 erase_cnt;
+    u32 program_cnt;
+    u32 op_cnt;				/*擦除 + 页编程*/
+    u32 power_off_at;		/*第几次擦除/编程后掉电，0不掉电*/
+    u32 fail_permille;		/*每次擦除/编程注入故障的概率*/
+    u8 selected;
+};
+
+static struct spi_flash_sim sim;
+
+static int sim_power_on(void)
+{
+    return !(sim.power_off_at && (sim.op_cnt >= sim.power_off_at));
+}
+
+/*return: 1 注入故障(操作只完成一部分，状态寄存器一直忙到驱动超时)*/
+static int sim_op_start(void)
+{
+    if (sim.fail_permille && (host_rand() % 1000 < sim.fail_permille)) {
+        sim.busy = 8 * 1000 * 1000 / 100 + 1;
+        return 1;
+    }
+    sim.busy = 2;
+    return 0;
+}
+
+static void sim_erase(u32 addr, u32 size)
+{
+    if (!sim.wel || !sim_power_on()) {
+        return;
+    }
+    sim.wel = 0;
+    addr = addr / size * size;
+    if (sim_op_start()) {
+        size /= 2;
+    }
+    memset(sim.mem + addr, 0xff, size);
+    sim.erase_cnt++;
+    sim.op_cnt++;
+}
+
+static void gpio_write(u32 gpio, u32 value)
+{
+    if (!value) {
+        sim.selected = 1;
+        sim.cmd = 0;
+        sim.addr_cnt = 0;
+        sim.id_idx = 0;
+        return;
+    }
+    sim.selected = 0;
+    switch (sim.cmd) {
+    case WINBOND_WRITE_ENABLE:
+        sim.wel = 1;
+        break;
+    case WINBOND_PAGE_ERASE:
+        sim_erase(sim.addr, 256);
+        break;
+    case WINBOND_SECTOR_ERASE:
+        sim_erase(sim.addr, 4096);
+        break;
+    case WINBOND_BLOCK_ERASE:
+        sim_erase(sim.addr, 65536);
+        break;
+    case WINBOND_CHIP_ERASE:
+        sim_erase(0, SIM_FLASH_SIZE);
+        break;
+    case WINBOND_PAGE_PROGRAM:
+        sim.wel = 0;
+        break;
+    }
+}
+
+static void spi_send_byte(int spi, u8 byte)
+{
+    if (sim.cmd == 0) {
+        sim.cmd = byte;
+        sim.addr = 0;
+        return;
+    }
+    if (sim.addr_cnt < 3) {
+        sim.addr = (sim.addr << 8) | byte;
+        sim.addr_cnt++;
+    }
+    /*快速读地址后的空字节不处理*/
+}
+
+static u8 spi_recv_byte(int spi, int *err)
+{
+    if (sim.cmd == WINBOND_READ_SR1) {
+        if (sim.busy) {
+            sim.busy--;
+            return BIT(0);
+        }
+        return 0;
+    }
+    if (sim.cmd == WINBOND_JEDEC_ID) {
+        return SIM_FLASH_ID >> (16 - 8 * sim.id_idx++);
+    }
+    return 0xff;
+}
+
+static int spi_dma_recv(int spi, void *buf, u32 len)
+{
+    HOST_CHECK(sim.addr + len <= SIM_FLASH_SIZE, "read 0x%x + %u out of flash", sim.addr, len);
+    memcpy(buf, sim.mem + sim.addr, len);
+    return len;
+}
+
+static int spi_dma_send(int spi, const void *buf, u32 len)
+{
+    const u8 *p = buf;
+    u32 page = sim.addr / 256 * 256;
+
+    HOST_CHECK(sim.cmd == WINBOND_PAGE_PROGRAM && len <= 256, "dma send cmd 0x%x len %u", sim.cmd, len);
+    if (!sim.wel || !sim_power_on()) {
+        return len;
+    }
+    if (sim_op_start()) {
+        len /= 2;
+    }
+    for (u32 i = 0; i < len; i++) {
+        sim.mem[page + (sim.addr + i) % 256] &= p[i];
+    }
+    sim.program_cnt++;
+    sim.op_cnt++;
+    return len;
+}
+
+#define gpio_set_die(gpio, on)
+#define gpio_set_direction(gpio, dir)
+#define gpio_set_pull_up(gpio, on)
+#define gpio_set_pull_down(gpio, on)
+#define spi_open(spi)
+#define spi_close(spi)
+#define spi_set_bit_mode(spi, mode)
+#define spi_set_baud(spi, baud)
+#define spi_get_baud(spi)		0
+
+#include "../../apps/common/device/norflash/norflash.c"
+
+#define STEP_MS					5		/*负载里每次读写之间的间隔*/
+
+static u8 ref[SIM_FLASH_SIZE];
+static u8 tmp[8192];
+static struct norflash_partition *part;
+
+static void sim_advance(u32 ms)
+{
+    while (ms--) {
+        sim_now_ms++;
+        if (sim_timer_func && ((s32)(sim_now_ms - sim_timer_deadline) >= 0)) {
+            sim_timer_func(NULL);
+        }
+    }
+}
+
+static void flash_open(void)
+{
+    static const struct norflash_dev_platform_data pdata = {
+        .spi_hw_num = 1,
+        .spi_cs_port = 1,
+        .spi_read_width = 1,
+        .start_addr = 0,
+        .size = SIM_FLASH_SIZE,
+    };
+    if (!part) {
+        _norflash_init("nor_sim", (void *)&pdata);
+        part = norflash_find_part("nor_sim");
+    }
+    HOST_CHECK(_norflash_open(NULL) == 0, "open failed");
+}
+
+static void flash_power_cycle(void)
+{
+    /*掉电后缓存内容丢失，直接丢弃不回写*/
+    free(flash_cache_mem);
+    flash_cache_mem = NULL;
+    sim_timer_func = NULL;
+    flash_cache_timer = 0;
+    _norflash.open_cnt = 0;
+    memset(&sim.cmd, 0, sizeof(sim) - offsetof(struct spi_flash_sim, cmd));
+    flash_open();
+}
+
+static void fill_random(u8 *buf, u32 len)
+{
+    for (u32 i = 0; i < len; i++) {
+        buf[i] = host_rand();
+    }
+}
+
+static int check_read(u32 addr, u32 len)
+{
+    while (len) {
+        u32 n = MIN(len, sizeof(tmp));
+        _norflash_read(addr, tmp, n, 1);
+        if (memcmp(tmp, ref + addr, n)) {
+            printf("  read 0x%x + %u mismatch\n", addr, n);
+            return -1;
+        }
+        addr += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/*随机读写擦除，with_fault: 注入写回故障*/
+static void test_random(u32 ops, u32 with_fault)
+{
+    u32 bad_read = 0, write_err = 0;
+
+    memset(sim.mem, 0xff, SIM_FLASH_SIZE);
+    memset(ref, 0xff, SIM_FLASH_SIZE);
+    flash_power_cycle();
+    sim.fail_permille = with_fault ? 20 : 0;
+    for (u32 n = 0; n < ops; n++) {
+        /*集中在几个扇区，缓存有命中和替换*/
+        u32 sector = host_rand() % (with_fault ? 6 : 12);
+        u32 addr = sector * 4096 + host_rand() % 4096;
+        u32 op = host_rand() % 100;
+        u32 len;
+        if (op < 40) {
+            len = 1 + host_rand() % MIN(sizeof(tmp), SIM_FLASH_SIZE - addr);
+            len = (host_rand() & 1) ? MIN(len, 512) : len;
+            bad_read += check_read(addr, len) != 0;
+        } else if (op < 85) {
+            if (with_fault) {
+                /*注入故障时只写扇区内且不写到扇区末尾(写到末尾立即回写，失败时数据已经在缓存里)*/
+                len = 1 + host_rand() % (4096 - addr % 4096);
+                len = MIN(len, 4095 - addr % 4096);
+                if (!len) {
+                    continue;
+                }
+            } else {
+                len = 1 + host_rand() % MIN(sizeof(tmp), SIM_FLASH_SIZE - addr);
+            }
+            if (host_rand() & 1) {
+                /*只把1写成0，不需要擦除*/
+                memcpy(tmp, ref + addr, len);
+                for (u32 i = 0; i < len; i++) {
+                    tmp[i] &= host_rand();
+                }
+            } else {
+                fill_random(tmp, len);
+            }
+            if (_norflash_write(addr, tmp, len, 1) == 0) {
+                memcpy(ref + addr, tmp, len);
+            } else {
+                HOST_CHECK(with_fault, "write 0x%x + %u failed without fault", addr, len);
+                write_err++;
+            }
+        } else if (op < 90 && !with_fault) {
+            u32 s = host_rand() % 12;
+            HOST_CHECK(_norflash_ioctl(IOCTL_ERASE_SECTOR, s * 4096, 1, part) == 0, "erase sector %u failed", s);
+            memset(ref + s * 4096, 0xff, 4096);
+        } else if (op < 95) {
+            _norflash_ioctl(IOCTL_FLUSH, 0, 1, part);
+        } else {
+            sim_advance(FLASH_CACHE_SYNC_T_INTERVAL + 1);
+        }
+    }
+    sim.fail_permille = 0;
+    HOST_CHECK(_norflash_ioctl(IOCTL_FLUSH, 0, 1, part) == 0, "final flush failed");
+    HOST_CHECK(bad_read == 0, "%u reads mismatch", bad_read);
+    HOST_CHECK(memcmp(sim.mem, ref, SIM_FLASH_SIZE) == 0, "flash image differs after flush");
+    printf("norflash random%s: %u ops, %u write errors, erase %u program %u, read hit %u miss %u\n",
+           with_fault ? " with fault" : "", ops, write_err, sim.erase_cnt, sim.program_cnt,
+           flash_cache_stat.read_hit, flash_cache_stat.read_miss);
+}
+
+/*原来的单扇区缓存：换扇区、写到扇区末尾、定时器到期时擦除并编程整个扇区*/
+struct legacy_cache {
+    u32 addr;
+    u8 dirty;
+    u32 deadline;
+    u32 erase_cnt;
+    u32 program_cnt;
+};
+
+static void legacy_flush(struct legacy_cache *lc)
+{
+    if (lc->dirty) {
+        lc->dirty = 0;
+        lc->erase_cnt++;
+        lc->program_cnt += 4096 / 256;
+    }
+}
+
+static void legacy_write(struct legacy_cache *lc, u32 addr, u32 len)
+{
+    while (len) {
+        u32 sector = addr / 4096 * 4096;
+        u32 cnt = MIN(len, sector + 4096 - addr);
+        if (sector != lc->addr) {
+            legacy_flush(lc);
+            lc->addr = sector;
+        }
+        lc->dirty = 1;
+        if ((addr + cnt) % 4096 == 0) {
+            legacy_flush(lc);
+        } else {
+            lc->deadline = sim_now_ms + FLASH_CACHE_SYNC_T_INTERVAL;
+        }
+        addr += cnt;
+        len -= cnt;
+    }
+}
+
+/*
+ *录音 + 文件系统 + 日志交错写入，扇区号对应512字节的设备扇区
+ *录音数据：从DATA_START顺序写512字节(新擦除的区域，只有1->0)
+ *分配表：每写8个数据扇区(一个簇)更新一次FAT扇区，表项从0改为簇号(需要擦除)
+ *目录项：每写64个数据扇区更新一次文件长度
+ *日志：每3次读写追加一条48字节的日志
+ */
+#define FAT_ADDR				(4 * 4096)
+#define DIR_ADDR				(8 * 4096)
+#define LOG_START				(12 * 4096)
+#define LOG_SIZE				(16 * 4096)
+#define DATA_START				(32 * 4096)
+#define DATA_SECTORS			512
+
+static void workload_write(struct legacy_cache *lc, u32 addr, const u8 *buf, u32 len)
+{
+    if (lc->dirty && ((s32)(sim_now_ms - lc->deadline) >= 0)) {
+        legacy_flush(lc);
+    }
+    legacy_write(lc, addr, len);
+    HOST_CHECK(_norflash_write(addr, (void *)buf, len, 1) == 0, "write 0x%x + %u failed", addr, len);
+    memcpy(ref + addr, buf, len);
+    sim_advance(STEP_MS);
+}
+
+static void test_record_workload(void)
+{
+    struct legacy_cache lc = {0};
+    u32 log_pos = 0, step = 0;
+    u8 sec[512];
+
+    /*格式化：分配表、目录清0，数据和日志区擦除*/
+    memset(sim.mem, 0xff, SIM_FLASH_SIZE);
+    memset(sim.mem + FAT_ADDR, 0, 4096);
+    memset(sim.mem + DIR_ADDR, 0, 4096);
+    memcpy(ref, sim.mem, SIM_FLASH_SIZE);
+    flash_power_cycle();
+
+    for (u32 s = 0; s < DATA_SECTORS; s++) {
+        fill_random(sec, sizeof(sec));
+        workload_write(&lc, DATA_START + s * 512, sec, 512);
+        if (s % 8 == 7) {
+            u32 cluster = s / 8;
+            u32 fat = FAT_ADDR + (cluster * 2) / 512 * 512;
+            memcpy(sec, ref + fat, 512);
+            sec[(cluster * 2) % 512] = cluster + 3;
+            sec[(cluster * 2) % 512 + 1] = (cluster + 3) >> 8;
+            workload_write(&lc, fat, sec, 512);
+        }
+        if (s % 64 == 63) {
+            memcpy(sec, ref + DIR_ADDR, 512);
+            sec[28] = (s + 1) * 512;
+            sec[29] = ((s + 1) * 512) >> 8;
+            sec[30] = ((s + 1) * 512) >> 16;
+            workload_write(&lc, DIR_ADDR, sec, 512);
+        }
+        if (++step % 3 == 0) {
+            u8 line[48];
+            snprintf((char *)line, sizeof(line), "%08u rec sector %u\n", sim_now_ms, s);
+            if (log_pos + sizeof(line) > LOG_SIZE) {
+                log_pos = 0;
+            }
+            workload_write(&lc, LOG_START + log_pos, line, sizeof(line));
+            log_pos += sizeof(line);
+        }
+    }
+    sim_advance(FLASH_CACHE_SYNC_T_INTERVAL + 1);
+    legacy_flush(&lc);
+    HOST_CHECK(memcmp(sim.mem, ref, SIM_FLASH_SIZE) == 0, "record workload flash image differs");
+    HOST_CHECK(check_read(FAT_ADDR, 4096) == 0 && check_read(DATA_START, DATA_SECTORS * 512) == 0,
+               "record workload read back differs");
+    printf("norflash record+fat+log, %d cache sectors: erase %u program %u, single sector cache: erase %u program %u\n",
+           FLASH_CACHE_SECTOR_NUM, sim.erase_cnt, sim.program_cnt, lc.erase_cnt, lc.program_cnt);
+    HOST_CHECK(sim.erase_cnt * 2 < lc.erase_cnt, "erase %u not below half of single sector cache %u",
+               sim.erase_cnt, lc.erase_cnt);
+}
+
+/*
+ *回写中掉电：先回写一次作为旧数据，再改写若干扇区(留在缓存里)，IOCTL_FLUSH回写时在第cut次擦除/编程后掉电
+ *写入都在扇区中间且覆盖整个扇区内容的随机位置，保证每个扇区需要擦除
+ */
+static void test_power_loss(void)
+{
+    static u8 old[SIM_FLASH_SIZE];
+    u32 torn_max = 0, cases = 0;
+
+    for (u32 cut = 1; cut < 200; cut += 3) {
+        u32 dirty_sectors[FLASH_CACHE_SECTOR_NUM];
+        u32 n = 0;
+
+        memset(sim.mem, 0xff, SIM_FLASH_SIZE);
+        fill_random(sim.mem, 16 * 4096);
+        memcpy(ref, sim.mem, SIM_FLASH_SIZE);
+        flash_power_cycle();
+        /*改写FLASH_CACHE_SECTOR_NUM个不同扇区，都留在缓存里，地址顺序打乱*/
+        while (n < FLASH_CACHE_SECTOR_NUM) {
+            u32 s = host_rand() % 16, dup = 0;
+            for (u32 i = 0; i < n; i++) {
+                dup |= dirty_sectors[i] == s;
+            }
+            if (dup) {
+                continue;
+            }
+            dirty_sectors[n++] = s;
+            u32 off = 16 + host_rand() % 2048;
+            fill_random(tmp, 1024);
+            HOST_CHECK(_norflash_write(s * 4096 + off, tmp, 1024, 1) == 0, "write failed");
+            memcpy(ref + s * 4096 + off, tmp, 1024);
+        }
+        memcpy(old, sim.mem, SIM_FLASH_SIZE);
+        sim.op_cnt = 0;
+        sim.power_off_at = cut;
+        _norflash_ioctl(IOCTL_FLUSH, 0, 1, part);
+        sim.power_off_at = 0;
+
+        /*每个扇区为旧数据或新数据，新数据的扇区地址都低于仍是旧数据的脏扇区，不完整的扇区最多一个*/
+        u32 torn = 0, last_new = 0, first_old = SIM_SECTOR_NUM;
+        for (u32 s = 0; s < SIM_SECTOR_NUM; s++) {
+            u8 is_old = !memcmp(sim.mem + s * 4096, old + s * 4096, 4096);
+            u8 is_new = !memcmp(sim.mem + s * 4096, ref + s * 4096, 4096);
+            if (is_old && is_new) {
+                continue;
+            }
+            if (is_new) {
+                last_new = s + 1;
+            } else if (is_old) {
+                first_old = MIN(first_old, s);
+            } else {
+                torn++;
+                first_old = MIN(first_old, s);
+                last_new = MAX(last_new, s);
+            }
+        }
+        HOST_CHECK(torn <= 1, "cut %u: %u torn sectors", cut, torn);
+        HOST_CHECK(last_new <= first_old, "cut %u: sector %u written back after sector %u", cut, last_new - 1, first_old);
+        torn_max = MAX(torn_max, torn);
+        cases++;
+        flash_power_cycle();
+    }
+    printf("norflash power loss during write back: %u cut points, torn sectors per cut <= %u\n", cases, torn_max);
+}
+
+int main(void)
+{
+    test_random(40000, 0);
+    test_random(40000, 1);
+    test_record_workload();
+    test_power_loss();
+    char name[32];
+    sprintf(name, "norflash_sim_test(%d)", FLASH_CACHE_SECTOR_NUM);
+    return host_test_result(name);
+}
@@ -0,0 +1,336 @@
+/*
+ * pcm格式/通道转换(pcm_convert.c)逐点对比和耗时测试
+ * 参考结果由本文件的逐点标量实现给出，与库里的实现(优化或c参考)逐位比较
+ * 1.16bit->32bit：全部65536个值，shift 0/8/16，原地和不原地
+ * 2.32bit->16bit：shift 0/8/16，移位后留下的高位全部取值(shift 0即全部2^32个值)，饱和
+ * 3.单双声道、交织/拆分、四声道后两路混合：全部16bit值，各种长度和2byte/4byte对齐，原地
+ * 4.pcm_convert：4种位宽两两组合，通道n->n、1->2、2->1，边界值和随机值，
+ *   与pcm_load/pcm_store逐点结果一致；原地只测说明里支持的组合
+ * 5.统计标量参考和库实现每个点的耗时
+ * 同一程序以-DPCM_CONVERT_OPT_ENABLE=0编译，检查c参考实现本身
+ */
+#include "host_bench.h"
+#include "../../apps/common/audio/pcm_convert.c"
+
+#define TEST_FRAMES_MAX		65536
+
+#define REF_FN	static __attribute__((noinline, optimize("no-tree-vectorize")))
+
+REF_FN void ref_s16_to_s32(s32 *dst, const s16 *src, int points, u8 shift)
+{
+    for (int i = 0; i < points; i++) {
+        dst[i] = (s32)src[i] << shift;
+    }
+}
+
+REF_FN void ref_s32_to_s16(s16 *dst, const s32 *src, int points, u8 shift)
+{
+    for (int i = 0; i < points; i++) {
+        s32 v = src[i] >> shift;
+        dst[i] = v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+    }
+}
+
+REF_FN void ref_mono_to_dual(s16 *dst, const s16 *src, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        dst[2 * i] = src[i];
+        dst[2 * i + 1] = src[i];
+    }
+}
+
+REF_FN void ref_deinterleave(s16 *l, s16 *r, const s16 *src, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        l[i] = src[2 * i];
+        r[i] = src[2 * i + 1];
+    }
+}
+
+static s16 s16_all[TEST_FRAMES_MAX];
+static s32 s32_buf[TEST_FRAMES_MAX * 2 + 8], s32_ref[TEST_FRAMES_MAX * 2 + 8];
+static s16 s16_buf[TEST_FRAMES_MAX * 4 + 8], s16_ref[TEST_FRAMES_MAX * 4 + 8];
+
+static void test_s16_to_s32(void)
+{
+    static const u8 shifts[] = {0, 8, 16};
+
+    for (int k = 0; k < ARRAY_SIZE(shifts); k++) {
+        u8 shift = shifts[k];
+        ref_s16_to_s32(s32_ref, s16_all, TEST_FRAMES_MAX, shift);
+        pcm_s16_to_s32(s32_buf, s16_all, TEST_FRAMES_MAX, shift);
+        HOST_CHECK(memcmp(s32_buf, s32_ref, TEST_FRAMES_MAX * 4) == 0, "s16_to_s32 shift %d differs", shift);
+
+        /*原地：16bit数据放在32bit缓存前半段*/
+        memcpy(s32_buf, s16_all, TEST_FRAMES_MAX * 2);
+        pcm_s16_to_s32(s32_buf, (s16 *)s32_buf, TEST_FRAMES_MAX, shift);
+        HOST_CHECK(memcmp(s32_buf, s32_ref, TEST_FRAMES_MAX * 4) == 0, "s16_to_s32 in place shift %d differs", shift);
+
+        /*短长度和不对齐的源地址，检查尾部处理*/
+        for (int len = 0; len < 40; len++) {
+            for (int off = 0; off < 2; off++) {
+                memset(s32_buf, 0x5a, (len + 2) * 4);
+                pcm_s16_to_s32(s32_buf, s16_all + 30000 + off, len, shift);
+                ref_s16_to_s32(s32_ref, s16_all + 30000 + off, len, shift);
+                HOST_CHECK(memcmp(s32_buf, s32_ref, len * 4) == 0 && s32_buf[len] == 0x5a5a5a5a,
+                           "s16_to_s32 len %d off %d shift %d", len, off, shift);
+            }
+        }
+    }
+}
+
+static void test_s32_to_s16(void)
+{
+    static const u8 shifts[] = {0, 8, 16};
+
+    for (int k = 0; k < ARRAY_SIZE(shifts); k++) {
+        u8 shift = shifts[k];
+        /*结果只与移出后的高位有关：高(32 - shift)位全部取到，移出的低位取随机值*/
+        u32 blocks = 1u << (16 - shift);
+        for (u32 b = 0; b < blocks && !host_test_fail; b++) {
+            for (u32 i = 0; i < TEST_FRAMES_MAX; i++) {
+                u32 low = shift ? host_rand() & ((1u << shift) - 1) : 0;
+                s32_buf[i] = (s32)(((b << 16 | i) << shift) | low);
+            }
+            ref_s32_to_s16(s16_ref, s32_buf, TEST_FRAMES_MAX, shift);
+            pcm_s32_to_s16(s16_buf, s32_buf, TEST_FRAMES_MAX, shift);
+            HOST_CHECK(memcmp(s16_buf, s16_ref, TEST_FRAMES_MAX * 2) == 0, "s32_to_s16 block %u shift %d differs", b, shift);
+        }
+        /*原地*/
+        for (u32 i = 0; i < TEST_FRAMES_MAX; i++) {
+            s32_buf[i] = (s32)host_rand() >> (host_rand() & 15);
+        }
+        ref_s32_to_s16(s16_ref, s32_buf, TEST_FRAMES_MAX, shift);
+        pcm_s32_to_s16((s16 *)s32_buf, s32_buf, TEST_FRAMES_MAX, shift);
+        HOST_CHECK(memcmp(s32_buf, s16_ref, TEST_FRAMES_MAX * 2) == 0, "s32_to_s16 in place shift %d differs", shift);
+    }
+}
+
+static void test_channel(void)
+{
+    s16 *src = s16_buf + 4 * TEST_FRAMES_MAX / 2;
+
+    /*单声道->双声道：全部16bit值，不同长度、2byte/4byte对齐，原地*/
+    for (int len = 0; len < 40; len++) {
+        for (int off = 0; off < 4; off++) {
+            s16 *dst = s16_buf + (off & 1);
+            const s16 *in = s16_all + 1000 + (off >> 1);
+            memset(s16_buf, 0x5a, (2 * len + 4) * 2);
+            pcm_s16_mono_to_dual(dst, in, len);
+            ref_mono_to_dual(s16_ref, in, len);
+            HOST_CHECK(memcmp(dst, s16_ref, len * 4) == 0 && (u16)dst[2 * len] == 0x5a5a,
+                       "mono_to_dual len %d off %d", len, off);
+        }
+    }
+    ref_mono_to_dual(s16_ref, s16_all, TEST_FRAMES_MAX);
+    pcm_s16_mono_to_dual(s16_buf, s16_all, TEST_FRAMES_MAX);
+    HOST_CHECK(memcmp(s16_buf, s16_ref, TEST_FRAMES_MAX * 4) == 0, "mono_to_dual all values differ");
+    memcpy(s16_buf, s16_all, TEST_FRAMES_MAX * 2);
+    pcm_s16_mono_to_dual(s16_buf, s16_buf, TEST_FRAMES_MAX);
+    HOST_CHECK(memcmp(s16_buf, s16_ref, TEST_FRAMES_MAX * 4) == 0, "mono_to_dual in place differs");
+    memcpy(s16_buf + 1, s16_all, 999 * 2);
+    pcm_s16_mono_to_dual(s16_buf + 1, s16_buf + 1, 999);
+    HOST_CHECK(memcmp(s16_buf + 1, s16_ref, 999 * 4) == 0, "mono_to_dual unaligned in place differs");
+
+    /*32bit单声道->双声道，16bit单声道->32bit双声道*/
+    for (int k = 0; k < 3; k++) {
+        u8 shift = k * 8;
+        ref_s16_to_s32(s32_ref, s16_all, TEST_FRAMES_MAX, shift);
+        pcm_s16_mono_to_dual_s32(s32_buf, s16_all, TEST_FRAMES_MAX, shift);
+        for (int i = 0; i < TEST_FRAMES_MAX; i++) {
+            HOST_CHECK(s32_buf[2 * i] == s32_ref[i] && s32_buf[2 * i + 1] == s32_ref[i],
+                       "mono_to_dual_s32 %d shift %d", s16_all[i], shift);
+            if (host_test_fail) {
+                return;
+            }
+        }
+        memcpy(s32_buf, s32_ref, TEST_FRAMES_MAX * 4);
+        pcm_s32_mono_to_dual(s32_buf, s32_buf, TEST_FRAMES_MAX);
+        for (int i = 0; i < TEST_FRAMES_MAX; i++) {
+            HOST_CHECK(s32_buf[2 * i] == s32_ref[i] && s32_buf[2 * i + 1] == s32_ref[i], "s32 mono_to_dual %d", i);
+            if (host_test_fail) {
+                return;
+            }
+        }
+    }
+
+    /*双声道->单声道：每个值与全部16bit值配对*/
+    for (int i = 0; i < TEST_FRAMES_MAX; i++) {
+        src[2 * i] = s16_all[i];
+        src[2 * i + 1] = s16_all[(i * 40503u) & 0xffff];
+    }
+    pcm_s16_dual_to_mono(s16_buf, src, TEST_FRAMES_MAX);
+    for (int i = 0; i < TEST_FRAMES_MAX; i++) {
+        HOST_CHECK(s16_buf[i] == (((s32)src[2 * i] + src[2 * i + 1]) >> 1), "dual_to_mono %d", i);
+        if (host_test_fail) {
+            return;
+        }
+    }
+
+    /*拆分/交织：不同长度和对齐，l == src原地*/
+    for (int len = 0; len < 40; len++) {
+        for (int off = 0; off < 8; off++) {
+            s16 *in = src + (off & 1);
+            s16 *l = s16_buf + ((off >> 1) & 1);
+            s16 *r = s16_buf + 200 + ((off >> 2) & 1);
+            s16 ref_l[40], ref_r[40], out[80];
+            for (int i = 0; i < 2 * len; i++) {
+                in[i] = s16_all[(i * 7919 + len) & 0xffff];
+            }
+            ref_deinterleave(ref_l, ref_r, in, len);
+            pcm_s16_deinterleave(l, r, in, len);
+            HOST_CHECK(memcmp(l, ref_l, len * 2) == 0 && memcmp(r, ref_r, len * 2) == 0,
+                       "deinterleave len %d off %d", len, off);
+            pcm_s16_interleave(out, l, r, len);
+            HOST_CHECK(memcmp(out, in, len * 4) == 0, "interleave len %d off %d", len, off);
+        }
+    }
+    for (int i = 0; i < 2 * TEST_FRAMES_MAX; i++) {
+        src[i] = s16_all[(i * 40503u) & 0xffff];
+    }
+    ref_deinterleave(s16_ref, s16_ref + TEST_FRAMES_MAX, src, TEST_FRAMES_MAX);
+    pcm_s16_deinterleave(src, s16_buf, src, TEST_FRAMES_MAX);
+    HOST_CHECK(memcmp(src, s16_ref, TEST_FRAMES_MAX * 2) == 0 &&
+               memcmp(s16_buf, s16_ref + TEST_FRAMES_MAX, TEST_FRAMES_MAX * 2) == 0, "deinterleave l == src differs");
+
+    /*四声道后两路：每个值与全部16bit值配对*/
+    for (int i = 0; i < TEST_FRAMES_MAX / 2; i++) {
+        s16 *f = s16_buf + 4 * i;
+        f[0] = i;
+        f[1] = -i;
+        f[2] = s16_all[i * 2];
+        f[3] = s16_all[(i * 2 * 40503u + 1) & 0xffff];
+    }
+    memcpy(s16_ref, s16_buf, TEST_FRAMES_MAX * 4);
+    pcm_s16_qual_mix_rear(s16_buf, TEST_FRAMES_MAX / 2);
+    for (int i = 0; i < TEST_FRAMES_MAX / 2; i++) {
+        s16 *f = s16_buf + 4 * i, *g = s16_ref + 4 * i;
+        s16 v = pcm_sat((s32)g[2] + g[3], -32768, 32767);
+        HOST_CHECK(f[0] == g[0] && f[1] == g[1] && f[2] == v && f[3] == v, "qual_mix_rear frame %d", i);
+        if (host_test_fail) {
+            return;
+        }
+    }
+}
+
+/*边界值和随机值，按格式放在各自的容器里，24bit数据不超过24bit幅度*/
+static void fill_fmt(void *buf, u8 fmt, int points)
+{
+    static const s32 edge[] = {0, 1, -1, 32767, -32768, 0x7fffff, -0x800000, 0x7fffffff, (s32)0x80000000, 0x8000, -0x8001};
+
+    for (int i = 0; i < points; i++) {
+        s32 v = i < ARRAY_SIZE(edge) ? edge[i] : (s32)host_rand() >> (host_rand() & 31);
+        if (fmt == PCM_FMT_S16) {
+            ((s16 *)buf)[i] = v;
+        } else if (fmt == PCM_FMT_S24) {
+            ((s32 *)buf)[i] = pcm_sat(v, -0x800000, 0x7fffff);
+        } else {
+            ((s32 *)buf)[i] = v;
+        }
+    }
+}
+
+static int fmt_bytes(u8 fmt)
+{
+    return fmt == PCM_FMT_S16 ? 2 : 4;
+}
+
+static void ref_convert(void *dst, u8 dst_fmt, u8 dst_ch, const void *src, u8 src_fmt, u8 src_ch, int frames)
+{
+    for (int i = 0; i < frames; i++) {
+        if (src_ch == dst_ch) {
+            for (int c = 0; c < src_ch; c++) {
+                pcm_store(dst, dst_fmt, i * src_ch + c, pcm_load(src, src_fmt, i * src_ch + c));
+            }
+        } else if (src_ch == 1) {
+            s64 v = pcm_load(src, src_fmt, i);
+            pcm_store(dst, dst_fmt, 2 * i, v);
+            pcm_store(dst, dst_fmt, 2 * i + 1, v);
+        } else {
+            pcm_store(dst, dst_fmt, i, (pcm_load(src, src_fmt, 2 * i) + pcm_load(src, src_fmt, 2 * i + 1)) >> 1);
+        }
+    }
+}
+
+static void test_convert(void)
+{
+    static const u8 chs[][2] = {{1, 1}, {2, 2}, {1, 2}, {2, 1}};
+    static u8 src[4096 * 8], dst[4096 * 8], ref[4096 * 8], tmp[4096 * 8];
+
+    for (u8 sf = 0; sf < PCM_FMT_NUM; sf++) {
+        for (u8 df = 0; df < PCM_FMT_NUM; df++) {
+            for (int c = 0; c < ARRAY_SIZE(chs); c++) {
+                u8 sc = chs[c][0], dc = chs[c][1];
+                int frames = 1 + host_rand() % 4000;
+                int src_len = frames * sc * fmt_bytes(sf);
+                int dst_len = frames * dc * fmt_bytes(df);
+
+                fill_fmt(src, sf, frames * sc);
+                ref_convert(ref, df, dc, src, sf, sc, frames);
+                HOST_CHECK(pcm_convert(dst, df, dc, src, sf, sc, frames) == 0, "convert %d->%d ch %d->%d ret", sf, df, sc, dc);
+                HOST_CHECK(memcmp(dst, ref, dst_len) == 0, "convert %d->%d ch %d->%d differs", sf, df, sc, dc);
+
+                /*原地：同通道数，或者1->2且输出缓存够大，或者2->1*/
+                memset(tmp, 0, sizeof(tmp));
+                memcpy(tmp, src, src_len);
+                pcm_convert(tmp, df, dc, tmp, sf, sc, frames);
+                if (sc == dc || sc == 2 || sf == df || sf == PCM_FMT_S16) {
+                    HOST_CHECK(memcmp(tmp, ref, dst_len) == 0, "convert in place %d->%d ch %d->%d differs", sf, df, sc, dc);
+                }
+            }
+        }
+    }
+    HOST_CHECK(pcm_convert_get(PCM_FMT_NUM, 0) == NULL && pcm_convert(dst, 0, 3, src, 0, 1, 1) == -EINVAL,
+               "bad format accepted");
+}
+
+#define BENCH(name, ref_call, lib_call) \
+	do { \
+		u64 t_ref = 0, t_lib = 0; \
+		for (int i = 0; i < loops; i++) { \
+			u64 t0 = host_bench_now(); \
+			ref_call; \
+			u64 t1 = host_bench_now(); \
+			lib_call; \
+			u64 t2 = host_bench_now(); \
+			t_ref += t1 - t0; \
+			t_lib += t2 - t1; \
+		} \
+		printf("  %-22s ref %6.3f  lib %6.3f %s/point\n", name, \
+			   (double)t_ref / loops / points, (double)t_lib / loops / points, HOST_BENCH_UNIT); \
+	} while (0)
+
+static void bench(void)
+{
+    const int loops = 2000, points = 1024;
+    s16 *in16 = s16_all + 1000;
+    s32 *in32 = s32_ref;
+
+    for (int i = 0; i < points * 2; i++) {
+        in32[i] = (s32)host_rand() >> 12;
+    }
+    printf("pcm_convert bench (PCM_CONVERT_OPT_ENABLE %d, %d points):\n", PCM_CONVERT_OPT_ENABLE, points);
+    BENCH("s16_to_s32 shift 8", ref_s16_to_s32(s32_buf, in16, points, 8), pcm_s16_to_s32(s32_buf, in16, points, 8));
+    BENCH("s32_to_s16 shift 0", ref_s32_to_s16(s16_buf, in32, points, 0), pcm_s32_to_s16(s16_buf, in32, points, 0));
+    BENCH("s32_to_s16 shift 8", ref_s32_to_s16(s16_buf, in32, points, 8), pcm_s32_to_s16(s16_buf, in32, points, 8));
+    BENCH("mono_to_dual", ref_mono_to_dual(s16_buf, in16, points), pcm_s16_mono_to_dual(s16_buf, in16, points));
+    BENCH("deinterleave", ref_deinterleave(s16_buf, s16_buf + points, s16_all, points),
+          pcm_s16_deinterleave(s16_buf, s16_buf + points, s16_all, points));
+}
+
+int main(void)
+{
+    for (int i = 0; i < TEST_FRAMES_MAX; i++) {
+        s16_all[i] = (s16)i;
+    }
+    test_s16_to_s32();
+    test_s32_to_s16();
+    test_channel();
+    test_convert();
+    bench();
+#if PCM_CONVERT_OPT_ENABLE
+    return host_test_result("pcm_convert_test");
+#else
+    return host_test_result("pcm_convert_test(c ref)");
+#endif
+}
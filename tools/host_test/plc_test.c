@@ -0,0 +1,415 @@
+/*
+ * 丢包修复(audio_plc.c)回放测试
+ * 1.按丢包模式(随机单帧/突发/长时中断)回放PCM，统计修复帧的SNR和对数谱失真(LSD)，
+ *   并与不修复(补零)对比；丢包段前PLC_FADE_MS的LSD必须优于补零
+ * 2.统计信息与丢包模式一致，多实例之间互不影响
+ * 3.统计正常帧和修复帧每个点的耗时
+ * 主机上没有库PLC，测试的是内置的分级修复(a2dp及库PLC被占用时的路径)
+ *   plc_test [in.wav]		不带参数时使用内置的合成语音(16k单声道)和音乐(44.1k立体声)
+ */
+#include <math.h>
+#include "host_bench.h"
+#include "../../apps/common/audio/audio_plc.c"
+
+#define LSD_FFT_LEN		256
+#define LSD_EPS			1e-3
+
+enum {
+    LOSS_RANDOM = 0,	/*随机单帧丢失*/
+    LOSS_BURST,			/*两状态突发丢包*/
+    LOSS_OUTAGE,		/*偶尔的长时中断*/
+    LOSS_MODE_NUM,
+};
+
+static const char *loss_name[LOSS_MODE_NUM] = {"random 5%", "burst 10%", "outage 200ms"};
+
+struct pcm_clip {
+    const char *name;
+    s16 *data;
+    u32 points;			/*每声道点数*/
+    u16 sr;
+    u8 ch_num;
+    u16 frame_points;
+};
+
+struct quality {
+    double sig_e;
+    double err_e;
+    double lsd_sum;
+    u32 lsd_frames;
+};
+
+/*按模式生成每帧是否丢失，最后一段固定为正常帧，保证所有丢包段都已结束*/
+static void loss_pattern(u8 *lost, u32 frames, u8 mode, u32 frame_ms)
+{
+    u8 bad = 0;
+    u32 outage = 0;
+
+    for (u32 i = 0; i < frames; i++) {
+        u32 r = host_rand() % 1000;
+        switch (mode) {
+        case LOSS_RANDOM:
+            lost[i] = (r < 50);
+            break;
+        case LOSS_BURST:
+            /*好->坏3.3%，坏->坏70%，平均突发长度3.3帧*/
+            bad = bad ? (r < 700) : (r < 33);
+            lost[i] = bad;
+            break;
+        default:
+            if (outage) {
+                outage--;
+            } else if (r < 3) {
+                outage = 200 / frame_ms;
+            }
+            lost[i] = (outage != 0);
+            break;
+        }
+    }
+    for (u32 i = (frames > 4) ? frames - 4 : 0; i < frames; i++) {
+        lost[i] = 0;
+    }
+}
+
+/*对数谱失真(dB)：加汉宁窗补零到LSD_FFT_LEN点，直接DFT*/
+static double frame_lsd(const s16 *ref, const s16 *out, u16 points, u8 ch_num)
+{
+    static double win[LSD_FFT_LEN], cos_tab[LSD_FFT_LEN], sin_tab[LSD_FFT_LEN];
+    static u16 win_points;
+    double xr[LSD_FFT_LEN] = {0}, xo[LSD_FFT_LEN] = {0};
+    double sum = 0;
+    u16 n = (points < LSD_FFT_LEN) ? points : LSD_FFT_LEN;
+
+    if (win_points != n) {
+        for (int i = 0; i < n; i++) {
+            win[i] = 0.5 - 0.5 * cos(2 * M_PI * i / n);
+        }
+        for (int i = 0; i < LSD_FFT_LEN; i++) {
+            cos_tab[i] = cos(2 * M_PI * i / LSD_FFT_LEN);
+            sin_tab[i] = sin(2 * M_PI * i / LSD_FFT_LEN);
+        }
+        win_points = n;
+    }
+    for (int i = 0; i < n; i++) {
+        xr[i] = ref[i * ch_num] * win[i] / 32768.0;
+        xo[i] = out[i * ch_num] * win[i] / 32768.0;
+    }
+    for (int k = 1; k < LSD_FFT_LEN / 2; k++) {
+        double rr = 0, ri = 0, or = 0, oi = 0;
+        for (int i = 0; i < n; i++) {
+            int idx = (k * i) & (LSD_FFT_LEN - 1);
+            rr += xr[i] * cos_tab[idx];
+            ri -= xr[i] * sin_tab[idx];
+            or += xo[i] * cos_tab[idx];
+            oi -= xo[i] * sin_tab[idx];
+        }
+        double d = 10 * log10(rr * rr + ri * ri + LSD_EPS) - 10 * log10(or * or + oi * oi + LSD_EPS);
+        sum += d * d;
+    }
+    return sqrt(sum / (LSD_FFT_LEN / 2 - 1));
+}
+
+static void quality_add(struct quality *q, const s16 *ref, const s16 *out, u16 points, u8 ch_num)
+{
+    for (u32 i = 0; i < (u32)points * ch_num; i++) {
+        double e = (double)ref[i] - out[i];
+        q->sig_e += (double)ref[i] * ref[i];
+        q->err_e += e * e;
+    }
+    q->lsd_sum += frame_lsd(ref, out, points, ch_num);
+    q->lsd_frames++;
+}
+
+static double quality_snr(const struct quality *q)
+{
+    return 10 * log10((q->sig_e + 1) / (q->err_e + 1));
+}
+
+static double quality_lsd(const struct quality *q)
+{
+    return q->lsd_frames ? q->lsd_sum / q->lsd_frames : 0;
+}
+
+static void *plc_create_fixed(u16 sr, u8 ch_num, u8 flags)
+{
+    audio_plc_t *plc = audio_plc_create(sr, ch_num, flags);
+    if (plc) {
+        /*舒适噪声种子与地址无关，每次回放结果一致*/
+        plc->seed = 0x2468ace;
+    }
+    return plc;
+}
+
+/*
+ *回放一段PCM：丢失帧的数据在送入PLC前清零(与a2dp/esco解码出错时一致)
+ *修复帧和恢复后的第一帧计入质量统计
+ */
+static void replay(struct pcm_clip *clip, u8 mode)
+{
+    u16 fp = clip->frame_points;
+    u8 ch = clip->ch_num;
+    u32 frames = clip->points / fp;
+    u32 frame_ms = fp * 1000 / clip->sr;
+    u8 *lost = malloc(frames);
+    s16 *buf = malloc(fp * ch * sizeof(s16));
+    struct quality q_plc = {0}, q_zero = {0};
+    struct quality q_short = {0}, q_short_zero = {0};
+    u32 burst_frames = 0;
+    u64 t_good = 0, t_lost = 0;
+    u32 n_good = 0, n_lost = 0, bursts = 0;
+    struct audio_plc_stat stat;
+
+    loss_pattern(lost, frames, mode, frame_ms ? frame_ms : 1);
+
+    void *plc = plc_create_fixed(clip->sr, ch, 0);
+    HOST_CHECK(plc != NULL, "create %s", clip->name);
+    if (!plc) {
+        free(lost);
+        free(buf);
+        return;
+    }
+
+    for (u32 f = 0; f < frames; f++) {
+        s16 *ref = clip->data + f * fp * ch;
+        memcpy(buf, ref, fp * ch * sizeof(s16));
+        if (lost[f]) {
+            memset(buf, 0, fp * ch * sizeof(s16));
+            if (f == 0 || !lost[f - 1]) {
+                bursts++;
+                burst_frames = 0;
+            }
+            burst_frames++;
+        }
+
+        u64 t0 = host_bench_now();
+        audio_plc_process(plc, buf, fp * ch * sizeof(s16), lost[f]);
+        u64 t1 = host_bench_now();
+
+        if (lost[f]) {
+            t_lost += t1 - t0;
+            n_lost++;
+        } else {
+            t_good += t1 - t0;
+            n_good++;
+        }
+        if (lost[f] || (f && lost[f - 1])) {
+            static s16 zero[LSD_FFT_LEN * 8];
+            quality_add(&q_plc, ref, buf, fp, ch);
+            quality_add(&q_zero, ref, lost[f] ? zero : ref, fp, ch);
+            /*前PLC_FADE_MS为波形重复和外推，之后逐渐淡出到舒适噪声，与补零趋于一致*/
+            if (lost[f] && (burst_frames - 1) * fp * 1000 / clip->sr < PLC_FADE_MS) {
+                quality_add(&q_short, ref, buf, fp, ch);
+                quality_add(&q_short_zero, ref, zero, fp, ch);
+            }
+        }
+    }
+
+    audio_plc_get_stat(plc, &stat);
+    u32 hist_sum = 0, tier_sum = 0;
+    for (int i = 0; i < AUDIO_PLC_BURST_HIST_NUM; i++) {
+        hist_sum += stat.burst_hist[i];
+    }
+    for (int i = 0; i < AUDIO_PLC_TIER_NUM; i++) {
+        tier_sum += stat.tier_frames[i];
+    }
+    HOST_CHECK(stat.frames == frames, "%s frames %d != %d", clip->name, stat.frames, frames);
+    HOST_CHECK(stat.lost_frames == n_lost, "%s lost %d != %d", clip->name, stat.lost_frames, n_lost);
+    HOST_CHECK(stat.bursts == bursts, "%s bursts %d != %d", clip->name, stat.bursts, bursts);
+    HOST_CHECK(hist_sum == bursts, "%s burst_hist sum %d != %d", clip->name, hist_sum, bursts);
+    HOST_CHECK(tier_sum == n_lost, "%s tier sum %d != %d", clip->name, tier_sum, n_lost);
+    HOST_CHECK(stat.cur_burst == 0, "%s cur_burst %d", clip->name, stat.cur_burst);
+    if (n_lost) {
+        HOST_CHECK(quality_lsd(&q_short) < quality_lsd(&q_short_zero), "%s %s lsd %.1f >= zero fill %.1f",
+                   clip->name, loss_name[mode], quality_lsd(&q_short), quality_lsd(&q_short_zero));
+    }
+
+    printf("  %-10s %-13s lost %5d/%-5d bursts %4d max %3d tier %d/%d/%d  SNR %6.1f dB (zero %5.1f)  LSD %5.1f dB (zero %5.1f)\n",
+           clip->name, loss_name[mode], n_lost, frames, stat.bursts, stat.max_burst,
+           stat.tier_frames[0], stat.tier_frames[1], stat.tier_frames[2],
+           quality_snr(&q_plc), quality_snr(&q_zero), quality_lsd(&q_plc), quality_lsd(&q_zero));
+    printf("  %-10s %-13s first %dms of bursts:                        SNR %6.1f dB (zero %5.1f)  LSD %5.1f dB (zero %5.1f)\n",
+           "", "", PLC_FADE_MS, quality_snr(&q_short), quality_snr(&q_short_zero),
+           quality_lsd(&q_short), quality_lsd(&q_short_zero));
+    printf("  %-10s %-13s good %6.2f  lost %6.2f %s/point\n", "", "",
+           n_good ? (double)t_good / n_good / fp : 0, n_lost ? (double)t_lost / n_lost / fp : 0, HOST_BENCH_UNIT);
+
+    audio_plc_release(plc);
+    free(lost);
+    free(buf);
+}
+
+/*两路实例交替处理，结果与各自单独处理一致*/
+static void test_multi_instance(struct pcm_clip *a, struct pcm_clip *b)
+{
+    u32 frames = MIN(a->points / a->frame_points, b->points / b->frame_points);
+    u8 *lost_a = malloc(frames), *lost_b = malloc(frames);
+    u32 len_a = a->frame_points * a->ch_num * sizeof(s16);
+    u32 len_b = b->frame_points * b->ch_num * sizeof(s16);
+    s16 *solo = malloc(frames * len_a), *mixed = malloc(frames * len_a);
+    s16 *buf_b = malloc(len_b);
+
+    loss_pattern(lost_a, frames, LOSS_BURST, 8);
+    loss_pattern(lost_b, frames, LOSS_RANDOM, 3);
+
+    void *pa = plc_create_fixed(a->sr, a->ch_num, 0);
+    for (u32 f = 0; f < frames; f++) {
+        s16 *p = solo + f * len_a / 2;
+        memcpy(p, a->data + f * len_a / 2, len_a);
+        audio_plc_process(pa, p, len_a, lost_a[f]);
+    }
+    audio_plc_release(pa);
+
+    pa = plc_create_fixed(a->sr, a->ch_num, 0);
+    void *pb = plc_create_fixed(b->sr, b->ch_num, AUDIO_PLC_FLAG_MSBC);
+    for (u32 f = 0; f < frames; f++) {
+        s16 *p = mixed + f * len_a / 2;
+        memcpy(buf_b, b->data + f * len_b / 2, len_b);
+        audio_plc_process(pb, buf_b, len_b, lost_b[f]);
+        memcpy(p, a->data + f * len_a / 2, len_a);
+        audio_plc_process(pa, p, len_a, lost_a[f]);
+    }
+    HOST_CHECK(memcmp(solo, mixed, frames * len_a) == 0, "instances interfere");
+
+    /*msbc：错误帧的下一帧也修复*/
+    struct audio_plc_stat stat;
+    u32 expect = 0;
+    for (u32 f = 0; f < frames; f++) {
+        expect += lost_b[f] || (f && lost_b[f - 1]);
+    }
+    audio_plc_get_stat(pb, &stat);
+    HOST_CHECK(stat.lost_frames == expect, "msbc lost_frames %d != %d", stat.lost_frames, expect);
+
+    audio_plc_release(pa);
+    audio_plc_release(pb);
+    free(lost_a);
+    free(lost_b);
+    free(solo);
+    free(mixed);
+    free(buf_b);
+}
+
+/*合成浊音：基频在120~200Hz之间缓慢变化，带谐波和音节包络*/
+static void synth_speech(struct pcm_clip *clip, u32 seconds)
+{
+    double phase = 0;
+
+    clip->name = "speech16k";
+    clip->sr = 16000;
+    clip->ch_num = 1;
+    clip->frame_points = 120;
+    clip->points = clip->sr * seconds;
+    clip->data = malloc(clip->points * sizeof(s16));
+    for (u32 i = 0; i < clip->points; i++) {
+        double t = (double)i / clip->sr;
+        double f0 = 160 + 40 * sin(2 * M_PI * 0.7 * t);
+        double env = 0.55 + 0.45 * sin(2 * M_PI * 3 * t);
+        double s = 0;
+        phase += 2 * M_PI * f0 / clip->sr;
+        for (int h = 1; h <= 12; h++) {
+            s += sin(h * phase) / h;
+        }
+        clip->data[i] = (s16)(env * 6000 * s + (s16)host_rand() / 512);
+    }
+}
+
+/*合成音乐：左右声道不同的和弦，每秒换一次，128点一帧(sbc)*/
+static void synth_music(struct pcm_clip *clip, u32 seconds)
+{
+    static const double chords[4][3] = {
+        {261.6, 329.6, 392.0}, {220.0, 261.6, 329.6}, {174.6, 220.0, 261.6}, {196.0, 246.9, 293.7},
+    };
+
+    clip->name = "music44k";
+    clip->sr = 44100;
+    clip->ch_num = 2;
+    clip->frame_points = 128;
+    clip->points = clip->sr * seconds;
+    clip->data = malloc(clip->points * 2 * sizeof(s16));
+    for (u32 i = 0; i < clip->points; i++) {
+        double t = (double)i / clip->sr;
+        const double *c = chords[(i / clip->sr) & 3];
+        double l = 0, r = 0;
+        for (int k = 0; k < 3; k++) {
+            l += sin(2 * M_PI * c[k] * t);
+            r += sin(2 * M_PI * c[k] * 2 * t + k);
+        }
+        clip->data[i * 2] = (s16)(l * 5000);
+        clip->data[i * 2 + 1] = (s16)(r * 4000);
+    }
+}
+
+/*只支持16bit pcm wav，帧长按约8ms取*/
+static int load_wav(struct pcm_clip *clip, const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    u8 hdr[12], chunk[8];
+    u16 fmt_tag = 0, bits = 0;
+
+    if (!fp) {
+        printf("open %s fail\n", path);
+        return -1;
+    }
+    if (fread(hdr, 1, 12, fp) != 12 || memcmp(hdr, "RIFF", 4) || memcmp(hdr + 8, "WAVE", 4)) {
+        fclose(fp);
+        return -1;
+    }
+    while (fread(chunk, 1, 8, fp) == 8) {
+        u32 size = chunk[4] | (chunk[5] << 8) | (chunk[6] << 16) | ((u32)chunk[7] << 24);
+        if (!memcmp(chunk, "fmt ", 4)) {
+            u8 fmt[16];
+            if (size < 16 || fread(fmt, 1, 16, fp) != 16) {
+                break;
+            }
+            fmt_tag = fmt[0] | (fmt[1] << 8);
+            clip->ch_num = fmt[2];
+            clip->sr = fmt[4] | (fmt[5] << 8);
+            bits = fmt[14] | (fmt[15] << 8);
+            fseek(fp, size - 16 + (size & 1), SEEK_CUR);
+        } else if (!memcmp(chunk, "data", 4)) {
+            if (fmt_tag != 1 || bits != 16 || !clip->ch_num || !clip->sr) {
+                break;
+            }
+            clip->data = malloc(size);
+            clip->points = fread(clip->data, 1, size, fp) / 2 / clip->ch_num;
+            clip->name = "wav";
+            clip->frame_points = clip->sr / 125;
+            fclose(fp);
+            return 0;
+        } else {
+            fseek(fp, size + (size & 1), SEEK_CUR);
+        }
+    }
+    printf("%s: only 16bit pcm wav supported\n", path);
+    fclose(fp);
+    return -1;
+}
+
+int main(int argc, char **argv)
+{
+    struct pcm_clip speech, music, wav;
+
+    synth_speech(&speech, 10);
+    synth_music(&music, 10);
+
+    test_multi_instance(&music, &speech);
+
+    printf("plc replay:\n");
+    for (u8 mode = 0; mode < LOSS_MODE_NUM; mode++) {
+        replay(&speech, mode);
+        replay(&music, mode);
+    }
+    if (argc > 1) {
+        if (load_wav(&wav, argv[1]) == 0) {
+            for (u8 mode = 0; mode < LOSS_MODE_NUM; mode++) {
+                replay(&wav, mode);
+            }
+            free(wav.data);
+        } else {
+            host_test_fail++;
+        }
+    }
+
+    free(speech.data);
+    free(music.data);
+    return host_test_result("plc_test");
+}
@@ -0,0 +1,161 @@
+/*
+ * 第三方协议共用CRC(apps/common/third_party_profile/common/profile_crc.c)对比和速度测试
+ * 1.与原来各协议里的实现一致：tuya逐位CRC16/MODBUS、逐位CRC32，qiot逐字节查表CRC32；
+ *   随机buf对齐、长度、初值，分段续算与一次计算一致
+ * 2.标准校验值("123456789")
+ * 3.统计原逐位/逐字节实现和查表实现的MB/s
+ * 同一程序以-DPROFILE_CRC_SLICE=1/8编译作为对照
+ */
+#include "host_bench.h"
+#include "../../apps/common/third_party_profile/common/profile_crc.c"
+
+#define TEST_BYTES_MAX		4096
+
+/*tuya_ble_crc16_compute原实现*/
+static u16 legacy_crc16(const u8 *p_data, u32 size, const u16 *p_crc)
+{
+    u16 poly[2] = {0, 0xa001};
+    u16 crc;
+    int i, j;
+    crc = (p_crc == NULL) ? 0xFFFF : *p_crc;
+
+    for (j = size; j > 0; j--) {
+        unsigned char ds = *p_data++;
+
+        for (i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ poly[(crc ^ ds) & 1];
+            ds = ds >> 1;
+        }
+    }
+    return crc;
+}
+
+/*tuya_ble_crc32_compute原实现*/
+static u32 legacy_crc32(const u8 *p_data, u32 size, const u32 *p_crc)
+{
+    u32 crc;
+    crc = (p_crc == NULL) ? 0xFFFFFFFF : ~(*p_crc);
+    for (u32 i = 0; i < size; i++) {
+        crc = crc ^ p_data[i];
+        for (u32 j = 8; j > 0; j--) {
+            crc = (crc >> 1) ^ (0xEDB88320U & ((crc & 1) ? 0xFFFFFFFF : 0));
+        }
+    }
+    return ~crc;
+}
+
+/*ble_qiot_crc32原实现(逐字节查表，表即crc32_tab[0])*/
+static u32 legacy_qiot_crc32(u32 crc, const u8 *buf, int len)
+{
+    const u8 *p = buf;
+    crc = crc ^ ~0U;
+    while (len--) {
+        crc = crc32_tab[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ ~0U;
+}
+
+static void fill_random(u8 *buf, u32 len)
+{
+    for (u32 i = 0; i < len; i++) {
+        buf[i] = host_rand() >> 24;
+    }
+}
+
+static void test_vectors(void)
+{
+    const u8 *s = (const u8 *)"123456789";
+    u16 crc16 = profile_crc16_update(PROFILE_CRC16_INIT, s, 9);
+    u32 crc32 = profile_crc32(0, s, 9);
+
+    HOST_CHECK(crc32 == 0xcbf43926, "crc32 check value %08x", crc32);
+    HOST_CHECK(crc16 == 0x4b37, "crc16/modbus check value %04x", crc16);
+    HOST_CHECK(profile_crc32(0, s, 0) == 0 && profile_crc16_update(PROFILE_CRC16_INIT, s, 0) == PROFILE_CRC16_INIT,
+               "empty input changed crc");
+}
+
+static void test_random(int rounds)
+{
+    static u8 buf[TEST_BYTES_MAX + 8];
+
+    for (int r = 0; r < rounds; r++) {
+        u32 len = (r & 3) ? host_rand() % 24 : host_rand() % TEST_BYTES_MAX;
+        u8 *p = buf + (host_rand() & 7);
+        u32 seed32 = (r & 1) ? host_rand() : 0;
+        u16 seed16 = (r & 1) ? host_rand() : PROFILE_CRC16_INIT;
+
+        fill_random(p, len);
+        u32 ref32 = legacy_crc32(p, len, (r & 1) ? &seed32 : NULL);
+        u16 ref16 = legacy_crc16(p, len, &seed16);
+        HOST_CHECK(profile_crc32(seed32, p, len) == ref32, "crc32 len=%u align=%d seed=%08x differs",
+                   len, (int)((unsigned long)p & 7), seed32);
+        HOST_CHECK(profile_crc32(seed32, p, len) == legacy_qiot_crc32(seed32, p, len), "qiot crc32 len=%u differs", len);
+        HOST_CHECK(profile_crc16_update(seed16, p, len) == ref16, "crc16 len=%u align=%d seed=%04x differs",
+                   len, (int)((unsigned long)p & 7), seed16);
+
+        /*分段续算*/
+        u32 crc32 = (r & 1) ? ~seed32 : profile_crc32_init();
+        u16 crc16 = seed16;
+        u32 off = 0;
+        while (off < len) {
+            u32 n = 1 + host_rand() % 300;
+            n = MIN(n, len - off);
+            crc32 = profile_crc32_update(crc32, p + off, n);
+            crc16 = profile_crc16_update(crc16, p + off, n);
+            off += n;
+        }
+        HOST_CHECK(profile_crc32_final(crc32) == ref32, "streamed crc32 len=%u differs", len);
+        HOST_CHECK(crc16 == ref16, "streamed crc16 len=%u differs", len);
+        if (host_test_fail) {
+            return;
+        }
+    }
+}
+
+/*MB/s按墙上时间计算，与HOST_BENCH_UNIT无关*/
+static double bench_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static volatile u32 bench_sink;
+
+#define BENCH_MBPS(expr, len, loops) ({ \
+		double t0 = bench_sec(); \
+		for (int i = 0; i < (loops); i++) { \
+			bench_sink += (expr); \
+		} \
+		(double)(len) * (loops) / (bench_sec() - t0) / 1e6; \
+	})
+
+static void bench(u32 len, u32 align)
+{
+    static u8 buf[TEST_BYTES_MAX + 8];
+    u8 *p = buf + align;
+    int loops = 4000000 / len + 1;
+
+    fill_random(buf, sizeof(buf));
+    printf("  %4uB buf+%u  crc32: bitwise %7.1f  byte table %7.1f  slice-by-%d %7.1f MB/s\n", len, align,
+           BENCH_MBPS(legacy_crc32(p, len, NULL), len, loops / 8),
+           BENCH_MBPS(legacy_qiot_crc32(0, p, len), len, loops),
+           PROFILE_CRC_SLICE, BENCH_MBPS(profile_crc32(0, p, len), len, loops));
+    printf("  %4uB buf+%u  crc16: bitwise %7.1f  slice-by-%d %7.1f MB/s\n", len, align,
+           BENCH_MBPS(legacy_crc16(p, len, NULL), len, loops / 8),
+           PROFILE_CRC_SLICE < 4 ? 1 : 4, BENCH_MBPS(profile_crc16_update(PROFILE_CRC16_INIT, p, len), len, loops));
+}
+
+int main(void)
+{
+    test_vectors();
+    test_random(200000);
+
+    printf("crc bench (PROFILE_CRC_SLICE %d):\n", PROFILE_CRC_SLICE);
+    bench(4096, 0);
+    bench(4096, 1);
+    bench(20, 0);
+    char name[32];
+    sprintf(name, "profile_crc_test(%d)", PROFILE_CRC_SLICE);
+    return host_test_result(name);
+}
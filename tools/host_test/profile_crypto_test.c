@@ -0,0 +1,590 @@
+/*
+ * 第三方协议共用加解密/摘要(apps/common/third_party_profile/common/profile_crypto.c)标准向量和速度测试
+ * 1.MD5(RFC 1321)、SHA-1/SHA-256(FIPS 180)标准向量，随机分段update与一次计算一致
+ * 2.HMAC：RFC 2202(MD5/SHA-1)、RFC 4231(SHA-256)，包括长于一块的密钥；
+ *   同一ctx连续计算多次(final后回到init之后的状态)与每次重新计算一致
+ * 3.AES：FIPS-197附录C单块，SP800-38A的ECB/CBC/CTR(128/192/256)，原地处理，
+ *   CBC/CTR分段续算与一次计算一致，CTR末尾不足一块
+ * 4.CCM：SP800-38C附录C的例子1~4(例子4的aad为64K)，原地加解密，
+ *   篡改tag/密文/aad返回-EACCES且输出清零，nonce/tag长度错误返回-EINVAL
+ * 5.统计各模式和摘要每字节的耗时
+ * 同一程序以-DPROFILE_CRYPTO_AES_TABLES=0/4编译作为对照
+ */
+#include "host_bench.h"
+#include "../../apps/common/third_party_profile/common/profile_crypto.c"
+
+#define TEST_BYTES_MAX		4096
+
+/*十六进制串转字节，忽略空格，return:字节数*/
+static u32 hex(u8 *out, const char *str)
+{
+    u32 len = 0;
+    int half = -1;
+
+    for (; *str; str++) {
+        int v;
+        if ((*str >= '0') && (*str <= '9')) {
+            v = *str - '0';
+        } else if ((*str >= 'a') && (*str <= 'f')) {
+            v = *str - 'a' + 10;
+        } else {
+            continue;
+        }
+        if (half < 0) {
+            half = v;
+        } else {
+            out[len++] = (half << 4) | v;
+            half = -1;
+        }
+    }
+    return len;
+}
+
+static int hex_equal(const u8 *data, const char *str, u32 len)
+{
+    u8 ref[TEST_BYTES_MAX];
+    return (hex(ref, str) == len) && !memcmp(data, ref, len);
+}
+
+static void fill_random(u8 *buf, u32 len)
+{
+    for (u32 i = 0; i < len; i++) {
+        buf[i] = host_rand();
+    }
+}
+
+/*1.摘要*/
+struct hash_vector {
+    u8 alg;
+    const char *msg;
+    u32 repeat;			/*msg重复次数*/
+    const char *digest;
+};
+
+static const struct hash_vector hash_vectors[] = {
+    {PROFILE_HASH_MD5, "", 1, "d41d8cd98f00b204e9800998ecf8427e"},
+    {PROFILE_HASH_MD5, "abc", 1, "900150983cd24fb0d6963f7d28e17f72"},
+    {PROFILE_HASH_MD5, "message digest", 1, "f96b697d7cb7938d525a2f31aaf161d0"},
+    {PROFILE_HASH_MD5, "1234567890", 8, "57edf4a22be3c955ac49da2e2107b67a"},
+    {PROFILE_HASH_SHA1, "", 1, "da39a3ee5e6b4b0d3255bfef95601890afd80709"},
+    {PROFILE_HASH_SHA1, "abc", 1, "a9993e364706816aba3e25717850c26c9cd0d89d"},
+    {PROFILE_HASH_SHA1, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+     "84983e441c3bd26ebaae4aa1f95129e5e54670f1"},
+    {PROFILE_HASH_SHA1, "a", 1000000, "34aa973cd4c4daa4f61eeb2bdbad27316534016f"},
+    {PROFILE_HASH_SHA256, "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+    {PROFILE_HASH_SHA256, "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+    {PROFILE_HASH_SHA256, "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+    {PROFILE_HASH_SHA256, "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+};
+
+static void test_hash(void)
+{
+    struct profile_hash_ctx ctx;
+    u8 digest[PROFILE_HASH_DIGEST_MAX];
+
+    for (int i = 0; i < ARRAY_SIZE(hash_vectors); i++) {
+        const struct hash_vector *v = &hash_vectors[i];
+        u8 size = profile_hash_size(v->alg);
+        profile_hash_init(&ctx, v->alg);
+        for (u32 r = 0; r < v->repeat; r++) {
+            profile_hash_update(&ctx, (const u8 *)v->msg, strlen(v->msg));
+        }
+        profile_hash_final(&ctx, digest);
+        HOST_CHECK(hex_equal(digest, v->digest, size), "hash vector %d (alg %d) differs", i, v->alg);
+        if (v->repeat == 1) {
+            profile_hash(v->alg, (const u8 *)v->msg, strlen(v->msg), digest);
+            HOST_CHECK(hex_equal(digest, v->digest, size), "one-shot hash vector %d differs", i);
+        }
+    }
+    HOST_CHECK(profile_hash_init(&ctx, PROFILE_HASH_NUM) == -EINVAL && profile_hash_size(PROFILE_HASH_NUM) == 0,
+               "unknown hash accepted");
+
+    /*随机分段(跨块边界、正好一块、空段)与一次计算一致*/
+    static u8 buf[TEST_BYTES_MAX];
+    u8 ref[PROFILE_HASH_DIGEST_MAX];
+    fill_random(buf, sizeof(buf));
+    for (int n = 0; n < 3000; n++) {
+        u8 alg = n % PROFILE_HASH_NUM;
+        u32 len = host_rand() % (TEST_BYTES_MAX + 1);
+        u32 off = 0;
+        profile_hash(alg, buf, len, ref);
+        profile_hash_init(&ctx, alg);
+        while (off < len) {
+            u32 seg = host_rand() % 150;
+            seg = MIN(seg, len - off);
+            profile_hash_update(&ctx, buf + off, seg);
+            off += seg;
+        }
+        profile_hash_final(&ctx, digest);
+        HOST_CHECK(!memcmp(digest, ref, profile_hash_size(alg)), "alg %d len %u streamed hash differs", alg, len);
+        if (host_test_fail) {
+            return;
+        }
+    }
+}
+
+/*2.HMAC*/
+struct hmac_vector {
+    u8 alg;
+    const char *key;	/*十六进制*/
+    const char *data;	/*十六进制*/
+    const char *mac;	/*截短的mac只比较给出的长度*/
+};
+
+static const struct hmac_vector hmac_vectors[] = {
+    /*RFC 2202*/
+    {PROFILE_HASH_MD5, "0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b", "4869205468657265", "9294727a3638bb1c13f48ef8158bfc9d"},
+    {PROFILE_HASH_MD5, "4a656665", "7768617420646f2079612077616e7420666f72206e6f7468696e673f",
+     "750c783e6ab0b503eaa86e310a5db738"},
+    {PROFILE_HASH_SHA1, "0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b", "4869205468657265",
+     "b617318655057264e28bc0b6fb378c8ef146be00"},
+    {PROFILE_HASH_SHA1, "4a656665", "7768617420646f2079612077616e7420666f72206e6f7468696e673f",
+     "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79"},
+    /*RFC 4231 1~5*/
+    {PROFILE_HASH_SHA256, "0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b0b", "4869205468657265",
+     "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7"},
+    {PROFILE_HASH_SHA256, "4a656665", "7768617420646f2079612077616e7420666f72206e6f7468696e673f",
+     "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843"},
+    {PROFILE_HASH_SHA256, "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+     "dddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddddd",
+     "773ea91e36800e46854db8ebd09181a72959098b3ef8c122d9635514ced565fe"},
+    {PROFILE_HASH_SHA256, "0102030405060708090a0b0c0d0e0f10111213141516171819",
+     "cdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcdcd",
+     "82558a389a443c0ea4cc819899f2083a85f0faa3e578f8077a2e3ff46729665b"},
+    {PROFILE_HASH_SHA256, "0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c0c", "546573742057697468205472756e636174696f6e",
+     "a3b6167473100ee06e0c796c2955552b"},
+};
+
+/*长于一块的密钥：RFC 2202 6/7(80byte)、RFC 4231 6/7(131byte)，密钥全为0xaa*/
+struct hmac_long_vector {
+    u8 alg;
+    u8 key_len;
+    const char *data;
+    const char *mac;
+};
+
+static const struct hmac_long_vector hmac_long_vectors[] = {
+    {PROFILE_HASH_MD5, 80, "Test Using Larger Than Block-Size Key - Hash Key First", "6b1ab7fe4bd7bf8f0b62e6ce61b9d0cd"},
+    {PROFILE_HASH_MD5, 80, "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data",
+     "6f630fad67cda0ee1fb1f562db3aa53e"},
+    {PROFILE_HASH_SHA1, 80, "Test Using Larger Than Block-Size Key - Hash Key First", "aa4ae5e15272d00e95705637ce8a3b55ed402112"},
+    {PROFILE_HASH_SHA1, 80, "Test Using Larger Than Block-Size Key and Larger Than One Block-Size Data",
+     "e8e99d0f45237d786d6bbaa7965c7808bbff1a91"},
+    {PROFILE_HASH_SHA256, 131, "Test Using Larger Than Block-Size Key - Hash Key First",
+     "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54"},
+    {PROFILE_HASH_SHA256, 131, "This is a test using a larger than block-size key and a larger than block-size data. "
+     "The key needs to be hashed before being used by the HMAC algorithm.",
+     "9b09ffa71b942fcb27635fbcd5b0e944bfdc63644f0713938a7f51535c3a35e2"},
+};
+
+static void test_hmac(void)
+{
+    u8 key[256], data[256], mac[PROFILE_HASH_DIGEST_MAX];
+    struct profile_hmac_ctx ctx;
+
+    for (int i = 0; i < ARRAY_SIZE(hmac_vectors); i++) {
+        const struct hmac_vector *v = &hmac_vectors[i];
+        u32 key_len = hex(key, v->key);
+        u32 data_len = hex(data, v->data);
+        u32 mac_len = strlen(v->mac) / 2;
+        profile_hmac(v->alg, key, key_len, data, data_len, mac);
+        HOST_CHECK(hex_equal(mac, v->mac, mac_len), "hmac vector %d (alg %d) differs", i, v->alg);
+    }
+
+    memset(key, 0xaa, sizeof(key));
+    for (int i = 0; i < ARRAY_SIZE(hmac_long_vectors); i++) {
+        const struct hmac_long_vector *v = &hmac_long_vectors[i];
+        u8 size = profile_hash_size(v->alg);
+        profile_hmac(v->alg, key, v->key_len, (const u8 *)v->data, strlen(v->data), mac);
+        HOST_CHECK(hex_equal(mac, v->mac, size), "long key hmac vector %d (alg %d) differs", i, v->alg);
+
+        /*同一ctx连续计算：每次final后直接接着算下一条，不重新init*/
+        profile_hmac_init(&ctx, v->alg, key, v->key_len);
+        for (int r = 0; r < 3; r++) {
+            const char *msg = v->data;
+            profile_hmac_update(&ctx, (const u8 *)msg, 7);
+            profile_hmac_update(&ctx, (const u8 *)msg + 7, strlen(msg) - 7);
+            profile_hmac_final(&ctx, mac);
+            HOST_CHECK(hex_equal(mac, v->mac, size), "long key hmac vector %d, mac %d on one ctx differs", i, r);
+        }
+    }
+
+    /*同一ctx交替计算不同数据，与每次重新计算一致*/
+    static u8 buf[TEST_BYTES_MAX];
+    u8 ref[PROFILE_HASH_DIGEST_MAX];
+    fill_random(buf, sizeof(buf));
+    for (u8 alg = 0; alg < PROFILE_HASH_NUM; alg++) {
+        u32 key_len = 1 + host_rand() % 200;
+        profile_hmac_init(&ctx, alg, buf, key_len);
+        for (int n = 0; n < 200; n++) {
+            u32 len = host_rand() % (TEST_BYTES_MAX + 1);
+            profile_hmac(alg, buf, key_len, buf, len, ref);
+            profile_hmac_update(&ctx, buf, len);
+            profile_hmac_final(&ctx, mac);
+            HOST_CHECK(!memcmp(mac, ref, profile_hash_size(alg)), "alg %d key %u len %u reused ctx differs",
+                       alg, key_len, len);
+            if (host_test_fail) {
+                return;
+            }
+        }
+    }
+    HOST_CHECK(profile_hmac_init(&ctx, PROFILE_HASH_NUM, key, 16) == -EINVAL, "unknown hmac hash accepted");
+}
+
+/*3.AES*/
+static const char *const fips197_key[3] = {
+    "000102030405060708090a0b0c0d0e0f",
+    "000102030405060708090a0b0c0d0e0f1011121314151617",
+    "000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f",
+};
+
+static const char *const fips197_ct[3] = {
+    "69c4e0d86a7b0430d8cdb78070b4c55a",
+    "dda97ca4864cdfe06eaf70a0ec0d7191",
+    "8ea2b7ca516745bfeafc49904b496089",
+};
+
+/*SP800-38A F.1/F.2/F.5，四块明文相同*/
+static const char *const sp800_38a_pt =
+    "6bc1bee22e409f96e93d7e117393172a ae2d8a571e03ac9c9eb76fac45af8e51"
+    "30c81c46a35ce411e5fbc1191a0a52ef f69f2445df4f9b17ad2b417be66c3710";
+
+struct aes_mode_vector {
+    const char *key;
+    const char *ecb;
+    const char *cbc;	/*iv 000102...0f*/
+    const char *ctr;	/*计数块f0f1f2...ff*/
+};
+
+static const struct aes_mode_vector sp800_38a[3] = {
+    {
+        "2b7e151628aed2a6abf7158809cf4f3c",
+        "3ad77bb40d7a3660a89ecaf32466ef97 f5d3d58503b9699de785895a96fdbaaf"
+        "43b1cd7f598ece23881b00e3ed030688 7b0c785e27e8ad3f8223207104725dd4",
+        "7649abac8119b246cee98e9b12e9197d 5086cb9b507219ee95db113a917678b2"
+        "73bed6b8e3c1743b7116e69e22229516 3ff1caa1681fac09120eca307586e1a7",
+        "874d6191b620e3261bef6864990db6ce 9806f66b7970fdff8617187bb9fffdff"
+        "5ae4df3edbd5d35e5b4f09020db03eab 1e031dda2fbe03d1792170a0f3009cee",
+    },
+    {
+        "8e73b0f7da0e6452c810f32b809079e562f8ead2522c6b7b",
+        "bd334f1d6e45f25ff712a214571fa5cc 974104846d0ad3ad7734ecb3ecee4eef"
+        "ef7afd2270e2e60adce0ba2face6444e 9a4b41ba738d6c72fb16691603c18e0e",
+        "4f021db243bc633d7178183a9fa071e8 b4d9ada9ad7dedf4e5e738763f69145a"
+        "571b242012fb7ae07fa9baac3df102e0 08b0e27988598881d920a9e64f5615cd",
+        "1abc932417521ca24f2b0459fe7e6e0b 090339ec0aa6faefd5ccc2c6f4ce8e94"
+        "1e36b26bd1ebc670d1bd1d665620abf7 4f78a7f6d29809585a97daec58c6b050",
+    },
+    {
+        "603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4",
+        "f3eed1bdb5d2a03c064b5a7e3db181f8 591ccb10d410ed26dc5ba74a31362870"
+        "b6ed21b99ca6f4f9f153e7b1beafed1d 23304b7a39f9f3ff067d8d8f9e24ecc7",
+        "f58c4c04d6e5f1ba779eabfb5f7bfbd6 9cfc4e967edb808d679f777bc6702c7d"
+        "39f23369a9d9bacfa530e26304231461 b2eb05e2c39be9fcda6c19078c6a9d1b",
+        "601ec313775789a5b7a7f504bbf3d228 f443e3ca4d62b59aca84e990cacaf5c5"
+        "2b0930daa23de94ce87017ba2d84988d dfc9c58db67aada613c2dd08457941a6",
+    },
+};
+
+static void test_aes_vectors(void)
+{
+    struct profile_aes_ctx enc, dec;
+    u8 key[32], pt[64], buf[64], iv[16];
+    u32 key_len;
+
+    for (int k = 0; k < 3; k++) {
+        u16 bits = 128 + k * 64;
+
+        key_len = hex(key, fips197_key[k]);
+        hex(pt, "00112233445566778899aabbccddeeff");
+        profile_aes_setkey_enc(&enc, key, key_len * 8);
+        profile_aes_setkey_dec(&dec, key, key_len * 8);
+        profile_aes_ecb_encrypt(&enc, pt, buf, 1);
+        HOST_CHECK(hex_equal(buf, fips197_ct[k], 16), "FIPS-197 AES-%d encrypt differs", bits);
+        profile_aes_ecb_decrypt(&dec, buf, buf, 1);
+        HOST_CHECK(!memcmp(buf, pt, 16), "FIPS-197 AES-%d decrypt differs", bits);
+
+        const struct aes_mode_vector *v = &sp800_38a[k];
+        key_len = hex(key, v->key);
+        hex(pt, sp800_38a_pt);
+        HOST_CHECK(profile_aes_setkey_enc(&enc, key, bits) == 0 && profile_aes_setkey_dec(&dec, key, bits) == 0,
+                   "AES-%d setkey failed", bits);
+
+        profile_aes_ecb_encrypt(&enc, pt, buf, 4);
+        HOST_CHECK(hex_equal(buf, v->ecb, 64), "SP800-38A ECB-AES%d encrypt differs", bits);
+        profile_aes_ecb_decrypt(&dec, buf, buf, 4);
+        HOST_CHECK(!memcmp(buf, pt, 64), "SP800-38A ECB-AES%d in-place decrypt differs", bits);
+
+        hex(iv, "000102030405060708090a0b0c0d0e0f");
+        memcpy(buf, pt, 64);
+        profile_aes_cbc_encrypt(&enc, iv, buf, buf, 4);
+        HOST_CHECK(hex_equal(buf, v->cbc, 64), "SP800-38A CBC-AES%d in-place encrypt differs", bits);
+        HOST_CHECK(!memcmp(iv, buf + 48, 16), "CBC-AES%d iv is not the last cipher block", bits);
+        /*分两段解密，iv接着用*/
+        hex(iv, "000102030405060708090a0b0c0d0e0f");
+        profile_aes_cbc_decrypt(&dec, iv, buf, buf, 1);
+        profile_aes_cbc_decrypt(&dec, iv, buf + 16, buf + 16, 3);
+        HOST_CHECK(!memcmp(buf, pt, 64), "SP800-38A CBC-AES%d chained decrypt differs", bits);
+
+        hex(iv, "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+        profile_aes_ctr(&enc, iv, pt, buf, 32);
+        profile_aes_ctr(&enc, iv, pt + 32, buf + 32, 32);
+        HOST_CHECK(hex_equal(buf, v->ctr, 64), "SP800-38A CTR-AES%d chained encrypt differs", bits);
+        HOST_CHECK(hex_equal(iv, "f0f1f2f3f4f5f6f7f8f9fafbfcfdff03", 16), "CTR-AES%d next counter differs", bits);
+        /*末尾不足一块*/
+        hex(iv, "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+        profile_aes_ctr(&enc, iv, buf, buf, 61);
+        HOST_CHECK(!memcmp(buf, pt, 61), "SP800-38A CTR-AES%d 61 byte in-place decrypt differs", bits);
+    }
+
+    HOST_CHECK(profile_aes_setkey_enc(&enc, key, 64) == -EINVAL && profile_aes_setkey_dec(&dec, key, 512) == -EINVAL,
+               "unsupported AES key size accepted");
+}
+
+/*随机数据：ECB/CBC往返，CBC/CTR分段与一次计算一致*/
+static void test_aes_random(void)
+{
+    static u8 pt[TEST_BYTES_MAX], ct[TEST_BYTES_MAX], seg[TEST_BYTES_MAX];
+    struct profile_aes_ctx enc, dec;
+    u8 key[32], iv[16], iv_ref[16], iv_seg[16];
+
+    fill_random(pt, sizeof(pt));
+    for (int n = 0; n < 600; n++) {
+        u16 bits = 128 + (n % 3) * 64;
+        u32 blocks = host_rand() % (TEST_BYTES_MAX / 16 + 1);
+        u32 cut = blocks ? host_rand() % blocks : 0;
+
+        fill_random(key, sizeof(key));
+        fill_random(iv_ref, sizeof(iv_ref));
+        profile_aes_setkey_enc(&enc, key, bits);
+        profile_aes_setkey_dec(&dec, key, bits);
+
+        profile_aes_ecb_encrypt(&enc, pt, ct, blocks);
+        profile_aes_ecb_decrypt(&dec, ct, seg, blocks);
+        HOST_CHECK(!memcmp(seg, pt, blocks * 16), "AES-%d ECB %u blocks round trip differs", bits, blocks);
+
+        memcpy(iv, iv_ref, 16);
+        profile_aes_cbc_encrypt(&enc, iv, pt, ct, blocks);
+        memcpy(iv_seg, iv_ref, 16);
+        profile_aes_cbc_encrypt(&enc, iv_seg, pt, seg, cut);
+        profile_aes_cbc_encrypt(&enc, iv_seg, pt + cut * 16, seg + cut * 16, blocks - cut);
+        HOST_CHECK(!memcmp(seg, ct, blocks * 16) && !memcmp(iv, iv_seg, 16), "AES-%d CBC %u blocks cut %u differs",
+                   bits, blocks, cut);
+        memcpy(iv, iv_ref, 16);
+        profile_aes_cbc_decrypt(&dec, iv, ct, ct, blocks);
+        HOST_CHECK(!memcmp(ct, pt, blocks * 16), "AES-%d CBC %u blocks round trip differs", bits, blocks);
+
+        /*计数块低字节接近回绕，检查跨字节进位*/
+        u32 len = blocks * 16 - (blocks ? host_rand() % 16 : 0);
+        iv_ref[15] = 0xff - (host_rand() & 3);
+        iv_ref[14] = 0xff;
+        memcpy(iv, iv_ref, 16);
+        profile_aes_ctr(&enc, iv, pt, ct, len);
+        memcpy(iv_seg, iv_ref, 16);
+        profile_aes_ctr(&enc, iv_seg, pt, seg, cut * 16);
+        profile_aes_ctr(&enc, iv_seg, pt + cut * 16, seg + cut * 16, len - cut * 16);
+        HOST_CHECK(!memcmp(seg, ct, len), "AES-%d CTR %u bytes cut %u differs", bits, len, cut * 16);
+        memcpy(iv, iv_ref, 16);
+        profile_aes_ctr(&enc, iv, ct, ct, len);
+        HOST_CHECK(!memcmp(ct, pt, len), "AES-%d CTR %u bytes round trip differs", bits, len);
+        if (host_test_fail) {
+            return;
+        }
+    }
+}
+
+/*4.CCM，SP800-38C附录C，密钥404142...4f*/
+struct ccm_vector {
+    const char *nonce;
+    const char *aad;
+    u32 aad_len;		/*非0时aad为00..ff循环，长度aad_len*/
+    const char *pt;
+    const char *ct;
+    const char *tag;
+};
+
+static const struct ccm_vector sp800_38c[] = {
+    {"10111213141516", "0001020304050607", 0, "20212223", "7162015b", "4dac255d"},
+    {
+        "1011121314151617", "000102030405060708090a0b0c0d0e0f", 0,
+        "202122232425262728292a2b2c2d2e2f", "d2a1f0e051ea5f62081a7792073d593d", "1fc64fbfaccd",
+    },
+    {
+        "101112131415161718191a1b", "000102030405060708090a0b0c0d0e0f10111213", 0,
+        "202122232425262728292a2b2c2d2e2f3031323334353637",
+        "e3b201a9f5b71a7a9b1ceaeccd97e70b6176aad9a4428aa5", "484392fbc1b09951",
+    },
+    {
+        "101112131415161718191a1b1c", NULL, 65536,
+        "202122232425262728292a2b2c2d2e2f303132333435363738393a3b3c3d3e3f",
+        "69915dad1e84c6376a68c2967e4dab615ae0fd1faec44cc484828529463ccf72", "b4ac6bec93e8598e7f0dadbcea5b",
+    },
+};
+
+static u8 ccm_aad[65536];
+
+static void test_ccm(void)
+{
+    struct profile_aes_ctx enc;
+    u8 key[16], nonce[16], pt[64], buf[64], tag[16];
+    u8 pt_len, tag_len, nonce_len;
+    u32 aad_len;
+
+    hex(key, "404142434445464748494a4b4c4d4e4f");
+    profile_aes_setkey_enc(&enc, key, 128);
+    for (int i = 0; i < ARRAY_SIZE(sp800_38c); i++) {
+        const struct ccm_vector *v = &sp800_38c[i];
+        nonce_len = hex(nonce, v->nonce);
+        pt_len = hex(pt, v->pt);
+        tag_len = strlen(v->tag) / 2;
+        if (v->aad) {
+            aad_len = hex(ccm_aad, v->aad);
+        } else {
+            aad_len = v->aad_len;
+            for (u32 j = 0; j < aad_len; j++) {
+                ccm_aad[j] = j;
+            }
+        }
+
+        int ret = profile_aes_ccm_encrypt(&enc, nonce, nonce_len, ccm_aad, aad_len, pt, buf, pt_len, tag, tag_len);
+        HOST_CHECK(ret == 0 && hex_equal(buf, v->ct, pt_len) && hex_equal(tag, v->tag, tag_len),
+                   "SP800-38C example %d encrypt differs (ret %d)", i + 1, ret);
+        /*原地解密*/
+        ret = profile_aes_ccm_decrypt(&enc, nonce, nonce_len, ccm_aad, aad_len, buf, buf, pt_len, tag, tag_len);
+        HOST_CHECK(ret == 0 && !memcmp(buf, pt, pt_len), "SP800-38C example %d decrypt differs (ret %d)", i + 1, ret);
+        /*原地加密*/
+        ret = profile_aes_ccm_encrypt(&enc, nonce, nonce_len, ccm_aad, aad_len, buf, buf, pt_len, tag, tag_len);
+        HOST_CHECK(ret == 0 && hex_equal(buf, v->ct, pt_len), "SP800-38C example %d in-place encrypt differs", i + 1);
+
+        /*篡改tag、密文、aad各一位：-EACCES，输出清零*/
+        for (int t = 0; t < 3; t++) {
+            u8 ct[64], out[64];
+            u8 *bit = t == 0 ? &tag[tag_len - 1] : (t == 1 ? &ct[pt_len - 1] : &ccm_aad[aad_len - 1]);
+            memcpy(ct, buf, pt_len);
+            *bit ^= 0x01;
+            memset(out, 0xa5, sizeof(out));
+            ret = profile_aes_ccm_decrypt(&enc, nonce, nonce_len, ccm_aad, aad_len, ct, out, pt_len, tag, tag_len);
+            HOST_CHECK(ret == -EACCES, "SP800-38C example %d tamper %d returned %d", i + 1, t, ret);
+            int zero = 1;
+            for (u8 j = 0; j < pt_len; j++) {
+                zero &= out[j] == 0;
+            }
+            HOST_CHECK(zero && out[pt_len] == 0xa5, "SP800-38C example %d tamper %d output not cleared", i + 1, t);
+            *bit ^= 0x01;
+        }
+    }
+
+    HOST_CHECK(profile_aes_ccm_encrypt(&enc, nonce, 6, NULL, 0, pt, buf, 4, tag, 4) == -EINVAL, "nonce 6 accepted");
+    HOST_CHECK(profile_aes_ccm_encrypt(&enc, nonce, 14, NULL, 0, pt, buf, 4, tag, 4) == -EINVAL, "nonce 14 accepted");
+    HOST_CHECK(profile_aes_ccm_encrypt(&enc, nonce, 13, NULL, 0, pt, buf, 4, tag, 5) == -EINVAL, "tag 5 accepted");
+    HOST_CHECK(profile_aes_ccm_decrypt(&enc, nonce, 13, NULL, 0, pt, buf, 4, tag, 18) == -EINVAL, "tag 18 accepted");
+    /*nonce 13时长度字段2byte*/
+    HOST_CHECK(profile_aes_ccm_encrypt(&enc, nonce, 13, NULL, 0, ccm_aad, ccm_aad, 0x10000, tag, 4) == -EINVAL,
+               "64K payload accepted with a 2 byte length field");
+}
+
+/*5.每字节耗时*/
+static volatile u8 bench_sink;
+
+static double bench_cpb(void (*fn)(u8 *buf, u32 len), u8 *buf, u32 len, int loops)
+{
+    uint64_t t0 = host_bench_now();
+    for (int i = 0; i < loops; i++) {
+        fn(buf, len);
+        bench_sink += buf[0];
+    }
+    return (double)(host_bench_now() - t0) / ((double)len * loops);
+}
+
+static struct profile_aes_ctx bench_enc, bench_dec;
+static u8 bench_iv[16];
+
+static void bench_ecb_enc(u8 *buf, u32 len)
+{
+    profile_aes_ecb_encrypt(&bench_enc, buf, buf, len / 16);
+}
+
+static void bench_ecb_dec(u8 *buf, u32 len)
+{
+    profile_aes_ecb_decrypt(&bench_dec, buf, buf, len / 16);
+}
+
+static void bench_cbc_enc(u8 *buf, u32 len)
+{
+    profile_aes_cbc_encrypt(&bench_enc, bench_iv, buf, buf, len / 16);
+}
+
+static void bench_cbc_dec(u8 *buf, u32 len)
+{
+    profile_aes_cbc_decrypt(&bench_dec, bench_iv, buf, buf, len / 16);
+}
+
+static void bench_ctr(u8 *buf, u32 len)
+{
+    profile_aes_ctr(&bench_enc, bench_iv, buf, buf, len);
+}
+
+static void bench_ccm(u8 *buf, u32 len)
+{
+    u8 tag[8];
+    profile_aes_ccm_encrypt(&bench_enc, bench_iv, 13, bench_iv, 8, buf, buf, len, tag, sizeof(tag));
+}
+
+static void bench_md5(u8 *buf, u32 len)
+{
+    profile_hash(PROFILE_HASH_MD5, buf, len, buf);
+}
+
+static void bench_sha1(u8 *buf, u32 len)
+{
+    profile_hash(PROFILE_HASH_SHA1, buf, len, buf);
+}
+
+static void bench_sha256(u8 *buf, u32 len)
+{
+    profile_hash(PROFILE_HASH_SHA256, buf, len, buf);
+}
+
+static void bench_hmac_sha256(u8 *buf, u32 len)
+{
+    profile_hmac(PROFILE_HASH_SHA256, bench_iv, 16, buf, len, buf);
+}
+
+static void bench(u32 len)
+{
+    static u8 buf[TEST_BYTES_MAX];
+    int loops = 2000000 / len + 1;
+    u8 key[32];
+
+    fill_random(buf, sizeof(buf));
+    fill_random(key, sizeof(key));
+    fill_random(bench_iv, sizeof(bench_iv));
+    for (u16 bits = 128; bits <= 256; bits += 128) {
+        profile_aes_setkey_enc(&bench_enc, key, bits);
+        profile_aes_setkey_dec(&bench_dec, key, bits);
+        printf("  %4uB AES-%d  ecb enc %6.1f dec %6.1f  cbc enc %6.1f dec %6.1f  ctr %6.1f  ccm %6.1f %s/byte\n",
+               len, bits, bench_cpb(bench_ecb_enc, buf, len, loops), bench_cpb(bench_ecb_dec, buf, len, loops),
+               bench_cpb(bench_cbc_enc, buf, len, loops), bench_cpb(bench_cbc_dec, buf, len, loops),
+               bench_cpb(bench_ctr, buf, len, loops), bench_cpb(bench_ccm, buf, len, loops), HOST_BENCH_UNIT);
+    }
+    printf("  %4uB md5 %6.1f  sha1 %6.1f  sha256 %6.1f  hmac-sha256 %6.1f %s/byte\n", len,
+           bench_cpb(bench_md5, buf, len, loops), bench_cpb(bench_sha1, buf, len, loops),
+           bench_cpb(bench_sha256, buf, len, loops), bench_cpb(bench_hmac_sha256, buf, len, loops), HOST_BENCH_UNIT);
+}
+
+int main(void)
+{
+    test_hash();
+    test_hmac();
+    test_aes_vectors();
+    test_aes_random();
+    test_ccm();
+
+    printf("crypto bench (PROFILE_CRYPTO_AES_TABLES %d):\n", PROFILE_CRYPTO_AES_TABLES);
+    bench(4096);
+    bench(64);
+    char name[40];
+    sprintf(name, "profile_crypto_test(%d)", PROFILE_CRYPTO_AES_TABLES);
+    return host_test_result(name);
+}
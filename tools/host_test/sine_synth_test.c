@@ -0,0 +1,166 @@
+/*
+ * 多声部合成(sine_make.c sine_synth_xxx)精度和耗时测试
+ * 1.单音THD+N：100Hz~3kHz，8k/16k/44.1k/48k输出采样率，去掉首尾淡入淡出后按已知频率
+ *   最小二乘拟合基波，残差能量与基波能量之比
+ * 2.双音(DTMF)两个频率的幅度一致，输出不超过SINE_SYNTH_VOLUME
+ * 3.点数、分块生成与一次生成逐位一致，淡入淡出首尾点接近0
+ * 4.统计1/2/4声部每个点的耗时
+ */
+#include <math.h>
+#include "host_bench.h"
+#include "../../apps/common/audio/sine_make.c"
+
+#define THD_LIMIT_DB		-75.0
+
+static s16 *synth_render(const struct sine_synth_note *note, int num, u32 sr, u8 ch, u32 *points, int block)
+{
+    void *synth = sine_synth_open(note, num, sr, ch, 0);
+    u32 total = sine_synth_points(synth);
+    s16 *pcm = calloc(total * ch + block, sizeof(s16));
+    u32 offset = 0;
+    int len;
+
+    while ((len = sine_synth_make(synth, (u8 *)pcm + offset, block * 2 * ch)) > 0) {
+        offset += len;
+    }
+    sine_synth_close(synth);
+    *points = offset / 2 / ch;
+    return pcm;
+}
+
+/*按已知频率拟合正弦，返回残差与基波的能量比(dB)，amp返回基波幅度*/
+static double tone_fit(const s16 *pcm, u32 n, u8 ch, double freq, u32 sr, double *amp)
+{
+    double ss = 0, sc = 0, cc = 0, ys = 0, yc = 0;
+    double w = 2 * M_PI * freq / sr;
+
+    for (u32 i = 0; i < n; i++) {
+        double s = sin(w * i), c = cos(w * i), y = pcm[i * ch];
+        ss += s * s;
+        cc += c * c;
+        sc += s * c;
+        ys += y * s;
+        yc += y * c;
+    }
+    double det = ss * cc - sc * sc;
+    double a = (ys * cc - yc * sc) / det;
+    double b = (yc * ss - ys * sc) / det;
+    double sig = 0, res = 0;
+    for (u32 i = 0; i < n; i++) {
+        double fit = a * sin(w * i) + b * cos(w * i);
+        double e = pcm[i * ch] - fit;
+        sig += fit * fit;
+        res += e * e;
+    }
+    *amp = sqrt(a * a + b * b);
+    return 10 * log10((res + 1e-9) / sig);
+}
+
+static void test_thd(void)
+{
+    static const u32 rates[] = {8000, 16000, 44100, 48000};
+    static const u16 freqs[] = {100, 440, 1000, 2000, 3000};
+
+    printf("single tone THD+N (dB):\n        ");
+    for (int f = 0; f < ARRAY_SIZE(freqs); f++) {
+        printf("%7dHz", freqs[f]);
+    }
+    printf("\n");
+    for (int r = 0; r < ARRAY_SIZE(rates); r++) {
+        printf("  %5d ", rates[r]);
+        for (int f = 0; f < ARRAY_SIZE(freqs); f++) {
+            struct sine_synth_note note = {{freqs[f]}, 500};
+            u32 points;
+            s16 *pcm = synth_render(&note, 1, rates[r], 1, &points, 256);
+            u32 fade = rates[r] * SINE_SYNTH_FADE_MS / 1000;
+            double amp;
+            double thd = tone_fit(pcm + fade, points - 2 * fade, 1, freqs[f], rates[r], &amp);
+
+            printf("%9.1f", thd);
+            HOST_CHECK(thd < THD_LIMIT_DB, "thd %d Hz @%d: %.1f dB", freqs[f], rates[r], thd);
+            HOST_CHECK(fabs(amp - SINE_SYNTH_VOLUME) < SINE_SYNTH_VOLUME * 0.002,
+                       "amp %d Hz @%d: %.0f", freqs[f], rates[r], amp);
+            free(pcm);
+        }
+        printf("\n");
+    }
+}
+
+static void test_dtmf(void)
+{
+    struct sine_synth_note note = {{941, 1336}, 200};
+    u32 points, sr = 16000;
+    s16 *pcm = synth_render(&note, 1, sr, 2, &points, 100);
+    u32 fade = sr * SINE_SYNTH_FADE_MS / 1000;
+    double a0, a1;
+    int peak = 0;
+
+    HOST_CHECK(points == sr * 200 / 1000, "dtmf points %d", points);
+    tone_fit(pcm + fade * 2, points - 2 * fade, 2, 941, sr, &a0);
+    tone_fit(pcm + fade * 2, points - 2 * fade, 2, 1336, sr, &a1);
+    for (u32 i = 0; i < points * 2; i++) {
+        peak = MAX(peak, abs(pcm[i]));
+        if (i & 1) {
+            HOST_CHECK(pcm[i] == pcm[i - 1], "dtmf stereo mismatch at %d", i);
+        }
+    }
+    HOST_CHECK(fabs(a0 - a1) < SINE_SYNTH_VOLUME * 0.002, "dtmf amp %.0f/%.0f", a0, a1);
+    HOST_CHECK(fabs(a0 - SINE_SYNTH_VOLUME / 2) < SINE_SYNTH_VOLUME * 0.002, "dtmf amp %.0f", a0);
+    HOST_CHECK(peak <= SINE_SYNTH_VOLUME, "dtmf peak %d", peak);
+    HOST_CHECK(abs(pcm[0]) < 64 && abs(pcm[points * 2 - 2]) < 64, "dtmf fade %d/%d", pcm[0], pcm[points * 2 - 2]);
+    free(pcm);
+}
+
+/*不同分块大小生成的数据逐位一致，总点数等于各音符点数之和*/
+static void test_blocks(void)
+{
+    static const struct sine_synth_note chord[] = {
+        {{523}, 90}, {{523, 659}, 90}, {{0}, 20}, {{523, 659, 784, 1047}, 240},
+    };
+    u32 sr = 44100, ref_points, points;
+    s16 *ref = synth_render(chord, ARRAY_SIZE(chord), sr, 2, &ref_points, 100000);
+    u32 expect = 0;
+
+    for (int i = 0; i < ARRAY_SIZE(chord); i++) {
+        expect += chord[i].ms * sr / 1000;
+    }
+    HOST_CHECK(ref_points == expect, "chord points %d != %d", ref_points, expect);
+    for (int block = 1; block < 700; block += 37) {
+        s16 *pcm = synth_render(chord, ARRAY_SIZE(chord), sr, 2, &points, block);
+        HOST_CHECK(points == ref_points && memcmp(pcm, ref, points * 4) == 0, "block %d differs", block);
+        free(pcm);
+    }
+    free(ref);
+}
+
+static void bench(void)
+{
+    static s16 buf[512 * 2];
+    const int loops = 2000;
+
+    printf("synth bench (48k stereo, 512 points per block):\n");
+    for (int voices = 1; voices <= SINE_SYNTH_TONE_MAX; voices <<= 1) {
+        struct sine_synth_note note = {{0}, 60000};
+        for (int k = 0; k < voices; k++) {
+            note.freq[k] = 440 + 220 * k;
+        }
+        void *synth = sine_synth_open(&note, 1, 48000, 2, 0);
+        u64 t0 = host_bench_now();
+        for (int i = 0; i < loops; i++) {
+            sine_synth_make(synth, buf, sizeof(buf));
+        }
+        u64 t1 = host_bench_now();
+        sine_synth_close(synth);
+        printf("  %d voice%s %6.2f %s/point\n", voices, voices > 1 ? "s" : " ",
+               (double)(t1 - t0) / loops / 512, HOST_BENCH_UNIT);
+    }
+}
+
+int main(void)
+{
+    test_thd();
+    test_dtmf();
+    test_blocks();
+    bench();
+    return host_test_result("sine_synth_test");
+}
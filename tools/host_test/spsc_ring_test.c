@@ -0,0 +1,325 @@
+/*
+ * 单生产者单消费者无锁环形缓存(include_lib/system/generic/spsc_ring.h)多线程压力测试和吞吐对比
+ * 1.单线程：大小不是2的幂返回-EINVAL，回绕读写、reserve/commit和peek/consume分段、
+ *   write_frames只写完整帧、索引越过u32最大值时长度计算正确
+ * 2.两个pthread分别做生产者和消费者，随机块长交替使用write和reserve/commit写入递增序列，
+ *   消费者交替用read和peek/consume读出并逐字节检查，索引从接近u32回绕处开始
+ * 3.同样的两线程数据通路，统计spsc_ring和cbuf的MB/s；
+ *   cbuf在库里(circular_buf.h)，这里按其结构(读写指针 + data_len，spinlock保护)建模对照
+ * 同一程序以-DCPU_CORE_NUM=2编译，使用多核的屏障(__asm_csync，这里用完整内存屏障)
+ * x86是强内存序，编译器屏障版本在这里能通过不代表在弱内存序的主机上也能通过
+ */
+#include "host_bench.h"
+#include "generic/typedef.h"
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if CPU_CORE_NUM > 1
+#define __asm_csync()	__sync_synchronize()
+#endif
+#include "spsc_ring.h"
+
+#ifndef CPU_CORE_NUM
+#define CPU_CORE_NUM	1
+#endif
+
+#define RING_SIZE		4096
+#define STRESS_BYTES	(32 << 20)
+#define BENCH_BYTES		(64 << 20)
+
+static void test_single(void)
+{
+    static u8 mem[64];
+    spsc_ring_t ring;
+    u8 in[64], out[64];
+    u32 len;
+    u8 *p;
+
+    HOST_CHECK(spsc_ring_init(&ring, mem, 48) == -EINVAL && spsc_ring_init(&ring, mem, 0) == -EINVAL,
+               "non power of two size accepted");
+    HOST_CHECK(spsc_ring_init(&ring, mem, 64) == 0, "init failed");
+    for (int i = 0; i < 64; i++) {
+        in[i] = i + 1;
+    }
+
+    /*回绕写读*/
+    HOST_CHECK(spsc_ring_write(&ring, in, 40) == 40 && spsc_ring_read(&ring, out, 40) == 40, "write/read 40");
+    HOST_CHECK(spsc_ring_write(&ring, in, 50) == 50, "wrapped write");
+    HOST_CHECK(spsc_ring_write(&ring, in, 15) == 0, "write beyond free space accepted");
+    HOST_CHECK(spsc_ring_free_len(&ring) == 14 && spsc_ring_data_len(&ring) == 50, "free %u data %u",
+               spsc_ring_free_len(&ring), spsc_ring_data_len(&ring));
+    HOST_CHECK(spsc_ring_read(&ring, out, 51) == 0, "read beyond data accepted");
+    HOST_CHECK(spsc_ring_read(&ring, out, 50) == 50 && !memcmp(in, out, 50), "wrapped read differs");
+
+    /*reserve/peek只给到缓存末尾的连续空间*/
+    p = spsc_ring_reserve(&ring, &len);
+    HOST_CHECK(p == mem + 26 && len == 38, "reserve at %d len %u", (int)(p - mem), len);
+    memcpy(p, in, len);
+    spsc_ring_commit(&ring, len);
+    p = spsc_ring_reserve(&ring, &len);
+    HOST_CHECK(p == mem && len == 26, "reserve after wrap at %d len %u", (int)(p - mem), len);
+    spsc_ring_commit(&ring, 10);
+    p = spsc_ring_peek(&ring, &len);
+    HOST_CHECK(p == mem + 26 && len == 38 && !memcmp(p, in, 38), "peek at %d len %u", (int)(p - mem), len);
+    spsc_ring_consume(&ring, len);
+    p = spsc_ring_peek(&ring, &len);
+    HOST_CHECK(p == mem && len == 10, "peek after wrap len %u", len);
+    spsc_ring_consume(&ring, len);
+
+    /*只写能完整放下的帧*/
+    HOST_CHECK(spsc_ring_write_frames(&ring, in, 12, 8) == 5 && spsc_ring_data_len(&ring) == 60,
+               "write_frames data %u", spsc_ring_data_len(&ring));
+    HOST_CHECK(spsc_ring_write_frames(&ring, in, 0, 8) == 0, "zero frame length");
+    spsc_ring_clear(&ring);
+    HOST_CHECK(spsc_ring_data_len(&ring) == 0, "clear left %u bytes", spsc_ring_data_len(&ring));
+
+    /*索引越过u32最大值*/
+    ring.write_idx = ring.read_idx = 0xffffffe0;
+    HOST_CHECK(spsc_ring_write(&ring, in, 60) == 60 && spsc_ring_data_len(&ring) == 60 &&
+               spsc_ring_free_len(&ring) == 4, "index wrap: data %u free %u", spsc_ring_data_len(&ring),
+               spsc_ring_free_len(&ring));
+    HOST_CHECK(spsc_ring_read(&ring, out, 60) == 60 && !memcmp(in, out, 60), "index wrap read differs");
+}
+
+/*cbuf模型：读写各自移动指针，data_len在锁内增减*/
+typedef struct {
+    u8 *begin;
+    u8 *end;
+    u8 *read_ptr;
+    u8 *write_ptr;
+    u32 data_len;
+    u32 total_len;
+    pthread_spinlock_t lock;
+} cbuf_model_t;
+
+static void cbuf_model_init(cbuf_model_t *c, void *buf, u32 size)
+{
+    c->begin = c->read_ptr = c->write_ptr = buf;
+    c->end = c->begin + size;
+    c->data_len = 0;
+    c->total_len = size;
+    pthread_spin_init(&c->lock, 0);
+}
+
+static u32 cbuf_model_write(cbuf_model_t *c, const void *buf, u32 len)
+{
+    pthread_spin_lock(&c->lock);
+    if (c->total_len - c->data_len < len) {
+        pthread_spin_unlock(&c->lock);
+        return 0;
+    }
+    u32 tail = c->end - c->write_ptr;
+    if (len <= tail) {
+        memcpy(c->write_ptr, buf, len);
+        c->write_ptr += len;
+        if (c->write_ptr == c->end) {
+            c->write_ptr = c->begin;
+        }
+    } else {
+        memcpy(c->write_ptr, buf, tail);
+        memcpy(c->begin, (const u8 *)buf + tail, len - tail);
+        c->write_ptr = c->begin + len - tail;
+    }
+    c->data_len += len;
+    pthread_spin_unlock(&c->lock);
+    return len;
+}
+
+static u32 cbuf_model_read(cbuf_model_t *c, void *buf, u32 len)
+{
+    pthread_spin_lock(&c->lock);
+    if (c->data_len < len) {
+        pthread_spin_unlock(&c->lock);
+        return 0;
+    }
+    u32 tail = c->end - c->read_ptr;
+    if (len <= tail) {
+        memcpy(buf, c->read_ptr, len);
+        c->read_ptr += len;
+        if (c->read_ptr == c->end) {
+            c->read_ptr = c->begin;
+        }
+    } else {
+        memcpy(buf, c->read_ptr, tail);
+        memcpy((u8 *)buf + tail, c->begin, len - tail);
+        c->read_ptr = c->begin + len - tail;
+    }
+    c->data_len -= len;
+    pthread_spin_unlock(&c->lock);
+    return len;
+}
+
+struct pipe_ctx {
+    spsc_ring_t ring;
+    cbuf_model_t cbuf;
+    u8 use_cbuf;
+    u8 check;				/*按递增序列写入和检查*/
+    u32 chunk;				/*0表示随机块长*/
+    u32 total;
+    u32 errors;
+    u32 producer_wait;
+    u32 consumer_wait;
+};
+
+static u32 chunk_len(struct pipe_ctx *c, u32 *seed)
+{
+    if (c->chunk) {
+        return c->chunk;
+    }
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return 1 + *seed % 700;
+}
+
+static void *producer(void *arg)
+{
+    struct pipe_ctx *c = arg;
+    u8 buf[1024];
+    u32 seed = 0x2468ace1, sent = 0, n = 0;
+    u8 seq = 0;
+
+    while (sent < c->total) {
+        u32 len = chunk_len(c, &seed);
+        len = MIN(len, c->total - sent);
+        if (c->check) {
+            for (u32 i = 0; i < len; i++) {
+                buf[i] = seq + i;
+            }
+        }
+        u32 done;
+        if (c->use_cbuf) {
+            done = cbuf_model_write(&c->cbuf, buf, len);
+        } else if (c->check && (n & 1)) {
+            /*reserve/commit，可能分两段*/
+            u32 avail, first;
+            u8 *p;
+            if (spsc_ring_free_len(&c->ring) < len) {
+                done = 0;
+            } else {
+                p = spsc_ring_reserve(&c->ring, &avail);
+                first = MIN(avail, len);
+                memcpy(p, buf, first);
+                spsc_ring_commit(&c->ring, first);
+                if (first < len) {
+                    p = spsc_ring_reserve(&c->ring, &avail);
+                    memcpy(p, buf + first, len - first);
+                    spsc_ring_commit(&c->ring, len - first);
+                }
+                done = len;
+            }
+        } else {
+            done = spsc_ring_write(&c->ring, buf, len);
+        }
+        if (!done) {
+            c->producer_wait++;
+            sched_yield();
+            continue;
+        }
+        seq += len;
+        sent += len;
+        n++;
+    }
+    return NULL;
+}
+
+static void *consumer(void *arg)
+{
+    struct pipe_ctx *c = arg;
+    u8 buf[1024];
+    u32 seed = 0x13579bdf, recv = 0, n = 0;
+    u8 seq = 0;
+
+    while (recv < c->total) {
+        u32 len = chunk_len(c, &seed);
+        len = MIN(len, c->total - recv);
+        u32 done;
+        if (c->use_cbuf) {
+            done = cbuf_model_read(&c->cbuf, buf, len);
+        } else if (c->check && (n & 1)) {
+            /*peek/consume，一次只取到缓存末尾*/
+            u8 *p = spsc_ring_peek(&c->ring, &done);
+            done = MIN(done, len);
+            memcpy(buf, p, done);
+            spsc_ring_consume(&c->ring, done);
+        } else {
+            done = spsc_ring_read(&c->ring, buf, len);
+        }
+        if (!done) {
+            c->consumer_wait++;
+            sched_yield();
+            continue;
+        }
+        if (c->check) {
+            for (u32 i = 0; i < done; i++) {
+                if (buf[i] != (u8)(seq + i)) {
+                    c->errors++;
+                    break;
+                }
+            }
+        }
+        seq += done;
+        recv += done;
+        n++;
+    }
+    return NULL;
+}
+
+static double pipe_run(struct pipe_ctx *c)
+{
+    static u8 mem[RING_SIZE];
+    pthread_t tp, tc;
+    struct timespec t0, t1;
+
+    spsc_ring_init(&c->ring, mem, RING_SIZE);
+    /*从接近u32回绕的位置开始*/
+    c->ring.write_idx = c->ring.read_idx = 0xffffffff - RING_SIZE * 3;
+    cbuf_model_init(&c->cbuf, mem, RING_SIZE);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    pthread_create(&tc, NULL, consumer, c);
+    pthread_create(&tp, NULL, producer, c);
+    pthread_join(tp, NULL);
+    pthread_join(tc, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    pthread_spin_destroy(&c->cbuf.lock);
+    return c->total / ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9) / 1e6;
+}
+
+static void test_stress(void)
+{
+    struct pipe_ctx c = {
+        .check = 1,
+        .total = STRESS_BYTES,
+    };
+
+    pipe_run(&c);
+    printf("spsc stress: %u MB random chunks, waits producer %u consumer %u\n", STRESS_BYTES >> 20,
+           c.producer_wait, c.consumer_wait);
+    HOST_CHECK(c.errors == 0, "stress: %u chunks out of sequence", c.errors);
+    HOST_CHECK(spsc_ring_data_len(&c.ring) == 0, "stress: %u bytes left", spsc_ring_data_len(&c.ring));
+}
+
+static void bench(void)
+{
+    static const u32 chunks[] = {32, 256, 1024};
+
+    printf("spsc_ring vs cbuf (model) throughput, %u byte ring, %ld cpus:\n", RING_SIZE, sysconf(_SC_NPROCESSORS_ONLN));
+    for (int i = 0; i < ARRAY_SIZE(chunks); i++) {
+        struct pipe_ctx s = {.chunk = chunks[i], .total = BENCH_BYTES};
+        struct pipe_ctx b = {.chunk = chunks[i], .total = BENCH_BYTES, .use_cbuf = 1};
+        double spsc = pipe_run(&s);
+        double cbuf = pipe_run(&b);
+        printf("  %4u byte chunks: spsc_ring %7.1f MB/s  cbuf %7.1f MB/s\n", chunks[i], spsc, cbuf);
+    }
+}
+
+int main(void)
+{
+    test_single();
+    test_stress();
+    bench();
+    char name[32];
+    sprintf(name, "spsc_ring_test(%d core)", CPU_CORE_NUM);
+    return host_test_result(name);
+}
@@ -0,0 +1,228 @@
+/*
+ * 触摸按键算法(cpu/br36/lp_touch_key_alog.c)回放工具
+ * 逐点调用TouchAlgo_Update，按key_state的变化输出按下/抬起时间，统计：
+ * 1.按下/抬起时间戳(采样序号*采样周期)
+ * 2.误触发：按下或抬起不在标注的按键区间内(区间后留RELEASE_SLACK_POINTS个点给抬起检测)
+ * 3.漏检：标注的按键区间内没有检测到按下
+ * 4.每个点TouchAlgo_Update的平均/最大耗时
+ *   touch_key_replay [trace.txt [周期ms]]
+ *   trace每行一个点："ctmu值 [标注]"，标注1表示手指在按键上，#开头的行忽略，
+ *   不带参数时使用内置的合成数据(基线噪声、慢漂移、按键、单点毛刺、噪声段)，并检查无漏检和误触发
+ */
+#include "host_bench.h"
+#include "../../cpu/br36/lp_touch_key_alog.c"
+
+#define TOUCH_RANGE_MIN			50		/*与lp_touch_key.c一致*/
+#define TOUCH_RANGE_MAX			500
+#define SAMPLE_PERIOD_MS		20		/*CTMU_SAMPLE_RATE_PRD*/
+#define SKIP_POINTS				50		/*lp_touch_key.c上电后丢掉的点数*/
+#define RELEASE_SLACK_POINTS	4
+#define TRACE_POINTS_MAX		(1 << 20)
+
+struct trace {
+    u16 *val;
+    u8 *label;
+    u32 points;
+    u8 has_label;
+};
+
+struct replay_stat {
+    u32 press;
+    u32 release;
+    u32 false_press;
+    u32 false_release;
+    u32 label_press;
+    u32 missed;
+    u64 cycles;
+    u64 cycles_max;
+    u32 cycles_points;
+};
+
+static int trace_load(struct trace *t, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[128];
+
+    if (!fp) {
+        printf("open %s failed\n", path);
+        return -1;
+    }
+    t->val = malloc(TRACE_POINTS_MAX * sizeof(u16));
+    t->label = calloc(TRACE_POINTS_MAX, 1);
+    t->points = 0;
+    t->has_label = 0;
+    while (fgets(line, sizeof(line), fp) && t->points < TRACE_POINTS_MAX) {
+        int val, label;
+        int n = sscanf(line, "%d %d", &val, &label);
+        if (line[0] == '#' || n < 1) {
+            continue;
+        }
+        t->val[t->points] = val;
+        if (n == 2) {
+            t->label[t->points] = !!label;
+            t->has_label = 1;
+        }
+        t->points++;
+    }
+    fclose(fp);
+    return 0;
+}
+
+/*
+ *合成数据：基线10000附近的噪声和慢漂移，按键时3个点内下降200左右并保持10~40个点，
+ *中间插入单点毛刺(中值滤波应去掉)和一段噪声偏大的区间
+ */
+static void trace_synth(struct trace *t)
+{
+    u32 n = 0;
+    s32 base = 10000;
+
+    t->val = malloc(TRACE_POINTS_MAX * sizeof(u16));
+    t->label = calloc(TRACE_POINTS_MAX, 1);
+    t->has_label = 1;
+
+#define PUSH(v, l)	do { t->val[n] = (v); t->label[n] = (l); n++; } while (0)
+#define NOISE(a)	((s32)(host_rand() % (2 * (a) + 1)) - (a))
+
+    for (u32 i = 0; i < 600; i++) {
+        PUSH(base + NOISE(2), 0);
+    }
+    for (int k = 0; k < 40; k++) {
+        s32 depth = 180 + host_rand() % 60;
+        u32 hold = 10 + host_rand() % 30;
+        u32 idle = 60 + host_rand() % 200;
+
+        for (int i = 1; i <= 3; i++) {
+            PUSH(base - depth * i / 3 + NOISE(2), 1);
+        }
+        for (u32 i = 0; i < hold; i++) {
+            PUSH(base - depth + NOISE(2), 1);
+        }
+        for (int i = 2; i >= 0; i--) {
+            PUSH(base - depth * i / 3 + NOISE(2), i ? 1 : 0);
+        }
+        for (u32 i = 0; i < idle; i++) {
+            if ((k % 5) == 2 && i == idle / 2) {
+                PUSH(base + ((host_rand() & 1) ? 300 : -300), 0);	/*单点毛刺*/
+            } else if ((k % 10) == 7 && i < 40) {
+                PUSH(base + NOISE(6), 0);							/*噪声偏大*/
+            } else {
+                PUSH(base + NOISE(2), 0);
+            }
+            if ((i & 15) == 0) {
+                base += (k & 8) ? 1 : -1;							/*慢漂移*/
+            }
+        }
+    }
+#undef PUSH
+#undef NOISE
+    t->points = n;
+}
+
+/*i是否在标注的按键区间内，区间后RELEASE_SLACK_POINTS个点也算*/
+static u8 in_press(const struct trace *t, u32 i)
+{
+    for (u32 k = 0; k <= RELEASE_SLACK_POINTS && k <= i; k++) {
+        if (t->label[i - k]) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void replay(const struct trace *t, u32 period_ms, struct replay_stat *st, u8 verbose)
+{
+    const u8 ch = 0;
+    u8 key_state = 0;
+    u8 hit = 0;
+
+    memset(st, 0, sizeof(*st));
+    TouchAlgo_Init(ch, TOUCH_RANGE_MIN, TOUCH_RANGE_MAX);
+    for (u32 i = 0; i < t->points; i++) {
+        if (t->has_label && t->label[i] && (i == 0 || !t->label[i - 1])) {
+            st->label_press++;
+            hit = 0;
+        }
+        if (i < SKIP_POINTS) {
+            continue;
+        }
+        u64 t0 = host_bench_now();
+        TouchAlgo_Update(ch, t->val[i]);
+        u64 dt = host_bench_now() - t0;
+        st->cycles += dt;
+        st->cycles_max = MAX(st->cycles_max, dt);
+        st->cycles_points++;
+
+        if (ta_ch[ch].key_state != key_state) {
+            key_state = ta_ch[ch].key_state;
+            u8 valid = !t->has_label || in_press(t, i);
+            if (key_state) {
+                st->press++;
+                st->false_press += !valid;
+                if (valid && t->label[i]) {
+                    hit = 1;
+                }
+            } else {
+                st->release++;
+                st->false_release += !valid;
+            }
+            if (verbose) {
+                printf("  %8u ms  %-7s val %5d%s\n", i * period_ms, key_state ? "press" : "release",
+                       t->val[i], valid ? "" : "  (false trigger)");
+            }
+        }
+        if (t->has_label && !t->label[i] && i && t->label[i - 1] && !hit) {
+            st->missed++;
+            if (verbose) {
+                printf("  %8u ms  missed press\n", i * period_ms);
+            }
+        }
+    }
+}
+
+static void report(const struct trace *t, u32 period_ms, const struct replay_stat *st)
+{
+    u8 valid;
+    u16 range = TouchAlgo_GetRange(0, &valid);
+
+    printf("touch replay: %u points, %u ms\n", t->points, t->points * period_ms);
+    printf("  press %u release %u", st->press, st->release);
+    if (t->has_label) {
+        printf(", labelled %u missed %u, false press %u false release %u",
+               st->label_press, st->missed, st->false_press, st->false_release);
+    }
+    printf("\n  range %d(valid %d) sigma %d\n", range, valid, (TouchAlgo_GetSigma(0) + 32) >> 6);
+    printf("  update avg %.1f max %llu %s/point\n",
+           (double)st->cycles / st->cycles_points, (unsigned long long)st->cycles_max, HOST_BENCH_UNIT);
+}
+
+int main(int argc, char **argv)
+{
+    struct trace t;
+    struct replay_stat st;
+    u32 period_ms = SAMPLE_PERIOD_MS;
+
+    if (argc > 1) {
+        if (trace_load(&t, argv[1])) {
+            return 1;
+        }
+        if (argc > 2) {
+            period_ms = atoi(argv[2]);
+        }
+        replay(&t, period_ms, &st, 1);
+        report(&t, period_ms, &st);
+        return 0;
+    }
+
+    trace_synth(&t);
+    replay(&t, period_ms, &st, 0);
+    report(&t, period_ms, &st);
+    HOST_CHECK(st.missed == 0, "missed %u presses", st.missed);
+    HOST_CHECK(st.false_press == 0 && st.false_release == 0, "false press %u release %u",
+               st.false_press, st.false_release);
+    HOST_CHECK(st.press == st.label_press && st.release == st.label_press, "press %u release %u, expect %u",
+               st.press, st.release, st.label_press);
+    free(t.val);
+    free(t.label);
+    return host_test_result("touch_key_replay");
+}
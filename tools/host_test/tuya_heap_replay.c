@@ -0,0 +1,376 @@
+/*
+ * tuya ble私有堆：first-fit空闲链表(tuya_ble_heap.c，heap_4)和TLSF(tuya_ble_heap_tlsf.c)分配轨迹回放对比
+ * 两个实现各有一份静态ucHeap和同名接口，分别以TUYA_HEAP_REPLAY_PART=1/2编译成目标文件并改名链接，
+ * 指针宽度(portPOINTER_SIZE_TYPE)按主机编译
+ * 1.同一条分配轨迹依次回放到两个堆：分配的内存不重叠(写入内容在释放时检查)、按4字节对齐，
+ *   全部释放后空闲字节回到初始值且只剩一个空闲块
+ * 2.统计分配失败次数、碎片率(1 - 最大空闲块/空闲字节，每次分配后采样)、空闲块数，
+ *   内置轨迹上TLSF的分配失败不多于heap_4
+ * 3.每次malloc/free的耗时：同一轨迹回放多轮，每个操作取各轮最小值，输出平均、99.9%和最坏值
+ *   tuya_heap_replay [trace.txt]
+ *   trace每行一个操作："a 编号 字节数"分配，"f 编号"释放，#开头的行忽略
+ */
+#define TUYA_BLE_HEAP_HOST
+#define TUYA_BLE_USE_PLATFORM_MEMORY_HEAP	0
+#define TUYA_BLE_TOTAL_HEAP_SIZE			5120	/*tuya_ble_internal_config.h*/
+
+#include <stdint.h>
+#include <string.h>
+
+/*单线程回放，不需要临界区*/
+#define tuya_ble_device_enter_critical()
+#define tuya_ble_device_exit_critical()		0
+
+extern int tuya_heap_assert_fail;
+#define tuyaASSERT(x)	do { if (!(x)) { tuya_heap_assert_fail++; } } while (0)
+
+#if TUYA_HEAP_REPLAY_PART == 1
+#define TUYA_BLE_HEAP_USE_TLSF				0
+#define pvTuyaPortMalloc					heap4_malloc
+#define vTuyaPortFree						heap4_free
+#define xTuyaPortGetFreeHeapSize			heap4_free_size
+#define xTuyaPortGetMinimumEverFreeHeapSize	heap4_min_free_size
+#define vTuyaPortGetHeapStats				heap4_stats
+#define vTuyaPortInitialiseBlocks			heap4_init_blocks
+#include "../../apps/common/third_party_profile/tuya_protocol/sdk/src/tuya_ble_heap.c"
+
+#elif TUYA_HEAP_REPLAY_PART == 2
+#define TUYA_BLE_HEAP_USE_TLSF				1
+#define pvTuyaPortMalloc					tlsf_malloc
+#define vTuyaPortFree						tlsf_free
+#define xTuyaPortGetFreeHeapSize			tlsf_free_size
+#define xTuyaPortGetMinimumEverFreeHeapSize	tlsf_min_free_size
+#define vTuyaPortGetHeapStats				tlsf_stats
+#define vTuyaPortInitialiseBlocks			tlsf_init_blocks
+#include "../../apps/common/third_party_profile/tuya_protocol/sdk/src/tuya_ble_heap_tlsf.c"
+
+#else
+#include "host_bench.h"
+#include "typedef.h"
+#include "../../apps/common/third_party_profile/tuya_protocol/sdk/include/tuya_ble_heap.h"
+
+#define TRACE_OPS_MAX		200000
+#define TRACE_IDS_MAX		4096
+#define TIMING_ROUNDS		5
+#define COST_NONE			0xffffffff
+
+int tuya_heap_assert_fail;
+
+void *heap4_malloc(uint32_t size);
+void heap4_free(void *pv);
+uint32_t heap4_free_size(void);
+void heap4_stats(TuyaHeapStats_t *stats);
+void *tlsf_malloc(uint32_t size);
+void tlsf_free(void *pv);
+uint32_t tlsf_free_size(void);
+void tlsf_stats(TuyaHeapStats_t *stats);
+
+struct heap_ops {
+    const char *name;
+    void *(*malloc)(uint32_t size);
+    void (*free)(void *pv);
+    uint32_t (*free_size)(void);
+    void (*stats)(TuyaHeapStats_t *stats);
+};
+
+static const struct heap_ops heaps[] = {
+    {"heap_4", heap4_malloc, heap4_free, heap4_free_size, heap4_stats},
+    {"tlsf",   tlsf_malloc,  tlsf_free,  tlsf_free_size,  tlsf_stats},
+};
+
+struct trace_op {
+    u16 id;
+    u16 size;		/*0表示释放*/
+};
+
+struct trace {
+    struct trace_op *op;
+    u32 num;
+    u32 allocs;
+};
+
+struct replay_stat {
+    u32 failed;
+    u32 corrupt;		/*释放时内容被改写(内存重叠)*/
+    u32 misaligned;
+    u32 max_free_blocks;
+    double frag_sum;
+    u32 frag_samples;
+    double frag_max;
+    u32 end_free;
+    u32 end_blocks;
+    u32 *cost;			/*每个操作各轮的最小耗时*/
+};
+
+static void fill(u8 *p, u16 id, u16 size)
+{
+    for (u32 i = 0; i < size; i++) {
+        p[i] = id + i;
+    }
+}
+
+static int verify(const u8 *p, u16 id, u16 size)
+{
+    for (u32 i = 0; i < size; i++) {
+        if (p[i] != (u8)(id + i)) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void replay_run(const struct heap_ops *h, const struct trace *t, struct replay_stat *st, u8 round)
+{
+    static u8 *ptr[TRACE_IDS_MAX];
+    static u16 size[TRACE_IDS_MAX];
+    TuyaHeapStats_t hs;
+
+    memset(ptr, 0, sizeof(ptr));
+    for (u32 i = 0; i < t->num; i++) {
+        const struct trace_op *op = &t->op[i];
+        u64 t0, t1;
+
+        if (op->size) {
+            t0 = host_bench_now();
+            u8 *p = h->malloc(op->size);
+            t1 = host_bench_now();
+            if (round == 0) {
+                if (!p) {
+                    st->failed++;
+                } else {
+                    st->misaligned += ((unsigned long)p & 3) != 0;
+                }
+            }
+            if (p) {
+                fill(p, op->id, op->size);
+            }
+            ptr[op->id] = p;
+            size[op->id] = op->size;
+            if (round == 0) {
+                h->stats(&hs);
+                if (hs.xAvailableHeapSpaceInBytes) {
+                    double frag = 1.0 - (double)hs.xSizeOfLargestFreeBlockInBytes / hs.xAvailableHeapSpaceInBytes;
+                    st->frag_sum += frag;
+                    st->frag_max = MAX(st->frag_max, frag);
+                    st->frag_samples++;
+                }
+                st->max_free_blocks = MAX(st->max_free_blocks, hs.xNumberOfFreeBlocks);
+            }
+        } else {
+            u8 *p = ptr[op->id];
+            if (!p) {
+                st->cost[i] = COST_NONE;	/*分配失败的不计*/
+                continue;
+            }
+            if (round == 0 && verify(p, op->id, size[op->id])) {
+                st->corrupt++;
+            }
+            t0 = host_bench_now();
+            h->free(p);
+            t1 = host_bench_now();
+            ptr[op->id] = NULL;
+        }
+        u32 dt = t1 - t0;
+        if (round == 0 || dt < st->cost[i]) {
+            st->cost[i] = dt;
+        }
+    }
+    /*轨迹结束时没释放的在这里释放*/
+    for (u32 id = 0; id < TRACE_IDS_MAX; id++) {
+        if (ptr[id]) {
+            h->free(ptr[id]);
+        }
+    }
+    h->stats(&hs);
+    st->end_free = hs.xAvailableHeapSpaceInBytes;
+    st->end_blocks = hs.xNumberOfFreeBlocks;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    u32 x = *(const u32 *)a, y = *(const u32 *)b;
+    return x < y ? -1 : x > y;
+}
+
+/*malloc/free分开统计：平均、99.9%、最坏*/
+static void cost_report(const struct trace *t, const u32 *cost, u8 is_malloc, u32 *p999, u32 *worst)
+{
+    u32 *v = malloc(t->num * sizeof(u32));
+    u32 n = 0;
+    u64 sum = 0;
+
+    for (u32 i = 0; i < t->num; i++) {
+        if (!t->op[i].size == !is_malloc && cost[i] != COST_NONE) {
+            v[n++] = cost[i];
+            sum += cost[i];
+        }
+    }
+    qsort(v, n, sizeof(u32), cmp_u32);
+    *p999 = n ? v[n * 999 / 1000] : 0;
+    *worst = n ? v[n - 1] : 0;
+    printf(" %s avg %4u p99.9 %5u max %6u", is_malloc ? "malloc" : "free", n ? (u32)(sum / n) : 0, *p999, *worst);
+    free(v);
+}
+
+/*返回TLSF的分配失败不多于heap_4*/
+static int replay_compare(const char *name, const struct trace *t)
+{
+    struct replay_stat st[ARRAY_SIZE(heaps)];
+    u32 init_free[ARRAY_SIZE(heaps)];
+
+    printf("trace %-8s %u ops, %u allocs:\n", name, t->num, t->allocs);
+    for (int k = 0; k < ARRAY_SIZE(heaps); k++) {
+        const struct heap_ops *h = &heaps[k];
+        u32 p999, worst;
+
+        memset(&st[k], 0, sizeof(st[k]));
+        st[k].cost = malloc(t->num * sizeof(u32));
+        /*第一次分配时初始化堆*/
+        h->free(h->malloc(4));
+        init_free[k] = h->free_size();
+        tuya_heap_assert_fail = 0;
+        for (u8 round = 0; round < TIMING_ROUNDS; round++) {
+            replay_run(h, t, &st[k], round);
+        }
+        printf("  %-6s failed %5u  frag avg %4.1f%% max %4.1f%%  free blocks max %3u  %s\n        ", h->name,
+               st[k].failed, st[k].frag_samples ? 100 * st[k].frag_sum / st[k].frag_samples : 0.0,
+               100 * st[k].frag_max, st[k].max_free_blocks, HOST_BENCH_UNIT);
+        cost_report(t, st[k].cost, 1, &p999, &worst);
+        cost_report(t, st[k].cost, 0, &p999, &worst);
+        printf("\n");
+
+        HOST_CHECK(st[k].corrupt == 0, "%s %s: %u blocks overwritten", name, h->name, st[k].corrupt);
+        HOST_CHECK(st[k].misaligned == 0, "%s %s: %u misaligned blocks", name, h->name, st[k].misaligned);
+        HOST_CHECK(tuya_heap_assert_fail == 0, "%s %s: %d asserts", name, h->name, tuya_heap_assert_fail);
+        HOST_CHECK(st[k].end_free == init_free[k] && st[k].end_blocks == 1,
+                   "%s %s: %u of %u bytes in %u blocks free after the trace", name, h->name,
+                   st[k].end_free, init_free[k], st[k].end_blocks);
+        free(st[k].cost);
+    }
+    return st[1].failed <= st[0].failed;
+}
+
+static void trace_add(struct trace *t, u16 id, u16 size)
+{
+    if (t->num < TRACE_OPS_MAX) {
+        t->op[t->num].id = id;
+        t->op[t->num].size = size;
+        t->num++;
+        t->allocs += size != 0;
+    }
+}
+
+enum {
+    TRACE_BLE_MSG,
+    TRACE_BULK,
+    TRACE_RANDOM,
+    TRACE_NUM,
+};
+
+static const char *trace_name[TRACE_NUM] = {"ble_msg", "bulk", "random"};
+
+/*
+ *ble_msg:收发消息和dp上报，20~260字节，大多数很快释放，1%持有几百次操作
+ *bulk:ble_msg之外每200次操作读一次1024字节的大数据块(TUYA_BLE_BULK_DATA_MAX_READ_BLOCK_SIZE)，持有50次操作
+ *random:8~600字节，生存期随机，堆大约用到一半以上
+ */
+static void trace_synth(struct trace *t, int type)
+{
+    static u32 death[TRACE_IDS_MAX];
+    static u16 live_size[TRACE_IDS_MAX];
+    u32 live_bytes = 0;
+
+    memset(t, 0, sizeof(*t));
+    memset(live_size, 0, sizeof(live_size));
+    t->op = malloc(TRACE_OPS_MAX * sizeof(struct trace_op));
+    for (u32 step = 0; step < 40000; step++) {
+        /*到期的释放*/
+        for (u16 id = 0; id < TRACE_IDS_MAX; id++) {
+            if (live_size[id] && death[id] <= step) {
+                trace_add(t, id, 0);
+                live_bytes -= live_size[id];
+                live_size[id] = 0;
+            }
+        }
+        u16 size;
+        u32 life;
+        switch (type) {
+        case TRACE_BULK:
+            if (step % 200 == 0) {
+                size = 1024;
+                life = 50;
+                break;
+            }
+        case TRACE_BLE_MSG:
+            size = 20 + host_rand() % 241;
+            life = host_rand() % 100 == 0 ? 200 + host_rand() % 600 : 1 + host_rand() % 12;
+            break;
+        default:
+            size = 8 + host_rand() % 593;
+            life = 1 + host_rand() % 40;
+            if (live_bytes > TUYA_BLE_TOTAL_HEAP_SIZE * 3 / 4) {
+                continue;
+            }
+            break;
+        }
+        u16 id = host_rand() % TRACE_IDS_MAX;
+        while (live_size[id]) {
+            id = (id + 1) % TRACE_IDS_MAX;
+        }
+        trace_add(t, id, size);
+        live_size[id] = size;
+        live_bytes += size;
+        death[id] = step + life;
+    }
+}
+
+static int trace_load(struct trace *t, const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    char line[64];
+
+    if (!fp) {
+        printf("open %s failed\n", path);
+        return -1;
+    }
+    memset(t, 0, sizeof(*t));
+    t->op = malloc(TRACE_OPS_MAX * sizeof(struct trace_op));
+    while (fgets(line, sizeof(line), fp)) {
+        char op;
+        int id, size = 0;
+        if (line[0] == '#' || sscanf(line, "%c %d %d", &op, &id, &size) < 2 || id < 0 || id >= TRACE_IDS_MAX) {
+            continue;
+        }
+        if (op == 'a' && size > 0 && size < 0x10000) {
+            trace_add(t, id, size);
+        } else if (op == 'f') {
+            trace_add(t, id, 0);
+        }
+    }
+    fclose(fp);
+    return t->num ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+    struct trace t;
+
+    printf("tuya ble heap replay (heap %u bytes, pointer %d bytes):\n", TUYA_BLE_TOTAL_HEAP_SIZE, (int)sizeof(void *));
+    if (argc > 1) {
+        if (trace_load(&t, argv[1])) {
+            return 1;
+        }
+        replay_compare("file", &t);
+        free(t.op);
+        return host_test_result("tuya_heap_replay");
+    }
+
+    for (int type = 0; type < TRACE_NUM; type++) {
+        trace_synth(&t, type);
+        HOST_CHECK(replay_compare(trace_name[type], &t), "%s: tlsf fails more allocations than heap_4", trace_name[type]);
+        free(t.op);
+    }
+    return host_test_result("tuya_heap_replay");
+}
+
+#endif